@@ -0,0 +1,323 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Offline front-end to the shader recompiler: translates GXP programs (single files or whole
+// directories, such as the shaderlog folder of a title) for every requested target and
+// combination of feature flags, writes the generated SPIR-V and GLSL and reports how long
+// each translation took. Nothing here touches the GPU.
+
+#include <gxm/types.h>
+#include <shader/spirv_recompiler.h>
+#include <util/fs.h>
+#include <util/log.h>
+
+#include <CLI11.hpp>
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <ranges>
+#include <string>
+#include <vector>
+
+using namespace shader;
+
+namespace {
+
+// the feature flags which can change the generated code
+const std::map<std::string, bool FeatureState::*> feature_flags = {
+    { "support_shader_interlock", &FeatureState::support_shader_interlock },
+    { "support_texture_barrier", &FeatureState::support_texture_barrier },
+    { "direct_fragcolor", &FeatureState::direct_fragcolor },
+    { "support_get_texture_sub_image", &FeatureState::support_get_texture_sub_image },
+    { "preserve_f16_nan_as_u16", &FeatureState::preserve_f16_nan_as_u16 },
+    { "support_unknown_format", &FeatureState::support_unknown_format },
+    { "support_rgb_attributes", &FeatureState::support_rgb_attributes },
+    { "use_mask_bit", &FeatureState::use_mask_bit },
+    { "support_memory_mapping", &FeatureState::support_memory_mapping },
+    { "use_texture_viewport", &FeatureState::use_texture_viewport },
+    { "optimize_spirv", &FeatureState::optimize_spirv },
+};
+
+// the part of the record state given to the recompiler
+constexpr const char *MASKUPDATE = "maskupdate";
+
+// more than this many varied flags would mean thousands of translations per program
+constexpr size_t MAX_VARIED_FLAGS = 10;
+
+const std::map<std::string, Target> targets = {
+    { "glsl", Target::GLSLOpenGL },
+    { "spirv-gl", Target::SpirVOpenGL },
+    { "spirv-vk", Target::SpirVVulkan },
+};
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::vector<std::string> targets;
+    std::vector<std::string> enabled;
+    std::vector<std::string> disabled;
+    std::vector<std::string> varied;
+    std::string output;
+    uint32_t color_format = SCE_GXM_COLOR_FORMAT_U8U8U8U8_ABGR;
+    uint32_t repeat = 1;
+    bool summary_only = false;
+    bool verbose = false;
+};
+
+struct Program {
+    std::string name;
+    std::vector<char> bytes;
+
+    const SceGxmProgram &gxp() const {
+        return *reinterpret_cast<const SceGxmProgram *>(bytes.data());
+    }
+};
+
+// One combination of the inputs of convert_gxp
+struct Variant {
+    std::string name;
+    FeatureState features;
+    bool maskupdate;
+};
+
+struct Result {
+    std::string program;
+    std::string variant;
+    std::string target;
+    double best_ms;
+    double mean_ms;
+    size_t size;
+};
+
+bool load_gxp(const fs::path &path, std::vector<Program> &programs) {
+    std::vector<char> bytes;
+    if (!fs_utils::read_data(path, bytes))
+        return false;
+
+    if (bytes.size() < sizeof(SceGxmProgram) || std::memcmp(bytes.data(), "GXP", 4) != 0)
+        return false;
+
+    const auto &program = *reinterpret_cast<const SceGxmProgram *>(bytes.data());
+    if (program.size > bytes.size())
+        return false;
+
+    programs.push_back({ fs_utils::path_to_utf8(path.stem()), std::move(bytes) });
+    return true;
+}
+
+bool load_inputs(const Options &options, std::vector<Program> &programs) {
+    for (const std::string &input : options.inputs) {
+        const fs::path path = fs_utils::utf8_to_path(input);
+        if (fs::is_directory(path)) {
+            for (const auto &entry : fs::recursive_directory_iterator(path)) {
+                if (fs::is_regular_file(entry.path()) && entry.path().extension() == ".gxp" && !load_gxp(entry.path(), programs))
+                    fmt::print(stderr, "Skipping {}, not a GXP program\n", fs_utils::path_to_utf8(entry.path()));
+            }
+        } else if (!load_gxp(path, programs)) {
+            fmt::print(stderr, "Skipping {}, not a GXP program\n", input);
+        }
+    }
+
+    // keep the output stable whatever order the directories were walked in
+    std::sort(programs.begin(), programs.end(), [](const Program &a, const Program &b) { return a.name < b.name; });
+    return !programs.empty();
+}
+
+bool set_flag(FeatureState &features, bool &maskupdate, const std::string &name, bool value) {
+    if (name == MASKUPDATE) {
+        maskupdate = value;
+        return true;
+    }
+
+    const auto flag = feature_flags.find(name);
+    if (flag == feature_flags.end()) {
+        fmt::print(stderr, "Unknown feature flag {}\n", name);
+        return false;
+    }
+
+    features.*(flag->second) = value;
+    return true;
+}
+
+// Build the base variant from the enabled and disabled flags, then one variant per subset of the varied flags
+bool build_variants(const Options &options, std::vector<Variant> &variants) {
+    Variant base{ "base", {}, false };
+    for (const std::string &name : options.enabled) {
+        if (!set_flag(base.features, base.maskupdate, name, true))
+            return false;
+    }
+    for (const std::string &name : options.disabled) {
+        if (!set_flag(base.features, base.maskupdate, name, false))
+            return false;
+    }
+
+    if (options.varied.size() > MAX_VARIED_FLAGS) {
+        fmt::print(stderr, "Cannot vary more than {} flags at once\n", MAX_VARIED_FLAGS);
+        return false;
+    }
+
+    for (uint32_t subset = 0; subset < (1u << options.varied.size()); subset++) {
+        Variant variant = base;
+        std::vector<std::string> names;
+        for (size_t i = 0; i < options.varied.size(); i++) {
+            const bool value = subset & (1u << i);
+            if (!set_flag(variant.features, variant.maskupdate, options.varied[i], value))
+                return false;
+            if (value)
+                names.push_back(options.varied[i]);
+        }
+        if (!names.empty())
+            variant.name = fmt::format("{}", fmt::join(names, "+"));
+        variants.push_back(std::move(variant));
+    }
+
+    return true;
+}
+
+// Translate the program options.repeat times, returns false if the translator produced nothing
+bool translate(const Options &options, const Program &program, const Variant &variant, const std::string &target_name, Result &result) {
+    using clock = std::chrono::steady_clock;
+
+    // attributes are left out, just like for the shaders of the GUI with stripped symbols
+    Hints hints{
+        .attributes = nullptr,
+        .color_format = static_cast<SceGxmColorFormat>(options.color_format),
+    };
+    std::fill_n(hints.vertex_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+    std::fill_n(hints.fragment_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+
+    const Target target = targets.at(target_name);
+    GeneratedShader shader;
+    double total_ms = 0.0;
+    result = { program.name, variant.name, target_name, 0.0, 0.0, 0 };
+    for (uint32_t i = 0; i < options.repeat; i++) {
+        const auto start = clock::now();
+        shader = convert_gxp(program.gxp(), program.name, variant.features, target, hints, variant.maskupdate);
+        const double elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        total_ms += elapsed;
+        result.best_ms = (i == 0) ? elapsed : std::min(result.best_ms, elapsed);
+    }
+    result.mean_ms = total_ms / options.repeat;
+
+    const bool is_glsl = (target == Target::GLSLOpenGL);
+    result.size = is_glsl ? shader.glsl.size() : shader.spirv.size() * sizeof(uint32_t);
+    if (result.size == 0)
+        return false;
+
+    if (!options.output.empty()) {
+        const char *stage = program.gxp().is_vertex() ? "vert" : "frag";
+        const std::string file_name = fmt::format("{}.{}.{}.{}", program.name, variant.name, stage, is_glsl ? "glsl" : (target == Target::SpirVVulkan ? "vk.spv" : "gl.spv"));
+        const fs::path path = fs_utils::utf8_to_path(options.output) / fs_utils::utf8_to_path(file_name);
+        if (is_glsl)
+            fs_utils::dump_data(path, shader.glsl.data(), shader.glsl.size());
+        else
+            fs_utils::dump_data(path, shader.spirv.data(), shader.spirv.size() * sizeof(uint32_t));
+    }
+
+    return true;
+}
+
+void print_summary(const std::vector<Result> &results, size_t failures) {
+    fmt::print("\n{:<12} {:>10} {:>12} {:>12} {:>12} {:>12}\n", "target", "shaders", "total ms", "mean ms", "median ms", "max ms");
+    for (const auto &[target_name, target] : targets) {
+        std::vector<double> times;
+        for (const Result &result : results) {
+            if (result.target == target_name)
+                times.push_back(result.best_ms);
+        }
+        if (times.empty())
+            continue;
+
+        std::sort(times.begin(), times.end());
+        double total = 0.0;
+        for (const double time : times)
+            total += time;
+        fmt::print("{:<12} {:>10} {:>12.3f} {:>12.3f} {:>12.3f} {:>12.3f}\n", target_name, times.size(), total, total / times.size(), times[times.size() / 2], times.back());
+    }
+
+    if (failures > 0)
+        fmt::print("{} translations failed\n", failures);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    CLI::App app{ "Vita3K offline shader translator" };
+    app.add_option("inputs", options.inputs, "GXP programs or directories containing them, such as the shaderlog folder of a title")->required();
+    app.add_option("-t,--target", options.targets, "Targets to translate to: glsl, spirv-gl or spirv-vk (default: all of them)")
+        ->check(CLI::IsMember({ "glsl", "spirv-gl", "spirv-vk" }));
+    app.add_option("-e,--enable", options.enabled, "Feature flags to enable, or maskupdate");
+    app.add_option("-d,--disable", options.disabled, "Feature flags to disable");
+    app.add_option("--vary", options.varied, "Feature flags to translate both with and without, every combination is translated");
+    app.add_option("-o,--output", options.output, "Directory to write the generated shaders to");
+    app.add_option("--color-format", options.color_format, "SceGxmColorFormat of the color surface given to the fragment programs");
+    app.add_option("-r,--repeat", options.repeat, "Number of times each shader is translated, the best time is reported")->check(CLI::PositiveNumber);
+    app.add_flag("-s,--summary-only", options.summary_only, "Only print the aggregated times");
+    app.add_flag("-v,--verbose", options.verbose, "Print the translator logs");
+    app.footer(fmt::format("Feature flags: {}, {}", fmt::join(std::views::keys(feature_flags), ", "), MASKUPDATE));
+    CLI11_PARSE(app, argc, argv);
+
+    if (options.targets.empty())
+        options.targets = { "glsl", "spirv-gl", "spirv-vk" };
+
+    // the translator is quite chatty
+    logging::set_level(options.verbose ? spdlog::level::trace : spdlog::level::err);
+
+    std::vector<Variant> variants;
+    if (!build_variants(options, variants))
+        return 1;
+
+    std::vector<Program> programs;
+    if (!load_inputs(options, programs)) {
+        fmt::print(stderr, "No GXP program to translate\n");
+        return 1;
+    }
+
+    if (!options.output.empty())
+        fs::create_directories(fs_utils::utf8_to_path(options.output));
+
+    fmt::print("{} programs, {} variants, {} targets\n", programs.size(), variants.size(), options.targets.size());
+    if (!options.summary_only)
+        fmt::print("{:<48} {:<24} {:<10} {:>10} {:>10} {:>10}\n", "program", "variant", "target", "best ms", "mean ms", "bytes");
+
+    std::vector<Result> results;
+    size_t failures = 0;
+    for (const Program &program : programs) {
+        for (const Variant &variant : variants) {
+            for (const std::string &target : options.targets) {
+                Result result;
+                if (!translate(options, program, variant, target, result)) {
+                    fmt::print(stderr, "Failed to translate {} ({}) to {}\n", program.name, variant.name, target);
+                    failures++;
+                    continue;
+                }
+
+                if (!options.summary_only)
+                    fmt::print("{:<48} {:<24} {:<10} {:>10.3f} {:>10.3f} {:>10}\n", result.program, result.variant, result.target, result.best_ms, result.mean_ms, result.size);
+                results.push_back(std::move(result));
+            }
+        }
+    }
+
+    print_summary(results, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+struct EmuEnvState;
+
+namespace app {
+
+/// Tracks an app running in headless mode: when it should stop and what gets reported at exit
+struct HeadlessRun {
+    void start(EmuEnvState &emuenv);
+
+    /// Must be called once per host frame, returns false once the frame or time limit is reached
+    bool update(EmuEnvState &emuenv);
+
+    /// Write the JSON report to the configured path, or to stdout if there is none
+    void write_report(EmuEnvState &emuenv) const;
+
+private:
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point first_frame_time;
+    std::chrono::steady_clock::time_point last_frame_time;
+    size_t start_frame_count = 0;
+    size_t last_frame_count = 0;
+    uint64_t shaders_compiled = 0;
+    std::vector<float> frame_times_ms;
+};
+
+} // namespace app
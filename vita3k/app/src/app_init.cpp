@@ -26,6 +26,7 @@
 #include <gui/imgui_impl_sdl.h>
 #include <gui/state.h>
 #include <io/functions.h>
+#include <io/state.h>
 #include <kernel/state.h>
 #include <ngs/state.h>
 #include <renderer/state.h>
@@ -392,7 +393,9 @@ bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
         break;
 
     case renderer::Backend::Vulkan:
-        window_type = SDL_WINDOW_VULKAN;
+        // in headless mode, the renderer creates its own headless surface instead of using SDL's one
+        if (!state.cfg.headless)
+            window_type = SDL_WINDOW_VULKAN;
         break;
 
     default:
@@ -400,6 +403,9 @@ bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
         break;
     }
 
+    if (state.cfg.headless)
+        window_type |= SDL_WINDOW_HIDDEN;
+
     if (state.cfg.fullscreen) {
         state.display.fullscreen = true;
         window_type |= SDL_WINDOW_FULLSCREEN_DESKTOP;
@@ -487,7 +493,8 @@ bool late_init(EmuEnvState &state) {
             thread->update_status(ThreadStatus::run);
         }
     };
-    if (!state.audio.init(resume_thread, state.cfg.audio_backend)) {
+    state.audio.unthrottled = state.cfg.headless && state.cfg.unthrottled_audio;
+    if (!state.audio.init(resume_thread, state.cfg.headless ? "Null" : state.cfg.audio_backend)) {
         LOG_WARN("Failed to initialize audio! Audio will not work.");
     }
 
@@ -509,6 +516,8 @@ void destroy(EmuEnvState &emuenv, ImGui_State *imgui) {
     if (emuenv.cfg.gdbstub)
         server_close(emuenv);
 
+    emuenv.io.write_behind.flush();
+
     // There may be changes that made in the GUI, so we should save, again
     if (emuenv.cfg.overwrite_config)
         config::serialize_config(emuenv.cfg, emuenv.cfg.config_path);
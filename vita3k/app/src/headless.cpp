@@ -0,0 +1,197 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <app/headless.h>
+
+#include <config/state.h>
+#include <emuenv/state.h>
+#include <io/state.h>
+#include <kernel/state.h>
+#include <nids/functions.h>
+#include <renderer/state.h>
+#include <util/fs.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string_view>
+
+namespace app {
+
+static double elapsed_seconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// quoted JSON string, the title and function names may contain any character
+static std::string json_string(std::string_view str) {
+    std::string quoted = "\"";
+    for (const char c : str) {
+        switch (c) {
+        case '"':
+            quoted += "\\\"";
+            break;
+        case '\\':
+            quoted += "\\\\";
+            break;
+        case '\n':
+            quoted += "\\n";
+            break;
+        case '\r':
+            quoted += "\\r";
+            break;
+        case '\t':
+            quoted += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                quoted += fmt::format("\\u{:04x}", static_cast<int>(c));
+            else
+                quoted += c;
+            break;
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
+
+// nearest-rank percentile of an already sorted list
+static float percentile(const std::vector<float> &sorted, float pct) {
+    if (sorted.empty())
+        return 0.f;
+    const size_t rank = static_cast<size_t>(std::ceil(pct / 100.f * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+void HeadlessRun::start(EmuEnvState &emuenv) {
+    start_time = std::chrono::steady_clock::now();
+    last_frame_time = start_time;
+    start_frame_count = emuenv.total_frame_count;
+    last_frame_count = start_frame_count;
+    emuenv.kernel.debugger.count_import_calls = true;
+
+    LOG_INFO("Running headless (frame limit: {}, time limit: {} s)", emuenv.cfg.run_frames ? std::to_string(*emuenv.cfg.run_frames) : "none",
+        emuenv.cfg.run_seconds ? std::to_string(*emuenv.cfg.run_seconds) : "none");
+}
+
+bool HeadlessRun::update(EmuEnvState &emuenv) {
+    const auto now = std::chrono::steady_clock::now();
+
+    // the renderer counter is reset by whoever displays it, so accumulate it here
+    shaders_compiled += emuenv.renderer->shaders_count_compiled;
+    emuenv.renderer->shaders_count_compiled = 0;
+
+    const size_t frame_count = emuenv.total_frame_count;
+    if (frame_count != last_frame_count) {
+        if (last_frame_count == start_frame_count) {
+            // the time spent before the first frame is loading, not frame time
+            first_frame_time = now;
+        } else {
+            // several frames may have been presented since the last host frame, spread the time evenly
+            const size_t new_frames = frame_count - last_frame_count;
+            const float frame_time = static_cast<float>(elapsed_seconds(last_frame_time, now) * 1000.0 / new_frames);
+            frame_times_ms.insert(frame_times_ms.end(), new_frames, frame_time);
+        }
+        last_frame_time = now;
+        last_frame_count = frame_count;
+    }
+
+    if (emuenv.cfg.run_frames && (frame_count - start_frame_count) >= *emuenv.cfg.run_frames)
+        return false;
+    if (emuenv.cfg.run_seconds && elapsed_seconds(start_time, now) >= *emuenv.cfg.run_seconds)
+        return false;
+
+    return true;
+}
+
+void HeadlessRun::write_report(EmuEnvState &emuenv) const {
+    const auto now = std::chrono::steady_clock::now();
+    const size_t frames = last_frame_count - start_frame_count;
+    const double run_time = elapsed_seconds(start_time, now);
+    const double render_time = frames > 0 ? elapsed_seconds(first_frame_time, last_frame_time) : 0.0;
+
+    std::vector<float> sorted_frame_times = frame_times_ms;
+    std::sort(sorted_frame_times.begin(), sorted_frame_times.end());
+    float avg_frame_time = 0.f;
+    for (const float frame_time : sorted_frame_times)
+        avg_frame_time += frame_time;
+    if (!sorted_frame_times.empty())
+        avg_frame_time /= sorted_frame_times.size();
+
+    // sort HLE calls by decreasing count
+    const auto import_call_counts = emuenv.kernel.debugger.get_import_call_counts();
+    std::vector<std::pair<uint32_t, uint64_t>> hle_calls(import_call_counts.begin(), import_call_counts.end());
+    std::sort(hle_calls.begin(), hle_calls.end(), [](const auto &lhs, const auto &rhs) { return lhs.second > rhs.second; });
+    uint64_t hle_calls_total = 0;
+    std::string hle_functions;
+    for (const auto &[nid, count] : hle_calls) {
+        hle_calls_total += count;
+        if (!hle_functions.empty())
+            hle_functions += ",\n";
+        hle_functions += fmt::format(R"(      {{ "nid": "{}", "name": {}, "count": {} }})", log_hex_full(nid), json_string(import_name(nid)), count);
+    }
+
+    std::string replaced_functions;
+    for (const auto &replacement : emuenv.kernel.function_replacements.get_stats()) {
+        if (replacement.matches == 0)
+            continue;
+        if (!replaced_functions.empty())
+            replaced_functions += ",\n";
+        replaced_functions += fmt::format(R"(    {{ "name": {}, "nid": "{}", "matches": {}, "calls": {} }})", json_string(replacement.name), log_hex_full(replacement.nid), replacement.matches, replacement.calls);
+    }
+
+    const TimerStats timer_stats = emuenv.kernel.timer_service.get_stats();
+    const double timer_avg_late_us = timer_stats.fired > 0 ? std::chrono::duration<double, std::micro>(timer_stats.total_lateness).count() / timer_stats.fired : 0.0;
+
+    const std::string report = fmt::format(R"({{
+  "title_id": {},
+  "backend": {},
+  "run_time_s": {:.3f},
+  "frames": {},
+  "fps": {:.2f},
+  "frame_time_ms": {{ "avg": {:.3f}, "p50": {:.3f}, "p90": {:.3f}, "p99": {:.3f}, "max": {:.3f} }},
+  "shaders_compiled": {},
+  "timers": {{ "fired": {}, "missed_periods": {}, "late_us": {{ "avg": {:.1f}, "max": {:.1f} }} }},
+  "hle_calls": {{
+    "total": {},
+    "functions": [
+{}
+    ]
+  }},
+  "function_replacements": [
+{}
+  ]
+}}
+)",
+        json_string(emuenv.io.title_id), json_string(emuenv.cfg.backend_renderer), run_time, frames, render_time > 0.0 ? (frames - 1) / render_time : 0.0,
+        avg_frame_time, percentile(sorted_frame_times, 50.f), percentile(sorted_frame_times, 90.f), percentile(sorted_frame_times, 99.f),
+        sorted_frame_times.empty() ? 0.f : sorted_frame_times.back(), shaders_compiled,
+        timer_stats.fired, timer_stats.missed_periods, timer_avg_late_us, std::chrono::duration<double, std::micro>(timer_stats.max_lateness).count(), hle_calls_total, hle_functions, replaced_functions);
+
+    if (emuenv.cfg.report_path) {
+        fs::ofstream report_file(fs_utils::utf8_to_path(*emuenv.cfg.report_path));
+        if (report_file) {
+            report_file << report;
+            LOG_INFO("Performance report written to {}", *emuenv.cfg.report_path);
+            return;
+        }
+        LOG_ERROR("Could not write the performance report to {}", *emuenv.cfg.report_path);
+    }
+    std::cout << report;
+}
+
+} // namespace app
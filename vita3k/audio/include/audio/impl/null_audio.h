@@ -0,0 +1,43 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include "../state.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+// Adapter without any audio device, used for headless runs
+// A host thread mixes the ports like a device callback would, either in real time or as fast as possible
+class NullAudioAdapter : public AudioAdapter {
+    std::thread consumer_thread;
+    std::mutex pause_mutex;
+    std::condition_variable pause_cond;
+    std::atomic<bool> running = false;
+    bool paused = false;
+
+    void consume();
+
+public:
+    NullAudioAdapter(AudioState &audio_state);
+    ~NullAudioAdapter() override;
+
+    bool init() override;
+    void switch_state(const bool pause) override;
+};
@@ -119,6 +119,8 @@ struct AudioState {
     ResumeAudioThread resume_thread;
     std::string audio_backend;
     float global_volume;
+    // consume audio as fast as possible instead of in real time (only honoured by the null adapter)
+    bool unthrottled = false;
 
     bool init(const ResumeAudioThread &resume_thread, const std::string &adapter_name);
     void set_backend(const std::string &adapter_name);
@@ -20,6 +20,7 @@
 #include <tracy/Tracy.hpp>
 
 #include <audio/impl/cubeb_audio.h>
+#include <audio/impl/null_audio.h>
 #include <audio/impl/sdl_audio.h>
 
 #include <kernel/thread/thread_state.h>
@@ -104,6 +105,8 @@ void AudioState::set_backend(const std::string &adapter_name) {
         adapter = std::make_unique<SDLAudioAdapter>(*this);
     } else if (adapter_name == "Cubeb") {
         adapter = std::make_unique<CubebAudioAdapter>(*this);
+    } else if (adapter_name == "Null") {
+        adapter = std::make_unique<NullAudioAdapter>(*this);
     } else {
         LOG_ERROR("Unknown audio adapter {}", adapter_name);
         return;
@@ -171,7 +174,7 @@ void AudioState::audio_output(ThreadState &thread, AudioOutPort &out_port, const
     uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     uint64_t diff = now - out_port.last_output;
     uint64_t to_wait = out_port.len_microseconds - diff;
-    if (diff < out_port.len_microseconds && to_wait > 1000) {
+    if (!unthrottled && diff < out_port.len_microseconds && to_wait > 1000) {
         // This is what we should be waiting to be perfectly accurate
         // However, doing so would cause the host audio buffer to often lack samples to output
         // This is because the PS Vita and the host audio parameters do not match exactly
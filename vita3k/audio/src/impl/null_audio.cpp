@@ -0,0 +1,86 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "audio/impl/null_audio.h"
+
+#include <chrono>
+
+// Same output format as the SDL adapter
+static constexpr int NULL_AUDIO_FREQ = 48000;
+static constexpr int NULL_AUDIO_SAMPLES = 512;
+static constexpr int NULL_AUDIO_CHANNELS = 2;
+
+// When unthrottled, still leave some time between two mixes so the consumer does not spin on an idle port
+static constexpr auto UNTHROTTLED_PERIOD = std::chrono::milliseconds(1);
+
+NullAudioAdapter::NullAudioAdapter(AudioState &audio_state)
+    : AudioAdapter(audio_state) {}
+
+NullAudioAdapter::~NullAudioAdapter() {
+    running = false;
+    pause_cond.notify_all();
+    if (consumer_thread.joinable())
+        consumer_thread.join();
+}
+
+bool NullAudioAdapter::init() {
+    state.spec = {
+        .freq = NULL_AUDIO_FREQ,
+        .nb_samples = NULL_AUDIO_SAMPLES,
+        .silence = 0
+    };
+
+    running = true;
+    consumer_thread = std::thread(&NullAudioAdapter::consume, this);
+
+    return true;
+}
+
+void NullAudioAdapter::consume() {
+    std::vector<uint8_t> buffer(NULL_AUDIO_SAMPLES * NULL_AUDIO_CHANNELS * sizeof(int16_t));
+    const auto period = std::chrono::microseconds((NULL_AUDIO_SAMPLES * 1'000'000LL) / NULL_AUDIO_FREQ);
+
+    auto next_deadline = std::chrono::steady_clock::now();
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(pause_mutex);
+            if (paused) {
+                pause_cond.wait(lock, [&]() { return !paused || !running; });
+                next_deadline = std::chrono::steady_clock::now();
+                continue;
+            }
+        }
+
+        audio_callback(buffer.data(), static_cast<int>(buffer.size()));
+
+        if (state.unthrottled) {
+            std::this_thread::sleep_for(UNTHROTTLED_PERIOD);
+        } else {
+            // use absolute deadlines so the consumption rate does not drift
+            next_deadline += period;
+            std::this_thread::sleep_until(next_deadline);
+        }
+    }
+}
+
+void NullAudioAdapter::switch_state(const bool pause) {
+    {
+        const std::lock_guard<std::mutex> lock(pause_mutex);
+        paused = pause;
+    }
+    pause_cond.notify_all();
+}
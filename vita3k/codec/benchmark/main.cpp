@@ -0,0 +1,224 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Decodes an ATRAC9 file as many concurrent streams, one frame of each stream per round like
+// sceAudiodecDecodeNStreams, first one stream after the other and then on the worker pool.
+// Both runs must give the same samples.
+
+#include <codec/state.h>
+
+#include <util/worker_pool.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string path;
+    int streams = 16;
+    int frames = 1000;
+    int workers = static_cast<int>(WorkerPool::default_size());
+};
+
+struct At9File {
+    uint32_t config_data = 0;
+    std::vector<uint8_t> data;
+};
+
+uint32_t read_u32(const uint8_t *data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Take the decoder configuration and the superframes out of a RIFF .at9 file
+bool load_at9(const std::string &path, At9File &file) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        return false;
+
+    const std::vector<uint8_t> bytes{ std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) != 0 || std::memcmp(bytes.data() + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool has_config = false;
+    size_t offset = 12;
+    while (offset + 8 <= bytes.size()) {
+        const uint8_t *chunk = bytes.data() + offset;
+        const uint32_t size = std::min<uint32_t>(read_u32(chunk + 4), bytes.size() - offset - 8);
+        // WAVEFORMATEXTENSIBLE followed by the version and the configuration of the ATRAC9 stream
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 48) {
+            file.config_data = read_u32(chunk + 8 + 44);
+            has_config = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            file.data.assign(chunk + 8, chunk + 8 + size);
+        }
+        offset += 8 + size + (size & 1);
+    }
+
+    return has_config && !file.data.empty();
+}
+
+struct Stream {
+    std::unique_ptr<Atrac9DecoderState> decoder;
+    uint32_t position = 0;
+    std::vector<uint8_t> pcm;
+};
+
+// Decode options.frames rounds and return how long it took, in milliseconds
+double decode(const Options &options, const At9File &file, WorkerPool *workers, std::vector<Stream> &streams) {
+    const uint32_t superframe_size = streams[0].decoder->get(DecoderQuery::AT9_SUPERFRAME_SIZE);
+    const uint32_t superframe_count = static_cast<uint32_t>(file.data.size() / superframe_size);
+    const uint32_t frame_size = streams[0].decoder->get(DecoderQuery::AT9_SAMPLE_PER_FRAME)
+        * streams[0].decoder->get(DecoderQuery::CHANNELS) * sizeof(int16_t);
+
+    // each stream starts on its own superframe, so that they do not all decode the same data
+    for (size_t i = 0; i < streams.size(); i++) {
+        streams[i].position = static_cast<uint32_t>(i % superframe_count) * superframe_size;
+        streams[i].pcm.assign(static_cast<size_t>(options.frames) * frame_size, 0);
+    }
+
+    std::vector<DecodeJob> jobs(streams.size());
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    for (int frame = 0; frame < options.frames; frame++) {
+        for (size_t i = 0; i < streams.size(); i++) {
+            Stream &stream = streams[i];
+            // go back to the start once the last superframe is done
+            if (stream.position + superframe_size > file.data.size())
+                stream.position = 0;
+
+            DecodeJob &job = jobs[i];
+            job = {};
+            job.decoder = stream.decoder.get();
+            job.es_data = file.data.data() + stream.position;
+            job.es_size_max = superframe_size;
+            job.pcm_data = stream.pcm.data() + static_cast<size_t>(frame) * frame_size;
+            job.pcm_size_max = frame_size;
+        }
+
+        if (workers) {
+            decode_frames(*workers, jobs);
+        } else {
+            for (DecodeJob &job : jobs)
+                decode_frames(job);
+        }
+
+        for (size_t i = 0; i < streams.size(); i++) {
+            if (!jobs[i].success)
+                return -1.0;
+            streams[i].position += jobs[i].es_size_used;
+        }
+    }
+
+    return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+}
+
+std::vector<Stream> make_streams(const Options &options, const At9File &file) {
+    std::vector<Stream> streams(options.streams);
+    for (Stream &stream : streams)
+        stream.decoder = std::make_unique<Atrac9DecoderState>(file.config_data);
+    return streams;
+}
+
+void print_usage() {
+    fmt::print("Usage: codec-benchmark [--streams N] [--frames N] [--workers N] file.at9\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            options.path = arg;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+
+        if (arg == "--streams")
+            options.streams = std::stoi(argv[++i]);
+        else if (arg == "--frames")
+            options.frames = std::stoi(argv[++i]);
+        else if (arg == "--workers")
+            options.workers = std::stoi(argv[++i]);
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (options.path.empty() || options.streams <= 0 || options.frames <= 0 || options.workers < 0) {
+        print_usage();
+        return 1;
+    }
+
+    At9File file;
+    if (!load_at9(options.path, file)) {
+        fmt::print("{} is not an ATRAC9 file\n", options.path);
+        return 1;
+    }
+
+    std::vector<Stream> serial = make_streams(options, file);
+    std::vector<Stream> batched = make_streams(options, file);
+    const uint32_t sample_rate = serial[0].decoder->get(DecoderQuery::SAMPLE_RATE);
+    const uint32_t frame_samples = serial[0].decoder->get(DecoderQuery::AT9_SAMPLE_PER_FRAME);
+    if (sample_rate == 0 || frame_samples == 0) {
+        fmt::print("Invalid ATRAC9 configuration {:#010x}\n", file.config_data);
+        return 1;
+    }
+
+    WorkerPool workers;
+    workers.start(static_cast<uint32_t>(options.workers));
+
+    const double serial_ms = decode(options, file, nullptr, serial);
+    const double batched_ms = decode(options, file, &workers, batched);
+    if (serial_ms < 0.0 || batched_ms < 0.0) {
+        fmt::print("Decode failure\n");
+        return 1;
+    }
+
+    for (int i = 0; i < options.streams; i++) {
+        if (serial[i].pcm != batched[i].pcm) {
+            fmt::print("Stream {} differs between the serial and the batched decode\n", i);
+            return 1;
+        }
+    }
+
+    const double audio_ms = 1000.0 * options.frames * frame_samples / sample_rate;
+    fmt::print("{} streams, {} frames of {} samples each ({:.0f} ms of audio at {} Hz)\n", options.streams, options.frames, frame_samples, audio_ms, sample_rate);
+    fmt::print("{:<10} {:>10} {:>16}\n", "decode", "ms", "realtime streams");
+    fmt::print("{:<10} {:>10.1f} {:>16.0f}\n", "serial", serial_ms, options.streams * audio_ms / serial_ms);
+    fmt::print("{:<10} {:>10.1f} {:>16.0f}\n", fmt::format("{} workers", options.workers), batched_ms, options.streams * audio_ms / batched_ms);
+
+    return 0;
+}
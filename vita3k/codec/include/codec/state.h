@@ -17,9 +17,14 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
+#include <vector>
 
 struct AVFrame;
 struct AVPacket;
@@ -29,6 +34,8 @@ struct AVCodecParserContext;
 struct AVCodec;
 struct SwrContext;
 
+class WorkerPool;
+
 union DecoderSize {
     struct {
         uint32_t width;
@@ -80,6 +87,20 @@ struct DecoderState {
     virtual ~DecoderState();
 };
 
+// Frames decoded one after the other from the same stream, the sizes are filled in by decode_frames
+struct DecodeJob {
+    DecoderState *decoder = nullptr;
+    const uint8_t *es_data = nullptr;
+    uint32_t es_size_max = 0;
+    uint8_t *pcm_data = nullptr;
+    uint32_t pcm_size_max = 0;
+    uint32_t frames = 1;
+
+    uint32_t es_size_used = 0;
+    uint32_t pcm_size_given = 0;
+    bool success = false;
+};
+
 struct H264DecoderOptions {
     uint32_t pts_upper;
     uint32_t pts_lower;
@@ -196,6 +217,9 @@ struct ADPCMHistory {
     int32_t hist4;
 };
 
+constexpr uint32_t HEVAG_FRAME_SIZE = 0x10;
+constexpr uint32_t HEVAG_FRAME_SAMPLES = (HEVAG_FRAME_SIZE - 2) * 2;
+
 struct PCMDecoderState : public DecoderState {
 private:
     std::vector<std::uint8_t> final_result;
@@ -241,21 +265,25 @@ struct AacDecoderState : public DecoderState {
     ~AacDecoderState() override;
 };
 
-struct PlayerState {
-    std::string video_playing;
-    std::queue<std::string> videos_queue;
-
-    AVFormatContext *format{};
-    AVCodecContext *video_context{};
-    AVCodecContext *audio_context{};
-    int32_t video_stream_id = -1;
-    int32_t audio_stream_id = -1;
+struct PlayerVideoFrame {
+    std::vector<uint8_t> data;
+    uint64_t timestamp = 0;
+};
 
-    std::queue<AVPacket *> audio_packets;
-    std::queue<AVPacket *> video_packets;
+struct PlayerAudioFrame {
+    std::vector<int16_t> data;
+    uint64_t timestamp = 0;
+    uint32_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint32_t sample_count = 0;
+};
 
-    uint64_t time_of_last_frame = 0;
-    uint64_t framerate_microseconds = 0;
+// Decodes the queued videos on its own thread, a few frames ahead of what the app asked for.
+// Frames are taken from a pool, so once it is warm no allocation happens during playback.
+struct PlayerState {
+    // frames decoded ahead, per stream
+    static constexpr size_t VIDEO_FRAMES_AHEAD = 4;
+    static constexpr size_t AUDIO_FRAMES_AHEAD = 16;
 
     uint64_t last_timestamp = 0;
     uint32_t last_channels = 0;
@@ -264,19 +292,62 @@ struct PlayerState {
 
     DecoderSize get_size();
     uint64_t get_framerate_microseconds();
+    bool is_playing();
 
     void pop_video();
     void free_video();
     void switch_video(const std::string &path);
 
-    bool next_packet(int32_t stream_id);
-
-    std::vector<int16_t> receive_audio();
-    std::vector<uint8_t> receive_video();
+    // Swap the next decoded frame into data, the previous content of data goes back to the pool
+    bool receive_audio(std::vector<int16_t> &data);
+    bool receive_video(std::vector<uint8_t> &data);
+    // Fill the last_* audio fields with the next audio frame, without consuming it
+    bool peek_audio();
 
     void queue(const std::string &path);
 
     ~PlayerState();
+
+private:
+    std::thread decoder_thread;
+
+    // held while the format and codec contexts are used
+    std::mutex decoder_mutex;
+    AVFormatContext *format{};
+    AVCodecContext *video_context{};
+    AVCodecContext *audio_context{};
+    AVFrame *decoded_frame{};
+    int32_t video_stream_id = -1;
+    int32_t audio_stream_id = -1;
+    std::queue<AVPacket *> audio_packets;
+    std::queue<AVPacket *> video_packets;
+
+    // protects everything below
+    std::mutex mutex;
+    std::string video_playing;
+    std::queue<std::string> videos_queue;
+    uint64_t framerate_microseconds = 0;
+    DecoderSize video_size{};
+    std::condition_variable frame_decoded;
+    std::condition_variable frame_consumed;
+    bool decoder_exit = false;
+    bool video_ended = false;
+    bool audio_ended = false;
+    // both streams ended and there is no video left in the queue
+    bool finished = false;
+    // incremented when the app switches or stops the video, frames decoded before are dropped
+    uint32_t generation = 0;
+    std::deque<PlayerVideoFrame> video_frames;
+    std::deque<PlayerAudioFrame> audio_frames;
+    std::vector<PlayerVideoFrame> video_pool;
+    std::vector<PlayerAudioFrame> audio_pool;
+
+    bool next_packet(int32_t stream_id);
+    void open_video(const std::string &path);
+    void close_video();
+    bool decode_video(PlayerVideoFrame &frame);
+    bool decode_audio(PlayerAudioFrame &frame);
+    void decoder_loop();
 };
 
 void convert_rgb_to_yuv(const uint8_t *rgba, uint8_t *yuv, uint32_t width, uint32_t height, const DecoderColorSpace color_space, int32_t in_pitch);
@@ -285,3 +356,12 @@ int convert_yuv_to_jpeg(const uint8_t *yuv, uint8_t *jpeg, uint32_t width, uint3
 void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest, const uint32_t width, const uint32_t height, bool is_p3);
 void calculate_pitch_info(uint32_t width, uint32_t height, int downscale_ratio, DecoderColorSpace color_space, bool use_standard_decoder, MJpegPitch output_pitch[4]);
 std::string codec_error_name(int error);
+
+// Decode a HE-VAG (or plain VAG) frame, writing a sample every stride samples. Returns the frame flags
+uint8_t decode_hevag_frame(const uint8_t *frame, ADPCMHistory &history, int16_t *dest, uint32_t stride = 1);
+
+// Decode the frames of a job, stops at the first one the decoder fails on
+bool decode_frames(DecodeJob &job);
+// Decode the jobs on the workers and the calling thread. The jobs using the same decoder are decoded
+// in order on a single thread, so the result is the same as decoding them one by one.
+void decode_frames(WorkerPool &workers, std::vector<DecodeJob> &jobs);
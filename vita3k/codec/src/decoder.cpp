@@ -22,6 +22,10 @@ extern "C" {
 }
 
 #include <util/log.h>
+#include <util/worker_pool.h>
+
+#include <algorithm>
+#include <cassert>
 
 uint32_t DecoderState::get(DecoderQuery query) {
     return 0;
@@ -56,3 +60,52 @@ std::string codec_error_name(int error) {
         return log_hex(static_cast<uint32_t>(error));
     }
 }
+
+bool decode_frames(DecodeJob &job) {
+    const uint8_t *es_data = job.es_data;
+    uint8_t *pcm_data = job.pcm_data;
+
+    job.es_size_used = 0;
+    job.pcm_size_given = 0;
+    job.success = false;
+
+    for (uint32_t frame = 0; frame < job.frames; frame++) {
+        DecoderSize size;
+        if (!job.decoder->send(es_data, job.es_size_max)
+            || !job.decoder->receive(pcm_data, &size)) {
+            return false;
+        }
+
+        const uint32_t es_size_used = std::min(job.decoder->get_es_size(), job.es_size_max);
+        job.es_size_used += es_size_used;
+        es_data += es_size_used;
+
+        const uint32_t pcm_size_given = size.samples * job.decoder->get(DecoderQuery::CHANNELS) * sizeof(int16_t);
+        assert(pcm_size_given <= job.pcm_size_max);
+        job.pcm_size_given += pcm_size_given;
+        pcm_data += pcm_size_given;
+    }
+
+    job.success = true;
+    return true;
+}
+
+void decode_frames(WorkerPool &workers, std::vector<DecodeJob> &jobs) {
+    // a decoder keeps the history of its stream, its jobs can't be spread
+    std::vector<std::vector<size_t>> groups;
+    std::vector<DecoderState *> group_decoders;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const auto it = std::find(group_decoders.begin(), group_decoders.end(), jobs[i].decoder);
+        if (it == group_decoders.end()) {
+            group_decoders.push_back(jobs[i].decoder);
+            groups.push_back({ i });
+        } else {
+            groups[it - group_decoders.begin()].push_back(i);
+        }
+    }
+
+    workers.run(static_cast<uint32_t>(groups.size()), [&](const uint32_t index) {
+        for (const size_t job : groups[index])
+            decode_frames(jobs[job]);
+    });
+}
@@ -165,6 +165,64 @@ static int nibble_lookup[16] = { 0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3,
  * Original research and algorithm by id-daemon / daemon1.
  * Implementation used from vgmstream project, code by bnnm and korenkonder.
  */
+uint8_t decode_hevag_frame(const uint8_t *frame, ADPCMHistory &history, int16_t *dest, const uint32_t stride) {
+    constexpr std::uint32_t samples_per_frame = HEVAG_FRAME_SAMPLES;
+
+    int32_t hist1 = history.hist1;
+    int32_t hist2 = history.hist2;
+    int32_t hist3 = history.hist3;
+    int32_t hist4 = history.hist4;
+
+    std::uint8_t coef_index = (frame[0] >> 4) & 0xf;
+    std::uint8_t shift_factor = (frame[0] >> 0) & 0xf;
+    coef_index = ((frame[1] >> 0) & 0xf0) | coef_index;
+
+    const std::uint8_t flag = (frame[1] >> 0) & 0xf;
+
+    if ((coef_index > 127) || (shift_factor > 12)) {
+        LOG_WARN("HE ADPCM: in+correct coefs/shift");
+    }
+
+    // Better to reset to 0
+    if (coef_index > 127)
+        coef_index = 0; /* ? */
+
+    // Don't care about it. We don't need that stuff in HEVAG
+    // if (shift_factor > 12)
+    //    shift_factor = 9; /* ? */
+
+    shift_factor = 20 - shift_factor;
+
+    for (std::uint32_t j = 0; j < samples_per_frame; j++) {
+        int32_t sample = 0;
+
+        if (flag < 0x07) { /* with flag 0x07 decoded sample must be 0 */
+            uint8_t nibbles = frame[0x02 + j / 2];
+
+            sample = (j & 1 ? /* low nibble first */
+                             nibble_lookup[nibbles >> 4]
+                            : nibble_lookup[nibbles & 0xF])
+                << shift_factor; /*scale*/
+            sample += ((hist1 * hevag_coefs[coef_index][0] + hist2 * hevag_coefs[coef_index][1] + hist3 * hevag_coefs[coef_index][2] + hist4 * hevag_coefs[coef_index][3]) >> 5);
+            sample >>= 8;
+        }
+
+        dest[j * stride] = static_cast<std::int16_t>(std::clamp(sample, -32768, 32767));
+
+        hist4 = hist3;
+        hist3 = hist2;
+        hist2 = hist1;
+        hist1 = sample;
+    }
+
+    history.hist1 = hist1;
+    history.hist2 = hist2;
+    history.hist3 = hist3;
+    history.hist4 = hist4;
+
+    return flag;
+}
+
 bool PCMDecoderState::send(const uint8_t *data, uint32_t size) {
     const std::uint8_t *source_transformed = data;
     std::uint32_t produced_samples = 0;
@@ -172,8 +230,8 @@ bool PCMDecoderState::send(const uint8_t *data, uint32_t size) {
     std::vector<std::int16_t> transformed;
 
     if (he_adpcm) {
-        const std::uint32_t bytes_per_frame = 0x10;
-        const std::uint32_t samples_per_frame = (bytes_per_frame - 2) * 2;
+        const std::uint32_t bytes_per_frame = HEVAG_FRAME_SIZE;
+        const std::uint32_t samples_per_frame = HEVAG_FRAME_SAMPLES;
 
         if (size % bytes_per_frame != 0) {
             LOG_ERROR("Unaligned HE ADPCM frame size");
@@ -193,60 +251,8 @@ bool PCMDecoderState::send(const uint8_t *data, uint32_t size) {
 
         std::int32_t ch = 0;
         for (std::uint32_t i = 0; i < size / bytes_per_frame; i++) {
-            int32_t hist1 = adpcm_history[ch].hist1;
-            int32_t hist2 = adpcm_history[ch].hist2;
-            int32_t hist3 = adpcm_history[ch].hist3;
-            int32_t hist4 = adpcm_history[ch].hist4;
-
-            const std::uint8_t *frame = data + bytes_per_frame * i;
-
-            std::uint8_t coef_index = (frame[0] >> 4) & 0xf;
-            std::uint8_t shift_factor = (frame[0] >> 0) & 0xf;
-            coef_index = ((frame[1] >> 0) & 0xf0) | coef_index;
-
-            const std::uint8_t flag = (frame[1] >> 0) & 0xf;
-
-            if ((coef_index > 127) || (shift_factor > 12)) {
-                LOG_WARN("HE ADPCM: in+correct coefs/shift at frame {}", i);
-            }
-
-            // Better to reset to 0
-            if (coef_index > 127)
-                coef_index = 0; /* ? */
-
-            // Don't care about it. We don't need that stuff in HEVAG
-            // if (shift_factor > 12)
-            //    shift_factor = 9; /* ? */
-
-            shift_factor = 20 - shift_factor;
-
-            for (std::uint32_t j = 0; j < samples_per_frame; j++) {
-                int32_t sample = 0;
-
-                if (flag < 0x07) { /* with flag 0x07 decoded sample must be 0 */
-                    uint8_t nibbles = frame[0x02 + j / 2];
-
-                    sample = (j & 1 ? /* low nibble first */
-                                     nibble_lookup[nibbles >> 4]
-                                    : nibble_lookup[nibbles & 0xF])
-                        << shift_factor; /*scale*/
-                    sample += ((hist1 * hevag_coefs[coef_index][0] + hist2 * hevag_coefs[coef_index][1] + hist3 * hevag_coefs[coef_index][2] + hist4 * hevag_coefs[coef_index][3]) >> 5);
-                    sample >>= 8;
-                }
-
-                // Multichannel interleaving
-                buffer[j * src_ch + ch] = static_cast<std::int16_t>(std::clamp(sample, -32768, 32767));
-
-                hist4 = hist3;
-                hist3 = hist2;
-                hist2 = hist1;
-                hist1 = sample;
-            }
-
-            adpcm_history[ch].hist1 = hist1;
-            adpcm_history[ch].hist2 = hist2;
-            adpcm_history[ch].hist3 = hist3;
-            adpcm_history[ch].hist4 = hist4;
+            // Multichannel interleaving
+            decode_hevag_frame(data + bytes_per_frame * i, adpcm_history[ch], buffer + ch, src_ch);
 
             ch++;
             ch %= src_ch;
@@ -28,23 +28,40 @@ extern "C" {
 #include <cassert>
 
 uint64_t PlayerState::get_framerate_microseconds() {
-    AVRational rational = format->streams[video_stream_id]->avg_frame_rate;
-    return 1000000ull * rational.den / rational.num;
+    const std::lock_guard<std::mutex> lock(mutex);
+    return framerate_microseconds;
 }
 
 DecoderSize PlayerState::get_size() {
-    if (video_context)
-        return { { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) } };
+    const std::lock_guard<std::mutex> lock(mutex);
+    return video_size;
+}
 
-    return {};
+bool PlayerState::is_playing() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return !video_playing.empty();
 }
 
 void PlayerState::pop_video() {
-    switch_video(videos_queue.front());
-    videos_queue.pop();
+    std::string path;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (videos_queue.empty())
+            return;
+        path = videos_queue.front();
+        videos_queue.pop();
+    }
+    switch_video(path);
 }
 
-void PlayerState::free_video() {
+template <typename T>
+static void recycle_frames(std::deque<T> &frames, std::vector<T> &pool) {
+    for (T &frame : frames)
+        pool.push_back(std::move(frame));
+    frames.clear();
+}
+
+void PlayerState::close_video() {
     if (video_context)
         avcodec_free_context(&video_context);
 
@@ -66,12 +83,37 @@ void PlayerState::free_video() {
         audio_packets.pop();
     }
 
+    video_stream_id = -1;
+    audio_stream_id = -1;
+}
+
+void PlayerState::free_video() {
+    const std::lock_guard<std::mutex> decoder_lock(decoder_mutex);
+    close_video();
+
+    const std::lock_guard<std::mutex> lock(mutex);
     video_playing.clear();
+    recycle_frames(video_frames, video_pool);
+    recycle_frames(audio_frames, audio_pool);
+    generation++;
+    frame_decoded.notify_all();
 }
 
-void PlayerState::switch_video(const std::string &path) {
-    free_video();
-    video_playing = path;
+static AVCodecContext *open_codec(AVStream *stream, bool threaded) {
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(context, stream->codecpar);
+    if (threaded) {
+        // let FFmpeg pick the thread count, the extra latency of frame threading is hidden by the decode-ahead
+        context->thread_count = 0;
+        context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    }
+    avcodec_open2(context, codec, nullptr);
+    return context;
+}
+
+void PlayerState::open_video(const std::string &path) {
+    close_video();
 
     int error = avformat_open_input(&format, path.c_str(), nullptr, nullptr);
     assert(error == 0);
@@ -83,21 +125,46 @@ void PlayerState::switch_video(const std::string &path) {
     video_stream_id = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
     audio_stream_id = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
 
+    DecoderSize size{};
+    uint64_t framerate = 0;
     if (video_stream_id >= 0) {
         AVStream *video_stream = format->streams[video_stream_id];
-        const AVCodec *video_codec = avcodec_find_decoder(video_stream->codecpar->codec_id);
-        video_context = avcodec_alloc_context3(video_codec);
-        avcodec_parameters_to_context(video_context, video_stream->codecpar);
-        avcodec_open2(video_context, video_codec, nullptr);
+        video_context = open_codec(video_stream, true);
+        size = { { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) } };
+        const AVRational rational = video_stream->avg_frame_rate;
+        if (rational.num)
+            framerate = 1000000ull * rational.den / rational.num;
     }
 
-    if (audio_stream_id >= 0) {
-        AVStream *audio_stream = format->streams[audio_stream_id];
-        const AVCodec *audio_codec = avcodec_find_decoder(audio_stream->codecpar->codec_id);
-        audio_context = avcodec_alloc_context3(audio_codec);
-        avcodec_parameters_to_context(audio_context, audio_stream->codecpar);
-        avcodec_open2(audio_context, audio_codec, nullptr);
+    if (audio_stream_id >= 0)
+        audio_context = open_codec(format->streams[audio_stream_id], false);
+
+    if (!decoded_frame)
+        decoded_frame = av_frame_alloc();
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    video_playing = path;
+    video_size = size;
+    framerate_microseconds = framerate;
+    video_ended = video_stream_id < 0;
+    audio_ended = audio_stream_id < 0;
+    finished = false;
+}
+
+void PlayerState::switch_video(const std::string &path) {
+    {
+        const std::lock_guard<std::mutex> decoder_lock(decoder_mutex);
+        open_video(path);
+
+        const std::lock_guard<std::mutex> lock(mutex);
+        recycle_frames(video_frames, video_pool);
+        recycle_frames(audio_frames, audio_pool);
+        generation++;
     }
+
+    if (!decoder_thread.joinable())
+        decoder_thread = std::thread(&PlayerState::decoder_loop, this);
+    frame_consumed.notify_all();
 }
 
 bool PlayerState::next_packet(int32_t stream_id) {
@@ -124,8 +191,10 @@ bool PlayerState::next_packet(int32_t stream_id) {
         }
 
         AVPacket *packet = av_packet_alloc();
-        if (av_read_frame(format, packet) != 0)
+        if (av_read_frame(format, packet) != 0) {
+            av_packet_free(&packet);
             return false;
+        }
 
         if (packet->stream_index == stream_id) {
             this_queue.push(packet);
@@ -135,115 +204,241 @@ bool PlayerState::next_packet(int32_t stream_id) {
     }
 }
 
-std::vector<int16_t> PlayerState::receive_audio() {
-    if (audio_stream_id < 0)
-        return {};
-
-    if (video_playing.empty())
-        return {};
-
-    AVFrame *frame = av_frame_alloc();
-    std::vector<int16_t> data;
+bool PlayerState::decode_audio(PlayerAudioFrame &frame) {
     while (true) {
-        int error = avcodec_receive_frame(audio_context, frame);
+        const int error = avcodec_receive_frame(audio_context, decoded_frame);
 
-        if (error == AVERROR(EAGAIN) && next_packet(audio_stream_id))
+        if (error == AVERROR(EAGAIN)) {
+            // at the end of the file, drain what is still buffered in the decoder
+            if (!next_packet(audio_stream_id))
+                avcodec_send_packet(audio_context, nullptr);
             continue;
-
-        if (error != 0) {
-            if (videos_queue.empty()) {
-                // Stop playing videos or
-                video_playing.clear();
-                break;
-            } else {
-                // Play the next video (if there is any).
-                switch_video(videos_queue.front());
-                videos_queue.pop();
-                continue;
-            }
         }
 
-        LOG_WARN_IF(frame->format != AV_SAMPLE_FMT_FLTP, "Unknown audio format {}.", frame->format);
-
-        last_channels = frame->ch_layout.nb_channels;
-        last_sample_count = frame->nb_samples;
-        last_sample_rate = frame->sample_rate;
+        if (error != 0)
+            return false;
 
-        data.resize(frame->nb_samples * frame->ch_layout.nb_channels);
+        LOG_WARN_IF(decoded_frame->format != AV_SAMPLE_FMT_FLTP, "Unknown audio format {}.", decoded_frame->format);
 
-        for (int a = 0; a < frame->nb_samples; a++) {
-            for (int b = 0; b < frame->ch_layout.nb_channels; b++) {
-                auto *frame_data = reinterpret_cast<float *>(frame->data[b]);
-                float current_sample = frame_data[a];
-                int16_t pcm_sample = current_sample * INT16_MAX;
+        const int channels = decoded_frame->ch_layout.nb_channels;
+        frame.timestamp = decoded_frame->best_effort_timestamp;
+        frame.channels = channels;
+        frame.sample_count = decoded_frame->nb_samples;
+        frame.sample_rate = decoded_frame->sample_rate;
+        frame.data.resize(decoded_frame->nb_samples * channels);
 
-                data[a * frame->ch_layout.nb_channels + b] = pcm_sample;
-            }
+        for (int b = 0; b < channels; b++) {
+            const auto *frame_data = reinterpret_cast<const float *>(decoded_frame->data[b]);
+            for (int a = 0; a < decoded_frame->nb_samples; a++)
+                frame.data[a * channels + b] = static_cast<int16_t>(frame_data[a] * INT16_MAX);
         }
 
-        break;
+        return true;
     }
-
-    av_frame_free(&frame);
-    return data;
 }
 
-std::vector<uint8_t> PlayerState::receive_video() {
-    if (video_stream_id < 0)
-        return {};
+bool PlayerState::decode_video(PlayerVideoFrame &frame) {
+    while (true) {
+        const int error = avcodec_receive_frame(video_context, decoded_frame);
+
+        if (error == AVERROR(EAGAIN)) {
+            // at the end of the file, drain the frames still held by the decoder threads
+            if (!next_packet(video_stream_id))
+                avcodec_send_packet(video_context, nullptr);
+            continue;
+        }
 
-    if (video_playing.empty())
+        if (error != 0)
+            return false;
+
+        frame.timestamp = decoded_frame->best_effort_timestamp;
+        frame.data.resize(H264DecoderState::buffer_size(
+            { { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) } }));
+        copy_yuv_data_from_frame(decoded_frame, frame.data.data(), decoded_frame->width, decoded_frame->height, false);
+
+        return true;
+    }
+}
+
+template <typename T>
+static T take_from_pool(std::vector<T> &pool) {
+    if (pool.empty())
         return {};
+    T frame = std::move(pool.back());
+    pool.pop_back();
+    return frame;
+}
 
-    AVFrame *frame = av_frame_alloc();
-    std::vector<uint8_t> data;
+void PlayerState::decoder_loop() {
     while (true) {
-        int error = avcodec_receive_frame(video_context, frame);
+        std::string next_video;
+        bool need_video = false;
+        bool need_audio = false;
+        uint32_t frame_generation;
+        PlayerVideoFrame video_frame;
+        PlayerAudioFrame audio_frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            const auto has_work = [&] {
+                need_video = !video_ended && video_frames.size() < VIDEO_FRAMES_AHEAD;
+                need_audio = !audio_ended && audio_frames.size() < AUDIO_FRAMES_AHEAD;
+                return need_video || need_audio || (video_ended && audio_ended);
+            };
+            frame_consumed.wait(lock, [&] { return decoder_exit || (!video_playing.empty() && !finished && has_work()); });
+            if (decoder_exit)
+                return;
+
+            if (!need_video && !need_audio) {
+                // the current video is over, go on with the next one or let the app drain the frames left
+                if (videos_queue.empty()) {
+                    finished = true;
+                    frame_decoded.notify_all();
+                    continue;
+                }
+                // only taken from the queue once it is sure to be opened
+                next_video = videos_queue.front();
+            }
 
-        if (error == AVERROR(EAGAIN) && next_packet(video_stream_id))
-            continue;
+            frame_generation = generation;
+            if (need_video)
+                video_frame = take_from_pool(video_pool);
+            if (need_audio)
+                audio_frame = take_from_pool(audio_pool);
+        }
 
-        if (error != 0) {
-            if (videos_queue.empty()) {
-                // Stop playing videos or
-                video_playing.clear();
-                break;
-            } else {
-                // Play the next video (if there is any).
-                switch_video(videos_queue.front());
-                videos_queue.pop();
+        const std::lock_guard<std::mutex> decoder_lock(decoder_mutex);
+        {
+            // the app may have switched or stopped the video, or popped the next one, while no lock was held
+            const std::lock_guard<std::mutex> lock(mutex);
+            const bool next_video_taken = !next_video.empty() && (videos_queue.empty() || videos_queue.front() != next_video);
+            if (frame_generation != generation || next_video_taken) {
+                if (need_video)
+                    video_pool.push_back(std::move(video_frame));
+                if (need_audio)
+                    audio_pool.push_back(std::move(audio_frame));
                 continue;
             }
+            if (!next_video.empty())
+                videos_queue.pop();
+        }
+        if (!next_video.empty()) {
+            open_video(next_video);
+            continue;
         }
 
-        last_timestamp = frame->best_effort_timestamp;
+        const bool has_video = need_video && decode_video(video_frame);
+        const bool has_audio = need_audio && decode_audio(audio_frame);
 
-        data.resize(H264DecoderState::buffer_size(
-            { { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) } }));
-        copy_yuv_data_from_frame(frame, data.data(), frame->width, frame->height, false);
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (frame_generation == generation) {
+            if (need_video) {
+                if (has_video)
+                    video_frames.push_back(std::move(video_frame));
+                else
+                    video_ended = true;
+            }
+            if (need_audio) {
+                if (has_audio)
+                    audio_frames.push_back(std::move(audio_frame));
+                else
+                    audio_ended = true;
+            }
+            frame_decoded.notify_all();
+        }
+        if (need_video && (!has_video || frame_generation != generation))
+            video_pool.push_back(std::move(video_frame));
+        if (need_audio && (!has_audio || frame_generation != generation))
+            audio_pool.push_back(std::move(audio_frame));
+    }
+}
 
-        break;
+bool PlayerState::receive_audio(std::vector<int16_t> &data) {
+    std::unique_lock<std::mutex> lock(mutex);
+    frame_decoded.wait(lock, [&] { return !audio_frames.empty() || audio_ended || video_playing.empty(); });
+
+    if (audio_frames.empty()) {
+        if (finished)
+            video_playing.clear();
+        return false;
+    }
+
+    PlayerAudioFrame &frame = audio_frames.front();
+    last_timestamp = frame.timestamp;
+    last_channels = frame.channels;
+    last_sample_count = frame.sample_count;
+    last_sample_rate = frame.sample_rate;
+    std::swap(data, frame.data);
+
+    audio_pool.push_back(std::move(frame));
+    audio_frames.pop_front();
+    frame_consumed.notify_one();
+    return true;
+}
+
+bool PlayerState::peek_audio() {
+    std::unique_lock<std::mutex> lock(mutex);
+    frame_decoded.wait(lock, [&] { return !audio_frames.empty() || audio_ended || video_playing.empty(); });
+
+    if (audio_frames.empty())
+        return false;
+
+    const PlayerAudioFrame &frame = audio_frames.front();
+    last_channels = frame.channels;
+    last_sample_count = frame.sample_count;
+    last_sample_rate = frame.sample_rate;
+    return true;
+}
+
+bool PlayerState::receive_video(std::vector<uint8_t> &data) {
+    std::unique_lock<std::mutex> lock(mutex);
+    frame_decoded.wait(lock, [&] { return !video_frames.empty() || video_ended || video_playing.empty(); });
+
+    if (video_frames.empty()) {
+        if (finished)
+            video_playing.clear();
+        return false;
     }
 
-    av_frame_free(&frame);
-    return data;
+    PlayerVideoFrame &frame = video_frames.front();
+    last_timestamp = frame.timestamp;
+    std::swap(data, frame.data);
+
+    video_pool.push_back(std::move(frame));
+    video_frames.pop_front();
+    frame_consumed.notify_one();
+    return true;
 }
 
 void PlayerState::queue(const std::string &path) {
-    if (fs::exists(path)) {
-        LOG_INFO("Queued video: '{}'.", path);
-        if (video_playing.empty())
-            switch_video(path);
-        else
-            videos_queue.push(path);
-    } else {
+    if (!fs::exists(path)) {
         LOG_INFO("Cannot find video: {}", path);
+        return;
+    }
+
+    LOG_INFO("Queued video: '{}'.", path);
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (!video_playing.empty()) {
+            videos_queue.push(path);
+            finished = false;
+            frame_consumed.notify_all();
+            return;
+        }
     }
+    switch_video(path);
 }
 
 PlayerState::~PlayerState() {
-    free_video();
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        decoder_exit = true;
+    }
+    frame_consumed.notify_all();
+    if (decoder_thread.joinable())
+        decoder_thread.join();
 
-    video_playing.clear();
+    free_video();
+    if (decoded_frame)
+        av_frame_free(&decoded_frame);
     videos_queue = {};
 }
@@ -143,6 +143,8 @@ enum ScreenshotFormat {
     code(int, "keyboard-gui-toggle-touch", 23, keyboard_gui_toggle_touch)                               \
     code(int, "keyboard-toggle-texture-replacement", 0, keyboard_toggle_texture_replacement)            \
     code(int, "keyboard-take-screenshot", 0, keyboard_take_screenshot)                                  \
+    code(int, "keyboard-save-snapshot", 0, keyboard_save_snapshot)                                      \
+    code(int, "keyboard-load-snapshot", 0, keyboard_load_snapshot)                                      \
     code(std::string, "user-id", std::string{}, user_id)                                                \
     code(bool, "user-auto-connect", false, auto_user_login)                                             \
     code(std::string, "user-lang", std::string{}, user_lang)                                            \
@@ -153,6 +155,7 @@ enum ScreenshotFormat {
     code(bool, "asia-font-support", false, asia_font_support)                                           \
     code(bool, "shader-cache", true, shader_cache)                                                      \
     code(bool, "spirv-shader", false, spirv_shader)                                                     \
+    code(bool, "optimize-shaders", false, optimize_shaders)                                             \
     code(bool, "fps-hack", false, fps_hack)                                                             \
     code(uint64_t, "current-ime-lang", 4, current_ime_lang)                                             \
     code(int, "psn-signed-in", false, psn_signed_in)                                                    \
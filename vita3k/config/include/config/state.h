@@ -75,6 +75,16 @@ private:
             pkg_path = rhs.pkg_path;
         if (rhs.pkg_zrif.has_value())
             pkg_zrif = rhs.pkg_zrif;
+        if (rhs.run_frames.has_value())
+            run_frames = rhs.run_frames;
+        if (rhs.run_seconds.has_value())
+            run_seconds = rhs.run_seconds;
+        if (rhs.report_path.has_value())
+            report_path = rhs.report_path;
+        if (rhs.gxm_trace_path.has_value())
+            gxm_trace_path = rhs.gxm_trace_path;
+        if (rhs.load_snapshot_path.has_value())
+            load_snapshot_path = rhs.load_snapshot_path;
 
         if (!rhs.config_path.empty())
             config_path = rhs.config_path;
@@ -83,6 +93,8 @@ private:
         load_config = rhs.load_config;
         fullscreen = rhs.fullscreen;
         console = rhs.console;
+        headless = rhs.headless;
+        unthrottled_audio = rhs.unthrottled_audio;
         app_args = rhs.app_args;
         load_app_list = rhs.load_app_list;
         self_path = rhs.self_path;
@@ -97,6 +109,14 @@ public:
     std::optional<std::string> pkg_path;
     std::optional<std::string> pkg_zrif;
     std::optional<std::string> pup_path;
+    // Headless run limits and report location
+    std::optional<uint32_t> run_frames;
+    std::optional<double> run_seconds;
+    std::optional<std::string> report_path;
+    // Record the renderer activity to this file, for renderer-replay
+    std::optional<std::string> gxm_trace_path;
+    // Restore this snapshot of the app instead of starting it
+    std::optional<std::string> load_snapshot_path;
 
     // Setting not present in the YAML file
     fs::path config_path = {};
@@ -106,6 +126,8 @@ public:
     bool load_config = false;
     bool fullscreen = false;
     bool console = false;
+    bool headless = false;
+    bool unthrottled_audio = false;
     bool load_app_list = false;
 
     fs::path get_pref_path() const {
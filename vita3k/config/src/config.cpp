@@ -143,6 +143,20 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
     auto input = app.add_option_group("Input", "Special options for Vita3K");
     input->add_flag("--console,-z", command_line.console, "Start the emulator in console mode.")
        ->default_val(false)->group("Input");
+    input->add_flag("--headless,-H", command_line.headless, "Run the app without a window or audio device, rendering offscreen.")
+       ->default_val(false)->group("Input");
+    input->add_option("--run-frames", command_line.run_frames, "Quit after the app has presented the given number of frames.")
+        ->check(CLI::PositiveNumber)->group("Input");
+    input->add_option("--run-seconds", command_line.run_seconds, "Quit after the app has been running for the given number of seconds.")
+        ->check(CLI::PositiveNumber)->group("Input");
+    input->add_option("--report,-R", command_line.report_path, "Write a JSON performance report to the given file when the app quits.")
+        ->default_str({})->group("Input");
+    input->add_option("--gxm-trace", command_line.gxm_trace_path, "Record the GXM commands and the guest memory they read to the given file, to be replayed by renderer-replay.")
+        ->default_str({})->group("Input");
+    input->add_option("--load-snapshot", command_line.load_snapshot_path, "Restore the given snapshot instead of starting the app. It must have been saved from the app given with --installed-path.")
+        ->default_str({})->group("Input");
+    input->add_flag("--unthrottled-audio", command_line.unthrottled_audio, "In headless mode, consume audio as fast as possible instead of in real time.")
+       ->default_val(false)->group("Input");
     input->add_option("--app-args,-Z", command_line.app_args, "Argument for app, use ', ' to separate arguments.")
         ->default_str("")->group("Input");
     input->add_option("--load-app-list,-a", command_line.load_app_list, "Starts the emulator with load app list.")
@@ -240,6 +254,11 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
         return InitConfigFailed;
     }
 
+    if (command_line.headless && !command_line.run_app_path && !command_line.content_path) {
+        LOG_ERROR("Headless mode needs an app to run, use --installed-path or give a content path.");
+        return InitConfigFailed;
+    }
+
     // Get LLE modules from the command line, otherwise get the modules from the YML file
     if (!lle_modules.empty()) {
         if (command_line.load_config) {
@@ -263,6 +282,7 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
 
         LOG_INFO_IF(cfg.content_path, "input-content-path: {}", cfg.content_path->string());
         LOG_INFO_IF(cfg.run_app_path, "input-installed-path: {}", *cfg.run_app_path);
+        LOG_INFO_IF(cfg.load_snapshot_path, "input-load-snapshot: {}", *cfg.load_snapshot_path);
         LOG_INFO("{}: {}", cfg[e_backend_renderer], cfg.backend_renderer);
         LOG_INFO("{}: {}", cfg[e_log_level], LIST_LOG_LEVEL[cfg.log_level]);
         LOG_INFO_IF(cfg.log_active_shaders, "{}: enabled", cfg[e_log_active_shaders]);
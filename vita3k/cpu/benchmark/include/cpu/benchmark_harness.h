@@ -0,0 +1,113 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// What the benchmarks running guest code share: the protocol of a CPU without a kernel, guest memcpy and memset
+// routines, and calls of guest functions from the host.
+
+#pragma once
+
+#include <cpu/common.h>
+#include <cpu/functions.h>
+#include <cpu/state.h>
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace cpu_benchmark {
+
+// memcpy(r0 = destination, r1 = source, r2 = size): 4 bytes at a time, then the remaining bytes
+inline const std::vector<uint32_t> guest_memcpy_code = {
+    0xE1A03000, // mov r3, r0
+    0xE3520004, // cmp r2, #4
+    0x3A000004, // blo tail
+    0xE491C004, // word: ldr r12, [r1], #4
+    0xE483C004, // str r12, [r3], #4
+    0xE2422004, // sub r2, r2, #4
+    0xE3520004, // cmp r2, #4
+    0x2AFFFFFA, // bhs word
+    0xE2522001, // tail: subs r2, r2, #1
+    0x312FFF1E, // bxlo lr
+    0xE4D1C001, // ldrb r12, [r1], #1
+    0xE4C3C001, // strb r12, [r3], #1
+    0xEAFFFFFA, // b tail
+};
+
+// memset(r0 = destination, r1 = value, r2 = size): the value is replicated to store 4 bytes at a time
+inline const std::vector<uint32_t> guest_memset_code = {
+    0xE20110FF, // and r1, r1, #0xFF
+    0xE1811401, // orr r1, r1, r1, lsl #8
+    0xE1811801, // orr r1, r1, r1, lsl #16
+    0xE1A03000, // mov r3, r0
+    0xE3520004, // cmp r2, #4
+    0x3A000003, // blo tail
+    0xE4831004, // word: str r1, [r3], #4
+    0xE2422004, // sub r2, r2, #4
+    0xE3520004, // cmp r2, #4
+    0x2AFFFFFB, // bhs word
+    0xE2522001, // tail: subs r2, r2, #1
+    0x312FFF1E, // bxlo lr
+    0xE4C31001, // strb r1, [r3], #1
+    0xEAFFFFFB, // b tail
+};
+
+// The svc are served by the benchmark instead of going through the kernel
+struct BenchmarkProtocol : CPUProtocolBase {
+    void call_svc(CPUState &cpu, uint32_t svc, Address pc, ThreadState &thread) override {}
+    Address get_watch_memory_addr(Address addr) override {
+        return 0;
+    }
+    ExclusiveMonitorPtr get_exclusive_monitor() override {
+        return monitor;
+    }
+
+    ExclusiveMonitorPtr monitor = nullptr;
+};
+
+inline Address write_code(MemState &mem, const std::vector<uint32_t> &code) {
+    const Address address = alloc(mem, static_cast<uint32_t>(code.size() * sizeof(uint32_t)), "benchmark code");
+    std::copy(code.begin(), code.end(), Ptr<uint32_t>(address).get(mem));
+    return address;
+}
+
+// Call the ARM function until it returns, serve_svc is called after each svc it makes
+template <typename ServeSvc>
+bool call(CPUState &cpu, Address function, uint32_t r0, uint32_t r1, uint32_t r2, ServeSvc &&serve_svc) {
+    write_reg(cpu, 0, r0);
+    write_reg(cpu, 1, r1);
+    write_reg(cpu, 2, r2);
+    write_lr(cpu, cpu.halt_instruction_pc);
+    write_pc(cpu, function);
+    while (true) {
+        const int res = run(cpu);
+        if (res < 0)
+            return false;
+        if (res)
+            return true;
+        if (cpu.svc_called)
+            serve_svc();
+    }
+}
+
+inline bool call(CPUState &cpu, Address function, uint32_t r0, uint32_t r1, uint32_t r2) {
+    return call(cpu, function, r0, r1, r2, [] {});
+}
+
+} // namespace cpu_benchmark
@@ -0,0 +1,258 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Times fiber switches the way SceFiber serves them, two guest fibers switching to each other through an svc stub:
+// - context: what SceFiber used to do, the whole CPU context saved and loaded, the thread state found in maps under
+//   a mutex, after the kernel thread lookup
+// - callee saved: the registers a call preserves swapped, the thread state kept in a thread local slot
+// and reports the number of switches per second of each.
+
+#include <cpu/benchmark_harness.h>
+#include <cpu/common.h>
+#include <cpu/functions.h>
+#include <cpu/state.h>
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <fmt/core.h>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+using cpu_benchmark::BenchmarkProtocol;
+using cpu_benchmark::write_code;
+
+constexpr SceUID THREAD_ID = 1;
+constexpr uint32_t FIBER_STACK_SIZE = KiB(4);
+
+// fiber(r0 = fiber index): keeps its index in r5 and counts its switches in r4
+const std::vector<uint32_t> fiber_code = {
+    0xE1A05000, // mov r5, r0
+    0xE3A04000, // mov r4, #0
+    0xE2844001, // loop: add r4, r4, #1
+    0xEB000000, // bl switch
+    0xEAFFFFFC, // b loop
+    0xEF000000, // switch: svc #0
+    0xE1A0F00E, // mov pc, lr
+};
+
+// The svc are served by the benchmark
+struct Options {
+    double seconds = 1.0;
+};
+
+struct Fibers {
+    Address entry;
+    std::array<Address, 2> stacks;
+};
+
+// Switches the thread to the other fiber, the first switch starts it
+struct Switcher {
+    virtual ~Switcher() = default;
+    virtual void switch_fiber(CPUState &cpu, const Fibers &fibers) = 0;
+    int current = 0;
+};
+
+// The kernel thread list, looked up by every import
+struct Kernel {
+    std::mutex mutex;
+    std::map<SceUID, std::shared_ptr<CPUState *>> threads;
+};
+
+struct ContextSwitcher : Switcher {
+    explicit ContextSwitcher(CPUState &cpu) {
+        kernel.threads.emplace(THREAD_ID, std::make_shared<CPUState *>(&cpu));
+        thread_fibers[THREAD_ID] = 0;
+        thread_contexts[THREAD_ID] = save_context(cpu);
+        for (auto &context : contexts)
+            context = std::make_unique<CPUContext>();
+    }
+
+    void switch_fiber(CPUState &, const Fibers &fibers) override {
+        std::shared_ptr<CPUState *> thread;
+        {
+            const std::lock_guard<std::mutex> lock(kernel.mutex);
+            thread = kernel.threads.find(THREAD_ID)->second;
+        }
+        CPUState &cpu = **thread;
+
+        const std::lock_guard<std::mutex> lock(mutex);
+        const CPUContext thread_context = thread_contexts[THREAD_ID];
+        const int from = thread_fibers.find(THREAD_ID)->second;
+        *contexts[from] = save_context(cpu);
+        contexts[from]->cpu_registers[0] = 0;
+
+        current = 1 - from;
+        CPUContext &to = *contexts[current];
+        if (!started[current]) {
+            to = thread_context;
+            to.cpu_registers[0] = current;
+            to.set_sp(fibers.stacks[current] + FIBER_STACK_SIZE);
+            to.set_pc(fibers.entry);
+            started[current] = true;
+        }
+        thread_fibers[THREAD_ID] = current;
+        load_context(cpu, to);
+    }
+
+    Kernel kernel;
+    std::mutex mutex;
+    std::map<SceUID, int> thread_fibers;
+    std::map<SceUID, CPUContext> thread_contexts;
+    std::array<std::unique_ptr<CPUContext>, 2> contexts;
+    std::array<bool, 2> started = { true, false };
+};
+
+struct ThreadSlot {
+    SceUID thread_id = 0;
+    CPUState *cpu = nullptr;
+    int fiber = 0;
+};
+
+thread_local ThreadSlot thread_slot;
+
+struct CalleeSavedSwitcher : Switcher {
+    explicit CalleeSavedSwitcher(CPUState &cpu) {
+        thread_slot = { THREAD_ID, &cpu, 0 };
+    }
+
+    void switch_fiber(CPUState &, const Fibers &fibers) override {
+        ThreadSlot &slot = thread_slot;
+        CPUState &cpu = *slot.cpu;
+        contexts[slot.fiber] = save_callee_saved(cpu);
+
+        slot.fiber = 1 - slot.fiber;
+        current = slot.fiber;
+        if (!started[current]) {
+            write_reg(cpu, 0, current);
+            write_sp(cpu, fibers.stacks[current] + FIBER_STACK_SIZE);
+            write_pc(cpu, fibers.entry);
+            started[current] = true;
+            return;
+        }
+        load_callee_saved(cpu, contexts[current]);
+    }
+
+    std::array<CalleeSavedContext, 2> contexts;
+    std::array<bool, 2> started = { true, false };
+};
+
+// Switches per second, negative if the CPU failed or a fiber did not get its own registers back
+double time_switches(const Options &options, CPUState &cpu, const Fibers &fibers, Switcher &switcher) {
+    write_reg(cpu, 0, 0);
+    write_sp(cpu, fibers.stacks[0] + FIBER_STACK_SIZE);
+    write_lr(cpu, cpu.halt_instruction_pc);
+    write_pc(cpu, fibers.entry);
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const auto deadline = start + std::chrono::duration<double>(options.seconds);
+    uint64_t switches = 0;
+    auto now = start;
+    while (true) {
+        const int res = run(cpu);
+        if (res < 0)
+            return -1.0;
+        if (res)
+            break;
+        if (!cpu.svc_called)
+            continue;
+
+        if (read_reg(cpu, 5) != static_cast<uint32_t>(switcher.current))
+            return -1.0;
+        switches++;
+        // amortize the clock over a few switches
+        if ((switches % 64) == 0) {
+            now = clock::now();
+            if (now >= deadline) {
+                write_lr(cpu, cpu.halt_instruction_pc);
+                continue;
+            }
+        }
+        switcher.switch_fiber(cpu, fibers);
+    }
+
+    // each fiber counted its own switches
+    if (read_reg(cpu, 4) != (switches + 1) / 2)
+        return -1.0;
+
+    return switches / std::chrono::duration<double>(now - start).count();
+}
+
+void print_usage() {
+    fmt::print("Usage: cpu-benchmark [--seconds S]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::stod(argv[++i]);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    MemState mem;
+    if (!init(mem, false)) {
+        fmt::print("Failed to initialize the memory\n");
+        return 1;
+    }
+
+    BenchmarkProtocol protocol;
+    protocol.monitor = new_exclusive_monitor(1);
+    const Fibers fibers = {
+        write_code(mem, fiber_code),
+        { alloc(mem, FIBER_STACK_SIZE, "fiber stack"), alloc(mem, FIBER_STACK_SIZE, "fiber stack") },
+    };
+
+    fmt::print("{:<16} {:>16}\n", "switch", "switches/s");
+    for (const CPUBackend backend : { CPUBackend::Dynarmic, CPUBackend::Unicorn }) {
+        CPUStatePtr cpu = init_cpu(backend, true, THREAD_ID, 0, mem, &protocol);
+        if (!cpu) {
+            fmt::print("Failed to initialize the CPU\n");
+            return 1;
+        }
+
+        const char *backend_name = backend == CPUBackend::Dynarmic ? "dynarmic" : "unicorn";
+        ContextSwitcher context(*cpu);
+        CalleeSavedSwitcher callee_saved(*cpu);
+        const double context_rate = time_switches(options, *cpu, fibers, context);
+        const double callee_saved_rate = time_switches(options, *cpu, fibers, callee_saved);
+        if (context_rate < 0 || callee_saved_rate < 0) {
+            fmt::print("The fibers did not run as expected on {}\n", backend_name);
+            return 1;
+        }
+        fmt::print("{:<16} {:>16.0f}\n", fmt::format("{} context", backend_name), context_rate);
+        fmt::print("{:<16} {:>16.0f}   x{:.2f}\n", fmt::format("{} callee", backend_name), callee_saved_rate, callee_saved_rate / context_rate);
+    }
+
+    free_exclusive_monitor(protocol.monitor);
+    return 0;
+}
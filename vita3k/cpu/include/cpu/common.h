@@ -106,6 +106,18 @@ struct CPUContext {
     }
 };
 
+// Registers a function call has to preserve (AAPCS), enough to switch between two points that are both in a call
+struct CalleeSavedContext {
+    // r4 to r11
+    std::array<uint32_t, 8> cpu_registers{};
+    uint32_t sp = 0;
+    // where the call returns to
+    uint32_t lr = 0;
+    // s16 to s31, d8 to d15
+    std::array<float, 16> fpu_registers{};
+    uint32_t fpscr = 0;
+};
+
 enum class CPUBackend {
     Dynarmic,
     Unicorn,
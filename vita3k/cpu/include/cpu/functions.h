@@ -47,6 +47,9 @@ void write_tpidruro(CPUState &state, uint32_t value);
 bool is_thumb_mode(CPUState &state);
 CPUContext save_context(CPUState &state);
 void load_context(CPUState &state, const CPUContext &ctx);
+// Only the registers kept across a call, for switching the thread between guest contexts from an import
+CalleeSavedContext save_callee_saved(CPUState &state);
+void load_callee_saved(CPUState &state, const CalleeSavedContext &ctx);
 std::size_t get_processor_id(CPUState &state);
 void invalidate_jit_cache(CPUState &state, Address start, size_t length);
 
@@ -81,6 +81,8 @@ public:
 
     CPUContext save_context() override;
     void load_context(const CPUContext &ctx) override;
+    CalleeSavedContext save_callee_saved() override;
+    void load_callee_saved(const CalleeSavedContext &ctx) override;
 
     bool is_thumb_mode() override;
     int step() override;
@@ -54,6 +54,8 @@ struct CPUInterface {
 
     virtual CPUContext save_context() = 0;
     virtual void load_context(const CPUContext &ctx) = 0;
+    virtual CalleeSavedContext save_callee_saved() = 0;
+    virtual void load_callee_saved(const CalleeSavedContext &ctx) = 0;
     virtual void invalidate_jit_cache(Address start, size_t length) = 0;
 
     virtual bool is_thumb_mode() = 0;
@@ -94,6 +94,8 @@ public:
 
     CPUContext save_context() override;
     void load_context(const CPUContext &ctx) override;
+    CalleeSavedContext save_callee_saved() override;
+    void load_callee_saved(const CalleeSavedContext &ctx) override;
     void invalidate_jit_cache(Address start, size_t length) override;
 
     bool hit_breakpoint() override;
@@ -206,6 +206,14 @@ void load_context(CPUState &state, const CPUContext &ctx) {
     state.cpu->load_context(ctx);
 }
 
+CalleeSavedContext save_callee_saved(CPUState &state) {
+    return state.cpu->save_callee_saved();
+}
+
+void load_callee_saved(CPUState &state, const CalleeSavedContext &ctx) {
+    state.cpu->load_callee_saved(ctx);
+}
+
 uint32_t stack_alloc(CPUState &state, size_t size) {
     const uint32_t new_sp = read_sp(state) - size;
     write_sp(state, new_sp);
@@ -27,6 +27,7 @@
 #include <dynarmic/interface/A32/coprocessor.h>
 #include <dynarmic/interface/exclusive_monitor.h>
 
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <string>
@@ -460,6 +461,27 @@ void DynarmicCPU::load_context(const CPUContext &ctx) {
     jit->SetFpscr(ctx.fpscr);
 }
 
+CalleeSavedContext DynarmicCPU::save_callee_saved() {
+    CalleeSavedContext ctx;
+    const auto &regs = jit->Regs();
+    std::copy_n(regs.begin() + 4, ctx.cpu_registers.size(), ctx.cpu_registers.begin());
+    ctx.sp = regs[13];
+    ctx.lr = regs[14];
+    memcpy(ctx.fpu_registers.data(), jit->ExtRegs().data() + 16, sizeof(ctx.fpu_registers));
+    ctx.fpscr = jit->Fpscr();
+
+    return ctx;
+}
+
+void DynarmicCPU::load_callee_saved(const CalleeSavedContext &ctx) {
+    auto &regs = jit->Regs();
+    std::copy(ctx.cpu_registers.begin(), ctx.cpu_registers.end(), regs.begin() + 4);
+    regs[13] = ctx.sp;
+    regs[14] = ctx.lr;
+    memcpy(jit->ExtRegs().data() + 16, ctx.fpu_registers.data(), sizeof(ctx.fpu_registers));
+    jit->SetFpscr(ctx.fpscr);
+}
+
 uint32_t DynarmicCPU::get_lr() {
     return jit->Regs()[14];
 }
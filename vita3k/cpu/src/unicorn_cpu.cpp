@@ -388,6 +388,35 @@ void UnicornCPU::load_context(const CPUContext &ctx) {
     set_pc(ctx.thumb() ? ctx.get_pc() | 1 : ctx.get_pc());
 }
 
+CalleeSavedContext UnicornCPU::save_callee_saved() {
+    CalleeSavedContext ctx;
+    for (size_t i = 0; i < ctx.cpu_registers.size(); i++) {
+        ctx.cpu_registers[i] = get_reg(i + 4);
+    }
+    ctx.sp = get_sp();
+    ctx.lr = get_lr();
+
+    for (size_t i = 0; i < ctx.fpu_registers.size(); i++) {
+        ctx.fpu_registers[i] = get_float_reg(i + 16);
+    }
+
+    // Unicorn doesn't like tweaking fpscr, see save_context
+
+    return ctx;
+}
+
+void UnicornCPU::load_callee_saved(const CalleeSavedContext &ctx) {
+    for (size_t i = 0; i < ctx.fpu_registers.size(); i++) {
+        set_float_reg(i + 16, ctx.fpu_registers[i]);
+    }
+
+    for (size_t i = 0; i < ctx.cpu_registers.size(); i++) {
+        set_reg(i + 4, ctx.cpu_registers[i]);
+    }
+    set_sp(ctx.sp);
+    set_lr(ctx.lr);
+}
+
 void UnicornCPU::invalidate_jit_cache(Address start, size_t length) {
     uc_ctl_remove_cache(uc.get(), start, start + length);
 }
@@ -0,0 +1,154 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Measures how old the input returned to the guest is, for a sampler thread writing to a HistoryRing:
+// - every 1 ms, like the ctrl sampler
+// - every 4 ms
+// - once per vblank, like the touch buffers
+// The guest reads the newest sample at random times, the age is the time since the sample was taken.
+// The cost of a read of one sample and of a full buffer of 64 is reported as well.
+
+#include <util/history_ring.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// same layout as CtrlSample
+struct Sample {
+    uint64_t timestamp;
+    uint32_t buttons;
+    uint32_t buttons_ext;
+    uint8_t lx;
+    uint8_t ly;
+    uint8_t rx;
+    uint8_t ry;
+};
+
+typedef HistoryRing<Sample, 128> History;
+
+constexpr auto VBLANK_PERIOD = std::chrono::microseconds(16667);
+
+struct Options {
+    uint32_t reads = 2000;
+};
+
+uint64_t to_us(clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+void sample(History &history, const std::atomic<bool> &stop, clock::duration period) {
+    const auto start = clock::now();
+    auto next_sample = start;
+    uint64_t last_vcount = UINT64_MAX;
+    while (!stop) {
+        const auto now = clock::now();
+        const uint64_t vcount = (now - start) / VBLANK_PERIOD;
+        const Sample sample = { to_us(now), static_cast<uint32_t>(vcount), static_cast<uint32_t>(vcount), 0x80, 0x80, 0x80, 0x80 };
+        if (vcount != last_vcount)
+            history.push(sample);
+        else
+            history.update_newest(sample);
+        last_vcount = vcount;
+
+        next_sample = std::max(next_sample + period, clock::now());
+        std::this_thread::sleep_until(next_sample);
+    }
+}
+
+template <typename Read>
+double time_reads(const History &history, Read read) {
+    constexpr uint32_t READS = 100000;
+    Sample out[History::MAX_READ];
+    uint64_t sum = 0;
+    const auto start = clock::now();
+    for (uint32_t i = 0; i < READS; i++)
+        sum += read(history, out);
+    const auto end = clock::now();
+
+    // keep the reads from being optimized away
+    if (sum == 0)
+        fmt::print("");
+    return std::chrono::duration<double, std::nano>(end - start).count() / READS;
+}
+
+void run_case(const Options &options, const char *name, clock::duration period) {
+    History history;
+    std::atomic<bool> stop = false;
+    std::thread sampler(sample, std::ref(history), std::cref(stop), period);
+    while (history.count() == 0)
+        std::this_thread::yield();
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> wait_us(100, 3000);
+    std::vector<double> ages;
+    ages.reserve(options.reads);
+    for (uint32_t i = 0; i < options.reads; i++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(wait_us(random)));
+        Sample newest;
+        history.read(&newest, 1);
+        ages.push_back(static_cast<double>(to_us(clock::now()) - newest.timestamp));
+    }
+
+    const double one_ns = time_reads(history, [](const History &history, Sample *out) { return history.read(out, 1); });
+    const double full_ns = time_reads(history, [](const History &history, Sample *out) { return history.read(out, History::MAX_READ); });
+    stop = true;
+    sampler.join();
+
+    std::sort(ages.begin(), ages.end());
+    double total = 0;
+    for (const double age : ages)
+        total += age;
+    fmt::print("{:<12} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n", name, total / ages.size(), ages[ages.size() * 99 / 100], ages.back(),
+        one_ns, full_ns);
+}
+
+void print_usage() {
+    fmt::print("Usage: ctrl-benchmark [--reads N]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--reads" && i + 1 < argc) {
+            options.reads = std::max(1, std::stoi(argv[++i]));
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    fmt::print("{} reads per case, age of the newest sample in us, ns per read\n", options.reads);
+    fmt::print("{:<12} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "sampler", "avg", "p99", "max", "read 1", "read 64");
+    run_case(options, "1 ms", std::chrono::milliseconds(1));
+    run_case(options, "4 ms", std::chrono::milliseconds(4));
+    run_case(options, "vblank", VBLANK_PERIOD);
+    return 0;
+}
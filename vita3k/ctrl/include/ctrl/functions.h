@@ -26,3 +26,6 @@ std::array<ControllerBinding, 15> get_controller_bindings_ext(EmuEnvState &emuen
 SceCtrlExternalInputMode get_type_of_controller(const int idx);
 int ctrl_get(const SceUID thread_id, EmuEnvState &emuenv, int port, SceCtrlData2 *pData, SceUInt32 count, bool negative, bool is_peek, bool is_v2, bool from_ext);
 void refresh_controllers(CtrlState &state, EmuEnvState &emuenv);
+// Sample the ports in the background so that the reads return a sample per vblank
+void start_ctrl_sampler(EmuEnvState &emuenv);
+void stop_ctrl_sampler(EmuEnvState &emuenv);
@@ -18,15 +18,18 @@
 #pragma once
 
 #include <ctrl/ctrl.h>
+#include <util/history_ring.h>
 
 #include <SDL_gamecontroller.h>
 #include <SDL_haptic.h>
 #include <SDL_joystick.h>
 
+#include <atomic>
 #include <cstring>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 struct _SDL_GameController;
 
@@ -55,6 +58,20 @@ struct SDL_JoystickGUIDComparator {
 
 typedef std::map<SDL_JoystickGUID, Controller, SDL_JoystickGUIDComparator> ControllerList;
 
+// State of a port read from the host, the input mode and the negative logic are applied when it is returned
+struct CtrlSample {
+    uint64_t timestamp; // usec
+    uint32_t buttons; // with the bindings of sceCtrl* functions
+    uint32_t buttons_ext; // with the bindings of sceCtrl*2 functions
+    uint8_t lx;
+    uint8_t ly;
+    uint8_t rx;
+    uint8_t ry;
+};
+
+// one sample per vblank, the newest one follows the host until the next vblank
+typedef HistoryRing<CtrlSample, 128> CtrlHistory;
+
 struct CtrlState {
     std::mutex mutex;
     ControllerList controllers;
@@ -66,4 +83,12 @@ struct CtrlState {
 
     // last vsync the data was read
     uint64_t last_vcount[5] = {}; // sceCtrl ports.
+
+    // written by the sampler thread with the mutex held, port 0 is read from port 1
+    CtrlHistory history[SCE_CTRL_MAX_WIRELESS_NUM + 1];
+    // vblank of the newest samples
+    uint64_t history_vcount = 0;
+    std::unique_ptr<std::thread> sampler_thread;
+    // when not set, the ports are sampled by the reads themselves
+    std::atomic<bool> sampling{ false };
 };
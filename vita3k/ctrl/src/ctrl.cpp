@@ -25,8 +25,15 @@
 #include <display/state.h>
 #include <kernel/state.h>
 
+#include <SDL_joystick.h>
 #include <SDL_keyboard.h>
 
+#include <algorithm>
+#include <chrono>
+
+// the newest sample of a port is at most this old, the SDL state it reads is updated when the UI thread pumps the events
+static constexpr auto CTRL_SAMPLE_PERIOD = std::chrono::milliseconds(1);
+
 static int reserve_port(CtrlState &state) {
     for (int i = 0; i < SCE_CTRL_MAX_WIRELESS_NUM; i++) {
         if (state.free_ports[i]) {
@@ -266,52 +273,89 @@ static void apply_controller(EmuEnvState &emuenv, uint32_t *buttons, float axes[
     axes[3] += axis_to_axis(SDL_GameControllerGetAxis(controller, SDL_CONTROLLER_AXIS_RIGHTY));
 }
 
-static void retrieve_ctrl_data(EmuEnvState &emuenv, int port, bool is_v2, bool negative, bool from_ext_function, SceUInt32 &buttons, SceUInt8 &lx, SceUInt8 &ly, SceUInt8 &rx, SceUInt8 &ry) {
-    std::lock_guard<std::mutex> guard(emuenv.ctrl.mutex);
-
-    if (port == 0) {
-        port++;
-    }
-    CtrlState &state = emuenv.ctrl;
-    refresh_controllers(state, emuenv);
+static CtrlSample sample_port(EmuEnvState &emuenv, int port, uint64_t timestamp) {
+    CtrlSample sample{};
+    sample.timestamp = timestamp;
 
     std::array<float, 4> axes;
     axes.fill(0);
-
-    const auto reset_axes = [&]() {
-        // Re-center joysticks to (128,128). Range is (0-255,0-255).
-        SceCtrlPadInputMode mode = from_ext_function ? state.input_mode_ext : state.input_mode;
-        if (mode == SCE_CTRL_MODE_DIGITAL) {
-            lx = 0x80;
-            ly = 0x80;
-            rx = 0x80;
-            ry = 0x80;
-        } else {
-            lx = float_to_byte(axes[0]);
-            ly = float_to_byte(axes[1]);
-            rx = float_to_byte(axes[2]);
-            ry = float_to_byte(axes[3]);
+    if ((emuenv.common_dialog.status != SCE_COMMON_DIALOG_STATUS_RUNNING) && !emuenv.drop_inputs) {
+        // both bindings are sampled, the axes only once
+        std::array<float, 4> axes_ext;
+        axes_ext.fill(0);
+        if (port == 1) {
+            apply_keyboard(&sample.buttons, axes.data(), false, emuenv);
+            apply_keyboard(&sample.buttons_ext, axes_ext.data(), true, emuenv);
+        }
+        for (const auto &[_, controller] : emuenv.ctrl.controllers) {
+            if (controller.port + 1 == port) {
+                // sceCtrl ports are 1-based and SDL_GameController index is 0-based. Need to convert.
+                apply_controller(emuenv, &sample.buttons, axes.data(), controller.controller.get(), false);
+                apply_controller(emuenv, &sample.buttons_ext, axes_ext.data(), controller.controller.get(), true);
+            }
         }
-        if (negative)
-            buttons ^= ~0;
-    };
-
-    if ((emuenv.common_dialog.status == SCE_COMMON_DIALOG_STATUS_RUNNING) || emuenv.drop_inputs) {
-        reset_axes();
-        return;
     }
 
-    if (port == 1) {
-        apply_keyboard(&buttons, axes.data(), is_v2, emuenv);
+    sample.lx = float_to_byte(axes[0]);
+    sample.ly = float_to_byte(axes[1]);
+    sample.rx = float_to_byte(axes[2]);
+    sample.ry = float_to_byte(axes[3]);
+    return sample;
+}
+
+// Must be called with the ctrl mutex held, this is the only writer of the histories.
+// The controllers are opened, closed and updated by the UI thread, only their state is read here
+static void sample_ports(EmuEnvState &emuenv) {
+    CtrlState &state = emuenv.ctrl;
+
+    const uint64_t vcount = emuenv.display.vblank_count.load();
+    const bool new_vblank = (vcount != state.history_vcount) || (state.history[1].count() == 0);
+    state.history_vcount = vcount;
+
+    const auto ts = std::chrono::steady_clock::now();
+    const uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(ts.time_since_epoch()).count();
+    const int port_count = emuenv.cfg.current_config.pstv_mode ? SCE_CTRL_MAX_WIRELESS_NUM : 1;
+    std::array<CtrlSample, SCE_CTRL_MAX_WIRELESS_NUM + 1> samples;
+    // the controllers are read outside of the thread pumping the events
+    SDL_LockJoysticks();
+    for (int port = 1; port <= port_count; port++)
+        samples[port] = sample_port(emuenv, port, timestamp);
+    SDL_UnlockJoysticks();
+
+    for (int port = 1; port <= port_count; port++) {
+        if (new_vblank)
+            state.history[port].push(samples[port]);
+        else
+            state.history[port].update_newest(samples[port]);
     }
-    for (const auto &[_, controller] : state.controllers) {
-        if (controller.port + 1 == port) {
-            // sceCtrl ports are 1-based and SDL_GameController index is 0-based. Need to convert.
-            apply_controller(emuenv, &buttons, axes.data(), controller.controller.get(), is_v2);
+}
+
+static void sampler_thread(EmuEnvState &emuenv) {
+    CtrlState &state = emuenv.ctrl;
+
+    auto next_sample = std::chrono::steady_clock::now();
+    while (state.sampling.load()) {
+        {
+            const std::lock_guard<std::mutex> guard(state.mutex);
+            sample_ports(emuenv);
         }
+
+        next_sample = std::max(next_sample + CTRL_SAMPLE_PERIOD, std::chrono::steady_clock::now());
+        std::this_thread::sleep_until(next_sample);
     }
+}
+
+void start_ctrl_sampler(EmuEnvState &emuenv) {
+    emuenv.ctrl.sampling = true;
+    emuenv.ctrl.sampler_thread = std::make_unique<std::thread>(sampler_thread, std::ref(emuenv));
+}
 
-    reset_axes();
+void stop_ctrl_sampler(EmuEnvState &emuenv) {
+    emuenv.ctrl.sampling = false;
+    if (emuenv.ctrl.sampler_thread) {
+        emuenv.ctrl.sampler_thread->join();
+        emuenv.ctrl.sampler_thread.reset();
+    }
 }
 
 int ctrl_get(const SceUID thread_id, EmuEnvState &emuenv, int port, SceCtrlData2 *pData, SceUInt32 count, bool negative, bool is_peek, bool is_v2, bool from_ext) {
@@ -323,8 +367,13 @@ int ctrl_get(const SceUID thread_id, EmuEnvState &emuenv, int port, SceCtrlData2
     memset(pData, 0, sizeof(SceCtrlData2) * count);
 
     CtrlState &state = emuenv.ctrl;
+    const CtrlHistory &history = state.history[std::max(port, 1)];
+    if (!state.sampling.load()) {
+        const std::lock_guard<std::mutex> guard(state.mutex);
+        sample_ports(emuenv);
+    }
 
-    int nb_returned_data = 1;
+    uint32_t nb_returned_data = 1;
     if (is_peek) {
         nb_returned_data = count;
     } else {
@@ -335,20 +384,34 @@ int ctrl_get(const SceUID thread_id, EmuEnvState &emuenv, int port, SceCtrlData2
             wait_vblank(emuenv.display, emuenv.kernel, thread, state.last_vcount[port] + 1, false);
         }
         uint64_t vblank_count = emuenv.display.vblank_count.load();
-        nb_returned_data = std::min<int32_t>(count, vblank_count - state.last_vcount[port]);
+        nb_returned_data = std::min<uint64_t>(count, vblank_count - state.last_vcount[port]);
         state.last_vcount[port] = vblank_count;
     }
 
-    std::chrono::time_point<std::chrono::steady_clock> ts = std::chrono::steady_clock::now();
-    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(ts.time_since_epoch()).count();
-    pData->timeStamp = timestamp;
-    retrieve_ctrl_data(emuenv, port, is_v2, negative, from_ext, pData->buttons, pData->lx, pData->ly, pData->rx, pData->ry);
+    // one sample per vblank, the oldest first
+    std::array<CtrlSample, CtrlHistory::MAX_READ> samples;
+    nb_returned_data = history.read(samples.data(), std::min<uint32_t>(nb_returned_data, samples.size()));
 
-    for (int i = 1; i < nb_returned_data; i++) {
-        memcpy(&pData[i], &pData[0], sizeof(SceCtrlData2));
+    const SceCtrlPadInputMode mode = from_ext ? state.input_mode_ext : state.input_mode;
+    for (uint32_t i = 0; i < nb_returned_data; i++) {
+        const CtrlSample &sample = samples[i];
+        pData[i].timeStamp = sample.timestamp;
+        pData[i].buttons = is_v2 ? sample.buttons_ext : sample.buttons;
+        if (negative)
+            pData[i].buttons ^= ~0;
 
-        // update the timestamp, 1 vsync = 1/60 sec = 16 667 us earlier
-        pData[i].timeStamp -= i * 16667ULL;
+        // Re-center joysticks to (128,128). Range is (0-255,0-255).
+        if (mode == SCE_CTRL_MODE_DIGITAL) {
+            pData[i].lx = 0x80;
+            pData[i].ly = 0x80;
+            pData[i].rx = 0x80;
+            pData[i].ry = 0x80;
+        } else {
+            pData[i].lx = sample.lx;
+            pData[i].ly = sample.ly;
+            pData[i].rx = sample.rx;
+            pData[i].ry = sample.ry;
+        }
     }
 
     return nb_returned_data;
@@ -26,7 +26,9 @@ struct KernelState;
 struct EmuEnvState;
 struct DisplayFrameInfo;
 
-void start_sync_thread(EmuEnvState &emuenv);
+// Fire the vblank at 60 Hz on the kernel timer service
+void start_vblank_timer(EmuEnvState &emuenv);
+void stop_vblank_timer(EmuEnvState &emuenv);
 void wait_vblank(DisplayState &display, KernelState &kernel, const ThreadStatePtr &wait_thread, const uint64_t target_vcount, const bool is_cb);
 // if the result is not nullptr, contain the predicted frame (pointer needs to be freed later)
 DisplayFrameInfo *predict_next_image(EmuEnvState &emuenv, Address sync_object);
@@ -24,7 +24,7 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
-#include <thread>
+#include <queue>
 #include <vector>
 
 enum SceDisplayPixelFormat {
@@ -37,6 +37,10 @@ typedef std::shared_ptr<ThreadState> ThreadStatePtr;
 struct DisplayStateVBlankWaitInfo {
     ThreadStatePtr target_thread;
     uint64_t target_vcount;
+
+    bool operator>(const DisplayStateVBlankWaitInfo &other) const {
+        return target_vcount > other.target_vcount;
+    }
 };
 
 struct DisplayFrameInfo {
@@ -60,12 +64,14 @@ struct DisplayState {
     DisplayFrameInfo next_rendered_frame;
 
     std::mutex mutex;
-    std::unique_ptr<std::thread> vblank_thread;
+    // id of the periodic timer in the kernel timer service, 0 when not started
+    uint64_t vblank_timer = 0;
     std::atomic<bool> abort{ false };
     std::atomic<bool> imgui_render{ true };
     std::atomic<bool> fullscreen{ false };
     std::atomic<std::uint64_t> vblank_count{ 0 };
-    std::vector<DisplayStateVBlankWaitInfo> vblank_wait_infos;
+    // earliest target vcount first
+    std::priority_queue<DisplayStateVBlankWaitInfo, std::vector<DisplayStateVBlankWaitInfo>, std::greater<>> vblank_wait_infos;
     std::atomic<uint64_t> last_setframe_vblank_count = 0;
     std::map<SceUID, CallbackPtr> vblank_callbacks{};
 
@@ -35,54 +35,54 @@ static constexpr int64_t TARGET_MICRO_PER_FRAME = 1000000LL / TARGET_FPS;
 static constexpr int predict_threshold = 3;
 static constexpr int max_expected_swapchain_size = 6;
 
-static void vblank_sync_thread(EmuEnvState &emuenv) {
+static void vblank_sync(EmuEnvState &emuenv) {
     DisplayState &display = emuenv.display;
+    if (display.abort.load())
+        return;
 
-    while (!display.abort.load()) {
-        {
-            const std::lock_guard<std::mutex> guard(display.mutex);
+    const std::lock_guard<std::mutex> guard(display.mutex);
 
-            {
-                const std::lock_guard<std::mutex> guard_info(display.display_info_mutex);
-                ++display.vblank_count;
-
-                // in this case, even though no new game frames are being rendered, we still need to update the screen
-                if (emuenv.kernel.is_threads_paused() || (emuenv.common_dialog.status == SCE_COMMON_DIALOG_STATUS_RUNNING))
-                    // only display the UI/common dialog at 30 fps
-                    // this is necessary so that the command buffer processing doesn't get starved
-                    // with vsync enabled and a screen with a refresh rate of 60Hz or less
-                    if (display.vblank_count % 2 == 0)
-                        emuenv.renderer->should_display = true;
-            }
-
-            // maybe we should also use a mutex for this part, but it shouldn't be an issue
-            touch_vsync_update(emuenv);
-            refresh_motion(emuenv.motion, emuenv.ctrl);
+    {
+        const std::lock_guard<std::mutex> guard_info(display.display_info_mutex);
+        ++display.vblank_count;
+
+        // in this case, even though no new game frames are being rendered, we still need to update the screen
+        if (emuenv.kernel.is_threads_paused() || (emuenv.common_dialog.status == SCE_COMMON_DIALOG_STATUS_RUNNING))
+            // only display the UI/common dialog at 30 fps
+            // this is necessary so that the command buffer processing doesn't get starved
+            // with vsync enabled and a screen with a refresh rate of 60Hz or less
+            if (display.vblank_count % 2 == 0)
+                emuenv.renderer->should_display = true;
+    }
 
-            // Notify Vblank callback in each VBLANK start
-            for (auto &[_, cb] : display.vblank_callbacks)
-                cb->event_notify(cb->get_notifier_id());
+    // maybe we should also use a mutex for this part, but it shouldn't be an issue
+    touch_vsync_update(emuenv);
+    refresh_motion(emuenv.motion, emuenv.ctrl);
 
-            for (std::size_t i = 0; i < display.vblank_wait_infos.size();) {
-                auto &vblank_wait_info = display.vblank_wait_infos[i];
-                if (vblank_wait_info.target_vcount <= display.vblank_count) {
-                    ThreadStatePtr target_wait = vblank_wait_info.target_thread;
+    // Notify Vblank callback in each VBLANK start
+    for (auto &[_, cb] : display.vblank_callbacks)
+        cb->event_notify(cb->get_notifier_id());
 
-                    target_wait->update_status(ThreadStatus::run);
-                    display.vblank_wait_infos.erase(display.vblank_wait_infos.begin() + i);
-                } else {
-                    i++;
-                }
-            }
-        }
-        const auto time_ms = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-        const auto time_left = TARGET_MICRO_PER_FRAME - (time_ms % TARGET_MICRO_PER_FRAME);
-        std::this_thread::sleep_for(std::chrono::microseconds(time_left));
+    // only wake up the threads whose target is reached
+    while (!display.vblank_wait_infos.empty() && display.vblank_wait_infos.top().target_vcount <= display.vblank_count) {
+        display.vblank_wait_infos.top().target_thread->update_status(ThreadStatus::run);
+        display.vblank_wait_infos.pop();
     }
 }
 
-void start_sync_thread(EmuEnvState &emuenv) {
-    emuenv.display.vblank_thread = std::make_unique<std::thread>(vblank_sync_thread, std::ref(emuenv));
+void start_vblank_timer(EmuEnvState &emuenv) {
+    const auto period = std::chrono::microseconds(TARGET_MICRO_PER_FRAME);
+    // the deadlines are absolute, the time spent in a vblank does not delay the next ones
+    emuenv.display.vblank_timer = emuenv.kernel.timer_service.add(
+        TimerService::Clock::now() + period, [&emuenv](TimerService::Clock::time_point) { vblank_sync(emuenv); }, period);
+}
+
+void stop_vblank_timer(EmuEnvState &emuenv) {
+    emuenv.display.abort = true;
+    if (emuenv.display.vblank_timer != 0) {
+        emuenv.kernel.timer_service.cancel(emuenv.display.vblank_timer);
+        emuenv.display.vblank_timer = 0;
+    }
 }
 
 void wait_vblank(DisplayState &display, KernelState &kernel, const ThreadStatePtr &wait_thread, const uint64_t target_vcount, const bool is_cb) {
@@ -100,7 +100,7 @@ void wait_vblank(DisplayState &display, KernelState &kernel, const ThreadStatePt
                 return;
 
             wait_thread->update_status(ThreadStatus::wait);
-            display.vblank_wait_infos.push_back({ wait_thread, target_vcount });
+            display.vblank_wait_infos.push({ wait_thread, target_vcount });
         }
 
         wait_thread->status_cond.wait(thread_lock, [=]() { return wait_thread->status == ThreadStatus::run; });
@@ -0,0 +1,168 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Measures the throughput of bulk copies and fills of guest memory done
+// - by the guest: a word loop run by the JIT, like a game's own memcpy
+// - by the host libc on the guest memory, like the HLE memcpy and memset
+// - by the DMAC, streaming and split with the copy thread from dmac::OFFLOAD_THRESHOLD
+// for a range of sizes.
+
+#include <dmac/functions.h>
+#include <dmac/state.h>
+
+#include <cpu/benchmark_harness.h>
+#include <cpu/common.h>
+#include <cpu/functions.h>
+#include <cpu/state.h>
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+using cpu_benchmark::BenchmarkProtocol;
+using cpu_benchmark::call;
+using cpu_benchmark::guest_memcpy_code;
+using cpu_benchmark::guest_memset_code;
+using cpu_benchmark::write_code;
+
+constexpr uint32_t BUFFER_SIZE = MiB(16);
+
+struct Options {
+    double seconds = 0.5;
+    bool use_page_table = false;
+};
+
+// Throughput in GiB/s, negative if a transfer failed
+double measure(const Options &options, uint32_t size, const std::function<bool()> &transfer) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const auto deadline = start + std::chrono::duration<double>(options.seconds);
+    uint64_t bytes = 0;
+    auto now = start;
+    while (now < deadline) {
+        if (!transfer())
+            return -1.0;
+        bytes += size;
+        now = clock::now();
+    }
+
+    return bytes / std::chrono::duration<double>(now - start).count() / GiB(1);
+}
+
+void print_usage() {
+    fmt::print("Usage: dmac-benchmark [--seconds S] [--page-table]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::stod(argv[++i]);
+        } else if (arg == "--page-table") {
+            options.use_page_table = true;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    MemState mem;
+    if (!init(mem, options.use_page_table)) {
+        fmt::print("Failed to initialize the memory\n");
+        return 1;
+    }
+
+    BenchmarkProtocol protocol;
+    protocol.monitor = new_exclusive_monitor(1);
+    CPUStatePtr cpu = init_cpu(CPUBackend::Dynarmic, true, 0, 0, mem, &protocol);
+    if (!cpu) {
+        fmt::print("Failed to initialize the CPU\n");
+        return 1;
+    }
+
+    const Address guest_memcpy = write_code(mem, guest_memcpy_code);
+    const Address guest_memset = write_code(mem, guest_memset_code);
+    const Address source = alloc(mem, BUFFER_SIZE, "benchmark source");
+    const Address destination = alloc(mem, BUFFER_SIZE, "benchmark destination");
+    if (!source || !destination) {
+        fmt::print("Failed to allocate the buffers\n");
+        return 1;
+    }
+    uint8_t *const host_source = Ptr<uint8_t>(source).get(mem);
+    uint8_t *const host_destination = Ptr<uint8_t>(destination).get(mem);
+    for (uint32_t i = 0; i < BUFFER_SIZE; i++)
+        host_source[i] = static_cast<uint8_t>(i * 7 + 1);
+
+    dmac::State dmac;
+
+    // the DMAC must give the same bytes as the guest, the split point included
+    for (const uint32_t size : { 3u, dmac::STREAM_THRESHOLD + 1, dmac::OFFLOAD_THRESHOLD + 1, BUFFER_SIZE - 1 }) {
+        std::memset(host_destination, 0, BUFFER_SIZE);
+        if (!dmac::copy(dmac, mem, destination + 1, source, size - 1) || std::memcmp(host_destination + 1, host_source, size - 1) != 0) {
+            fmt::print("DMAC copy of {} bytes is wrong\n", size - 1);
+            return 1;
+        }
+        if (!dmac::fill(dmac, mem, destination + 1, 0x5A, size - 1)
+            || std::any_of(host_destination + 1, host_destination + size, [](uint8_t value) { return value != 0x5A; })) {
+            fmt::print("DMAC fill of {} bytes is wrong\n", size - 1);
+            return 1;
+        }
+    }
+
+    fmt::print("{} memory, streaming from {} KiB, split from {} KiB, GiB/s\n", options.use_page_table ? "page table" : "fastmem",
+        dmac::STREAM_THRESHOLD / KiB(1), dmac::OFFLOAD_THRESHOLD / KiB(1));
+    fmt::print("{:<8} {:>10} {:>10} {:>10} {:>10}\n", "routine", "KiB", "guest", "host", "dmac");
+    const uint32_t sizes[] = { KiB(4), KiB(64), KiB(256), MiB(1), MiB(4), BUFFER_SIZE };
+    for (const uint32_t size : sizes) {
+        const double guest_copy = measure(options, size, [&] { return call(*cpu, guest_memcpy, destination, source, size); });
+        const double host_copy = measure(options, size, [&] {
+            std::memcpy(host_destination, host_source, size);
+            return true;
+        });
+        const double dmac_copy = measure(options, size, [&] { return dmac::copy(dmac, mem, destination, source, size); });
+        const double guest_fill = measure(options, size, [&] { return call(*cpu, guest_memset, destination, 0x5A, size); });
+        const double host_fill = measure(options, size, [&] {
+            std::memset(host_destination, 0x5A, size);
+            return true;
+        });
+        const double dmac_fill = measure(options, size, [&] { return dmac::fill(dmac, mem, destination, 0x5A, size); });
+        if (guest_copy < 0 || guest_fill < 0 || dmac_copy < 0 || dmac_fill < 0) {
+            fmt::print("A transfer of {} bytes failed\n", size);
+            return 1;
+        }
+
+        fmt::print("{:<8} {:>10} {:>10.2f} {:>10.2f} {:>10.2f}\n", "memcpy", size / KiB(1), guest_copy, host_copy, dmac_copy);
+        fmt::print("{:<8} {:>10} {:>10.2f} {:>10.2f} {:>10.2f}\n", "memset", size / KiB(1), guest_fill, host_fill, dmac_fill);
+    }
+
+    cpu.reset();
+    free_exclusive_monitor(protocol.monitor);
+    return 0;
+}
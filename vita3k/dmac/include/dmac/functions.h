@@ -0,0 +1,48 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h>
+
+#include <cstddef>
+#include <cstdint>
+
+struct MemState;
+
+namespace dmac {
+
+struct State;
+
+// From this size the stores bypass the cache, below it the libc copy is faster
+constexpr uint32_t STREAM_THRESHOLD = MiB(2);
+// From this size half of the transfer is done by the copy thread, when the state allows it
+constexpr uint32_t OFFLOAD_THRESHOLD = MiB(4);
+
+// Copy or fill guest memory as the DMAC does, the write protection callbacks of the ranges are run first.
+// Return false without touching memory if a range is not mapped.
+bool copy(State &state, MemState &mem, Address dst, Address src, uint32_t size);
+bool fill(State &state, MemState &mem, Address dst, uint8_t value, uint32_t size);
+
+// Host copy and fill using non-temporal stores, the ranges must not overlap
+void stream_copy(uint8_t *dst, const uint8_t *src, size_t size);
+void stream_fill(uint8_t *dst, uint8_t value, size_t size);
+
+// Stop the copy thread, it is started again by the next transfer needing it
+void stop(State &state);
+
+} // namespace dmac
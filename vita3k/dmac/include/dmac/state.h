@@ -0,0 +1,58 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace dmac {
+
+// Part of a transfer handed to the copy thread, src is null for a fill
+struct Transfer {
+    uint8_t *dst = nullptr;
+    const uint8_t *src = nullptr;
+    uint8_t value = 0;
+    size_t size = 0;
+};
+
+// The copy thread takes the transfers in the order they were submitted, so a caller waiting
+// for its ticket knows every transfer submitted before its own is also done
+struct State {
+    State() = default;
+    State(const State &) = delete;
+    State &operator=(const State &) = delete;
+    ~State();
+
+    // a single core is better used by the emulated threads
+    bool offload = std::thread::hardware_concurrency() > 2;
+
+    std::thread copy_thread;
+    std::mutex mutex;
+    std::condition_variable submitted_cond;
+    std::condition_variable completed_cond;
+    std::deque<Transfer> queue;
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    bool quit = false;
+};
+
+} // namespace dmac
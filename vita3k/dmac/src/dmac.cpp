@@ -0,0 +1,169 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <dmac/functions.h>
+#include <dmac/state.h>
+
+#include <mem/functions.h>
+#include <mem/libc.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+#include <util/align.h>
+
+#include <cstring>
+
+namespace dmac {
+
+namespace {
+
+bool is_valid_range(const MemState &mem, Address address, uint32_t size) {
+    const uint64_t end = static_cast<uint64_t>(address) + size;
+    return address != 0 && end <= UINT32_MAX && is_valid_addr_range(mem, address, static_cast<Address>(end));
+}
+
+bool overlap(Address lhs, Address rhs, uint32_t size) {
+    return (lhs < rhs) ? (rhs - lhs < size) : (lhs - rhs < size);
+}
+
+void run(const Transfer &transfer) {
+    if (transfer.src)
+        stream_copy(transfer.dst, transfer.src, transfer.size);
+    else
+        stream_fill(transfer.dst, transfer.value, transfer.size);
+}
+
+void copy_thread_main(State &state) {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (true) {
+        state.submitted_cond.wait(lock, [&] { return state.quit || !state.queue.empty(); });
+        // a caller may still be waiting for the transfers left, so only quit once they are done
+        if (state.queue.empty())
+            return;
+
+        const Transfer transfer = state.queue.front();
+        state.queue.pop_front();
+        lock.unlock();
+
+        run(transfer);
+
+        lock.lock();
+        state.completed++;
+        state.completed_cond.notify_all();
+    }
+}
+
+uint64_t submit(State &state, const Transfer &transfer) {
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.copy_thread.joinable()) {
+        state.quit = false;
+        state.copy_thread = std::thread(copy_thread_main, std::ref(state));
+    }
+
+    state.queue.push_back(transfer);
+    state.submitted_cond.notify_one();
+    return ++state.submitted;
+}
+
+void wait(State &state, uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.completed_cond.wait(lock, [&] { return state.completed >= ticket; });
+}
+
+// Transfer between non-overlapping host ranges, returns once it is done
+void transfer(State &state, const Transfer &transfer) {
+    if (transfer.size < STREAM_THRESHOLD) {
+        // small enough to be read back from the cache soon
+        if (transfer.src)
+            std::memcpy(transfer.dst, transfer.src, transfer.size);
+        else
+            std::memset(transfer.dst, transfer.value, transfer.size);
+        return;
+    }
+
+    if (!state.offload || transfer.size < OFFLOAD_THRESHOLD) {
+        run(transfer);
+        return;
+    }
+
+    // the copy thread takes the second half while the calling thread does the first one
+    const size_t half = align(transfer.size / 2, 64);
+    Transfer back = transfer;
+    back.dst += half;
+    if (back.src)
+        back.src += half;
+    back.size -= half;
+    const uint64_t ticket = submit(state, back);
+
+    Transfer front = transfer;
+    front.size = half;
+    run(front);
+
+    wait(state, ticket);
+}
+
+} // namespace
+
+State::~State() {
+    stop(*this);
+}
+
+bool copy(State &state, MemState &mem, Address dst, Address src, uint32_t size) {
+    if (size == 0)
+        return true;
+    if (!is_valid_range(mem, dst, size) || !is_valid_range(mem, src, size))
+        return false;
+
+    // let the caches built on top of guest memory (textures, surfaces) see the access before it happens,
+    // instead of taking a fault on every protected page
+    handle_host_access(mem, src, size, false);
+    handle_host_access(mem, dst, size, true);
+
+    // the host memory is only contiguous in fastmem, the page table path copies page by page
+    if (mem.use_page_table || overlap(dst, src, size))
+        return guest_memmove(mem, dst, src, size);
+
+    transfer(state, { Ptr<uint8_t>(dst).get(mem), Ptr<const uint8_t>(src).get(mem), 0, size });
+    return true;
+}
+
+bool fill(State &state, MemState &mem, Address dst, uint8_t value, uint32_t size) {
+    if (size == 0)
+        return true;
+    if (!is_valid_range(mem, dst, size))
+        return false;
+
+    handle_host_access(mem, dst, size, true);
+
+    if (mem.use_page_table)
+        return guest_memset(mem, dst, value, size);
+
+    transfer(state, { Ptr<uint8_t>(dst).get(mem), nullptr, value, size });
+    return true;
+}
+
+void stop(State &state) {
+    {
+        const std::lock_guard<std::mutex> lock(state.mutex);
+        state.quit = true;
+    }
+    state.submitted_cond.notify_all();
+
+    if (state.copy_thread.joinable())
+        state.copy_thread.join();
+}
+
+} // namespace dmac
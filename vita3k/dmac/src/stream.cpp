@@ -0,0 +1,88 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <dmac/functions.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#else
+#include <emmintrin.h>
+#endif
+
+namespace dmac {
+
+#if !defined(__aarch64__)
+// Bytes to store before dst is aligned for the streaming stores
+static size_t head_size(const uint8_t *dst, size_t size) {
+    return std::min<size_t>(size, (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15);
+}
+#endif
+
+void stream_copy(uint8_t *dst, const uint8_t *src, size_t size) {
+#if defined(__aarch64__)
+    // there is no intrinsic for the non-temporal pair stores, the libc copy uses the widest stores already
+    std::memcpy(dst, src, size);
+#else
+    const size_t head = head_size(dst, size);
+    std::memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+
+    for (; size >= 64; size -= 64, dst += 64, src += 64) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst), a);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 48), d);
+    }
+
+    // the streaming stores are weakly ordered, they must be visible before the transfer is reported done
+    _mm_sfence();
+    std::memcpy(dst, src, size);
+#endif
+}
+
+void stream_fill(uint8_t *dst, uint8_t value, size_t size) {
+#if defined(__aarch64__)
+    std::memset(dst, value, size);
+#else
+    const size_t head = head_size(dst, size);
+    std::memset(dst, value, head);
+    dst += head;
+    size -= head;
+
+    const __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+    for (; size >= 64; size -= 64, dst += 64) {
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst), pattern);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 16), pattern);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 32), pattern);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 48), pattern);
+    }
+
+    _mm_sfence();
+    std::memset(dst, value, size);
+#endif
+}
+
+} // namespace dmac
@@ -0,0 +1,150 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <dmac/functions.h>
+#include <dmac/state.h>
+
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t BUFFER_SIZE = MiB(8);
+
+// Run with and without a page table
+class dmac_transfer : public testing::TestWithParam<bool> {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(init(mem, GetParam()));
+        // whatever the host, so that the copy thread is tested
+        dmac.offload = true;
+        src = alloc(mem, BUFFER_SIZE, "dmac source");
+        dst = alloc(mem, BUFFER_SIZE, "dmac destination");
+        ASSERT_NE(src, 0u);
+        ASSERT_NE(dst, 0u);
+        for (uint32_t i = 0; i < BUFFER_SIZE; i++)
+            *host(src + i) = static_cast<uint8_t>(i * 13 + 7);
+    }
+
+    uint8_t *host(Address address) {
+        return Ptr<uint8_t>(address).get(mem);
+    }
+
+    MemState mem;
+    dmac::State dmac;
+    Address src = 0;
+    Address dst = 0;
+};
+
+TEST_P(dmac_transfer, copy_sizes) {
+    // below the streaming threshold, streamed, and split with the copy thread
+    for (const uint32_t size : { 1u, 100u, dmac::STREAM_THRESHOLD + 3, dmac::OFFLOAD_THRESHOLD + 77, BUFFER_SIZE - 5 }) {
+        std::memset(host(dst), 0, BUFFER_SIZE);
+        ASSERT_TRUE(dmac::copy(dmac, mem, dst + 1, src + 3, size));
+        EXPECT_EQ(*host(dst), 0);
+        EXPECT_EQ(std::memcmp(host(dst + 1), host(src + 3), size), 0) << size;
+        EXPECT_EQ(*host(dst + 1 + size), 0) << size;
+    }
+}
+
+TEST_P(dmac_transfer, fill_sizes) {
+    for (const uint32_t size : { 1u, 100u, dmac::STREAM_THRESHOLD + 3, dmac::OFFLOAD_THRESHOLD + 77, BUFFER_SIZE - 2 }) {
+        std::memset(host(dst), 0, BUFFER_SIZE);
+        ASSERT_TRUE(dmac::fill(dmac, mem, dst + 1, 0xC3, size));
+        EXPECT_EQ(*host(dst), 0);
+        EXPECT_TRUE(std::all_of(host(dst + 1), host(dst + 1 + size), [](uint8_t value) { return value == 0xC3; })) << size;
+        EXPECT_EQ(*host(dst + 1 + size), 0) << size;
+    }
+}
+
+TEST_P(dmac_transfer, overlapping_copy) {
+    const uint32_t size = dmac::OFFLOAD_THRESHOLD;
+    const std::vector<uint8_t> expected(host(src), host(src + size));
+    ASSERT_TRUE(dmac::copy(dmac, mem, src + 1000, src, size));
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), host(src + 1000)));
+}
+
+TEST_P(dmac_transfer, concurrent_callers) {
+    // every caller must get its own transfer done when it returns, whatever the others submitted
+    const uint32_t size = dmac::OFFLOAD_THRESHOLD;
+    const uint32_t count = BUFFER_SIZE / size;
+    std::vector<std::thread> threads;
+    std::vector<int> results(count);
+    for (uint32_t i = 0; i < count; i++) {
+        threads.emplace_back([&, i] {
+            const Address target = dst + i * size;
+            results[i] = dmac::fill(dmac, mem, target, static_cast<uint8_t>(i + 1), size)
+                && std::all_of(host(target), host(target + size), [&](uint8_t value) { return value == i + 1; });
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    EXPECT_EQ(results, std::vector<int>(count, 1));
+}
+
+TEST_P(dmac_transfer, runs_protection_callbacks) {
+    Address written = 0;
+    bool write = false;
+    ASSERT_TRUE(add_protect(mem, dst + KiB(8), KiB(4), MemPerm::ReadOnly, [&](Address address, bool is_write) {
+        written = address;
+        write = is_write;
+        return true;
+    }));
+    ASSERT_TRUE(is_protecting(mem, dst + KiB(8)));
+
+    ASSERT_TRUE(dmac::copy(dmac, mem, dst, src, KiB(16)));
+    EXPECT_EQ(written, dst + KiB(8));
+    EXPECT_TRUE(write);
+    EXPECT_FALSE(is_protecting(mem, dst + KiB(8)));
+    EXPECT_EQ(std::memcmp(host(dst), host(src), KiB(16)), 0);
+}
+
+TEST_P(dmac_transfer, reads_skip_write_protection) {
+    bool called = false;
+    ASSERT_TRUE(add_protect(mem, src, KiB(4), MemPerm::ReadOnly, [&](Address, bool) {
+        called = true;
+        return true;
+    }));
+
+    ASSERT_TRUE(dmac::copy(dmac, mem, dst, src, KiB(4)));
+    EXPECT_FALSE(called);
+    EXPECT_TRUE(is_protecting(mem, src));
+}
+
+TEST_P(dmac_transfer, rejects_invalid_ranges) {
+    *host(dst) = 0x55;
+    EXPECT_FALSE(dmac::copy(dmac, mem, dst, 0, 16));
+    EXPECT_FALSE(dmac::copy(dmac, mem, dst, src, BUFFER_SIZE * 4));
+    EXPECT_FALSE(dmac::fill(dmac, mem, 0xFFFFFFF0, 0, 32));
+    EXPECT_TRUE(dmac::copy(dmac, mem, dst, 0, 0));
+    EXPECT_EQ(*host(dst), 0x55);
+}
+
+INSTANTIATE_TEST_SUITE_P(memory, dmac_transfer, testing::Values(false, true), [](const testing::TestParamInfo<bool> &info) {
+    return info.param ? "page_table" : "fastmem";
+});
+
+} // namespace
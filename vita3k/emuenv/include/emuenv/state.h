@@ -34,10 +34,18 @@ enum class Backend : uint32_t;
 struct State;
 } // namespace renderer
 
+namespace dmac {
+struct State;
+};
+
 namespace ngs {
 struct State;
 };
 
+namespace sas {
+struct State;
+};
+
 struct Config;
 struct CPUProtocolBase;
 struct MemState;
@@ -96,7 +104,9 @@ private:
     std::unique_ptr<NetCtlState> _netctl;
     std::unique_ptr<ngs::State> _ngs;
     std::unique_ptr<NpState> _np;
+    std::unique_ptr<sas::State> _sas;
     std::unique_ptr<DisplayState> _display;
+    std::unique_ptr<dmac::State> _dmac;
     std::unique_ptr<DialogState> _common_dialog;
     std::unique_ptr<Ime> _ime;
     std::unique_ptr<License> _license;
@@ -125,12 +135,14 @@ public:
     std::string load_app_path{};
     std::string load_exec_argv{};
     std::string load_exec_path{};
+    std::string load_snapshot_path{};
     std::string self_name{};
     std::string self_path{};
     Config &cfg;
     std::unique_ptr<CPUProtocolBase> cpu_protocol{};
     SceUID main_thread_id{};
     size_t frame_count = 0;
+    size_t total_frame_count = 0; // never reset, unlike frame_count
     uint32_t sdl_ticks = 0;
     uint32_t fps = 0;
     uint32_t avg_fps = 0;
@@ -162,7 +174,9 @@ public:
     NetCtlState &netctl;
     ngs::State &ngs;
     NpState &np;
+    sas::State &sas;
     DisplayState &display;
+    dmac::State &dmac;
     DialogState &common_dialog;
     Ime &ime;
     License &license;
@@ -22,6 +22,7 @@
 #include <ctrl/state.h>
 #include <dialog/state.h>
 #include <display/state.h>
+#include <dmac/state.h>
 #include <gxm/state.h>
 #include <http/state.h>
 #include <ime/state.h>
@@ -36,6 +37,7 @@
 #include <packages/sfo.h>
 #include <regmgr/state.h>
 #include <renderer/state.h>
+#include <sas/state.h>
 #include <touch/state.h>
 
 #include <gdbstub/state.h>
@@ -74,8 +76,12 @@ EmuEnvState::EmuEnvState()
     , ngs(*_ngs)
     , _np(new NpState)
     , np(*_np)
+    , _sas(new sas::State)
+    , sas(*_sas)
     , _display(new DisplayState)
     , display(*_display)
+    , _dmac(new dmac::State)
+    , dmac(*_dmac)
     , _common_dialog(new DialogState)
     , common_dialog(*_common_dialog)
     , _ime(new Ime)
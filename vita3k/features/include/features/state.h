@@ -29,6 +29,7 @@ struct FeatureState {
     bool use_mask_bit = false; ///< Is the mask bit (1 per sample) emulated ? It is only used in homebrews afaik
     bool support_memory_mapping = false; ///< Is the host GPU memory directly mapped with gxm memory?
     bool use_texture_viewport = false; ///< Are we using texture viewports in the shader
+    bool optimize_spirv = false; ///< Run the SPIR-V optimizer on the translated shaders before they are cached
 
     bool is_programmable_blending_supported() const {
         return support_shader_interlock || support_texture_barrier || direct_fragcolor;
@@ -192,6 +192,8 @@ void draw_controls_dialog(GuiState &gui, EmuEnvState &emuenv) {
         ImGui::TableSetupColumn("mapped_button");
         remapper_button(gui, emuenv, &emuenv.cfg.keyboard_toggle_texture_replacement, lang["toggle_texture_replacement"].c_str());
         remapper_button(gui, emuenv, &emuenv.cfg.keyboard_take_screenshot, lang["take_screenshot"].c_str());
+        remapper_button(gui, emuenv, &emuenv.cfg.keyboard_save_snapshot, lang["save_snapshot"].c_str());
+        remapper_button(gui, emuenv, &emuenv.cfg.keyboard_load_snapshot, lang["load_snapshot"].c_str());
         ImGui::EndTable();
     }
 
@@ -27,6 +27,7 @@
 #include <dialog/state.h>
 #include <io/device.h>
 #include <io/functions.h>
+#include <io/state.h>
 
 #include <pugixml.hpp>
 #include <stb_image.h>
@@ -134,6 +135,8 @@ static bool show_hidden_trophy = false;
 void init_trophy_collection(GuiState &gui, EmuEnvState &emuenv) {
     const auto TROPHY_PATH{ emuenv.pref_path / "ux0/user" / emuenv.io.user_id / "trophy" };
     const auto TROPHY_CONF_PATH = TROPHY_PATH / "conf";
+    // the progress of a trophy unlocked just before may not be on the disk yet
+    emuenv.io.write_behind.wait(TROPHY_PATH);
 
     gui.trophy_np_com_id_list_icons.clear();
     np_com_id_info.clear();
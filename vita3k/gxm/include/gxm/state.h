@@ -23,6 +23,8 @@
 
 #include <map>
 #include <mutex>
+#include <optional>
+#include <set>
 
 struct SceGxmInitializeParams {
     uint32_t flags = 0;
@@ -47,6 +49,28 @@ struct MemoryMapInfo {
     std::uint32_t perm;
 };
 
+struct GxmContextInfo {
+    // the command allocator of an immediate context runs the callbacks on this thread
+    SceUID thread_id;
+    // render target of the last scene of an immediate context, the scene is started again when a snapshot is loaded in the middle of it
+    Address render_target = 0;
+};
+
+// The GXM objects live in guest memory but hold host state, which does not survive the process.
+// They are tracked here so that a snapshot can create their host state again.
+struct GxmObjects {
+    std::mutex mutex;
+    std::map<Address, GxmContextInfo> contexts;
+    std::map<Address, SceGxmRenderTargetParams> render_targets;
+    std::set<Address> sync_objects;
+    std::set<Address> shader_patchers;
+    std::set<Address> vertex_programs;
+    // blend info the program was created with, if any
+    std::map<Address, std::optional<SceGxmBlendInfo>> fragment_programs;
+    // host command list each command list of the game points to
+    std::map<Address, const void *> command_lists;
+};
+
 struct GxmState {
     SceGxmInitializeParams params;
 
@@ -62,4 +86,6 @@ struct GxmState {
 
     std::map<Address, MemoryMapInfo> memory_mapped_regions;
     std::mutex callback_lock;
+
+    GxmObjects objects;
 };
@@ -0,0 +1,118 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef struct ssl_ctx_st SSL_CTX;
+typedef struct ssl_session_st SSL_SESSION;
+
+namespace http {
+
+typedef std::chrono::steady_clock Clock;
+
+enum class Result {
+    Ok,
+    // the server closed the connection
+    Closed,
+    Timeout,
+    ResolveFailed,
+    ConnectFailed,
+    HandshakeFailed,
+    Error,
+};
+
+struct Endpoint {
+    std::string host;
+    std::string port;
+    // uses TLS with this context when set
+    SSL_CTX *ssl_ctx = nullptr;
+};
+
+// A TCP connection to an endpoint, with its TLS state for https
+struct Connection;
+// The work on a connection that the network worker takes over when it can not be done right away
+struct Operation;
+// The addresses a host resolved to
+struct Addresses;
+// A resolution running on its own thread
+struct Lookup;
+typedef std::shared_ptr<Connection> ConnectionPtr;
+
+struct PoolStats {
+    uint64_t connections_opened = 0;
+    uint64_t connections_reused = 0;
+    uint64_t sessions_resumed = 0;
+    uint64_t dns_lookups = 0;
+    uint64_t dns_cache_hits = 0;
+};
+
+// Keeps connections to the hosts the guest talks to alive between requests, along with their DNS results and TLS sessions.
+// The sockets are non-blocking, an operation that can not complete right away is handed to a network worker and the calling
+// thread waits for it to complete.
+class ConnectionPool {
+public:
+    ConnectionPool();
+    ~ConnectionPool();
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    // Resolves the host, or returns the cached result of a recent resolution. The resolution goes on in the background
+    // after a timeout, the next call for the host waits for it again.
+    Result resolve(const std::string &host, const std::string &port, Clock::duration timeout);
+    // An idle connection to the endpoint that is still open, or a new one once connected and through its TLS handshake
+    Result acquire(const Endpoint &endpoint, Clock::duration timeout, ConnectionPtr &connection);
+    // Keeps the connection for the next acquire of the same endpoint when reusable, closes it otherwise
+    void release(ConnectionPtr connection, bool reusable);
+    // Closes the idle connections and forgets the DNS results and TLS sessions
+    void clear();
+
+    Result send(Connection &connection, const void *data, size_t size, Clock::duration timeout);
+    // Waits until some data arrives, at most size bytes are received
+    Result receive(Connection &connection, void *data, size_t size, size_t &received, Clock::duration timeout);
+
+    // Whether the connection had been used before the last acquire
+    static bool is_reused(const Connection &connection);
+    PoolStats stats();
+
+private:
+    struct Worker;
+
+    Result run(Operation &operation, Clock::duration timeout);
+    std::shared_ptr<const Addresses> lookup(const std::string &host, const std::string &port, Clock::duration timeout, Result &result);
+
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<const Addresses>> dns_cache;
+    // resolutions not in dns_cache yet, several threads connecting to the same host wait for the same one
+    std::map<std::string, std::shared_ptr<Lookup>> lookups;
+    std::map<std::string, std::vector<ConnectionPtr>> idle;
+    std::map<std::string, SSL_SESSION *> sessions;
+    PoolStats counters;
+    // started by the first operation that has to wait
+    std::unique_ptr<Worker> worker;
+};
+
+} // namespace http
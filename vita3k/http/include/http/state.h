@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <http/connection_pool.h>
 #include <mem/ptr.h>
 #include <util/types.h>
 
@@ -235,7 +236,10 @@ struct SceConnection {
     std::string url;
     SceBool keepAlive;
     bool isSecure;
-    int sockfd;
+    std::string hostname;
+    std::string port;
+    // taken from the pool when created and given back when deleted, null once it can not carry another request
+    http::ConnectionPtr connection;
 };
 
 struct SceRequestResponse {
@@ -276,4 +280,5 @@ struct HTTPState {
     std::map<SceInt, SceRequest> requests;
     std::vector<Ptr<void>> guestPointers;
     void *ssl_ctx = nullptr;
+    http::ConnectionPool pool;
 };
@@ -0,0 +1,737 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <http/connection_pool.h>
+
+#include <net/socket.h>
+#include <util/log.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#ifdef _WIN32
+#define poll WSAPoll
+#else
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+namespace http {
+
+// How long the addresses of a host are used before it is resolved again
+constexpr auto DNS_CACHE_LIFETIME = std::chrono::minutes(5);
+// Idle connections kept for each endpoint, and for how long
+constexpr size_t MAX_IDLE_PER_ENDPOINT = 4;
+constexpr auto IDLE_LIFETIME = std::chrono::seconds(30);
+
+#ifdef _WIN32
+constexpr abs_socket INVALID_SOCK = INVALID_SOCKET;
+constexpr int SEND_FLAGS = 0;
+
+static int last_error() {
+    return WSAGetLastError();
+}
+
+static bool would_block(int error) {
+    return error == WSAEWOULDBLOCK;
+}
+
+static bool in_progress(int error) {
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+}
+
+static void close_socket(abs_socket sock) {
+    closesocket(sock);
+}
+
+static void set_non_blocking(abs_socket sock) {
+    u_long non_blocking = 1;
+    ioctlsocket(sock, FIONBIO, &non_blocking);
+}
+#else
+constexpr abs_socket INVALID_SOCK = -1;
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+static int last_error() {
+    return errno;
+}
+
+static bool would_block(int error) {
+    return error == EAGAIN || error == EWOULDBLOCK;
+}
+
+static bool in_progress(int error) {
+    return error == EINPROGRESS;
+}
+
+static void close_socket(abs_socket sock) {
+    ::close(sock);
+}
+
+static void set_non_blocking(abs_socket sock) {
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+}
+#endif
+
+struct Connection {
+    ~Connection() {
+        if (ssl) {
+            // sends the close notification if the socket can take it, without waiting for the answer
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+        }
+        if (sock != INVALID_SOCK) {
+            close_socket(sock);
+        }
+    }
+
+    std::string key;
+    abs_socket sock = INVALID_SOCK;
+    SSL *ssl = nullptr;
+    bool reused = false;
+    Clock::time_point idle_since;
+};
+
+struct Addresses {
+    struct Address {
+        sockaddr_storage storage;
+        socklen_t length;
+    };
+
+    std::vector<Address> list;
+    Clock::time_point expires;
+};
+
+struct Lookup {
+    std::mutex mutex;
+    std::condition_variable resolved;
+    bool done = false;
+    // null if the resolution failed
+    std::shared_ptr<Addresses> addresses;
+};
+
+// getaddrinfo can block for as long as the system resolver wants, it runs on a thread of its own so that the caller can time out
+static void start_lookup(const std::shared_ptr<Lookup> &lookup, const std::string &host, const std::string &port) {
+    std::thread([lookup, host, port] {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *list = nullptr;
+        const int ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &list);
+
+        std::shared_ptr<Addresses> addresses;
+        if (ret != 0 || !list) {
+            LOG_ERROR("getaddrinfo({},{},...) = {}", host, port, ret);
+        } else {
+            addresses = std::make_shared<Addresses>();
+            for (const addrinfo *info = list; info; info = info->ai_next) {
+                Addresses::Address address{};
+                std::memcpy(&address.storage, info->ai_addr, info->ai_addrlen);
+                address.length = static_cast<socklen_t>(info->ai_addrlen);
+                addresses->list.push_back(address);
+            }
+            freeaddrinfo(list);
+            addresses->expires = Clock::now() + DNS_CACHE_LIFETIME;
+        }
+
+        const std::lock_guard<std::mutex> lock(lookup->mutex);
+        lookup->addresses = std::move(addresses);
+        lookup->done = true;
+        lookup->resolved.notify_all();
+    }).detach();
+}
+
+enum class Want {
+    None,
+    Read,
+    Write,
+};
+
+struct Operation {
+    enum class Kind {
+        Connect,
+        Send,
+        Receive,
+    };
+
+    Operation(Kind kind, Connection &connection)
+        : kind(kind)
+        , connection(connection) {}
+
+    const Kind kind;
+    Connection &connection;
+
+    std::shared_ptr<const Addresses> addresses;
+    size_t next_address = 0;
+    bool connecting = false;
+    bool handshaking = false;
+
+    uint8_t *data = nullptr;
+    size_t size = 0;
+    size_t progress = 0;
+
+    Want want = Want::None;
+    Result result = Result::Ok;
+    Clock::time_point deadline;
+    bool done = false;
+};
+
+static Want ssl_want(Operation &operation, int ret, Result failure) {
+    switch (SSL_get_error(operation.connection.ssl, ret)) {
+    case SSL_ERROR_WANT_READ:
+        return Want::Read;
+    case SSL_ERROR_WANT_WRITE:
+        return Want::Write;
+    case SSL_ERROR_ZERO_RETURN:
+        operation.result = Result::Closed;
+        return Want::None;
+    default:
+        operation.result = failure;
+        return Want::None;
+    }
+}
+
+static Want step_handshake(Operation &operation) {
+    ERR_clear_error();
+    const int ret = SSL_connect(operation.connection.ssl);
+    if (ret == 1) {
+        operation.result = Result::Ok;
+        return Want::None;
+    }
+
+    const Want want = ssl_want(operation, ret, Result::HandshakeFailed);
+    if (want == Want::None) {
+        LOG_ERROR("SSL_connect(...) = {}, SSLERR = {}", ret, SSL_get_error(operation.connection.ssl, ret));
+        operation.result = Result::HandshakeFailed;
+    }
+    return want;
+}
+
+static Want step_connect(Operation &operation) {
+    Connection &connection = operation.connection;
+    if (operation.handshaking) {
+        return step_handshake(operation);
+    }
+
+    if (operation.connecting) {
+        operation.connecting = false;
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(connection.sock, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &length);
+        if (error == 0) {
+            if (!connection.ssl) {
+                operation.result = Result::Ok;
+                return Want::None;
+            }
+            operation.handshaking = true;
+            return step_handshake(operation);
+        }
+        close_socket(connection.sock);
+        connection.sock = INVALID_SOCK;
+    }
+
+    // the addresses of the host are tried in order until one accepts the connection
+    while (operation.next_address < operation.addresses->list.size()) {
+        const auto &address = operation.addresses->list[operation.next_address++];
+        connection.sock = socket(address.storage.ss_family, SOCK_STREAM, IPPROTO_TCP);
+        if (connection.sock == INVALID_SOCK) {
+            continue;
+        }
+
+        set_non_blocking(connection.sock);
+        const int no_delay = 1;
+        setsockopt(connection.sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&no_delay), sizeof(no_delay));
+#ifdef SO_NOSIGPIPE
+        const int no_sigpipe = 1;
+        setsockopt(connection.sock, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+        if (connection.ssl) {
+            SSL_set_fd(connection.ssl, static_cast<int>(connection.sock));
+        }
+
+        if (::connect(connection.sock, reinterpret_cast<const sockaddr *>(&address.storage), address.length) == 0) {
+            if (!connection.ssl) {
+                operation.result = Result::Ok;
+                return Want::None;
+            }
+            operation.handshaking = true;
+            return step_handshake(operation);
+        }
+        if (in_progress(last_error())) {
+            operation.connecting = true;
+            return Want::Write;
+        }
+
+        close_socket(connection.sock);
+        connection.sock = INVALID_SOCK;
+    }
+
+    operation.result = Result::ConnectFailed;
+    return Want::None;
+}
+
+static Want step_send(Operation &operation) {
+    Connection &connection = operation.connection;
+    while (operation.progress < operation.size) {
+        const int length = static_cast<int>(std::min<size_t>(operation.size - operation.progress, INT_MAX));
+        int sent;
+        if (connection.ssl) {
+            ERR_clear_error();
+            sent = SSL_write(connection.ssl, operation.data + operation.progress, length);
+            if (sent <= 0) {
+                return ssl_want(operation, sent, Result::Closed);
+            }
+        } else {
+            sent = ::send(connection.sock, reinterpret_cast<const char *>(operation.data + operation.progress), length, SEND_FLAGS);
+            if (sent < 0) {
+                if (would_block(last_error())) {
+                    return Want::Write;
+                }
+                operation.result = Result::Closed;
+                return Want::None;
+            }
+        }
+        operation.progress += sent;
+    }
+
+    operation.result = Result::Ok;
+    return Want::None;
+}
+
+static Want step_receive(Operation &operation) {
+    Connection &connection = operation.connection;
+    const int length = static_cast<int>(std::min<size_t>(operation.size, INT_MAX));
+    int received;
+    if (connection.ssl) {
+        ERR_clear_error();
+        received = SSL_read(connection.ssl, operation.data, length);
+        if (received <= 0) {
+            return ssl_want(operation, received, Result::Closed);
+        }
+    } else {
+        received = ::recv(connection.sock, reinterpret_cast<char *>(operation.data), length, 0);
+        if (received < 0 && would_block(last_error())) {
+            return Want::Read;
+        }
+        if (received <= 0) {
+            operation.result = Result::Closed;
+            return Want::None;
+        }
+    }
+
+    operation.progress = received;
+    operation.result = Result::Ok;
+    return Want::None;
+}
+
+static Want step(Operation &operation) {
+    switch (operation.kind) {
+    case Operation::Kind::Connect:
+        return step_connect(operation);
+    case Operation::Kind::Send:
+        return step_send(operation);
+    case Operation::Kind::Receive:
+        return step_receive(operation);
+    }
+    return Want::None;
+}
+
+// An idle connection can still be used if the server neither closed it nor sent anything since
+static bool is_alive(Connection &connection) {
+    if (connection.ssl) {
+        // a session ticket sent after the handshake is consumed here without being data
+        char byte;
+        ERR_clear_error();
+        const int ret = SSL_peek(connection.ssl, &byte, 1);
+        return ret <= 0 && SSL_get_error(connection.ssl, ret) == SSL_ERROR_WANT_READ;
+    }
+
+    char byte;
+    const int ret = ::recv(connection.sock, &byte, 1, MSG_PEEK);
+    return ret < 0 && would_block(last_error());
+}
+
+// Waits on the sockets of the operations that could not complete right away and steps them once they are ready
+struct ConnectionPool::Worker {
+    Worker() {
+        // a datagram sent by the socket to itself wakes the worker up when an operation is submitted
+        wake_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (wake_socket == INVALID_SOCK
+            || bind(wake_socket, reinterpret_cast<const sockaddr *>(&address), length) != 0
+            || getsockname(wake_socket, reinterpret_cast<sockaddr *>(&address), &length) != 0
+            || ::connect(wake_socket, reinterpret_cast<const sockaddr *>(&address), length) != 0) {
+            LOG_ERROR("Could not create the socket waking up the network worker, errno={}", last_error());
+        }
+        if (wake_socket != INVALID_SOCK) {
+            set_non_blocking(wake_socket);
+        }
+
+        thread = std::thread([this] { loop(); });
+    }
+
+    ~Worker() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake();
+        thread.join();
+        if (wake_socket != INVALID_SOCK) {
+            close_socket(wake_socket);
+        }
+    }
+
+    Result wait(Operation &operation) {
+        std::unique_lock<std::mutex> lock(mutex);
+        submitted.push_back(&operation);
+        lock.unlock();
+        wake();
+
+        lock.lock();
+        completed.wait(lock, [&] { return operation.done; });
+        return operation.result;
+    }
+
+    void wake() {
+        if (wake_socket != INVALID_SOCK) {
+            ::send(wake_socket, "", 1, 0);
+        }
+    }
+
+    void loop() {
+        std::vector<Operation *> active;
+        std::vector<Operation *> finished;
+        std::vector<pollfd> fds;
+        while (true) {
+            {
+                const std::lock_guard<std::mutex> lock(mutex);
+                active.insert(active.end(), submitted.begin(), submitted.end());
+                submitted.clear();
+                if (quit) {
+                    for (Operation *operation : active) {
+                        operation->result = Result::Error;
+                        operation->done = true;
+                    }
+                    completed.notify_all();
+                    return;
+                }
+            }
+
+            fds.clear();
+            fds.push_back({ wake_socket, POLLIN, 0 });
+            auto next_deadline = Clock::time_point::max();
+            for (Operation *operation : active) {
+                fds.push_back({ operation->connection.sock, static_cast<short>(operation->want == Want::Read ? POLLIN : POLLOUT), 0 });
+                next_deadline = std::min(next_deadline, operation->deadline);
+            }
+
+            int timeout = -1;
+            if (!active.empty()) {
+                const auto left = std::chrono::ceil<std::chrono::milliseconds>(next_deadline - Clock::now()).count();
+                timeout = static_cast<int>(std::clamp<decltype(left)>(left, 0, INT_MAX));
+            }
+            if (wake_socket == INVALID_SOCK) {
+                timeout = timeout < 0 ? 10 : std::min(timeout, 10);
+            }
+            poll(fds.data(), static_cast<unsigned long>(fds.size()), timeout);
+
+            if (fds[0].revents) {
+                char buffer[64];
+                while (::recv(wake_socket, buffer, sizeof(buffer), 0) > 0) {
+                }
+            }
+
+            const auto now = Clock::now();
+            size_t kept = 0;
+            for (size_t i = 0; i < active.size(); i++) {
+                Operation &operation = *active[i];
+                bool finish = false;
+                if (fds[i + 1].revents) {
+                    operation.want = step(operation);
+                    finish = operation.want == Want::None;
+                }
+                if (!finish && now >= operation.deadline) {
+                    operation.result = Result::Timeout;
+                    finish = true;
+                }
+
+                if (finish) {
+                    finished.push_back(&operation);
+                } else {
+                    active[kept++] = &operation;
+                }
+            }
+            active.resize(kept);
+
+            if (!finished.empty()) {
+                {
+                    const std::lock_guard<std::mutex> lock(mutex);
+                    for (Operation *operation : finished) {
+                        operation->done = true;
+                    }
+                }
+                completed.notify_all();
+                finished.clear();
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable completed;
+    std::vector<Operation *> submitted;
+    bool quit = false;
+    abs_socket wake_socket = INVALID_SOCK;
+    std::thread thread;
+};
+
+ConnectionPool::ConnectionPool() = default;
+
+ConnectionPool::~ConnectionPool() {
+    worker.reset();
+    clear();
+}
+
+Result ConnectionPool::run(Operation &operation, Clock::duration timeout) {
+    // most operations complete right away, only the ones that would block go through the worker
+    operation.want = step(operation);
+    if (operation.want == Want::None) {
+        return operation.result;
+    }
+
+    operation.deadline = Clock::now() + timeout;
+    Worker *current;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (!worker) {
+            worker = std::make_unique<Worker>();
+        }
+        current = worker.get();
+    }
+    return current->wait(operation);
+}
+
+std::shared_ptr<const Addresses> ConnectionPool::lookup(const std::string &host, const std::string &port, Clock::duration timeout, Result &result) {
+    const std::string key = host + ":" + port;
+    std::shared_ptr<Lookup> pending;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        const auto it = dns_cache.find(key);
+        if (it != dns_cache.end() && it->second->expires > Clock::now()) {
+            counters.dns_cache_hits++;
+            result = Result::Ok;
+            return it->second;
+        }
+
+        std::shared_ptr<Lookup> &in_flight = lookups[key];
+        if (!in_flight) {
+            in_flight = std::make_shared<Lookup>();
+            counters.dns_lookups++;
+            start_lookup(in_flight, host, port);
+        }
+        pending = in_flight;
+    }
+
+    std::shared_ptr<const Addresses> addresses;
+    {
+        std::unique_lock<std::mutex> lock(pending->mutex);
+        if (!pending->resolved.wait_for(lock, timeout, [&] { return pending->done; })) {
+            LOG_ERROR("Resolving {} timed out", host);
+            result = Result::Timeout;
+            return nullptr;
+        }
+        addresses = pending->addresses;
+    }
+
+    // the first thread to see the result moves it to the cache, a failure is only reported to the threads waiting for it
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto it = lookups.find(key);
+    if (it != lookups.end() && it->second == pending) {
+        lookups.erase(it);
+        if (addresses) {
+            dns_cache[key] = addresses;
+        }
+    }
+    result = addresses ? Result::Ok : Result::ResolveFailed;
+    return addresses;
+}
+
+Result ConnectionPool::resolve(const std::string &host, const std::string &port, Clock::duration timeout) {
+    Result result;
+    lookup(host, port, timeout, result);
+    return result;
+}
+
+// Must be called with the pool locked
+static void keep_session(std::map<std::string, SSL_SESSION *> &sessions, const std::string &key, SSL *ssl) {
+    SSL_SESSION *session = SSL_get1_session(ssl);
+    if (!session) {
+        return;
+    }
+    if (!SSL_SESSION_is_resumable(session)) {
+        SSL_SESSION_free(session);
+        return;
+    }
+
+    SSL_SESSION *&kept = sessions[key];
+    if (kept) {
+        SSL_SESSION_free(kept);
+    }
+    kept = session;
+}
+
+Result ConnectionPool::acquire(const Endpoint &endpoint, Clock::duration timeout, ConnectionPtr &connection) {
+    // connections and sessions are only shared between users of the same TLS context, which holds their TLS settings
+    const std::string key = endpoint.ssl_ctx
+        ? fmt::format("https://{}:{}#{}", endpoint.host, endpoint.port, fmt::ptr(endpoint.ssl_ctx))
+        : "http://" + endpoint.host + ":" + endpoint.port;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        const auto it = idle.find(key);
+        if (it != idle.end()) {
+            auto &connections = it->second;
+            while (!connections.empty()) {
+                ConnectionPtr candidate = std::move(connections.back());
+                connections.pop_back();
+                if (Clock::now() - candidate->idle_since < IDLE_LIFETIME && is_alive(*candidate)) {
+                    candidate->reused = true;
+                    counters.connections_reused++;
+                    connection = std::move(candidate);
+                    return Result::Ok;
+                }
+            }
+        }
+    }
+
+    Result result;
+    auto addresses = lookup(endpoint.host, endpoint.port, timeout, result);
+    if (!addresses) {
+        return result;
+    }
+
+    auto created = std::make_shared<Connection>();
+    created->key = key;
+    if (endpoint.ssl_ctx) {
+        created->ssl = SSL_new(endpoint.ssl_ctx);
+        if (!created->ssl) {
+            return Result::Error;
+        }
+        // This is needed as some servers are using handshake protocols older than the person writing this code
+        SSL_set_security_level(created->ssl, 0);
+        SSL_set_tlsext_host_name(created->ssl, endpoint.host.c_str());
+
+        const std::lock_guard<std::mutex> lock(mutex);
+        const auto session = sessions.find(key);
+        if (session != sessions.end()) {
+            SSL_set_session(created->ssl, session->second);
+        }
+    }
+
+    Operation operation(Operation::Kind::Connect, *created);
+    operation.addresses = std::move(addresses);
+    result = run(operation, timeout);
+    if (result != Result::Ok) {
+        return result;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    counters.connections_opened++;
+    if (created->ssl) {
+        const long verify_flag = SSL_get_verify_result(created->ssl);
+        if (verify_flag != X509_V_OK && verify_flag != X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY)
+            LOG_ERROR("Certificate verification error ({}) but continuing...", verify_flag);
+
+        if (SSL_session_reused(created->ssl)) {
+            counters.sessions_resumed++;
+        }
+        keep_session(sessions, key, created->ssl);
+    }
+
+    connection = std::move(created);
+    return Result::Ok;
+}
+
+void ConnectionPool::release(ConnectionPtr connection, bool reusable) {
+    if (!connection) {
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    // with TLS 1.3 the session to resume arrives after the handshake
+    if (connection->ssl) {
+        keep_session(sessions, connection->key, connection->ssl);
+    }
+    if (!reusable) {
+        return;
+    }
+
+    connection->idle_since = Clock::now();
+    auto &connections = idle[connection->key];
+    if (connections.size() == MAX_IDLE_PER_ENDPOINT) {
+        connections.erase(connections.begin());
+    }
+    connections.push_back(std::move(connection));
+}
+
+void ConnectionPool::clear() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    idle.clear();
+    dns_cache.clear();
+    lookups.clear();
+    for (auto &[key, session] : sessions) {
+        SSL_SESSION_free(session);
+    }
+    sessions.clear();
+}
+
+Result ConnectionPool::send(Connection &connection, const void *data, size_t size, Clock::duration timeout) {
+    Operation operation(Operation::Kind::Send, connection);
+    operation.data = static_cast<uint8_t *>(const_cast<void *>(data));
+    operation.size = size;
+    return run(operation, timeout);
+}
+
+Result ConnectionPool::receive(Connection &connection, void *data, size_t size, size_t &received, Clock::duration timeout) {
+    Operation operation(Operation::Kind::Receive, connection);
+    operation.data = static_cast<uint8_t *>(data);
+    operation.size = size;
+    const Result result = run(operation, timeout);
+    received = result == Result::Ok ? operation.progress : 0;
+    return result;
+}
+
+bool ConnectionPool::is_reused(const Connection &connection) {
+    return connection.reused;
+}
+
+PoolStats ConnectionPool::stats() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+} // namespace http
@@ -0,0 +1,395 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <http/connection_pool.h>
+
+#include <net/socket.h>
+
+#include <gtest/gtest.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+using namespace http;
+
+namespace {
+
+constexpr auto TIMEOUT = std::chrono::seconds(5);
+constexpr char RESPONSE[] = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+
+void close_socket(abs_socket sock) {
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+}
+
+// An HTTP server on the loopback interface answering every request with the same response, over TLS with a context
+class LoopbackServer {
+public:
+    explicit LoopbackServer(SSL_CTX *ssl_ctx = nullptr, bool keep_alive = true, bool respond = true)
+        : ssl_ctx(ssl_ctx)
+        , keep_alive(keep_alive)
+        , respond(respond) {
+        listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        EXPECT_EQ(bind(listener, reinterpret_cast<const sockaddr *>(&address), length), 0);
+        EXPECT_EQ(getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length), 0);
+        EXPECT_EQ(listen(listener, 16), 0);
+        port = std::to_string(ntohs(address.sin_port));
+
+        thread = std::thread([this] { accept_loop(); });
+    }
+
+    ~LoopbackServer() {
+        stop = true;
+        thread.join();
+        for (auto &client : clients) {
+            client.join();
+        }
+        close_socket(listener);
+    }
+
+    Endpoint endpoint(SSL_CTX *client_ctx = nullptr) const {
+        return Endpoint{ "localhost", port, client_ctx };
+    }
+
+    std::string port;
+    std::atomic<int> accepted = 0;
+    std::atomic<int> closed = 0;
+
+private:
+    void accept_loop() {
+        while (!stop) {
+            pollfd fd{ listener, POLLIN, 0 };
+            if (poll(&fd, 1, 10) <= 0)
+                continue;
+
+            const abs_socket sock = accept(listener, nullptr, nullptr);
+            accepted++;
+            clients.emplace_back([this, sock] { serve(sock); });
+        }
+    }
+
+    int read(SSL *ssl, abs_socket sock, char *buffer, int size) {
+        if (ssl)
+            return SSL_read(ssl, buffer, size);
+        return recv(sock, buffer, size, 0);
+    }
+
+    void serve(abs_socket sock) {
+        // wakes up regularly to notice when the test is over
+#ifdef _WIN32
+        const DWORD wait = 10;
+#else
+        const timeval wait{ 0, 10000 };
+#endif
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&wait), sizeof(wait));
+
+        SSL *ssl = nullptr;
+        if (ssl_ctx) {
+            ssl = SSL_new(ssl_ctx);
+            SSL_set_fd(ssl, static_cast<int>(sock));
+            while (SSL_accept(ssl) != 1) {
+                if (stop || SSL_get_error(ssl, -1) == SSL_ERROR_SSL) {
+                    SSL_free(ssl);
+                    close_socket(sock);
+                    return;
+                }
+            }
+        }
+
+        std::string request;
+        char buffer[256];
+        while (!stop) {
+            const int received = read(ssl, sock, buffer, sizeof(buffer));
+            if (received == 0)
+                break;
+            if (received < 0)
+                continue;
+
+            request.append(buffer, received);
+            if (request.find("\r\n\r\n") == std::string::npos || !respond)
+                continue;
+            request.clear();
+
+            if (ssl)
+                SSL_write(ssl, RESPONSE, sizeof(RESPONSE) - 1);
+            else
+                send(sock, RESPONSE, sizeof(RESPONSE) - 1, 0);
+            if (!keep_alive)
+                break;
+        }
+
+        if (ssl) {
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+        }
+        close_socket(sock);
+        closed++;
+    }
+
+    SSL_CTX *ssl_ctx;
+    const bool keep_alive;
+    const bool respond;
+    abs_socket listener;
+    std::atomic<bool> stop = false;
+    std::thread thread;
+    std::list<std::thread> clients;
+};
+
+// A server context with a self-signed certificate
+SSL_CTX *create_server_context() {
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    X509_sign(cert, key, EVP_sha256());
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_use_certificate(ctx, cert);
+    SSL_CTX_use_PrivateKey(ctx, key);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ctx;
+}
+
+class connection_pool : public testing::Test {
+protected:
+    static void SetUpTestSuite() {
+#ifdef _WIN32
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+    }
+
+    // Sends a request and reads the whole response
+    std::string exchange(Connection &connection) {
+        const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        EXPECT_EQ(pool.send(connection, request.data(), request.size(), TIMEOUT), Result::Ok);
+
+        std::string response;
+        char buffer[256];
+        while (response.size() < sizeof(RESPONSE) - 1) {
+            size_t received = 0;
+            const Result result = pool.receive(connection, buffer, sizeof(buffer), received, TIMEOUT);
+            EXPECT_EQ(result, Result::Ok);
+            if (result != Result::Ok)
+                break;
+            response.append(buffer, received);
+        }
+        return response;
+    }
+
+    ConnectionPool pool;
+};
+
+} // namespace
+
+TEST_F(connection_pool, reuses_kept_alive_connections) {
+    LoopbackServer server;
+
+    ConnectionPtr connection;
+    ASSERT_EQ(pool.acquire(server.endpoint(), TIMEOUT, connection), Result::Ok);
+    EXPECT_FALSE(ConnectionPool::is_reused(*connection));
+    EXPECT_EQ(exchange(*connection), RESPONSE);
+    pool.release(std::move(connection), true);
+
+    ASSERT_EQ(pool.acquire(server.endpoint(), TIMEOUT, connection), Result::Ok);
+    EXPECT_TRUE(ConnectionPool::is_reused(*connection));
+    EXPECT_EQ(exchange(*connection), RESPONSE);
+    pool.release(std::move(connection), true);
+
+    EXPECT_EQ(server.accepted, 1);
+    const PoolStats stats = pool.stats();
+    EXPECT_EQ(stats.connections_opened, 1u);
+    EXPECT_EQ(stats.connections_reused, 1u);
+}
+
+TEST_F(connection_pool, does_not_reuse_connections_closed_by_the_server) {
+    LoopbackServer server(nullptr, false);
+
+    ConnectionPtr connection;
+    ASSERT_EQ(pool.acquire(server.endpoint(), TIMEOUT, connection), Result::Ok);
+    EXPECT_EQ(exchange(*connection), RESPONSE);
+    pool.release(std::move(connection), true);
+    while (server.closed == 0)
+        std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    ASSERT_EQ(pool.acquire(server.endpoint(), TIMEOUT, connection), Result::Ok);
+    EXPECT_FALSE(ConnectionPool::is_reused(*connection));
+    EXPECT_EQ(exchange(*connection), RESPONSE);
+    EXPECT_EQ(server.accepted, 2);
+}
+
+TEST_F(connection_pool, caches_dns_results) {
+    LoopbackServer server;
+
+    ASSERT_EQ(pool.resolve("localhost", server.port, TIMEOUT), Result::Ok);
+    ASSERT_EQ(pool.resolve("localhost", server.port, TIMEOUT), Result::Ok);
+    ConnectionPtr connection;
+    ASSERT_EQ(pool.acquire(server.endpoint(), TIMEOUT, connection), Result::Ok);
+
+    const PoolStats stats = pool.stats();
+    EXPECT_EQ(stats.dns_lookups, 1u);
+    EXPECT_EQ(stats.dns_cache_hits, 2u);
+
+    pool.clear();
+    ASSERT_EQ(pool.resolve("localhost", server.port, TIMEOUT), Result::Ok);
+    EXPECT_EQ(pool.stats().dns_lookups, 2u);
+}
+
+TEST_F(connection_pool, shares_a_resolution_between_threads) {
+    LoopbackServer server;
+
+    // the threads asking while the host is being resolved wait for the same resolution
+    std::vector<std::thread> threads;
+    std::vector<Result> results(4, Result::Error);
+    for (size_t i = 0; i < results.size(); i++)
+        threads.emplace_back([&, i] { results[i] = pool.resolve("localhost", server.port, TIMEOUT); });
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (const Result result : results)
+        EXPECT_EQ(result, Result::Ok);
+    EXPECT_EQ(pool.stats().dns_lookups, 1u);
+}
+
+TEST_F(connection_pool, times_out_without_a_response) {
+    LoopbackServer server(nullptr, true, false);
+
+    ConnectionPtr connection;
+    ASSERT_EQ(pool.acquire(server.endpoint(), TIMEOUT, connection), Result::Ok);
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_EQ(pool.send(*connection, request.data(), request.size(), TIMEOUT), Result::Ok);
+
+    char buffer[16];
+    size_t received = 0;
+    const auto start = Clock::now();
+    EXPECT_EQ(pool.receive(*connection, buffer, sizeof(buffer), received, std::chrono::milliseconds(50)), Result::Timeout);
+    EXPECT_GE(Clock::now() - start, std::chrono::milliseconds(50));
+    EXPECT_EQ(received, 0u);
+}
+
+TEST_F(connection_pool, fails_to_connect_to_a_closed_port) {
+    std::string port;
+    {
+        LoopbackServer server;
+        port = server.port;
+    }
+
+    ConnectionPtr connection;
+    EXPECT_EQ(pool.acquire(Endpoint{ "127.0.0.1", port }, TIMEOUT, connection), Result::ConnectFailed);
+    EXPECT_FALSE(connection);
+}
+
+TEST_F(connection_pool, resumes_tls_sessions) {
+    SSL_CTX *server_ctx = create_server_context();
+    SSL_CTX *client_ctx = SSL_CTX_new(TLS_client_method());
+    {
+        LoopbackServer server(server_ctx);
+
+        for (int i = 0; i < 2; i++) {
+            ConnectionPtr connection;
+            ASSERT_EQ(pool.acquire(server.endpoint(client_ctx), TIMEOUT, connection), Result::Ok);
+            EXPECT_EQ(exchange(*connection), RESPONSE);
+            pool.release(std::move(connection), false);
+        }
+
+        EXPECT_EQ(server.accepted, 2);
+        EXPECT_EQ(pool.stats().sessions_resumed, 1u);
+    }
+    pool.clear();
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+}
+
+TEST_F(connection_pool, does_not_share_connections_between_tls_contexts) {
+    SSL_CTX *server_ctx = create_server_context();
+    SSL_CTX *client_ctxs[] = { SSL_CTX_new(TLS_client_method()), SSL_CTX_new(TLS_client_method()) };
+    {
+        LoopbackServer server(server_ctx);
+
+        for (SSL_CTX *client_ctx : client_ctxs) {
+            ConnectionPtr connection;
+            ASSERT_EQ(pool.acquire(server.endpoint(client_ctx), TIMEOUT, connection), Result::Ok);
+            EXPECT_FALSE(ConnectionPool::is_reused(*connection));
+            EXPECT_EQ(exchange(*connection), RESPONSE);
+            pool.release(std::move(connection), false);
+        }
+
+        EXPECT_EQ(server.accepted, 2);
+        EXPECT_EQ(pool.stats().sessions_resumed, 0u);
+
+        // the connection kept alive with the first context is only reused with it
+        ConnectionPtr connection;
+        ASSERT_EQ(pool.acquire(server.endpoint(client_ctxs[0]), TIMEOUT, connection), Result::Ok);
+        EXPECT_EQ(exchange(*connection), RESPONSE);
+        pool.release(std::move(connection), true);
+        ASSERT_EQ(pool.acquire(server.endpoint(client_ctxs[1]), TIMEOUT, connection), Result::Ok);
+        EXPECT_FALSE(ConnectionPool::is_reused(*connection));
+        EXPECT_EQ(exchange(*connection), RESPONSE);
+        pool.release(std::move(connection), false);
+    }
+    pool.clear();
+    for (SSL_CTX *client_ctx : client_ctxs)
+        SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+}
+
+TEST_F(connection_pool, serves_concurrent_requests) {
+    LoopbackServer server;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 20; j++) {
+                ConnectionPtr connection;
+                ASSERT_EQ(pool.acquire(server.endpoint(), TIMEOUT, connection), Result::Ok);
+                EXPECT_EQ(exchange(*connection), RESPONSE);
+                pool.release(std::move(connection), true);
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    const PoolStats stats = pool.stats();
+    EXPECT_EQ(stats.connections_opened + stats.connections_reused, 80u);
+    EXPECT_LE(stats.connections_opened, 4u);
+}
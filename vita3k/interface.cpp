@@ -37,6 +37,7 @@
 #include <packages/sfo.h>
 #include <renderer/state.h>
 #include <renderer/texture_cache.h>
+#include <snapshot/snapshot.h>
 
 #include <modules/module_parent.h>
 #include <string>
@@ -391,6 +392,8 @@ static ExitCode load_app_impl(SceUID &main_module_id, EmuEnvState &emuenv) {
         LOG_WARN("Failed to init kernel!");
         return KernelInitFailed;
     }
+    // not tied to a title: a function is replaced in any module it is found in
+    emuenv.kernel.function_replacements.load(emuenv.patch_path / "signatures.txt");
 
     if (emuenv.cfg.archive_log) {
         const fs::path log_directory{ emuenv.log_path / "logs" };
@@ -559,8 +562,50 @@ static void take_screenshot(EmuEnvState &emuenv) {
     }
 }
 
+// The first snapshot of an app is kept as the base, the following ones only store what changed since it
+static void save_snapshot(EmuEnvState &emuenv) {
+    if (emuenv.io.title_id.empty()) {
+        LOG_ERROR("Trying to save a snapshot while not ingame");
+        return;
+    }
+
+    const fs::path snapshot_folder = emuenv.shared_path / "snapshots" / emuenv.io.title_id;
+    fs::create_directories(snapshot_folder);
+
+    const fs::path base = snapshot_folder / "base.v3ks";
+    if (fs::exists(base))
+        snapshot::save(snapshot_folder / "latest.v3ks", emuenv, base);
+    else
+        snapshot::save(base, emuenv);
+}
+
+// A snapshot is restored in a new run of the emulator, the app is loaded again and the snapshot replaces its start
+static void load_snapshot(EmuEnvState &emuenv) {
+    if (emuenv.io.title_id.empty()) {
+        LOG_ERROR("Trying to load a snapshot while not ingame");
+        return;
+    }
+
+    const fs::path snapshot_folder = emuenv.shared_path / "snapshots" / emuenv.io.title_id;
+    fs::path path = snapshot_folder / "latest.v3ks";
+    if (!fs::exists(path))
+        path = snapshot_folder / "base.v3ks";
+    if (!fs::exists(path)) {
+        LOG_ERROR("No snapshot of {} to load", emuenv.io.title_id);
+        return;
+    }
+
+    emuenv.load_exec = true;
+    emuenv.load_app_path = emuenv.io.app_path;
+    emuenv.load_exec_path = emuenv.self_path;
+    emuenv.load_snapshot_path = fs_utils::path_to_utf8(path);
+}
+
 bool handle_events(EmuEnvState &emuenv, GuiState &gui) {
-    refresh_controllers(emuenv.ctrl, emuenv);
+    {
+        const std::lock_guard<std::mutex> guard(emuenv.ctrl.mutex);
+        refresh_controllers(emuenv.ctrl, emuenv);
+    }
     const auto allow_switch_state = !emuenv.io.title_id.empty() && !gui.vita_area.app_close && !gui.vita_area.home_screen && !gui.vita_area.user_management && !gui.configuration_menu.custom_settings_dialog && !gui.configuration_menu.settings_dialog && !gui.controls_menu.controls_dialog && gui::get_sys_apps_state(gui);
 
     const auto ui_navigation = [&emuenv, &gui, allow_switch_state](const uint32_t sce_ctrl_btn) {
@@ -655,12 +700,7 @@ bool handle_events(EmuEnvState &emuenv, GuiState &gui) {
         case SDL_QUIT:
             if (!emuenv.io.app_path.empty())
                 gui::update_time_app_used(gui, emuenv, emuenv.io.app_path);
-            emuenv.kernel.exit_delete_all_threads();
-            emuenv.gxm.display_queue.abort();
-            emuenv.display.abort = true;
-            if (emuenv.display.vblank_thread) {
-                emuenv.display.vblank_thread->join();
-            }
+            stop_app(emuenv);
             return false;
 
         case SDL_KEYDOWN: {
@@ -718,6 +758,10 @@ bool handle_events(EmuEnvState &emuenv, GuiState &gui) {
                 toggle_texture_replacement(emuenv);
             if (event.key.keysym.scancode == emuenv.cfg.keyboard_take_screenshot && !gui.is_key_capture_dropped)
                 take_screenshot(emuenv);
+            if (event.key.keysym.scancode == emuenv.cfg.keyboard_save_snapshot && !gui.is_key_capture_dropped)
+                save_snapshot(emuenv);
+            if (event.key.keysym.scancode == emuenv.cfg.keyboard_load_snapshot && !gui.is_key_capture_dropped)
+                load_snapshot(emuenv);
 
             if (sce_ctrl_btn != 0) {
                 if (last_buttons.contains(sce_ctrl_btn)) {
@@ -835,6 +879,14 @@ static std::vector<std::string> split(const std::string &input, const std::strin
     return { first, last };
 }
 
+static void start_services(EmuEnvState &emuenv) {
+    start_vblank_timer(emuenv);
+    start_ctrl_sampler(emuenv);
+
+    if (emuenv.cfg.boot_apps_full_screen && !emuenv.display.fullscreen.load())
+        switch_full_screen(emuenv);
+}
+
 ExitCode run_app(EmuEnvState &emuenv, int32_t main_module_id) {
     auto entry_point = emuenv.kernel.loaded_modules[main_module_id]->info.start_entry;
     auto process_param = emuenv.kernel.process_param.get(emuenv.mem);
@@ -883,15 +935,34 @@ ExitCode run_app(EmuEnvState &emuenv, int32_t main_module_id) {
         param.size = static_cast<SceSize>(buf.size());
         param.attr = arr.address();
     }
+    touch_init_buffers();
     if (main_thread->start(param.size, Ptr<void>(param.attr), true) < 0) {
         app::error_dialog("Failed to run main thread.", emuenv.window.get());
         return RunThreadFailed;
     }
 
-    start_sync_thread(emuenv);
+    start_services(emuenv);
 
-    if (emuenv.cfg.boot_apps_full_screen && !emuenv.display.fullscreen.load())
-        switch_full_screen(emuenv);
+    return Success;
+}
+
+ExitCode restore_app(EmuEnvState &emuenv, const fs::path &snapshot_path) {
+    if (!snapshot::load(snapshot_path, emuenv)) {
+        app::error_dialog(fmt::format("Failed to load the snapshot {}.", snapshot_path), emuenv.window.get());
+        return SnapshotLoadFailed;
+    }
+
+    touch_init_buffers();
+    start_services(emuenv);
 
     return Success;
 }
+
+void stop_app(EmuEnvState &emuenv) {
+    emuenv.kernel.exit_delete_all_threads();
+    emuenv.gxm.display_queue.abort();
+    // the vblank callback uses the display state, destroyed before the kernel timer service
+    stop_vblank_timer(emuenv);
+    // a joinable sampler thread would terminate the process once the ctrl state is destroyed
+    stop_ctrl_sampler(emuenv);
+}
@@ -58,3 +58,7 @@ uint32_t install_contents(EmuEnvState &emuenv, GuiState *gui, const fs::path &pa
 
 ExitCode load_app(int32_t &main_module_id, EmuEnvState &emuenv);
 ExitCode run_app(EmuEnvState &emuenv, int32_t main_module_id);
+// Start the app from a snapshot, after load_app and instead of run_app
+ExitCode restore_app(EmuEnvState &emuenv, const fs::path &snapshot_path);
+// Stop the guest threads and what drives them, must be called before the emulator state is destroyed
+void stop_app(EmuEnvState &emuenv);
@@ -0,0 +1,157 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Compares the lookups of guest paths whose case differs from the host under app0 with the cache they used to go through:
+// - the first lookup, which walks the whole tree
+// - the lookup of every file, the way open goes
+// - the stat of every file, the way stat and dread go
+
+#include <io/vfs_index.h>
+#include <util/string_utils.h>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+struct Options {
+    int directories = 200;
+    int files = 100;
+    int rounds = 3;
+};
+
+// The cache of the lowercase full paths filled by walking the tree on the first lookup that missed
+struct LowercaseCache {
+    std::unordered_map<std::string, std::string> paths;
+
+    void fill(const fs::path &root) {
+        for (const auto &file : fs::recursive_directory_iterator(root))
+            paths.emplace(string_utils::tolower(file.path().string()), file.path().string());
+    }
+
+    bool resolve(const fs::path &path, fs::path &host_path) {
+        if (fs::exists(path)) {
+            host_path = path;
+            return true;
+        }
+        const auto found = paths.find(string_utils::tolower(path.string()));
+        if (found == paths.end())
+            return false;
+        host_path = found->second;
+        return true;
+    }
+
+    bool stat(const fs::path &path, vfs::HostStat &stat) {
+        fs::path host_path;
+        return resolve(path, host_path) && vfs::read_host_stat(host_path, stat) && (fs::is_regular_file(host_path) || fs::is_directory(host_path));
+    }
+};
+
+double seconds_since(clock::time_point start) {
+    return std::chrono::duration<double>(clock::now() - start).count();
+}
+
+template <typename Walk, typename Resolve, typename Stat>
+void run(const char *name, const Options &options, const std::vector<fs::path> &paths, Walk walk, Resolve resolve, Stat stat) {
+    const auto start = clock::now();
+    walk();
+    const double walk_ms = seconds_since(start) * 1000;
+
+    size_t found = 0;
+    auto lookup_start = clock::now();
+    for (int round = 0; round < options.rounds; round++) {
+        for (const fs::path &path : paths) {
+            fs::path host_path;
+            found += resolve(path, host_path);
+        }
+    }
+    const double lookup_us = seconds_since(lookup_start) * 1000000 / (paths.size() * options.rounds);
+
+    auto stat_start = clock::now();
+    for (int round = 0; round < options.rounds; round++) {
+        for (const fs::path &path : paths) {
+            vfs::HostStat host_stat;
+            found += stat(path, host_stat);
+        }
+    }
+    const double stat_us = seconds_since(stat_start) * 1000000 / (paths.size() * options.rounds);
+
+    if (found != paths.size() * options.rounds * 2)
+        fmt::print("{} only found {} of the paths\n", name, found / 2 / options.rounds);
+    fmt::print("{:<10} {:>12.2f} {:>12.3f} {:>12.3f}\n", name, walk_ms, lookup_us, stat_us);
+}
+
+void print_usage() {
+    fmt::print("Usage: io-benchmark [--directories N] [--files N] [--rounds N]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--directories" && i + 1 < argc) {
+            options.directories = std::stoi(argv[++i]);
+        } else if (arg == "--files" && i + 1 < argc) {
+            options.files = std::stoi(argv[++i]);
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            options.rounds = std::stoi(argv[++i]);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    const fs::path root = fs::temp_directory_path() / fs::unique_path("vita3k-io-benchmark-%%%%-%%%%");
+    // the files are named in uppercase on the host and looked up in lowercase like the games do
+    std::vector<fs::path> paths;
+    for (int d = 0; d < options.directories; d++) {
+        const std::string directory = fmt::format("DATA/LEVEL{:04}", d);
+        fs::create_directories(root / directory);
+        for (int f = 0; f < options.files; f++) {
+            std::ofstream((root / fmt::format("{}/ASSET{:04}.BIN", directory, f)).string());
+            paths.push_back(root / string_utils::tolower(fmt::format("{}/ASSET{:04}.BIN", directory, f)));
+        }
+    }
+
+    fmt::print("{} files, {} rounds, ms for the first lookup, us per lookup and per stat\n", paths.size(), options.rounds);
+    fmt::print("{:<10} {:>12} {:>12} {:>12}\n", "resolver", "walk", "lookup", "stat");
+
+    LowercaseCache cache;
+    run(
+        "lowercase", options, paths, [&] { cache.fill(root); },
+        [&](const fs::path &path, fs::path &host_path) { return cache.resolve(path, host_path); },
+        [&](const fs::path &path, vfs::HostStat &stat) { return cache.stat(path, stat); });
+
+    vfs::PathIndex index;
+    run(
+        "index", options, paths, [&] { index.add_mount(root); },
+        [&](const fs::path &path, fs::path &host_path) { return index.resolve(path, host_path); },
+        [&](const fs::path &path, vfs::HostStat &stat) { return index.stat(path, stat); });
+
+    boost::system::error_code error;
+    fs::remove_all(root, error);
+    return 0;
+}
@@ -37,8 +37,9 @@ void init_device_paths(IOState &io);
 bool init_savedata_app_path(IOState &io, const fs::path &pref_path);
 bool init(IOState &io, const fs::path &cache_path, const fs::path &log_path, const fs::path &pref_path, bool redirect_stdio);
 
-bool find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &translated_path, const fs::path &system_path);
-fs::path find_in_cache(IOState &io, const std::string &system_path);
+// Whether the host path of a guest path exists, with its stat when asked for. On a case sensitive host the paths under app0,
+// addcont0 and vs0 are looked up case insensitively in their index, the path is then changed to its host spelling
+bool find_host_path(IOState &io, VitaIoDevice guest_device, const fs::path &pref_path, fs::path &system_path, vfs::HostStat *stat = nullptr);
 
 fs::path expand_path(IOState &io, const char *path, const fs::path &pref_path);
 std::string translate_path(const char *path, VitaIoDevice &device, const IOState::DevicePaths &device_paths);
@@ -68,8 +69,8 @@ bool copy_path(const fs::path &src_path, const fs::path &pref_path, const std::s
 
 SceUID open_file(IOState &io, const char *path, const int flags, const fs::path &pref_path, const char *export_name);
 int read_file(void *data, IOState &io, SceUID fd, SceSize size, const char *export_name);
-int write_file(SceUID fd, const void *data, SceSize size, const IOState &io, const char *export_name);
-int truncate_file(SceUID fd, unsigned long long length, const IOState &io, const char *export_name);
+int write_file(SceUID fd, const void *data, SceSize size, IOState &io, const char *export_name);
+int truncate_file(SceUID fd, unsigned long long length, IOState &io, const char *export_name);
 SceOff seek_file(SceUID fd, SceOff offset, SceIoSeekMode whence, IOState &io, const char *export_name);
 SceOff tell_file(IOState &io, const SceUID fd, const char *export_name);
 int stat_file(IOState &io, const char *file, SceIoStat *statp, const fs::path &pref_path, const char *export_name, SceUID fd = invalid_fd);
@@ -20,6 +20,8 @@
 #include <io/filesystem.h>
 #include <io/types.h>
 #include <io/util.h>
+#include <io/vfs_index.h>
+#include <io/write_behind.h>
 
 #include <map>
 #include <unordered_map>
@@ -121,8 +123,11 @@ struct IOState {
     StdFiles std_files;
     DirEntries dir_entries;
 
-    std::unordered_map<std::string, std::string> cachemap;
+    // app0, addcont0 and vs0 are looked up in it when the host filesystem is case sensitive
+    vfs::PathIndex path_index;
     bool case_isens_find_enabled = false;
+    // savedata and trophy progress, waited for before the files it writes are accessed
+    vfs::WriteBehind write_behind;
 
     std::mutex overlay_mutex;
     SceUID next_overlay_id = 1;
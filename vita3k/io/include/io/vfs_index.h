@@ -0,0 +1,117 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace vfs {
+
+struct HostStat {
+    bool is_directory = false;
+    bool is_regular_file = false;
+    uint64_t size = 0;
+    // in seconds since the epoch
+    int64_t access_time = 0;
+    int64_t modification_time = 0;
+    int64_t creation_time = 0;
+};
+
+bool read_host_stat(const fs::path &path, HostStat &stat);
+
+// Resolves guest paths under the indexed mounts on a case sensitive host without touching the host filesystem.
+// The mounts are kept as a trie of case-folded names, each name stored only once, along with the stat of the
+// files, read the first time it is asked for. A directory is listed the first time a lookup goes through it.
+// The guest file operations report what they create, change and remove so that the index stays coherent with the host.
+class PathIndex {
+public:
+    // The directory must exist, it is only listed once a path under it is looked up
+    bool add_mount(const fs::path &root);
+    // Whether the path is under one of the mounts, looking it up then does not need the host filesystem
+    bool is_indexed(const fs::path &path);
+
+    // The host spelling of a path under a mount matched case insensitively, with its stat when asked for.
+    // A path that is not in the index is looked for on the host as it is spelled, and added when it exists
+    bool resolve(const fs::path &path, fs::path &host_path, HostStat *stat = nullptr);
+    // The stat of a host path, cached for the paths under a mount
+    bool stat(const fs::path &host_path, HostStat &stat);
+
+    // The host path was created
+    void created(const fs::path &host_path);
+    // The contents of the file were modified, its stat is read again next time
+    void changed(const fs::path &host_path);
+    void removed(const fs::path &host_path);
+
+    void clear();
+
+    // Number of paths indexed, the roots of the mounts included
+    size_t size();
+
+private:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    struct Node {
+        // host spelling of the name, the full host path for the root of a mount
+        std::string name;
+        uint32_t parent = NO_NODE;
+        bool is_directory = false;
+        // whether the children of the directory were read from the host
+        bool is_listed = false;
+        bool has_stat = false;
+        HostStat stat;
+    };
+
+    struct Mount {
+        std::string root;
+        uint32_t node;
+    };
+
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    const Mount *find_mount(std::string_view path) const;
+    uint32_t find_child(uint32_t parent, std::string_view name);
+    uint32_t add_child(uint32_t parent, std::string_view name, bool is_directory);
+    uint32_t lookup(const Mount &mount, std::string_view path);
+    uint32_t insert(const Mount &mount, std::string_view path);
+    void list_directory(uint32_t node);
+    std::string host_path_of(uint32_t node) const;
+    bool node_stat(uint32_t node, HostStat &stat);
+
+    std::mutex mutex;
+    std::vector<Mount> mounts;
+    std::vector<Node> nodes;
+    // case-folded names, interned so that the edges only store their id
+    std::unordered_map<std::string, uint32_t, NameHash, std::equal_to<>> names;
+    // parent node and folded name id to child node
+    std::unordered_map<uint64_t, uint32_t> children;
+    // buffer the names are folded in
+    std::string folded;
+};
+
+} // namespace vfs
@@ -0,0 +1,86 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vfs {
+
+// A change to a file, made over what it contains before
+struct FileUpdate {
+    uint64_t offset = 0;
+    std::vector<uint8_t> data;
+    // size the file is cut or extended to once the data is written, kept as it is when not set
+    std::optional<uint64_t> size;
+};
+
+// Commits file updates on a background thread so that the guest thread that made them does not wait on the disk.
+// A commit writes the new contents of the file to a temporary file next to it, flushes it to the disk and renames it
+// over the file, so that a crash at any point leaves either the old or the new contents. The updates of a file are
+// committed in the order they were made, the ones made while the file waits for the worker are merged in one commit.
+class WriteBehind {
+public:
+    WriteBehind() = default;
+    // Commits the pending updates
+    ~WriteBehind();
+    WriteBehind(const WriteBehind &) = delete;
+    WriteBehind &operator=(const WriteBehind &) = delete;
+
+    void update(const fs::path &path, FileUpdate update);
+    // Waits for the pending updates of the path, or of the paths under it for a directory, to be committed
+    void wait(const fs::path &path);
+    // Waits for every pending update to be committed
+    void flush();
+
+private:
+    struct File {
+        fs::path path;
+        // normalized path the pending updates are looked up with
+        std::string key;
+        std::vector<FileUpdate> updates;
+    };
+
+    void run();
+    bool is_pending(const std::string &path) const;
+
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable committed;
+    // in the order they were first updated in
+    std::deque<File> files;
+    // key of the file the worker is committing
+    std::string committing;
+    // files queued or being committed, so that waiting with nothing pending does not lock
+    std::atomic<uint32_t> outstanding = 0;
+    bool stop = false;
+    // started by the first update
+    std::thread worker;
+};
+
+} // namespace vfs
@@ -28,23 +28,11 @@
 #include <util/preprocessor.h>
 #include <util/string_utils.h>
 
-#ifdef _WIN32
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#else
-#include <sys/stat.h>
-#include <unistd.h>
-#endif
-
 #include <cassert>
 #include <iostream>
 #include <iterator>
 #include <string>
 
-#if defined(__aarch64__) && defined(__APPLE__)
-#define stat64 stat
-#endif
-
 // ****************************
 // * Utility functions *
 // ****************************
@@ -128,6 +116,7 @@ void init_device_paths(IOState &io) {
     io.device_paths.savedata0 = "user/" + io.user_id + "/savedata/" + io.savedata;
     io.device_paths.app0 = "app/" + io.app_path;
     io.device_paths.addcont0 = "addcont/" + io.addcont;
+    io.path_index.clear();
 }
 
 bool init_savedata_app_path(IOState &io, const fs::path &pref_path) {
@@ -142,49 +131,33 @@ bool init_savedata_app_path(IOState &io, const fs::path &pref_path) {
     return true;
 }
 
-bool find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &translated_path, const fs::path &system_path) {
-    std::string final_path{};
-
-    switch (device) {
-    case +VitaIoDevice::app0: {
-        std::string app_id = translated_path.string().substr(0, 14);
-        final_path = system_path.string().substr(0, system_path.string().find(app_id)) + app_id;
-        break;
-    }
-    case +VitaIoDevice::addcont0: {
-        std::string addcont_id = translated_path.string().substr(0, 18);
-        final_path = system_path.string().substr(0, system_path.string().find(addcont_id)) + addcont_id;
-        break;
-    }
-    case +VitaIoDevice::vs0: {
-        // This only works if ALL the parent folders of the path are the correct case or are in a case insensitive fs
-        // Only the file's name is searched for, not the parent folders
-        final_path = system_path.string().substr(0, system_path.string().find_last_of('/'));
-        break;
-    }
-    default: {
-        return false;
-    }
-    }
-
-    if (!fs::exists(final_path))
-        return false;
-
-    for (const auto &file : fs::recursive_directory_iterator(final_path)) {
-        io.cachemap.emplace(string_utils::tolower(file.path().string()), file.path().string());
+// The host directory of a guest device whose paths are indexed, empty when they are not
+static fs::path indexed_mount(const IOState &io, const VitaIoDevice guest_device, const fs::path &pref_path) {
+    switch (guest_device) {
+    case +VitaIoDevice::app0: return device::construct_emulated_path(VitaIoDevice::ux0, io.device_paths.app0, pref_path);
+    case +VitaIoDevice::addcont0: return device::construct_emulated_path(VitaIoDevice::ux0, io.device_paths.addcont0, pref_path);
+    case +VitaIoDevice::vs0: return device::construct_emulated_path(VitaIoDevice::vs0, "", pref_path);
+    default: return fs::path{};
     }
-
-    return true;
 }
 
-fs::path find_in_cache(IOState &io, const std::string &system_path) {
-    const auto find_path = io.cachemap.find(system_path);
+bool find_host_path(IOState &io, const VitaIoDevice guest_device, const fs::path &pref_path, fs::path &system_path, vfs::HostStat *stat) {
+    if (io.case_isens_find_enabled) {
+        const fs::path mount = indexed_mount(io, guest_device, pref_path);
+        if (!mount.empty() && io.path_index.add_mount(mount)) {
+            fs::path host_path;
+            if (!io.path_index.resolve(system_path, host_path, stat))
+                return false;
 
-    if (find_path != io.cachemap.end()) {
-        return fs::path{ find_path->second.c_str() };
-    } else {
-        return fs::path{};
+            LOG_TRACE_IF(host_path != system_path, "Found {} on case-sensitive filesystem at {}", system_path, host_path);
+            system_path = std::move(host_path);
+            return true;
+        }
     }
+
+    if (stat)
+        return vfs::read_host_stat(system_path, *stat);
+    return fs::exists(system_path);
 }
 
 std::string translate_path(const char *path, VitaIoDevice &device, const IOState::DevicePaths &device_paths) {
@@ -308,41 +281,25 @@ SceUID open_file(IOState &io, const char *path, const int flags, const fs::path
     }
 
     auto system_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
-    if (fs::is_directory(system_path)) {
-        LOG_ERROR("Cannot open directory: {}", system_path);
+    io.write_behind.wait(system_path);
+    vfs::HostStat host_stat;
+    if (find_host_path(io, device_for_icase, pref_path, system_path, &host_stat)) {
+        if (host_stat.is_directory) {
+            LOG_ERROR("Cannot open directory: {}", system_path);
+            return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+        }
+        if (can_write(flags))
+            io.path_index.changed(system_path);
+    } else if (!(flags & SCE_O_CREAT)) {
+        // Do not allow any new files if they do not have a write flag.
+        LOG_ERROR("Missing file at {} (target path: {})", system_path, path);
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-    }
-
-    // Do not allow any new files if they do not have a write flag.
-    if (!fs::exists(system_path)) {
-        if (!(flags & SCE_O_CREAT)) {
-            if (io.case_isens_find_enabled) {
-                // Attempt a case-insensitive file search.
-                const auto original_system_path = system_path;
-                const auto cached_path = find_in_cache(io, string_utils::tolower(system_path.string()));
-                if (!cached_path.empty()) {
-                    system_path = cached_path;
-                    LOG_TRACE("Found cached filepath at {}", system_path);
-                } else {
-                    const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, system_path);
-                    system_path = find_in_cache(io, string_utils::tolower(system_path.string()));
-                    if (!system_path.empty() && path_found) {
-                        LOG_TRACE("Found file on case-sensitive filesystem at {}", system_path);
-                    } else {
-                        LOG_ERROR("Missing file at {} (target path: {})", original_system_path, path);
-                        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                    }
-                }
-            } else {
-                LOG_ERROR("Missing file at {} (target path: {})", system_path, path);
-                return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-            }
-        } else {
-            if (!fs::exists(system_path.parent_path())) {
-                fs::create_directories(system_path.parent_path());
-            }
-            fs::ofstream file(system_path);
+    } else {
+        if (!fs::exists(system_path.parent_path())) {
+            fs::create_directories(system_path.parent_path());
         }
+        fs::ofstream file(system_path);
+        io.path_index.created(system_path);
     }
 
     const auto normalized_path = device::construct_normalized_path(device, translated_path);
@@ -379,7 +336,7 @@ int read_file(void *data, IOState &io, const SceUID fd, const SceSize size, cons
     return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 }
 
-int write_file(SceUID fd, const void *data, const SceSize size, const IOState &io, const char *export_name) {
+int write_file(SceUID fd, const void *data, const SceSize size, IOState &io, const char *export_name) {
     assert(data != nullptr);
     assert(size >= 0);
 
@@ -424,7 +381,7 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
     return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 }
 
-int truncate_file(const SceUID fd, unsigned long long length, const IOState &io, const char *export_name) {
+int truncate_file(const SceUID fd, unsigned long long length, IOState &io, const char *export_name) {
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
@@ -432,6 +389,7 @@ int truncate_file(const SceUID fd, unsigned long long length, const IOState &io,
     if (file == io.std_files.end())
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
     auto trunc = file->second.truncate(length);
+    io.path_index.changed(file->second.get_system_location());
     LOG_TRACE_IF(log_file_op, "{}: Truncating fd: {}, to size: {}", export_name, log_hex(fd), length);
     return trunc;
 }
@@ -476,12 +434,31 @@ SceOff tell_file(IOState &io, const SceUID fd, const char *export_name) {
     return std_file->second.tell();
 }
 
+static void fill_stat(const vfs::HostStat &host_stat, SceIoStat *statp) {
+    statp->st_mode = SCE_S_IRUSR | SCE_S_IRGRP | SCE_S_IROTH | SCE_S_IXUSR | SCE_S_IXGRP | SCE_S_IXOTH;
+
+    if (host_stat.is_regular_file) {
+        statp->st_size = host_stat.size;
+        statp->st_attr = SCE_SO_IFREG;
+        statp->st_mode |= SCE_S_IFREG;
+    }
+    if (host_stat.is_directory) {
+        statp->st_attr = SCE_SO_IFDIR;
+        statp->st_mode |= SCE_S_IFDIR;
+    }
+
+    __RtcTicksToPspTime(&statp->st_atime, (uint64_t)host_stat.access_time * VITA_CLOCKS_PER_SEC);
+    __RtcTicksToPspTime(&statp->st_mtime, (uint64_t)host_stat.modification_time * VITA_CLOCKS_PER_SEC);
+    __RtcTicksToPspTime(&statp->st_ctime, (uint64_t)host_stat.creation_time * VITA_CLOCKS_PER_SEC);
+}
+
 int stat_file(IOState &io, const char *file, SceIoStat *statp, const fs::path &pref_path, const char *export_name, const SceUID fd) {
     assert(statp != nullptr);
 
     memset(statp, '\0', sizeof(SceIoStat));
 
     fs::path file_path = "";
+    vfs::HostStat host_stat;
     if (fd == invalid_fd) {
         auto device = device::get_device(file);
         auto device_for_icase = device;
@@ -492,29 +469,11 @@ int stat_file(IOState &io, const char *file, SceIoStat *statp, const fs::path &p
 
         const auto translated_path = translate_path(file, device, io.device_paths);
         file_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
+        io.write_behind.wait(file_path);
 
-        if (!fs::exists(file_path)) {
-            if (io.case_isens_find_enabled) {
-                // Attempt a case-insensitive file search.
-                const auto original_file_path = file_path;
-                const auto cached_path = find_in_cache(io, string_utils::tolower(file_path.string()));
-                if (!cached_path.empty()) {
-                    file_path = cached_path;
-                    LOG_TRACE("Found cached filepath at {}", file_path);
-                } else {
-                    const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, file_path);
-                    file_path = find_in_cache(io, string_utils::tolower(file_path.string()));
-                    if (!file_path.empty() && path_found) {
-                        LOG_TRACE("Found file on case-sensitive filesystem at {}", file_path);
-                    } else {
-                        LOG_ERROR("Missing file at {} (target path: {})", original_file_path, file);
-                        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                    }
-                }
-            } else {
-                LOG_ERROR("Missing file at {} (target path: {})", file_path, file);
-                return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-            }
+        if (!find_host_path(io, device_for_icase, pref_path, file_path, &host_stat)) {
+            LOG_ERROR("Missing file at {} (target path: {})", file_path, file);
+            return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
         }
         LOG_TRACE_IF(log_file_op && log_file_stat, "{}: Statting file: {} ({})", export_name, file, device::construct_normalized_path(device, translated_path));
     } else { // We have previously opened and defined the location
@@ -526,47 +485,11 @@ int stat_file(IOState &io, const char *file, SceIoStat *statp, const fs::path &p
         LOG_TRACE_IF(log_file_op && log_file_stat, "{}: Statting fd: {}", export_name, log_hex(fd));
 
         statp->st_attr = fd_file->second.get_file_mode();
+        if (!vfs::read_host_stat(file_path, host_stat))
+            return IO_ERROR_UNK();
     }
 
-    std::uint64_t last_access_time_ticks;
-    std::uint64_t creation_time_ticks;
-    std::uint64_t last_modification_time_ticks;
-
-#ifdef _WIN32
-    struct _stati64 sb;
-    if (_wstati64(file_path.generic_path().wstring().c_str(), &sb) < 0)
-        return IO_ERROR_UNK();
-#else
-    struct stat64 sb;
-    if (stat64(file_path.generic_path().string().c_str(), &sb) < 0)
-        return IO_ERROR_UNK();
-#endif
-
-    last_access_time_ticks = (uint64_t)sb.st_atime * VITA_CLOCKS_PER_SEC;
-    creation_time_ticks = (uint64_t)sb.st_ctime * VITA_CLOCKS_PER_SEC;
-    last_modification_time_ticks = (uint64_t)sb.st_mtime * VITA_CLOCKS_PER_SEC;
-
-#ifndef _WIN32
-#undef st_atime
-#undef st_mtime
-#undef st_ctime
-#endif
-
-    statp->st_mode = SCE_S_IRUSR | SCE_S_IRGRP | SCE_S_IROTH | SCE_S_IXUSR | SCE_S_IXGRP | SCE_S_IXOTH;
-
-    if (fs::is_regular_file(file_path)) {
-        statp->st_size = fs::file_size(file_path);
-        statp->st_attr = SCE_SO_IFREG;
-        statp->st_mode |= SCE_S_IFREG;
-    }
-    if (fs::is_directory(file_path)) {
-        statp->st_attr = SCE_SO_IFDIR;
-        statp->st_mode |= SCE_S_IFDIR;
-    }
-
-    __RtcTicksToPspTime(&statp->st_atime, last_access_time_ticks);
-    __RtcTicksToPspTime(&statp->st_mtime, last_modification_time_ticks);
-    __RtcTicksToPspTime(&statp->st_ctime, creation_time_ticks);
+    fill_stat(host_stat, statp);
 
     return 0;
 }
@@ -590,7 +513,13 @@ int close_file(IOState &io, const SceUID fd, const char *export_name) {
     LOG_TRACE_IF(log_file_op, "{}: Closing file fd: {}", export_name, log_hex(fd));
 
     io.tty_files.erase(fd);
-    io.std_files.erase(fd);
+    // the stat cached while the file was written to is read again
+    const auto file = io.std_files.find(fd);
+    if (file != io.std_files.end()) {
+        if (file->second.can_write_file())
+            io.path_index.changed(file->second.get_system_location());
+        io.std_files.erase(file);
+    }
 
     return 0;
 }
@@ -609,6 +538,7 @@ int remove_file(IOState &io, const char *file, const fs::path &pref_path, const
     }
 
     const auto emulated_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
+    io.write_behind.wait(emulated_path);
     if (!fs::exists(emulated_path) || fs::is_directory(emulated_path)) {
         LOG_ERROR("File does not exist at path: {} (target path: {})", emulated_path, file);
     }
@@ -623,6 +553,7 @@ int remove_file(IOState &io, const char *file, const fs::path &pref_path, const
         LOG_ERROR("Error code: {} ({})", error_code.value(), error_code.message());
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
+    io.path_index.removed(emulated_path);
 
     return 0;
 }
@@ -647,12 +578,14 @@ int rename(IOState &io, const char *old_name, const char *new_name, const fs::pa
     }
 
     const auto emulated_old_path = device::construct_emulated_path(device, translated_old_path, pref_path, io.redirect_stdio);
+    io.write_behind.wait(emulated_old_path);
     if (!fs::exists(emulated_old_path)) {
         LOG_ERROR("File does not exist at path: {} (target path: {})", emulated_old_path, old_name);
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
 
     const auto emulated_new_path = device::construct_emulated_path(device, translated_new_path, pref_path, io.redirect_stdio);
+    io.write_behind.wait(emulated_new_path);
 
     LOG_TRACE_IF(log_file_op, "{}: Renaming file {} to {} ({} to {})", export_name, old_name, new_name, emulated_old_path, emulated_new_path);
 
@@ -664,6 +597,8 @@ int rename(IOState &io, const char *old_name, const char *new_name, const fs::pa
         LOG_ERROR("Error code: {} ({})", error_code.value(), error_code.message());
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
+    io.path_index.removed(emulated_old_path);
+    io.path_index.created(emulated_new_path);
 
     return 0;
 }
@@ -673,30 +608,13 @@ SceUID open_dir(IOState &io, const char *path, const fs::path &pref_path, const
     auto device_for_icase = device;
     const auto translated_path = translate_path(path, device, io.device_paths);
 
-    auto dir_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio) / "";
-    if (!fs::exists(dir_path)) {
-        if (io.case_isens_find_enabled) {
-            // Attempt a case-insensitive file search.
-            const auto original_dir_path = dir_path;
-            const auto cached_path = find_in_cache(io, string_utils::tolower(dir_path.string()));
-            if (!cached_path.empty()) {
-                dir_path = cached_path;
-                LOG_TRACE("Found cached directory path at {}", dir_path);
-            } else {
-                const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, dir_path);
-                dir_path = find_in_cache(io, string_utils::tolower(dir_path.string().substr(0, dir_path.string().size() - 1)));
-                if (!dir_path.empty() && path_found) {
-                    LOG_TRACE("Found directory on case-sensitive filesystem at {}", dir_path);
-                } else {
-                    LOG_ERROR("Directory does not exist at {} (target path: {})", original_dir_path, path);
-                    return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                }
-            }
-        } else {
-            LOG_ERROR("Directory does not exist at: {} (target path: {})", dir_path, path);
-            return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-        }
+    auto dir_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
+    io.write_behind.wait(dir_path);
+    if (!find_host_path(io, device_for_icase, pref_path, dir_path)) {
+        LOG_ERROR("Directory does not exist at: {} (target path: {})", dir_path, path);
+        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
+    dir_path /= "";
 
     const DirPtr opened = create_shared_dir(dir_path);
     if (!opened) {
@@ -735,13 +653,16 @@ SceUID read_dir(IOState &io, const SceUID fd, SceIoDirent *dent, const fs::path
 
         const auto cur_path = dir->second.get_system_location() / d_name_utf8;
         if (!(cur_path.filename_is_dot() || cur_path.filename_is_dot_dot())) {
-            const auto file_path = std::string(dir->second.get_vita_loc()) + '/' + d_name_utf8;
+            LOG_TRACE_IF(log_file_op, "{}: Reading entry {}/{} of fd: {}", export_name, dir->second.get_vita_loc(), d_name_utf8, log_hex(fd));
 
-            LOG_TRACE_IF(log_file_op, "{}: Reading entry {} of fd: {}", export_name, file_path, log_hex(fd));
-            if (stat_file(io, file_path.c_str(), &dent->d_stat, pref_path, export_name) < 0)
+            // the entry has the host spelling already, its stat is cached when the directory is indexed
+            vfs::HostStat host_stat;
+            if (!io.path_index.stat(cur_path, host_stat))
                 return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
-            else
-                return 1; // move to the next file
+
+            memset(&dent->d_stat, '\0', sizeof(SceIoStat));
+            fill_stat(host_stat, &dent->d_stat);
+            return 1; // move to the next file
         }
         return read_dir(io, fd, dent, pref_path, export_name);
     }
@@ -795,8 +716,11 @@ int create_dir(IOState &io, const char *dir, int mode, const fs::path &pref_path
     }
 
     const auto emulated_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
-    if (recursive)
-        return fs::create_directories(emulated_path);
+    if (recursive) {
+        const bool created = fs::create_directories(emulated_path);
+        io.path_index.created(emulated_path);
+        return created;
+    }
     if (fs::exists(emulated_path))
         return IO_ERROR(SCE_ERROR_ERRNO_EEXIST);
 
@@ -810,6 +734,7 @@ int create_dir(IOState &io, const char *dir, int mode, const fs::path &pref_path
         LOG_ERROR("Failed to create directory at {} (target path: {})", emulated_path, dir);
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
+    io.path_index.created(emulated_path);
 
     return 0;
 }
@@ -843,10 +768,13 @@ int remove_dir(IOState &io, const char *dir, const fs::path &pref_path, const ch
 
     LOG_TRACE_IF(log_file_op, "{}: Removing dir {} ({})", export_name, dir, device::construct_normalized_path(device, translated_path));
 
-    if (!fs::remove_all(device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio))) {
+    const auto emulated_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
+    io.write_behind.wait(emulated_path);
+    if (!fs::remove_all(emulated_path)) {
         LOG_ERROR("Cannot remove dir: {} ({})", dir, device::construct_normalized_path(device, translated_path));
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
+    io.path_index.removed(emulated_path);
 
     return 0;
 }
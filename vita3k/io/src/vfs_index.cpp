@@ -0,0 +1,300 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/vfs_index.h>
+
+#include <util/log.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <utility>
+
+#if defined(__aarch64__) && defined(__APPLE__)
+#define stat64 stat
+#endif
+
+namespace vfs {
+
+bool read_host_stat(const fs::path &path, HostStat &stat) {
+#ifdef _WIN32
+    struct _stati64 sb;
+    if (_wstati64(path.generic_path().wstring().c_str(), &sb) < 0)
+        return false;
+    stat.is_directory = sb.st_mode & _S_IFDIR;
+    stat.is_regular_file = sb.st_mode & _S_IFREG;
+#else
+    struct stat64 sb;
+    if (stat64(path.generic_path().string().c_str(), &sb) < 0)
+        return false;
+    stat.is_directory = S_ISDIR(sb.st_mode);
+    stat.is_regular_file = S_ISREG(sb.st_mode);
+#endif
+
+    stat.size = stat.is_regular_file ? sb.st_size : 0;
+    stat.access_time = sb.st_atime;
+    stat.modification_time = sb.st_mtime;
+    stat.creation_time = sb.st_ctime;
+    return true;
+}
+
+static std::string to_key(const fs::path &path) {
+    std::string key = fs_utils::path_to_utf8(path.generic_path());
+    while (key.size() > 1 && key.back() == '/')
+        key.pop_back();
+    return key;
+}
+
+static void fold(std::string_view name, std::string &out) {
+    out.assign(name);
+    for (char &c : out) {
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+    }
+}
+
+// Calls the function with every name of the path in order, stops at the first one it returns false for
+template <typename F>
+static bool for_each_name(std::string_view path, F &&f) {
+    size_t start = 0;
+    while (start < path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string_view::npos)
+            end = path.size();
+        const std::string_view name = path.substr(start, end - start);
+        start = end + 1;
+        if (name.empty() || name == ".")
+            continue;
+        if (!f(name, start >= path.size()))
+            return false;
+    }
+    return true;
+}
+
+const PathIndex::Mount *PathIndex::find_mount(std::string_view path) const {
+    for (const Mount &mount : mounts) {
+        if (path.starts_with(mount.root) && (path.size() == mount.root.size() || path[mount.root.size()] == '/'))
+            return &mount;
+    }
+    return nullptr;
+}
+
+uint32_t PathIndex::find_child(uint32_t parent, std::string_view name) {
+    if (!nodes[parent].is_listed)
+        list_directory(parent);
+
+    fold(name, folded);
+    const auto id = names.find(std::string_view(folded));
+    if (id == names.end())
+        return NO_NODE;
+
+    const auto child = children.find((uint64_t(parent) << 32) | id->second);
+    return child == children.end() ? NO_NODE : child->second;
+}
+
+uint32_t PathIndex::add_child(uint32_t parent, std::string_view name, bool is_directory) {
+    fold(name, folded);
+    const uint32_t id = names.try_emplace(folded, static_cast<uint32_t>(names.size())).first->second;
+    const auto [child, inserted] = children.try_emplace((uint64_t(parent) << 32) | id, static_cast<uint32_t>(nodes.size()));
+    if (inserted) {
+        Node node;
+        node.name = name;
+        node.parent = parent;
+        node.is_directory = is_directory;
+        nodes.push_back(std::move(node));
+    }
+    return child->second;
+}
+
+uint32_t PathIndex::lookup(const Mount &mount, std::string_view path) {
+    uint32_t node = mount.node;
+    const bool found = for_each_name(path.substr(mount.root.size()), [&](std::string_view name, bool) {
+        node = name == ".." ? NO_NODE : find_child(node, name);
+        return node != NO_NODE;
+    });
+    return found ? node : NO_NODE;
+}
+
+uint32_t PathIndex::insert(const Mount &mount, std::string_view path) {
+    uint32_t node = mount.node;
+    std::string host_path = mount.root;
+    const bool inserted = for_each_name(path.substr(mount.root.size()), [&](std::string_view name, bool last) {
+        if (name == "..")
+            return false;
+
+        host_path += '/';
+        const uint32_t child = find_child(node, name);
+        if (child != NO_NODE) {
+            // the path may differ in case from the one in the index, the host spelling is kept
+            host_path += nodes[child].name;
+            node = child;
+            return true;
+        }
+
+        host_path += name;
+        const bool is_directory = !last || fs::is_directory(fs_utils::utf8_to_path(host_path));
+        node = add_child(node, name, is_directory);
+        return true;
+    });
+    if (!inserted)
+        return NO_NODE;
+
+    nodes[node].has_stat = false;
+    if (nodes[node].parent != NO_NODE)
+        nodes[nodes[node].parent].has_stat = false;
+    return node;
+}
+
+void PathIndex::list_directory(uint32_t node) {
+    // a file has no children to list
+    nodes[node].is_listed = true;
+    if (!nodes[node].is_directory)
+        return;
+
+    boost::system::error_code error;
+    for (fs::directory_iterator it(fs_utils::utf8_to_path(host_path_of(node)), error), end; !error && it != end; it.increment(error)) {
+        boost::system::error_code status_error;
+        const bool is_directory = fs::is_directory(it->status(status_error));
+        add_child(node, fs_utils::path_to_utf8(it->path().filename()), is_directory);
+    }
+}
+
+std::string PathIndex::host_path_of(uint32_t node) const {
+    std::vector<uint32_t> path;
+    for (; nodes[node].parent != NO_NODE; node = nodes[node].parent)
+        path.push_back(node);
+
+    std::string host_path = nodes[node].name;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        host_path += '/';
+        host_path += nodes[*it].name;
+    }
+    return host_path;
+}
+
+bool PathIndex::node_stat(uint32_t node, HostStat &stat) {
+    if (!nodes[node].has_stat) {
+        if (!read_host_stat(fs_utils::utf8_to_path(host_path_of(node)), nodes[node].stat))
+            return false;
+        nodes[node].has_stat = true;
+    }
+    stat = nodes[node].stat;
+    return true;
+}
+
+bool PathIndex::add_mount(const fs::path &root) {
+    const std::string key = to_key(root);
+    const std::lock_guard<std::mutex> lock(mutex);
+    for (const Mount &mount : mounts) {
+        if (mount.root == key)
+            return true;
+    }
+    if (!fs::is_directory(root))
+        return false;
+
+    Node node;
+    node.name = key;
+    node.is_directory = true;
+    mounts.push_back(Mount{ key, static_cast<uint32_t>(nodes.size()) });
+    nodes.push_back(std::move(node));
+    return true;
+}
+
+bool PathIndex::is_indexed(const fs::path &path) {
+    const std::string key = to_key(path);
+    const std::lock_guard<std::mutex> lock(mutex);
+    return find_mount(key) != nullptr;
+}
+
+bool PathIndex::resolve(const fs::path &path, fs::path &host_path, HostStat *stat) {
+    const std::string key = to_key(path);
+    const std::lock_guard<std::mutex> lock(mutex);
+    const Mount *mount = find_mount(key);
+    uint32_t node = mount ? lookup(*mount, key) : NO_NODE;
+    if (node == NO_NODE) {
+        // created outside of the guest since the mount was indexed, or not under a mount
+        if (!fs::exists(path))
+            return false;
+        if (mount)
+            node = insert(*mount, key);
+        if (node == NO_NODE) {
+            host_path = path;
+            return !stat || read_host_stat(path, *stat);
+        }
+    }
+
+    host_path = fs_utils::utf8_to_path(host_path_of(node));
+    return !stat || node_stat(node, *stat);
+}
+
+bool PathIndex::stat(const fs::path &host_path, HostStat &stat) {
+    const std::string key = to_key(host_path);
+    const std::lock_guard<std::mutex> lock(mutex);
+    const Mount *mount = find_mount(key);
+    const uint32_t node = mount ? lookup(*mount, key) : NO_NODE;
+    if (node == NO_NODE)
+        return read_host_stat(host_path, stat);
+
+    return node_stat(node, stat);
+}
+
+void PathIndex::created(const fs::path &host_path) {
+    const std::string key = to_key(host_path);
+    const std::lock_guard<std::mutex> lock(mutex);
+    const Mount *mount = find_mount(key);
+    if (mount)
+        insert(*mount, key);
+}
+
+void PathIndex::changed(const fs::path &host_path) {
+    const std::string key = to_key(host_path);
+    const std::lock_guard<std::mutex> lock(mutex);
+    const Mount *mount = find_mount(key);
+    const uint32_t node = mount ? lookup(*mount, key) : NO_NODE;
+    if (node != NO_NODE)
+        nodes[node].has_stat = false;
+}
+
+void PathIndex::removed(const fs::path &host_path) {
+    const std::string key = to_key(host_path);
+    const std::lock_guard<std::mutex> lock(mutex);
+    const Mount *mount = find_mount(key);
+    const uint32_t node = mount ? lookup(*mount, key) : NO_NODE;
+    if (node == NO_NODE || nodes[node].parent == NO_NODE)
+        return;
+
+    // the node and the ones under it are only unlinked, they are dropped with the whole index
+    const uint32_t parent = nodes[node].parent;
+    fold(nodes[node].name, folded);
+    children.erase((uint64_t(parent) << 32) | names.find(std::string_view(folded))->second);
+    nodes[parent].has_stat = false;
+}
+
+void PathIndex::clear() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    mounts.clear();
+    nodes.clear();
+    names.clear();
+    children.clear();
+}
+
+size_t PathIndex::size() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return nodes.size();
+}
+
+} // namespace vfs
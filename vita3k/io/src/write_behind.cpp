@@ -0,0 +1,185 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/write_behind.h>
+
+#include <util/log.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vfs {
+
+static std::string to_key(const fs::path &path) {
+    std::string key = fs_utils::path_to_utf8(path.lexically_normal());
+    std::replace(key.begin(), key.end(), '\\', '/');
+    while (key.size() > 1 && key.back() == '/')
+        key.pop_back();
+    return key;
+}
+
+static bool flush_to_disk(FILE *file) {
+    if (fflush(file) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Makes the rename of a file in the directory survive a power loss, Windows does not open directories
+static void flush_dir_to_disk(const fs::path &dir) {
+#ifndef _WIN32
+    const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+static bool commit(const fs::path &path, const std::vector<FileUpdate> &updates) {
+    std::vector<uint8_t> contents;
+    // the file was not created yet when this fails
+    fs_utils::read_data(path, contents);
+    for (const FileUpdate &update : updates) {
+        const uint64_t end = update.offset + update.data.size();
+        if (end > contents.size())
+            contents.resize(end);
+        std::copy(update.data.begin(), update.data.end(), contents.begin() + update.offset);
+        if (update.size)
+            contents.resize(*update.size);
+    }
+
+    boost::system::error_code error;
+    fs::create_directories(path.parent_path(), error);
+
+    const fs::path temp_path = fs_utils::path_concat(path, ".tmp");
+    FILE *file = FOPEN(temp_path.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR("Failed to create {}: {}", temp_path, strerror(errno));
+        return false;
+    }
+    const bool written = (contents.empty() || fwrite(contents.data(), contents.size(), 1, file) == 1) && flush_to_disk(file);
+    fclose(file);
+    if (!written) {
+        LOG_ERROR("Failed to write {}: {}", temp_path, strerror(errno));
+        fs::remove(temp_path, error);
+        return false;
+    }
+
+    fs::rename(temp_path, path, error);
+    if (error) {
+        LOG_ERROR("Failed to replace {}: {}", path, error.message());
+        fs::remove(temp_path, error);
+        return false;
+    }
+    flush_dir_to_disk(path.parent_path());
+
+    return true;
+}
+
+WriteBehind::~WriteBehind() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    queued.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+void WriteBehind::update(const fs::path &path, FileUpdate update) {
+    std::string key = to_key(path);
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        // merged with the queued updates of the file, the ones being committed are already out of the queue
+        const auto it = std::find_if(files.begin(), files.end(), [&](const File &file) { return file.key == key; });
+        if (it != files.end()) {
+            it->updates.push_back(std::move(update));
+        } else {
+            files.push_back({ path, std::move(key), {} });
+            files.back().updates.push_back(std::move(update));
+            outstanding++;
+        }
+
+        if (!worker.joinable())
+            worker = std::thread([this] { run(); });
+    }
+    queued.notify_one();
+}
+
+bool WriteBehind::is_pending(const std::string &path) const {
+    const auto is_under = [&](const std::string &key) {
+        return key.size() >= path.size() && key.compare(0, path.size(), path) == 0
+            && (key.size() == path.size() || key[path.size()] == '/' || path.back() == '/');
+    };
+    if (!committing.empty() && is_under(committing))
+        return true;
+
+    return std::any_of(files.begin(), files.end(), [&](const File &file) { return is_under(file.key); });
+}
+
+void WriteBehind::wait(const fs::path &path) {
+    if (outstanding == 0)
+        return;
+
+    const std::string key = to_key(path);
+    std::unique_lock<std::mutex> lock(mutex);
+    committed.wait(lock, [&] { return !is_pending(key); });
+}
+
+void WriteBehind::flush() {
+    if (outstanding == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    committed.wait(lock, [&] { return files.empty() && committing.empty(); });
+}
+
+void WriteBehind::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // the pending updates are committed before stopping
+        queued.wait(lock, [&] { return stop || !files.empty(); });
+        if (files.empty())
+            return;
+
+        File file = std::move(files.front());
+        files.pop_front();
+        committing = file.key;
+        lock.unlock();
+
+        commit(file.path, file.updates);
+
+        lock.lock();
+        committing.clear();
+        outstanding--;
+        committed.notify_all();
+    }
+}
+
+} // namespace vfs
@@ -0,0 +1,175 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/vfs_index.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+
+namespace {
+
+// A directory tree in a temporary directory, indexed as a mount
+class path_index : public testing::Test {
+protected:
+    void SetUp() override {
+        root = fs::temp_directory_path() / fs::unique_path("vita3k-index-%%%%-%%%%");
+        create_file("Data/Sub/File.TXT", "contents");
+        create_file("Data/other.bin", "1234");
+        create_file("eboot.bin", "");
+        fs::create_directories(root / "Empty");
+        ASSERT_TRUE(index.add_mount(root));
+    }
+
+    void TearDown() override {
+        boost::system::error_code error;
+        fs::remove_all(root, error);
+    }
+
+    void create_file(const std::string &path, const std::string &contents) {
+        fs::create_directories((root / path).parent_path());
+        std::ofstream(fs::path(root / path).string(), std::ios::binary) << contents;
+    }
+
+    fs::path resolve(const std::string &path) {
+        fs::path host_path;
+        if (!index.resolve(root / path, host_path))
+            return fs::path{};
+        return host_path;
+    }
+
+    fs::path root;
+    vfs::PathIndex index;
+};
+
+} // namespace
+
+TEST_F(path_index, resolves_any_case) {
+    EXPECT_EQ(resolve("data/sub/file.txt"), root / "Data/Sub/File.TXT");
+    EXPECT_EQ(resolve("DATA/SUB/FILE.txt"), root / "Data/Sub/File.TXT");
+    EXPECT_EQ(resolve("Data/Sub/File.TXT"), root / "Data/Sub/File.TXT");
+    EXPECT_EQ(resolve("data/./sub//file.txt/"), root / "Data/Sub/File.TXT");
+    EXPECT_EQ(resolve("empty"), root / "Empty");
+    EXPECT_EQ(resolve(""), root);
+
+    EXPECT_TRUE(resolve("data/sub/missing.txt").empty());
+    EXPECT_TRUE(resolve("data/file.txt").empty());
+    EXPECT_TRUE(index.is_indexed(root / "anything"));
+    EXPECT_FALSE(index.is_indexed(fs::path(root.string() + "-other") / "data"));
+}
+
+TEST_F(path_index, caches_stat) {
+    fs::path host_path;
+    vfs::HostStat stat;
+    ASSERT_TRUE(index.resolve(root / "data/sub/file.txt", host_path, &stat));
+    EXPECT_TRUE(stat.is_regular_file);
+    EXPECT_FALSE(stat.is_directory);
+    EXPECT_EQ(stat.size, 8u);
+
+    ASSERT_TRUE(index.stat(root / "Data", stat));
+    EXPECT_TRUE(stat.is_directory);
+    EXPECT_EQ(stat.size, 0u);
+
+    // only read again once the change is reported
+    create_file("Data/Sub/File.TXT", "longer contents");
+    ASSERT_TRUE(index.stat(root / "data/sub/file.txt", stat));
+    EXPECT_EQ(stat.size, 8u);
+    index.changed(root / "Data/Sub/File.TXT");
+    ASSERT_TRUE(index.stat(root / "data/sub/file.txt", stat));
+    EXPECT_EQ(stat.size, 15u);
+}
+
+TEST_F(path_index, follows_guest_changes) {
+    create_file("Data/New/Created.dat", "x");
+    index.created(root / "Data/New/Created.dat");
+    EXPECT_EQ(resolve("data/new/created.DAT"), root / "Data/New/Created.dat");
+
+    fs::rename(root / "Data/Sub", root / "Data/Moved");
+    index.removed(root / "Data/Sub");
+    index.created(root / "Data/Moved");
+    EXPECT_TRUE(resolve("data/sub/file.txt").empty());
+    EXPECT_EQ(resolve("data/moved/FILE.TXT"), root / "Data/Moved/File.TXT");
+
+    fs::remove_all(root / "Data");
+    index.removed(root / "Data");
+    EXPECT_TRUE(resolve("data/other.bin").empty());
+    EXPECT_TRUE(resolve("data/moved/file.txt").empty());
+
+    create_file("data/recreated", "");
+    index.created(root / "data/recreated");
+    EXPECT_EQ(resolve("Data/Recreated"), root / "data/recreated");
+}
+
+TEST_F(path_index, finds_paths_created_on_the_host) {
+    // once the directory is listed
+    EXPECT_EQ(resolve("data/other.bin"), root / "Data/other.bin");
+    create_file("Data/Late/Added.txt", "");
+    // only found as it is spelled until then
+    EXPECT_TRUE(resolve("data/late/added.txt").empty());
+    EXPECT_EQ(resolve("Data/Late/Added.txt"), root / "Data/Late/Added.txt");
+    EXPECT_EQ(resolve("data/late/added.txt"), root / "Data/Late/Added.txt");
+}
+
+TEST_F(path_index, leaves_parent_references_to_the_host) {
+    EXPECT_EQ(resolve("Data/../eboot.bin"), root / "Data/../eboot.bin");
+    EXPECT_TRUE(resolve("data/../eboot.bin").empty());
+    const size_t size = index.size();
+    resolve("Data/../eboot.bin");
+    EXPECT_EQ(index.size(), size);
+}
+
+TEST_F(path_index, stats_paths_outside_of_the_mounts) {
+    const fs::path outside = fs::path(root.string() + "-outside");
+    std::ofstream(outside.string(), std::ios::binary) << "abc";
+
+    vfs::HostStat stat;
+    EXPECT_TRUE(index.stat(outside, stat));
+    EXPECT_EQ(stat.size, 3u);
+    fs::path host_path;
+    EXPECT_TRUE(index.resolve(outside, host_path));
+    EXPECT_EQ(host_path, outside);
+
+    fs::remove(outside);
+    EXPECT_FALSE(index.stat(outside, stat));
+}
+
+TEST_F(path_index, clear_forgets_the_mounts) {
+    index.clear();
+    EXPECT_EQ(index.size(), 0u);
+    EXPECT_FALSE(index.is_indexed(root / "Data"));
+    EXPECT_FALSE(index.add_mount(root / "missing"));
+    EXPECT_TRUE(index.add_mount(root));
+    EXPECT_EQ(index.size(), 1u);
+}
+
+TEST_F(path_index, lists_the_directories_looked_up_only) {
+    EXPECT_EQ(index.size(), 1u);
+    EXPECT_EQ(resolve("empty"), root / "Empty");
+    // the root and its three entries
+    EXPECT_EQ(index.size(), 4u);
+    EXPECT_TRUE(resolve("empty/missing").empty());
+    EXPECT_EQ(index.size(), 4u);
+
+    // created on the host before the directory is listed
+    create_file("Data/Late.txt", "");
+    EXPECT_EQ(resolve("data/late.TXT"), root / "Data/Late.txt");
+    // other.bin, Sub and Late.txt
+    EXPECT_EQ(index.size(), 7u);
+    EXPECT_EQ(resolve("data/sub/file.txt"), root / "Data/Sub/File.TXT");
+    EXPECT_EQ(index.size(), 8u);
+}
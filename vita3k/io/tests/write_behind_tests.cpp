@@ -0,0 +1,168 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/write_behind.h>
+
+#include <util/fs.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+class write_behind : public testing::Test {
+protected:
+    void SetUp() override {
+        root = fs::temp_directory_path() / fs::unique_path("vita3k-write-behind-%%%%-%%%%");
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        boost::system::error_code error;
+        fs::remove_all(root, error);
+    }
+
+    std::string read(const fs::path &path) {
+        std::vector<char> data;
+        if (!fs_utils::read_data(path, data))
+            return "<missing>";
+        return std::string(data.begin(), data.end());
+    }
+
+    fs::path root;
+};
+
+vfs::FileUpdate update(uint64_t offset, const std::string &data, std::optional<uint64_t> size = std::nullopt) {
+    return { offset, std::vector<uint8_t>(data.begin(), data.end()), size };
+}
+
+} // namespace
+
+TEST_F(write_behind, commits_updates_over_the_file) {
+    vfs::WriteBehind writer;
+    const fs::path file = root / "save/data.bin";
+
+    writer.update(file, update(0, "hello"));
+    writer.wait(file);
+    EXPECT_EQ(read(file), "hello");
+
+    writer.update(file, update(2, "XY"));
+    writer.wait(file);
+    EXPECT_EQ(read(file), "heXYo");
+
+    writer.update(file, update(1, "ab", 3));
+    writer.wait(file);
+    EXPECT_EQ(read(file), "hab");
+
+    writer.update(file, update(5, "z"));
+    writer.wait(file);
+    EXPECT_EQ(read(file), std::string("hab\0\0z", 6));
+
+    // only the size changes
+    writer.update(file, update(0, "", 2));
+    writer.wait(file);
+    EXPECT_EQ(read(file), "ha");
+    EXPECT_FALSE(fs::exists(fs_utils::path_concat(file, ".tmp")));
+}
+
+TEST_F(write_behind, keeps_the_order_of_updates) {
+    vfs::WriteBehind writer;
+    const fs::path first = root / "first.bin";
+    const fs::path second = root / "second.bin";
+
+    std::string expected(400, '\0');
+    for (int i = 0; i < 100; i++) {
+        const std::string value = fmt::format("{:04}", i);
+        writer.update(first, update(i * 2, value));
+        writer.update(second, update(0, value, 4));
+        expected.replace(i * 2, 4, value);
+    }
+    writer.flush();
+
+    expected.resize(99 * 2 + 4);
+    EXPECT_EQ(read(first), expected);
+    EXPECT_EQ(read(second), "0099");
+}
+
+TEST_F(write_behind, waits_for_the_files_under_a_directory) {
+    vfs::WriteBehind writer;
+    const std::string contents(512 * 1024, 'x');
+    for (int i = 0; i < 8; i++)
+        writer.update(root / "dir" / fmt::format("{}.bin", i), update(0, contents));
+    writer.update(root / "dir-other/0.bin", update(0, contents));
+
+    writer.wait(root / "dir");
+    for (int i = 0; i < 8; i++)
+        EXPECT_EQ(read(root / "dir" / fmt::format("{}.bin", i)), contents) << i;
+}
+
+TEST_F(write_behind, commits_on_destruction) {
+    const fs::path file = root / "data.bin";
+    {
+        vfs::WriteBehind writer;
+        writer.update(file, update(0, "contents"));
+    }
+    EXPECT_EQ(read(file), "contents");
+}
+
+#ifndef _WIN32
+// The process is killed at various points of a commit, the file must never be left with a mix of both contents
+TEST_F(write_behind, survives_being_killed) {
+    const fs::path file = root / "data.bin";
+    const std::string old_contents(2 * 1024 * 1024, 'o');
+    const std::string new_contents(3 * 1024 * 1024, 'n');
+    std::ofstream(file.string(), std::ios::binary) << old_contents;
+
+    int new_count = 0;
+    for (int delay = 0; delay <= 40; delay++) {
+        const pid_t child = fork();
+        ASSERT_GE(child, 0);
+        if (child == 0) {
+            vfs::WriteBehind writer;
+            writer.update(file, update(0, new_contents, new_contents.size()));
+            if (delay == 40)
+                writer.flush();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(delay * 250));
+            raise(SIGKILL);
+        }
+
+        int status = 0;
+        ASSERT_EQ(waitpid(child, &status, 0), child);
+        ASSERT_TRUE(WIFSIGNALED(status));
+
+        const std::string contents = read(file);
+        if (contents != old_contents) {
+            ASSERT_EQ(contents, new_contents) << "delay " << delay;
+            new_count++;
+            // the next run starts over from the old contents
+            std::ofstream(file.string(), std::ios::binary | std::ios::trunc) << old_contents;
+        }
+    }
+    EXPECT_GT(new_count, 0);
+}
+#endif
@@ -0,0 +1,270 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Times guest calls to memcpy and memset served in each of the ways an import can be:
+// - guest: an ARM word copy loop run by the JIT, standing in for the LLE libc (the firmware
+//   module can't be loaded here)
+// - hle: the svc import stub, leaving the JIT to run the host implementation on guest memory
+// - fast path: the code the import stubs of the HLE memcpy and memset branch to, which stays
+//   in the JIT under IMPORT_FAST_PATH_THRESHOLD bytes
+// - replaced: the guest code found by its signature and replaced with a jump to the HLE export
+// and reports the time per call for a range of sizes, then how fast code is scanned for signatures.
+
+#include <cpu/benchmark_harness.h>
+#include <cpu/common.h>
+#include <cpu/functions.h>
+#include <cpu/state.h>
+#include <kernel/function_replacement.h>
+#include <kernel/import_fast_path.h>
+#include <mem/functions.h>
+#include <mem/libc.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using cpu_benchmark::BenchmarkProtocol;
+using cpu_benchmark::guest_memcpy_code;
+using cpu_benchmark::guest_memset_code;
+using cpu_benchmark::write_code;
+
+constexpr uint32_t BUFFER_SIZE = KiB(64);
+constexpr uint32_t SCAN_SIZE = MiB(16);
+constexpr int SCAN_SIGNATURES = 256;
+
+std::vector<uint32_t> hle_stub(uint32_t nid) {
+    return {
+        0xEF000000, // svc #0
+        0xE1A0F00E, // mov pc, lr
+        nid,
+    };
+}
+
+struct Options {
+    double seconds = 0.2;
+    bool use_page_table = false;
+};
+
+struct Functions {
+    Address guest;
+    Address hle;
+    Address fast_path;
+    Address replaced;
+};
+
+FunctionReplacements replacements;
+
+// Guest code replaced by the export with nid, the way a title linking its own copy of the routine would be
+Address write_replaced_code(MemState &mem, const char *name, uint32_t nid, const std::vector<uint32_t> &code) {
+    FunctionSignature signature;
+    signature.name = name;
+    signature.nid = nid;
+    signature.bytes.resize(code.size() * sizeof(uint32_t));
+    memcpy(signature.bytes.data(), code.data(), signature.bytes.size());
+    signature.mask.assign(signature.bytes.size(), 0xFF);
+    replacements.add(std::move(signature));
+
+    const Address address = write_code(mem, code);
+    if (replacements.replace(mem, address, static_cast<uint32_t>(code.size() * sizeof(uint32_t))) != 1)
+        return 0;
+    return address;
+}
+
+// Call function until it returns, serving the HLE memcpy and memset
+bool call(CPUState &cpu, MemState &mem, Address function, uint32_t r0, uint32_t r1, uint32_t r2) {
+    return cpu_benchmark::call(cpu, function, r0, r1, r2, [&] {
+        uint32_t nid = *Ptr<uint32_t>(read_pc(cpu) + 4).get(mem);
+        if (cpu.svc == FUNCTION_REPLACEMENT_SVC)
+            nid = replacements.call(nid);
+        const Address destination = read_reg(cpu, 0);
+        const uint32_t size = read_reg(cpu, 2);
+        if (nid == NID_MEMCPY)
+            guest_memmove(mem, destination, read_reg(cpu, 1), size);
+        else
+            guest_memset(mem, destination, static_cast<uint8_t>(read_reg(cpu, 1)), size);
+    });
+}
+
+// Average time of a call in nanoseconds, negative if a call failed
+double time_calls(const Options &options, CPUState &cpu, MemState &mem, Address function, uint32_t r0, uint32_t r1, uint32_t r2) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const auto deadline = start + std::chrono::duration<double>(options.seconds);
+    uint64_t calls = 0;
+    auto now = start;
+    while (now < deadline) {
+        // amortize the clock over a few calls
+        for (int i = 0; i < 16; i++) {
+            if (!call(cpu, mem, function, r0, r1, r2))
+                return -1.0;
+        }
+        calls += 16;
+        now = clock::now();
+    }
+
+    return std::chrono::duration<double, std::nano>(now - start).count() / calls;
+}
+
+// Megabytes of code scanned per second, against signatures looking like the prologues of Thumb functions
+double time_scan(const Options &options) {
+    std::mt19937 random(42);
+    std::vector<uint8_t> code(SCAN_SIZE);
+    for (uint8_t &byte : code)
+        byte = static_cast<uint8_t>(random());
+
+    FunctionReplacements scan_replacements;
+    for (int i = 0; i < SCAN_SIGNATURES; i++) {
+        FunctionSignature signature;
+        signature.name = fmt::format("function{}", i);
+        signature.thumb = true;
+        // push {..., lr} then instructions with some fields the linker fills
+        signature.bytes = { static_cast<uint8_t>(random()), 0xB5 };
+        signature.mask = { 0xFF, 0xFF };
+        for (int j = 0; j < 14; j++) {
+            signature.bytes.push_back(static_cast<uint8_t>(random()));
+            signature.mask.push_back(j % 4 == 0 ? 0x00 : 0xFF);
+        }
+        // a few of them are in the code
+        if (i % 16 == 0)
+            memcpy(code.data() + (random() % (SCAN_SIZE - 16) & ~1u), signature.bytes.data(), signature.bytes.size());
+        scan_replacements.add(std::move(signature));
+    }
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const auto deadline = start + std::chrono::duration<double>(options.seconds);
+    uint64_t scans = 0;
+    size_t matches = 0;
+    auto now = start;
+    while (now < deadline) {
+        matches += scan_replacements.find(code.data(), SCAN_SIZE).size();
+        scans++;
+        now = clock::now();
+    }
+
+    if (matches < scans * (SCAN_SIGNATURES / 16))
+        return -1.0;
+    return scans * SCAN_SIZE / MiB(1) / std::chrono::duration<double>(now - start).count();
+}
+
+void print_usage() {
+    fmt::print("Usage: kernel-benchmark [--seconds S] [--page-table]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::stod(argv[++i]);
+        } else if (arg == "--page-table") {
+            options.use_page_table = true;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    MemState mem;
+    if (!init(mem, options.use_page_table)) {
+        fmt::print("Failed to initialize the memory\n");
+        return 1;
+    }
+
+    BenchmarkProtocol protocol;
+    protocol.monitor = new_exclusive_monitor(1);
+    CPUStatePtr cpu = init_cpu(CPUBackend::Dynarmic, true, 0, 0, mem, &protocol);
+    if (!cpu) {
+        fmt::print("Failed to initialize the CPU\n");
+        return 1;
+    }
+
+    const Functions memcpy_functions = { write_code(mem, guest_memcpy_code), write_code(mem, hle_stub(NID_MEMCPY)), write_code(mem, get_import_fast_path(NID_MEMCPY)), write_replaced_code(mem, "memcpy", NID_MEMCPY, guest_memcpy_code) };
+    const Functions memset_functions = { write_code(mem, guest_memset_code), write_code(mem, hle_stub(NID_MEMSET)), write_code(mem, get_import_fast_path(NID_MEMSET)), write_replaced_code(mem, "memset", NID_MEMSET, guest_memset_code) };
+    if (!memcpy_functions.replaced || !memset_functions.replaced) {
+        fmt::print("The guest memcpy and memset were not found by their signature\n");
+        return 1;
+    }
+    const Address source = alloc(mem, BUFFER_SIZE, "benchmark source");
+    const Address destination = alloc(mem, BUFFER_SIZE, "benchmark destination");
+    for (uint32_t i = 0; i < BUFFER_SIZE; i++)
+        *Ptr<uint8_t>(source + i).get(mem) = static_cast<uint8_t>(i * 7 + 1);
+
+    // every way must produce the same bytes, including the ones the fast path handles itself
+    for (const Address function : { memcpy_functions.guest, memcpy_functions.hle, memcpy_functions.fast_path, memcpy_functions.replaced }) {
+        for (const uint32_t size : { 0u, 3u, IMPORT_FAST_PATH_THRESHOLD - 1, IMPORT_FAST_PATH_THRESHOLD, 1000u }) {
+            guest_memset(mem, destination, 0, BUFFER_SIZE);
+            if (!call(*cpu, mem, function, destination + 1, source + 2, size)
+                || std::memcmp(Ptr<uint8_t>(destination + 1).get(mem), Ptr<uint8_t>(source + 2).get(mem), size) != 0
+                || *Ptr<uint8_t>(destination + 1 + size).get(mem) != 0) {
+                fmt::print("memcpy of {} bytes at {:#x} is wrong\n", size, function);
+                return 1;
+            }
+        }
+    }
+    for (const Address function : { memset_functions.guest, memset_functions.hle, memset_functions.fast_path, memset_functions.replaced }) {
+        for (const uint32_t size : { 0u, 3u, IMPORT_FAST_PATH_THRESHOLD - 1, IMPORT_FAST_PATH_THRESHOLD, 1000u }) {
+            guest_memset(mem, destination, 0, BUFFER_SIZE);
+            const uint8_t *data = Ptr<uint8_t>(destination + 1).get(mem);
+            if (!call(*cpu, mem, function, destination + 1, 0x1A5, size)
+                || std::any_of(data, data + size, [](uint8_t value) { return value != 0xA5; })
+                || data[size] != 0) {
+                fmt::print("memset of {} bytes at {:#x} is wrong\n", size, function);
+                return 1;
+            }
+        }
+    }
+
+    fmt::print("{} memory, fast path under {} bytes, ns per call\n", options.use_page_table ? "page table" : "fastmem", IMPORT_FAST_PATH_THRESHOLD);
+    fmt::print("{:<8} {:>8} {:>12} {:>12} {:>12} {:>12}\n", "routine", "bytes", "guest", "hle", "fast path", "replaced");
+    for (const auto &[name, functions, r1] : { std::tuple{ "memcpy", memcpy_functions, source }, std::tuple{ "memset", memset_functions, Address(0x5A) } }) {
+        for (const uint32_t size : { 4u, 16u, 32u, 64u, 128u, 256u, 1024u, 4096u, BUFFER_SIZE }) {
+            const double guest = time_calls(options, *cpu, mem, functions.guest, destination, r1, size);
+            const double hle = time_calls(options, *cpu, mem, functions.hle, destination, r1, size);
+            const double fast_path = time_calls(options, *cpu, mem, functions.fast_path, destination, r1, size);
+            const double replaced = time_calls(options, *cpu, mem, functions.replaced, destination, r1, size);
+            if (guest < 0 || hle < 0 || fast_path < 0 || replaced < 0) {
+                fmt::print("The CPU failed while running {}\n", name);
+                return 1;
+            }
+            fmt::print("{:<8} {:>8} {:>12.1f} {:>12.1f} {:>12.1f} {:>12.1f}\n", name, size, guest, hle, fast_path, replaced);
+        }
+    }
+
+    const double scan_speed = time_scan(options);
+    if (scan_speed < 0) {
+        fmt::print("The scan missed some functions\n");
+        return 1;
+    }
+    fmt::print("\nscan for {} signatures: {:.1f} MiB/s\n", SCAN_SIGNATURES, scan_speed);
+
+    cpu.reset();
+    free_exclusive_monitor(protocol.monitor);
+    return 0;
+}
@@ -20,7 +20,9 @@
 #include <mem/state.h>
 #include <mem/util.h>
 
+#include <atomic>
 #include <map>
+#include <memory>
 
 constexpr uint32_t TRAMPOLINE_JUMPER_SVC = 0x54;
 constexpr uint32_t TRAMPOLINE_HANDLER_SVC = 0x53;
@@ -66,6 +68,9 @@ struct Debugger {
     bool log_exports = false;
     bool dump_elfs = false;
 
+    // count HLE import calls per NID (used by headless performance reports)
+    bool count_import_calls = false;
+
     void add_watch_memory_addr(Address addr, size_t size);
     void remove_watch_memory_addr(KernelState &state, Address addr);
     void add_breakpoint(MemState &mem, uint32_t addr, bool thumb_mode);
@@ -75,6 +80,8 @@ struct Debugger {
     void remove_trampoline(MemState &mem, uint32_t addr);
     Address get_watch_memory_addr(Address addr);
     void update_watches();
+    void count_import_call(uint32_t nid);
+    std::map<uint32_t, uint64_t> get_import_call_counts();
 
 private:
     std::mutex mutex;
@@ -82,4 +89,11 @@ private:
     WatchMemoryAddrs watch_memory_addrs;
     Breakpoints breakpoints;
     Trampolines trampolines;
+    // open addressing table of per NID counters, filled without a lock: a NID keeps its slot once claimed
+    struct ImportCallCounter {
+        std::atomic<uint32_t> nid{ 0 };
+        std::atomic<uint64_t> count{ 0 };
+    };
+    static constexpr size_t IMPORT_CALL_COUNTER_SLOTS = 8192;
+    std::unique_ptr<ImportCallCounter[]> import_call_counters;
 };
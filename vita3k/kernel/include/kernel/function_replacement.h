@@ -0,0 +1,104 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h>
+#include <util/fs.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct MemState;
+
+// The stub a replaced function jumps to is `svc #FUNCTION_REPLACEMENT_SVC; mov pc, lr; index`
+constexpr uint32_t FUNCTION_REPLACEMENT_SVC = 0x52;
+
+// Beginning of a function statically linked in titles (usually libc or math routines) that has a HLE
+// export doing the same work. The bytes cleared in mask (relocated addresses, registers picked by the
+// compiler) are not compared.
+struct FunctionSignature {
+    std::string name;
+    // export called instead of the function
+    uint32_t nid = 0;
+    bool thumb = false;
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> mask;
+    // of the bytes under the mask
+    uint64_t hash = 0;
+};
+
+struct FunctionMatch {
+    size_t signature;
+    uint32_t offset;
+};
+
+struct FunctionReplacementStats {
+    std::string name;
+    uint32_t nid;
+    uint32_t matches;
+    uint64_t calls;
+};
+
+// Parses `<name> <nid> <arm|thumb> <bytes>`, the bytes are in hexadecimal with ?? for the ones not compared
+std::optional<FunctionSignature> parse_function_signature(const std::string &line);
+uint64_t hash_masked(const uint8_t *bytes, const uint8_t *mask, size_t size);
+
+class FunctionReplacements {
+public:
+    // The signature must be long enough to hold the jump to the stub and have its first word not fully masked
+    bool add(FunctionSignature signature);
+    // Replaces the signatures with the ones in the file, one per line, # starts a comment. Returns how many were added.
+    size_t load(const fs::path &path);
+    size_t size() const { return entries.size(); }
+    const FunctionSignature &get(size_t signature) const { return entries[signature]->signature; }
+
+    // Functions starting in code, code is the content of a segment so offsets and addresses have the same alignment
+    std::vector<FunctionMatch> find(const uint8_t *code, uint32_t size) const;
+    // Makes the functions found in the code at address jump to their stub. Returns how many were replaced.
+    size_t replace(MemState &mem, Address address, uint32_t size);
+
+    // NID of the export to call for the stub with index, counting the call
+    uint32_t call(uint32_t index);
+    std::vector<FunctionReplacementStats> get_stats() const;
+
+private:
+    struct Entry {
+        FunctionSignature signature;
+        Address stub = 0;
+        std::atomic<uint32_t> matches = 0;
+        std::atomic<uint64_t> calls = 0;
+    };
+
+    struct AnchorGroup {
+        uint32_t mask;
+        // one bit per hashed first word of a signature, most code words are rejected with it alone
+        std::vector<uint64_t> filter;
+        // signatures by their first word under mask
+        std::unordered_multimap<uint32_t, size_t> signatures;
+    };
+
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::vector<AnchorGroup> anchors;
+    // held to allocate the stubs
+    std::mutex mutex;
+};
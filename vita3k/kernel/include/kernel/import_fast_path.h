@@ -0,0 +1,34 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// SceLibc exports with a fast path
+constexpr uint32_t NID_MEMCPY = 0x7205BFDB;
+constexpr uint32_t NID_MEMSET = 0x6DC1F0D8;
+
+// Below this many bytes, the memcpy and memset imports served by HLE do the work in guest code: leaving
+// the JIT to call the export costs more than copying that few bytes. See kernel-benchmark.
+constexpr uint32_t IMPORT_FAST_PATH_THRESHOLD = 64;
+
+// ARM code the import stub of nid should branch to, empty if nid has no fast path.
+// The code handles the sizes under IMPORT_FAST_PATH_THRESHOLD itself and ends with the usual svc stub
+// calling the HLE export for the others.
+std::vector<uint32_t> get_import_fast_path(uint32_t nid);
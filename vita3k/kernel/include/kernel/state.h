@@ -20,6 +20,7 @@
 #include <kernel/callback.h>
 #include <kernel/cpu_protocol.h>
 #include <kernel/debugger.h>
+#include <kernel/function_replacement.h>
 #include <kernel/object_store.h>
 #include <kernel/sync_primitives.h>
 #include <kernel/types.h>
@@ -28,13 +29,19 @@
 #include <mem/util.h>
 #include <rtc/rtc.h>
 #include <util/containers.h>
+#include <util/timer_service.h>
 #include <util/types.h>
+#include <util/worker_pool.h>
 
+#include <algorithm>
 #include <atomic>
+#include <functional>
 #include <map>
 #include <mutex>
+#include <string>
 #include <vector>
 
+struct ThreadSnapshot;
 struct ThreadState;
 
 struct SDL_Thread;
@@ -85,11 +92,55 @@ struct VarBindingInfo {
     uint32_t module_nid;
 };
 
-typedef std::multimap<uint32_t, VarBindingInfo> VarBindingInfos;
-typedef std::multimap<uint32_t, Address> FuncBindingInfos;
+// Flat multimap from NID to binding, kept sorted by NID so lookups are a binary search
+// Entries sharing the same NID keep their insertion order, like std::multimap
+template <typename T>
+struct BindingTable {
+    using Entry = std::pair<uint32_t, T>;
+    using Entries = std::vector<Entry>;
+    using iterator = typename Entries::iterator;
+
+    Entries entries;
+
+    std::pair<iterator, iterator> equal_range(uint32_t nid) {
+        return std::equal_range(entries.begin(), entries.end(), Entry{ nid, T{} }, compare);
+    }
+
+    // Insert all the bindings of a module at once: O(n + k log k) instead of k insertions in the middle of the vector
+    void insert(Entries &&batch) {
+        if (batch.empty())
+            return;
+        const size_t old_size = entries.size();
+        std::stable_sort(batch.begin(), batch.end(), compare);
+        entries.insert(entries.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        std::inplace_merge(entries.begin(), entries.begin() + old_size, entries.end(), compare);
+    }
+
+    // Remove all the bindings of a module at once: a single pass over the vector instead of one per binding
+    template <typename Pred>
+    void erase_if(Pred pred) {
+        std::erase_if(entries, pred);
+    }
+
+private:
+    static bool compare(const Entry &lhs, const Entry &rhs) {
+        return lhs.first < rhs.first;
+    }
+};
+
+typedef BindingTable<VarBindingInfo> VarBindingInfos;
+typedef BindingTable<Address> FuncBindingInfos;
 
 typedef std::map<uint32_t, uint32_t> ModuleUidByNid;
 
+// Saves and restores the host side state of a HLE library in a snapshot
+struct LibrarySnapshotHandler {
+    std::function<void(std::string &data)> save;
+    // called once the guest memory, the threads and the kernel objects are restored, returns false if the data is invalid
+    std::function<bool(const std::string &data)> load;
+};
+typedef std::map<std::string, LibrarySnapshotHandler> LibrarySnapshotHandlers;
+
 struct KernelState {
     KernelState();
 
@@ -129,6 +180,15 @@ struct KernelState {
     FuncBindingInfos func_binding_infos;
     VarBindingInfos var_binding_infos;
     ModuleUidByNid module_uid_by_nid;
+    // guest address of the fast path code of a HLE import, 0 if it has none
+    std::map<uint32_t, Address> import_fast_paths;
+    // statically linked functions replaced by HLE exports when a module is loaded
+    FunctionReplacements function_replacements;
+    // vblank and thread delays
+    TimerService timer_service;
+    // decompress and relocate the segments of a module in parallel, started on the first load needing it
+    std::mutex loader_workers_mutex;
+    WorkerPool loader_workers;
 
     bool cpu_opt;
     CPUBackend cpu_backend;
@@ -144,14 +204,27 @@ struct KernelState {
 
     Debugger debugger;
 
+    // registered by the libraries at initialization, by library name
+    LibrarySnapshotHandlers snapshot_handlers;
+
     SceUID get_next_uid() {
         return next_uid++;
     }
 
+    // to restore the objects of a snapshot with their uid and keep the new ones from overlapping them
+    SceUID peek_next_uid() const {
+        return next_uid;
+    }
+    void set_next_uid(SceUID uid) {
+        next_uid = uid;
+    }
+
     bool init(MemState &mem, const CallImportFunc &call_import, CPUBackend cpu_backend, bool cpu_opt);
     void load_process_param(MemState &mem, Ptr<uint32_t> ptr);
     ThreadStatePtr create_thread(MemState &mem, const char *name, Ptr<const void> entry_point = Ptr<const void>(0));
     ThreadStatePtr create_thread(MemState &mem, const char *name, Ptr<const void> entry_point, int init_priority, SceInt32 affinity_mask, int stack_size, const SceKernelThreadOptParam *option);
+    // create a thread from a snapshot, its guest memory must already be restored. The thread is not resumed.
+    ThreadStatePtr restore_thread(MemState &mem, const ThreadSnapshot &snapshot);
 
     ThreadStatePtr get_thread(SceUID thread_id);
     Ptr<Ptr<void>> get_thread_tls_addr(MemState &mem, SceUID thread_id, int key);
@@ -166,6 +239,8 @@ struct KernelState {
     SceKernelModuleInfo *find_module_by_addr(Address address);
 
 private:
+    void start_host_thread(const ThreadState &thread);
+
     std::atomic<SceUID> next_uid{ 1 };
     std::map<SceUID, ThreadStatus> paused_threads_status;
 };
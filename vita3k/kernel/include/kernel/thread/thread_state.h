@@ -27,6 +27,7 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 struct CPUContext;
 
@@ -67,6 +68,28 @@ enum class ThreadToDo {
     wait,
 };
 
+// State of a thread saved in a snapshot, to create it again in another run of the emulator
+// The stack, the TLS and the halt instruction are in guest memory, which is restored separately
+struct ThreadSnapshot {
+    SceUID id = 0;
+    std::string name;
+    Address entry_point = 0;
+    Address stack = 0;
+    int stack_size = 0;
+    Address tls = 0;
+    Address halt_instruction = 0;
+    int priority = 0;
+    SceInt32 affinity_mask = 0;
+    uint64_t start_tick = 0;
+    ThreadStatus status = ThreadStatus::dormant;
+    // 0 for a dormant thread, 1 otherwise: snapshots are not taken while a thread runs a callback
+    int call_level = 0;
+    bool run_start_callback = false;
+    CPUContext init_context;
+    CPUContext context;
+    uint32_t returned_value = 0;
+};
+
 struct ThreadState {
     std::mutex mutex;
     std::string name;
@@ -119,7 +142,17 @@ struct ThreadState {
     void resume(bool step = false);
     std::string log_stack_traceback() const;
 
+    // the thread must not be running. A thread waiting in a kernel call is saved so that it makes the call again.
+    ThreadSnapshot get_snapshot();
+    // the restored thread is dormant or suspended, it must be resumed once everything else is restored
+    int restore(const ThreadSnapshot &snapshot);
+    // the number of nested run_loop calls, see call_level
+    int get_call_level() const {
+        return call_level;
+    }
+
 private:
+    bool create_cpu();
     void push_arguments(const std::vector<uint32_t> &args);
 
     KernelState &kernel;
@@ -51,6 +51,9 @@ void CPUProtocol::call_svc(CPUState &cpu, uint32_t svc, Address pc, ThreadState
 
     // This is usual service call
     uint32_t nid = *Ptr<uint32_t>(pc + 4).get(*mem);
+    // A function replaced on load, its stub holds the index of the replacement instead
+    if (svc == FUNCTION_REPLACEMENT_SVC)
+        nid = kernel->function_replacements.call(nid);
     // TODO: just supply ThreadStatePtr to call_import
     // the only benefit of using thread_id instead--namely less locking-- has been gone for long
     call_import(cpu, nid, thread.id);
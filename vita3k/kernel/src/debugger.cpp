@@ -119,7 +119,8 @@ void Debugger::remove_trampoline(MemState &mem, uint32_t addr) {
 }
 
 Debugger::Debugger(KernelState &kernel)
-    : parent(kernel) {
+    : parent(kernel)
+    , import_call_counters(std::make_unique<ImportCallCounter[]>(IMPORT_CALL_COUNTER_SLOTS)) {
 }
 
 void Debugger::add_watch_memory_addr(Address addr, size_t size) {
@@ -146,3 +147,32 @@ Address Debugger::get_watch_memory_addr(Address addr) {
 void Debugger::update_watches() {
     parent.set_memory_watch(watch_memory);
 }
+
+void Debugger::count_import_call(uint32_t nid) {
+    // 0 marks a free slot, no exported function uses it as NID
+    if (nid == 0)
+        return;
+
+    // NIDs are hashes already, the low bits are spread well enough to index the table
+    for (size_t i = 0; i < IMPORT_CALL_COUNTER_SLOTS; i++) {
+        ImportCallCounter &counter = import_call_counters[(nid + i) % IMPORT_CALL_COUNTER_SLOTS];
+        uint32_t slot_nid = counter.nid.load(std::memory_order_acquire);
+        if (slot_nid == 0 && counter.nid.compare_exchange_strong(slot_nid, nid, std::memory_order_acq_rel))
+            slot_nid = nid;
+        if (slot_nid == nid) {
+            counter.count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+std::map<uint32_t, uint64_t> Debugger::get_import_call_counts() {
+    std::map<uint32_t, uint64_t> counts;
+    for (size_t i = 0; i < IMPORT_CALL_COUNTER_SLOTS; i++) {
+        const uint32_t nid = import_call_counters[i].nid.load(std::memory_order_acquire);
+        if (nid != 0)
+            counts[nid] = import_call_counters[i].count.load(std::memory_order_relaxed);
+    }
+
+    return counts;
+}
@@ -0,0 +1,270 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/function_replacement.h>
+
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+static constexpr uint32_t SVC_REPLACEMENT = 0xEF000000 | FUNCTION_REPLACEMENT_SVC; // svc #FUNCTION_REPLACEMENT_SVC
+static constexpr uint32_t MOV_PC_LR = 0xE1A0F00E; // mov pc, lr - Return to the caller.
+static constexpr uint32_t ARM_LDR_PC = 0xE51FF004; // ldr pc, [pc, #-4] - Jump to the word that follows.
+static constexpr uint16_t THUMB_LDR_PC = 0xF8DF; // ldr.w pc, [pc, #imm] - Jump to the word at imm.
+static constexpr uint16_t THUMB_NOP = 0xBF00;
+
+// Size of the jump written over a replaced function, a Thumb one needs a nop before its word when it does not start on 4 bytes
+static constexpr uint32_t ARM_JUMP_SIZE = 8;
+static constexpr uint32_t THUMB_JUMP_SIZE = 10;
+
+static constexpr size_t FILTER_BITS = 1 << 16;
+
+static uint32_t filter_bit(uint32_t word) {
+    return (word * 0x9E3779B1u) >> 16;
+}
+
+static uint32_t read_word(const uint8_t *bytes) {
+    uint32_t word;
+    memcpy(&word, bytes, sizeof(word));
+    return word;
+}
+
+static uint32_t first_word(const std::vector<uint8_t> &bytes) {
+    return read_word(bytes.data());
+}
+
+uint64_t hash_masked(const uint8_t *bytes, const uint8_t *mask, size_t size) {
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i] & mask[i];
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+std::optional<FunctionSignature> parse_function_signature(const std::string &line) {
+    std::istringstream stream(line.substr(0, line.find('#')));
+    FunctionSignature signature;
+    std::string nid, mode;
+    if (!(stream >> signature.name >> nid >> mode))
+        return {};
+
+    try {
+        size_t end = 0;
+        signature.nid = static_cast<uint32_t>(std::stoul(nid, &end, 16));
+        if (end != nid.size())
+            return {};
+    } catch (...) {
+        return {};
+    }
+
+    if (mode == "thumb")
+        signature.thumb = true;
+    else if (mode != "arm")
+        return {};
+
+    // bytes can be written together or apart: `2DE9F041` and `2D E9 F0 41` are the same
+    std::string bytes;
+    while (stream >> bytes) {
+        if (bytes.size() % 2 != 0)
+            return {};
+        for (size_t i = 0; i < bytes.size(); i += 2) {
+            if (bytes[i] == '?' && bytes[i + 1] == '?') {
+                signature.bytes.push_back(0);
+                signature.mask.push_back(0);
+                continue;
+            }
+            const int high = hex_digit(bytes[i]);
+            const int low = hex_digit(bytes[i + 1]);
+            if (high < 0 || low < 0)
+                return {};
+            signature.bytes.push_back(static_cast<uint8_t>((high << 4) | low));
+            signature.mask.push_back(0xFF);
+        }
+    }
+    if (signature.bytes.empty())
+        return {};
+
+    signature.hash = hash_masked(signature.bytes.data(), signature.mask.data(), signature.bytes.size());
+    return signature;
+}
+
+bool FunctionReplacements::add(FunctionSignature signature) {
+    const uint32_t jump_size = signature.thumb ? THUMB_JUMP_SIZE : ARM_JUMP_SIZE;
+    if (signature.bytes.size() < jump_size || signature.mask.size() != signature.bytes.size())
+        return false;
+    const uint32_t anchor_mask = first_word(signature.mask);
+    if (anchor_mask == 0)
+        return false;
+
+    signature.hash = hash_masked(signature.bytes.data(), signature.mask.data(), signature.bytes.size());
+    const uint32_t anchor = first_word(signature.bytes) & anchor_mask;
+
+    auto group = std::find_if(anchors.begin(), anchors.end(), [&](const AnchorGroup &group) { return group.mask == anchor_mask; });
+    if (group == anchors.end()) {
+        group = anchors.insert(anchors.end(), AnchorGroup{ anchor_mask, std::vector<uint64_t>(FILTER_BITS / 64) });
+    }
+    const uint32_t bit = filter_bit(anchor);
+    group->filter[bit / 64] |= uint64_t(1) << (bit % 64);
+    group->signatures.emplace(anchor, entries.size());
+
+    auto entry = std::make_unique<Entry>();
+    entry->signature = std::move(signature);
+    entries.push_back(std::move(entry));
+    return true;
+}
+
+size_t FunctionReplacements::load(const fs::path &path) {
+    entries.clear();
+    anchors.clear();
+
+    fs::ifstream file(path);
+    if (!file)
+        return 0;
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos || line.find_first_not_of(" \t\r") == line.find('#'))
+            continue;
+
+        auto signature = parse_function_signature(line);
+        if (!signature || !add(std::move(*signature)))
+            LOG_WARN("Invalid function signature on line {} of {}", line_number, path);
+    }
+
+    LOG_INFO_IF(!entries.empty(), "Loaded {} function signatures from {}", entries.size(), path);
+    return entries.size();
+}
+
+std::vector<FunctionMatch> FunctionReplacements::find(const uint8_t *code, uint32_t size) const {
+    std::vector<FunctionMatch> matches;
+    if (entries.empty())
+        return matches;
+
+    // ARM functions start on 4 bytes, Thumb ones on 2
+    const bool has_thumb = std::any_of(entries.begin(), entries.end(), [](const auto &entry) { return entry->signature.thumb; });
+    const uint32_t step = has_thumb ? 2 : 4;
+
+    uint32_t offset = 0;
+    while (offset + 4 <= size) {
+        const uint32_t word = read_word(code + offset);
+        const Entry *found = nullptr;
+        size_t found_index = 0;
+        for (const AnchorGroup &group : anchors) {
+            const uint32_t anchor = word & group.mask;
+            const uint32_t bit = filter_bit(anchor);
+            if (!(group.filter[bit / 64] & (uint64_t(1) << (bit % 64))))
+                continue;
+
+            const auto [begin, end] = group.signatures.equal_range(anchor);
+            for (auto it = begin; it != end && !found; ++it) {
+                const Entry &entry = *entries[it->second];
+                const FunctionSignature &signature = entry.signature;
+                if ((!signature.thumb && offset % 4 != 0) || signature.bytes.size() > size - offset)
+                    continue;
+                if (hash_masked(code + offset, signature.mask.data(), signature.bytes.size()) != signature.hash)
+                    continue;
+
+                found = &entry;
+                found_index = it->second;
+            }
+            if (found)
+                break;
+        }
+
+        if (found) {
+            matches.push_back({ found_index, offset });
+            // a function does not start inside another one
+            offset += (static_cast<uint32_t>(found->signature.bytes.size()) + step - 1) / step * step;
+        } else {
+            offset += step;
+        }
+    }
+
+    return matches;
+}
+
+size_t FunctionReplacements::replace(MemState &mem, Address address, uint32_t size) {
+    const std::vector<FunctionMatch> matches = find(Ptr<uint8_t>(address).get(mem), size);
+    for (const FunctionMatch &match : matches) {
+        Entry &entry = *entries[match.signature];
+        Address stub;
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            if (!entry.stub) {
+                entry.stub = alloc(mem, 3 * sizeof(uint32_t), "function_replacement");
+                uint32_t *const stub_code = Ptr<uint32_t>(entry.stub).get(mem);
+                stub_code[0] = SVC_REPLACEMENT;
+                stub_code[1] = MOV_PC_LR;
+                stub_code[2] = static_cast<uint32_t>(match.signature);
+            }
+            stub = entry.stub;
+        }
+
+        const Address function_address = address + match.offset;
+        uint8_t *const code = Ptr<uint8_t>(function_address).get(mem);
+        if (entry.signature.thumb) {
+            // the word loaded by ldr.w pc must be aligned, pc reads as the address of the instruction + 4 rounded down to 4
+            const bool aligned = function_address % 4 == 0;
+            const uint16_t jump[3] = { THUMB_LDR_PC, static_cast<uint16_t>(0xF000 | (aligned ? 0 : 4)), THUMB_NOP };
+            memcpy(code, jump, aligned ? 4 : 6);
+            memcpy(code + (aligned ? 4 : 6), &stub, sizeof(stub));
+        } else {
+            memcpy(code, &ARM_LDR_PC, sizeof(ARM_LDR_PC));
+            memcpy(code + 4, &stub, sizeof(stub));
+        }
+        entry.matches++;
+
+        LOG_DEBUG("Replaced {} at {} with export {}", entry.signature.name, log_hex(function_address), log_hex(entry.signature.nid));
+    }
+
+    return matches.size();
+}
+
+uint32_t FunctionReplacements::call(uint32_t index) {
+    if (index >= entries.size())
+        return 0;
+
+    Entry &entry = *entries[index];
+    entry.calls.fetch_add(1, std::memory_order_relaxed);
+    return entry.signature.nid;
+}
+
+std::vector<FunctionReplacementStats> FunctionReplacements::get_stats() const {
+    std::vector<FunctionReplacementStats> stats;
+    stats.reserve(entries.size());
+    for (const auto &entry : entries)
+        stats.push_back({ entry->signature.name, entry->signature.nid, entry->matches.load(), entry->calls.load(std::memory_order_relaxed) });
+    return stats;
+}
@@ -0,0 +1,75 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/import_fast_path.h>
+
+static_assert(IMPORT_FAST_PATH_THRESHOLD <= 0xFF, "the threshold must fit in the immediate of cmp");
+
+static constexpr uint32_t CMP_R2_IMM = 0xE3520000; // cmp r2, #imm
+static constexpr uint32_t BHS = 0x2A000000; // bhs <offset>
+static constexpr uint32_t B = 0xEA000000; // b <offset>
+static constexpr uint32_t MOV_R3_R0 = 0xE1A03000; // mov r3, r0
+static constexpr uint32_t SUBS_R2_1 = 0xE2522001; // subs r2, r2, #1
+static constexpr uint32_t BXLO_LR = 0x312FFF1E; // bxlo lr
+static constexpr uint32_t LDRB_R12_R1_POST = 0xE4D1C001; // ldrb r12, [r1], #1
+static constexpr uint32_t STRB_R12_R3_POST = 0xE4C3C001; // strb r12, [r3], #1
+static constexpr uint32_t STRB_R1_R3_POST = 0xE4C31001; // strb r1, [r3], #1
+static constexpr uint32_t SVC_0 = 0xEF000000; // svc #0 - Call our interrupt hook.
+static constexpr uint32_t MOV_PC_LR = 0xE1A0F00E; // mov pc, lr - Return to the caller.
+
+// Offset field of a branch at index from to the instruction at index to
+static uint32_t branch_offset(int from, int to) {
+    return static_cast<uint32_t>(to - (from + 2)) & 0xFFFFFF;
+}
+
+// memcpy(r0 = destination, r1 = source, r2 = size) and memset(r0 = destination, r1 = value, r2 = size)
+// both return r0 untouched, r3 and r12 are free to use as scratch registers
+static std::vector<uint32_t> byte_loop(uint32_t nid, uint32_t store) {
+    const bool is_copy = (nid == NID_MEMCPY);
+    const int loop = 3;
+    const int hle = is_copy ? 8 : 7;
+
+    std::vector<uint32_t> code = {
+        CMP_R2_IMM | IMPORT_FAST_PATH_THRESHOLD,
+        BHS | branch_offset(1, hle),
+        MOV_R3_R0,
+        SUBS_R2_1,
+        BXLO_LR,
+    };
+    if (is_copy)
+        code.push_back(LDRB_R12_R1_POST);
+    code.push_back(store);
+    code.push_back(B | branch_offset(static_cast<int>(code.size()), loop));
+
+    // same layout as the import stubs, the interrupt hook reads the nid after the return
+    code.push_back(SVC_0);
+    code.push_back(MOV_PC_LR);
+    code.push_back(nid);
+
+    return code;
+}
+
+std::vector<uint32_t> get_import_fast_path(uint32_t nid) {
+    switch (nid) {
+    case NID_MEMCPY:
+        return byte_loop(nid, STRB_R12_R3_POST);
+    case NID_MEMSET:
+        return byte_loop(nid, STRB_R1_R3_POST);
+    default:
+        return {};
+    }
+}
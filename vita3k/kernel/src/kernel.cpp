@@ -92,6 +92,7 @@ bool KernelState::init(MemState &mem, const CallImportFunc &call_import, CPUBack
     cpu_protocol = std::make_unique<CPUProtocol>(*this, mem, call_import);
     this->cpu_backend = cpu_backend;
     this->cpu_opt = cpu_opt;
+    timer_service.start();
 
     return true;
 }
@@ -143,14 +144,27 @@ ThreadStatePtr KernelState::create_thread(MemState &mem, const char *name, Ptr<c
         return nullptr;
     const auto lock = std::lock_guard(mutex);
     threads.emplace(thread->id, thread);
+    start_host_thread(*thread);
+    return thread;
+}
 
+ThreadStatePtr KernelState::restore_thread(MemState &mem, const ThreadSnapshot &snapshot) {
+    ThreadStatePtr thread = std::make_shared<ThreadState>(snapshot.id, *this, mem);
+    if (thread->restore(snapshot) < 0)
+        return nullptr;
+    const auto lock = std::lock_guard(mutex);
+    threads.emplace(thread->id, thread);
+    start_host_thread(*thread);
+    return thread;
+}
+
+void KernelState::start_host_thread(const ThreadState &thread) {
     ThreadParams params;
     params.kernel = this;
-    params.thid = thread->id;
+    params.thid = thread.id;
 
-    SDL_CreateThread(&thread_function, thread->name.c_str(), &params);
+    SDL_CreateThread(&thread_function, thread.name.c_str(), &params);
     SDL_SemWait(params.host_may_destroy_params.get());
-    return thread;
 }
 
 Ptr<Ptr<void>> KernelState::get_thread_tls_addr(MemState &mem, SceUID thread_id, int key) {
@@ -16,6 +16,7 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <cpu/functions.h>
+#include <kernel/import_fast_path.h>
 #include <kernel/load_self.h>
 #include <kernel/relocation.h>
 #include <kernel/state.h>
@@ -35,9 +36,12 @@
 #include <miniz.h>
 #include <self.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 
@@ -57,8 +61,42 @@ struct VarImportsHeader {
 };
 static_assert(sizeof(VarImportsHeader) == sizeof(uint32_t));
 
+// Size of the import stub rewritten when binding a function (movw, movt, bx)
+static constexpr uint32_t FUNC_STUB_SIZE = 3 * sizeof(uint32_t);
+
+// Import stubs rewritten while (un)linking a module, invalidated in the JIT cache once per contiguous stub table
+// instead of once per stub
+struct StubInvalidations {
+    std::vector<Address> stubs;
+
+    void add(Address stub) {
+        stubs.push_back(stub);
+    }
+
+    void flush(KernelState &kernel) {
+        if (stubs.empty())
+            return;
+
+        std::sort(stubs.begin(), stubs.end());
+        Address range_start = stubs.front();
+        Address range_end = range_start + FUNC_STUB_SIZE;
+        for (const Address stub : stubs) {
+            // stubs are 16 bytes apart in the stub table, merge them when only the reftable word separates them
+            if (stub > range_end + sizeof(uint32_t)) {
+                kernel.invalidate_jit_cache(range_start, range_end - range_start);
+                range_start = stub;
+            }
+            range_end = std::max(range_end, stub + FUNC_STUB_SIZE);
+        }
+        kernel.invalidate_jit_cache(range_start, range_end - range_start);
+        stubs.clear();
+    }
+};
+
 static bool load_var_imports(const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, const SegmentInfosForReloc &segments, KernelState &kernel, MemState &mem, uint32_t module_id) {
     const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+    VarBindingInfos::Entries bindings;
+    bindings.reserve(count);
     for (size_t i = 0; i < count; ++i) {
         const uint32_t nid = nids[i];
         const Ptr<uint32_t> entry = entries[i];
@@ -74,7 +112,7 @@ static bool load_var_imports(const uint32_t *nids, const Ptr<uint32_t> *entries,
 
         const char *const name = import_name(nid);
         Address export_address;
-        kernel.var_binding_infos.emplace(nid, VarBindingInfo{ var_reloc_entries, reloc_size, module_id });
+        bindings.emplace_back(nid, VarBindingInfo{ var_reloc_entries, reloc_size, module_id });
         const ExportNids::iterator export_address_it = kernel.export_nids.find(nid);
         if (export_address_it != kernel.export_nids.end()) {
             export_address = export_address_it->second;
@@ -94,39 +132,63 @@ static bool load_var_imports(const uint32_t *nids, const Ptr<uint32_t> *entries,
 
         if (reloc_size)
             // 8 is sizeof(EntryFormat1Alt)
-            if (!relocate(var_reloc_entries, reloc_size, segments, mem, true, export_address))
+            if (!relocate(var_reloc_entries, reloc_size, segments, mem, true, export_address)) {
+                kernel.var_binding_infos.insert(std::move(bindings));
                 return false;
+            }
     }
+    kernel.var_binding_infos.insert(std::move(bindings));
 
     return true;
 }
 
 static bool unload_var_imports(const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, const SegmentInfosForReloc &segments, KernelState &kernel, MemState &mem, uint32_t module_id) {
-    const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+    // the relocation entries of each import are only bound once
+    unordered_set_fast<void *> removed_entries;
     for (size_t i = 0; i < count; ++i) {
-        const uint32_t nid = nids[i];
-        const Ptr<uint32_t> entry = entries[i];
+        VarImportsHeader *const var_reloc_header = reinterpret_cast<VarImportsHeader *>(entries[i].get(mem));
+        removed_entries.insert(var_reloc_header + 1);
+    }
 
-        VarImportsHeader *const var_reloc_header = reinterpret_cast<VarImportsHeader *>(entry.get(mem));
-        const auto var_reloc_entries = static_cast<void *>(var_reloc_header + 1);
-        const uint32_t reloc_size = (var_reloc_header->reloc_data_size > sizeof(VarImportsHeader)) ? (var_reloc_header->reloc_data_size - sizeof(VarImportsHeader)) : 0;
+    // remove the binding infos from the map
+    const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+    kernel.var_binding_infos.erase_if([&](const auto &binding) {
+        return binding.second.module_nid == module_id && removed_entries.count(binding.second.entries);
+    });
 
-        // remove the binding info from the map
-        VarBindingInfo binding_info{ var_reloc_entries, reloc_size, module_id };
-        auto range = kernel.var_binding_infos.equal_range(nid);
-        for (auto it = range.first; it != range.second; ++it) {
-            if (memcmp(&it->second, &binding_info, sizeof(VarBindingInfo)) == 0) {
-                kernel.var_binding_infos.erase(it);
-                break;
-            }
+    return true;
+}
+
+// Point an import stub to the HLE export of nid, through its fast path if it has one
+static void write_hle_stub(KernelState &kernel, MemState &mem, uint32_t *stub, uint32_t nid) {
+    auto fast_path = kernel.import_fast_paths.find(nid);
+    if (fast_path == kernel.import_fast_paths.end()) {
+        // the code is written once and shared by all the stubs importing nid
+        const std::vector<uint32_t> code = get_import_fast_path(nid);
+        Address address = 0;
+        if (!code.empty()) {
+            address = alloc(mem, static_cast<uint32_t>(code.size() * sizeof(uint32_t)), "import_fast_path");
+            if (address)
+                std::copy(code.begin(), code.end(), Ptr<uint32_t>(address).get(mem));
         }
+        fast_path = kernel.import_fast_paths.emplace(nid, address).first;
     }
 
-    return true;
+    if (fast_path->second) {
+        stub[0] = encode_arm_inst(INSTRUCTION_MOVW, (uint16_t)fast_path->second, 12);
+        stub[1] = encode_arm_inst(INSTRUCTION_MOVT, (uint16_t)(fast_path->second >> 16), 12);
+        stub[2] = encode_arm_inst(INSTRUCTION_BRANCH, 0, 12);
+    } else {
+        stub[0] = 0xef000000; // svc #0 - Call our interrupt hook.
+        stub[1] = 0xe1a0f00e; // mov pc, lr - Return to the caller.
+        stub[2] = nid; // Our interrupt hook will read this.
+    }
 }
 
-static bool load_func_imports(const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, const SegmentInfosForReloc &segments, KernelState &kernel, const MemState &mem) {
+static bool load_func_imports(const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, const SegmentInfosForReloc &segments, KernelState &kernel, MemState &mem) {
     const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+    FuncBindingInfos::Entries bindings;
+    bindings.reserve(count);
     for (size_t i = 0; i < count; ++i) {
         const uint32_t nid = nids[i];
         const Ptr<uint32_t> entry = entries[i];
@@ -139,11 +201,9 @@ static bool load_func_imports(const uint32_t *nids, const Ptr<uint32_t> *entries
         const ExportNids::iterator export_address = kernel.export_nids.find(nid);
         uint32_t *const stub = entry.get(mem);
 
-        kernel.func_binding_infos.emplace(nid, entry.address());
+        bindings.emplace_back(nid, entry.address());
         if (export_address == kernel.export_nids.end()) {
-            stub[0] = 0xef000000; // svc #0 - Call our interrupt hook.
-            stub[1] = 0xe1a0f00e; // mov pc, lr - Return to the caller.
-            stub[2] = nid; // Our interrupt hook will read this.
+            write_hle_stub(kernel, mem, stub, nid);
         } else {
             Address func_address = export_address->second;
             stub[0] = encode_arm_inst(INSTRUCTION_MOVW, (uint16_t)func_address, 12);
@@ -156,29 +216,27 @@ static bool load_func_imports(const uint32_t *nids, const Ptr<uint32_t> *entries
             const uint32_t reloc_size = (var_reloc_header->reloc_data_size > sizeof(VarImportsHeader)) ? (var_reloc_header->reloc_data_size - sizeof(VarImportsHeader)) : 0;
             if (reloc_size) {
                 if (!relocate(var_reloc_entries, reloc_size, segments, mem, true, entry.address())) {
+                    kernel.func_binding_infos.insert(std::move(bindings));
                     return false;
                 }
             }
         }
     }
+    kernel.func_binding_infos.insert(std::move(bindings));
     return true;
 }
 
 static bool unload_func_imports(const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, const SegmentInfosForReloc &segments, KernelState &kernel, const MemState &mem) {
-    const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
-    for (size_t i = 0; i < count; ++i) {
-        const uint32_t nid = nids[i];
-        const Ptr<uint32_t> entry = entries[i];
+    // each stub has its own address
+    unordered_set_fast<Address> removed_stubs;
+    for (size_t i = 0; i < count; ++i)
+        removed_stubs.insert(entries[i].address());
 
-        // remove the stub from the table
-        auto range = kernel.func_binding_infos.equal_range(nid);
-        for (auto it = range.first; it != range.second; ++it) {
-            if (it->second == entry.address()) {
-                kernel.func_binding_infos.erase(it);
-                break;
-            }
-        }
-    }
+    // remove the stubs from the table
+    const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
+    kernel.func_binding_infos.erase_if([&](const auto &binding) {
+        return removed_stubs.count(binding.second) != 0;
+    });
     return true;
 }
 
@@ -244,7 +302,7 @@ static bool load_imports(const sce_module_info_raw &module, Ptr<const void> segm
     return true;
 }
 
-static bool load_func_exports(SceKernelModuleInfo *kernel_module_info, const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, KernelState &kernel, MemState &mem) {
+static bool load_func_exports(SceKernelModuleInfo *kernel_module_info, const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, KernelState &kernel, MemState &mem, StubInvalidations &invalidations) {
     const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
     for (size_t i = 0; i < count; ++i) {
         const uint32_t nid = nids[i];
@@ -273,7 +331,7 @@ static bool load_func_exports(SceKernelModuleInfo *kernel_module_info, const uin
             stub[0] = encode_arm_inst(INSTRUCTION_MOVW, (uint16_t)entry.address(), 12);
             stub[1] = encode_arm_inst(INSTRUCTION_MOVT, (uint16_t)(entry.address() >> 16), 12);
             stub[2] = encode_arm_inst(INSTRUCTION_BRANCH, 0, 12);
-            kernel.invalidate_jit_cache(address, 3 * sizeof(uint32_t));
+            invalidations.add(address);
         }
 
         if (kernel.debugger.log_exports) {
@@ -286,7 +344,7 @@ static bool load_func_exports(SceKernelModuleInfo *kernel_module_info, const uin
     return true;
 }
 
-static bool unload_func_exports(SceKernelModuleInfo *kernel_module_info, const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, KernelState &kernel, MemState &mem) {
+static bool unload_func_exports(SceKernelModuleInfo *kernel_module_info, const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, KernelState &kernel, MemState &mem, StubInvalidations &invalidations) {
     const std::lock_guard<std::mutex> guard(kernel.export_nids_mutex);
     for (size_t i = 0; i < count; ++i) {
         const uint32_t nid = nids[i];
@@ -301,10 +359,8 @@ static bool unload_func_exports(SceKernelModuleInfo *kernel_module_info, const u
             Address entry = it->second;
             uint32_t *stub = Ptr<uint32_t>(entry).get(mem);
 
-            stub[0] = 0xef000000; // svc #0 - Call our interrupt hook.
-            stub[1] = 0xe1a0f00e; // mov pc, lr - Return to the caller.
-            stub[2] = nid; // Our interrupt hook will read this.
-            kernel.invalidate_jit_cache(entry, 3 * sizeof(uint32_t));
+            write_hle_stub(kernel, mem, stub, nid);
+            invalidations.add(entry);
         }
     }
 
@@ -436,7 +492,7 @@ static bool unload_var_exports(const uint32_t *nids, const Ptr<uint32_t> *entrie
     return true;
 }
 
-static bool load_exports(SceKernelModuleInfo *kernel_module_info, const sce_module_info_raw &module, Ptr<const void> segment_address, KernelState &kernel, MemState &mem, bool is_unload = false) {
+static bool load_exports(SceKernelModuleInfo *kernel_module_info, const sce_module_info_raw &module, Ptr<const void> segment_address, KernelState &kernel, MemState &mem, StubInvalidations &invalidations, bool is_unload = false) {
     const uint8_t *const base = segment_address.cast<const uint8_t>().get(mem);
     const sce_module_exports_raw *const exports_begin = reinterpret_cast<const sce_module_exports_raw *>(base + module.export_top);
     const sce_module_exports_raw *const exports_end = reinterpret_cast<const sce_module_exports_raw *>(base + module.export_end);
@@ -449,9 +505,9 @@ static bool load_exports(SceKernelModuleInfo *kernel_module_info, const sce_modu
 
         const uint32_t *const nids = Ptr<const uint32_t>(exports->nid_table).get(mem);
         const Ptr<uint32_t> *const entries = Ptr<Ptr<uint32_t>>(exports->entry_table).get(mem);
-        if (!is_unload && !load_func_exports(kernel_module_info, nids, entries, exports->num_syms_funcs, kernel, mem))
+        if (!is_unload && !load_func_exports(kernel_module_info, nids, entries, exports->num_syms_funcs, kernel, mem, invalidations))
             return false;
-        if (is_unload && !unload_func_exports(kernel_module_info, nids, entries, exports->num_syms_funcs, kernel, mem))
+        if (is_unload && !unload_func_exports(kernel_module_info, nids, entries, exports->num_syms_funcs, kernel, mem, invalidations))
             return false;
 
         const auto var_count = exports->num_syms_vars;
@@ -469,6 +525,27 @@ static bool load_exports(SceKernelModuleInfo *kernel_module_info, const sce_modu
     return true;
 }
 
+// Run the given per-segment jobs, on the loader workers when there is more than one
+static bool run_segment_jobs(KernelState &kernel, const std::vector<std::function<bool()>> &jobs) {
+    // another thread is already loading a module with the workers, run the jobs here instead of waiting for it
+    std::unique_lock<std::mutex> lock(kernel.loader_workers_mutex, std::defer_lock);
+    if (jobs.size() <= 1 || !lock.try_lock())
+        return std::all_of(jobs.begin(), jobs.end(), [](const auto &job) { return job(); });
+
+    if (kernel.loader_workers.size() != WorkerPool::default_size())
+        kernel.loader_workers.start(WorkerPool::default_size());
+
+    // std::vector<bool> is not safe to write concurrently
+    std::vector<uint8_t> results(jobs.size());
+    kernel.loader_workers.run(static_cast<uint32_t>(jobs.size()), [&](uint32_t i) { results[i] = jobs[i](); });
+
+    return std::all_of(results.begin(), results.end(), [](uint8_t result) { return result != 0; });
+}
+
+static int64_t elapsed_us(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
 /**
  * \return Negative on failure
  */
@@ -575,6 +652,12 @@ SceUID load_self(KernelState &kernel, MemState &mem, const void *self, const std
         }
     };
 
+    // Segments are allocated and linked serially, but decompressing and relocating them is independent work per segment
+    std::vector<std::function<bool()>> load_jobs;
+    std::vector<std::function<bool()>> reloc_jobs;
+
+    const auto load_start = std::chrono::steady_clock::now();
+
     for (Elf_Half seg_index = 0; seg_index < elf.e_phnum; ++seg_index) {
         const Elf32_Phdr &seg_header = segments[seg_index];
         const uint8_t *const seg_bytes = self_bytes + self_header.header_len + seg_header.p_offset;
@@ -624,44 +707,52 @@ SceUID load_self(KernelState &kernel, MemState &mem, const void *self, const std
                     return SCE_KERNEL_ERROR_NO_MEMORY; // TODO is this correct?
                 }
 
-                const Ptr<uint8_t> seg_ptr(segment_address);
-                if (seg_infos[seg_index].compression == 2) {
-                    unsigned long dest_bytes = seg_header.p_filesz;
-                    const uint8_t *const compressed_segment_bytes = self_bytes + seg_infos[seg_index].offset;
-
-                    int res = mz_uncompress(seg_ptr.get(mem), &dest_bytes, compressed_segment_bytes, static_cast<mz_ulong>(seg_infos[seg_index].length));
-                    assert(res == MZ_OK);
-                } else {
-                    memcpy(seg_ptr.get(mem), seg_bytes, seg_header.p_filesz);
-                }
+                uint8_t *const seg_ptr = Ptr<uint8_t>(segment_address).get(mem);
+                const segment_info &seg_info = seg_infos[seg_index];
+                load_jobs.emplace_back([&, seg_index, seg_ptr, seg_bytes, seg_info, filesz = seg_header.p_filesz]() {
+                    if (seg_info.compression == 2) {
+                        unsigned long dest_bytes = filesz;
+                        const uint8_t *const compressed_segment_bytes = self_bytes + seg_info.offset;
+
+                        const int res = mz_uncompress(seg_ptr, &dest_bytes, compressed_segment_bytes, static_cast<mz_ulong>(seg_info.length));
+                        if (res != MZ_OK) {
+                            LOG_CRITICAL("Cannot load ELF {}: failed to decompress segment {} ({}).", self_path, seg_index, res);
+                            return false;
+                        }
+                    } else {
+                        memcpy(seg_ptr, seg_bytes, filesz);
+                    }
 
-                for (auto &patch : patches) {
-                    // TODO patches should maybe be able to specify the path/file to patch?
-                    if (seg_index == patch.seg && self_path.find("eboot.bin") != std::string::npos) {
-                        LOG_INFO("Patching segment {} at offset 0x{:X} with {} values", seg_index, patch.offset, patch.values.size());
-                        memcpy(seg_ptr.get(mem) + patch.offset, patch.values.data(), patch.values.size());
+                    for (auto &patch : patches) {
+                        // TODO patches should maybe be able to specify the path/file to patch?
+                        if (seg_index == patch.seg && self_path.find("eboot.bin") != std::string::npos) {
+                            LOG_INFO("Patching segment {} at offset 0x{:X} with {} values", seg_index, patch.offset, patch.values.size());
+                            memcpy(seg_ptr + patch.offset, patch.values.data(), patch.values.size());
+                        }
                     }
-                }
+                    return true;
+                });
 
                 segment_reloc_info[seg_index] = { segment_address, seg_header.p_vaddr, seg_header.p_memsz };
             }
         } else if (seg_header.p_type == PT_SCE_RELA) {
-            if (seg_infos[seg_index].compression == 2) {
-                unsigned long dest_bytes = seg_header.p_filesz;
-                const uint8_t *const compressed_segment_bytes = self_bytes + seg_infos[seg_index].offset;
-                auto uncompressed = std::make_unique<uint8_t[]>(dest_bytes);
-
-                int res = mz_uncompress(uncompressed.get(), &dest_bytes, compressed_segment_bytes, static_cast<mz_ulong>(seg_infos[seg_index].length));
-                assert(res == MZ_OK);
-                if (!relocate(uncompressed.get(), seg_header.p_filesz, segment_reloc_info, mem)) {
-                    return -1;
+            const segment_info &seg_info = seg_infos[seg_index];
+            reloc_jobs.emplace_back([&, seg_index, seg_bytes, seg_info, filesz = seg_header.p_filesz]() {
+                if (seg_info.compression == 2) {
+                    unsigned long dest_bytes = filesz;
+                    const uint8_t *const compressed_segment_bytes = self_bytes + seg_info.offset;
+                    auto uncompressed = std::make_unique<uint8_t[]>(dest_bytes);
+
+                    const int res = mz_uncompress(uncompressed.get(), &dest_bytes, compressed_segment_bytes, static_cast<mz_ulong>(seg_info.length));
+                    if (res != MZ_OK) {
+                        LOG_CRITICAL("Cannot load ELF {}: failed to decompress relocation segment {} ({}).", self_path, seg_index, res);
+                        return false;
+                    }
+                    return relocate(uncompressed.get(), filesz, segment_reloc_info, mem);
                 }
 
-            } else {
-                if (!relocate(seg_bytes, seg_header.p_filesz, segment_reloc_info, mem)) {
-                    return -1;
-                }
-            }
+                return relocate(seg_bytes, filesz, segment_reloc_info, mem);
+            });
         } else if ((seg_header.p_type == PT_SCE_COMMENT) || (seg_header.p_type == PT_SCE_VERSION)
             || (seg_header.p_type == PT_ARM_EXIDX) /* TODO: this may be important and require being loaded */) {
             LOG_INFO("{}: Skipping special segment {}...", self_path, log_hex(seg_header.p_type));
@@ -670,6 +761,26 @@ SceUID load_self(KernelState &kernel, MemState &mem, const void *self, const std
         }
     }
 
+    // All the loadable segments must be in place before any relocation is applied
+    if (!run_segment_jobs(kernel, load_jobs)) {
+        free_all_segments(mem, segment_reloc_info);
+        return -1;
+    }
+    const auto reloc_start = std::chrono::steady_clock::now();
+    if (!run_segment_jobs(kernel, reloc_jobs)) {
+        free_all_segments(mem, segment_reloc_info);
+        return -1;
+    }
+    const auto reloc_end = std::chrono::steady_clock::now();
+
+    // Statically linked functions with a HLE export doing the same work are replaced once the code is relocated
+    size_t replaced_functions = 0;
+    for (const auto &[seg_index, segment] : segment_reloc_info) {
+        if (segments[seg_index].p_flags & PF_X)
+            replaced_functions += kernel.function_replacements.replace(mem, segment.addr, segments[seg_index].p_filesz);
+    }
+    LOG_INFO_IF(replaced_functions > 0, "Replaced {} functions of module {}", replaced_functions, self_path);
+
     if (kernel.debugger.dump_elfs) {
         // Dump elf
         std::vector<uint8_t> dump_elf(self_bytes + self_header.header_len, self_bytes + self_header.self_filesize);
@@ -754,13 +865,22 @@ SceUID load_self(KernelState &kernel, MemState &mem, const void *self, const std
     sceKernelModuleInfo->state = module_info->type;
 
     LOG_INFO("Linking SELF {}...", self_path);
-    if (!load_exports(sceKernelModuleInfo, *module_info, module_info_segment_address, kernel, mem)) {
+    StubInvalidations invalidations;
+    if (!load_exports(sceKernelModuleInfo, *module_info, module_info_segment_address, kernel, mem, invalidations)) {
+        invalidations.flush(kernel);
         return -1;
     }
+    invalidations.flush(kernel);
+    const auto exports_end = std::chrono::steady_clock::now();
 
     if (!load_imports(*module_info, module_info_segment_address, segment_reloc_info, kernel, mem)) {
         return -1;
     }
+    const auto imports_end = std::chrono::steady_clock::now();
+
+    LOG_INFO("Loaded {} in {} us (segments: {} us, relocation: {} us, exports: {} us, imports: {} us)", self_path,
+        elapsed_us(load_start, imports_end), elapsed_us(load_start, reloc_start), elapsed_us(reloc_start, reloc_end),
+        elapsed_us(reloc_end, exports_end), elapsed_us(exports_end, imports_end));
     const SceUID uid = kernel.get_next_uid();
     sceKernelModuleInfo->modid = uid;
     {
@@ -778,7 +898,10 @@ SceUID load_self(KernelState &kernel, MemState &mem, const void *self, const std
 int unload_self(KernelState &kernel, MemState &mem, KernelModule &module) {
     LOG_INFO("Unlinking self...");
     const sce_module_info_raw *const module_info = reinterpret_cast<const sce_module_info_raw *>(module.info_segment_address.get(mem) + module.info_offset);
-    if (!load_exports(&module.info, *module_info, module.info_segment_address, kernel, mem, true)) {
+    StubInvalidations invalidations;
+    const bool unlinked = load_exports(&module.info, *module_info, module.info_segment_address, kernel, mem, invalidations, true);
+    invalidations.flush(kernel);
+    if (!unlinked) {
         return -1;
     }
 
@@ -19,6 +19,7 @@
 #include <kernel/thread/thread_state.h>
 
 #include <kernel/state.h>
+#include <mem/functions.h>
 #include <mem/ptr.h>
 #include <util/align.h>
 
@@ -29,6 +30,9 @@
 #include <memory>
 #include <sstream>
 
+// reserved for the kernel at the start of the TLS block of each thread, the user TLS comes after it
+constexpr size_t KERNEL_TLS_SIZE = 0x800;
+
 void ThreadSignal::wait() {
     std::unique_lock<std::mutex> lock(mutex);
     recv_cond.wait(lock, [&]() { return signaled; });
@@ -45,21 +49,33 @@ bool ThreadSignal::send() {
     return true;
 }
 
-int ThreadState::init(const char *name, Ptr<const void> entry_point, int init_priority, SceInt32 affinity_mask, int stack_size, const SceKernelThreadOptParam *option = nullptr) {
-    constexpr size_t KERNEL_TLS_SIZE = 0x800;
+bool ThreadState::create_cpu() {
+    int core_num = kernel.corenum_allocator.new_corenum();
+    if (core_num < 0) {
+        LOG_ERROR("Out of core number to allocate, use 0");
+        core_num = 0;
+    }
+
+    cpu = init_cpu(kernel.cpu_backend, kernel.cpu_opt, id, static_cast<std::size_t>(core_num), mem, kernel.cpu_protocol.get());
+    if (!cpu) {
+        return false;
+    }
+    if (kernel.debugger.watch_code) {
+        set_log_code(*cpu, true);
+    }
+    if (kernel.debugger.watch_memory) {
+        set_log_mem(*cpu, true);
+    }
+    return true;
+}
 
+int ThreadState::init(const char *name, Ptr<const void> entry_point, int init_priority, SceInt32 affinity_mask, int stack_size, const SceKernelThreadOptParam *option = nullptr) {
     // the stack size should be page-aligned
     stack_size = align(stack_size, KiB(4));
 
     this->name = name;
     this->entry_point = entry_point.address();
 
-    int core_num = kernel.corenum_allocator.new_corenum();
-    if (core_num < 0) {
-        LOG_ERROR("Out of core number to allocate, use 0");
-        core_num = 0;
-    }
-
     if (init_priority > SCE_KERNEL_LOWEST_PRIORITY_USER) {
         assert(SCE_KERNEL_HIGHEST_DEFAULT_PRIORITY <= init_priority && init_priority <= SCE_KERNEL_LOWEST_DEFAULT_PRIORITY);
         priority = init_priority - SCE_KERNEL_DEFAULT_PRIORITY + SCE_KERNEL_GAME_DEFAULT_PRIORITY_ACTUAL;
@@ -71,16 +87,9 @@ int ThreadState::init(const char *name, Ptr<const void> entry_point, int init_pr
     start_tick = rtc_get_ticks(kernel.base_tick.tick);
     last_vblank_waited = 0;
 
-    cpu = init_cpu(kernel.cpu_backend, kernel.cpu_opt, id, static_cast<std::size_t>(core_num), mem, kernel.cpu_protocol.get());
-    if (!cpu) {
+    if (!create_cpu()) {
         return SCE_KERNEL_ERROR_ERROR;
     }
-    if (kernel.debugger.watch_code) {
-        set_log_code(*cpu, true);
-    }
-    if (kernel.debugger.watch_memory) {
-        set_log_mem(*cpu, true);
-    }
 
     std::string alloc_name = fmt::format("Stack for thread {} (#{})", name, id);
     stack = alloc_block(mem, stack_size, alloc_name.c_str());
@@ -260,7 +269,7 @@ bool ThreadState::run_loop() {
 
             // handle svc call if this was what stopped the cpu
             if (cpu->svc_called) {
-                cpu->protocol->call_svc(*cpu, cpu->svc_called, read_pc(*cpu), *this);
+                cpu->protocol->call_svc(*cpu, cpu->svc, read_pc(*cpu), *this);
             }
 
             lock.lock();
@@ -413,6 +422,70 @@ void ThreadState::resume(bool step) {
     something_to_do.notify_one();
 }
 
+ThreadSnapshot ThreadState::get_snapshot() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    ThreadSnapshot snapshot;
+    snapshot.id = id;
+    snapshot.name = name;
+    snapshot.entry_point = entry_point;
+    snapshot.stack = stack.get();
+    snapshot.stack_size = stack_size;
+    snapshot.tls = tls.get();
+    snapshot.halt_instruction = cpu->halt_instruction.get();
+    snapshot.priority = priority;
+    snapshot.affinity_mask = affinity_mask;
+    snapshot.start_tick = start_tick;
+    snapshot.status = status;
+    snapshot.call_level = call_level;
+    snapshot.run_start_callback = run_start_callback;
+    snapshot.init_context = init_cpu_ctx;
+    snapshot.context = save_context(*cpu);
+    snapshot.returned_value = returned_value;
+
+    if (status == ThreadStatus::wait) {
+        // the pc is right after the svc of the kernel call the thread waits in, the host side of the wait can not be saved
+        snapshot.context.cpu_registers[15] -= snapshot.context.thumb() ? 2 : 4;
+    }
+
+    return snapshot;
+}
+
+int ThreadState::restore(const ThreadSnapshot &snapshot) {
+    name = snapshot.name;
+    entry_point = snapshot.entry_point;
+    priority = snapshot.priority;
+    affinity_mask = snapshot.affinity_mask;
+    stack_size = snapshot.stack_size;
+    start_tick = snapshot.start_tick;
+    last_vblank_waited = 0;
+    returned_value = snapshot.returned_value;
+
+    if (!create_cpu()) {
+        return SCE_KERNEL_ERROR_ERROR;
+    }
+
+    // take the ownership of the blocks allocated again by the snapshot, the halt instruction allocated by init_cpu is freed
+    const auto free_block = [&mem = mem](Address address) {
+        free(mem, address);
+    };
+    stack = Block(snapshot.stack, free_block);
+    tls = Block(snapshot.tls, free_block);
+    cpu->halt_instruction = Block(snapshot.halt_instruction, free_block);
+    cpu->halt_instruction_pc = snapshot.halt_instruction | 1;
+    write_tpidruro(*cpu, tls.get() + KERNEL_TLS_SIZE);
+
+    init_cpu_ctx = snapshot.init_context;
+    load_context(*cpu, snapshot.context);
+    call_level = snapshot.call_level;
+    run_start_callback = snapshot.run_start_callback;
+
+    // a waiting thread makes its kernel call again once resumed
+    status = (call_level == 0) ? ThreadStatus::dormant : ThreadStatus::suspend;
+    to_do = ThreadToDo::wait;
+
+    return 0;
+}
+
 std::string ThreadState::log_stack_traceback() const {
     constexpr Address START_OFFSET = 0;
     constexpr Address END_OFFSET = 1024;
@@ -0,0 +1,180 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/function_replacement.h>
+#include <kernel/import_fast_path.h>
+
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t NID_STRLEN = 0xCFC6A9AC;
+
+// push {r4, lr}; the next two instructions load addresses the linker picks
+constexpr const char *THUMB_LINE = "memcpy 7205BFDB thumb 10B5 ??4C ??4B 2168 1960 10BD # relocated loads";
+constexpr const char *ARM_LINE = "strlen CFC6A9AC arm 0020A0E1 ????9FE5 0110D0E4 000051E3";
+
+FunctionSignature parse(const char *line) {
+    auto signature = parse_function_signature(line);
+    EXPECT_TRUE(signature.has_value()) << line;
+    return signature ? *signature : FunctionSignature{};
+}
+
+// Code that matches no signature, with functions written at some offsets
+class code_blob {
+public:
+    explicit code_blob(size_t size)
+        : bytes(size, 0xE7) {}
+
+    // Writes the bytes of signature, filling the masked ones with fill
+    void write(size_t offset, const FunctionSignature &signature, uint8_t fill) {
+        for (size_t i = 0; i < signature.bytes.size(); i++)
+            bytes[offset + i] = signature.mask[i] ? signature.bytes[i] : fill;
+    }
+
+    std::vector<uint8_t> bytes;
+};
+
+} // namespace
+
+TEST(function_replacement, parses_signatures) {
+    const FunctionSignature thumb = parse(THUMB_LINE);
+    EXPECT_EQ(thumb.name, "memcpy");
+    EXPECT_EQ(thumb.nid, NID_MEMCPY);
+    EXPECT_TRUE(thumb.thumb);
+    EXPECT_EQ(thumb.bytes, std::vector<uint8_t>({ 0x10, 0xB5, 0x00, 0x4C, 0x00, 0x4B, 0x21, 0x68, 0x19, 0x60, 0x10, 0xBD }));
+    EXPECT_EQ(thumb.mask, std::vector<uint8_t>({ 0xFF, 0xFF, 0x00, 0xFF, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }));
+
+    // the masked bytes are not part of the hash
+    FunctionSignature other = thumb;
+    other.bytes[2] = 0x42;
+    EXPECT_EQ(hash_masked(other.bytes.data(), other.mask.data(), other.bytes.size()), thumb.hash);
+    other.bytes[3] = 0x4D;
+    EXPECT_NE(hash_masked(other.bytes.data(), other.mask.data(), other.bytes.size()), thumb.hash);
+
+    EXPECT_FALSE(parse(ARM_LINE).thumb);
+
+    EXPECT_FALSE(parse_function_signature("memcpy 7205BFDB mips 10B5 2168"));
+    EXPECT_FALSE(parse_function_signature("memcpy 7205BFDB thumb 10B 52168"));
+    EXPECT_FALSE(parse_function_signature("memcpy 7205BFDB thumb 10G5"));
+    EXPECT_FALSE(parse_function_signature("memcpy 7205BFDX thumb 10B5"));
+    EXPECT_FALSE(parse_function_signature("memcpy 7205BFDB thumb # 10B5"));
+}
+
+TEST(function_replacement, rejects_unusable_signatures) {
+    FunctionReplacements replacements;
+    // too short for the jump to the stub
+    EXPECT_FALSE(replacements.add(parse("short 7205BFDB thumb 10B5 2168 1960")));
+    EXPECT_FALSE(replacements.add(parse("short 7205BFDB arm 0020A0E1")));
+    // nothing to look for
+    EXPECT_FALSE(replacements.add(parse("masked 7205BFDB arm ???????? 0110D0E4 000051E3")));
+    EXPECT_EQ(replacements.size(), 0u);
+
+    EXPECT_TRUE(replacements.add(parse(THUMB_LINE)));
+    EXPECT_TRUE(replacements.add(parse(ARM_LINE)));
+    EXPECT_EQ(replacements.size(), 2u);
+}
+
+TEST(function_replacement, finds_functions) {
+    FunctionReplacements replacements;
+    ASSERT_TRUE(replacements.add(parse(THUMB_LINE)));
+    ASSERT_TRUE(replacements.add(parse(ARM_LINE)));
+    const FunctionSignature &thumb = replacements.get(0);
+    const FunctionSignature &arm = replacements.get(1);
+
+    code_blob code(512);
+    code.write(34, thumb, 0x11);
+    code.write(100, thumb, 0x22);
+    // one compared byte differs
+    code.write(160, thumb, 0x33);
+    code.bytes[160 + 7] = 0x69;
+    // ARM functions start on 4 bytes
+    code.write(202, arm, 0x44);
+    code.write(300, arm, 0x55);
+    // cut by the end of the code
+    code.write(500, thumb, 0x66);
+
+    const std::vector<FunctionMatch> matches = replacements.find(code.bytes.data(), 508);
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].signature, 0u);
+    EXPECT_EQ(matches[0].offset, 34u);
+    EXPECT_EQ(matches[1].signature, 0u);
+    EXPECT_EQ(matches[1].offset, 100u);
+    EXPECT_EQ(matches[2].signature, 1u);
+    EXPECT_EQ(matches[2].offset, 300u);
+}
+
+TEST(function_replacement, jumps_to_stub) {
+    FunctionReplacements replacements;
+    ASSERT_TRUE(replacements.add(parse(THUMB_LINE)));
+    ASSERT_TRUE(replacements.add(parse(ARM_LINE)));
+
+    MemState mem;
+    ASSERT_TRUE(init(mem, false));
+    const Address base = alloc_at(mem, 0x81000000, KiB(4), "function replacement test");
+    ASSERT_EQ(base, 0x81000000u);
+
+    code_blob code(256);
+    code.write(16, replacements.get(0), 0x11);
+    code.write(66, replacements.get(0), 0x22);
+    code.write(128, replacements.get(1), 0x33);
+    memcpy(Ptr<uint8_t>(base).get(mem), code.bytes.data(), code.bytes.size());
+
+    EXPECT_EQ(replacements.replace(mem, base, static_cast<uint32_t>(code.bytes.size())), 3u);
+
+    const auto halfword = [&](Address address) { return *Ptr<uint16_t>(address).get(mem); };
+    const auto word = [&](Address address) { return *Ptr<uint32_t>(address).get(mem); };
+
+    // ldr.w pc, [pc] with the stub right after
+    EXPECT_EQ(halfword(base + 16), 0xF8DF);
+    EXPECT_EQ(halfword(base + 18), 0xF000);
+    const Address thumb_stub = word(base + 20);
+    // ldr.w pc, [pc, #4]; nop with the stub on the next word
+    EXPECT_EQ(halfword(base + 66), 0xF8DF);
+    EXPECT_EQ(halfword(base + 68), 0xF004);
+    EXPECT_EQ(halfword(base + 70), 0xBF00);
+    EXPECT_EQ(word(base + 72), thumb_stub);
+    // ldr pc, [pc, #-4]
+    EXPECT_EQ(word(base + 128), 0xE51FF004);
+    const Address arm_stub = word(base + 132);
+
+    ASSERT_NE(thumb_stub, 0u);
+    ASSERT_NE(arm_stub, thumb_stub);
+    EXPECT_EQ(word(thumb_stub), 0xEF000000 | FUNCTION_REPLACEMENT_SVC);
+    EXPECT_EQ(word(thumb_stub + 4), 0xE1A0F00E);
+    EXPECT_EQ(word(thumb_stub + 8), 0u);
+    EXPECT_EQ(word(arm_stub + 8), 1u);
+
+    EXPECT_EQ(replacements.call(word(thumb_stub + 8)), NID_MEMCPY);
+    EXPECT_EQ(replacements.call(word(thumb_stub + 8)), NID_MEMCPY);
+    EXPECT_EQ(replacements.call(word(arm_stub + 8)), NID_STRLEN);
+
+    const std::vector<FunctionReplacementStats> stats = replacements.get_stats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].name, "memcpy");
+    EXPECT_EQ(stats[0].matches, 2u);
+    EXPECT_EQ(stats[0].calls, 2u);
+    EXPECT_EQ(stats[1].matches, 1u);
+    EXPECT_EQ(stats[1].calls, 1u);
+}
@@ -308,6 +308,8 @@ struct LangState {
         { "miscellaneous", "Miscellaneous" },
         { "toggle_texture_replacement", "Toggle Texture Replacement" },
         { "take_screenshot", "Take A Screenshot" },
+        { "save_snapshot", "Save Snapshot" },
+        { "load_snapshot", "Load Snapshot" },
         { "error_duplicate_key", "The key is used for other bindings or it is reserved." }
     };
     std::map<std::string, std::string> game_data = {
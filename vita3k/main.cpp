@@ -18,6 +18,7 @@
 #include "interface.h"
 
 #include <app/functions.h>
+#include <app/headless.h>
 #include <config/functions.h>
 #include <config/version.h>
 #include <dialog/state.h>
@@ -55,35 +56,31 @@
 #include <cstdlib>
 #include <thread>
 #include <tracy/Tracy.hpp>
+#include <vector>
 
 static void run_execv(char *argv[], EmuEnvState &emuenv) {
-    char const *args[10];
-    args[0] = argv[0];
-    args[1] = "-a";
-    args[2] = "true";
+    // execv does not return, the destructors are not run
+    emuenv.io.write_behind.flush();
+
+    std::vector<const char *> args = { argv[0], "-a", "true" };
     if (!emuenv.load_app_path.empty()) {
-        args[3] = "-r";
-        args[4] = emuenv.load_app_path.data();
+        args.insert(args.end(), { "-r", emuenv.load_app_path.data() });
         if (!emuenv.load_exec_path.empty()) {
-            args[5] = "--self";
-            args[6] = emuenv.load_exec_path.data();
-            if (!emuenv.load_exec_argv.empty()) {
-                args[7] = "--app-args";
-                args[8] = emuenv.load_exec_argv.data();
-                args[9] = nullptr;
-            } else
-                args[7] = nullptr;
-        } else
-            args[5] = nullptr;
-    } else
-        args[3] = nullptr;
-
-        // Execute the emulator again with some arguments
+            args.insert(args.end(), { "--self", emuenv.load_exec_path.data() });
+            if (!emuenv.load_exec_argv.empty())
+                args.insert(args.end(), { "--app-args", emuenv.load_exec_argv.data() });
+        }
+        if (!emuenv.load_snapshot_path.empty())
+            args.insert(args.end(), { "--load-snapshot", emuenv.load_snapshot_path.data() });
+    }
+    args.push_back(nullptr);
+
+    // Execute the emulator again with some arguments
 #ifdef _WIN32
     FreeConsole();
-    _execv(argv[0], args);
+    _execv(argv[0], args.data());
 #elif defined(__unix__) || defined(__APPLE__) && defined(__MACH__)
-    execv(argv[0], const_cast<char *const *>(args));
+    execv(argv[0], const_cast<char *const *>(args.data()));
 #endif
 }
 
@@ -190,7 +187,13 @@ int main(int argc, char *argv[]) {
 #ifdef _WIN32
         SDL_SetHint(SDL_HINT_WINDOWS_DPI_SCALING, "1");
 #endif
-        if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) < 0) {
+        Uint32 sdl_subsystems = SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER;
+        if (cfg.headless) {
+            // Render without any display server, OpenGL goes through EGL pbuffers
+            SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+            sdl_subsystems = SDL_INIT_VIDEO;
+        }
+        if (SDL_Init(sdl_subsystems) < 0) {
             app::error_dialog("SDL initialisation failed.");
             return SDLInitFailed;
         }
@@ -219,7 +222,8 @@ int main(int argc, char *argv[]) {
     GuiState gui;
     if (!cfg.console) {
         gui::pre_init(gui, emuenv);
-        if (!emuenv.cfg.initial_setup) {
+        // Nobody can go through the initial setup in headless mode
+        if (!emuenv.cfg.initial_setup && !cfg.headless) {
             while (!emuenv.cfg.initial_setup) {
                 if (handle_events(emuenv, gui)) {
                     gui::draw_begin(gui, emuenv);
@@ -403,13 +407,29 @@ int main(int argc, char *argv[]) {
         }
     }
     {
-        const auto err = run_app(emuenv, main_module_id);
+        const auto err = cfg.load_snapshot_path ? restore_app(emuenv, fs_utils::utf8_to_path(*cfg.load_snapshot_path)) : run_app(emuenv, main_module_id);
         if (err != Success)
             return err;
     }
+
+    std::optional<app::HeadlessRun> headless_run;
+    if (cfg.headless) {
+        headless_run.emplace();
+        headless_run->start(emuenv);
+    }
+    const auto headless_run_continue = [&]() {
+        return !headless_run || headless_run->update(emuenv);
+    };
+    // handle_events already stops the app on SDL_QUIT
+    bool app_stopped = false;
+    const auto handle_app_events = [&]() {
+        app_stopped = !handle_events(emuenv, gui);
+        return !app_stopped;
+    };
+
     SDL_SetWindowTitle(emuenv.window.get(), fmt::format("{} | {} ({}) | Please wait, loading...", window_title, emuenv.current_app_title, emuenv.io.title_id).c_str());
 
-    while (handle_events(emuenv, gui) && (emuenv.frame_count == 0) && !emuenv.load_exec) {
+    while (handle_app_events() && (emuenv.frame_count == 0) && !emuenv.load_exec && headless_run_continue()) {
         ZoneScopedN("Game loading"); // Tracy - Track game loading loop scope
         // Driver acto!
         renderer::process_batches(*emuenv.renderer.get(), emuenv.renderer->features, emuenv.mem, emuenv.cfg);
@@ -427,7 +447,7 @@ int main(int argc, char *argv[]) {
         FrameMark; // Tracy - Frame end mark for game loading loop
     }
 
-    while (handle_events(emuenv, gui) && !emuenv.load_exec) {
+    while (!app_stopped && handle_app_events() && !emuenv.load_exec && headless_run_continue()) {
         ZoneScopedN("Game rendering"); // Tracy - Track game rendering loop scope
         // Driver acto!
         renderer::process_batches(*emuenv.renderer.get(), emuenv.renderer->features, emuenv.mem, emuenv.cfg);
@@ -438,25 +458,29 @@ int main(int argc, char *argv[]) {
         // Calculate FPS
         app::calculate_fps(emuenv);
 
-        // Set shaders compiled display
-        gui::set_shaders_compiled_display(gui, emuenv);
-
         gui::draw_begin(gui, emuenv);
         if (!emuenv.kernel.is_threads_paused())
             gui::draw_common_dialog(gui, emuenv);
-        gui::draw_vita_area(gui, emuenv);
 
-        if (emuenv.cfg.performance_overlay && !emuenv.kernel.is_threads_paused() && (emuenv.common_dialog.status != SCE_COMMON_DIALOG_STATUS_RUNNING)) {
-            ImGui::PushFont(gui.vita_font[emuenv.current_font_level]);
-            gui::draw_perf_overlay(gui, emuenv);
-            ImGui::PopFont();
-        }
+        // Nobody is looking at the overlays in headless mode, do not spend time drawing them
+        if (!cfg.headless) {
+            // Set shaders compiled display
+            gui::set_shaders_compiled_display(gui, emuenv);
+
+            gui::draw_vita_area(gui, emuenv);
+
+            if (emuenv.cfg.performance_overlay && !emuenv.kernel.is_threads_paused() && (emuenv.common_dialog.status != SCE_COMMON_DIALOG_STATUS_RUNNING)) {
+                ImGui::PushFont(gui.vita_font[emuenv.current_font_level]);
+                gui::draw_perf_overlay(gui, emuenv);
+                ImGui::PopFont();
+            }
 
-        if (emuenv.cfg.current_config.show_touchpad_cursor && !emuenv.kernel.is_threads_paused())
-            gui::draw_touchpad_cursor(emuenv);
+            if (emuenv.cfg.current_config.show_touchpad_cursor && !emuenv.kernel.is_threads_paused())
+                gui::draw_touchpad_cursor(emuenv);
 
-        if (emuenv.display.imgui_render) {
-            gui::draw_ui(gui, emuenv);
+            if (emuenv.display.imgui_render) {
+                gui::draw_ui(gui, emuenv);
+            }
         }
 
         gui::draw_end(gui);
@@ -468,6 +492,13 @@ int main(int argc, char *argv[]) {
     CoUninitialize();
 #endif
 
+    // the loops also end without SDL_QUIT in headless mode or on load_exec
+    if (!app_stopped)
+        stop_app(emuenv);
+
+    if (headless_run)
+        headless_run->write_report(emuenv);
+
     emuenv.renderer->preclose_action();
     app::destroy(emuenv, gui.imgui_state.get());
 
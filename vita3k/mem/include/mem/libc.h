@@ -0,0 +1,46 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h>
+
+#include <cstdint>
+
+struct MemState;
+
+// Host implementations of the libc memory and string routines working on guest memory.
+// Every range is checked against the allocated pages before anything is accessed and a routine
+// returns false, leaving memory untouched, when it is not. Without a page table (fastmem), guest
+// memory is contiguous on the host and the whole range goes through one call to the host routine,
+// with a page table the work is split on the 4 KiB pages it maps.
+// The wide variants work on the 16-bit wchar_t of the Vita and require 2-byte aligned addresses.
+
+// Copy size bytes, the ranges may overlap
+bool guest_memmove(MemState &mem, Address destination, Address source, uint32_t size);
+bool guest_memset(MemState &mem, Address destination, uint8_t value, uint32_t size);
+bool guest_wmemset(MemState &mem, Address destination, uint16_t value, uint32_t count);
+bool guest_memcmp(const MemState &mem, Address lhs, Address rhs, uint32_t size, int &result);
+bool guest_wmemcmp(const MemState &mem, Address lhs, Address rhs, uint32_t count, int &result);
+// found is set to the address of the first match, 0 if there is none
+bool guest_memchr(const MemState &mem, Address address, uint8_t value, uint32_t size, Address &found);
+bool guest_wmemchr(const MemState &mem, Address address, uint16_t value, uint32_t count, Address &found);
+// Length of a string of at most max_length characters, fails if it runs into an invalid page first
+bool guest_strnlen(const MemState &mem, Address str, uint32_t max_length, uint32_t &length);
+bool guest_wcsnlen(const MemState &mem, Address str, uint32_t max_length, uint32_t &length);
+// Compare at most max_length characters of two strings
+bool guest_strncmp(const MemState &mem, Address lhs, Address rhs, uint32_t max_length, int &result);
@@ -0,0 +1,307 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/libc.h>
+
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#else
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Granularity of the page table, strings of unknown length are also scanned by pages of this size
+constexpr uint32_t PAGE_SIZE = KiB(4);
+
+bool is_valid_range(const MemState &mem, Address address, uint64_t size) {
+    if (size == 0)
+        return true;
+
+    const uint64_t end = address + size;
+    return address != 0 && end <= UINT32_MAX && is_valid_addr_range(mem, address, static_cast<Address>(end));
+}
+
+uint8_t *host(const MemState &mem, Address address) {
+    return Ptr<uint8_t>(address).get(mem);
+}
+
+uint16_t *host16(const MemState &mem, Address address) {
+    return Ptr<uint16_t>(address).get(mem);
+}
+
+uint32_t page_left(Address address) {
+    return PAGE_SIZE - address % PAGE_SIZE;
+}
+
+// Number of bytes from address, at most size, which are contiguous in host memory
+uint32_t contiguous(const MemState &mem, Address address, uint32_t size) {
+    return mem.use_page_table ? std::min(size, page_left(address)) : size;
+}
+
+// Call f(host pointer, size) on each host-contiguous part of a valid range until it returns false
+template <typename F>
+void for_each_part(const MemState &mem, Address address, uint32_t size, F &&f) {
+    while (size > 0) {
+        const uint32_t part = contiguous(mem, address, size);
+        if (!f(host(mem, address), part))
+            return;
+        address += part;
+        size -= part;
+    }
+}
+
+// Same with two ranges of the same size walked together
+template <typename F>
+void for_each_part(const MemState &mem, Address lhs, Address rhs, uint32_t size, F &&f) {
+    while (size > 0) {
+        const uint32_t part = contiguous(mem, rhs, contiguous(mem, lhs, size));
+        if (!f(host(mem, lhs), host(mem, rhs), part))
+            return;
+        lhs += part;
+        rhs += part;
+        size -= part;
+    }
+}
+
+// The host libc has vectorized versions of the byte routines but nothing for 16-bit characters
+
+// Index of the first element equal to value, count if there is none
+size_t find16(const uint16_t *data, size_t count, uint16_t value) {
+    size_t i = 0;
+#if defined(__aarch64__)
+    const uint16x8_t needle = vdupq_n_u16(value);
+    for (; i + 8 <= count; i += 8) {
+        if (vmaxvq_u16(vceqq_u16(vld1q_u16(data + i), needle)) != 0)
+            break;
+    }
+#else
+    const __m128i needle = _mm_set1_epi16(static_cast<short>(value));
+    for (; i + 8 <= count; i += 8) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(block, needle)) != 0)
+            break;
+    }
+#endif
+    for (; i < count; i++) {
+        if (data[i] == value)
+            return i;
+    }
+    return count;
+}
+
+void fill16(uint16_t *data, size_t count, uint16_t value) {
+    size_t i = 0;
+#if defined(__aarch64__)
+    const uint16x8_t block = vdupq_n_u16(value);
+    for (; i + 8 <= count; i += 8)
+        vst1q_u16(data + i, block);
+#else
+    const __m128i block = _mm_set1_epi16(static_cast<short>(value));
+    for (; i + 8 <= count; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), block);
+#endif
+    for (; i < count; i++)
+        data[i] = value;
+}
+
+} // namespace
+
+bool guest_memmove(MemState &mem, Address destination, Address source, uint32_t size) {
+    if (!is_valid_range(mem, destination, size) || !is_valid_range(mem, source, size))
+        return false;
+
+    if (!mem.use_page_table) {
+        std::memmove(host(mem, destination), host(mem, source), size);
+        return true;
+    }
+
+    // the parts must be copied from the end when the destination overlaps the end of the source
+    if (destination > source && destination - source < size) {
+        while (size > 0) {
+            const Address destination_end = destination + size;
+            const Address source_end = source + size;
+            const uint32_t part = std::min({ size, (destination_end - 1) % PAGE_SIZE + 1, (source_end - 1) % PAGE_SIZE + 1 });
+            std::memmove(host(mem, destination_end - part), host(mem, source_end - part), part);
+            size -= part;
+        }
+        return true;
+    }
+
+    for_each_part(mem, destination, source, size, [](uint8_t *dst, const uint8_t *src, uint32_t part) {
+        std::memmove(dst, src, part);
+        return true;
+    });
+    return true;
+}
+
+bool guest_memset(MemState &mem, Address destination, uint8_t value, uint32_t size) {
+    if (!is_valid_range(mem, destination, size))
+        return false;
+
+    for_each_part(mem, destination, size, [value](uint8_t *dst, uint32_t part) {
+        std::memset(dst, value, part);
+        return true;
+    });
+    return true;
+}
+
+bool guest_wmemset(MemState &mem, Address destination, uint16_t value, uint32_t count) {
+    if (destination % 2 != 0 || !is_valid_range(mem, destination, uint64_t(count) * 2))
+        return false;
+
+    for_each_part(mem, destination, count * 2, [value](uint8_t *dst, uint32_t part) {
+        fill16(reinterpret_cast<uint16_t *>(dst), part / 2, value);
+        return true;
+    });
+    return true;
+}
+
+bool guest_memcmp(const MemState &mem, Address lhs, Address rhs, uint32_t size, int &result) {
+    if (!is_valid_range(mem, lhs, size) || !is_valid_range(mem, rhs, size))
+        return false;
+
+    result = 0;
+    for_each_part(mem, lhs, rhs, size, [&result](const uint8_t *a, const uint8_t *b, uint32_t part) {
+        result = std::memcmp(a, b, part);
+        return result == 0;
+    });
+    return true;
+}
+
+bool guest_wmemcmp(const MemState &mem, Address lhs, Address rhs, uint32_t count, int &result) {
+    if (lhs % 2 != 0 || rhs % 2 != 0 || !is_valid_range(mem, lhs, uint64_t(count) * 2) || !is_valid_range(mem, rhs, uint64_t(count) * 2))
+        return false;
+
+    result = 0;
+    for_each_part(mem, lhs, rhs, count * 2, [&result](const uint8_t *a, const uint8_t *b, uint32_t part) {
+        // memcmp finds out quickly whether the parts differ, but not in which order 16-bit characters compare
+        if (std::memcmp(a, b, part) == 0)
+            return true;
+
+        const auto *wa = reinterpret_cast<const uint16_t *>(a);
+        const auto *wb = reinterpret_cast<const uint16_t *>(b);
+        const auto mismatch = std::mismatch(wa, wa + part / 2, wb);
+        result = (*mismatch.first < *mismatch.second) ? -1 : 1;
+        return false;
+    });
+    return true;
+}
+
+bool guest_memchr(const MemState &mem, Address address, uint8_t value, uint32_t size, Address &found) {
+    if (!is_valid_range(mem, address, size))
+        return false;
+
+    found = 0;
+    for_each_part(mem, address, size, [&](const uint8_t *data, uint32_t part) {
+        const auto *match = static_cast<const uint8_t *>(std::memchr(data, value, part));
+        if (match)
+            found = address + static_cast<uint32_t>(match - data);
+        address += part;
+        return match == nullptr;
+    });
+    return true;
+}
+
+bool guest_wmemchr(const MemState &mem, Address address, uint16_t value, uint32_t count, Address &found) {
+    if (address % 2 != 0 || !is_valid_range(mem, address, uint64_t(count) * 2))
+        return false;
+
+    found = 0;
+    for_each_part(mem, address, count * 2, [&](const uint8_t *data, uint32_t part) {
+        const size_t index = find16(reinterpret_cast<const uint16_t *>(data), part / 2, value);
+        if (index < part / 2)
+            found = address + static_cast<uint32_t>(index * 2);
+        address += part;
+        return found == 0;
+    });
+    return true;
+}
+
+bool guest_strnlen(const MemState &mem, Address str, uint32_t max_length, uint32_t &length) {
+    // the length is unknown, so the validity of each page is only checked once the scan reaches it
+    length = 0;
+    Address address = str;
+    while (length < max_length) {
+        if (address == 0 || !is_valid_addr(mem, address))
+            return false;
+
+        const uint32_t part = std::min(max_length - length, page_left(address));
+        const uint8_t *data = host(mem, address);
+        const auto *nul = static_cast<const uint8_t *>(std::memchr(data, 0, part));
+        if (nul) {
+            length += static_cast<uint32_t>(nul - data);
+            return true;
+        }
+        length += part;
+        address += part;
+    }
+    return true;
+}
+
+bool guest_wcsnlen(const MemState &mem, Address str, uint32_t max_length, uint32_t &length) {
+    if (str % 2 != 0)
+        return false;
+
+    length = 0;
+    Address address = str;
+    while (length < max_length) {
+        if (address == 0 || !is_valid_addr(mem, address))
+            return false;
+
+        const uint32_t part = std::min(max_length - length, page_left(address) / 2);
+        const size_t index = find16(host16(mem, address), part, 0);
+        if (index < part) {
+            length += static_cast<uint32_t>(index);
+            return true;
+        }
+        length += part;
+        address += part * 2;
+    }
+    return true;
+}
+
+bool guest_strncmp(const MemState &mem, Address lhs, Address rhs, uint32_t max_length, int &result) {
+    result = 0;
+    uint32_t compared = 0;
+    while (compared < max_length) {
+        if (lhs == 0 || rhs == 0 || !is_valid_addr(mem, lhs) || !is_valid_addr(mem, rhs))
+            return false;
+
+        // compare up to the end of lhs, a shorter rhs differs at its terminator
+        const uint32_t part = std::min({ max_length - compared, page_left(lhs), page_left(rhs) });
+        const uint8_t *a = host(mem, lhs);
+        const uint8_t *b = host(mem, rhs);
+        const auto *nul = static_cast<const uint8_t *>(std::memchr(a, 0, part));
+        const uint32_t size = nul ? static_cast<uint32_t>(nul - a) + 1 : part;
+        result = std::memcmp(a, b, size);
+        if (result != 0 || nul)
+            return true;
+
+        compared += part;
+        lhs += part;
+        rhs += part;
+    }
+    return true;
+}
@@ -26,6 +26,7 @@
 #include <cstring>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -177,7 +178,7 @@ static Address alloc_inner(MemState &state, uint32_t start_page, uint32_t page_c
     const int ret = mprotect(memory, size, PROT_READ | PROT_WRITE);
     LOG_CRITICAL_IF(ret == -1, "mprotect failed: {}", get_error_msg());
 #endif
-    std::memset(memory, 0, size);
+    // no need to clear the memory: reserved pages are zero and free drops the content of the pages it releases
 
     AllocMemPage &page = state.alloc_table[page_num];
     assert(!page.allocated);
@@ -250,6 +251,47 @@ void protect_inner(MemState &state, Address addr, uint32_t size, const MemPerm p
 #endif
 }
 
+// Run the callbacks of the blocks of the segment overlapping [first, last] and drop the ones which are done,
+// the segment is then shrunk to the blocks left or removed. The protect mutex must be held.
+static void trigger_protect_segment(MemState &state, ProtectSegmentTrees::iterator it, Address first, Address last, bool write) {
+    ProtectSegmentInfo &info = it->second;
+    Address previous_beg = it->first;
+    for (auto ite = info.blocks.begin(); ite != info.blocks.end();) {
+        if (first < ite->first + ite->second.size && ite->first <= last && ite->second.callback(std::max(first, ite->first), write)) {
+            Address beg_unpr = align_down(ite->first, state.page_size);
+            Address end_unpr = align(ite->first + ite->second.size, state.page_size);
+            unprotect_inner(state, beg_unpr, end_unpr - beg_unpr);
+
+            ite = info.blocks.erase(ite);
+        } else {
+            ++ite;
+        }
+    }
+
+    if (info.blocks.empty()) {
+        if (info.ref_count == 0) {
+            unprotect_inner(state, it->first, info.size);
+            state.protect_tree.erase(it);
+        }
+    } else {
+        Address beg_region = info.blocks.begin()->first;
+        Address end_region = info.blocks.rbegin()->first + info.blocks.rbegin()->second.size;
+
+        beg_region = align_down(beg_region, state.page_size);
+        end_region = align(end_region, state.page_size);
+
+        if (beg_region != previous_beg) {
+            ProtectSegmentInfo new_info = std::move(info);
+            new_info.size = end_region - beg_region;
+
+            state.protect_tree.erase(it);
+            state.protect_tree.emplace(beg_region, std::move(new_info));
+        } else {
+            info.size = end_region - beg_region;
+        }
+    }
+}
+
 bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcept {
     const uintptr_t memory_addr = reinterpret_cast<uintptr_t>(state.memory.get());
     const uintptr_t fault_addr = reinterpret_cast<uintptr_t>(addr);
@@ -296,41 +338,31 @@ bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcep
         return true;
     }
 
-    Address previous_beg = it->first;
-    for (auto ite = info.blocks.begin(); ite != info.blocks.end();) {
-        if (vaddr >= ite->first && vaddr < ite->first + ite->second.size && ite->second.callback(vaddr, write)) {
-            Address beg_unpr = align_down(ite->first, state.page_size);
-            Address end_unpr = align(ite->first + ite->second.size, state.page_size);
-            unprotect_inner(state, beg_unpr, end_unpr - beg_unpr);
-
-            ite = info.blocks.erase(ite);
-        } else {
-            ++ite;
-        }
-    }
+    trigger_protect_segment(state, it, vaddr, vaddr, write);
 
-    if (info.blocks.empty() && info.ref_count == 0) {
-        unprotect_inner(state, it->first, info.size);
-        state.protect_tree.erase(it);
-    } else {
-        Address beg_region = info.blocks.begin()->first;
-        Address end_region = info.blocks.rbegin()->first + info.blocks.rbegin()->second.size;
+    return true;
+}
 
-        beg_region = align_down(beg_region, state.page_size);
-        end_region = align(end_region, state.page_size);
+void handle_host_access(MemState &state, Address addr, uint32_t size, bool write) {
+    if (size == 0)
+        return;
 
-        if (beg_region != previous_beg) {
-            ProtectSegmentInfo new_info = std::move(info);
-            new_info.size = end_region - beg_region;
+    const std::lock_guard<std::mutex> lock(state.protect_mutex);
+    const Address last = addr + (size - 1);
 
-            state.protect_tree.erase(it);
-            state.protect_tree.emplace(beg_region, std::move(new_info));
-        } else {
-            info.size = end_region - beg_region;
-        }
+    // only the segments the access would fault on, the callbacks can move a segment so keep their start
+    std::vector<Address> segments;
+    for (auto it = state.protect_tree.lower_bound(last); it != state.protect_tree.end() && it->first + it->second.size > addr; ++it) {
+        const ProtectSegmentInfo &info = it->second;
+        if (info.ref_count == 0 && (info.perm == MemPerm::None || (write && info.perm == MemPerm::ReadOnly)))
+            segments.push_back(it->first);
     }
 
-    return true;
+    for (const Address segment : segments) {
+        const auto it = state.protect_tree.find(segment);
+        if (it != state.protect_tree.end())
+            trigger_protect_segment(state, it, addr, last, write);
+    }
 }
 
 bool add_protect(MemState &state, Address addr, const uint32_t size, const MemPerm perm, const ProtectCallback &callback) {
@@ -547,10 +579,9 @@ void free(MemState &state, Address address) {
     const BOOL ret = VirtualFree(memory, page.size * state.page_size, MEM_DECOMMIT);
     LOG_CRITICAL_IF(!ret, "VirtualFree failed: {}", get_error_msg());
 #else
-    int ret = mprotect(memory, page.size * state.page_size, PROT_NONE);
-    LOG_CRITICAL_IF(ret == -1, "mprotect failed: {}", get_error_msg());
-    ret = madvise(memory, page.size * state.page_size, MADV_DONTNEED);
-    LOG_CRITICAL_IF(ret == -1, "madvise failed: {}", get_error_msg());
+    // replace the pages with new anonymous ones, this also drops the pages mapped from a snapshot file
+    const void *const ret = mmap(memory, page.size * state.page_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    LOG_CRITICAL_IF(ret == MAP_FAILED, "mmap failed: {}", get_error_msg());
 #endif
 }
 
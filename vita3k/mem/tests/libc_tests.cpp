@@ -0,0 +1,191 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/functions.h>
+#include <mem/libc.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t PAGE = KiB(4);
+constexpr uint32_t PAGE_COUNT = 3;
+
+// Three allocated pages, with a page table the middle one is mapped somewhere else on the host
+// so that any access not split on pages ends up in the wrong place
+class guest_libc : public testing::TestWithParam<bool> {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(init(mem, GetParam()));
+        base = alloc_at(mem, 0x81000000, PAGE * PAGE_COUNT, "libc test");
+        ASSERT_EQ(base, 0x81000000u);
+        if (GetParam()) {
+            external.resize(PAGE * 2);
+            external_page = reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(external.data()) + PAGE - 1) & ~uintptr_t(PAGE - 1));
+            add_external_mapping(mem, base + PAGE, PAGE, external_page);
+        }
+    }
+
+    void TearDown() override {
+        if (external_page)
+            remove_external_mapping(mem, external_page);
+    }
+
+    uint8_t &at(uint32_t offset) {
+        return *Ptr<uint8_t>(base + offset).get(mem);
+    }
+
+    void write(uint32_t offset, const std::vector<uint8_t> &data) {
+        for (size_t i = 0; i < data.size(); i++)
+            at(offset + static_cast<uint32_t>(i)) = data[i];
+    }
+
+    std::vector<uint8_t> read(uint32_t offset, uint32_t size) {
+        std::vector<uint8_t> data(size);
+        for (uint32_t i = 0; i < size; i++)
+            data[i] = at(offset + i);
+        return data;
+    }
+
+    MemState mem;
+    Address base = 0;
+    std::vector<uint8_t> external;
+    uint8_t *external_page = nullptr;
+};
+
+std::vector<uint8_t> pattern(size_t size) {
+    std::vector<uint8_t> data(size);
+    std::iota(data.begin(), data.end(), uint8_t(1));
+    std::replace(data.begin(), data.end(), uint8_t(0), uint8_t(0xAA));
+    return data;
+}
+
+} // namespace
+
+TEST_P(guest_libc, memmove_across_pages) {
+    const std::vector<uint8_t> data = pattern(PAGE * 2);
+    write(0, data);
+
+    ASSERT_TRUE(guest_memmove(mem, base + 100, base, PAGE + 1000));
+    std::vector<uint8_t> expected = data;
+    std::memmove(expected.data() + 100, expected.data(), PAGE + 1000);
+    EXPECT_EQ(read(0, PAGE * 2), expected);
+
+    ASSERT_TRUE(guest_memmove(mem, base + 10, base + 300, PAGE + 500));
+    std::memmove(expected.data() + 10, expected.data() + 300, PAGE + 500);
+    EXPECT_EQ(read(0, PAGE * 2), expected);
+}
+
+TEST_P(guest_libc, memset_and_wmemset) {
+    ASSERT_TRUE(guest_memset(mem, base + PAGE - 7, 0x5A, 20));
+    EXPECT_EQ(read(PAGE - 8, 22), std::vector<uint8_t>({ 0, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0 }));
+
+    ASSERT_TRUE(guest_wmemset(mem, base + PAGE - 10, 0x1234, 37));
+    for (uint32_t i = 0; i < 37; i++)
+        EXPECT_EQ(*Ptr<uint16_t>(base + PAGE - 10 + i * 2).get(mem), 0x1234) << i;
+    EXPECT_EQ(at(PAGE - 10 + 74), 0);
+
+    EXPECT_FALSE(guest_wmemset(mem, base + 1, 0x1234, 2));
+}
+
+TEST_P(guest_libc, compares) {
+    const std::vector<uint8_t> data = pattern(64);
+    write(PAGE - 32, data);
+    write(PAGE * 2 + 100, data);
+
+    int result = 1;
+    ASSERT_TRUE(guest_memcmp(mem, base + PAGE - 32, base + PAGE * 2 + 100, 64, result));
+    EXPECT_EQ(result, 0);
+
+    at(PAGE * 2 + 150) = 0xFF;
+    ASSERT_TRUE(guest_memcmp(mem, base + PAGE - 32, base + PAGE * 2 + 100, 64, result));
+    EXPECT_LT(result, 0);
+
+    // 0x0102 is below 0x0201 as a 16-bit character, but its first byte is above
+    *Ptr<uint16_t>(base + PAGE + 204).get(mem) = 0x0102;
+    *Ptr<uint16_t>(base + 204).get(mem) = 0x0201;
+    ASSERT_TRUE(guest_wmemcmp(mem, base + PAGE + 200, base + 200, 4, result));
+    EXPECT_LT(result, 0);
+}
+
+TEST_P(guest_libc, searches) {
+    write(0, pattern(PAGE * 2));
+    at(PAGE + 17) = 0;
+
+    Address found = 0;
+    ASSERT_TRUE(guest_memchr(mem, base + 5, 0, PAGE * 2 - 5, found));
+    EXPECT_EQ(found, base + PAGE + 17);
+    ASSERT_TRUE(guest_memchr(mem, base + 5, 0, PAGE, found));
+    EXPECT_EQ(found, 0u);
+
+    uint32_t length = 0;
+    ASSERT_TRUE(guest_strnlen(mem, base + PAGE - 3, UINT32_MAX, length));
+    EXPECT_EQ(length, 20u);
+    ASSERT_TRUE(guest_strnlen(mem, base + PAGE - 3, 10, length));
+    EXPECT_EQ(length, 10u);
+
+    *Ptr<uint16_t>(base + PAGE + 40).get(mem) = 0xBEEF;
+    *Ptr<uint16_t>(base + PAGE + 42).get(mem) = 0;
+    ASSERT_TRUE(guest_wmemchr(mem, base + 2, 0xBEEF, PAGE, found));
+    EXPECT_EQ(found, base + PAGE + 40);
+    ASSERT_TRUE(guest_wcsnlen(mem, base + PAGE + 18, UINT32_MAX, length));
+    EXPECT_EQ(length, 12u);
+}
+
+TEST_P(guest_libc, strncmp_across_pages) {
+    const char text[] = "a string crossing a page";
+    write(PAGE - 5, std::vector<uint8_t>(text, text + sizeof(text)));
+    write(PAGE * 2 - 9, std::vector<uint8_t>(text, text + sizeof(text)));
+
+    int result = 1;
+    ASSERT_TRUE(guest_strncmp(mem, base + PAGE - 5, base + PAGE * 2 - 9, UINT32_MAX, result));
+    EXPECT_EQ(result, 0);
+
+    at(PAGE * 2 - 9 + 12) = 0;
+    ASSERT_TRUE(guest_strncmp(mem, base + PAGE - 5, base + PAGE * 2 - 9, UINT32_MAX, result));
+    EXPECT_GT(result, 0);
+    ASSERT_TRUE(guest_strncmp(mem, base + PAGE - 5, base + PAGE * 2 - 9, 12, result));
+    EXPECT_EQ(result, 0);
+}
+
+TEST_P(guest_libc, rejects_invalid_ranges) {
+    write(0, pattern(PAGE * 3));
+    const std::vector<uint8_t> before = read(0, PAGE * 3);
+
+    EXPECT_FALSE(guest_memmove(mem, base + PAGE * 2, base, PAGE + 1));
+    EXPECT_FALSE(guest_memset(mem, base - 1, 0, 2));
+    EXPECT_FALSE(guest_memset(mem, 0, 0, 1));
+    EXPECT_EQ(read(0, PAGE * 3), before);
+
+    // no terminator before the end of the allocation
+    uint32_t length = 0;
+    EXPECT_FALSE(guest_strnlen(mem, base, UINT32_MAX, length));
+
+    // an empty range is always fine
+    EXPECT_TRUE(guest_memset(mem, 0, 0, 0));
+}
+
+INSTANTIATE_TEST_SUITE_P(mem, guest_libc, testing::Bool(), [](const testing::TestParamInfo<bool> &info) {
+    return info.param ? "page_table" : "fastmem";
+});
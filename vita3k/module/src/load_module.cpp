@@ -139,7 +139,6 @@ extern const SysmoduleInternalPaths sysmodule_internal_paths = init_sysmodule_in
 
 // Current modules works for loading
 static constexpr auto auto_lle_modules = {
-    SCE_SYSMODULE_SAS,
     SCE_SYSMODULE_PGF,
     SCE_SYSMODULE_SYSTEM_GESTURE,
     SCE_SYSMODULE_XML,
@@ -259,9 +259,16 @@ EXPORT(int, sceAppUtilSaveDataDataRemove, SceAppUtilSaveDataFileSlot *slot, SceA
     return 0;
 }
 
+// The contents are copied and written to the host by the write-behind worker, the save returns without waiting for the disk
+static void save_behind(EmuEnvState &emuenv, const std::string &path, uint64_t offset, const void *data, SceSize size, std::optional<uint64_t> new_size) {
+    vfs::FileUpdate update{ offset, {}, new_size };
+    if (data)
+        update.data.assign(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + size);
+    emuenv.io.write_behind.update(expand_path(emuenv.io, path.c_str(), emuenv.pref_path), std::move(update));
+}
+
 EXPORT(int, sceAppUtilSaveDataDataSave, SceAppUtilSaveDataFileSlot *slot, SceAppUtilSaveDataDataSaveItem *files, unsigned int fileNum, SceAppUtilMountPoint *mountPoint, SceSize *requiredSizeKiB) {
     TRACY_FUNC(sceAppUtilSaveDataDataSave, slot, files, fileNum, mountPoint, requiredSizeKiB);
-    SceUID fd;
 
     if (requiredSizeKiB)
         // requiredSizeKiB must be set to 0 if there is enough space available
@@ -269,27 +276,17 @@ EXPORT(int, sceAppUtilSaveDataDataSave, SceAppUtilSaveDataFileSlot *slot, SceApp
 
     for (unsigned int i = 0; i < fileNum; i++) {
         const auto file_path = construct_savedata0_path(files[i].dataPath.get(emuenv.mem));
+        const void *buf = files[i].buf.get(emuenv.mem);
         switch (files[i].mode) {
         case SCE_APPUTIL_SAVEDATA_DATA_SAVE_MODE_DIRECTORY:
             create_dir(emuenv.io, file_path.c_str(), 0777, emuenv.pref_path, export_name);
             break;
         case SCE_APPUTIL_SAVEDATA_DATA_SAVE_MODE_FILE_TRUNCATE:
-            if (files[i].buf) {
-                fd = open_file(emuenv.io, file_path.c_str(), SCE_O_WRONLY | SCE_O_CREAT, emuenv.pref_path, export_name);
-                seek_file(fd, static_cast<int>(files[i].offset), SCE_SEEK_SET, emuenv.io, export_name);
-                write_file(fd, files[i].buf.get(emuenv.mem), files[i].bufSize, emuenv.io, export_name);
-                close_file(emuenv.io, fd, export_name);
-            }
-            fd = open_file(emuenv.io, file_path.c_str(), SCE_O_WRONLY | SCE_O_APPEND | SCE_O_TRUNC, emuenv.pref_path, export_name);
-            truncate_file(fd, files[i].bufSize + files[i].offset, emuenv.io, export_name);
-            close_file(emuenv.io, fd, export_name);
+            save_behind(emuenv, file_path, files[i].offset, buf, files[i].bufSize, files[i].offset + files[i].bufSize);
             break;
         case SCE_APPUTIL_SAVEDATA_DATA_SAVE_MODE_FILE:
         default:
-            fd = open_file(emuenv.io, file_path.c_str(), SCE_O_WRONLY | SCE_O_CREAT, emuenv.pref_path, export_name);
-            seek_file(fd, static_cast<int>(files[i].offset), SCE_SEEK_SET, emuenv.io, export_name);
-            write_file(fd, files[i].buf.get(emuenv.mem), files[i].bufSize, emuenv.io, export_name);
-            close_file(emuenv.io, fd, export_name);
+            save_behind(emuenv, file_path, files[i].offset, buf, files[i].bufSize, std::nullopt);
             break;
         }
     }
@@ -307,9 +304,7 @@ EXPORT(int, sceAppUtilSaveDataDataSave, SceAppUtilSaveDataFileSlot *slot, SceApp
         modified_time.minute = local.tm_min;
         modified_time.second = local.tm_sec;
         slot->slotParam.get(emuenv.mem)->modifiedTime = modified_time;
-        fd = open_file(emuenv.io, construct_slotparam_path(slot->id).c_str(), SCE_O_WRONLY | SCE_O_CREAT, emuenv.pref_path, export_name);
-        write_file(fd, slot->slotParam.get(emuenv.mem), sizeof(SceAppUtilSaveDataSlotParam), emuenv.io, export_name);
-        close_file(emuenv.io, fd, export_name);
+        save_behind(emuenv, construct_slotparam_path(slot->id), 0, slot->slotParam.get(emuenv.mem), sizeof(SceAppUtilSaveDataSlotParam), std::nullopt);
     }
 
     return 0;
@@ -22,12 +22,14 @@
 #include <kernel/state.h>
 #include <util/lock_and_find.h>
 #include <util/tracy.h>
+#include <util/worker_pool.h>
 
 TRACY_MODULE_NAME(SceAudiodecUser);
 
 enum {
     SCE_AUDIODEC_ERROR_API_FAIL = 0x807F0000,
     SCE_AUDIODEC_ERROR_NOT_INITIALIZED = 0x807F0005,
+    SCE_AUDIODEC_ERROR_INVALID_PTR = 0x807F0008,
     SCE_AUDIODEC_ERROR_INVALID_HANDLE = 0x807F0009,
     SCE_AUDIODEC_ERROR_NOT_HANDLE_IN_USE = 0x807F000A,
     SCE_AUDIODEC_MP3_ERROR_INVALID_MPEG_VERSION = 0x807F2801,
@@ -49,6 +51,10 @@ struct AudiodecState {
     std::mutex mutex;
     DecoderStates decoders;
     CodecDecodersMap codecs;
+
+    // decodes the streams of sceAudiodecDecodeNStreams, held by the thread using the workers
+    std::mutex workers_mutex;
+    WorkerPool workers;
 };
 
 struct SceAudiodecInfoAt9 {
@@ -223,33 +229,31 @@ EXPORT(int, sceAudiodecCreateDecoderResident) {
     return UNIMPLEMENTED();
 }
 
+static DecodeJob make_decode_job(EmuEnvState &emuenv, const SceAudiodecCtrl *ctrl, DecoderState *decoder, SceUInt32 nb_frames) {
+    DecodeJob job;
+    job.decoder = decoder;
+    job.es_data = ctrl->es_data.get(emuenv.mem);
+    job.es_size_max = ctrl->es_size_max;
+    job.pcm_data = ctrl->pcm_data.get(emuenv.mem);
+    job.pcm_size_max = ctrl->pcm_size_max;
+    job.frames = nb_frames;
+    return job;
+}
+
 static int decode_audio_frames(EmuEnvState &emuenv, const char *export_name, SceAudiodecCtrl *ctrl, SceUInt32 nb_frames) {
+    if (!ctrl)
+        return RET_ERROR(SCE_AUDIODEC_ERROR_INVALID_PTR);
+
     const auto state = emuenv.kernel.obj_store.get<AudiodecState>();
     const DecoderPtr &decoder = lock_and_find(ctrl->handle, state->decoders, state->mutex);
 
-    uint8_t *es_data = ctrl->es_data.get(emuenv.mem);
-    uint8_t *pcm_data = ctrl->pcm_data.get(emuenv.mem);
-
-    ctrl->es_size_used = 0;
-    ctrl->pcm_size_given = 0;
-
-    for (uint32_t frame = 0; frame < nb_frames; frame++) {
-        DecoderSize size;
-        if (!decoder->send(es_data, ctrl->es_size_max)
-            || !decoder->receive(pcm_data, &size)) {
-            return RET_ERROR(SCE_AUDIODEC_ERROR_API_FAIL);
-        }
-
-        uint32_t es_size_used = std::min(decoder->get_es_size(), ctrl->es_size_max);
-        assert(es_size_used <= ctrl->es_size_max);
-        ctrl->es_size_used += es_size_used;
-        es_data += es_size_used;
-
-        uint32_t pcm_size_given = size.samples * decoder->get(DecoderQuery::CHANNELS) * sizeof(int16_t);
-        assert(pcm_size_given <= ctrl->pcm_size_max);
-        ctrl->pcm_size_given += pcm_size_given;
-        pcm_data += pcm_size_given;
-    }
+    // the frames of a stream depend on each other, they are always decoded in order on this thread
+    DecodeJob job = make_decode_job(emuenv, ctrl, decoder.get(), nb_frames);
+    const bool success = decode_frames(job);
+    ctrl->es_size_used = job.es_size_used;
+    ctrl->pcm_size_given = job.pcm_size_given;
+    if (!success)
+        return RET_ERROR(SCE_AUDIODEC_ERROR_API_FAIL);
 
     return 0;
 }
@@ -266,7 +270,52 @@ EXPORT(int, sceAudiodecDecodeNFrames, SceAudiodecCtrl *ctrl, SceUInt32 nFrames)
 
 EXPORT(int, sceAudiodecDecodeNStreams, Ptr<SceAudiodecCtrl> *pCtrls, SceUInt32 nStreams) {
     TRACY_FUNC(sceAudiodecDecodeNStreams, pCtrls, nStreams);
-    return UNIMPLEMENTED();
+    const auto state = emuenv.kernel.obj_store.get<AudiodecState>();
+    if (state->codecs.empty())
+        return SCE_AUDIODEC_ERROR_NOT_INITIALIZED;
+    if (!pCtrls)
+        return RET_ERROR(SCE_AUDIODEC_ERROR_INVALID_PTR);
+
+    // keep the decoders alive until all the streams are decoded
+    std::vector<DecoderPtr> decoders(nStreams);
+    std::vector<DecodeJob> jobs(nStreams);
+    for (SceUInt32 i = 0; i < nStreams; i++) {
+        const SceAudiodecCtrl *ctrl = pCtrls[i].get(emuenv.mem);
+        if (!ctrl)
+            return RET_ERROR(SCE_AUDIODEC_ERROR_INVALID_PTR);
+
+        decoders[i] = lock_and_find(ctrl->handle, state->decoders, state->mutex);
+        if (!decoders[i])
+            return RET_ERROR(SCE_AUDIODEC_ERROR_INVALID_HANDLE);
+
+        jobs[i] = make_decode_job(emuenv, ctrl, decoders[i].get(), 1);
+    }
+
+    {
+        // another thread is already using the workers, decode the streams here instead of waiting for it
+        std::unique_lock<std::mutex> lock(state->workers_mutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            if (state->workers.size() != WorkerPool::default_size())
+                state->workers.start(WorkerPool::default_size());
+            decode_frames(state->workers, jobs);
+        } else {
+            for (DecodeJob &job : jobs)
+                decode_frames(job);
+        }
+    }
+
+    bool success = true;
+    for (SceUInt32 i = 0; i < nStreams; i++) {
+        SceAudiodecCtrl *ctrl = pCtrls[i].get(emuenv.mem);
+        ctrl->es_size_used = jobs[i].es_size_used;
+        ctrl->pcm_size_given = jobs[i].pcm_size_given;
+        success &= jobs[i].success;
+    }
+
+    if (!success)
+        return RET_ERROR(SCE_AUDIODEC_ERROR_API_FAIL);
+
+    return 0;
 }
 
 EXPORT(int, sceAudiodecDeleteDecoder, SceAudiodecCtrl *ctrl) {
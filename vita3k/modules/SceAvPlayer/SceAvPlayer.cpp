@@ -94,6 +94,10 @@ struct PlayerInfoState {
     uint32_t audio_buffer_size = 0;
     std::array<Ptr<uint8_t>, RING_BUFFER_COUNT> audio_buffer;
 
+    // last frames handed to the app, swapped with the player frame pools
+    std::vector<uint8_t> video_frame;
+    std::vector<int16_t> audio_frame;
+
     bool do_loop = false;
     bool paused = false;
 
@@ -334,9 +338,8 @@ EXPORT(bool, sceAvPlayerGetAudioData, SceUID player_handle, SceAvPlayerFrameInfo
                 player_info->player.last_sample_count * sizeof(int16_t) * player_info->player.last_channels, true);
         }
     } else {
-        std::vector<int16_t> data = player_info->player.receive_audio();
-
-        if (data.empty())
+        std::vector<int16_t> &data = player_info->audio_frame;
+        if (!player_info->player.receive_audio(data) || data.empty())
             return false;
 
         buffer = get_buffer(player_info, MediaType::AUDIO, emuenv.mem, (uint32_t)data.size() * sizeof(int16_t), false);
@@ -371,7 +374,7 @@ EXPORT(uint32_t, sceAvPlayerGetStreamInfo, SceUID player_handle, SceUInt32 strea
         stream_info->stream_details.video.aspect_ratio = static_cast<float>(size.width) / static_cast<float>(size.height);
         strcpy(stream_info->stream_details.video.language, "ENG");
     } else if (stream_no == 1) { // audio
-        player_info->player.receive_audio(); // TODO: Get audio info without skipping data frames
+        player_info->player.peek_audio();
         stream_info->stream_type = MediaType::AUDIO;
         stream_info->stream_details.audio.channels = player_info->player.last_channels;
         stream_info->stream_details.audio.sample_rate = player_info->player.last_sample_rate;
@@ -411,8 +414,9 @@ EXPORT(bool, sceAvPlayerGetVideoData, SceUID player_handle, SceAvPlayerFrameInfo
         } else {
             buffer = get_buffer(player_info, MediaType::VIDEO, emuenv.mem, H264DecoderState::buffer_size(size), true);
 
-            std::vector<uint8_t> data = player_info->player.receive_video();
-            std::memcpy(buffer.get(emuenv.mem), data.data(), data.size());
+            std::vector<uint8_t> &data = player_info->video_frame;
+            if (player_info->player.receive_video(data))
+                std::memcpy(buffer.get(emuenv.mem), data.data(), data.size());
         }
     } else {
         buffer = get_buffer(player_info, MediaType::VIDEO, emuenv.mem, H264DecoderState::buffer_size(size), false);
@@ -459,7 +463,7 @@ EXPORT(bool, sceAvPlayerIsActive, SceUID player_handle) {
     const auto state = emuenv.kernel.obj_store.get<AvPlayerState>();
     const PlayerPtr &player_info = lock_and_find(player_handle, state->players, state->mutex);
 
-    return !player_info->player.video_playing.empty();
+    return player_info->player.is_playing();
 }
 
 EXPORT(int, sceAvPlayerJumpToTime) {
@@ -505,9 +509,7 @@ EXPORT(int, sceAvPlayerSetTrickSpeed) {
 EXPORT(int, sceAvPlayerStart, SceUID player_handle) {
     const auto state = emuenv.kernel.obj_store.get<AvPlayerState>();
     const PlayerPtr &player_info = lock_and_find(player_handle, state->players, state->mutex);
-    if (!player_info->player.videos_queue.empty()) {
-        player_info->player.pop_video();
-    }
+    player_info->player.pop_video();
     const auto thread = emuenv.kernel.get_thread(thread_id);
     run_event_callback(emuenv, thread, player_info, SCE_AVPLAYER_STATE_PLAY, 0, Ptr<void>(0));
     return 0;
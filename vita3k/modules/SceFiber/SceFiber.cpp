@@ -20,8 +20,6 @@
 #include <cpu/functions.h>
 #include <kernel/state.h>
 
-#include <sstream>
-#include <util/lock_and_find.h>
 #include <util/log.h>
 
 #include <util/tracy.h>
@@ -59,7 +57,8 @@ typedef struct SceFiber {
     Address addrContext;
     SceSize sizeContext;
     char name[32];
-    CPUContext *cpu;
+    // registers of the fiber while it is suspended
+    CalleeSavedContext *cpu;
     SceUInt32 argOnInitialize;
     Ptr<uint32_t> argOnRun;
     FiberStatus status;
@@ -67,147 +66,134 @@ typedef struct SceFiber {
 
 static_assert(sizeof(SceFiber) <= 128, "SceFiber struct size is more than 128");
 
-struct FiberState {
-    std::mutex mutex;
-    std::map<SceUID, SceFiber *> thread_fibers;
-    std::map<SceUID, CPUContext> thread_contexts;
+// Every guest thread runs on its own host thread, so the fiber state of a thread is only ever used from one host
+// thread and switching fibers does not need any lock
+struct ThreadFibers {
+    SceUID thread_id = SCE_UID_INVALID_UID;
+    CPUState *cpu = nullptr;
+    // fiber running on the thread, null when the thread runs its own code
+    SceFiber *fiber = nullptr;
+    // registers of the thread when it started running fibers, restored when they return to it
+    CalleeSavedContext thread_context;
+    Address argOnReturn = 0;
 };
 
-LIBRARY_INIT(SceFiber) {
-    emuenv.kernel.obj_store.create<FiberState>();
-}
+static thread_local ThreadFibers thread_fibers;
 
 constexpr bool LOG_FIBER = false;
 
-static void set_thread_fiber(FiberState &state, const SceUID &tid, SceFiber *fiber) {
-    state.thread_fibers[tid] = fiber;
-}
+static ThreadFibers *get_thread_fibers(EmuEnvState &emuenv, SceUID thread_id) {
+    if (thread_fibers.thread_id == thread_id)
+        return &thread_fibers;
 
-static SceFiber *get_thread_fiber(FiberState &state, const SceUID &tid) {
-    auto fiber = state.thread_fibers.find(tid);
-    if (fiber == state.thread_fibers.end()) {
+    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
+    if (!thread)
         return nullptr;
-    }
-    return fiber->second;
-}
 
-static void set_thread_context(FiberState &state, const SceUID &tid, const CPUContext &ctx) {
-    state.thread_contexts[tid] = ctx;
+    thread_fibers = {};
+    thread_fibers.thread_id = thread_id;
+    thread_fibers.cpu = thread->cpu.get();
+    return &thread_fibers;
 }
 
-static CPUContext get_thread_context(FiberState &state, const SceUID &tid) {
-    return state.thread_contexts[tid];
-}
-
-static std::string describe_fiber(FiberState &state, const ThreadStatePtr &thread, SceFiber *fiber) {
+static std::string describe_fiber(const ThreadFibers &fibers, SceFiber *fiber) {
     std::string str;
     auto back_it = std::back_inserter(str);
     fmt::format_to(back_it, "Fiber (name: {})\n", fiber->name);
     fmt::format_to(back_it, "entry: 0x{:X}\n", fiber->entry.address());
-    fmt::format_to(back_it, "CPU Context:\n{}", fiber->cpu->description());
-    fmt::format_to(back_it, "Referenced from {}\n", thread->id);
-    fmt::format_to(back_it, "CPU Context:\n{}", get_thread_context(state, thread->id).description());
+    fmt::format_to(back_it, "SP: 0x{:0>8x},   LR: 0x{:0>8x}\n", fiber->cpu->sp, fiber->cpu->lr);
+    fmt::format_to(back_it, "Referenced from {}\n", fibers.thread_id);
+    fmt::format_to(back_it, "Thread SP: 0x{:0>8x},   LR: 0x{:0>8x}\n", fibers.thread_context.sp, fibers.thread_context.lr);
     return str;
 }
 
-static void log_fiber(FiberState &state, const ThreadStatePtr &thread, SceFiber *fiber, const std::string &function_name) {
-    LOG_INFO("{}\n{}", function_name, describe_fiber(state, thread, fiber));
+static void log_fiber(const ThreadFibers &fibers, SceFiber *fiber, const std::string &function_name) {
+    LOG_INFO("{}\n{}", function_name, describe_fiber(fibers, fiber));
+}
+
+// Saves the registers of the fiber running on the thread, it resumes from the call it is in when run again
+static void suspend_fiber(ThreadFibers &fibers, Ptr<SceUInt32> argOnRun) {
+    SceFiber *fiber = fibers.fiber;
+    *fiber->cpu = save_callee_saved(*fibers.cpu);
+    fiber->status = FiberStatus::SUSPEND;
+    fiber->argOnRun = argOnRun;
 }
 
-static void setup_fiber_to_run(EmuEnvState &emuenv, const ThreadStatePtr &thread, SceFiber *fiber, uint32_t thread_sp, const uint32_t &argOnRunTo) {
+// Makes the thread run the fiber once the import returns, the returned value is the one the fiber gets in r0
+static SceUInt32 run_fiber(EmuEnvState &emuenv, ThreadFibers &fibers, SceFiber *fiber, SceUInt32 argOnRunTo) {
     assert(fiber->status != FiberStatus::RUN);
-    if (!fiber->addrContext) {
-        fiber->cpu->set_sp(thread_sp);
-        fiber->status = FiberStatus::INIT;
+    fibers.fiber = fiber;
+
+    // a fiber without a context of its own runs on the stack of the thread, it always starts over
+    if (!fiber->addrContext || fiber->status == FiberStatus::INIT) {
+        fiber->status = FiberStatus::RUN;
+        CPUState &cpu = *fibers.cpu;
+        write_sp(cpu, fiber->addrContext ? fiber->addrContext + fiber->sizeContext : fibers.thread_context.sp);
+        write_reg(cpu, 1, argOnRunTo);
+        write_lr(cpu, 0xDEADBEAF);
+        write_pc(cpu, fiber->entry.address());
+        return fiber->argOnInitialize;
     }
 
-    if (fiber->status == FiberStatus::INIT) {
-        fiber->cpu->cpu_registers[0] = fiber->argOnInitialize;
-        fiber->cpu->cpu_registers[1] = argOnRunTo;
-        fiber->cpu->set_pc(fiber->entry.address());
-    } else {
-        if (fiber->argOnRun) {
-            *fiber->argOnRun.get(emuenv.mem) = argOnRunTo;
-        }
-    }
     fiber->status = FiberStatus::RUN;
+    if (fiber->argOnRun) {
+        *fiber->argOnRun.get(emuenv.mem) = argOnRunTo;
+    }
+    // the import stub returns to the call that suspended the fiber
+    load_callee_saved(*fibers.cpu, *fiber->cpu);
+    return SCE_FIBER_OK;
 }
 
-static void initialize_fiber(EmuEnvState &emuenv, const ThreadStatePtr &thread, SceFiber *fiber, const char *name, Ptr<SceFiberEntry> entry, SceUInt32 argOnInitialize, Ptr<void> addrContext, SceSize sizeContext, SceFiberOptParam *params) {
+static void initialize_fiber(EmuEnvState &emuenv, SceFiber *fiber, const char *name, Ptr<SceFiberEntry> entry, SceUInt32 argOnInitialize, Ptr<void> addrContext, SceSize sizeContext, SceFiberOptParam *params) {
     fiber->entry = entry;
     strncpy(fiber->name, name, 32);
     fiber->argOnInitialize = argOnInitialize;
     fiber->argOnRun = nullptr;
     fiber->addrContext = addrContext.address();
     fiber->sizeContext = sizeContext;
-    fiber->cpu = new CPUContext;
+    fiber->cpu = new CalleeSavedContext;
     fiber->status = FiberStatus::INIT;
-    *fiber->cpu = save_context(*thread->cpu);
 
     if (addrContext && sizeContext > 0) {
         memset(addrContext.get(emuenv.mem), 0xCC, sizeContext);
-        fiber->cpu->set_sp(addrContext.address() + sizeContext);
     }
-    fiber->cpu->set_lr(0xDEADBEAF);
 }
 
 EXPORT(int, _sceFiberAttachContextAndRun, SceFiber *fiber, Address addrContext, SceSize sizeContext, SceUInt32 argOnRunTo, Ptr<SceUInt32> argOnRun) {
     TRACY_FUNC(_sceFiberAttachContextAndRun, fiber, addrContext, sizeContext, argOnRunTo, argOnRun);
     // Maybe Need more check on real hw
     STUBBED("Todo: not sure for now");
-    const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
-    const auto thread = emuenv.kernel.get_thread(thread_id);
-    assert(!get_thread_fiber(*state, thread->id));
+    ThreadFibers *fibers = get_thread_fibers(emuenv, thread_id);
+    assert(fibers && !fibers->fiber);
     assert(!fiber->addrContext);
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Attach context and run");
+        log_fiber(*fibers, fiber, "Attach context and run");
     }
 
     fiber->addrContext = addrContext;
     fiber->sizeContext = sizeContext;
-    if (addrContext && sizeContext > 0) {
-        fiber->cpu->set_sp(addrContext + sizeContext);
-    }
-
-    setup_fiber_to_run(emuenv, thread, fiber, read_sp(*thread->cpu), argOnRunTo);
-    set_thread_context(*state, thread->id, save_context(*thread->cpu));
-    set_thread_fiber(*state, thread->id, fiber);
+    fibers->thread_context = save_callee_saved(*fibers->cpu);
+    fibers->argOnReturn = 0;
 
-    load_context(*thread->cpu, *fiber->cpu);
-    return fiber->cpu->cpu_registers[0];
+    return run_fiber(emuenv, *fibers, fiber, argOnRunTo);
 }
 
 EXPORT(int, _sceFiberAttachContextAndSwitch, SceFiber *fiber, Address addrContext, SceSize sizeContext, SceUInt32 argOnRunTo, Ptr<SceUInt32> argOnRun) {
     TRACY_FUNC(_sceFiberAttachContextAndSwitch, fiber, addrContext, sizeContext, argOnRunTo, argOnRun);
     // Maybe Need more check on real hw
     STUBBED("Todo: not sure for now");
-    const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
-    const auto thread = emuenv.kernel.get_thread(thread_id);
-    auto ctx = get_thread_context(*state, thread->id);
-    SceFiber *thread_fiber = get_thread_fiber(*state, thread->id);
+    ThreadFibers *fibers = get_thread_fibers(emuenv, thread_id);
+    assert(fibers && fibers->fiber);
+    assert(!fiber->addrContext);
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Attach context and switch");
+        log_fiber(*fibers, fiber, "Attach context and switch");
     }
 
-    assert(thread_fiber);
-    assert(!fiber->addrContext);
     fiber->addrContext = addrContext;
     fiber->sizeContext = sizeContext;
-    if (addrContext && sizeContext > 0) {
-        fiber->cpu->set_sp(addrContext + sizeContext);
-    }
-
-    *thread_fiber->cpu = save_context(*thread->cpu);
-    setup_fiber_to_run(emuenv, thread, fiber, ctx.get_sp(), argOnRunTo);
-    thread_fiber->status = FiberStatus::SUSPEND;
-    thread_fiber->argOnRun = argOnRun;
-    thread_fiber->cpu->cpu_registers[0] = SCE_FIBER_OK;
-    set_thread_fiber(*state, thread->id, fiber);
-    load_context(*thread->cpu, *fiber->cpu);
+    suspend_fiber(*fibers, argOnRun);
 
-    return fiber->cpu->cpu_registers[0];
+    return run_fiber(emuenv, *fibers, fiber, argOnRunTo);
 }
 
 EXPORT(SceInt32, _sceFiberInitializeImpl, SceFiber *fiber, const char *name, Ptr<SceFiberEntry> entry, SceUInt32 argOnInitialize, Ptr<void> addrContext, SceSize sizeContext, SceFiberOptParam *params) {
@@ -224,12 +210,7 @@ EXPORT(SceInt32, _sceFiberInitializeImpl, SceFiber *fiber, const char *name, Ptr
         return RET_ERROR(SCE_FIBER_ERROR_INVALID);
     }
 
-    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
-    if (!thread) {
-        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_THREAD_ID);
-    }
-
-    initialize_fiber(emuenv, thread, fiber, name, entry, argOnInitialize, addrContext, sizeContext, params);
+    initialize_fiber(emuenv, fiber, name, entry, argOnInitialize, addrContext, sizeContext, params);
 
     return SCE_FIBER_OK;
 }
@@ -248,12 +229,7 @@ EXPORT(int, _sceFiberInitializeWithInternalOptionImpl, SceFiber *fiber, const ch
         return RET_ERROR(SCE_FIBER_ERROR_INVALID);
     }
 
-    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
-    if (!thread) {
-        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_THREAD_ID);
-    }
-
-    initialize_fiber(emuenv, thread, fiber, name, entry, argOnInitialize, addrContext, sizeContext, nullptr);
+    initialize_fiber(emuenv, fiber, name, entry, argOnInitialize, addrContext, sizeContext, nullptr);
 
     return SCE_FIBER_OK;
 }
@@ -299,15 +275,13 @@ EXPORT(int, sceFiberGetInfo, SceFiber *fiber, SceFiberInfo *fiberInfo) {
 
 EXPORT(SceUInt32, sceFiberGetSelf, Ptr<SceFiber> *fiber) {
     TRACY_FUNC(sceFiberGetSelf, fiber);
-    const auto state = emuenv.kernel.obj_store.get<FiberState>();
     if (!fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_NULL);
     }
 
-    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
-    SceFiber *thread_fiber = get_thread_fiber(*state, thread->id);
-    if (thread_fiber)
-        *fiber = Ptr<SceFiber>(thread_fiber, emuenv.mem);
+    const ThreadFibers *fibers = get_thread_fibers(emuenv, thread_id);
+    if (fibers && fibers->fiber)
+        *fiber = Ptr<SceFiber>(fibers->fiber, emuenv.mem);
     else
         *fiber = Ptr<SceFiber>(0);
 
@@ -336,30 +310,22 @@ EXPORT(int, sceFiberRenameSelf) {
 
 EXPORT(SceInt32, sceFiberReturnToThread, uint32_t argOnReturnTo, Ptr<uint32_t> argOnRun) {
     TRACY_FUNC(sceFiberReturnToThread, argOnReturnTo, argOnRun);
-    const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
-    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
-    SceFiber *fiber = get_thread_fiber(*state, thread->id);
-    if (!fiber) {
+    ThreadFibers *fibers = get_thread_fibers(emuenv, thread_id);
+    if (!fibers || !fibers->fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_PERMISSION);
     }
 
-    CPUContext thread_context = get_thread_context(*state, thread->id);
-    assert(fiber->status == FiberStatus::RUN);
+    assert(fibers->fiber->status == FiberStatus::RUN);
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Return to thread");
+        log_fiber(*fibers, fibers->fiber, "Return to thread");
     }
 
-    *fiber->cpu = save_context(*thread->cpu);
-    fiber->cpu->cpu_registers[0] = SCE_FIBER_OK;
-    fiber->status = FiberStatus::SUSPEND;
-    fiber->argOnRun = argOnRun;
-    set_thread_fiber(*state, thread->id, nullptr);
+    suspend_fiber(*fibers, argOnRun);
+    fibers->fiber = nullptr;
 
-    load_context(*thread->cpu, thread_context);
-    Address argOnReturn = thread_context.cpu_registers[2];
-    if (argOnReturn) {
-        *(Ptr<uint32_t>(argOnReturn).get(emuenv.mem)) = argOnReturnTo;
+    load_callee_saved(*fibers->cpu, fibers->thread_context);
+    if (fibers->argOnReturn) {
+        *(Ptr<uint32_t>(fibers->argOnReturn).get(emuenv.mem)) = argOnReturnTo;
     }
 
     return SCE_FIBER_OK;
@@ -367,9 +333,6 @@ EXPORT(SceInt32, sceFiberReturnToThread, uint32_t argOnReturnTo, Ptr<uint32_t> a
 
 EXPORT(SceUInt32, sceFiberRun, SceFiber *fiber, SceUInt32 argOnRunTo, Ptr<SceUInt32> argOnReturn) {
     TRACY_FUNC(sceFiberRun, fiber, argOnRunTo, argOnReturn);
-    const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
-    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
     if (!fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_NULL);
     }
@@ -378,20 +341,23 @@ EXPORT(SceUInt32, sceFiberRun, SceFiber *fiber, SceUInt32 argOnRunTo, Ptr<SceUIn
         return RET_ERROR(SCE_FIBER_ERROR_STATE);
     }
 
-    if (get_thread_fiber(*state, thread->id)) {
+    ThreadFibers *fibers = get_thread_fibers(emuenv, thread_id);
+    if (!fibers) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_THREAD_ID);
+    }
+
+    if (fibers->fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_PERMISSION);
     }
 
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Run");
+        log_fiber(*fibers, fiber, "Run");
     }
 
-    setup_fiber_to_run(emuenv, thread, fiber, read_sp(*thread->cpu), argOnRunTo);
-    set_thread_context(*state, thread->id, save_context(*thread->cpu));
-    set_thread_fiber(*state, thread->id, fiber);
+    fibers->thread_context = save_callee_saved(*fibers->cpu);
+    fibers->argOnReturn = argOnReturn.address();
 
-    load_context(*thread->cpu, *fiber->cpu);
-    return fiber->cpu->cpu_registers[0];
+    return run_fiber(emuenv, *fibers, fiber, argOnRunTo);
 }
 
 EXPORT(int, sceFiberStartContextSizeCheck) {
@@ -406,10 +372,6 @@ EXPORT(int, sceFiberStopContextSizeCheck) {
 
 EXPORT(SceUInt32, sceFiberSwitch, SceFiber *fiber, SceUInt32 argOnRunTo, Ptr<SceUInt32> argOnRun) {
     TRACY_FUNC(sceFiberSwitch, fiber, argOnRunTo, argOnRun);
-    const auto state = emuenv.kernel.obj_store.get<FiberState>();
-    const std::lock_guard<std::mutex> lock(state->mutex);
-    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
-    auto ctx = get_thread_context(*state, thread->id);
     if (!fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_NULL);
     }
@@ -418,22 +380,16 @@ EXPORT(SceUInt32, sceFiberSwitch, SceFiber *fiber, SceUInt32 argOnRunTo, Ptr<Sce
         return RET_ERROR(SCE_FIBER_ERROR_STATE);
     }
 
-    SceFiber *thread_fiber = get_thread_fiber(*state, thread->id);
-    if (!thread_fiber) {
+    ThreadFibers *fibers = get_thread_fibers(emuenv, thread_id);
+    if (!fibers || !fibers->fiber) {
         return RET_ERROR(SCE_FIBER_ERROR_PERMISSION);
     }
 
     if (LOG_FIBER) {
-        log_fiber(*state, thread, fiber, "Switch");
+        log_fiber(*fibers, fiber, "Switch");
     }
 
-    *thread_fiber->cpu = save_context(*thread->cpu);
-    thread_fiber->status = FiberStatus::SUSPEND;
-    thread_fiber->argOnRun = argOnRun;
-    thread_fiber->cpu->cpu_registers[0] = SCE_FIBER_OK;
-    set_thread_fiber(*state, thread->id, fiber);
-    setup_fiber_to_run(emuenv, thread, fiber, ctx.get_sp(), argOnRunTo);
-    load_context(*thread->cpu, *fiber->cpu);
+    suspend_fiber(*fibers, argOnRun);
 
-    return fiber->cpu->cpu_registers[0];
+    return run_fiber(emuenv, *fibers, fiber, argOnRunTo);
 }
@@ -42,6 +42,7 @@
 #include <renderer/functions.h>
 #include <renderer/state.h>
 #include <renderer/types.h>
+#include <util/byte_stream.h>
 #include <util/bytes.h>
 #include <util/log.h>
 
@@ -1401,6 +1402,308 @@ static void gxmContextStateRestore(renderer::State &state, SceGxmContext *contex
     }
 }
 
+// Set command allocate functions
+// The command buffer will not be reallocated, so this is fine to use this thread ID
+static void set_command_allocator(EmuEnvState &emuenv, SceGxmContext *ctx, SceUID thread_id) {
+    KernelState *kernel = &emuenv.kernel;
+    MemState *mem = &emuenv.mem;
+
+    ctx->renderer->alloc_func = [ctx, kernel, mem, thread_id]() {
+        return ctx->allocate_new_command(*kernel, *mem, thread_id);
+    };
+
+    ctx->renderer->free_func = [ctx](renderer::Command *cmd) {
+        return ctx->free_new_command(cmd);
+    };
+}
+
+static uint32_t get_display_queue_size(const SceGxmInitializeParams &params) {
+    // hack, limit the number of frame rendering at the same time to at most 3
+    // also, the last frame won't be in the queue so decrease the count by 1
+    // the case where displayQueueMaxPendingCount is 1 handled in sceGxmDisplayQueueAddEntry
+    return std::max(std::min(params.displayQueueMaxPendingCount, 3U) - 1, 1U);
+}
+
+// The guest memory of the GXM objects is in the snapshot, the host state they hold is not.
+// It is saved apart and created again in place, over what is left of the previous process.
+static void save_objects(EmuEnvState &emuenv, std::string &data) {
+    GxmState &gxm = emuenv.gxm;
+    const MemState &mem = emuenv.mem;
+    ByteWriter writer(data);
+
+    writer.write(gxm.params);
+    writer.write(gxm.display_queue_thread);
+    writer.write(gxm.global_timestamp.load());
+    writer.write(gxm.last_display_global);
+    writer.write(gxm.notification_region.address());
+    writer.write(static_cast<uint32_t>(gxm.memory_mapped_regions.size()));
+    for (const auto &[address, info] : gxm.memory_mapped_regions) {
+        writer.write(address);
+        writer.write(info);
+    }
+
+    const std::lock_guard<std::mutex> lock(gxm.objects.mutex);
+    writer.write(static_cast<uint32_t>(gxm.objects.render_targets.size()));
+    for (const auto &[address, params] : gxm.objects.render_targets) {
+        writer.write(address);
+        writer.write(params);
+    }
+
+    writer.write_vector(std::vector<Address>(gxm.objects.sync_objects.begin(), gxm.objects.sync_objects.end()));
+
+    writer.write(static_cast<uint32_t>(gxm.objects.vertex_programs.size()));
+    for (const Address address : gxm.objects.vertex_programs) {
+        const SceGxmVertexProgram *const vp = Ptr<SceGxmVertexProgram>(address).get(mem);
+        writer.write(address);
+        writer.write_vector(vp->streams);
+        writer.write_vector(vp->attributes);
+    }
+
+    writer.write(static_cast<uint32_t>(gxm.objects.fragment_programs.size()));
+    for (const auto &[address, blend_info] : gxm.objects.fragment_programs) {
+        writer.write(address);
+        writer.write(blend_info.has_value());
+        writer.write(blend_info.value_or(SceGxmBlendInfo{}));
+    }
+
+    writer.write(static_cast<uint32_t>(gxm.objects.shader_patchers.size()));
+    for (const Address address : gxm.objects.shader_patchers) {
+        const SceGxmShaderPatcher *const patcher = Ptr<SceGxmShaderPatcher>(address).get(mem);
+        writer.write(address);
+        writer.write(static_cast<uint32_t>(patcher->vertex_program_cache.size()));
+        for (const auto &[key, program] : patcher->vertex_program_cache) {
+            writer.write(key);
+            writer.write(program.address());
+        }
+        writer.write(static_cast<uint32_t>(patcher->fragment_program_cache.size()));
+        for (const auto &[key, program] : patcher->fragment_program_cache) {
+            writer.write(key);
+            writer.write(program.address());
+        }
+    }
+
+    writer.write(static_cast<uint32_t>(gxm.objects.contexts.size()));
+    for (const auto &[address, info] : gxm.objects.contexts) {
+        writer.write(address);
+        writer.write(info.thread_id);
+        writer.write(info.render_target);
+    }
+
+    writer.write(static_cast<uint32_t>(gxm.objects.command_lists.size()));
+    for (const auto &[address, list] : gxm.objects.command_lists) {
+        writer.write(address);
+        writer.write(reinterpret_cast<uint64_t>(list));
+    }
+}
+
+static bool load_objects(EmuEnvState &emuenv, const std::string &data) {
+    GxmState &gxm = emuenv.gxm;
+    MemState &mem = emuenv.mem;
+    renderer::State &renderer = *emuenv.renderer;
+    ByteReader reader(data);
+
+    gxm.params = reader.read<SceGxmInitializeParams>();
+    gxm.display_queue_thread = reader.read<SceUID>();
+    gxm.global_timestamp = reader.read<uint32_t>();
+    gxm.last_display_global = reader.read<uint32_t>();
+    gxm.notification_region = Ptr<uint32_t>(reader.read<Address>());
+    gxm.memory_mapped_regions.clear();
+    const auto region_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < region_count && !reader.failed; i++) {
+        const auto address = reader.read<Address>();
+        const auto info = reader.read<MemoryMapInfo>();
+        gxm.memory_mapped_regions.emplace(address, info);
+        // not waited for, the renderer only runs once the app is started
+        if (renderer.features.support_memory_mapping && info.size > 0)
+            renderer::send_single_command(renderer, nullptr, renderer::CommandOpcode::MemoryMap, false, Ptr<void>(address), info.size);
+    }
+
+    const std::lock_guard<std::mutex> lock(gxm.objects.mutex);
+    gxm.objects.contexts.clear();
+    gxm.objects.render_targets.clear();
+    gxm.objects.sync_objects.clear();
+    gxm.objects.shader_patchers.clear();
+    gxm.objects.vertex_programs.clear();
+    gxm.objects.fragment_programs.clear();
+    gxm.objects.command_lists.clear();
+
+    const auto render_target_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < render_target_count && !reader.failed; i++) {
+        const auto address = reader.read<Address>();
+        const auto params = reader.read<SceGxmRenderTargetParams>();
+        if (reader.failed)
+            break;
+        SceGxmRenderTarget *const rt = Ptr<SceGxmRenderTarget>(address).get(mem);
+        new (rt) SceGxmRenderTarget{ nullptr, params.width, params.height, params.scenesPerFrame, params.driverMemBlock };
+        if (!renderer::create_render_target(renderer, rt->renderer, &params))
+            return false;
+        gxm.objects.render_targets.emplace(address, params);
+    }
+
+    for (const Address address : reader.read_vector<Address>()) {
+        SceGxmSyncObject *const sync = Ptr<SceGxmSyncObject>(address).get(mem);
+        const uint32_t timestamp_ahead = sync->timestamp_ahead.load();
+        const uint32_t last_display = sync->last_display.load();
+        const uint32_t last_operation_global = sync->last_operation_global;
+        new (sync) SceGxmSyncObject;
+        // everything which was submitted is done: the commands of the previous process will never run
+        sync->timestamp_ahead = timestamp_ahead;
+        sync->timestamp_current = timestamp_ahead;
+        sync->last_display = last_display;
+        sync->last_operation_global = last_operation_global;
+        gxm.objects.sync_objects.insert(address);
+    }
+
+    const auto vertex_program_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < vertex_program_count && !reader.failed; i++) {
+        const auto address = reader.read<Address>();
+        auto streams = reader.read_vector<SceGxmVertexStream>();
+        auto attributes = reader.read_vector<SceGxmVertexAttribute>();
+        if (reader.failed)
+            break;
+
+        SceGxmVertexProgram *const vp = Ptr<SceGxmVertexProgram>(address).get(mem);
+        const uint32_t reference_count = vp->reference_count.load();
+        const Ptr<const SceGxmProgram> program = vp->program;
+        const uint64_t key_hash = vp->key_hash;
+        new (vp) SceGxmVertexProgram;
+        vp->reference_count = reference_count;
+        vp->program = program;
+        vp->key_hash = key_hash;
+        vp->streams = std::move(streams);
+        vp->attributes = std::move(attributes);
+        if (!renderer::create(vp->renderer_data, renderer, *program.get(mem), renderer.gxp_ptr_map, vp->attributes))
+            return false;
+        gxm.objects.vertex_programs.insert(address);
+    }
+
+    const auto fragment_program_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < fragment_program_count && !reader.failed; i++) {
+        const auto address = reader.read<Address>();
+        const bool has_blend_info = reader.read<bool>();
+        const auto blend_info = reader.read<SceGxmBlendInfo>();
+        if (reader.failed)
+            break;
+
+        SceGxmFragmentProgram *const fp = Ptr<SceGxmFragmentProgram>(address).get(mem);
+        const uint32_t reference_count = fp->reference_count.load();
+        const Ptr<const SceGxmProgram> program = fp->program;
+        const bool is_maskupdate = fp->is_maskupdate;
+        new (fp) SceGxmFragmentProgram;
+        fp->reference_count = reference_count;
+        fp->program = program;
+        fp->is_maskupdate = is_maskupdate;
+        if (!renderer::create(fp->renderer_data, renderer, *program.get(mem), has_blend_info ? &blend_info : nullptr, renderer.gxp_ptr_map))
+            return false;
+        gxm.objects.fragment_programs.emplace(address, has_blend_info ? std::optional(blend_info) : std::nullopt);
+    }
+
+    const auto shader_patcher_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < shader_patcher_count && !reader.failed; i++) {
+        const auto address = reader.read<Address>();
+        SceGxmShaderPatcher *const patcher = Ptr<SceGxmShaderPatcher>(address).get(mem);
+        const SceGxmShaderPatcherParams params = patcher->params;
+        new (patcher) SceGxmShaderPatcher;
+        patcher->params = params;
+
+        const auto vertex_count = reader.read<uint32_t>();
+        for (uint32_t j = 0; j < vertex_count && !reader.failed; j++) {
+            const auto key = reader.read<VertexProgramCacheKey>();
+            patcher->vertex_program_cache.emplace(key, Ptr<SceGxmVertexProgram>(reader.read<Address>()));
+        }
+        const auto fragment_count = reader.read<uint32_t>();
+        for (uint32_t j = 0; j < fragment_count && !reader.failed; j++) {
+            const auto key = reader.read<FragmentProgramCacheKey>();
+            patcher->fragment_program_cache.emplace(key, Ptr<SceGxmFragmentProgram>(reader.read<Address>()));
+        }
+        gxm.objects.shader_patchers.insert(address);
+    }
+
+    const auto context_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < context_count && !reader.failed; i++) {
+        const auto address = reader.read<Address>();
+        GxmContextInfo info{ reader.read<SceUID>() };
+        info.render_target = reader.read<Address>();
+        if (reader.failed)
+            break;
+
+        SceGxmContext *const ctx = Ptr<SceGxmContext>(address).get(mem);
+        const GxmContextState state = ctx->state;
+        const Ptr<uint8_t> alloc_space = ctx->alloc_space;
+        const Ptr<uint8_t> alloc_space_end = ctx->alloc_space_end;
+        const Ptr<uint8_t> alloc_space_start = ctx->alloc_space_start;
+        const size_t command_allocator_size = ctx->command_allocator_size;
+        new (ctx) SceGxmContext(gxm.callback_lock);
+        ctx->state = state;
+        ctx->alloc_space = alloc_space;
+        ctx->alloc_space_end = alloc_space_end;
+        ctx->alloc_space_start = alloc_space_start;
+
+        if (state.type == SCE_GXM_CONTEXT_TYPE_IMMEDIATE) {
+            if (!renderer::create_context(renderer, ctx->renderer))
+                return false;
+            // nothing is in flight in the new process, the whole command buffer is free
+            ctx->command_allocator_size = command_allocator_size;
+            ctx->command_next_free_pos = 0;
+            ctx->command_last_free_pos = command_allocator_size - 1;
+            set_command_allocator(emuenv, ctx, info.thread_id);
+
+            const auto render_target = gxm.objects.render_targets.find(info.render_target);
+            if (state.active && render_target != gxm.objects.render_targets.end()) {
+                const SceGxmRenderTarget *const rt = Ptr<SceGxmRenderTarget>(info.render_target).get(mem);
+                SceGxmColorSurface *const color_surface = state.color_surface.disabled ? nullptr : new SceGxmColorSurface(state.color_surface);
+                SceGxmDepthStencilSurface *const depth_stencil_surface = state.depth_stencil_surface.disabled() ? nullptr : new SceGxmDepthStencilSurface(state.depth_stencil_surface);
+                renderer::set_context(renderer, ctx->renderer.get(), rt->renderer.get(), color_surface, depth_stencil_surface);
+                gxmContextStateRestore(renderer, ctx, true);
+                ctx->is_vert_texture_dirty.set();
+                ctx->is_frag_texture_dirty.set();
+            } else {
+                ctx->state.active = false;
+            }
+        } else {
+            ctx->renderer = std::make_unique<renderer::Context>();
+            // the command list being recorded is lost, ending it fails
+            ctx->state.active = false;
+        }
+        gxm.objects.contexts.emplace(address, info);
+    }
+
+    // the command lists point to host memory of the previous process, executing them fails instead of crashing
+    const auto command_list_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < command_list_count && !reader.failed; i++) {
+        const auto address = reader.read<Address>();
+        const auto list = reader.read<uint64_t>();
+        if (!is_valid_addr(mem, address))
+            continue;
+        SceGxmCommandList *const command_list = Ptr<SceGxmCommandList>(address).get(mem);
+        if (reinterpret_cast<uint64_t>(command_list->list) == list)
+            command_list->list = nullptr;
+    }
+
+    if (reader.failed)
+        return false;
+
+    if (gxm.notification_region) {
+        gxm.display_queue.maxPendingCount_ = get_display_queue_size(gxm.params);
+        gxm.display_queue.reset();
+        std::thread display_host_thread(display_entry_thread, std::ref(emuenv));
+        display_host_thread.detach();
+    }
+
+    return true;
+}
+
+LIBRARY_INIT(SceGxm) {
+    emuenv.kernel.snapshot_handlers["SceGxm"] = {
+        [&emuenv](std::string &data) {
+            save_objects(emuenv, data);
+        },
+        [&emuenv](const std::string &data) {
+            return load_objects(emuenv, data);
+        },
+    };
+}
+
 EXPORT(int, sceGxmBeginCommandList, SceGxmContext *deferredContext) {
     TRACY_FUNC(sceGxmBeginCommandList, deferredContext);
     if (!deferredContext) {
@@ -1490,6 +1793,17 @@ EXPORT(int, sceGxmBeginScene, SceGxmContext *context, uint32_t flags, const SceG
 
     context->state.fragment_sync_object = fragmentSyncObject;
 
+    // kept to start the scene again if a snapshot is loaded before it ends
+    context->state.color_surface = {};
+    context->state.color_surface.disabled = true;
+    if (colorSurface)
+        context->state.color_surface = *colorSurface;
+    context->state.depth_stencil_surface = depthStencil ? *depthStencil : SceGxmDepthStencilSurface{};
+    {
+        const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+        emuenv.gxm.objects.contexts[Ptr<SceGxmContext>(context, emuenv.mem).address()].render_target = Ptr<const SceGxmRenderTarget>(renderTarget, emuenv.mem).address();
+    }
+
     if (fragmentSyncObject) {
         SceGxmSyncObject *sync = fragmentSyncObject.get(emuenv.mem);
 
@@ -1788,19 +2102,10 @@ EXPORT(int, sceGxmCreateContext, const SceGxmContextParams *params, Ptr<SceGxmCo
     ctx->state.vdm_buffer_size = params->vdmRingBufferMemSize;
 
     ctx->make_new_alloc_space(emuenv.kernel, emuenv.mem, thread_id);
+    set_command_allocator(emuenv, ctx, thread_id);
 
-    // Set command allocate functions
-    // The command buffer will not be reallocated, so this is fine to use this thread ID
-    KernelState *kernel = &emuenv.kernel;
-    MemState *mem = &emuenv.mem;
-
-    ctx->renderer->alloc_func = [ctx, kernel, mem, thread_id]() {
-        return ctx->allocate_new_command(*kernel, *mem, thread_id);
-    };
-
-    ctx->renderer->free_func = [ctx](renderer::Command *cmd) {
-        return ctx->free_new_command(cmd);
-    };
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.contexts[context->address()] = { thread_id };
 
     return 0;
 }
@@ -1828,6 +2133,9 @@ EXPORT(int, sceGxmCreateDeferredContext, SceGxmDeferredContextParams *params, Pt
     // Create a generic context. This is only used for storing command list
     ctx->renderer = std::make_unique<renderer::Context>();
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.contexts[deferredContext->address()] = { thread_id };
+
     return 0;
 }
 
@@ -1861,6 +2169,9 @@ EXPORT(int, sceGxmCreateRenderTarget, const SceGxmRenderTargetParams *params, Pt
     rt->scenesPerFrame = params->scenesPerFrame;
     rt->driverMemBlock = params->driverMemBlock;
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.render_targets[renderTarget->address()] = *params;
+
     return 0;
 }
 
@@ -2008,6 +2319,9 @@ EXPORT(int, sceGxmDestroyContext, Ptr<SceGxmContext> context) {
 
     renderer::destroy_context(*emuenv.renderer, context.get(emuenv.mem)->renderer);
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.contexts.erase(context.address());
+
     return 0;
 }
 
@@ -2016,6 +2330,11 @@ EXPORT(int, sceGxmDestroyDeferredContext, SceGxmContext *deferredContext) {
     if (!deferredContext) {
         return RET_ERROR(SCE_GXM_ERROR_INVALID_POINTER);
     }
+
+    {
+        const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+        emuenv.gxm.objects.contexts.erase(Ptr<SceGxmContext>(deferredContext, emuenv.mem).address());
+    }
     return UNIMPLEMENTED();
 }
 
@@ -2032,6 +2351,9 @@ EXPORT(int, sceGxmDestroyRenderTarget, Ptr<SceGxmRenderTarget> renderTarget) {
 
     free(mem, renderTarget);
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.render_targets.erase(renderTarget.address());
+
     return 0;
 }
 
@@ -2385,6 +2707,10 @@ EXPORT(int, sceGxmEndCommandList, SceGxmContext *deferredContext, SceGxmCommandL
 
     // also update our own command list
     deferredContext->curr_command_list->list = commandList->list;
+    {
+        const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+        emuenv.gxm.objects.command_lists[Ptr<SceGxmCommandList>(commandList, emuenv.mem).address()] = commandList->list;
+    }
 
     *commandList->list = deferredContext->renderer->command_list;
 
@@ -2649,11 +2975,7 @@ EXPORT(int, sceGxmInitialize, const SceGxmInitializeParams *params) {
     }
 
     emuenv.gxm.params = *params;
-    // hack, limit the number of frame rendering at the same time to at most 3
-    // also, the last frame won't be in the queue so decrease the count by 1
-    // the case where displayQueueMaxPendingCount is 1 handled in sceGxmDisplayQueueAddEntry
-    const uint32_t max_queue_size = std::max(std::min(params->displayQueueMaxPendingCount, 3U) - 1, 1U);
-    emuenv.gxm.display_queue.maxPendingCount_ = max_queue_size;
+    emuenv.gxm.display_queue.maxPendingCount_ = get_display_queue_size(*params);
 
     const ThreadStatePtr main_thread = emuenv.kernel.get_thread(thread_id);
     const ThreadStatePtr display_queue_thread = emuenv.kernel.create_thread(emuenv.mem, "SceGxmDisplayQueue", Ptr<void>(0), SCE_KERNEL_HIGHEST_PRIORITY_USER, SCE_KERNEL_THREAD_CPU_AFFINITY_MASK_DEFAULT, SCE_KERNEL_STACK_SIZE_USER_DEFAULT, nullptr);
@@ -4277,6 +4599,16 @@ static void free_callbacked(EmuEnvState &emuenv, SceUID thread_id, SceGxmShaderP
     free_callbacked(emuenv, thread_id, shaderPatcher, data.address());
 }
 
+static void forget_vertex_program(GxmState &gxm, Address program) {
+    const std::lock_guard<std::mutex> lock(gxm.objects.mutex);
+    gxm.objects.vertex_programs.erase(program);
+}
+
+static void forget_fragment_program(GxmState &gxm, Address program) {
+    const std::lock_guard<std::mutex> lock(gxm.objects.mutex);
+    gxm.objects.fragment_programs.erase(program);
+}
+
 EXPORT(int, sceGxmShaderPatcherAddRefFragmentProgram, SceGxmShaderPatcher *shaderPatcher, SceGxmFragmentProgram *fragmentProgram) {
     TRACY_FUNC(sceGxmShaderPatcherAddRefFragmentProgram, shaderPatcher, fragmentProgram);
     if (!shaderPatcher || !fragmentProgram)
@@ -4308,6 +4640,9 @@ EXPORT(int, sceGxmShaderPatcherCreate, const SceGxmShaderPatcherParams *params,
         return RET_ERROR(SCE_GXM_ERROR_OUT_OF_MEMORY);
     }
     shaderPatcher->get(emuenv.mem)->params = *params;
+
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.shader_patchers.insert(shaderPatcher->address());
     return 0;
 }
 
@@ -4354,6 +4689,9 @@ EXPORT(int, sceGxmShaderPatcherCreateFragmentProgram, SceGxmShaderPatcher *shade
 
     shaderPatcher->fragment_program_cache.emplace(key, *fragmentProgram);
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.fragment_programs[fragmentProgram->address()] = blendInfo ? std::optional(*blendInfo) : std::nullopt;
+
     return 0;
 }
 
@@ -4379,6 +4717,9 @@ EXPORT(int, sceGxmShaderPatcherCreateMaskUpdateFragmentProgram, SceGxmShaderPatc
         return RET_ERROR(SCE_GXM_ERROR_DRIVER);
     }
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.fragment_programs[fragmentProgram->address()] = std::nullopt;
+
     return 0;
 }
 
@@ -4433,6 +4774,9 @@ EXPORT(int, sceGxmShaderPatcherCreateVertexProgram, SceGxmShaderPatcher *shaderP
 
     shaderPatcher->vertex_program_cache.emplace(key, *vertexProgram);
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.vertex_programs.insert(vertexProgram->address());
+
     return 0;
 }
 
@@ -4443,6 +4787,9 @@ EXPORT(int, sceGxmShaderPatcherDestroy, Ptr<SceGxmShaderPatcher> shaderPatcher)
 
     free_callbacked(emuenv, thread_id, shaderPatcher.get(emuenv.mem), shaderPatcher);
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.shader_patchers.erase(shaderPatcher.address());
+
     return 0;
 }
 
@@ -4463,6 +4810,7 @@ EXPORT(int, sceGxmShaderPatcherForceUnregisterProgram, SceGxmShaderPatcher *shad
                     std::this_thread::yield();
 
                 free_callbacked(emuenv, thread_id, shaderPatcher, it->second.address());
+                forget_vertex_program(emuenv.gxm, it->second.address());
                 it = shaderPatcher->vertex_program_cache.erase(it);
             } else {
                 ++it;
@@ -4476,6 +4824,7 @@ EXPORT(int, sceGxmShaderPatcherForceUnregisterProgram, SceGxmShaderPatcher *shad
                     std::this_thread::yield();
 
                 free_callbacked(emuenv, thread_id, shaderPatcher, it->second.address());
+                forget_fragment_program(emuenv.gxm, it->second.address());
                 it = shaderPatcher->fragment_program_cache.erase(it);
             } else {
                 ++it;
@@ -4581,6 +4930,7 @@ EXPORT(int, sceGxmShaderPatcherReleaseFragmentProgram, SceGxmShaderPatcher *shad
             }
         }
         free_callbacked(emuenv, thread_id, shaderPatcher, fragmentProgram);
+        forget_fragment_program(emuenv.gxm, fragmentProgram.address());
     }
 
     return 0;
@@ -4604,6 +4954,7 @@ EXPORT(int, sceGxmShaderPatcherReleaseVertexProgram, SceGxmShaderPatcher *shader
             }
         }
         free_callbacked(emuenv, thread_id, shaderPatcher, vertexProgram);
+        forget_vertex_program(emuenv.gxm, vertexProgram.address());
     }
 
     return 0;
@@ -4648,6 +4999,9 @@ EXPORT(int, sceGxmSyncObjectCreate, Ptr<SceGxmSyncObject> *syncObject) {
 
     renderer::create(syncObject->get(emuenv.mem), *emuenv.renderer);
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.sync_objects.insert(syncObject->address());
+
     return 0;
 }
 
@@ -4659,6 +5013,9 @@ EXPORT(int, sceGxmSyncObjectDestroy, Ptr<SceGxmSyncObject> syncObject) {
     renderer::destroy(syncObject.get(emuenv.mem), *emuenv.renderer);
     free(emuenv.mem, syncObject);
 
+    const std::lock_guard<std::mutex> lock(emuenv.gxm.objects.mutex);
+    emuenv.gxm.objects.sync_objects.erase(syncObject.address());
+
     return 0;
 }
 
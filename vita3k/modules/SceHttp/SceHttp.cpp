@@ -21,17 +21,6 @@
 #include <filesystem>
 #include <http/state.h>
 
-#ifdef _WIN32 // windows moment
-#include <io.h>
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#define write(x, y, z) _write(x, y, z)
-#define read(x, y, z) _read(x, y, z)
-#else
-#include <netdb.h>
-#include <sys/socket.h>
-#endif
-
 #include <kernel/state.h>
 #include <net/state.h>
 #include <openssl/err.h>
@@ -41,8 +30,10 @@
 #include <util/string_utils.h>
 #include <util/tracy.h>
 
+#include <chrono>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <vector>
 
 TRACY_MODULE_NAME(SceHttp);
 
@@ -116,6 +107,15 @@ std::string to_debug_str<SceHttpsFlags>(const MemState &mem, SceHttpsFlags type)
     return out;
 }
 
+static std::chrono::milliseconds connect_timeout(const EmuEnvState &emuenv) {
+    return std::chrono::milliseconds(emuenv.cfg.http_timeout_attempts * emuenv.cfg.http_timeout_sleep_ms);
+}
+
+static http::Result acquire_connection(EmuEnvState &emuenv, const SceTemplate &tmpl, SceConnection &connection) {
+    const http::Endpoint endpoint{ connection.hostname, connection.port, connection.isSecure ? SSL_get_SSL_CTX((SSL *)tmpl.ssl) : nullptr };
+    return emuenv.http.pool.acquire(endpoint, connect_timeout(emuenv), connection.connection);
+}
+
 EXPORT(int, sceHttpAbortRequest) {
     TRACY_FUNC(sceHttpAbortRequest);
     return UNIMPLEMENTED();
@@ -249,27 +249,13 @@ EXPORT(SceInt, sceHttpCreateConnectionWithURL, SceInt tmplId, const char *url, S
         port = parsed.port;
     // If fifth character is an s (meaning https) use 443, else 80
 
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    assert(sockfd);
-    if (sockfd < 0) {
-        LOG_ERROR("ERROR opening socket");
-        return RET_ERROR(SCE_HTTP_ERROR_UNKNOWN);
-    }
-
-    const addrinfo hints = {
-        AI_PASSIVE, /* For wildcard IP address */
-        AF_UNSPEC, /* Allow IPv4 or IPv6 */
-        SOCK_DGRAM, /* Datagram socket */
-        0, /* Any protocol */
-    };
-    addrinfo *result = { 0 };
-
     const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
 
-    auto ret = getaddrinfo(parsed.hostname.c_str(), port.c_str(), &hints, &result);
-    if (ret < 0) {
+    SceConnection connection{ tmplId, urlStr, enableKeepalive, isSecure, parsed.hostname, port };
+    const http::Result resolved = emuenv.http.pool.resolve(parsed.hostname, port, connect_timeout(emuenv));
+    if (resolved != http::Result::Ok) {
         if (!emuenv.cfg.http_enable) {
-            LOG_WARN("getaddrinfo failed, but http is disabled, asume we still got it");
+            LOG_WARN("Resolving {} failed, but http is disabled, asume we still got it", parsed.hostname);
 
             // Even if we didnt get the ip, we should send the ip obtained callback
             for (auto &callback : emuenv.netctl.callbacks) {
@@ -278,12 +264,12 @@ EXPORT(SceInt, sceHttpCreateConnectionWithURL, SceInt tmplId, const char *url, S
                 }
             }
             // Need to push the connection here so the id exists when "sending" the request
-            emuenv.http.connections.emplace(connId, SceConnection{ tmplId, urlStr, enableKeepalive, isSecure, sockfd });
+            emuenv.http.connections.emplace(connId, std::move(connection));
 
             return connId;
         }
 
-        LOG_ERROR("getaddrinfo({},{},...) = {}", url, port, ret);
+        LOG_ERROR("Failed to resolve {} for {}", parsed.hostname, url);
         return RET_ERROR(SCE_HTTP_ERROR_RESOLVER_ENODNS);
     }
 
@@ -296,43 +282,27 @@ EXPORT(SceInt, sceHttpCreateConnectionWithURL, SceInt tmplId, const char *url, S
 
     if (!emuenv.cfg.http_enable) {
         // Need to push the connection here so the id exists when "sending" the request
-        emuenv.http.connections.emplace(connId, SceConnection{ tmplId, urlStr, enableKeepalive, isSecure, sockfd });
+        emuenv.http.connections.emplace(connId, std::move(connection));
         return connId;
     }
 
-    ret = connect(sockfd, result->ai_addr, result->ai_addrlen);
-    if (ret < 0) {
-        LOG_ERROR("connect({},...) = {}, errno={}({})", sockfd, ret, errno, strerror(errno));
-        return RET_ERROR(SCE_HTTP_ERROR_RESOLVER_ENOHOST);
+    if (isSecure && !emuenv.http.sslInited) {
+        LOG_ERROR("SSL not inited on secure connection");
+        return RET_ERROR(SCE_HTTP_ERROR_SSL);
     }
 
-    LOG_TRACE("Connected to {}", url);
-
-    if (isSecure) {
-        if (!emuenv.http.sslInited) {
-            LOG_ERROR("SSL not inited on secure connection");
-            return RET_ERROR(SCE_HTTP_ERROR_SSL);
-        }
-
-        SSL_set_fd((SSL *)tmpl->second.ssl, sockfd);
-
-        // This is needed as some servers are using handshake protocols older than the person writing this code
-        SSL_set_security_level((SSL *)tmpl->second.ssl, 0);
-
-        int err = SSL_connect((SSL *)tmpl->second.ssl);
-        if (err != 1) {
-            int sslErr = SSL_get_error((SSL *)tmpl->second.ssl, err);
-            LOG_ERROR("SSL_connect(...) = {}, SSLERR = {}", err, sslErr);
-            if (sslErr == SSL_ERROR_SSL)
-                return RET_ERROR(SCE_HTTP_ERROR_SSL);
-        }
-
-        long verify_flag = SSL_get_verify_result((SSL *)tmpl->second.ssl);
-        if (verify_flag != X509_V_OK && verify_flag != X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY)
-            LOG_ERROR("Certificate verification error ({}) but continuing...\n", (int)verify_flag);
+    // Takes an idle connection to the same host when there is one, so that neither the TCP nor the TLS handshake is repeated
+    switch (acquire_connection(emuenv, tmpl->second, connection)) {
+    case http::Result::Ok: break;
+    case http::Result::ResolveFailed: return RET_ERROR(SCE_HTTP_ERROR_RESOLVER_ENODNS);
+    case http::Result::HandshakeFailed: return RET_ERROR(SCE_HTTP_ERROR_SSL);
+    case http::Result::Timeout: return RET_ERROR(SCE_HTTP_ERROR_TIMEOUT);
+    default: return RET_ERROR(SCE_HTTP_ERROR_RESOLVER_ENOHOST);
     }
 
-    emuenv.http.connections.emplace(connId, SceConnection{ tmplId, urlStr, enableKeepalive, isSecure, sockfd });
+    LOG_TRACE("Connected to {}", url);
+
+    emuenv.http.connections.emplace(connId, std::move(connection));
 
     return connId;
 }
@@ -564,12 +534,8 @@ EXPORT(SceInt, sceHttpDeleteConnection, SceInt connId) {
 
     if (connIt == emuenv.http.connections.end())
         return RET_ERROR(SCE_HTTP_ERROR_INVALID_ID);
-#ifdef _WIN32
-    closesocket(connIt->second.sockfd);
-#else
-    close(connIt->second.sockfd);
-#endif // _WIN32
-
+    // The connection stays open for the next one to the same host when kept alive
+    emuenv.http.pool.release(std::move(connIt->second.connection), connIt->second.keepAlive);
     emuenv.http.connections.erase(connIt);
 
     return 0;
@@ -733,10 +699,8 @@ EXPORT(SceInt, sceHttpGetResponseContentLength, SceInt reqId, SceULong64 *conten
     if (length_it == req->second.res.headers.end())
         return RET_ERROR(SCE_HTTP_ERROR_NO_CONTENT_LENGTH);
 
-    SceULong64 length = string_utils::stoi_def(length_it->second);
-    *contentLength = length;
-
-    req->second.res.contentLength = length;
+    // the body read is kept to what was received, a response without body can still give the size of the resource
+    *contentLength = string_utils::stoi_def(length_it->second);
 
     return 0;
 }
@@ -1006,187 +970,125 @@ EXPORT(SceInt, sceHttpSendRequest, SceInt reqId, const char *postData, SceSize s
 
     req->second.message = req->second.requestLine + "\r\n" + headers + "\r\n";
 
-    int msgLength = req->second.message.length();
-    int reqBytesSent = 0;
-    do {
-        int bytes = 0;
-        if (conn->second.isSecure)
-            bytes = SSL_write((SSL *)tmpl->second.ssl, req->second.message.c_str() + reqBytesSent, msgLength - reqBytesSent);
-        else
-            bytes = write(conn->second.sockfd, req->second.message.c_str() + reqBytesSent, msgLength - reqBytesSent);
-
-        if (bytes < 0) {
-            LOG_ERROR("ERROR writing GET message to socket");
-            assert(false);
-            return RET_ERROR(SCE_HTTP_ERROR_NETWORK);
+    auto &pool = emuenv.http.pool;
+    auto &connection = conn->second;
+    // How long to wait for the server to answer, then for the rest of the response once it started
+    const auto first_data_timeout = connect_timeout(emuenv);
+    const auto read_end_timeout = std::chrono::milliseconds(emuenv.cfg.http_read_end_attempts * emuenv.cfg.http_read_end_sleep_ms);
+
+    const size_t resHeadersMaxSize = emuenv.http.defaultResponseHeaderSize;
+    std::vector<char> resHeaders(resHeadersMaxSize);
+    size_t totalReceived = 0;
+    size_t headersEnd = std::string_view::npos;
+    http::Result result = http::Result::Ok;
+    for (int attempt = 0;; attempt++) {
+        bool fresh = false;
+        if (!connection.connection) {
+            if (acquire_connection(emuenv, tmpl->second, connection) != http::Result::Ok) {
+                LOG_ERROR("Failed to connect to {}", connection.url);
+                return RET_ERROR(SCE_HTTP_ERROR_NETWORK);
+            }
+            fresh = !http::ConnectionPool::is_reused(*connection.connection);
         }
-        LOG_TRACE("Sent {} bytes to {}", bytes, req->second.url);
-        if (bytes == 0)
-            break;
-        reqBytesSent += bytes;
-    } while (reqBytesSent < msgLength);
 
-    if (req->second.method == SCE_HTTP_METHOD_POST || req->second.method == SCE_HTTP_METHOD_PUT) {
+        result = pool.send(*connection.connection, req->second.message.data(), req->second.message.size(), first_data_timeout);
+        LOG_TRACE("Sent {} bytes to {}", req->second.message.size(), req->second.url);
         //  Once we send the request we need to send the actual data
-        SceSize dataSent = 0;
-        auto dataBytes = 0;
-        do {
-            if (conn->second.isSecure)
-                dataBytes = SSL_write((SSL *)tmpl->second.ssl, postData + dataSent, size - dataSent);
-            else
-                dataBytes = write(conn->second.sockfd, postData + dataSent, size - dataSent);
-
-            if (dataBytes < 0) {
-                LOG_ERROR("ERROR writing POST data to socket");
-                assert(false);
-                return RET_ERROR(SCE_HTTP_ERROR_NETWORK);
-            }
-            LOG_TRACE("Sent {} data bytes to {}", dataBytes, req->second.url);
-            if (dataBytes == 0)
+        if (result == http::Result::Ok && (req->second.method == SCE_HTTP_METHOD_POST || req->second.method == SCE_HTTP_METHOD_PUT) && size > 0) {
+            result = pool.send(*connection.connection, postData, size, first_data_timeout);
+            LOG_TRACE("Sent {} data bytes to {}", size, req->second.url);
+        }
+
+        /* receive the response headers, and whatever part of the body comes with them */
+        while (result == http::Result::Ok && totalReceived < resHeadersMaxSize) {
+            size_t bytes = 0;
+            result = pool.receive(*connection.connection, resHeaders.data() + totalReceived, resHeadersMaxSize - totalReceived, bytes,
+                totalReceived == 0 ? first_data_timeout : read_end_timeout);
+            if (result != http::Result::Ok)
                 break;
-            dataSent += dataBytes;
-        } while (dataSent < size);
-    }
+            LOG_TRACE("Received {} bytes from {}", bytes, req->second.url);
+            // the terminator may be split between two reads
+            const size_t searchFrom = totalReceived < 3 ? 0 : totalReceived - 3;
+            totalReceived += bytes;
+            headersEnd = std::string_view(resHeaders.data(), totalReceived).find("\r\n\r\n", searchFrom);
+            if (headersEnd != std::string_view::npos)
+                break;
+        }
 
-    // Make sockets non blocking only for the response
-    // as we can run out of data to read so it blocks like a whole minute
-    if (!net_utils::socketSetBlocking(conn->second.sockfd, false)) {
-        LOG_WARN("Failed to change blocking, socket={}, blocking={}", conn->second.sockfd, false);
-        assert(false);
-    }
+        if (headersEnd != std::string_view::npos)
+            break;
 
-    /* receive the response */
-    int attempts = 1;
-
-    auto resHeaders = new char[emuenv.http.defaultResponseHeaderSize]();
-    auto resHeadersMaxSize = emuenv.http.defaultResponseHeaderSize;
-    int totalReceived = 0;
-    do {
-        int bytes = 0;
-        if (conn->second.isSecure)
-            bytes = SSL_read((SSL *)tmpl->second.ssl, resHeaders + totalReceived, resHeadersMaxSize - totalReceived);
-        else
-            bytes = read(conn->second.sockfd, resHeaders + totalReceived, resHeadersMaxSize - totalReceived);
-        if (bytes < 0) {
-            if (bytes == -1) {
-                if (errno == EWOULDBLOCK) {
-                    if (attempts > emuenv.cfg.http_read_end_attempts)
-                        break; // we can assume there is no more data to read
-                    LOG_TRACE("No data available. Sleep for {}. Attempt {}", emuenv.cfg.http_read_end_sleep_ms, attempts);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(emuenv.cfg.http_read_end_sleep_ms));
-                    attempts++;
-                    continue;
-                } else {
-                    LOG_ERROR("ERROR reading GET response headers");
-                    assert(false);
-                    delete[] resHeaders;
-                    return RET_ERROR(SCE_HTTP_ERROR_NETWORK);
-                }
-            }
+        pool.release(std::move(connection.connection), false);
+        // A kept alive connection may have been closed by the server since it was last used, which is only found out once the
+        // request is sent, it is sent once more on a new connection then
+        if (!fresh && attempt == 0 && totalReceived == 0 && (result == http::Result::Closed || result == http::Result::Error)) {
+            LOG_DEBUG("Kept alive connection to {} was closed, retrying on a new one", connection.url);
+            continue;
         }
-        LOG_TRACE("Received {} bytes from {}", bytes, req->second.url);
-        if (bytes == 0) {
-            if (strcmp(resHeaders, "") == 0) {
-                if (attempts > emuenv.cfg.http_timeout_attempts)
-                    break; // Give up
-                LOG_TRACE("Response is null. Sleep for {}. Attempt {}", emuenv.cfg.http_timeout_sleep_ms, attempts);
-                std::this_thread::sleep_for(std::chrono::milliseconds(emuenv.cfg.http_timeout_sleep_ms));
-                attempts++;
-                continue;
-            }
-            break;
+
+        if (result == http::Result::Error) {
+            LOG_ERROR("ERROR exchanging with {}", req->second.url);
+            return RET_ERROR(SCE_HTTP_ERROR_NETWORK);
         }
 
-        totalReceived += bytes;
-    } while (std::string_view(resHeaders).find("\r\n\r\n") == std::string::npos || totalReceived == resHeadersMaxSize); // receive headers until we start receiving body
+        // Headers are too big
+        if (totalReceived == resHeadersMaxSize)
+            return RET_ERROR(SCE_HTTP_ERROR_TOO_LARGE_RESPONSE_HEADER);
 
-    if (totalReceived != resHeadersMaxSize && std::string_view(resHeaders).find("\r\n\r\n") == std::string::npos) {
-        delete[] resHeaders;
         return RET_ERROR(SCE_HTTP_ERROR_TIMEOUT);
     }
 
-    // Headers are too big
-    if (totalReceived == resHeadersMaxSize && std::string_view(resHeaders).find("\r\n\r\n") == std::string::npos) {
-        delete[] resHeaders;
-        return RET_ERROR(SCE_HTTP_ERROR_TOO_LARGE_RESPONSE_HEADER);
-    }
-
-    const auto resHeadersStr = std::string(resHeaders);
-    const auto resHeadersOnly = resHeadersStr.substr(0, resHeadersStr.find("\r\n\r\n"));
+    const std::string resHeadersOnly(resHeaders.data(), headersEnd);
     if (!net_utils::parseResponse(resHeadersOnly, req->second.res)) {
-        delete[] resHeaders;
+        pool.release(std::move(connection.connection), false);
         return RET_ERROR(SCE_HTTP_ERROR_PARSE_HTTP_INVALID_RESPONSE);
     }
 
-    // TODO: does a HEAD/OPTIONS request need content-length to exist?
-    if (req->second.res.headers.find("content-length") == req->second.headers.end()) {
-        delete[] resHeaders;
-        return RET_ERROR(SCE_HTTP_ERROR_NO_CONTENT_LENGTH);
-    }
-
     LOG_TRACE("Request replied with status code {}", req->second.res.statusCode);
 
+    // These responses end with their headers, a Content-Length there gives the size of the resource and no body follows
+    const int statusCode = req->second.res.statusCode;
+    const bool hasNoBody = req->second.method == SCE_HTTP_METHOD_HEAD || req->second.method == SCE_HTTP_METHOD_OPTIONS
+        || (statusCode >= 100 && statusCode < 200) || statusCode == 204 || statusCode == 304;
+    if (hasNoBody)
+        req->second.res.contentLength = 0;
+
+    // Without Content-Length the end of the body is only known once the server closes the connection, it is read as empty
+    const bool hasKnownLength = hasNoBody || req->second.res.headers.contains("Content-Length");
+
     // Now we get the body or the rest of the body
-    attempts = 1; // Reset attempts
-    int responseLength = resHeadersStr.find("\r\n\r\n") + strlen("\r\n\r\n") + req->second.res.contentLength;
-    if (req->second.method == SCE_HTTP_METHOD_HEAD || req->second.method == SCE_HTTP_METHOD_OPTIONS) // even if we have content-length, there will be no body
-        responseLength = resHeadersStr.find("\r\n\r\n") + strlen("\r\n\r\n");
+    const size_t responseLength = headersEnd + strlen("\r\n\r\n") + req->second.res.contentLength;
 
     // This is the entire response, including headers and everything
     auto reqResponse = new uint8_t[responseLength]();
-    memcpy(reqResponse, resHeaders, std::min(emuenv.http.defaultResponseHeaderSize, responseLength));
-    delete[] resHeaders;
-
-    int remainingToRead = responseLength - totalReceived;
-
-    while (remainingToRead != 0) {
-        int bytes = 0;
-        if (conn->second.isSecure)
-            bytes = SSL_read((SSL *)tmpl->second.ssl, reqResponse + totalReceived, remainingToRead);
-        else
-            bytes = read(conn->second.sockfd, reqResponse + totalReceived, remainingToRead);
-        if (bytes < 0) {
-            if (bytes == -1) {
-                if (errno == EWOULDBLOCK) {
-                    if (attempts > emuenv.cfg.http_read_end_attempts)
-                        break; // we can assume there is no more data to read
-                    LOG_TRACE("No data available. Sleep for {}. Attempt {}", emuenv.cfg.http_read_end_sleep_ms, attempts);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(emuenv.cfg.http_read_end_sleep_ms));
-                    attempts++;
-                    continue;
-                } else {
-                    LOG_ERROR("ERROR reading GET response");
-                    assert(false);
-                    delete[] reqResponse;
-                    return RET_ERROR(SCE_HTTP_ERROR_NETWORK);
-                }
-            }
-        }
-        LOG_TRACE("Received {} bytes from {}", bytes, req->second.url);
-        if (bytes == 0) {
-            if (attempts > emuenv.cfg.http_timeout_attempts)
-                break; // Give up
-            LOG_TRACE("Response is null. Sleep for {}. Attempt {}", emuenv.cfg.http_timeout_sleep_ms, attempts);
-            std::this_thread::sleep_for(std::chrono::milliseconds(emuenv.cfg.http_timeout_sleep_ms));
-            attempts++;
-            continue;
+    memcpy(reqResponse, resHeaders.data(), std::min(totalReceived, responseLength));
+    // more than the response means the connection is out of step with the server
+    const bool overread = totalReceived > responseLength;
+    totalReceived = std::min(totalReceived, responseLength);
+
+    while (result == http::Result::Ok && totalReceived < responseLength) {
+        size_t bytes = 0;
+        result = pool.receive(*connection.connection, reqResponse + totalReceived, responseLength - totalReceived, bytes, read_end_timeout);
+        if (result == http::Result::Ok) {
+            LOG_TRACE("Received {} bytes from {}", bytes, req->second.url);
+            totalReceived += bytes;
         }
-
-        totalReceived += bytes;
-        remainingToRead -= bytes;
-    }
-
-    if (!net_utils::socketSetBlocking(conn->second.sockfd, true)) {
-        LOG_WARN("Failed to change blocking, socket={}, blocking={}", conn->second.sockfd, true);
-        assert(false);
     }
 
-    if (remainingToRead != 0) {
+    if (totalReceived != responseLength) {
         LOG_WARN("Could not read entire body length");
+        pool.release(std::move(connection.connection), false);
         delete[] reqResponse;
-        return RET_ERROR(SCE_HTTP_ERROR_TIMEOUT);
+        return RET_ERROR(result == http::Result::Error ? SCE_HTTP_ERROR_NETWORK : SCE_HTTP_ERROR_TIMEOUT);
     }
 
+    // The connection is used again for the next request only when both sides keep it alive and the response ended where expected
+    const auto connectionHeader = req->second.res.headers.find("Connection");
+    const bool serverKeepsAlive = req->second.res.httpVer == "1.1"
+        && (connectionHeader == req->second.res.headers.end() || string_utils::tolower(connectionHeader->second) != "close");
+    if (!connection.keepAlive || tmpl->second.httpVersion != SCE_HTTP_VERSION_1_1 || !serverKeepsAlive || !hasKnownLength || overread)
+        pool.release(std::move(connection.connection), false);
+
     if (*reqResponse == 0) {
         LOG_ERROR("Received empty GET response. Probably due to unknown protocol");
         assert(false);
@@ -1195,7 +1097,7 @@ EXPORT(SceInt, sceHttpSendRequest, SceInt reqId, const char *postData, SceSize s
     }
 
     req->second.res.responseRaw = reqResponse;
-    req->second.res.body = reqResponse + resHeadersOnly.length() + strlen("\r\n\r\n");
+    req->second.res.body = reqResponse + headersEnd + strlen("\r\n\r\n");
 
     LOG_TRACE("Request finished nicely");
 
@@ -1380,6 +1282,8 @@ EXPORT(SceInt, sceHttpTerm) {
         free(emuenv.mem, pointer.address());
     }
 
+    emuenv.http.pool.clear();
+
     return 0;
 }
 
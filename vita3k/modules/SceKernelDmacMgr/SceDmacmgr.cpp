@@ -17,10 +17,27 @@
 
 #include <module/module.h>
 
-EXPORT(int, sceDmacMemcpy) {
-    return UNIMPLEMENTED();
+#include <dmac/functions.h>
+#include <util/log.h>
+#include <util/tracy.h>
+TRACY_MODULE_NAME(SceDmacmgr);
+
+EXPORT(Ptr<void>, sceDmacMemcpy, Ptr<void> dst, Ptr<const void> src, SceSize size) {
+    TRACY_FUNC(sceDmacMemcpy, dst, src, size);
+    if (!dmac::copy(emuenv.dmac, emuenv.mem, dst.address(), src.address(), size)) {
+        LOG_ERROR("Invalid copy of {} bytes from {} to {}", size, log_hex(src.address()), log_hex(dst.address()));
+        return Ptr<void>();
+    }
+
+    return dst;
 }
 
-EXPORT(int, sceDmacMemset) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, sceDmacMemset, Ptr<void> dst, int c, SceSize size) {
+    TRACY_FUNC(sceDmacMemset, dst, c, size);
+    if (!dmac::fill(emuenv.dmac, emuenv.mem, dst.address(), static_cast<uint8_t>(c), size)) {
+        LOG_ERROR("Invalid fill of {} bytes at {}", size, log_hex(dst.address()));
+        return Ptr<void>();
+    }
+
+    return dst;
 }
@@ -1048,37 +1048,36 @@ EXPORT(int, sceKernelCreateThreadForUser, const char *name, SceKernelThreadEntry
     return thread->id;
 }
 
-static int delay_thread(SceUInt delay_us) {
+static int delay_thread(KernelState &kernel, SceUInt delay_us) {
     if (delay_us == 0)
         return SCE_KERNEL_ERROR_INVALID_ARGUMENT;
 
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
-
+    // all the delays are woken up by the single timer service thread: this is what makes them precise,
+    // but a delay ending at the same time as the vblank waits for the vblank callback to return first
+    kernel.timer_service.wait_until(TimerService::Clock::now() + std::chrono::microseconds(delay_us));
     return SCE_KERNEL_OK;
 }
 
 static int delay_thread_cb(EmuEnvState &emuenv, SceUID thread_id, SceUInt delay_us) {
-    auto start = std::chrono::high_resolution_clock::now(); // Meseaure the time taken to process callbacks
+    // the time spent processing the callbacks counts in the delay
+    const auto deadline = TimerService::Clock::now() + std::chrono::microseconds(delay_us);
     process_callbacks(emuenv.kernel, thread_id);
-    auto end = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
 
-    if (delay_us > elapsed.count()) // If we spent less time than requested processing callbacks, sleep the remaining time
-        return delay_thread(delay_us - elapsed.count());
-    else // Else return directly
-        return SCE_KERNEL_OK;
+    if (TimerService::Clock::now() < deadline)
+        emuenv.kernel.timer_service.wait_until(deadline);
+    return SCE_KERNEL_OK;
 }
 
 EXPORT(int, sceKernelDelayThread, SceUInt delay) {
     TRACY_FUNC(sceKernelDelayThread, delay);
-    return delay_thread(delay);
+    return delay_thread(emuenv.kernel, delay);
 }
 
 EXPORT(int, sceKernelDelayThread200, SceUInt delay) {
     TRACY_FUNC(sceKernelDelayThread200, delay);
     if (delay < 201)
         delay = 201;
-    return delay_thread(delay);
+    return delay_thread(emuenv.kernel, delay);
 }
 
 EXPORT(int, sceKernelDelayThreadCB, SceUInt delay) {
@@ -19,6 +19,7 @@
 
 #include <io/functions.h>
 #include <kernel/state.h>
+#include <mem/libc.h>
 #include <util/lock_and_find.h>
 #include <util/log.h>
 #include <util/tracy.h>
@@ -26,10 +27,90 @@
 #include <dlmalloc.h>
 #include <v3kprintf.h>
 
+#include <algorithm>
+
 TRACY_MODULE_NAME(SceLibc);
 
 static Ptr<void> g_dso;
 
+// The guest libc would fault on these, leave memory alone instead
+#define INVALID_RANGE() LOG_ERROR_ONCE("{} called on an invalid memory range.", export_name)
+
+// Values of errno_t returned when a runtime constraint of the bounds-checked functions is violated
+constexpr int SCE_LIBC_EINVAL = 22;
+constexpr int SCE_LIBC_ERANGE = 34;
+constexpr SceSize SCE_LIBC_RSIZE_MAX = 0x7FFFFFFF;
+
+// memcpy_s and memmove_s, destination is cleared when a constraint is violated
+static int copy_s(EmuEnvState &emuenv, const char *export_name, Address destination, SceSize destination_size, Address source, SceSize count, bool allow_overlap) {
+    if (!destination || destination_size > SCE_LIBC_RSIZE_MAX)
+        return destination ? SCE_LIBC_ERANGE : SCE_LIBC_EINVAL;
+
+    const bool overlap = (destination < uint64_t(source) + count) && (source < uint64_t(destination) + count);
+    const int error = !source ? SCE_LIBC_EINVAL : ((count > destination_size || (overlap && !allow_overlap)) ? SCE_LIBC_ERANGE : 0);
+    if (error) {
+        if (!guest_memset(emuenv.mem, destination, 0, destination_size))
+            INVALID_RANGE();
+        return error;
+    }
+
+    if (!guest_memmove(emuenv.mem, destination, source, count)) {
+        INVALID_RANGE();
+        return SCE_LIBC_EINVAL;
+    }
+    return 0;
+}
+
+// strcpy_s and strncpy_s, destination is set to an empty string when a constraint is violated
+static int copy_string_s(EmuEnvState &emuenv, const char *export_name, Address destination, SceSize destination_size, Address source, SceSize count) {
+    if (!destination || destination_size == 0 || destination_size > SCE_LIBC_RSIZE_MAX)
+        return destination ? SCE_LIBC_ERANGE : SCE_LIBC_EINVAL;
+
+    // the copy and its terminator must fit in destination
+    uint32_t length = 0;
+    const bool valid = source && guest_strnlen(emuenv.mem, source, std::min(count, destination_size), length);
+    if (!valid || (length == destination_size)) {
+        if (source && !valid)
+            INVALID_RANGE();
+        guest_memset(emuenv.mem, destination, 0, 1);
+        return source ? SCE_LIBC_ERANGE : SCE_LIBC_EINVAL;
+    }
+
+    if (!guest_memmove(emuenv.mem, destination, source, length) || !guest_memset(emuenv.mem, destination + length, 0, 1)) {
+        INVALID_RANGE();
+        return SCE_LIBC_EINVAL;
+    }
+    return 0;
+}
+
+// strcat_s and strncat_s, destination is set to an empty string when a constraint is violated
+static int concatenate_s(EmuEnvState &emuenv, const char *export_name, Address destination, SceSize destination_size, Address source, SceSize count) {
+    if (!destination || destination_size == 0 || destination_size > SCE_LIBC_RSIZE_MAX)
+        return destination ? SCE_LIBC_ERANGE : SCE_LIBC_EINVAL;
+
+    uint32_t destination_length = 0;
+    if (!guest_strnlen(emuenv.mem, destination, destination_size, destination_length)) {
+        INVALID_RANGE();
+        return SCE_LIBC_EINVAL;
+    }
+
+    const uint32_t room = destination_size - destination_length;
+    uint32_t length = 0;
+    const bool valid = source && (room > 0) && guest_strnlen(emuenv.mem, source, std::min(count, room), length);
+    if (!valid || (length == room)) {
+        if (source && room > 0 && !valid)
+            INVALID_RANGE();
+        guest_memset(emuenv.mem, destination, 0, 1);
+        return source ? SCE_LIBC_ERANGE : SCE_LIBC_EINVAL;
+    }
+
+    if (!guest_memmove(emuenv.mem, destination + destination_length, source, length) || !guest_memset(emuenv.mem, destination + destination_length + length, 0, 1)) {
+        INVALID_RANGE();
+        return SCE_LIBC_EINVAL;
+    }
+    return 0;
+}
+
 EXPORT(int, _Assert) {
     TRACY_FUNC(_Assert);
     return UNIMPLEMENTED();
@@ -842,39 +923,51 @@ EXPORT(Ptr<void>, memalign, uint32_t alignment, uint32_t size) {
     return Ptr<void>(address);
 }
 
-EXPORT(int, memchr) {
-    TRACY_FUNC(memchr);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, memchr, Ptr<const void> str, int c, SceSize n) {
+    TRACY_FUNC(memchr, str, c, n);
+    Address found = 0;
+    if (!guest_memchr(emuenv.mem, str.address(), static_cast<uint8_t>(c), n, found))
+        INVALID_RANGE();
+    return Ptr<void>(found);
 }
 
-EXPORT(int, memcmp) {
-    TRACY_FUNC(memcmp);
-    return UNIMPLEMENTED();
+EXPORT(int, memcmp, Ptr<const void> str1, Ptr<const void> str2, SceSize n) {
+    TRACY_FUNC(memcmp, str1, str2, n);
+    int result = 0;
+    if (!guest_memcmp(emuenv.mem, str1.address(), str2.address(), n, result))
+        INVALID_RANGE();
+    return result;
 }
 
-EXPORT(void, memcpy, void *destination, const void *source, uint32_t num) {
+EXPORT(Ptr<void>, memcpy, Ptr<void> destination, Ptr<const void> source, SceSize num) {
     TRACY_FUNC(memcpy, destination, source, num);
-    memcpy(destination, source, num);
+    if (!guest_memmove(emuenv.mem, destination.address(), source.address(), num))
+        INVALID_RANGE();
+    return destination;
 }
 
-EXPORT(int, memcpy_s) {
-    TRACY_FUNC(memcpy_s);
-    return UNIMPLEMENTED();
+EXPORT(int, memcpy_s, Ptr<void> destination, SceSize destination_size, Ptr<const void> source, SceSize count) {
+    TRACY_FUNC(memcpy_s, destination, destination_size, source, count);
+    return copy_s(emuenv, export_name, destination.address(), destination_size, source.address(), count, false);
 }
 
-EXPORT(void, memmove, void *destination, const void *source, uint32_t num) {
+EXPORT(Ptr<void>, memmove, Ptr<void> destination, Ptr<const void> source, SceSize num) {
     TRACY_FUNC(memmove, destination, source, num);
-    memmove(destination, source, num);
+    if (!guest_memmove(emuenv.mem, destination.address(), source.address(), num))
+        INVALID_RANGE();
+    return destination;
 }
 
-EXPORT(int, memmove_s) {
-    TRACY_FUNC(memmove_s);
-    return UNIMPLEMENTED();
+EXPORT(int, memmove_s, Ptr<void> destination, SceSize destination_size, Ptr<const void> source, SceSize count) {
+    TRACY_FUNC(memmove_s, destination, destination_size, source, count);
+    return copy_s(emuenv, export_name, destination.address(), destination_size, source.address(), count, true);
 }
 
-EXPORT(void, memset, Ptr<void> str, int c, uint32_t n) {
+EXPORT(Ptr<void>, memset, Ptr<void> str, int c, SceSize n) {
     TRACY_FUNC(memset, str, c, n);
-    memset(str.get(emuenv.mem), c, n);
+    if (!guest_memset(emuenv.mem, str.address(), static_cast<uint8_t>(c), n))
+        INVALID_RANGE();
+    return str;
 }
 
 EXPORT(int, mktime) {
@@ -1170,25 +1263,38 @@ EXPORT(int, strcasecmp) {
 }
 #pragma pop_macro("strcasecmp")
 
-EXPORT(Ptr<char>, strcat, Ptr<char> destination, Ptr<char> source) {
+EXPORT(Ptr<char>, strcat, Ptr<char> destination, Ptr<const char> source) {
     TRACY_FUNC(strcat, destination, source);
-    strcat(destination.get(emuenv.mem), source.get(emuenv.mem));
+    uint32_t destination_length = 0;
+    uint32_t source_length = 0;
+    if (!guest_strnlen(emuenv.mem, destination.address(), UINT32_MAX, destination_length)
+        || !guest_strnlen(emuenv.mem, source.address(), UINT32_MAX, source_length)
+        || !guest_memmove(emuenv.mem, destination.address() + destination_length, source.address(), source_length + 1))
+        INVALID_RANGE();
     return destination;
 }
 
-EXPORT(int, strcat_s) {
-    TRACY_FUNC(strcat_s);
-    return UNIMPLEMENTED();
+EXPORT(int, strcat_s, Ptr<char> destination, SceSize destination_size, Ptr<const char> source) {
+    TRACY_FUNC(strcat_s, destination, destination_size, source);
+    return concatenate_s(emuenv, export_name, destination.address(), destination_size, source.address(), SCE_LIBC_RSIZE_MAX);
 }
 
-EXPORT(int, strchr) {
-    TRACY_FUNC(strchr);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, strchr, Ptr<const char> str, int c) {
+    TRACY_FUNC(strchr, str, c);
+    uint32_t length = 0;
+    Address found = 0;
+    if (!guest_strnlen(emuenv.mem, str.address(), UINT32_MAX, length)
+        || !guest_memchr(emuenv.mem, str.address(), static_cast<uint8_t>(c), length + 1, found))
+        INVALID_RANGE();
+    return Ptr<char>(found);
 }
 
-EXPORT(int, strcmp) {
-    TRACY_FUNC(strcmp);
-    return UNIMPLEMENTED();
+EXPORT(int, strcmp, Ptr<const char> str1, Ptr<const char> str2) {
+    TRACY_FUNC(strcmp, str1, str2);
+    int result = 0;
+    if (!guest_strncmp(emuenv.mem, str1.address(), str2.address(), UINT32_MAX, result))
+        INVALID_RANGE();
+    return result;
 }
 
 EXPORT(int, strcoll) {
@@ -1196,15 +1302,18 @@ EXPORT(int, strcoll) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(Ptr<char>, strcpy, Ptr<char> destination, Ptr<char> source) {
+EXPORT(Ptr<char>, strcpy, Ptr<char> destination, Ptr<const char> source) {
     TRACY_FUNC(strcpy, destination, source);
-    strcpy(destination.get(emuenv.mem), source.get(emuenv.mem));
+    uint32_t length = 0;
+    if (!guest_strnlen(emuenv.mem, source.address(), UINT32_MAX, length)
+        || !guest_memmove(emuenv.mem, destination.address(), source.address(), length + 1))
+        INVALID_RANGE();
     return destination;
 }
 
-EXPORT(int, strcpy_s) {
-    TRACY_FUNC(strcpy_s);
-    return UNIMPLEMENTED();
+EXPORT(int, strcpy_s, Ptr<char> destination, SceSize destination_size, Ptr<const char> source) {
+    TRACY_FUNC(strcpy_s, destination, destination_size, source);
+    return copy_string_s(emuenv, export_name, destination.address(), destination_size, source.address(), SCE_LIBC_RSIZE_MAX);
 }
 
 EXPORT(int, strcspn) {
@@ -1237,9 +1346,12 @@ EXPORT(int, strftime) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, strlen, char *str) {
+EXPORT(SceSize, strlen, Ptr<const char> str) {
     TRACY_FUNC(strlen, str);
-    return static_cast<int>(strlen(str));
+    uint32_t length = 0;
+    if (!guest_strnlen(emuenv.mem, str.address(), UINT32_MAX, length))
+        INVALID_RANGE();
+    return length;
 }
 
 #pragma push_macro("strncasecmp")
@@ -1250,35 +1362,53 @@ EXPORT(int, strncasecmp) {
 }
 #pragma pop_macro("strncasecmp")
 
-EXPORT(int, strncat) {
-    TRACY_FUNC(strncat);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, strncat, Ptr<char> destination, Ptr<const char> source, SceSize num) {
+    TRACY_FUNC(strncat, destination, source, num);
+    uint32_t destination_length = 0;
+    uint32_t source_length = 0;
+    if (!guest_strnlen(emuenv.mem, destination.address(), UINT32_MAX, destination_length)
+        || !guest_strnlen(emuenv.mem, source.address(), num, source_length)
+        || !guest_memmove(emuenv.mem, destination.address() + destination_length, source.address(), source_length)
+        || !guest_memset(emuenv.mem, destination.address() + destination_length + source_length, 0, 1))
+        INVALID_RANGE();
+    return destination;
 }
 
-EXPORT(int, strncat_s) {
-    TRACY_FUNC(strncat_s);
-    return UNIMPLEMENTED();
+EXPORT(int, strncat_s, Ptr<char> destination, SceSize destination_size, Ptr<const char> source, SceSize count) {
+    TRACY_FUNC(strncat_s, destination, destination_size, source, count);
+    return concatenate_s(emuenv, export_name, destination.address(), destination_size, source.address(), count);
 }
 
-EXPORT(int, strncmp, const char *str1, const char *str2, SceSize num) {
+EXPORT(int, strncmp, Ptr<const char> str1, Ptr<const char> str2, SceSize num) {
     TRACY_FUNC(strncmp, str1, str2, num);
-    return strncmp(str1, str2, num);
+    int result = 0;
+    if (!guest_strncmp(emuenv.mem, str1.address(), str2.address(), num, result))
+        INVALID_RANGE();
+    return result;
 }
 
-EXPORT(Ptr<char>, strncpy, Ptr<char> destination, Ptr<char> source, SceSize size) {
+EXPORT(Ptr<char>, strncpy, Ptr<char> destination, Ptr<const char> source, SceSize size) {
     TRACY_FUNC(strncpy, destination, source, size);
-    strncpy(destination.get(emuenv.mem), source.get(emuenv.mem), size);
+    // the rest of destination is padded with zeros
+    uint32_t length = 0;
+    if (!guest_strnlen(emuenv.mem, source.address(), size, length)
+        || !guest_memmove(emuenv.mem, destination.address(), source.address(), length)
+        || !guest_memset(emuenv.mem, destination.address() + length, 0, size - length))
+        INVALID_RANGE();
     return destination;
 }
 
-EXPORT(int, strncpy_s) {
-    TRACY_FUNC(strncpy_s);
-    return UNIMPLEMENTED();
+EXPORT(int, strncpy_s, Ptr<char> destination, SceSize destination_size, Ptr<const char> source, SceSize count) {
+    TRACY_FUNC(strncpy_s, destination, destination_size, source, count);
+    return copy_string_s(emuenv, export_name, destination.address(), destination_size, source.address(), count);
 }
 
-EXPORT(int, strnlen_s) {
-    TRACY_FUNC(strnlen_s);
-    return UNIMPLEMENTED();
+EXPORT(SceSize, strnlen_s, Ptr<const char> str, SceSize max_size) {
+    TRACY_FUNC(strnlen_s, str, max_size);
+    uint32_t length = 0;
+    if (str && !guest_strnlen(emuenv.mem, str.address(), max_size, length))
+        INVALID_RANGE();
+    return length;
 }
 
 EXPORT(int, strpbrk) {
@@ -1286,19 +1416,20 @@ EXPORT(int, strpbrk) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(Ptr<char>, strrchr, Ptr<char> str, char ch) {
-    TRACY_FUNC(strrchr, str, ch);
-    Ptr<char> res = Ptr<char>();
-    char *_str = str.get(emuenv.mem);
-    for (int i = static_cast<int>(strlen(_str) - 1); i >= 0; i--) {
-        const char ch1 = _str[i];
-        if (ch1 == ch) {
-            res = str + i * sizeof(char);
-            break;
-        }
+EXPORT(Ptr<char>, strrchr, Ptr<char> str, int c) {
+    TRACY_FUNC(strrchr, str, c);
+    uint32_t length = 0;
+    if (!guest_strnlen(emuenv.mem, str.address(), UINT32_MAX, length)) {
+        INVALID_RANGE();
+        return Ptr<char>();
     }
 
-    return res;
+    // the terminator is part of the string
+    for (int64_t i = length; i >= 0; i--) {
+        if (*(str + static_cast<int32_t>(i)).get(emuenv.mem) == static_cast<char>(c))
+            return str + static_cast<int32_t>(i);
+    }
+    return Ptr<char>();
 }
 
 EXPORT(int, strspn) {
@@ -1628,9 +1759,12 @@ EXPORT(int, wcsftime) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, wcslen) {
-    TRACY_FUNC(wcslen);
-    return UNIMPLEMENTED();
+EXPORT(SceSize, wcslen, Ptr<const SceWChar16> str) {
+    TRACY_FUNC(wcslen, str);
+    uint32_t length = 0;
+    if (!guest_wcsnlen(emuenv.mem, str.address(), UINT32_MAX, length))
+        INVALID_RANGE();
+    return length;
 }
 
 EXPORT(int, wcsncat) {
@@ -1658,9 +1792,12 @@ EXPORT(int, wcsncpy_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, wcsnlen_s) {
-    TRACY_FUNC(wcsnlen_s);
-    return UNIMPLEMENTED();
+EXPORT(SceSize, wcsnlen_s, Ptr<const SceWChar16> str, SceSize max_size) {
+    TRACY_FUNC(wcsnlen_s, str, max_size);
+    uint32_t length = 0;
+    if (str && !guest_wcsnlen(emuenv.mem, str.address(), max_size, length))
+        INVALID_RANGE();
+    return length;
 }
 
 EXPORT(int, wcspbrk) {
@@ -1788,39 +1925,55 @@ EXPORT(int, wctype) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, wmemchr) {
-    TRACY_FUNC(wmemchr);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<SceWChar16>, wmemchr, Ptr<const SceWChar16> str, SceWChar16 c, SceSize n) {
+    TRACY_FUNC(wmemchr, str, c, n);
+    Address found = 0;
+    if (!guest_wmemchr(emuenv.mem, str.address(), c, n, found))
+        INVALID_RANGE();
+    return Ptr<SceWChar16>(found);
 }
 
-EXPORT(int, wmemcmp) {
-    TRACY_FUNC(wmemcmp);
-    return UNIMPLEMENTED();
+EXPORT(int, wmemcmp, Ptr<const SceWChar16> str1, Ptr<const SceWChar16> str2, SceSize n) {
+    TRACY_FUNC(wmemcmp, str1, str2, n);
+    int result = 0;
+    if (!guest_wmemcmp(emuenv.mem, str1.address(), str2.address(), n, result))
+        INVALID_RANGE();
+    return result;
 }
 
-EXPORT(int, wmemcpy) {
-    TRACY_FUNC(wmemcpy);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<SceWChar16>, wmemcpy, Ptr<SceWChar16> destination, Ptr<const SceWChar16> source, SceSize num) {
+    TRACY_FUNC(wmemcpy, destination, source, num);
+    if (num > SCE_LIBC_RSIZE_MAX / sizeof(SceWChar16) || !guest_memmove(emuenv.mem, destination.address(), source.address(), num * sizeof(SceWChar16)))
+        INVALID_RANGE();
+    return destination;
 }
 
-EXPORT(int, wmemcpy_s) {
-    TRACY_FUNC(wmemcpy_s);
-    return UNIMPLEMENTED();
+EXPORT(int, wmemcpy_s, Ptr<SceWChar16> destination, SceSize destination_size, Ptr<const SceWChar16> source, SceSize count) {
+    TRACY_FUNC(wmemcpy_s, destination, destination_size, source, count);
+    if (destination_size > SCE_LIBC_RSIZE_MAX / sizeof(SceWChar16) || count > SCE_LIBC_RSIZE_MAX / sizeof(SceWChar16))
+        return SCE_LIBC_ERANGE;
+    return copy_s(emuenv, export_name, destination.address(), destination_size * sizeof(SceWChar16), source.address(), count * sizeof(SceWChar16), false);
 }
 
-EXPORT(int, wmemmove) {
-    TRACY_FUNC(wmemmove);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<SceWChar16>, wmemmove, Ptr<SceWChar16> destination, Ptr<const SceWChar16> source, SceSize num) {
+    TRACY_FUNC(wmemmove, destination, source, num);
+    if (num > SCE_LIBC_RSIZE_MAX / sizeof(SceWChar16) || !guest_memmove(emuenv.mem, destination.address(), source.address(), num * sizeof(SceWChar16)))
+        INVALID_RANGE();
+    return destination;
 }
 
-EXPORT(int, wmemmove_s) {
-    TRACY_FUNC(wmemmove_s);
-    return UNIMPLEMENTED();
+EXPORT(int, wmemmove_s, Ptr<SceWChar16> destination, SceSize destination_size, Ptr<const SceWChar16> source, SceSize count) {
+    TRACY_FUNC(wmemmove_s, destination, destination_size, source, count);
+    if (destination_size > SCE_LIBC_RSIZE_MAX / sizeof(SceWChar16) || count > SCE_LIBC_RSIZE_MAX / sizeof(SceWChar16))
+        return SCE_LIBC_ERANGE;
+    return copy_s(emuenv, export_name, destination.address(), destination_size * sizeof(SceWChar16), source.address(), count * sizeof(SceWChar16), true);
 }
 
-EXPORT(int, wmemset) {
-    TRACY_FUNC(wmemset);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<SceWChar16>, wmemset, Ptr<SceWChar16> str, SceWChar16 c, SceSize n) {
+    TRACY_FUNC(wmemset, str, c, n);
+    if (!guest_wmemset(emuenv.mem, str.address(), c, n))
+        INVALID_RANGE();
+    return str;
 }
 
 EXPORT(int, wprintf) {
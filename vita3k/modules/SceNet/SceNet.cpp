@@ -178,9 +178,14 @@ EXPORT(int, sceNetEmulationSet) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceNetEpollAbort) {
-    TRACY_FUNC(sceNetEpollAbort);
-    return UNIMPLEMENTED();
+EXPORT(int, sceNetEpollAbort, int eid, int flags) {
+    TRACY_FUNC(sceNetEpollAbort, eid, flags);
+    auto epoll = lock_and_find(eid, emuenv.net.epolls, emuenv.kernel.mutex);
+    if (!epoll) {
+        return RET_ERROR(SCE_NET_ERROR_EBADF);
+    }
+
+    return epoll->abort();
 }
 
 EXPORT(int, sceNetEpollControl, int eid, SceNetEpollControlFlag op, int id, SceNetEpollEvent *ev) {
@@ -229,13 +234,39 @@ EXPORT(int, sceNetEpollDestroy, int eid) {
     TRACY_FUNC(sceNetEpollDestroy, eid);
 
     const std::lock_guard<std::mutex> lock(emuenv.kernel.mutex);
-    if (emuenv.net.epolls.erase(eid) == 0) {
+    const auto it = emuenv.net.epolls.find(eid);
+    if (it == emuenv.net.epolls.end()) {
         return RET_ERROR(SCE_NET_EBADF);
     }
 
+    // the threads still waiting on it keep it alive until they return
+    it->second->abort();
+    emuenv.net.epolls.erase(it);
     return 0;
 }
 
+// The thread is shown as waiting while it is blocked in the host, like a thread waiting on a kernel object
+static int wait_epoll(EmuEnvState &emuenv, SceUID thread_id, const EpollPtr &epoll, SceNetEpollEvent *events, int maxevents, int timeout) {
+    const ThreadStatePtr thread = emuenv.kernel.get_thread(thread_id);
+    if (!thread || timeout == 0) {
+        return epoll->wait(events, maxevents, timeout);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(thread->mutex);
+        thread->update_status(ThreadStatus::wait);
+    }
+    const int ret = epoll->wait(events, maxevents, timeout);
+    {
+        const std::lock_guard<std::mutex> lock(thread->mutex);
+        if (thread->status == ThreadStatus::wait) {
+            thread->update_status(ThreadStatus::run);
+        }
+    }
+
+    return ret;
+}
+
 EXPORT(int, sceNetEpollWait, int eid, SceNetEpollEvent *events, int maxevents, int timeout) {
     TRACY_FUNC(sceNetEpollWait, eid, events, maxevents, timeout);
     auto epoll = lock_and_find(eid, emuenv.net.epolls, emuenv.kernel.mutex);
@@ -243,12 +274,18 @@ EXPORT(int, sceNetEpollWait, int eid, SceNetEpollEvent *events, int maxevents, i
         return RET_ERROR(SCE_NET_ERROR_EBADF);
     }
 
-    return epoll->wait(events, maxevents, timeout);
+    return wait_epoll(emuenv, thread_id, epoll, events, maxevents, timeout);
 }
 
-EXPORT(int, sceNetEpollWaitCB) {
-    TRACY_FUNC(sceNetEpollWaitCB);
-    return UNIMPLEMENTED();
+EXPORT(int, sceNetEpollWaitCB, int eid, SceNetEpollEvent *events, int maxevents, int timeout) {
+    TRACY_FUNC(sceNetEpollWaitCB, eid, events, maxevents, timeout);
+    auto epoll = lock_and_find(eid, emuenv.net.epolls, emuenv.kernel.mutex);
+    if (!epoll) {
+        return RET_ERROR(SCE_NET_ERROR_EBADF);
+    }
+
+    process_callbacks(emuenv.kernel, thread_id);
+    return wait_epoll(emuenv, thread_id, epoll, events, maxevents, timeout);
 }
 
 EXPORT(Ptr<int>, sceNetErrnoLoc) {
@@ -17,134 +17,523 @@
 
 #include <module/module.h>
 
-EXPORT(int, sceSasCore) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasCoreWithMix) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasExit) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasGetDryPeak) {
-    return UNIMPLEMENTED();
-}
+#include <sas/state.h>
+#include <util/tracy.h>
+
+#include <algorithm>
+
+TRACY_MODULE_NAME(SceSas);
+
+enum SceSasErrorCode : uint32_t {
+    SCE_SAS_ERROR_INVALID_GRAIN = 0x80420001,
+    SCE_SAS_ERROR_INVALID_OUTPUT_MODE = 0x80420003,
+    SCE_SAS_ERROR_BAD_ADDRESS = 0x80420005,
+    SCE_SAS_ERROR_INVALID_VOICE = 0x80420010,
+    SCE_SAS_ERROR_INVALID_NOISE_CLOCK = 0x80420011,
+    SCE_SAS_ERROR_INVALID_PITCH = 0x80420012,
+    SCE_SAS_ERROR_INVALID_ADSR_CURVE_MODE = 0x80420013,
+    SCE_SAS_ERROR_INVALID_PARAMETER = 0x80420014,
+    SCE_SAS_ERROR_INVALID_LOOP_POS = 0x80420015,
+    SCE_SAS_ERROR_VOICE_PAUSED = 0x80420016,
+    SCE_SAS_ERROR_INVALID_VOLUME = 0x80420018,
+    SCE_SAS_ERROR_INVALID_ADSR_RATE = 0x80420019,
+    SCE_SAS_ERROR_INVALID_PCM_SIZE = 0x8042001A,
+    SCE_SAS_ERROR_REV_INVALID_TYPE = 0x80420020,
+    SCE_SAS_ERROR_REV_INVALID_FEEDBACK = 0x80420021,
+    SCE_SAS_ERROR_REV_INVALID_DELAY = 0x80420022,
+    SCE_SAS_ERROR_REV_INVALID_VOLUME = 0x80420023,
+    SCE_SAS_ERROR_NOT_INIT = 0x80420100,
+    SCE_SAS_ERROR_ALREADY_INIT = 0x80420101,
+};
+
+static sas::Voice *get_voice(sas::State &state, const SceInt32 voice_num) {
+    if (voice_num < 0 || voice_num >= state.engine.voice_count)
+        return nullptr;
+    return &state.engine.voices[voice_num];
+}
+
+static bool is_valid_volume(const SceInt32 volume) {
+    return volume >= -sas::VOLUME_MAX && volume <= sas::VOLUME_MAX;
+}
+
+static int init_sas(EmuEnvState &emuenv, const char *export_name, sas::Config &config, Ptr<void> buffer, SceSize size) {
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_ALREADY_INIT);
+    if (config.grain < sas::MIN_GRAIN || config.grain > sas::MAX_GRAIN || (config.grain % 32) != 0)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_GRAIN);
+    if (!buffer || size < sas::needed_memory_size(config))
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
+
+    emuenv.sas.engine.reset(config);
+    emuenv.sas.buffer = buffer;
+    emuenv.sas.buffer_size = size;
+    emuenv.sas.initialized = true;
+    return 0;
+}
+
+EXPORT(int, sceSasCore, SceInt16 *out) {
+    TRACY_FUNC(sceSasCore, out);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (!out)
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
+
+    emuenv.sas.engine.render(out);
+    return 0;
+}
+
+EXPORT(int, sceSasCoreWithMix, SceInt16 *in_out, SceInt32 left_volume, SceInt32 right_volume) {
+    TRACY_FUNC(sceSasCoreWithMix, in_out, left_volume, right_volume);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (!in_out)
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
+    if (left_volume < 0 || left_volume > sas::VOLUME_MAX || right_volume < 0 || right_volume > sas::VOLUME_MAX)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOLUME);
+
+    emuenv.sas.engine.render_mix(in_out, left_volume, right_volume);
+    return 0;
+}
+
+EXPORT(int, sceSasExit, Ptr<void> *buffer, SceSize *size) {
+    TRACY_FUNC(sceSasExit, buffer, size);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+
+    if (buffer)
+        *buffer = emuenv.sas.buffer;
+    if (size)
+        *size = emuenv.sas.buffer_size;
+
+    emuenv.sas.engine.reset(sas::Config{});
+    emuenv.sas.buffer.reset();
+    emuenv.sas.buffer_size = 0;
+    emuenv.sas.initialized = false;
+    return 0;
+}
+
+EXPORT(int, sceSasGetDryPeak, SceInt32 *left, SceInt32 *right) {
+    TRACY_FUNC(sceSasGetDryPeak, left, right);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (!left || !right)
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
+
+    *left = emuenv.sas.engine.dry_peak.left;
+    *right = emuenv.sas.engine.dry_peak.right;
+    return 0;
+}
+
+EXPORT(int, sceSasGetEndState, SceInt32 voice_num) {
+    TRACY_FUNC(sceSasGetEndState, voice_num);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    const sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+
+    return voice->ended ? 1 : 0;
+}
+
+EXPORT(int, sceSasGetEnvelope, SceInt32 voice_num) {
+    TRACY_FUNC(sceSasGetEnvelope, voice_num);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    const sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
 
-EXPORT(int, sceSasGetEndState) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasGetEnvelope) {
-    return UNIMPLEMENTED();
+    return static_cast<int>(voice->envelope.height);
 }
 
 EXPORT(int, sceSasGetGrain) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasGetNeededMemorySize) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasGetOutputmode) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasGetPauseState) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasGetPreMasterPeak) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasGetWetPeak) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasInit) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasInitWithGrain) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetADSR) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetADSRmode) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetDistortion) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetEffect) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetEffectParam) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetEffectType) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetEffectVolume) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetGrain) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetKeyOff) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetKeyOn) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetNoise) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetOutputmode) {
-    return UNIMPLEMENTED();
-}
+    TRACY_FUNC(sceSasGetGrain);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
 
-EXPORT(int, sceSasSetPause) {
-    return UNIMPLEMENTED();
+    return emuenv.sas.engine.grain;
 }
 
-EXPORT(int, sceSasSetPitch) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetSL) {
-    return UNIMPLEMENTED();
-}
+EXPORT(int, sceSasGetNeededMemorySize, const char *config_str, SceSize *size) {
+    TRACY_FUNC(sceSasGetNeededMemorySize, config_str, size);
+    if (!size)
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
 
-EXPORT(int, sceSasSetSimpleADSR) {
-    return UNIMPLEMENTED();
-}
+    sas::Config config;
+    if (!sas::parse_config(config_str, config))
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
 
-EXPORT(int, sceSasSetVoice) {
-    return UNIMPLEMENTED();
+    *size = sas::needed_memory_size(config);
+    return 0;
 }
 
-EXPORT(int, sceSasSetVoicePCM) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, sceSasSetVolume) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasGetOutputmode) {
+    TRACY_FUNC(sceSasGetOutputmode);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+
+    return static_cast<int>(emuenv.sas.engine.output_mode);
+}
+
+EXPORT(int, sceSasGetPauseState, SceInt32 voice_num) {
+    TRACY_FUNC(sceSasGetPauseState, voice_num);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    const sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+
+    return voice->paused ? 1 : 0;
+}
+
+EXPORT(int, sceSasGetPreMasterPeak, SceInt32 *left, SceInt32 *right) {
+    TRACY_FUNC(sceSasGetPreMasterPeak, left, right);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (!left || !right)
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
+
+    *left = emuenv.sas.engine.pre_master_peak.left;
+    *right = emuenv.sas.engine.pre_master_peak.right;
+    return 0;
+}
+
+EXPORT(int, sceSasGetWetPeak, SceInt32 *left, SceInt32 *right) {
+    TRACY_FUNC(sceSasGetWetPeak, left, right);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (!left || !right)
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
+
+    *left = emuenv.sas.engine.wet_peak.left;
+    *right = emuenv.sas.engine.wet_peak.right;
+    return 0;
+}
+
+EXPORT(int, sceSasInit, const char *config_str, Ptr<void> buffer, SceSize size) {
+    TRACY_FUNC(sceSasInit, config_str, buffer, size);
+    sas::Config config;
+    if (!sas::parse_config(config_str, config))
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+
+    return init_sas(emuenv, export_name, config, buffer, size);
+}
+
+EXPORT(int, sceSasInitWithGrain, const char *config_str, SceUInt32 grain, Ptr<void> buffer, SceSize size) {
+    TRACY_FUNC(sceSasInitWithGrain, config_str, grain, buffer, size);
+    sas::Config config;
+    if (!sas::parse_config(config_str, config))
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+
+    config.grain = static_cast<int32_t>(grain);
+    return init_sas(emuenv, export_name, config, buffer, size);
+}
+
+EXPORT(int, sceSasSetADSR, SceInt32 voice_num, SceUInt32 flags, SceInt32 attack, SceInt32 decay, SceInt32 sustain, SceInt32 release) {
+    TRACY_FUNC(sceSasSetADSR, voice_num, flags, attack, decay, sustain, release);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+
+    const SceInt32 rates[] = { attack, decay, sustain, release };
+    for (int i = 0; i < 4; i++) {
+        if ((flags & (1 << i)) && rates[i] < 0)
+            return RET_ERROR(SCE_SAS_ERROR_INVALID_ADSR_RATE);
+    }
+    for (int i = 0; i < 4; i++) {
+        if (flags & (1 << i))
+            voice->envelope.rates[i] = rates[i];
+    }
+    return 0;
+}
+
+EXPORT(int, sceSasSetADSRmode, SceInt32 voice_num, SceUInt32 flags, SceInt32 attack, SceInt32 decay, SceInt32 sustain, SceInt32 release) {
+    TRACY_FUNC(sceSasSetADSRmode, voice_num, flags, attack, decay, sustain, release);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+
+    const SceInt32 curves[] = { attack, decay, sustain, release };
+    for (int i = 0; i < 4; i++) {
+        if ((flags & (1 << i)) && (curves[i] < 0 || curves[i] > static_cast<SceInt32>(sas::AdsrCurve::Direct)))
+            return RET_ERROR(SCE_SAS_ERROR_INVALID_ADSR_CURVE_MODE);
+    }
+    for (int i = 0; i < 4; i++) {
+        if (flags & (1 << i))
+            voice->envelope.curves[i] = static_cast<sas::AdsrCurve>(curves[i]);
+    }
+    return 0;
+}
+
+EXPORT(int, sceSasSetDistortion, SceInt32 voice_num, SceInt32 wet_level) {
+    TRACY_FUNC(sceSasSetDistortion, voice_num, wet_level);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (wet_level < 0 || wet_level > sas::VOLUME_MAX)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+
+    voice->distortion = wet_level;
+    return 0;
+}
+
+EXPORT(int, sceSasSetEffect, SceInt32 dry_switch, SceInt32 wet_switch) {
+    TRACY_FUNC(sceSasSetEffect, dry_switch, wet_switch);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+
+    emuenv.sas.engine.dry_enabled = dry_switch != 0;
+    emuenv.sas.engine.wet_enabled = wet_switch != 0;
+    return 0;
+}
+
+EXPORT(int, sceSasSetEffectParam, SceInt32 delay, SceInt32 feedback) {
+    TRACY_FUNC(sceSasSetEffectParam, delay, feedback);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (delay < 0 || delay > sas::EFFECT_PARAM_MAX)
+        return RET_ERROR(SCE_SAS_ERROR_REV_INVALID_DELAY);
+    if (feedback < 0 || feedback > sas::EFFECT_PARAM_MAX)
+        return RET_ERROR(SCE_SAS_ERROR_REV_INVALID_FEEDBACK);
+
+    emuenv.sas.engine.effect_delay = delay;
+    emuenv.sas.engine.effect_feedback = feedback;
+    return 0;
+}
+
+EXPORT(int, sceSasSetEffectType, SceInt32 type) {
+    TRACY_FUNC(sceSasSetEffectType, type);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (type < static_cast<SceInt32>(sas::EffectType::Off) || type > static_cast<SceInt32>(sas::EffectType::Pipe))
+        return RET_ERROR(SCE_SAS_ERROR_REV_INVALID_TYPE);
+
+    if (static_cast<sas::EffectType>(type) != emuenv.sas.engine.effect_type)
+        emuenv.sas.engine.set_effect_type(static_cast<sas::EffectType>(type));
+    return 0;
+}
+
+EXPORT(int, sceSasSetEffectVolume, SceInt32 left, SceInt32 right) {
+    TRACY_FUNC(sceSasSetEffectVolume, left, right);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (left < 0 || left > sas::VOLUME_MAX || right < 0 || right > sas::VOLUME_MAX)
+        return RET_ERROR(SCE_SAS_ERROR_REV_INVALID_VOLUME);
+
+    emuenv.sas.engine.effect_volume[0] = left;
+    emuenv.sas.engine.effect_volume[1] = right;
+    return 0;
+}
+
+EXPORT(int, sceSasSetGrain, SceInt32 grain) {
+    TRACY_FUNC(sceSasSetGrain, grain);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (grain < sas::MIN_GRAIN || grain > sas::MAX_GRAIN || (grain % 32) != 0)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_GRAIN);
+
+    emuenv.sas.engine.grain = grain;
+    return 0;
+}
+
+EXPORT(int, sceSasSetKeyOff, SceInt32 voice_num) {
+    TRACY_FUNC(sceSasSetKeyOff, voice_num);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (voice->paused)
+        return RET_ERROR(SCE_SAS_ERROR_VOICE_PAUSED);
+
+    voice->key_off();
+    return 0;
+}
+
+EXPORT(int, sceSasSetKeyOn, SceInt32 voice_num) {
+    TRACY_FUNC(sceSasSetKeyOn, voice_num);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (voice->paused)
+        return RET_ERROR(SCE_SAS_ERROR_VOICE_PAUSED);
+
+    voice->key_on();
+    return 0;
+}
+
+EXPORT(int, sceSasSetNoise, SceInt32 voice_num, SceInt32 clock) {
+    TRACY_FUNC(sceSasSetNoise, voice_num, clock);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (clock < 0 || clock > sas::NOISE_CLOCK_MAX)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_NOISE_CLOCK);
+
+    voice->type = sas::SourceType::Noise;
+    voice->noise_clock = clock;
+    return 0;
+}
+
+EXPORT(int, sceSasSetOutputmode, SceInt32 mode) {
+    TRACY_FUNC(sceSasSetOutputmode, mode);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    if (mode != static_cast<SceInt32>(sas::OutputMode::Stereo) && mode != static_cast<SceInt32>(sas::OutputMode::Multichannel))
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_OUTPUT_MODE);
+
+    emuenv.sas.engine.output_mode = static_cast<sas::OutputMode>(mode);
+    return 0;
+}
+
+EXPORT(int, sceSasSetPause, SceInt32 voice_num, SceInt32 pause) {
+    TRACY_FUNC(sceSasSetPause, voice_num, pause);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+
+    voice->paused = pause != 0;
+    return 0;
+}
+
+EXPORT(int, sceSasSetPitch, SceInt32 voice_num, SceInt32 pitch) {
+    TRACY_FUNC(sceSasSetPitch, voice_num, pitch);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (pitch < 0 || pitch > sas::PITCH_MAX)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PITCH);
+
+    voice->pitch = pitch;
+    return 0;
+}
+
+EXPORT(int, sceSasSetSL, SceInt32 voice_num, SceInt32 level) {
+    TRACY_FUNC(sceSasSetSL, voice_num, level);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (level < 0 || level > sas::ENVELOPE_HEIGHT_MAX)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+
+    voice->envelope.sustain_level = level;
+    return 0;
+}
+
+EXPORT(int, sceSasSetSimpleADSR, SceInt32 voice_num, SceUInt16 adsr1, SceUInt16 adsr2) {
+    TRACY_FUNC(sceSasSetSimpleADSR, voice_num, adsr1, adsr2);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+
+    voice->envelope.set_simple(adsr1, adsr2);
+    return 0;
+}
+
+EXPORT(int, sceSasSetVoice, SceInt32 voice_num, const uint8_t *vag, SceInt32 size, SceInt32 loop) {
+    TRACY_FUNC(sceSasSetVoice, voice_num, vag, size, loop);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (!vag)
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
+    if (size <= 0 || (size % HEVAG_FRAME_SIZE) != 0 || loop < 0 || loop > 1)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+
+    voice->type = sas::SourceType::Vag;
+    voice->data = vag;
+    voice->size = static_cast<uint32_t>(size);
+    voice->loop = loop != 0;
+    return 0;
+}
+
+EXPORT(int, sceSasSetVoicePCM, SceInt32 voice_num, const uint8_t *pcm, SceInt32 size, SceInt32 loop_pos) {
+    TRACY_FUNC(sceSasSetVoicePCM, voice_num, pcm, size, loop_pos);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (!pcm)
+        return RET_ERROR(SCE_SAS_ERROR_BAD_ADDRESS);
+    if (size <= 0 || size > sas::PCM_MAX_SAMPLES)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PCM_SIZE);
+    if (loop_pos >= size)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_LOOP_POS);
+
+    // a negative loop position plays the samples once
+    voice->type = sas::SourceType::Pcm;
+    voice->data = pcm;
+    voice->size = static_cast<uint32_t>(size);
+    voice->loop = loop_pos >= 0;
+    voice->loop_pos = static_cast<uint32_t>(std::max(loop_pos, 0));
+    return 0;
+}
+
+EXPORT(int, sceSasSetVolume, SceInt32 voice_num, SceInt32 left, SceInt32 right, SceInt32 wet_left, SceInt32 wet_right) {
+    TRACY_FUNC(sceSasSetVolume, voice_num, left, right, wet_left, wet_right);
+    const std::lock_guard<std::mutex> lock(emuenv.sas.mutex);
+    if (!emuenv.sas.initialized)
+        return RET_ERROR(SCE_SAS_ERROR_NOT_INIT);
+    sas::Voice *voice = get_voice(emuenv.sas, voice_num);
+    if (!voice)
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOICE);
+    if (!is_valid_volume(left) || !is_valid_volume(right) || !is_valid_volume(wet_left) || !is_valid_volume(wet_right))
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOLUME);
+
+    voice->volume[0] = left;
+    voice->volume[1] = right;
+    voice->wet_volume[0] = wet_left;
+    voice->wet_volume[1] = wet_right;
+    return 0;
 }
@@ -17,6 +17,27 @@
 
 #include <module/module.h>
 
+#include <mem/libc.h>
+
+#include <algorithm>
+
+// The kernel would fault or panic on these, leave memory alone instead
+#define INVALID_RANGE() LOG_ERROR_ONCE("{} called on an invalid memory range.", export_name)
+#define CHK_FAILED() LOG_ERROR("{}: buffer overflow detected", export_name)
+
+// Append src_length characters of src at the end of the dst_length characters of dst, then the terminator
+static void concatenate(EmuEnvState &emuenv, const char *export_name, Address dst, uint32_t dst_length, Address src, uint32_t src_length) {
+    if (!guest_memmove(emuenv.mem, dst + dst_length, src, src_length) || !guest_memset(emuenv.mem, dst + dst_length + src_length, 0, 1))
+        INVALID_RANGE();
+}
+
+// strncpy, the rest of dst is padded with zeros
+static void copy_padded(EmuEnvState &emuenv, const char *export_name, Address dst, Address src, uint32_t len) {
+    uint32_t length = 0;
+    if (!guest_strnlen(emuenv.mem, src, len, length) || !guest_memmove(emuenv.mem, dst, src, length) || !guest_memset(emuenv.mem, dst + length, 0, len - length))
+        INVALID_RANGE();
+}
+
 EXPORT(int, __aeabi_idiv) {
     return UNIMPLEMENTED();
 }
@@ -45,52 +66,88 @@ EXPORT(int, __aeabi_ulcmp) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, __memcpy_chk) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, __memcpy_chk, Ptr<void> dst, Ptr<const void> src, SceSize len, SceSize dst_len) {
+    if (len > dst_len)
+        CHK_FAILED();
+    else if (!guest_memmove(emuenv.mem, dst.address(), src.address(), len))
+        INVALID_RANGE();
+    return dst;
 }
 
-EXPORT(int, __memmove_chk) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, __memmove_chk, Ptr<void> dst, Ptr<const void> src, SceSize len, SceSize dst_len) {
+    if (len > dst_len)
+        CHK_FAILED();
+    else if (!guest_memmove(emuenv.mem, dst.address(), src.address(), len))
+        INVALID_RANGE();
+    return dst;
 }
 
-EXPORT(int, __memset_chk) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, __memset_chk, Ptr<void> dst, int c, SceSize len, SceSize dst_len) {
+    if (len > dst_len)
+        CHK_FAILED();
+    else if (!guest_memset(emuenv.mem, dst.address(), static_cast<uint8_t>(c), len))
+        INVALID_RANGE();
+    return dst;
 }
 
 EXPORT(int, __kstack_chk_fail) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, __strncat_chk) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, __strncat_chk, Ptr<char> dst, Ptr<const char> src, SceSize len, SceSize dst_len) {
+    uint32_t dst_length = 0;
+    uint32_t src_length = 0;
+    if (!guest_strnlen(emuenv.mem, dst.address(), dst_len, dst_length) || !guest_strnlen(emuenv.mem, src.address(), len, src_length))
+        INVALID_RANGE();
+    else if (dst_length + src_length >= dst_len)
+        CHK_FAILED();
+    else
+        concatenate(emuenv, export_name, dst.address(), dst_length, src.address(), src_length);
+    return dst;
 }
 
-EXPORT(int, __strncpy_chk) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, __strncpy_chk, Ptr<char> dst, Ptr<const char> src, SceSize len, SceSize dst_len) {
+    if (len > dst_len)
+        CHK_FAILED();
+    else
+        copy_padded(emuenv, export_name, dst.address(), src.address(), len);
+    return dst;
 }
 
 EXPORT(int, look_ctype_table) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, kmemchr) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, kmemchr, Ptr<const void> s, int c, SceSize len) {
+    Address found = 0;
+    if (!guest_memchr(emuenv.mem, s.address(), static_cast<uint8_t>(c), len, found))
+        INVALID_RANGE();
+    return Ptr<void>(found);
 }
 
-EXPORT(int, kmemcmp) {
-    return UNIMPLEMENTED();
+EXPORT(int, kmemcmp, Ptr<const void> s1, Ptr<const void> s2, SceSize len) {
+    int result = 0;
+    if (!guest_memcmp(emuenv.mem, s1.address(), s2.address(), len, result))
+        INVALID_RANGE();
+    return result;
 }
 
-EXPORT(int, kmemcpy) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, kmemcpy, Ptr<void> dst, Ptr<const void> src, SceSize len) {
+    if (!guest_memmove(emuenv.mem, dst.address(), src.address(), len))
+        INVALID_RANGE();
+    return dst;
 }
 
-EXPORT(int, kmemmove) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, kmemmove, Ptr<void> dst, Ptr<const void> src, SceSize len) {
+    if (!guest_memmove(emuenv.mem, dst.address(), src.address(), len))
+        INVALID_RANGE();
+    return dst;
 }
 
-EXPORT(int, kmemset) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, kmemset, Ptr<void> dst, int c, SceSize len) {
+    if (!guest_memset(emuenv.mem, dst.address(), static_cast<uint8_t>(c), len))
+        INVALID_RANGE();
+    return dst;
 }
 
 EXPORT(int, rshift) {
@@ -101,48 +158,115 @@ EXPORT(int, ksnprintf) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, kstrchr) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, kstrcmp) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, strlcat) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, strlcpy) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, kstrlen) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, kstrncat) {
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, kstrchr, Ptr<const char> s, int c) {
+    uint32_t length = 0;
+    Address found = 0;
+    if (!guest_strnlen(emuenv.mem, s.address(), UINT32_MAX, length) || !guest_memchr(emuenv.mem, s.address(), static_cast<uint8_t>(c), length + 1, found))
+        INVALID_RANGE();
+    return Ptr<char>(found);
 }
 
-EXPORT(int, kstrncmp) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, kstrncpy) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, strnlen) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, kstrrchr) {
-    return UNIMPLEMENTED();
-}
-
-EXPORT(int, kstrstr) {
-    return UNIMPLEMENTED();
+EXPORT(int, kstrcmp, Ptr<const char> s1, Ptr<const char> s2) {
+    int result = 0;
+    if (!guest_strncmp(emuenv.mem, s1.address(), s2.address(), UINT32_MAX, result))
+        INVALID_RANGE();
+    return result;
+}
+
+EXPORT(SceSize, strlcat, Ptr<char> dst, Ptr<const char> src, SceSize size) {
+    // returns the length of the string it tried to create
+    uint32_t dst_length = 0;
+    uint32_t src_length = 0;
+    if (!guest_strnlen(emuenv.mem, dst.address(), size, dst_length) || !guest_strnlen(emuenv.mem, src.address(), UINT32_MAX, src_length)) {
+        INVALID_RANGE();
+        return 0;
+    }
+
+    if (dst_length < size)
+        concatenate(emuenv, export_name, dst.address(), dst_length, src.address(), std::min(src_length, size - dst_length - 1));
+    return dst_length + src_length;
+}
+
+EXPORT(SceSize, strlcpy, Ptr<char> dst, Ptr<const char> src, SceSize size) {
+    // returns the length of the string it tried to create
+    uint32_t src_length = 0;
+    if (!guest_strnlen(emuenv.mem, src.address(), UINT32_MAX, src_length)) {
+        INVALID_RANGE();
+        return 0;
+    }
+
+    if (size > 0)
+        concatenate(emuenv, export_name, dst.address(), 0, src.address(), std::min(src_length, size - 1));
+    return src_length;
+}
+
+EXPORT(SceSize, kstrlen, Ptr<const char> s) {
+    uint32_t length = 0;
+    if (!guest_strnlen(emuenv.mem, s.address(), UINT32_MAX, length))
+        INVALID_RANGE();
+    return length;
+}
+
+EXPORT(Ptr<char>, kstrncat, Ptr<char> dst, Ptr<const char> src, SceSize len) {
+    uint32_t dst_length = 0;
+    uint32_t src_length = 0;
+    if (!guest_strnlen(emuenv.mem, dst.address(), UINT32_MAX, dst_length) || !guest_strnlen(emuenv.mem, src.address(), len, src_length))
+        INVALID_RANGE();
+    else
+        concatenate(emuenv, export_name, dst.address(), dst_length, src.address(), src_length);
+    return dst;
+}
+
+EXPORT(int, kstrncmp, Ptr<const char> s1, Ptr<const char> s2, SceSize len) {
+    int result = 0;
+    if (!guest_strncmp(emuenv.mem, s1.address(), s2.address(), len, result))
+        INVALID_RANGE();
+    return result;
+}
+
+EXPORT(Ptr<char>, kstrncpy, Ptr<char> dst, Ptr<const char> src, SceSize len) {
+    copy_padded(emuenv, export_name, dst.address(), src.address(), len);
+    return dst;
+}
+
+EXPORT(SceSize, strnlen, Ptr<const char> s, SceSize max_len) {
+    uint32_t length = 0;
+    if (!guest_strnlen(emuenv.mem, s.address(), max_len, length))
+        INVALID_RANGE();
+    return length;
+}
+
+EXPORT(Ptr<char>, kstrrchr, Ptr<const char> s, int c) {
+    uint32_t length = 0;
+    if (!guest_strnlen(emuenv.mem, s.address(), UINT32_MAX, length)) {
+        INVALID_RANGE();
+        return Ptr<char>();
+    }
+
+    // the terminator is part of the string
+    for (int64_t i = length; i >= 0; i--) {
+        const Address address = s.address() + static_cast<uint32_t>(i);
+        if (*Ptr<const char>(address).get(emuenv.mem) == static_cast<char>(c))
+            return Ptr<char>(address);
+    }
+    return Ptr<char>();
+}
+
+EXPORT(Ptr<char>, kstrstr, Ptr<const char> s1, Ptr<const char> s2) {
+    uint32_t length = 0;
+    uint32_t needle_length = 0;
+    if (!guest_strnlen(emuenv.mem, s1.address(), UINT32_MAX, length) || !guest_strnlen(emuenv.mem, s2.address(), UINT32_MAX, needle_length)) {
+        INVALID_RANGE();
+        return Ptr<char>();
+    }
+
+    for (uint32_t i = 0; i + needle_length <= length; i++) {
+        int result = 0;
+        guest_memcmp(emuenv.mem, s1.address() + i, s2.address(), needle_length, result);
+        if (result == 0)
+            return Ptr<char>(s1.address() + i);
+    }
+    return Ptr<char>();
 }
 
 EXPORT(int, kstrtol) {
@@ -21,6 +21,7 @@
 #include <kernel/types.h>
 
 #include <util/align.h>
+#include <util/byte_stream.h>
 
 #include <util/tracy.h>
 TRACY_MODULE_NAME(SceSysmem);
@@ -73,8 +74,46 @@ struct SysmemState {
     }
 };
 
+static void save_blocks(ByteWriter &writer, const Blocks &blocks) {
+    writer.write(static_cast<uint32_t>(blocks.size()));
+    for (const auto &[uid, block] : blocks) {
+        writer.write(uid);
+        writer.write(*block);
+    }
+}
+
+static bool load_blocks(ByteReader &reader, Blocks &blocks) {
+    const auto count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < count && !reader.failed; i++) {
+        const auto uid = reader.read<SceUID>();
+        blocks.emplace(uid, std::make_shared<KernelMemBlock>(reader.read<KernelMemBlock>()));
+    }
+    return !reader.failed;
+}
+
 LIBRARY_INIT(SceSysmem) {
     emuenv.kernel.obj_store.create<SysmemState>();
+
+    // the memory of the blocks is restored with the rest of the guest memory
+    emuenv.kernel.snapshot_handlers["SceSysmem"] = {
+        [&emuenv](std::string &data) {
+            SysmemState *const state = emuenv.kernel.obj_store.get<SysmemState>();
+            const std::lock_guard<std::mutex> lock(state->mutex);
+            ByteWriter writer(data);
+            writer.write(state->next_uid);
+            save_blocks(writer, state->blocks);
+            save_blocks(writer, state->vm_blocks);
+        },
+        [&emuenv](const std::string &data) {
+            SysmemState *const state = emuenv.kernel.obj_store.get<SysmemState>();
+            const std::lock_guard<std::mutex> lock(state->mutex);
+            ByteReader reader(data);
+            state->next_uid = reader.read<SceUID>();
+            state->blocks.clear();
+            state->vm_blocks.clear();
+            return load_blocks(reader, state->blocks) && load_blocks(reader, state->vm_blocks);
+        },
+    };
 }
 
 constexpr SceUInt32 SCE_KERNEL_ALLOC_MEMBLOCK_ATTR_HAS_ALIGNMENT = 4;
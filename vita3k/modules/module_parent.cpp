@@ -36,7 +36,6 @@
 #include <util/find.h>
 #include <util/lock_and_find.h>
 #include <util/log.h>
-#include <util/string_utils.h>
 
 #include <unordered_set>
 
@@ -131,6 +130,8 @@ void call_import(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread
         auto lr = read_lr(cpu);
         log_import_call('H', nid, thread_id, hle_nid_blacklist, lr);
     }
+    if (emuenv.kernel.debugger.count_import_calls)
+        emuenv.kernel.debugger.count_import_call(nid);
     const ImportFn *fn = resolve_import(nid);
     if (fn) {
         (*fn)(emuenv, cpu, thread_id);
@@ -163,38 +164,17 @@ SceUID load_module(EmuEnvState &emuenv, const std::string &module_path) {
 
     LOG_INFO("Loading module \"{}\"", module_path);
     vfs::FileBuffer module_buffer;
-    bool res;
     VitaIoDevice device = device::get_device(module_path);
     auto device_for_icase = device;
-    fs::path translated_module_path = translate_path(module_path.c_str(), device, emuenv.io.device_paths);
+    const fs::path translated_module_path = translate_path(module_path.c_str(), device, emuenv.io.device_paths);
     auto system_path = device::construct_emulated_path(device, translated_module_path, emuenv.pref_path, emuenv.io.redirect_stdio);
 
-    if (emuenv.io.case_isens_find_enabled && !fs::exists(system_path)) {
-        // Attempt a case-insensitive file search.
-        const auto original_translated_module_path = translated_module_path;
-        const auto cached_path = find_in_cache(emuenv.io, string_utils::tolower(translated_module_path.string()));
-        if (!cached_path.empty()) {
-            translated_module_path = cached_path;
-            LOG_TRACE("Found cached filepath at {}", translated_module_path);
-        } else {
-            const bool path_found = find_case_isens_path(emuenv.io, device_for_icase, translated_module_path, system_path);
-            translated_module_path = find_in_cache(emuenv.io, string_utils::tolower(system_path.string()));
-            if (!translated_module_path.empty() && path_found) {
-                LOG_TRACE("Found file on case-sensitive filesystem at {}", translated_module_path);
-                translated_module_path = translated_module_path.string().substr(emuenv.pref_path.string().length());
-                translated_module_path = translated_module_path.string().substr(translated_module_path.string().find('/') + 1);
-            } else {
-                LOG_ERROR("Missing file at {} (target path: {})", original_translated_module_path.string(), module_path);
-                return SCE_ERROR_ERRNO_ENOENT;
-            }
-        }
+    if (emuenv.io.case_isens_find_enabled && !find_host_path(emuenv.io, device_for_icase, emuenv.pref_path, system_path)) {
+        LOG_ERROR("Missing file at {} (target path: {})", system_path, module_path);
+        return SCE_ERROR_ERRNO_ENOENT;
     }
 
-    if (device == VitaIoDevice::app0)
-        res = vfs::read_app_file(module_buffer, emuenv.pref_path, emuenv.io.app_path, translated_module_path);
-    else
-        res = vfs::read_file(device, module_buffer, emuenv.pref_path, translated_module_path);
-    if (!res) {
+    if (!fs_utils::read_data(system_path, module_buffer)) {
         LOG_ERROR("Failed to read module file {}", module_path);
         return SCE_ERROR_ERRNO_ENOENT;
     }
@@ -0,0 +1,192 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Compares SceNetEpoll waits over many idle UDP sockets and a few active ones with the select loop they used to be:
+// - a poll without any socket ready
+// - a round where a datagram is sent to every active socket and waited for until all were received
+
+#include <net/epoll.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+struct Options {
+    int idle = 1000;
+    int active = 10;
+    int rounds = 2000;
+};
+
+// Waits like Epoll::wait did before the sockets were kept registered in the host
+int select_wait(const std::map<int, EpollSocket> &entries, SceNetEpollEvent *events, int maxevents, int timeout_microseconds) {
+    fd_set readFds, writeFds, exceptFds;
+    FD_ZERO(&readFds);
+    FD_ZERO(&writeFds);
+    FD_ZERO(&exceptFds);
+    int maxFd = 0;
+    for (auto &pair : entries) {
+        if (pair.second.events & SCE_NET_EPOLLIN)
+            FD_SET(pair.second.sock, &readFds);
+        if (pair.second.events & SCE_NET_EPOLLOUT)
+            FD_SET(pair.second.sock, &writeFds);
+        FD_SET(pair.second.sock, &exceptFds);
+        maxFd = std::max(maxFd, static_cast<int>(pair.second.sock));
+    }
+
+    timeval timeout;
+    timeout.tv_sec = timeout_microseconds / 1000000;
+    timeout.tv_usec = timeout_microseconds % 1000000;
+    if (select(maxFd + 1, &readFds, &writeFds, &exceptFds, &timeout) < 0)
+        return -1;
+
+    int count = 0;
+    for (auto &pair : entries) {
+        if (count < maxevents && FD_ISSET(pair.second.sock, &readFds)) {
+            events[count].events = SCE_NET_EPOLLIN;
+            events[count].data = pair.second.data;
+            count++;
+        }
+    }
+    return count;
+}
+
+abs_socket open_socket() {
+    const abs_socket sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(sock, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+    return sock;
+}
+
+struct Sockets {
+    abs_socket sender;
+    std::vector<abs_socket> all;
+    std::vector<sockaddr_in> active_addresses;
+    std::map<int, EpollSocket> entries;
+};
+
+template <typename Wait>
+void run(const char *name, const Options &options, Sockets &sockets, Wait wait) {
+    std::vector<SceNetEpollEvent> events(options.active);
+
+    auto start = clock::now();
+    for (int i = 0; i < options.rounds; i++)
+        wait(events.data(), options.active, 0);
+    const double poll_us = std::chrono::duration<double, std::micro>(clock::now() - start).count() / options.rounds;
+
+    start = clock::now();
+    for (int i = 0; i < options.rounds; i++) {
+        for (const sockaddr_in &addr : sockets.active_addresses)
+            sendto(sockets.sender, "x", 1, 0, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+        int received = 0;
+        while (received < options.active) {
+            const int count = wait(events.data(), options.active, 1000000);
+            for (int j = 0; j < count; j++) {
+                int id;
+                std::memcpy(&id, events[j].data.data, sizeof(id));
+                char data;
+                recv(sockets.all[id], &data, 1, 0);
+            }
+            received += std::max(count, 0);
+        }
+    }
+    const double round_us = std::chrono::duration<double, std::micro>(clock::now() - start).count() / options.rounds;
+
+    fmt::print("{:<8} {:>12.2f} {:>12.2f}\n", name, poll_us, round_us);
+}
+
+void print_usage() {
+    fmt::print("Usage: net-benchmark [--idle N] [--active N] [--rounds N]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--idle" && i + 1 < argc) {
+            options.idle = std::stoi(argv[++i]);
+        } else if (arg == "--active" && i + 1 < argc) {
+            options.active = std::stoi(argv[++i]);
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            options.rounds = std::stoi(argv[++i]);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+#ifdef _WIN32
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+
+    Sockets sockets;
+    sockets.sender = open_socket();
+    Epoll epoll;
+    bool selectable = true;
+    for (int id = 0; id < options.idle + options.active; id++) {
+        const abs_socket sock = open_socket();
+        if (sock < 0) {
+            fmt::print("Could not open {} sockets, raise the limit of open files\n", options.idle + options.active);
+            return 1;
+        }
+        sockets.all.push_back(sock);
+#ifndef _WIN32
+        selectable &= sock < FD_SETSIZE;
+#endif
+
+        SceNetEpollEvent event{};
+        event.events = SCE_NET_EPOLLIN;
+        std::memcpy(event.data.data, &id, sizeof(id));
+        epoll.add(id, sock, &event);
+        sockets.entries.emplace(id, EpollSocket{ event.events, event.data, sock });
+
+        if (id >= options.idle) {
+            sockaddr_in addr{};
+            socklen_t addr_len = sizeof(addr);
+            getsockname(sock, reinterpret_cast<sockaddr *>(&addr), &addr_len);
+            sockets.active_addresses.push_back(addr);
+        }
+    }
+
+    fmt::print("{} idle and {} active sockets, {} rounds, us per poll and per round\n", options.idle, options.active, options.rounds);
+    fmt::print("{:<8} {:>12} {:>12}\n", "wait", "poll", "round");
+    if (selectable) {
+        run("select", options, sockets, [&](SceNetEpollEvent *events, int maxevents, int timeout) {
+            return select_wait(sockets.entries, events, maxevents, timeout);
+        });
+    } else {
+        fmt::print("select   skipped, the sockets do not fit in an fd_set\n");
+    }
+    run("epoll", options, sockets, [&](SceNetEpollEvent *events, int maxevents, int timeout) {
+        return epoll.wait(events, maxevents, timeout);
+    });
+
+    return 0;
+}
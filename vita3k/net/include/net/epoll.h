@@ -2,19 +2,47 @@
 
 #include <net/socket.h>
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
 struct EpollSocket {
     unsigned int events;
     SceNetEpollData data;
     abs_socket sock;
 };
 
+// On Linux the sockets stay registered in a host epoll instance, so that a wait only costs as much as the sockets
+// that are ready, elsewhere they are all polled with select on every wait. Like on the Vita, readiness is level-triggered
+// and errors and hang-ups are reported even when they were not asked for.
 struct Epoll {
-    std::map<int, EpollSocket> eventEntries;
+    Epoll();
+    ~Epoll();
+    Epoll(const Epoll &) = delete;
+    Epoll &operator=(const Epoll &) = delete;
 
     int add(int id, abs_socket sock, SceNetEpollEvent *ev);
     int del(int id, abs_socket sock, SceNetEpollEvent *ev);
     int mod(int id, abs_socket sock, SceNetEpollEvent *ev);
+    // timeout is in microseconds, a negative one waits until a socket is ready or the wait is aborted
     int wait(SceNetEpollEvent *events, int maxevents, int timeout);
+    // makes the threads waiting at the moment return SCE_NET_ERROR_EINTR
+    int abort();
+
+private:
+    std::mutex mutex;
+    std::map<int, EpollSocket> eventEntries;
+    // number of aborts so far, the threads waiting when it changes return
+    uint64_t aborts = 0;
+#ifdef __linux__
+    int host_epoll = -1;
+    // readable until the threads inside wait when it was aborted have all left
+    int abort_event = -1;
+    int waiters = 0;
+    // threads aborted that have not left wait yet, the threads that came in since block on abort_consumed meanwhile
+    int aborted_waiters = 0;
+    std::condition_variable abort_consumed;
+#endif
 };
 
 typedef std::shared_ptr<Epoll> EpollPtr;
@@ -307,7 +307,8 @@ enum SceNetEpollControlFlag : int32_t {
 enum SceNetEpollEventType {
     SCE_NET_EPOLLIN = 1,
     SCE_NET_EPOLLOUT = 2,
-    SCE_NET_EPOLLERR = 8
+    SCE_NET_EPOLLERR = 8,
+    SCE_NET_EPOLLHUP = 0x10
 };
 
 struct SceNetEtherAddr {
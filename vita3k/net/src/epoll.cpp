@@ -1,6 +1,236 @@
 #include <net/epoll.h>
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+#ifdef __linux__
+
+// Host events returned by a single epoll_wait, the ones left are returned by the next wait
+constexpr int MAX_HOST_EVENTS = 256;
+constexpr uint64_t ABORT_EVENT_TAG = UINT64_MAX;
+
+static uint32_t to_host_events(unsigned int events) {
+    uint32_t host_events = 0;
+    if (events & SCE_NET_EPOLLIN) {
+        host_events |= EPOLLIN;
+    }
+    if (events & SCE_NET_EPOLLOUT) {
+        host_events |= EPOLLOUT;
+    }
+    return host_events;
+}
+
+static unsigned int to_guest_events(uint32_t host_events) {
+    unsigned int events = 0;
+    if (host_events & EPOLLIN) {
+        events |= SCE_NET_EPOLLIN;
+    }
+    if (host_events & EPOLLOUT) {
+        events |= SCE_NET_EPOLLOUT;
+    }
+    if (host_events & EPOLLERR) {
+        events |= SCE_NET_EPOLLERR;
+    }
+    if (host_events & EPOLLHUP) {
+        events |= SCE_NET_EPOLLHUP;
+    }
+    return events;
+}
+
+static int translate_host_error() {
+    switch (errno) {
+    case EEXIST:
+        return SCE_NET_ERROR_EEXIST;
+    case ENOENT:
+        return SCE_NET_ERROR_ENOENT;
+    case ENOMEM:
+        return SCE_NET_ERROR_ENOMEM;
+    case ENOSPC:
+        return SCE_NET_ERROR_ENOSPC;
+    case EBADF:
+    case EPERM:
+        return SCE_NET_ERROR_EBADF;
+    default:
+        return SCE_NET_ERROR_EINTERNAL;
+    }
+}
+
+Epoll::Epoll()
+    : host_epoll(epoll_create1(EPOLL_CLOEXEC))
+    , abort_event(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    if (host_epoll >= 0 && abort_event >= 0) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = ABORT_EVENT_TAG;
+        epoll_ctl(host_epoll, EPOLL_CTL_ADD, abort_event, &event);
+    }
+}
+
+Epoll::~Epoll() {
+    if (abort_event >= 0) {
+        ::close(abort_event);
+    }
+    if (host_epoll >= 0) {
+        ::close(host_epoll);
+    }
+}
+
+int Epoll::add(int id, abs_socket sock, SceNetEpollEvent *ev) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (!eventEntries.try_emplace(id, EpollSocket{ ev->events, ev->data, sock }).second) {
+        return SCE_NET_ERROR_EEXIST;
+    }
+
+    epoll_event event{};
+    event.events = to_host_events(ev->events);
+    event.data.u64 = static_cast<uint32_t>(id);
+    if (epoll_ctl(host_epoll, EPOLL_CTL_ADD, sock, &event) < 0) {
+        eventEntries.erase(id);
+        return translate_host_error();
+    }
+
+    return 0;
+}
+
+int Epoll::del(int id, abs_socket sock, SceNetEpollEvent *ev) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto it = eventEntries.find(id);
+    if (it == eventEntries.end()) {
+        return SCE_NET_ERROR_ENOENT;
+    }
+
+    // fails when the socket was closed since, the host already removed it then
+    epoll_ctl(host_epoll, EPOLL_CTL_DEL, it->second.sock, nullptr);
+    eventEntries.erase(it);
+    return 0;
+}
+
+int Epoll::mod(int id, abs_socket sock, SceNetEpollEvent *ev) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    auto it = eventEntries.find(id);
+    if (it == eventEntries.end()) {
+        return SCE_NET_ERROR_ENOENT;
+    }
+
+    epoll_event event{};
+    event.events = to_host_events(ev->events);
+    event.data.u64 = static_cast<uint32_t>(id);
+    if (epoll_ctl(host_epoll, EPOLL_CTL_MOD, it->second.sock, &event) < 0) {
+        return translate_host_error();
+    }
+
+    it->second.events = ev->events;
+    it->second.data = ev->data;
+    return 0;
+}
+
+int Epoll::wait(SceNetEpollEvent *events, int maxevents, int timeout_microseconds) {
+    if (maxevents <= 0) {
+        return SCE_NET_ERROR_EINVAL;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    const uint64_t aborts_before = aborts;
+    waiters++;
+    lock.unlock();
+
+    const auto deadline = Clock::now() + std::chrono::microseconds(std::max(timeout_microseconds, 0));
+    epoll_event host_events[MAX_HOST_EVENTS];
+    // one more for the abort event
+    const int host_maxevents = std::min(maxevents + 1, MAX_HOST_EVENTS);
+    int result = 0;
+    while (true) {
+        int host_timeout = -1;
+        if (timeout_microseconds >= 0) {
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            host_timeout = static_cast<int>(std::max<decltype(left)>(left, 0));
+        }
+
+        const int count = epoll_wait(host_epoll, host_events, host_maxevents, host_timeout);
+        lock.lock();
+        if (aborts != aborts_before) {
+            result = SCE_NET_ERROR_EINTR;
+            break;
+        }
+        if (count < 0 && errno != EINTR) {
+            result = SCE_NET_ERROR_EINTERNAL;
+            break;
+        }
+
+        bool abort_pending = false;
+        for (int i = 0; i < count && result < maxevents; i++) {
+            if (host_events[i].data.u64 == ABORT_EVENT_TAG) {
+                abort_pending = true;
+                continue;
+            }
+            // the socket may have been removed while this thread was not holding the lock
+            const auto it = eventEntries.find(static_cast<int>(host_events[i].data.u64));
+            if (it == eventEntries.end()) {
+                continue;
+            }
+
+            events[result].events = to_guest_events(host_events[i].events);
+            events[result].data = it->second.data;
+            result++;
+        }
+        if (result > 0 || host_timeout == 0) {
+            break;
+        }
+
+        // woken up by an abort meant for the threads that were already waiting, the event stays readable until they left
+        if (abort_pending) {
+            const auto abort_left = [&] { return aborted_waiters == 0 || aborts != aborts_before; };
+            if (timeout_microseconds >= 0) {
+                abort_consumed.wait_until(lock, deadline, abort_left);
+            } else {
+                abort_consumed.wait(lock, abort_left);
+            }
+        }
+        lock.unlock();
+    }
+
+    waiters--;
+    if (aborts != aborts_before && --aborted_waiters == 0) {
+        uint64_t value;
+        [[maybe_unused]] const auto ret = read(abort_event, &value, sizeof(value));
+        abort_consumed.notify_all();
+    }
+
+    return result;
+}
+
+int Epoll::abort() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    aborts++;
+    if (waiters > 0) {
+        // the ones aborted before are still inside and among them
+        aborted_waiters = waiters;
+        const uint64_t value = 1;
+        [[maybe_unused]] const auto ret = write(abort_event, &value, sizeof(value));
+    }
+
+    return 0;
+}
+
+#else
+
+// Longest time spent in select before checking whether the wait was aborted
+constexpr auto ABORT_CHECK_INTERVAL = std::chrono::milliseconds(10);
+
+Epoll::Epoll() = default;
+Epoll::~Epoll() = default;
+
 int Epoll::add(int id, abs_socket sock, SceNetEpollEvent *ev) {
+    const std::lock_guard<std::mutex> lock(mutex);
     if (!eventEntries.try_emplace(id, EpollSocket{ ev->events, ev->data, sock }).second) {
         return SCE_NET_ERROR_EEXIST;
     }
@@ -9,6 +239,7 @@ int Epoll::add(int id, abs_socket sock, SceNetEpollEvent *ev) {
 }
 
 int Epoll::del(int id, abs_socket sock, SceNetEpollEvent *ev) {
+    const std::lock_guard<std::mutex> lock(mutex);
     if (eventEntries.erase(id) == 0) {
         return SCE_NET_ERROR_ENOENT;
     }
@@ -17,6 +248,7 @@ int Epoll::del(int id, abs_socket sock, SceNetEpollEvent *ev) {
 }
 
 int Epoll::mod(int id, abs_socket sock, SceNetEpollEvent *ev) {
+    const std::lock_guard<std::mutex> lock(mutex);
     auto it = eventEntries.find(id);
     if (it == eventEntries.end()) {
         return SCE_NET_ERROR_ENOENT;
@@ -37,53 +269,102 @@ static void add_event_fd_set(fd_set *set, int *maxFd, abs_socket sock) {
 }
 
 int Epoll::wait(SceNetEpollEvent *events, int maxevents, int timeout_microseconds) {
-    fd_set readFds, writeFds, exceptFds;
-    FD_ZERO(&readFds);
-    FD_ZERO(&writeFds);
-    FD_ZERO(&exceptFds);
-    int maxFd = 0;
-
-    for (auto &pair : eventEntries) {
-        if (pair.second.events & SCE_NET_EPOLLIN) {
-            add_event_fd_set(&readFds, &maxFd, pair.second.sock);
-        }
-        if (pair.second.events & SCE_NET_EPOLLOUT) {
-            add_event_fd_set(&writeFds, &maxFd, pair.second.sock);
-        }
-        if (pair.second.events & SCE_NET_EPOLLERR) {
+    if (maxevents <= 0) {
+        return SCE_NET_ERROR_EINVAL;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    const uint64_t aborts_before = aborts;
+
+    const auto deadline = Clock::now() + std::chrono::microseconds(std::max(timeout_microseconds, 0));
+    std::vector<std::pair<int, abs_socket>> polled;
+    int result = 0;
+    while (true) {
+        fd_set readFds, writeFds, exceptFds;
+        FD_ZERO(&readFds);
+        FD_ZERO(&writeFds);
+        FD_ZERO(&exceptFds);
+        int maxFd = 0;
+
+        polled.clear();
+        for (auto &pair : eventEntries) {
+            if (pair.second.events & SCE_NET_EPOLLIN) {
+                add_event_fd_set(&readFds, &maxFd, pair.second.sock);
+            }
+            if (pair.second.events & SCE_NET_EPOLLOUT) {
+                add_event_fd_set(&writeFds, &maxFd, pair.second.sock);
+            }
             add_event_fd_set(&exceptFds, &maxFd, pair.second.sock);
+            polled.emplace_back(pair.first, pair.second.sock);
         }
-    }
+        lock.unlock();
 
-    timeval timeout;
-    timeout.tv_sec = timeout_microseconds / 1000000;
-    timeout.tv_usec = timeout_microseconds % 1000000;
-    auto ret = select(maxFd + 1, &readFds, &writeFds, &exceptFds, &timeout);
-    if (ret < 0) {
-        // TODO: translate error code
-        return -1;
-    }
+        auto slice = std::chrono::duration_cast<std::chrono::microseconds>(ABORT_CHECK_INTERVAL);
+        if (timeout_microseconds >= 0) {
+            slice = std::clamp(std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()), std::chrono::microseconds(0), slice);
+        }
 
-    int eventCount = 0;
-    for (auto &pair : eventEntries) {
-        unsigned int eventTypes = 0;
-        if (FD_ISSET(pair.second.sock, &readFds)) {
-            eventTypes |= SCE_NET_EPOLLIN;
+        int ret = 0;
+        if (polled.empty()) {
+            // select fails without any socket on Windows
+            std::this_thread::sleep_for(slice);
+        } else {
+            timeval timeout;
+            timeout.tv_sec = static_cast<long>(slice.count() / 1000000);
+            timeout.tv_usec = static_cast<long>(slice.count() % 1000000);
+            ret = select(maxFd + 1, &readFds, &writeFds, &exceptFds, &timeout);
         }
-        if (FD_ISSET(pair.second.sock, &writeFds)) {
-            eventTypes |= SCE_NET_EPOLLOUT;
+
+        lock.lock();
+        if (aborts != aborts_before) {
+            result = SCE_NET_ERROR_EINTR;
+            break;
         }
-        if (FD_ISSET(pair.second.sock, &exceptFds)) {
-            eventTypes |= SCE_NET_EPOLLERR;
+        if (ret < 0) {
+            // TODO: translate error code
+            result = SCE_NET_ERROR_EINTERNAL;
+            break;
         }
 
-        if (eventTypes != 0 && eventCount < maxevents) {
-            auto i = eventCount++;
+        for (const auto &[id, sock] : polled) {
+            if (ret == 0 || result == maxevents) {
+                break;
+            }
+            // the socket may have been removed while this thread was not holding the lock
+            const auto it = eventEntries.find(id);
+            if (it == eventEntries.end() || it->second.sock != sock) {
+                continue;
+            }
+
+            unsigned int eventTypes = 0;
+            if (FD_ISSET(sock, &readFds)) {
+                eventTypes |= SCE_NET_EPOLLIN;
+            }
+            if (FD_ISSET(sock, &writeFds)) {
+                eventTypes |= SCE_NET_EPOLLOUT;
+            }
+            if (FD_ISSET(sock, &exceptFds)) {
+                eventTypes |= SCE_NET_EPOLLERR;
+            }
 
-            events[i].events = eventTypes;
-            events[i].data = pair.second.data;
+            if (eventTypes != 0) {
+                events[result].events = eventTypes;
+                events[result].data = it->second.data;
+                result++;
+            }
+        }
+        if (result > 0 || (timeout_microseconds >= 0 && Clock::now() >= deadline)) {
+            break;
         }
     }
 
-    return eventCount;
+    return result;
+}
+
+int Epoll::abort() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    aborts++;
+    return 0;
 }
+
+#endif
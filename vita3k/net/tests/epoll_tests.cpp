@@ -0,0 +1,202 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <net/epoll.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace {
+
+// UDP sockets bound to ports of the loopback interface
+class epoll : public testing::Test {
+protected:
+    static void SetUpTestSuite() {
+#ifdef _WIN32
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+    }
+
+    void TearDown() override {
+        for (const abs_socket sock : sockets) {
+#ifdef _WIN32
+            closesocket(sock);
+#else
+            close(sock);
+#endif
+        }
+    }
+
+    abs_socket open_socket() {
+        const abs_socket sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        EXPECT_EQ(bind(sock, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)), 0);
+        sockets.push_back(sock);
+        return sock;
+    }
+
+    void send_to(abs_socket from, abs_socket to) {
+        sockaddr_in addr{};
+        socklen_t addr_len = sizeof(addr);
+        ASSERT_EQ(getsockname(to, reinterpret_cast<sockaddr *>(&addr), &addr_len), 0);
+        ASSERT_EQ(sendto(from, "x", 1, 0, reinterpret_cast<const sockaddr *>(&addr), addr_len), 1);
+    }
+
+    static void receive(abs_socket sock) {
+        char data;
+        ASSERT_EQ(recv(sock, &data, 1, 0), 1);
+    }
+
+    int add(int id, abs_socket sock, unsigned int events) {
+        SceNetEpollEvent event{};
+        event.events = events;
+        std::memcpy(event.data.data, &id, sizeof(id));
+        return instance.add(id, sock, &event);
+    }
+
+    static int id_of(const SceNetEpollEvent &event) {
+        int id;
+        std::memcpy(&id, event.data.data, sizeof(id));
+        return id;
+    }
+
+    Epoll instance;
+    std::vector<abs_socket> sockets;
+};
+
+} // namespace
+
+TEST_F(epoll, reports_only_the_ready_sockets) {
+    const abs_socket sender = open_socket();
+    std::vector<abs_socket> receivers;
+    for (int i = 0; i < 4; i++) {
+        receivers.push_back(open_socket());
+        ASSERT_EQ(add(i + 1, receivers.back(), SCE_NET_EPOLLIN), 0);
+    }
+
+    SceNetEpollEvent events[8];
+    EXPECT_EQ(instance.wait(events, 8, 0), 0);
+
+    send_to(sender, receivers[2]);
+    ASSERT_EQ(instance.wait(events, 8, 1000000), 1);
+    EXPECT_EQ(events[0].events, static_cast<unsigned int>(SCE_NET_EPOLLIN));
+    EXPECT_EQ(id_of(events[0]), 3);
+}
+
+TEST_F(epoll, is_level_triggered) {
+    const abs_socket sender = open_socket();
+    const abs_socket receiver = open_socket();
+    ASSERT_EQ(add(1, receiver, SCE_NET_EPOLLIN), 0);
+    send_to(sender, receiver);
+
+    SceNetEpollEvent events[1];
+    EXPECT_EQ(instance.wait(events, 1, 1000000), 1);
+    EXPECT_EQ(instance.wait(events, 1, 0), 1);
+
+    receive(receiver);
+    EXPECT_EQ(instance.wait(events, 1, 0), 0);
+}
+
+TEST_F(epoll, controls_the_registered_sockets) {
+    const abs_socket sock = open_socket();
+    ASSERT_EQ(add(1, sock, SCE_NET_EPOLLOUT), 0);
+    EXPECT_EQ(add(1, sock, SCE_NET_EPOLLOUT), SCE_NET_ERROR_EEXIST);
+
+    // an idle UDP socket can always be written to
+    SceNetEpollEvent events[1];
+    ASSERT_EQ(instance.wait(events, 1, 0), 1);
+    EXPECT_EQ(events[0].events, static_cast<unsigned int>(SCE_NET_EPOLLOUT));
+
+    SceNetEpollEvent event{};
+    event.events = SCE_NET_EPOLLIN;
+    ASSERT_EQ(instance.mod(1, sock, &event), 0);
+    EXPECT_EQ(instance.wait(events, 1, 0), 0);
+
+    event.events = SCE_NET_EPOLLOUT;
+    ASSERT_EQ(instance.mod(1, sock, &event), 0);
+    ASSERT_EQ(instance.del(1, sock, &event), 0);
+    EXPECT_EQ(instance.wait(events, 1, 0), 0);
+    EXPECT_EQ(instance.del(1, sock, &event), SCE_NET_ERROR_ENOENT);
+    EXPECT_EQ(instance.mod(1, sock, &event), SCE_NET_ERROR_ENOENT);
+}
+
+TEST_F(epoll, returns_at_most_maxevents) {
+    for (int i = 0; i < 5; i++)
+        ASSERT_EQ(add(i + 1, open_socket(), SCE_NET_EPOLLOUT), 0);
+
+    SceNetEpollEvent events[5];
+    EXPECT_EQ(instance.wait(events, 2, 0), 2);
+    EXPECT_EQ(instance.wait(events, 5, 0), 5);
+    EXPECT_EQ(instance.wait(events, 0, 0), SCE_NET_ERROR_EINVAL);
+}
+
+TEST_F(epoll, times_out) {
+    ASSERT_EQ(add(1, open_socket(), SCE_NET_EPOLLIN), 0);
+
+    SceNetEpollEvent events[1];
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(instance.wait(events, 1, 30000), 0);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(30));
+}
+
+TEST_F(epoll, wakes_up_when_a_socket_becomes_ready) {
+    const abs_socket sender = open_socket();
+    const abs_socket receiver = open_socket();
+    ASSERT_EQ(add(1, receiver, SCE_NET_EPOLLIN), 0);
+
+    auto waiting = std::async(std::launch::async, [&] {
+        SceNetEpollEvent events[1];
+        return instance.wait(events, 1, -1);
+    });
+    EXPECT_EQ(waiting.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+
+    send_to(sender, receiver);
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(waiting.get(), 1);
+}
+
+TEST_F(epoll, abort_wakes_up_the_waiting_threads) {
+    ASSERT_EQ(add(1, open_socket(), SCE_NET_EPOLLIN), 0);
+
+    std::vector<std::future<int>> waiting;
+    for (int i = 0; i < 3; i++) {
+        waiting.push_back(std::async(std::launch::async, [&] {
+            SceNetEpollEvent events[1];
+            return instance.wait(events, 1, -1);
+        }));
+    }
+    EXPECT_EQ(waiting[0].wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+
+    ASSERT_EQ(instance.abort(), 0);
+    for (auto &result : waiting) {
+        ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(result.get(), SCE_NET_ERROR_EINTR);
+    }
+
+    // only the threads waiting at the time are aborted
+    SceNetEpollEvent events[1];
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(instance.wait(events, 1, 20000), 0);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+}
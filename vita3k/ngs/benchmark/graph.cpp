@@ -0,0 +1,272 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+// The graph mixes 192 player voices through three levels of submix busses into a master buss, like a game
+// routing its sounds through category busses. Every voice can run concurrently with the others of its level.
+
+#include "graph.h"
+
+#include <kernel/state.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <ngs/modules/compressor.h>
+#include <ngs/modules/equalizer.h>
+#include <ngs/modules/filter.h>
+#include <ngs/modules/player.h>
+#include <ngs/modules/reverb.h>
+#include <ngs/state.h>
+#include <ngs/system.h>
+
+#include <util/log.h>
+
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int32_t SAMPLE_RATE = 48000;
+// one second of stereo 16-bit noise, looped by every player
+constexpr uint32_t SOURCE_FRAMES = SAMPLE_RATE;
+// each voice of a stage is patched to one voice of the next stage
+constexpr int32_t FAN_IN = 4;
+
+struct Stage {
+    ngs::BussType type;
+    int32_t voice_count;
+};
+
+constexpr Stage STAGES[] = {
+    { ngs::BussType::BUSS_SCREAM, 192 },
+    { ngs::BussType::BUSS_EQUALIZATION, 48 },
+    { ngs::BussType::BUSS_COMPRESSOR, 12 },
+    { ngs::BussType::BUSS_REVERB, 3 },
+    { ngs::BussType::BUSS_MASTER, 1 },
+};
+
+struct Graph {
+    ngs::System *system = nullptr;
+    std::vector<std::vector<ngs::Voice *>> stages;
+};
+
+template <typename T>
+T *parameters(const MemState &mem, ngs::Voice *voice, const uint32_t module) {
+    T *params = voice->datas[module].info.data.cast<T>().get(mem);
+    memset(static_cast<void *>(params), 0, sizeof(T));
+    return params;
+}
+
+void set_equalizer(const MemState &mem, ngs::Voice *voice, const uint32_t module, std::mt19937 &gen) {
+    std::uniform_real_distribution<float> gain(-6.0f, 6.0f);
+
+    SceNgsParamEqParams *eq = parameters<SceNgsParamEqParams>(mem, voice, module);
+    eq->desc = { SCE_NGS_PARAM_EQ_STRUCT_ID, sizeof(SceNgsParamEqParams) };
+    eq->filter[0] = { SCE_NGS_FILTER_HIGHPASS_RESONANT, 80.0f, 0.7071f, 0.0f };
+    eq->filter[1] = { SCE_NGS_FILTER_PEAK, 400.0f, 1.0f, gain(gen) };
+    eq->filter[2] = { SCE_NGS_FILTER_PEAK, 2500.0f, 2.0f, gain(gen) };
+    eq->filter[3] = { SCE_NGS_FILTER_HIGHSHELF, 8000.0f, 0.7071f, gain(gen) };
+}
+
+Graph build_graph(ngs::State &ngs, MemState &mem, const int32_t granularity, const Ptr<void> source) {
+    Graph graph;
+
+    SceNgsSystemInitParams system_params{ static_cast<int32_t>(std::size(STAGES)), 256, granularity, SAMPLE_RATE, 0 };
+    const uint32_t system_size = ngs::System::get_required_memspace_size(&system_params);
+    const Ptr<void> system_memspace(alloc(mem, system_size, "NGS benchmark system"));
+    ngs::init_system(ngs, mem, &system_params, system_memspace, system_size);
+    graph.system = system_memspace.cast<ngs::System>().get(mem);
+
+    for (const Stage &stage : STAGES) {
+        SceNgsRackDescription description{};
+        description.definition = ngs::get_voice_definition(ngs, mem, stage.type);
+        description.voice_count = stage.voice_count;
+        description.channels_per_voice = 2;
+        description.max_patches_per_input = FAN_IN;
+        description.patches_per_output = 1;
+
+        SceNgsBufferInfo rack_info{};
+        rack_info.size = ngs::Rack::get_required_memspace_size(mem, &description);
+        rack_info.data = Ptr<void>(alloc(mem, rack_info.size, "NGS benchmark rack"));
+        ngs::init_rack(ngs, mem, graph.system, &rack_info, &description);
+
+        graph.stages.emplace_back();
+        for (const Ptr<ngs::Voice> &voice : rack_info.data.cast<ngs::Rack>().get(mem)->voices)
+            graph.stages.back().push_back(voice.get(mem));
+    }
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> cutoff(2000.0f, 12000.0f);
+
+    // player, envelope, distortion, equalizer and the two send filters
+    for (size_t i = 0; i < graph.stages[0].size(); i++) {
+        ngs::Voice *voice = graph.stages[0][i];
+
+        SceNgsPlayerParams *player = parameters<SceNgsPlayerParams>(mem, voice, 0);
+        player->descriptor = { SCE_NGS_PLAYER_PARAMS_STRUCT_ID, sizeof(SceNgsPlayerParams) };
+        new (&player->buffer_params[0]) SceNgsPlayerBufferParams{ source, SOURCE_FRAMES * 4, -1, -1 };
+        player->playback_frequency = static_cast<float>(SAMPLE_RATE);
+        player->playback_scalar = 1.0f;
+        player->start_bytes = static_cast<SceInt32>((i * 997) % SOURCE_FRAMES) * 4;
+        player->channels = 2;
+        player->type = ParameterAudioTypePCM;
+
+        set_equalizer(mem, voice, 3, gen);
+
+        SceNgsFilterParams *filter = parameters<SceNgsFilterParams>(mem, voice, 4);
+        filter->desc = { SCE_NGS_FILTER_PARAMS_STRUCT_ID, sizeof(SceNgsFilterParams) };
+        filter->params = { SCE_NGS_FILTER_LOWPASS_RESONANT, cutoff(gen), 0.7071f, 0.0f };
+    }
+
+    for (ngs::Voice *voice : graph.stages[1])
+        set_equalizer(mem, voice, 1, gen);
+
+    for (ngs::Voice *voice : graph.stages[2]) {
+        SceNgsCompressorParams *compressor = parameters<SceNgsCompressorParams>(mem, voice, 1);
+        compressor->desc = { SCE_NGS_COMPRESSOR_PARAMS_STRUCT_ID, sizeof(SceNgsCompressorParams) };
+        compressor->fRatio = 4.0f;
+        compressor->fThreshold = -18.0f;
+        compressor->fAttack = 5.0f;
+        compressor->fRelease = 100.0f;
+        compressor->fMakeupGain = 3.0f;
+        compressor->nStereoLink = SCE_NGS_COMPRESSOR_STEREO_LINK_ON;
+        compressor->nPeakMode = SCE_NGS_COMPRESSOR_RMS_MODE;
+        compressor->fSoftKnee = 6.0f;
+    }
+
+    for (size_t i = 0; i < graph.stages[3].size(); i++) {
+        SceNgsReverbParams *reverb = parameters<SceNgsReverbParams>(mem, graph.stages[3][i], 1);
+        reverb->desc = { SCE_NGS_REVERB_PARAMS_STRUCT_ID_V2, sizeof(SceNgsReverbParams) };
+        reverb->fRoom = -1000.0f;
+        reverb->fRoomHF = -100.0f;
+        reverb->fDecayTime = 1.0f + i * 0.5f;
+        reverb->fDecayHFRatio = 0.8f;
+        reverb->fReflections = -1200.0f;
+        reverb->fReflectionsDelay = 0.01f;
+        reverb->fReverb = -200.0f;
+        reverb->fReverbDelay = 0.02f;
+        reverb->fDiffusion = 100.0f;
+        reverb->fDensity = 100.0f;
+        reverb->fHFReference = 5000.0f;
+        reverb->eEarlyReflectionPattern[0] = SCE_NGS_REVERB_ROOM1_LEFT;
+        reverb->eEarlyReflectionPattern[1] = SCE_NGS_REVERB_ROOM1_RIGHT;
+        reverb->fEarlyReflectionScalar = 1.0f;
+        reverb->fLFReference = 250.0f;
+        reverb->fDryMB = -10000.0f;
+    }
+
+    ngs::VoiceScheduler &scheduler = graph.system->voice_scheduler;
+    for (size_t stage = 0; stage + 1 < graph.stages.size(); stage++) {
+        for (size_t i = 0; i < graph.stages[stage].size(); i++) {
+            ngs::Voice *dest = graph.stages[stage + 1][i / FAN_IN];
+            SceNgsPatchSetupInfo patch_info{ Ptr<ngs::Voice>(graph.stages[stage][i], mem), 0, 0, Ptr<ngs::Voice>(dest, mem), 0 };
+
+            ngs::Patch *patch = scheduler.patch(mem, &patch_info).get(mem);
+            patch->volume_matrix[0][0] = 0.5f;
+            patch->volume_matrix[1][1] = 0.5f;
+        }
+    }
+
+    // the busses first, so each voice gets queued before the voice it delivers to
+    for (auto stage = graph.stages.rbegin(); stage != graph.stages.rend(); ++stage) {
+        for (ngs::Voice *voice : *stage)
+            scheduler.play(mem, voice);
+    }
+
+    return graph;
+}
+
+const std::vector<uint8_t> &master_mix(const Graph &graph) {
+    return graph.stages.back().front()->inputs.inputs[0];
+}
+
+} // namespace
+
+void run_graph_benchmark(const int granularity, const uint32_t workers, const double seconds) {
+    MemState mem;
+    if (!init(mem, false)) {
+        fmt::print("Could not initialize the guest memory\n");
+        return;
+    }
+
+    ngs::State ngs;
+    ngs::init(ngs, mem);
+    KernelState kern;
+
+    const Ptr<int16_t> source(alloc(mem, SOURCE_FRAMES * 4, "NGS benchmark source"));
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> noise(-20000, 20000);
+    for (uint32_t i = 0; i < SOURCE_FRAMES * 2; i++)
+        source.get(mem)[i] = static_cast<int16_t>(noise(gen));
+
+    int32_t voice_count = 0;
+    for (const Stage &stage : STAGES)
+        voice_count += stage.voice_count;
+
+    const double granule_ms = 1000.0 * granularity / SAMPLE_RATE;
+    fmt::print("\nvoice graph: {} voices in {} levels, granularity {} ({:.2f} ms of audio)\n", voice_count, std::size(STAGES), granularity, granule_ms);
+    fmt::print("{:<22} {:>14} {:>16}\n", "workers", "ms/update", "realtime load");
+
+    for (const uint32_t worker_count : { 0u, workers }) {
+        Graph graph = build_graph(ngs, mem, granularity, source);
+        graph.system->voice_scheduler.set_worker_count(worker_count);
+
+        // one untimed update so the lazily created DSP state and the workers are there
+        graph.system->voice_scheduler.update(kern, mem, 0);
+
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        const auto deadline = start + std::chrono::duration<double>(seconds);
+        uint64_t updates = 0;
+        auto now = start;
+        while (now < deadline) {
+            graph.system->voice_scheduler.update(kern, mem, 0);
+            updates++;
+            now = clock::now();
+        }
+
+        const double update_ms = std::chrono::duration<double, std::milli>(now - start).count() / updates;
+        fmt::print("{:<22} {:>14.3f} {:>15.1f}%\n", worker_count, update_ms, 100.0 * update_ms / granule_ms);
+
+        ngs::release_system(ngs, mem, graph.system);
+    }
+
+    // The same updates serially and on the workers must mix the exact same samples
+    Graph serial = build_graph(ngs, mem, granularity, source);
+    Graph parallel = build_graph(ngs, mem, granularity, source);
+    serial.system->voice_scheduler.set_worker_count(0);
+    parallel.system->voice_scheduler.set_worker_count(workers);
+
+    constexpr int COMPARED_UPDATES = 200;
+    int first_difference = -1;
+    for (int i = 0; i < COMPARED_UPDATES && first_difference == -1; i++) {
+        serial.system->voice_scheduler.update(kern, mem, 0);
+        parallel.system->voice_scheduler.update(kern, mem, 0);
+        if (master_mix(serial) != master_mix(parallel))
+            first_difference = i;
+    }
+
+    if (first_difference == -1)
+        fmt::print("master mix of {} updates identical to the serial one\n", COMPARED_UPDATES);
+    else
+        fmt::print("master mix differs from the serial one at update {}\n", first_difference);
+
+    ngs::release_system(ngs, mem, serial.system);
+    ngs::release_system(ngs, mem, parallel.system);
+}
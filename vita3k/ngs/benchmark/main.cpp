@@ -0,0 +1,244 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Runs the NGS DSP kernels over many independent voices and reports how many voice granules each
+// effect gets through per millisecond, and how many voices that makes in real time. Then times the
+// voice scheduler on a whole routing graph, see graph.cpp.
+
+#include "graph.h"
+
+#include <ngs/dsp.h>
+
+#include <util/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ngs::dsp;
+
+namespace {
+
+constexpr float SAMPLE_RATE = 48000.0f;
+
+struct Options {
+    int granularity = 512;
+    int voices = 64;
+    double seconds = 1.0;
+    int workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+};
+
+// One voice of a benchmark case: its own processing state and its own input
+struct BenchVoice {
+    std::vector<std::unique_ptr<ProcessorState>> states;
+    BiquadHistory history[6];
+    std::vector<float> input;
+    std::vector<float> output;
+};
+
+using ProcessFunc = std::function<void(BenchVoice &, int)>;
+
+struct Case {
+    std::string name;
+    std::function<void(BenchVoice &)> setup;
+    ProcessFunc process;
+};
+
+template <typename T>
+T &state(BenchVoice &voice, const size_t index) {
+    return *static_cast<T *>(voice.states[index].get());
+}
+
+std::vector<Case> make_cases() {
+    const BiquadCoefficients eq[4] = {
+        make_biquad(FilterType::HighPass, 80.0f, 0.7071f, 0.0f, SAMPLE_RATE),
+        make_biquad(FilterType::Peak, 400.0f, 1.0f, -3.0f, SAMPLE_RATE),
+        make_biquad(FilterType::Peak, 2500.0f, 2.0f, 4.0f, SAMPLE_RATE),
+        make_biquad(FilterType::HighShelf, 8000.0f, 0.7071f, -6.0f, SAMPLE_RATE),
+    };
+    const BiquadCoefficients sends[2] = {
+        make_biquad(FilterType::LowPass, 6000.0f, 0.7071f, 0.0f, SAMPLE_RATE),
+        make_biquad(FilterType::HighPass, 200.0f, 0.7071f, 0.0f, SAMPLE_RATE),
+    };
+
+    EnvelopeParams envelope{};
+    envelope.points[0] = { 5, 0.0f, EnvelopeCurve::Curved };
+    envelope.points[1] = { 200, 1.0f, EnvelopeCurve::Linear };
+    envelope.points[2] = { 0, 0.6f, EnvelopeCurve::Linear };
+    envelope.count = 3;
+    envelope.release = 100;
+    envelope.loop_end = -1;
+
+    const DistortionParams distortion{ 2.0f, 1.5f, 0.9f, 0.001f, 0.5f, 0.5f };
+
+    CompressorParams compressor{};
+    compressor.ratio = 4.0f;
+    compressor.threshold = -18.0f;
+    compressor.attack = 5.0f;
+    compressor.release = 100.0f;
+    compressor.makeup_gain = 3.0f;
+    compressor.soft_knee = 6.0f;
+    compressor.stereo_link = true;
+
+    DelayParams delay{};
+    delay.dry = 1.0f;
+    delay.mod_rate = 0.5f;
+    for (int i = 0; i < DelayParams::MAX_TAPS; i++)
+        delay.taps[i] = { 60.0f + i * 47.0f, 0.4f, 0.3f, FilterType::LowPassOnePole, 4000.0f, i * 90.0f, 2.0f };
+
+    ReverbParams reverb{};
+    reverb.room = -1000.0f;
+    reverb.room_hf = -100.0f;
+    reverb.decay_time = 1.5f;
+    reverb.decay_hf_ratio = 0.8f;
+    reverb.reflections = -1200.0f;
+    reverb.reflections_delay = 0.01f;
+    reverb.reverb = -200.0f;
+    reverb.reverb_delay = 0.02f;
+    reverb.diffusion = 100.0f;
+    reverb.density = 100.0f;
+    reverb.hf_reference = 5000.0f;
+    reverb.pattern[1] = 1;
+    reverb.early_reflection_scalar = 1.0f;
+    reverb.dry = 0.0f;
+
+    const auto no_setup = [](BenchVoice &) {};
+    const auto with_state = [](auto factory) {
+        return [factory](BenchVoice &voice) { voice.states.push_back(factory()); };
+    };
+
+    std::vector<Case> cases;
+    cases.push_back({ "gain", no_setup, [](BenchVoice &v, int frames) {
+                         apply_gain(v.input.data(), v.output.data(), frames, 0.5f);
+                     } });
+    cases.push_back({ "filter", no_setup, [sends](BenchVoice &v, int frames) {
+                         biquad_chain(sends, v.history, 1, v.input.data(), v.output.data(), frames);
+                     } });
+    cases.push_back({ "equalizer (4 bands)", no_setup, [eq](BenchVoice &v, int frames) {
+                         biquad_chain(eq, v.history, 4, v.input.data(), v.output.data(), frames);
+                     } });
+    cases.push_back({ "envelope", with_state([] { return std::make_unique<Envelope>(); }), [envelope](BenchVoice &v, int frames) {
+                         state<Envelope>(v, 0).process(envelope, SAMPLE_RATE, false, v.input.data(), v.output.data(), frames);
+                     } });
+    cases.push_back({ "distortion", no_setup, [distortion](BenchVoice &v, int frames) {
+                         distort(distortion, v.input.data(), v.output.data(), frames);
+                     } });
+    cases.push_back({ "compressor", with_state([] { return std::make_unique<Compressor>(); }), [compressor](BenchVoice &v, int frames) {
+                         state<Compressor>(v, 0).process(compressor, SAMPLE_RATE, v.input.data(), v.output.data(), frames);
+                     } });
+    cases.push_back({ "delay (4 taps)", with_state([] { return std::make_unique<Delay>(); }), [delay](BenchVoice &v, int frames) {
+                         state<Delay>(v, 0).process(delay, SAMPLE_RATE, v.input.data(), v.output.data(), frames);
+                     } });
+    cases.push_back({ "pitch shift", with_state([] { return std::make_unique<PitchShifter>(); }), [](BenchVoice &v, int frames) {
+                         state<PitchShifter>(v, 0).process(700.0f, SAMPLE_RATE, v.input.data(), v.output.data(), frames);
+                     } });
+    cases.push_back({ "reverb", with_state([] { return std::make_unique<Reverb>(); }), [reverb](BenchVoice &v, int frames) {
+                         state<Reverb>(v, 0).process(reverb, SAMPLE_RATE, v.input.data(), v.output.data(), frames);
+                     } });
+    // what a scream voice goes through: envelope, distortion, equalizer and the two send filters
+    cases.push_back({ "scream voice chain", with_state([] { return std::make_unique<Envelope>(); }), [=](BenchVoice &v, int frames) {
+                         state<Envelope>(v, 0).process(envelope, SAMPLE_RATE, false, v.input.data(), v.output.data(), frames);
+                         distort(distortion, v.output.data(), v.output.data(), frames);
+                         biquad_chain(eq, v.history, 4, v.output.data(), v.output.data(), frames);
+                         biquad_chain(&sends[0], &v.history[4], 1, v.output.data(), v.output.data(), frames);
+                         biquad_chain(&sends[1], &v.history[5], 1, v.output.data(), v.output.data(), frames);
+                     } });
+
+    return cases;
+}
+
+void print_usage() {
+    fmt::print("Usage: ngs-benchmark [--granularity N] [--voices N] [--seconds S] [--workers N]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+
+        if (arg == "--granularity")
+            options.granularity = std::stoi(argv[++i]);
+        else if (arg == "--voices")
+            options.voices = std::stoi(argv[++i]);
+        else if (arg == "--seconds")
+            options.seconds = std::stod(argv[++i]);
+        else if (arg == "--workers")
+            options.workers = std::stoi(argv[++i]);
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (options.granularity <= 0 || options.voices <= 0 || options.seconds <= 0.0 || options.workers < 0) {
+        print_usage();
+        return 1;
+    }
+
+    const double granule_ms = 1000.0 * options.granularity / SAMPLE_RATE;
+    fmt::print("{} voices, granularity {} ({:.2f} ms of audio at {} Hz)\n", options.voices, options.granularity, granule_ms, SAMPLE_RATE);
+    fmt::print("{:<22} {:>14} {:>16}\n", "case", "voices/ms", "realtime voices");
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-0.8f, 0.8f);
+
+    for (const Case &bench : make_cases()) {
+        std::vector<BenchVoice> voices(options.voices);
+        for (BenchVoice &voice : voices) {
+            voice.input.resize(options.granularity * CHANNELS);
+            voice.output.resize(options.granularity * CHANNELS);
+            for (float &sample : voice.input)
+                sample = dist(gen);
+            bench.setup(voice);
+        }
+
+        // one untimed round so lazily sized delay lines are allocated
+        for (BenchVoice &voice : voices)
+            bench.process(voice, options.granularity);
+
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        const auto deadline = start + std::chrono::duration<double>(options.seconds);
+        uint64_t processed = 0;
+        auto now = start;
+        while (now < deadline) {
+            for (BenchVoice &voice : voices)
+                bench.process(voice, options.granularity);
+            processed += voices.size();
+            now = clock::now();
+        }
+
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(now - start).count();
+        const double voices_per_ms = processed / elapsed_ms;
+        fmt::print("{:<22} {:>14.1f} {:>16.0f}\n", bench.name, voices_per_ms, voices_per_ms * granule_ms);
+    }
+
+    run_graph_benchmark(options.granularity, static_cast<uint32_t>(options.workers), options.seconds);
+
+    return 0;
+}
@@ -0,0 +1,247 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Signal processing kernels behind the NGS effect modules. Everything in here works on whole granules of
+// interleaved stereo float frames (the format modules exchange through VoiceProduct) and keeps the two
+// channels, or the independent taps/lines of an effect, in the lanes of a SSE/NEON vector.
+namespace ngs::dsp {
+
+constexpr int CHANNELS = 2;
+
+// Host-side state a module keeps for a voice between granules (filter history, delay lines...)
+struct ProcessorState {
+    virtual ~ProcessorState() = default;
+};
+
+float db_to_gain(float db);
+float millibels_to_gain(float mb);
+
+void apply_gain(const float *src, float *dest, int frames, float gain);
+// Scale every frame by its own gain, shared by both channels
+void apply_gain_curve(const float *src, float *dest, const float *gains, int frames);
+
+enum class FilterType {
+    Off,
+    LowPass,
+    HighPass,
+    BandPassPeak,
+    BandPassZero,
+    Notch,
+    Peak,
+    HighShelf,
+    LowShelf,
+    LowPassOnePole,
+    HighPassOnePole,
+    AllPass,
+    LowPassNormalized,
+};
+
+// y[0] = b0 x[0] + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]
+struct BiquadCoefficients {
+    float b0 = 1.0f;
+    float b1 = 0.0f;
+    float b2 = 0.0f;
+    float a1 = 0.0f;
+    float a2 = 0.0f;
+};
+
+// Audio EQ cookbook designs, resonance is the Q of the filter and gain is in dB (peak and shelves only)
+BiquadCoefficients make_biquad(FilterType type, float frequency, float resonance, float gain, float sample_rate);
+
+struct BiquadHistory {
+    float z1[CHANNELS] = {};
+    float z2[CHANNELS] = {};
+};
+
+// Run the frames through count biquads in series, src and dest may be the same buffer
+void biquad_chain(const BiquadCoefficients *coeffs, BiquadHistory *history, int count, const float *src, float *dest, int frames);
+
+struct DistortionParams {
+    float drive;
+    float shape;
+    float clip;
+    float gate;
+    float wet;
+    float dry;
+};
+
+// wet = clamp(drive * x / (1 + shape * |x|), -clip, clip), silenced below the gate
+void distort(const DistortionParams &params, const float *src, float *dest, int frames);
+
+struct CompressorParams {
+    float ratio;
+    float threshold; // dB
+    float attack; // ms
+    float release; // ms
+    float makeup_gain; // dB
+    float soft_knee; // dB
+    bool stereo_link;
+    bool peak_mode;
+};
+
+struct Compressor : public ProcessorState {
+    float envelope[CHANNELS] = {};
+    float input_level[CHANNELS] = {};
+    float output_level[CHANNELS] = {};
+
+    void process(const CompressorParams &params, float sample_rate, const float *src, float *dest, int frames);
+
+private:
+    std::vector<float> levels;
+};
+
+enum class EnvelopeCurve {
+    Linear,
+    Curved,
+};
+
+struct EnvelopePoint {
+    uint32_t length; // ms to the next point
+    float amplitude;
+    EnvelopeCurve curve;
+};
+
+struct EnvelopeParams {
+    static constexpr uint32_t MAX_POINTS = 4;
+
+    EnvelopePoint points[MAX_POINTS];
+    uint32_t count;
+    uint32_t release; // ms
+    uint32_t loop_start;
+    int32_t loop_end; // negative when not looping
+};
+
+struct Envelope : public ProcessorState {
+    float height = 0.0f;
+    float position = 0.0f; // ms spent in the current segment
+    float release_scale = 1.0f; // fraction of the release left
+    uint32_t point = 0;
+    bool releasing = false;
+
+    // Returns true once the release has faded out completely
+    bool process(const EnvelopeParams &params, float sample_rate, bool key_off, const float *src, float *dest, int frames);
+
+private:
+    float release_height = 0.0f;
+    std::vector<float> gains;
+};
+
+struct DelayTapParams {
+    float delay; // ms
+    float volume;
+    float feedback;
+    FilterType filter; // Off, LowPassOnePole, HighPassOnePole or AllPass
+    float cutoff;
+    float phase_offset; // degrees
+    float mod_width; // ms
+};
+
+struct DelayParams {
+    static constexpr int MAX_TAPS = 4;
+
+    float dry;
+    float mod_rate; // Hz
+    DelayTapParams taps[MAX_TAPS];
+};
+
+struct Delay : public ProcessorState {
+    // Longest delay (including modulation) a tap can reach
+    static constexpr float MAX_DELAY_MS = 4000.0f;
+
+    void process(const DelayParams &params, float sample_rate, const float *src, float *dest, int frames);
+
+private:
+    std::vector<float> lines[DelayParams::MAX_TAPS]; // interleaved stereo, power of two sized
+    uint32_t mask = 0;
+    uint32_t write_pos = 0;
+    float filter_x[CHANNELS][DelayParams::MAX_TAPS] = {};
+    float filter_y[CHANNELS][DelayParams::MAX_TAPS] = {};
+    float lfo_cos = 1.0f;
+    float lfo_sin = 0.0f;
+};
+
+struct PitchShifter : public ProcessorState {
+    void process(float cents, float sample_rate, const float *src, float *dest, int frames);
+
+private:
+    std::vector<float> line;
+    uint32_t mask = 0;
+    uint32_t write_pos = 0;
+    float phase = 0.0f;
+};
+
+struct ReverbParams {
+    float room; // mB
+    float room_hf; // mB
+    float decay_time; // s
+    float decay_hf_ratio;
+    float reflections; // mB
+    float reflections_delay; // s
+    float reverb; // mB
+    float reverb_delay; // s
+    float diffusion; // %
+    float density; // %
+    float hf_reference; // Hz
+    int32_t pattern[CHANNELS]; // early reflection pattern used for each channel, 0 to 5
+    float early_reflection_scalar;
+    float dry; // mB
+
+    bool operator==(const ReverbParams &other) const;
+};
+
+// Early reflections followed by a four line feedback delay network, one line per vector lane
+struct Reverb : public ProcessorState {
+    void process(const ReverbParams &params, float sample_rate, const float *src, float *dest, int frames);
+
+private:
+    void configure(const ReverbParams &params, float sample_rate);
+
+    ReverbParams config{};
+    float config_sample_rate = 0.0f;
+
+    std::vector<float> pre_delay;
+    uint32_t pre_delay_mask = 0;
+    uint32_t pos = 0;
+
+    std::vector<float> diffusers[2];
+    uint32_t diffuser_pos[2] = {};
+
+    std::vector<float> lines[4];
+    uint32_t line_length[4] = {};
+    uint32_t line_pos[4] = {};
+
+    uint32_t early_taps[CHANNELS][4] = {};
+    float early_gains[CHANNELS][4] = {};
+    uint32_t late_delay = 0;
+
+    float input_coeff = 0.0f;
+    float input_state = 0.0f;
+    float diffusion = 0.0f;
+    float line_gains[4] = {};
+    float damping[4] = {};
+    float damping_state[4] = {};
+    float dry_gain = 1.0f;
+    float early_gain = 0.0f;
+    float late_gain = 0.0f;
+};
+
+} // namespace ngs::dsp
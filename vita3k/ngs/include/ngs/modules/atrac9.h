@@ -93,6 +93,8 @@ public:
     uint32_t module_id() const override { return 0x5CAA; }
     void on_state_change(const MemState &mem, ModuleData &v, const VoiceState previous) override;
     void on_param_change(const MemState &mem, ModuleData &data) override;
+    // the decoder is swapped between the voices of the rack
+    bool has_shared_state() const override { return true; }
 
     static constexpr uint32_t get_max_parameter_size() {
         return sizeof(SceNgsAT9Params);
@@ -84,10 +84,12 @@ struct SceNgsPlayerParamsBlock {
 
 namespace ngs {
 
-class PlayerModule : public Module {
-private:
+// Each voice decodes with its own decoder, so voices of a rack can be processed concurrently
+struct PlayerDecoder : public dsp::ProcessorState {
     std::unique_ptr<PCMDecoderState> decoder;
+};
 
+class PlayerModule : public Module {
 public:
     bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override;
     uint32_t module_id() const override { return 0x5CE6; }
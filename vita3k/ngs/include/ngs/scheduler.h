@@ -18,10 +18,12 @@
 #pragma once
 
 #include <util/types.h>
+#include <util/worker_pool.h>
 
 #include <mem/ptr.h>
 
 #include <condition_variable>
+#include <mutex>
 #include <queue>
 #include <vector>
 
@@ -64,14 +66,43 @@ struct VoiceScheduler {
     std::condition_variable_any condvar;
     bool is_updating = false;
 
+    // The patch graph of the queued voices, rebuilt at the next update when the queue changes
+    bool graph_dirty = true;
+    uint32_t graph_id = 0;
+    // Bumped each time a patch or a queue change can make the graph miss a delivery
+    uint32_t graph_generation = 0;
+
 protected:
+    WorkerPool workers;
+    uint32_t worker_count;
+
+    // Scratch storage of update
+    std::vector<std::vector<Voice *>> levels;
+    std::vector<uint8_t> finished;
+
     void deque_insert(const MemState &mem, Voice *voice);
 
     bool resort_to_respect_dependencies(const MemState &mem, Voice *source);
 
     std::int32_t get_position(Voice *v);
 
+    void invalidate_graph();
+    void rebuild_graph(const MemState &mem);
+    void add_to_graph(const MemState &mem, Patch *patch);
+    void raise_level(const MemState &mem, Voice *voice, const uint32_t level);
+    bool is_in_graph(const Voice *voice) const;
+    bool can_process_concurrently(const Voice *voice) const;
+
+    void process_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, const std::vector<Voice *> &queue_copy,
+        Voice *voice, std::unique_lock<std::recursive_mutex> &scheduler_lock);
+    void process_segment(KernelState &kern, const MemState &mem, const SceUID thread_id, const std::vector<Voice *> &queue_copy, const size_t begin, const size_t end);
+
 public:
+    VoiceScheduler();
+
+    // Number of threads helping the updating thread, 0 processes all voices serially
+    void set_worker_count(const uint32_t count);
+
     bool deque_voice(Voice *voice);
 
     bool play(const MemState &mem, Voice *voice);
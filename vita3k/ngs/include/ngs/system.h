@@ -20,12 +20,14 @@
 #include <mem/mempool.h>
 #include <mem/ptr.h>
 #include <ngs/common.h>
+#include <ngs/dsp.h>
 #include <ngs/scheduler.h>
 #include <ngs/types.h>
 #include <util/types.h>
 
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -68,6 +70,7 @@ struct ModuleData {
 
     std::vector<uint8_t> voice_state_data; ///< Voice state.
     std::vector<uint8_t> extra_storage; ///< Local data storage for module.
+    std::unique_ptr<dsp::ProcessorState> processor; ///< Host-side DSP state, dropped on key on.
 
     SceNgsBufferInfo info;
     std::vector<uint8_t> last_info;
@@ -90,6 +93,14 @@ struct ModuleData {
         return reinterpret_cast<T *>(&voice_state_data[0]);
     }
 
+    template <typename T>
+    T *get_processor() {
+        if (!processor)
+            processor = std::make_unique<T>();
+
+        return static_cast<T *>(processor.get());
+    }
+
     template <typename T>
     T *get_parameters(const MemState &mem) {
         if (flags & PARAMS_LOCK) {
@@ -101,6 +112,8 @@ struct ModuleData {
     }
 
     void fill_to_fit_granularity();
+    // Granule sized buffer the module can write its output to
+    float *get_output_buffer();
 
     void invoke_callback(KernelState &kern, const MemState &mem, const SceUID thread_id, const uint32_t reason1,
         const uint32_t reason2, Address reason_ptr);
@@ -118,6 +131,9 @@ public:
     virtual uint32_t get_buffer_parameter_size() const = 0;
     virtual void on_state_change(const MemState &mem, ModuleData &v, const VoiceState previous) {}
     virtual void on_param_change(const MemState &mem, ModuleData &data) {}
+    // Modules keeping state in the module itself share it between all voices of the rack,
+    // these voices can't be processed concurrently
+    virtual bool has_shared_state() const { return false; }
 };
 
 static constexpr uint32_t MAX_VOICE_OUTPUT = 4;
@@ -167,6 +183,12 @@ struct Voice {
     Ptr<void> finished_callback;
     Ptr<void> finished_callback_user_data;
 
+    // Patch graph, maintained by the voice scheduler
+    std::vector<Patch *> incoming; ///< Patches delivering to this voice, in delivery order
+    uint32_t level = 0; ///< Length of the longest chain of queued voices delivering to this one
+    int32_t order = -1; ///< Position in the scheduler queue when the graph was built
+    uint32_t graph_id = 0; ///< Graph build the fields above belong to
+
     void init(Rack *mama);
 
     ModuleData *module_storage(const uint32_t index);
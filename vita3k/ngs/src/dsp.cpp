@@ -0,0 +1,920 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#else
+#include <emmintrin.h>
+#endif
+
+namespace ngs::dsp {
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+
+// Values this small are flushed to zero before they go back into a feedback path, denormals would
+// otherwise slow down every silent tail
+constexpr float DENORMAL_LIMIT = 1e-20f;
+
+#if defined(__aarch64__)
+struct Vec4 {
+    float32x4_t v;
+};
+
+inline Vec4 load(const float *p) { return { vld1q_f32(p) }; }
+inline Vec4 load2(const float *p) { return { vcombine_f32(vld1_f32(p), vdup_n_f32(0.0f)) }; }
+inline void store(float *p, const Vec4 a) { vst1q_f32(p, a.v); }
+inline void store2(float *p, const Vec4 a) { vst1_f32(p, vget_low_f32(a.v)); }
+inline Vec4 set1(const float f) { return { vdupq_n_f32(f) }; }
+inline Vec4 operator+(const Vec4 a, const Vec4 b) { return { vaddq_f32(a.v, b.v) }; }
+inline Vec4 operator-(const Vec4 a, const Vec4 b) { return { vsubq_f32(a.v, b.v) }; }
+inline Vec4 operator*(const Vec4 a, const Vec4 b) { return { vmulq_f32(a.v, b.v) }; }
+inline Vec4 operator/(const Vec4 a, const Vec4 b) { return { vdivq_f32(a.v, b.v) }; }
+inline Vec4 min(const Vec4 a, const Vec4 b) { return { vminq_f32(a.v, b.v) }; }
+inline Vec4 max(const Vec4 a, const Vec4 b) { return { vmaxq_f32(a.v, b.v) }; }
+inline Vec4 abs(const Vec4 a) { return { vabsq_f32(a.v) }; }
+inline Vec4 floor(const Vec4 a) { return { vrndmq_f32(a.v) }; }
+// Exchange the two channels of each stereo frame
+inline Vec4 swap_pairs(const Vec4 a) { return { vrev64q_f32(a.v) }; }
+// Lane-wise a < b ? x : y
+inline Vec4 select_lt(const Vec4 a, const Vec4 b, const Vec4 x, const Vec4 y) { return { vbslq_f32(vcltq_f32(a.v, b.v), x.v, y.v) }; }
+inline float hsum(const Vec4 a) { return vaddvq_f32(a.v); }
+// [x, a0, a1, a2]
+inline Vec4 shift_in(const Vec4 a, const float x) { return { vextq_f32(vdupq_n_f32(x), a.v, 3) }; }
+inline float last_lane(const Vec4 a) { return vgetq_lane_f32(a.v, 3); }
+
+// Split x (> 0) into its exponent and a mantissa in [1, 2)
+inline Vec4 split_exponent(const Vec4 x, Vec4 &mantissa) {
+    const int32x4_t bits = vreinterpretq_s32_f32(x.v);
+    mantissa.v = vreinterpretq_f32_s32(vorrq_s32(vandq_s32(bits, vdupq_n_s32(0x007FFFFF)), vdupq_n_s32(0x3F800000)));
+    return { vcvtq_f32_s32(vsubq_s32(vshrq_n_s32(bits, 23), vdupq_n_s32(127))) };
+}
+
+// 2^e for an integral e in [-126, 127]
+inline Vec4 pow2_int(const Vec4 e) {
+    return { vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(e.v), vdupq_n_s32(127)), 23)) };
+}
+#else
+struct Vec4 {
+    __m128 v;
+};
+
+inline Vec4 load(const float *p) { return { _mm_loadu_ps(p) }; }
+inline Vec4 load2(const float *p) { return { _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(p))) }; }
+inline void store(float *p, const Vec4 a) { _mm_storeu_ps(p, a.v); }
+inline void store2(float *p, const Vec4 a) { _mm_storel_pi(reinterpret_cast<__m64 *>(p), a.v); }
+inline Vec4 set1(const float f) { return { _mm_set1_ps(f) }; }
+inline Vec4 operator+(const Vec4 a, const Vec4 b) { return { _mm_add_ps(a.v, b.v) }; }
+inline Vec4 operator-(const Vec4 a, const Vec4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline Vec4 operator*(const Vec4 a, const Vec4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline Vec4 operator/(const Vec4 a, const Vec4 b) { return { _mm_div_ps(a.v, b.v) }; }
+inline Vec4 min(const Vec4 a, const Vec4 b) { return { _mm_min_ps(a.v, b.v) }; }
+inline Vec4 max(const Vec4 a, const Vec4 b) { return { _mm_max_ps(a.v, b.v) }; }
+inline Vec4 abs(const Vec4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+inline Vec4 floor(const Vec4 a) {
+    // SSE2 has no rounding instruction, truncate and step back for negative values
+    const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    return { _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.0f))) };
+}
+inline Vec4 swap_pairs(const Vec4 a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1)) }; }
+inline Vec4 select_lt(const Vec4 a, const Vec4 b, const Vec4 x, const Vec4 y) {
+    const __m128 mask = _mm_cmplt_ps(a.v, b.v);
+    return { _mm_or_ps(_mm_and_ps(mask, x.v), _mm_andnot_ps(mask, y.v)) };
+}
+inline Vec4 shift_in(const Vec4 a, const float x) {
+    const __m128 shifted = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(a.v), 4));
+    return { _mm_move_ss(shifted, _mm_set_ss(x)) };
+}
+inline float last_lane(const Vec4 a) { return _mm_cvtss_f32(_mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 3, 3, 3))); }
+inline float hsum(const Vec4 a) {
+    const __m128 pairs = _mm_add_ps(a.v, _mm_movehl_ps(a.v, a.v));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+inline Vec4 split_exponent(const Vec4 x, Vec4 &mantissa) {
+    const __m128i bits = _mm_castps_si128(x.v);
+    mantissa.v = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+    return { _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127))) };
+}
+
+inline Vec4 pow2_int(const Vec4 e) {
+    return { _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(e.v), _mm_set1_epi32(127)), 23)) };
+}
+#endif
+
+inline Vec4 set(const float a, const float b, const float c, const float d) {
+    const float lanes[4] = { a, b, c, d };
+    return load(lanes);
+}
+
+inline Vec4 flush_denormals(const Vec4 a) {
+    return select_lt(abs(a), set1(DENORMAL_LIMIT), set1(0.0f), a);
+}
+
+// log2 of positive values within 2e-5, a ten thousandth of a dB once scaled, far below what a gain computer can hear
+inline Vec4 fast_log2(const Vec4 x) {
+    Vec4 m;
+    const Vec4 e = split_exponent(x, m);
+    const Vec4 t = m - set1(1.0f);
+    const Vec4 p = ((((set1(0.0430049578f) * t + set1(-0.187488605f)) * t + set1(0.409470299f)) * t + set1(-0.706486449f)) * t + set1(1.44149241f)) * t + set1(1.65146709e-05f);
+    return e + p;
+}
+
+inline Vec4 fast_exp2(const Vec4 x) {
+    const Vec4 clamped = min(max(x, set1(-126.0f)), set1(126.0f));
+    const Vec4 e = floor(clamped);
+    const Vec4 f = clamped - e;
+    const Vec4 p = (((set1(0.0136703095f) * f + set1(0.0517449978f)) * f + set1(0.241604357f)) * f + set1(0.692972922f)) * f + set1(1.00000349f);
+    return pow2_int(e) * p;
+}
+
+uint32_t next_power_of_two(const uint32_t value) {
+    uint32_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+// Coefficient a of y = (1 - a) x + a y[-1] whose response at w (radians per sample) is gain
+float one_pole_for_gain(float gain, const float w) {
+    if (gain >= 0.9999f)
+        return 0.0f;
+
+    gain = std::max(gain, 0.001f);
+    const float g2 = gain * gain;
+    const float cw = std::cos(w);
+    const float b = 1.0f - g2 * cw;
+    const float discriminant = b * b - (1.0f - g2) * (1.0f - g2);
+    return std::clamp((b - std::sqrt(std::max(discriminant, 0.0f))) / (1.0f - g2), 0.0f, 0.9999f);
+}
+
+// Read a stereo frame delay (>= 0) samples behind pos from a power of two sized interleaved line
+inline Vec4 read_frame(const float *line, const uint32_t mask, const uint32_t pos, const float delay) {
+    const uint32_t whole = static_cast<uint32_t>(delay);
+    const float frac = delay - static_cast<float>(whole);
+    const uint32_t first = (pos - whole) & mask;
+    const uint32_t second = (first - 1) & mask;
+    const Vec4 a = load2(line + first * CHANNELS);
+    const Vec4 b = load2(line + second * CHANNELS);
+    return a + (b - a) * set1(frac);
+}
+
+} // namespace
+
+float db_to_gain(const float db) {
+    return std::pow(10.0f, db / 20.0f);
+}
+
+float millibels_to_gain(const float mb) {
+    return std::pow(10.0f, mb / 2000.0f);
+}
+
+void apply_gain(const float *src, float *dest, const int frames, const float gain) {
+    const int total = frames * CHANNELS;
+    const Vec4 g = set1(gain);
+
+    int i = 0;
+    for (; i + 4 <= total; i += 4)
+        store(dest + i, load(src + i) * g);
+    for (; i < total; i++)
+        dest[i] = src[i] * gain;
+}
+
+void apply_gain_curve(const float *src, float *dest, const float *gains, const int frames) {
+    int i = 0;
+    for (; i + 2 <= frames; i += 2)
+        store(dest + i * CHANNELS, load(src + i * CHANNELS) * set(gains[i], gains[i], gains[i + 1], gains[i + 1]));
+    for (; i < frames; i++) {
+        dest[i * CHANNELS] = src[i * CHANNELS] * gains[i];
+        dest[i * CHANNELS + 1] = src[i * CHANNELS + 1] * gains[i];
+    }
+}
+
+BiquadCoefficients make_biquad(const FilterType type, const float frequency, const float resonance, const float gain, const float sample_rate) {
+    const double f = std::clamp<double>(frequency, 1.0, sample_rate * 0.49);
+    const double w0 = 2.0 * PI * f / sample_rate;
+    const double cw = std::cos(w0);
+    const double q = std::max<double>(resonance, 0.01);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double a = std::pow(10.0, gain / 40.0);
+    const double shelf = 2.0 * std::sqrt(a) * alpha;
+
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+    switch (type) {
+    case FilterType::Off:
+        break;
+    case FilterType::LowPass:
+    case FilterType::LowPassNormalized:
+        b0 = b2 = (1.0 - cw) / 2.0;
+        b1 = 1.0 - cw;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        if (type == FilterType::LowPassNormalized) {
+            // the resonant peak is about q high, scale it back to unity
+            b0 /= std::max(q, 1.0);
+            b1 /= std::max(q, 1.0);
+            b2 /= std::max(q, 1.0);
+        }
+        break;
+    case FilterType::HighPass:
+        b0 = b2 = (1.0 + cw) / 2.0;
+        b1 = -(1.0 + cw);
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    case FilterType::BandPassPeak:
+        b0 = q * alpha;
+        b2 = -q * alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    case FilterType::BandPassZero:
+        b0 = alpha;
+        b2 = -alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    case FilterType::Notch:
+        b0 = b2 = 1.0;
+        b1 = -2.0 * cw;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    case FilterType::AllPass:
+        b0 = 1.0 - alpha;
+        b1 = -2.0 * cw;
+        b2 = 1.0 + alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    case FilterType::Peak:
+        b0 = 1.0 + alpha * a;
+        b1 = -2.0 * cw;
+        b2 = 1.0 - alpha * a;
+        a0 = 1.0 + alpha / a;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha / a;
+        break;
+    case FilterType::LowShelf:
+        b0 = a * ((a + 1.0) - (a - 1.0) * cw + shelf);
+        b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cw);
+        b2 = a * ((a + 1.0) - (a - 1.0) * cw - shelf);
+        a0 = (a + 1.0) + (a - 1.0) * cw + shelf;
+        a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cw);
+        a2 = (a + 1.0) + (a - 1.0) * cw - shelf;
+        break;
+    case FilterType::HighShelf:
+        b0 = a * ((a + 1.0) + (a - 1.0) * cw + shelf);
+        b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cw);
+        b2 = a * ((a + 1.0) + (a - 1.0) * cw - shelf);
+        a0 = (a + 1.0) - (a - 1.0) * cw + shelf;
+        a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cw);
+        a2 = (a + 1.0) - (a - 1.0) * cw - shelf;
+        break;
+    case FilterType::LowPassOnePole: {
+        const double p = std::exp(-w0);
+        b0 = 1.0 - p;
+        a1 = -p;
+        break;
+    }
+    case FilterType::HighPassOnePole: {
+        const double p = std::exp(-w0);
+        b0 = (1.0 + p) / 2.0;
+        b1 = -(1.0 + p) / 2.0;
+        a1 = -p;
+        break;
+    }
+    }
+
+    BiquadCoefficients coeffs;
+    coeffs.b0 = static_cast<float>(b0 / a0);
+    coeffs.b1 = static_cast<float>(b1 / a0);
+    coeffs.b2 = static_cast<float>(b2 / a0);
+    coeffs.a1 = static_cast<float>(a1 / a0);
+    coeffs.a2 = static_cast<float>(a2 / a0);
+    return coeffs;
+}
+
+namespace {
+
+// One biquad on both channels, left and right run in the two low lanes
+void biquad_single(const BiquadCoefficients &coeffs, BiquadHistory &history, const float *src, float *dest, const int frames) {
+    const Vec4 b0 = set1(coeffs.b0);
+    const Vec4 b1 = set1(coeffs.b1);
+    const Vec4 b2 = set1(coeffs.b2);
+    const Vec4 a1 = set1(coeffs.a1);
+    const Vec4 a2 = set1(coeffs.a2);
+
+    // transposed direct form II
+    Vec4 z1 = load2(history.z1);
+    Vec4 z2 = load2(history.z2);
+    for (int i = 0; i < frames; i++) {
+        const Vec4 x = load2(src + i * CHANNELS);
+        const Vec4 y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        store2(dest + i * CHANNELS, y);
+    }
+
+    store2(history.z1, flush_denormals(z1));
+    store2(history.z2, flush_denormals(z2));
+}
+
+// Up to four biquads in series, one per lane. A frame enters lane 0 and moves one lane up per
+// iteration, so every iteration advances all the stages at once on consecutive frames instead of
+// waiting for each stage in turn. The first and last three iterations fill and drain the pipeline.
+void biquad_cascade(const BiquadCoefficients *coeffs, BiquadHistory *history, const int count, const float *src, float *dest, const int frames) {
+    alignas(16) float lanes[5][4];
+    for (int k = 0; k < 4; k++) {
+        // stages past count let the signal through untouched
+        const BiquadCoefficients c = (k < count) ? coeffs[k] : BiquadCoefficients{};
+        lanes[0][k] = c.b0;
+        lanes[1][k] = c.b1;
+        lanes[2][k] = c.b2;
+        lanes[3][k] = c.a1;
+        lanes[4][k] = c.a2;
+    }
+    const Vec4 b0 = load(lanes[0]);
+    const Vec4 b1 = load(lanes[1]);
+    const Vec4 b2 = load(lanes[2]);
+    const Vec4 a1 = load(lanes[3]);
+    const Vec4 a2 = load(lanes[4]);
+    const Vec4 lane_index = set(0.0f, 1.0f, 2.0f, 3.0f);
+
+    Vec4 z1[CHANNELS], z2[CHANNELS], y[CHANNELS];
+    for (int c = 0; c < CHANNELS; c++) {
+        float h1[4] = {}, h2[4] = {};
+        for (int k = 0; k < count; k++) {
+            h1[k] = history[k].z1[c];
+            h2[k] = history[k].z2[c];
+        }
+        z1[c] = load(h1);
+        z2[c] = load(h2);
+        y[c] = set1(0.0f);
+    }
+
+    // fill and drain, lane k works on frame j - k and only moves when that frame is inside the granule
+    const auto step = [&](const int j) {
+        const Vec4 upper = set1(static_cast<float>(j) + 0.5f);
+        const Vec4 lower = set1(static_cast<float>(j - frames));
+        for (int c = 0; c < CHANNELS; c++) {
+            const float x = (j < frames) ? src[j * CHANNELS + c] : 0.0f;
+            const Vec4 u = shift_in(y[c], x);
+            const Vec4 out = b0 * u + z1[c];
+            const Vec4 next_z1 = b1 * u - a1 * out + z2[c];
+            const Vec4 next_z2 = b2 * u - a2 * out;
+            z1[c] = select_lt(lane_index, upper, select_lt(lower, lane_index, next_z1, z1[c]), z1[c]);
+            z2[c] = select_lt(lane_index, upper, select_lt(lower, lane_index, next_z2, z2[c]), z2[c]);
+            y[c] = out;
+        }
+
+        if (j >= 3) {
+            dest[(j - 3) * CHANNELS] = last_lane(y[0]);
+            dest[(j - 3) * CHANNELS + 1] = last_lane(y[1]);
+        }
+    };
+
+    const int total = frames + 3;
+    int j = 0;
+    for (; j < std::min(3, total); j++)
+        step(j);
+
+    // steady state, kept out of the lambda so both channels interleave freely
+    Vec4 y_left = y[0], y_right = y[1];
+    Vec4 z1_left = z1[0], z1_right = z1[1];
+    Vec4 z2_left = z2[0], z2_right = z2[1];
+    for (; j < frames; j++) {
+        const Vec4 u_left = shift_in(y_left, src[j * CHANNELS]);
+        const Vec4 u_right = shift_in(y_right, src[j * CHANNELS + 1]);
+        y_left = b0 * u_left + z1_left;
+        y_right = b0 * u_right + z1_right;
+        z1_left = b1 * u_left - a1 * y_left + z2_left;
+        z1_right = b1 * u_right - a1 * y_right + z2_right;
+        z2_left = b2 * u_left - a2 * y_left;
+        z2_right = b2 * u_right - a2 * y_right;
+        dest[(j - 3) * CHANNELS] = last_lane(y_left);
+        dest[(j - 3) * CHANNELS + 1] = last_lane(y_right);
+    }
+    y[0] = y_left;
+    y[1] = y_right;
+    z1[0] = z1_left;
+    z1[1] = z1_right;
+    z2[0] = z2_left;
+    z2[1] = z2_right;
+
+    for (; j < total; j++)
+        step(j);
+
+    for (int c = 0; c < CHANNELS; c++) {
+        alignas(16) float h1[4], h2[4];
+        store(h1, flush_denormals(z1[c]));
+        store(h2, flush_denormals(z2[c]));
+        for (int k = 0; k < count; k++) {
+            history[k].z1[c] = h1[k];
+            history[k].z2[c] = h2[k];
+        }
+    }
+}
+
+} // namespace
+
+void biquad_chain(const BiquadCoefficients *coeffs, BiquadHistory *history, const int count, const float *src, float *dest, const int frames) {
+    if (count == 0 && src != dest)
+        std::memmove(dest, src, frames * CHANNELS * sizeof(float));
+
+    for (int stage = 0; stage < count; stage += 4) {
+        const float *in = (stage == 0) ? src : dest;
+        const int group = std::min(count - stage, 4);
+        if (group == 1)
+            biquad_single(coeffs[stage], history[stage], in, dest, frames);
+        else
+            biquad_cascade(coeffs + stage, history + stage, group, in, dest, frames);
+    }
+}
+
+void distort(const DistortionParams &params, const float *src, float *dest, const int frames) {
+    const int total = frames * CHANNELS;
+    const float clip = (params.clip > 0.0f) ? params.clip : 1e30f;
+
+    const Vec4 drive = set1(params.drive);
+    const Vec4 shape = set1(params.shape);
+    const Vec4 one = set1(1.0f);
+    const Vec4 high = set1(clip);
+    const Vec4 low = set1(-clip);
+    const Vec4 gate = set1(params.gate);
+    const Vec4 zero = set1(0.0f);
+    const Vec4 wet = set1(params.wet);
+    const Vec4 dry = set1(params.dry);
+
+    const auto process = [&](const Vec4 x) {
+        const Vec4 magnitude = abs(x);
+        Vec4 shaped = drive * x / (one + shape * magnitude);
+        shaped = min(max(shaped, low), high);
+        shaped = select_lt(magnitude, gate, zero, shaped);
+        return wet * shaped + dry * x;
+    };
+
+    int i = 0;
+    for (; i + 4 <= total; i += 4)
+        store(dest + i, process(load(src + i)));
+    if (i < total) {
+        // an odd frame count leaves a single frame behind
+        store2(dest + i, process(load2(src + i)));
+    }
+}
+
+void Compressor::process(const CompressorParams &params, const float sample_rate, const float *src, float *dest, const int frames) {
+    const int total = frames * CHANNELS;
+    levels.resize(total + 4);
+
+    const auto smoothing = [&](const float ms) {
+        return (ms > 0.0f) ? std::exp(-1000.0f / (ms * sample_rate)) : 0.0f;
+    };
+
+    // The detector is recursive so it runs frame by frame with a channel per lane, the gain computer
+    // afterwards is independent for every sample and works on four at a time
+    const Vec4 attack = set1(smoothing(params.attack));
+    const Vec4 release = set1(smoothing(params.release));
+    const Vec4 one = set1(1.0f);
+    Vec4 env = load2(envelope);
+    for (int i = 0; i < frames; i++) {
+        const Vec4 x = load2(src + i * CHANNELS);
+        const Vec4 level = params.peak_mode ? abs(x) : x * x;
+        const Vec4 coeff = select_lt(env, level, attack, release);
+        env = coeff * env + (one - coeff) * level;
+        store2(levels.data() + i * CHANNELS, env);
+    }
+    store2(envelope, flush_denormals(env));
+
+    // level in dB is 20 log10 of a peak or 10 log10 of a mean square
+    const float to_db = params.peak_mode ? 6.0205999f : 3.0103f;
+    const float knee = std::max(params.soft_knee, 0.001f);
+    const float slope = 1.0f / std::max(params.ratio, 1.0f) - 1.0f;
+
+    const Vec4 db_scale = set1(to_db);
+    const Vec4 threshold = set1(params.threshold);
+    const Vec4 half_knee = set1(knee * 0.5f);
+    const Vec4 neg_half_knee = set1(-knee * 0.5f);
+    const Vec4 knee_scale = set1(slope / (2.0f * knee));
+    const Vec4 slope_vec = set1(slope);
+    const Vec4 makeup = set1(params.makeup_gain);
+    const Vec4 db_to_log2 = set1(0.16609640f);
+    const Vec4 floor_level = set1(1e-10f);
+    const Vec4 zero = set1(0.0f);
+
+    const auto gain_at = [&](const float *level_ptr) {
+        Vec4 level = load(level_ptr);
+        if (params.stereo_link)
+            level = max(level, swap_pairs(level));
+        const Vec4 over = db_scale * fast_log2(max(level, floor_level)) - threshold;
+        const Vec4 knee_pos = over + half_knee;
+        const Vec4 in_knee = knee_scale * knee_pos * knee_pos;
+        const Vec4 reduction = select_lt(over, neg_half_knee, zero, select_lt(half_knee, over, slope_vec * over, in_knee));
+        return fast_exp2((reduction + makeup) * db_to_log2);
+    };
+
+    int i = 0;
+    for (; i + 4 <= total; i += 4)
+        store(dest + i, load(src + i) * gain_at(levels.data() + i));
+    if (i < total) {
+        levels[i + 2] = levels[i + 3] = 0.0f;
+        store2(dest + i, load2(src + i) * gain_at(levels.data() + i));
+    }
+
+    if (frames > 0) {
+        alignas(16) float last_gain[4];
+        store(last_gain, gain_at(levels.data() + (frames - 1) * CHANNELS));
+        for (int c = 0; c < CHANNELS; c++) {
+            const float level = levels[(frames - 1) * CHANNELS + c];
+            input_level[c] = params.peak_mode ? level : std::sqrt(level);
+            output_level[c] = input_level[c] * last_gain[c];
+        }
+    }
+}
+
+bool Envelope::process(const EnvelopeParams &params, const float sample_rate, const bool key_off, const float *src, float *dest, const int frames) {
+    const uint32_t count = std::min(params.count, EnvelopeParams::MAX_POINTS);
+    if (count == 0) {
+        if (src != dest)
+            std::memmove(dest, src, frames * CHANNELS * sizeof(float));
+        return false;
+    }
+
+    gains.resize(frames);
+    const float frame_ms = 1000.0f / sample_rate;
+
+    if (key_off && !releasing) {
+        releasing = true;
+        release_height = height;
+        release_scale = 1.0f;
+    }
+
+    const bool looping = params.loop_end >= 0 && static_cast<uint32_t>(params.loop_end) < count && params.loop_start < static_cast<uint32_t>(params.loop_end);
+    const auto next_point = [&]() {
+        point++;
+        if (looping && point == static_cast<uint32_t>(params.loop_end))
+            point = params.loop_start;
+    };
+
+    for (int i = 0; i < frames; i++) {
+        if (releasing) {
+            height = release_height * release_scale;
+            release_scale = (params.release > 0) ? std::max(release_scale - frame_ms / params.release, 0.0f) : 0.0f;
+        } else {
+            // a loop made only of zero length segments must not hang us, give up after one round
+            for (uint32_t guard = 0; point + 1 < count && position >= params.points[point].length && guard <= count; guard++) {
+                position -= params.points[point].length;
+                next_point();
+            }
+
+            if (point + 1 >= count) {
+                // hold the last point until the voice is keyed off
+                point = count - 1;
+                height = params.points[point].amplitude;
+            } else {
+                const EnvelopePoint &from = params.points[point];
+                float t = std::min(position / std::max<float>(from.length, 1e-3f), 1.0f);
+                if (from.curve == EnvelopeCurve::Curved)
+                    t = t * (2.0f - t);
+                height = from.amplitude + (params.points[point + 1].amplitude - from.amplitude) * t;
+            }
+            position += frame_ms;
+        }
+
+        gains[i] = height;
+    }
+
+    apply_gain_curve(src, dest, gains.data(), frames);
+
+    return releasing && release_scale <= 0.0f;
+}
+
+void Delay::process(const DelayParams &params, const float sample_rate, const float *src, float *dest, const int frames) {
+    constexpr int TAPS = DelayParams::MAX_TAPS;
+    const float samples_per_ms = sample_rate / 1000.0f;
+
+    float base[TAPS], width[TAPS], b0[TAPS], b1[TAPS], a1[TAPS], volume[TAPS], feedback[TAPS], offset_cos[TAPS], offset_sin[TAPS];
+    float longest = 0.0f;
+    for (int t = 0; t < TAPS; t++) {
+        const DelayTapParams &tap = params.taps[t];
+        const float delay = std::clamp(tap.delay, 0.0f, MAX_DELAY_MS);
+        const float mod_width = std::clamp(tap.mod_width, 0.0f, MAX_DELAY_MS - delay);
+        // feedback needs at least a frame of delay between writing and reading back
+        base[t] = std::max(delay * samples_per_ms, 1.0f);
+        width[t] = mod_width * samples_per_ms * 0.5f;
+        longest = std::max(longest, base[t] + width[t] * 2.0f);
+
+        volume[t] = tap.volume;
+        feedback[t] = std::clamp(tap.feedback, -0.999f, 0.999f);
+        offset_cos[t] = std::cos(tap.phase_offset * PI / 180.0f);
+        offset_sin[t] = std::sin(tap.phase_offset * PI / 180.0f);
+
+        // first order section per tap, y = b0 x + b1 x[-1] - a1 y[-1]
+        const float w = 2.0f * PI * std::clamp(tap.cutoff, 1.0f, sample_rate * 0.49f) / sample_rate;
+        b0[t] = 1.0f;
+        b1[t] = a1[t] = 0.0f;
+        switch (tap.filter) {
+        case FilterType::LowPassOnePole:
+            a1[t] = -std::exp(-w);
+            b0[t] = 1.0f + a1[t];
+            break;
+        case FilterType::HighPassOnePole:
+            a1[t] = -std::exp(-w);
+            b0[t] = (1.0f - a1[t]) / 2.0f;
+            b1[t] = -b0[t];
+            break;
+        case FilterType::AllPass: {
+            const float tangent = std::tan(w / 2.0f);
+            b0[t] = (tangent - 1.0f) / (tangent + 1.0f);
+            b1[t] = 1.0f;
+            a1[t] = b0[t];
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    const uint32_t needed = next_power_of_two(static_cast<uint32_t>(longest) + 2);
+    if (needed > mask + 1 || lines[0].empty()) {
+        for (auto &line : lines)
+            line.assign(needed * CHANNELS, 0.0f);
+        mask = needed - 1;
+        write_pos = 0;
+    }
+
+    const float rotation = 2.0f * PI * std::max(params.mod_rate, 0.0f) / sample_rate;
+    const float rotation_cos = std::cos(rotation);
+    const float rotation_sin = std::sin(rotation);
+
+    // the four taps sit in the lanes, one vector per channel
+    const Vec4 base_vec = load(base);
+    const Vec4 width_vec = load(width);
+    const Vec4 offset_cos_vec = load(offset_cos);
+    const Vec4 offset_sin_vec = load(offset_sin);
+    const Vec4 b0_vec = load(b0);
+    const Vec4 b1_vec = load(b1);
+    const Vec4 a1_vec = load(a1);
+    const Vec4 volume_vec = load(volume);
+    const Vec4 feedback_vec = load(feedback);
+    const Vec4 one = set1(1.0f);
+
+    Vec4 x1[CHANNELS] = { load(filter_x[0]), load(filter_x[1]) };
+    Vec4 y1[CHANNELS] = { load(filter_y[0]), load(filter_y[1]) };
+
+    for (int i = 0; i < frames; i++) {
+        // sin(phase + offset) of every tap from the one shared oscillator
+        const Vec4 lfo = set1(lfo_sin) * offset_cos_vec + set1(lfo_cos) * offset_sin_vec;
+        alignas(16) float delays[TAPS];
+        store(delays, base_vec + width_vec * (one + lfo));
+
+        alignas(16) float taps[CHANNELS][TAPS];
+        for (int t = 0; t < TAPS; t++) {
+            alignas(16) float frame[4];
+            store(frame, read_frame(lines[t].data(), mask, write_pos, delays[t]));
+            taps[0][t] = frame[0];
+            taps[1][t] = frame[1];
+        }
+
+        for (int c = 0; c < CHANNELS; c++) {
+            const float in = src[i * CHANNELS + c];
+            const Vec4 x = load(taps[c]);
+            const Vec4 y = b0_vec * x + b1_vec * x1[c] - a1_vec * y1[c];
+            x1[c] = x;
+            y1[c] = y;
+
+            alignas(16) float back[TAPS];
+            store(back, flush_denormals(set1(in) + y * feedback_vec));
+            for (int t = 0; t < TAPS; t++)
+                lines[t][write_pos * CHANNELS + c] = back[t];
+
+            dest[i * CHANNELS + c] = params.dry * in + hsum(y * volume_vec);
+        }
+
+        write_pos = (write_pos + 1) & mask;
+
+        const float next_cos = lfo_cos * rotation_cos - lfo_sin * rotation_sin;
+        lfo_sin = lfo_sin * rotation_cos + lfo_cos * rotation_sin;
+        lfo_cos = next_cos;
+    }
+
+    for (int c = 0; c < CHANNELS; c++) {
+        store(filter_x[c], flush_denormals(x1[c]));
+        store(filter_y[c], flush_denormals(y1[c]));
+    }
+
+    // keep the oscillator on the unit circle
+    const float norm = 1.0f / std::sqrt(lfo_cos * lfo_cos + lfo_sin * lfo_sin);
+    lfo_cos *= norm;
+    lfo_sin *= norm;
+}
+
+void PitchShifter::process(const float cents, const float sample_rate, const float *src, float *dest, const int frames) {
+    if (std::abs(cents) < 0.5f) {
+        if (src != dest)
+            std::memmove(dest, src, frames * CHANNELS * sizeof(float));
+        return;
+    }
+
+    // Two read heads sweep a 40 ms window half a window apart, each fading out before it wraps around
+    const float window = std::round(sample_rate * 0.04f);
+    const uint32_t size = next_power_of_two(static_cast<uint32_t>(window) + 2);
+    if (size != mask + 1 || line.empty()) {
+        line.assign(size * CHANNELS, 0.0f);
+        mask = size - 1;
+        write_pos = 0;
+        phase = 0.0f;
+    }
+
+    const float ratio = std::exp2(cents / 1200.0f);
+    // the delay of a head shrinks by ratio - 1 samples every frame
+    const float step = (1.0f - ratio) / window;
+
+    for (int i = 0; i < frames; i++) {
+        store2(line.data() + write_pos * CHANNELS, load2(src + i * CHANNELS));
+
+        const float phase_b = (phase >= 0.5f) ? phase - 0.5f : phase + 0.5f;
+        const Vec4 a = read_frame(line.data(), mask, write_pos, phase * window);
+        const Vec4 b = read_frame(line.data(), mask, write_pos, phase_b * window);
+        const float gain_a = 1.0f - std::abs(2.0f * phase - 1.0f);
+        store2(dest + i * CHANNELS, a * set1(gain_a) + b * set1(1.0f - gain_a));
+
+        phase += step;
+        phase -= std::floor(phase);
+        write_pos = (write_pos + 1) & mask;
+    }
+}
+
+bool ReverbParams::operator==(const ReverbParams &other) const {
+    return std::memcmp(this, &other, sizeof(ReverbParams)) == 0;
+}
+
+namespace {
+
+// Tap times in ms after the reflections delay, for the left and right variants of the three rooms
+constexpr float EARLY_REFLECTION_TIMES[6][4] = {
+    { 4.3f, 8.9f, 13.1f, 21.7f },
+    { 5.1f, 9.7f, 14.9f, 23.3f },
+    { 7.1f, 15.3f, 24.7f, 36.1f },
+    { 8.3f, 17.9f, 27.1f, 39.7f },
+    { 11.3f, 23.9f, 37.3f, 53.9f },
+    { 12.7f, 26.3f, 41.9f, 58.1f },
+};
+
+constexpr float EARLY_REFLECTION_GAINS[4] = { 0.42f, 0.31f, 0.23f, 0.16f };
+
+// Mutually prime lengths in samples at 44.1 kHz
+constexpr uint32_t DIFFUSER_LENGTHS[2] = { 142, 107 };
+constexpr uint32_t LINE_LENGTHS[4] = { 1116, 1356, 1557, 1733 };
+
+} // namespace
+
+void Reverb::configure(const ReverbParams &params, const float sample_rate) {
+    const float scale = sample_rate / 44100.0f;
+    if (sample_rate != config_sample_rate) {
+        // room for the longest reflections delay, reverb delay and early reflection tap
+        const uint32_t pre_delay_size = next_power_of_two(static_cast<uint32_t>(sample_rate * 0.5f));
+        pre_delay.assign(pre_delay_size, 0.0f);
+        pre_delay_mask = pre_delay_size - 1;
+        pos = 0;
+
+        for (int d = 0; d < 2; d++) {
+            diffusers[d].assign(std::max<uint32_t>(static_cast<uint32_t>(DIFFUSER_LENGTHS[d] * scale), 1), 0.0f);
+            diffuser_pos[d] = 0;
+        }
+        for (int l = 0; l < 4; l++) {
+            lines[l].assign(static_cast<uint32_t>(LINE_LENGTHS[l] * scale) + 1, 0.0f);
+            line_pos[l] = 0;
+            damping_state[l] = 0.0f;
+        }
+        input_state = 0.0f;
+    }
+
+    config = params;
+    config_sample_rate = sample_rate;
+
+    const float reflections_delay = std::clamp(params.reflections_delay, 0.0f, 0.3f) * sample_rate;
+    for (int c = 0; c < CHANNELS; c++) {
+        const int pattern = std::clamp(params.pattern[c], 0, 5);
+        for (int t = 0; t < 4; t++) {
+            early_taps[c][t] = static_cast<uint32_t>(reflections_delay + EARLY_REFLECTION_TIMES[pattern][t] * sample_rate / 1000.0f);
+            early_gains[c][t] = EARLY_REFLECTION_GAINS[t];
+        }
+    }
+    late_delay = static_cast<uint32_t>(reflections_delay + std::clamp(params.reverb_delay, 0.0f, 0.1f) * sample_rate);
+
+    const float hf_w = 2.0f * PI * std::clamp(params.hf_reference, 20.0f, sample_rate * 0.45f) / sample_rate;
+    input_coeff = one_pole_for_gain(millibels_to_gain(std::min(params.room_hf, 0.0f)), hf_w);
+    diffusion = 0.7f * std::clamp(params.diffusion, 0.0f, 100.0f) / 100.0f;
+
+    const float decay = std::clamp(params.decay_time, 0.1f, 20.0f);
+    const float hf_ratio = std::clamp(params.decay_hf_ratio, 0.1f, 2.0f);
+    const float density = 0.4f + 0.6f * std::clamp(params.density, 0.0f, 100.0f) / 100.0f;
+    for (int l = 0; l < 4; l++) {
+        line_length[l] = std::clamp<uint32_t>(static_cast<uint32_t>(LINE_LENGTHS[l] * scale * density), 16, static_cast<uint32_t>(lines[l].size()));
+        line_pos[l] %= line_length[l];
+
+        // -60 dB after decay seconds, and after decay * hf_ratio seconds at the HF reference
+        const float seconds = line_length[l] / sample_rate;
+        line_gains[l] = std::pow(10.0f, -3.0f * seconds / decay);
+        if (hf_ratio < 1.0f) {
+            const float hf_gain = std::pow(10.0f, -3.0f * seconds / (decay * hf_ratio));
+            damping[l] = one_pole_for_gain(hf_gain / line_gains[l], hf_w);
+        } else {
+            damping[l] = 0.0f;
+        }
+    }
+
+    const float room = millibels_to_gain(std::min(params.room, 0.0f));
+    dry_gain = millibels_to_gain(std::min(params.dry, 0.0f));
+    early_gain = room * millibels_to_gain(std::min(params.reflections, 1000.0f)) * std::max(params.early_reflection_scalar, 0.0f);
+    late_gain = room * millibels_to_gain(std::min(params.reverb, 2000.0f)) * 0.5f;
+}
+
+void Reverb::process(const ReverbParams &params, const float sample_rate, const float *src, float *dest, const int frames) {
+    if (sample_rate != config_sample_rate || !(params == config))
+        configure(params, sample_rate);
+
+    const Vec4 early_left_gains = load(early_gains[0]);
+    const Vec4 early_right_gains = load(early_gains[1]);
+    const Vec4 gains = load(line_gains);
+    const Vec4 damp = load(damping);
+    const Vec4 one = set1(1.0f);
+    Vec4 damped = load(damping_state);
+
+    for (int i = 0; i < frames; i++) {
+        const float left = src[i * CHANNELS];
+        const float right = src[i * CHANNELS + 1];
+
+        input_state = 0.5f * (left + right) + input_coeff * (input_state - 0.5f * (left + right));
+        pre_delay[pos] = input_state;
+
+        const auto tap = [&](const uint32_t delay) {
+            return pre_delay[(pos - delay) & pre_delay_mask];
+        };
+        const float early_left = hsum(set(tap(early_taps[0][0]), tap(early_taps[0][1]), tap(early_taps[0][2]), tap(early_taps[0][3])) * early_left_gains);
+        const float early_right = hsum(set(tap(early_taps[1][0]), tap(early_taps[1][1]), tap(early_taps[1][2]), tap(early_taps[1][3])) * early_right_gains);
+
+        // two allpasses smear the input before it reaches the delay network
+        float late_in = tap(late_delay);
+        for (int d = 0; d < 2; d++) {
+            const float delayed = diffusers[d][diffuser_pos[d]];
+            const float out = delayed - diffusion * late_in;
+            diffusers[d][diffuser_pos[d]] = late_in + diffusion * out;
+            diffuser_pos[d] = (diffuser_pos[d] + 1 == diffusers[d].size()) ? 0 : diffuser_pos[d] + 1;
+            late_in = out;
+        }
+
+        // each lane is one delay line: damp, attenuate, then feed back through a Householder matrix
+        const Vec4 out = set(lines[0][line_pos[0]], lines[1][line_pos[1]], lines[2][line_pos[2]], lines[3][line_pos[3]]);
+        damped = out * (one - damp) + damped * damp;
+        const Vec4 attenuated = damped * gains;
+        const Vec4 back = flush_denormals(attenuated - set1(0.5f * hsum(attenuated)) + set1(late_in));
+
+        alignas(16) float lanes[4];
+        store(lanes, back);
+        for (int l = 0; l < 4; l++) {
+            lines[l][line_pos[l]] = lanes[l];
+            line_pos[l] = (line_pos[l] + 1 == line_length[l]) ? 0 : line_pos[l] + 1;
+        }
+
+        store(lanes, attenuated);
+        dest[i * CHANNELS] = dry_gain * left + early_gain * early_left + late_gain * (lanes[0] + lanes[2]);
+        dest[i * CHANNELS + 1] = dry_gain * right + early_gain * early_right + late_gain * (lanes[1] + lanes[3]);
+
+        pos = (pos + 1) & pre_delay_mask;
+    }
+
+    store(damping_state, flush_denormals(damped));
+    if (std::abs(input_state) < DENORMAL_LIMIT)
+        input_state = 0.0f;
+}
+
+} // namespace ngs::dsp
@@ -16,16 +16,39 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/compressor.h>
-#include <util/log.h>
 
 namespace ngs {
 
 bool CompressorModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_COMPRESSOR_PARAMS_STRUCT_ID || desc->id == SCE_NGS_COMPRESSOR_PARAMS_STRUCT_ID_V2) {
-            LOG_WARN_ONCE("Game is using unimplemented compressor audio module");
-        }
+    VoiceProduct &product = data.parent->products[0];
+    if (data.is_bypassed || !product.data)
+        return false;
+
+    const SceNgsCompressorParams *params = data.get_parameters<SceNgsCompressorParams>(mem);
+    if (params->desc.id != SCE_NGS_COMPRESSOR_PARAMS_STRUCT_ID && params->desc.id != SCE_NGS_COMPRESSOR_PARAMS_STRUCT_ID_V2)
+        return false;
+
+    dsp::CompressorParams compressor;
+    compressor.ratio = params->fRatio;
+    compressor.threshold = params->fThreshold;
+    compressor.attack = params->fAttack;
+    compressor.release = params->fRelease;
+    compressor.makeup_gain = params->fMakeupGain;
+    compressor.soft_knee = params->fSoftKnee;
+    compressor.stereo_link = params->nStereoLink == SCE_NGS_COMPRESSOR_STEREO_LINK_ON;
+    compressor.peak_mode = params->nPeakMode == SCE_NGS_COMPRESSOR_PEAK_MODE;
+
+    // The side chain variant is fed like the normal one for now, the key input is not looked at
+    dsp::Compressor *processor = data.get_processor<dsp::Compressor>();
+    float *output = data.get_output_buffer();
+    processor->process(compressor, static_cast<float>(data.parent->rack->system->sample_rate), reinterpret_cast<const float *>(product.data),
+        output, data.parent->rack->system->granularity);
+    product.data = reinterpret_cast<uint8_t *>(output);
+
+    SceNgsCompressorStates *state = data.get_state<SceNgsCompressorStates>();
+    for (int i = 0; i < SCE_NGS_MAX_SYSTEM_CHANNELS; i++) {
+        state->fInputLevel[i] = processor->input_level[i];
+        state->fOutputLevel[i] = processor->output_level[i];
     }
 
     return false;
@@ -16,18 +16,45 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/delay.h>
-#include <util/log.h>
 
 namespace ngs {
 
+static dsp::FilterType delay_filter_type(const SceNgsDelayFilterMode mode) {
+    switch (mode) {
+    case SCE_NGS_DELAY_FILTER_MODE_LOWPASS_ONEPOLE:
+        return dsp::FilterType::LowPassOnePole;
+    case SCE_NGS_DELAY_FILTER_MODE_HIGHPASS_ONEPOLE:
+        return dsp::FilterType::HighPassOnePole;
+    case SCE_NGS_DELAY_FILTER_MODE_ALLPASS:
+        return dsp::FilterType::AllPass;
+    default:
+        return dsp::FilterType::Off;
+    }
+}
+
 bool DelayModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_DELAY_PARAMS_STRUCT_ID) {
-            LOG_WARN_ONCE("Game is using unimplemented delay audio module");
-        }
+    VoiceProduct &product = data.parent->products[0];
+    if (data.is_bypassed || !product.data)
+        return false;
+
+    const SceNgsDelayParams *params = data.get_parameters<SceNgsDelayParams>(mem);
+    if (params->desc.id != SCE_NGS_DELAY_PARAMS_STRUCT_ID)
+        return false;
+
+    dsp::DelayParams delay;
+    delay.dry = params->fDryVol;
+    delay.mod_rate = params->fModRate;
+    for (int i = 0; i < SCE_NGS_DELAY_MAX_TAPS; i++) {
+        const SceNgsDelayTap &tap = params->taps[i];
+        delay.taps[i] = { tap.fDelayMillisecs, tap.fVolume, tap.fFeedback, delay_filter_type(tap.eFilterMode), tap.fCutoff,
+            tap.fPhaseOffsetDeg, tap.fModWidthMillisecs };
     }
 
+    float *output = data.get_output_buffer();
+    data.get_processor<dsp::Delay>()->process(delay, static_cast<float>(data.parent->rack->system->sample_rate),
+        reinterpret_cast<const float *>(product.data), output, data.parent->rack->system->granularity);
+    product.data = reinterpret_cast<uint8_t *>(output);
+
     return false;
 }
 } // namespace ngs
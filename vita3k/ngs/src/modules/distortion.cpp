@@ -16,17 +16,24 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/distortion.h>
-#include <util/log.h>
 
 namespace ngs {
 
 bool DistortionModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_DISTORTION_PARAMS_STRUCT_ID) {
-            LOG_WARN_ONCE("Game is using unimplemented distortion audio module");
-        }
-    }
+    VoiceProduct &product = data.parent->products[0];
+    if (data.is_bypassed || !product.data)
+        return false;
+
+    const SceNgsDistortionParams *params = data.get_parameters<SceNgsDistortionParams>(mem);
+    if (params->desc.id != SCE_NGS_DISTORTION_PARAMS_STRUCT_ID)
+        return false;
+
+    // The exact curve of the hardware is unknown, fA drives a soft saturator that fB shapes
+    const dsp::DistortionParams distortion{ params->fA, params->fB, params->fClip, params->fGate, params->fWetGain, params->fDryGain };
+
+    float *output = data.get_output_buffer();
+    dsp::distort(distortion, reinterpret_cast<const float *>(product.data), output, data.parent->rack->system->granularity);
+    product.data = reinterpret_cast<uint8_t *>(output);
 
     return false;
 }
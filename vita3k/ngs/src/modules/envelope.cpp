@@ -16,18 +16,44 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/envelope.h>
-#include <util/log.h>
 
 namespace ngs {
 
 bool EnvelopeModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_ENVELOPE_PARAMS_STRUCT_ID) {
-            LOG_WARN_ONCE("Game is using unimplemented envelope audio module");
-        }
+    VoiceProduct &product = data.parent->products[0];
+    if (data.is_bypassed || !product.data)
+        return false;
+
+    const SceNgsEnvelopeParams *params = data.get_parameters<SceNgsEnvelopeParams>(mem);
+    if (params->desc.id != SCE_NGS_ENVELOPE_PARAMS_STRUCT_ID)
+        return false;
+
+    dsp::EnvelopeParams envelope;
+    for (uint32_t i = 0; i < SCE_NGS_ENVELOPE_MAX_POINTS; i++) {
+        const SceNgsEnvelopePoint &point = params->envelopePoints[i];
+        envelope.points[i] = { point.uMsecsToNextPoint, point.fAmplitude,
+            (point.eCurveType == SCE_NGS_ENVELOPE_CURVED) ? dsp::EnvelopeCurve::Curved : dsp::EnvelopeCurve::Linear };
     }
+    envelope.count = params->uNumPoints;
+    envelope.release = params->uReleaseMsecs;
+    envelope.loop_start = params->uLoopStart;
+    envelope.loop_end = params->nLoopEnd;
+
+    // Key off starts the release, the voice ends once it has faded out
+    const bool key_off = data.parent->state == VOICE_STATE_FINALIZING;
+    dsp::Envelope *processor = data.get_processor<dsp::Envelope>();
+    float *output = data.get_output_buffer();
+    const bool finished = processor->process(envelope, static_cast<float>(data.parent->rack->system->sample_rate), key_off,
+        reinterpret_cast<const float *>(product.data), output, data.parent->rack->system->granularity);
+    product.data = reinterpret_cast<uint8_t *>(output);
+
+    SceNgsEnvelopeStates *state = data.get_state<SceNgsEnvelopeStates>();
+    state->fCurrentHeight = processor->height;
+    state->fPosition = processor->position;
+    state->fReleaseScale = processor->release_scale;
+    state->nCurrentPoint = static_cast<SceInt32>(processor->point);
+    state->nReleasing = processor->releasing;
 
-    return false;
+    return finished;
 }
 } // namespace ngs
@@ -16,22 +16,90 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/equalizer.h>
-#include <util/log.h>
+
+#include <algorithm>
 
 namespace ngs {
 
+struct EqualizerProcessor : public dsp::ProcessorState {
+    dsp::BiquadHistory history[SCE_NGS_MAX_EQ_FILTERS];
+};
+
 bool EqualizerModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_PARAM_EQ_COEFF_STRUCT_ID || desc->id == SCE_NGS_PARAM_EQ_STRUCT_ID) {
-            LOG_WARN_ONCE("Game is using unimplemented equalizer audio module");
+    // Definitions with equalizers can have up to 4 outputs. Those with a single equalizer share its
+    // result between them, the others have a voice equalizer followed by one equalizer per output
+    // that all start from the same signal.
+    uint32_t position = 0;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < data.parent->rack->modules.size(); i++) {
+        if (data.parent->rack->modules[i]->module_id() == module_id()) {
+            if (i < data.index)
+                position++;
+            total++;
+        }
+    }
+
+    const uint32_t output_index = (position == 0) ? 0 : position - 1;
+    if (position == 1) {
+        data.parent->products[1] = data.parent->products[0];
+        data.parent->products[2] = data.parent->products[0];
+        data.parent->products[3] = data.parent->products[0];
+    }
+
+    const auto share_output = [&]() {
+        if (total == 1) {
+            data.parent->products[1] = data.parent->products[0];
+            data.parent->products[2] = data.parent->products[0];
+            data.parent->products[3] = data.parent->products[0];
+        }
+    };
+
+    VoiceProduct &product = data.parent->products[std::min<uint32_t>(output_index, MAX_VOICE_OUTPUT - 1)];
+    if (data.is_bypassed || !product.data) {
+        share_output();
+        return false;
+    }
+
+    dsp::BiquadCoefficients coeffs[SCE_NGS_MAX_EQ_FILTERS];
+    bool active[SCE_NGS_MAX_EQ_FILTERS] = {};
+    const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
+    if (desc->id == SCE_NGS_PARAM_EQ_STRUCT_ID) {
+        const SceNgsParamEqParams *params = data.get_parameters<SceNgsParamEqParams>(mem);
+        const float sample_rate = static_cast<float>(data.parent->rack->system->sample_rate);
+        for (int i = 0; i < SCE_NGS_MAX_EQ_FILTERS; i++) {
+            const SceNgsParamFilter &filter = params->filter[i];
+            active[i] = filter.eFilterMode != SCE_NGS_FILTER_MODE_OFF && filter.eFilterMode <= SCE_NGS_FILTER_LOWPASS_RESONANT_NORMALIZED;
+            if (active[i])
+                coeffs[i] = dsp::make_biquad(static_cast<dsp::FilterType>(filter.eFilterMode), filter.fFrequency, filter.fResonance, filter.fGain, sample_rate);
+        }
+    } else if (desc->id == SCE_NGS_PARAM_EQ_COEFF_STRUCT_ID) {
+        const SceNgsParamEqParamsCoEff *params = data.get_parameters<SceNgsParamEqParamsCoEff>(mem);
+        for (int i = 0; i < SCE_NGS_MAX_EQ_FILTERS; i++) {
+            const SceNgsParamCoEff &filter = params->filterCoEff[i];
+            coeffs[i] = { filter.fB0, filter.fB1, filter.fB2, filter.fA1, filter.fA2 };
+            active[i] = true;
         }
     }
 
-    // Definitions with equalizers can have up to 4 outputs
-    data.parent->products[1] = data.parent->products[0];
-    data.parent->products[2] = data.parent->products[0];
-    data.parent->products[3] = data.parent->products[0];
+    if (std::none_of(std::begin(active), std::end(active), [](bool a) { return a; })) {
+        share_output();
+        return false;
+    }
+
+    EqualizerProcessor *processor = data.get_processor<EqualizerProcessor>();
+    const int32_t granularity = data.parent->rack->system->granularity;
+    float *output = data.get_output_buffer();
+    const float *input = reinterpret_cast<const float *>(product.data);
+    for (int i = 0; i < SCE_NGS_MAX_EQ_FILTERS; i++) {
+        if (!active[i])
+            continue;
+
+        // the first band reads the input, the others refine the output in place
+        dsp::biquad_chain(&coeffs[i], &processor->history[i], 1, input, output, granularity);
+        input = output;
+    }
+    product.data = reinterpret_cast<uint8_t *>(output);
+    share_output();
 
     return false;
 }
@@ -16,20 +16,49 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/filter.h>
-#include <util/log.h>
 
 namespace ngs {
 
+struct FilterProcessor : public dsp::ProcessorState {
+    dsp::BiquadHistory history;
+};
+
 bool FilterModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_FILTER_PARAMS_COEFF_STRUCT_ID || desc->id == SCE_NGS_FILTER_PARAMS_STRUCT_ID) {
-            LOG_WARN_ONCE("Game is using unimplemented filter audio module");
-        }
+    // Definitions with filters have 2 outputs, one send filter each. The first one also hands the
+    // unfiltered signal over to the second one.
+    uint32_t send = 0;
+    for (uint32_t i = 0; i < data.index; i++) {
+        if (data.parent->rack->modules[i]->module_id() == module_id())
+            send++;
+    }
+
+    if (send == 0)
+        data.parent->products[1] = data.parent->products[0];
+
+    VoiceProduct &product = data.parent->products[std::min<uint32_t>(send, 1)];
+    if (data.is_bypassed || !product.data)
+        return false;
+
+    dsp::BiquadCoefficients coeffs;
+    const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
+    if (desc->id == SCE_NGS_FILTER_PARAMS_STRUCT_ID) {
+        const SceNgsParamFilter &filter = data.get_parameters<SceNgsFilterParams>(mem)->params;
+        if (filter.eFilterMode == SCE_NGS_FILTER_MODE_OFF || filter.eFilterMode > SCE_NGS_FILTER_LOWPASS_RESONANT_NORMALIZED)
+            return false;
+
+        coeffs = dsp::make_biquad(static_cast<dsp::FilterType>(filter.eFilterMode), filter.fFrequency, filter.fResonance, filter.fGain,
+            static_cast<float>(data.parent->rack->system->sample_rate));
+    } else if (desc->id == SCE_NGS_FILTER_PARAMS_COEFF_STRUCT_ID) {
+        const SceNgsParamCoEff &filter = data.get_parameters<SceNgsFilterParamsCoEff>(mem)->params;
+        coeffs = { filter.fB0, filter.fB1, filter.fB2, filter.fA1, filter.fA2 };
+    } else {
+        return false;
     }
 
-    // Definitions with filters have 2 outputs
-    data.parent->products[1] = data.parent->products[0];
+    FilterProcessor *processor = data.get_processor<FilterProcessor>();
+    float *output = data.get_output_buffer();
+    dsp::biquad_chain(&coeffs, &processor->history, 1, reinterpret_cast<const float *>(product.data), output, data.parent->rack->system->granularity);
+    product.data = reinterpret_cast<uint8_t *>(output);
 
     return false;
 }
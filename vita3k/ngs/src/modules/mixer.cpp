@@ -27,12 +27,21 @@ bool InputMixerModule::process(KernelState &kern, const MemState &mem, const Sce
 }
 
 bool MixerModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_MIXER_PARAMS_STRUCT_ID) {
-            LOG_WARN_ONCE("Game is using unimplemented mixer audio module");
-        }
-    }
+    VoiceProduct &product = data.parent->products[0];
+    if (data.is_bypassed || !product.data)
+        return false;
+
+    const SceNgsMixerParams *params = data.get_parameters<SceNgsMixerParams>(mem);
+    if (params->desc.id != SCE_NGS_MIXER_PARAMS_STRUCT_ID)
+        return false;
+
+    // Only the voice signal reaches the mixer, the generator on the second port is not implemented
+    if (params->fGainIn[1] != 0.0f)
+        LOG_WARN_ONCE("Game is using the unimplemented second input of the mixer audio module");
+
+    float *output = data.get_output_buffer();
+    dsp::apply_gain(reinterpret_cast<const float *>(product.data), output, data.parent->rack->system->granularity, params->fGainIn[0]);
+    product.data = reinterpret_cast<uint8_t *>(output);
 
     return false;
 }
@@ -16,17 +16,22 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/pitchshift.h>
-#include <util/log.h>
 
 namespace ngs {
 
 bool PitchShiftModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_PITCHSHIFT_PARAMS_STRUCT_ID) {
-            LOG_WARN_ONCE("Game is using unimplemented pitchshift audio module");
-        }
-    }
+    VoiceProduct &product = data.parent->products[0];
+    if (data.is_bypassed || !product.data)
+        return false;
+
+    const SceNgsPitchShiftParams *params = data.get_parameters<SceNgsPitchShiftParams>(mem);
+    if (params->desc.id != SCE_NGS_PITCHSHIFT_PARAMS_STRUCT_ID)
+        return false;
+
+    float *output = data.get_output_buffer();
+    data.get_processor<dsp::PitchShifter>()->process(params->fPitchOffsetInCents, static_cast<float>(data.parent->rack->system->sample_rate),
+        reinterpret_cast<const float *>(product.data), output, data.parent->rack->system->granularity);
+    product.data = reinterpret_cast<uint8_t *>(output);
 
     return false;
 }
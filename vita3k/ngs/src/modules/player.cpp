@@ -94,6 +94,7 @@ bool PlayerModule::process(KernelState &kern, const MemState &mem, const SceUID
         params->channels = 2;
 
     // If decoder hasn't been initialized
+    std::unique_ptr<PCMDecoderState> &decoder = data.get_processor<PlayerDecoder>()->decoder;
     if (!decoder) {
         // Create decoder specifying the desired destination sample rate
         decoder = std::make_unique<PCMDecoderState>(static_cast<float>(sample_rate));
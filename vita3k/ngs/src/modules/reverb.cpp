@@ -16,17 +16,45 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/reverb.h>
-#include <util/log.h>
+
+#include <cstddef>
 
 namespace ngs {
 
 bool ReverbModule::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        const SceNgsParamsDescriptor *desc = data.get_parameters<SceNgsParamsDescriptor>(mem);
-        if (desc->id == SCE_NGS_REVERB_PARAMS_STRUCT_ID) {
-            LOG_WARN_ONCE("Game is using unimplemented reverb audio module");
-        }
-    }
+    VoiceProduct &product = data.parent->products[0];
+    if (data.is_bypassed || !product.data)
+        return false;
+
+    const SceNgsReverbParams *params = data.get_parameters<SceNgsReverbParams>(mem);
+    if (params->desc.id != SCE_NGS_REVERB_PARAMS_STRUCT_ID && params->desc.id != SCE_NGS_REVERB_PARAMS_STRUCT_ID_V2)
+        return false;
+
+    dsp::ReverbParams reverb;
+    reverb.room = params->fRoom;
+    reverb.room_hf = params->fRoomHF;
+    reverb.decay_time = params->fDecayTime;
+    reverb.decay_hf_ratio = params->fDecayHFRatio;
+    reverb.reflections = params->fReflections;
+    reverb.reflections_delay = params->fReflectionsDelay;
+    reverb.reverb = params->fReverb;
+    reverb.reverb_delay = params->fReverbDelay;
+    reverb.diffusion = params->fDiffusion;
+    reverb.density = params->fDensity;
+    reverb.hf_reference = params->fHFReference;
+    reverb.pattern[0] = params->eEarlyReflectionPattern[0];
+    reverb.pattern[1] = params->eEarlyReflectionPattern[1];
+    reverb.early_reflection_scalar = params->fEarlyReflectionScalar;
+
+    // Older parameter blocks end before the dry level, the reverb buss is then a pure send effect.
+    // The low frequency controls are not modelled.
+    const bool has_dry = params->desc.size >= offsetof(SceNgsReverbParams, fDryMB) + sizeof(params->fDryMB);
+    reverb.dry = has_dry ? params->fDryMB : -10000.0f;
+
+    float *output = data.get_output_buffer();
+    data.get_processor<dsp::Reverb>()->process(reverb, static_cast<float>(data.parent->rack->system->sample_rate),
+        reinterpret_cast<const float *>(product.data), output, data.parent->rack->system->granularity);
+    product.data = reinterpret_cast<uint8_t *>(output);
 
     return false;
 }
@@ -149,6 +149,14 @@ void ModuleData::fill_to_fit_granularity() {
     }
 }
 
+float *ModuleData::get_output_buffer() {
+    const size_t size = parent->rack->system->granularity * 2 * sizeof(float);
+    if (extra_storage.size() < size)
+        extra_storage.resize(size);
+
+    return reinterpret_cast<float *>(extra_storage.data());
+}
+
 void Voice::init(Rack *mama) {
     rack = mama;
     state = VoiceState::VOICE_STATE_AVAILABLE;
@@ -245,6 +253,10 @@ void Voice::transition(const MemState &mem, const VoiceState new_state) {
     state = new_state;
 
     for (size_t i = 0; i < datas.size(); i++) {
+        // A new note starts from silent filters and empty delay lines
+        if (old == VOICE_STATE_AVAILABLE && new_state == VOICE_STATE_ACTIVE)
+            datas[i].processor.reset();
+
         rack->modules[i]->on_state_change(mem, datas[i], old);
     }
 }
@@ -22,14 +22,32 @@
 
 #include <algorithm>
 #include <cstring>
+#include <tuple>
 #include <util/vector_utils.h>
 
 namespace ngs {
 
+VoiceScheduler::VoiceScheduler()
+    : worker_count(WorkerPool::default_size()) {
+}
+
+void VoiceScheduler::set_worker_count(const uint32_t count) {
+    const std::lock_guard<std::recursive_mutex> guard(mutex);
+
+    worker_count = count;
+    // started again by the next update
+    workers.stop();
+}
+
 bool VoiceScheduler::deque_voice(Voice *voice) {
     const std::lock_guard<std::recursive_mutex> guard(mutex);
 
-    return vector_utils::erase_first(queue, voice);
+    if (!vector_utils::erase_first(queue, voice))
+        return false;
+
+    // the other voices keep their order, so the graph stays usable until the next update
+    graph_dirty = true;
+    return true;
 }
 
 void VoiceScheduler::deque_insert(const MemState &mem, Voice *voice) {
@@ -55,6 +73,7 @@ void VoiceScheduler::deque_insert(const MemState &mem, Voice *voice) {
     }
 
     queue.insert(queue.begin() + lowest_dest_pos, voice);
+    invalidate_graph();
 }
 
 bool VoiceScheduler::play(const MemState &mem, Voice *voice) {
@@ -117,10 +136,139 @@ bool VoiceScheduler::off(const MemState &mem, Voice *voice) {
     return true;
 }
 
+void VoiceScheduler::process_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, const std::vector<Voice *> &queue_copy,
+    Voice *voice, std::unique_lock<std::recursive_mutex> &scheduler_lock) {
+    // Modify the state, in peace....
+    std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
+    memset(voice->products, 0, sizeof(voice->products));
+
+    bool finished = false;
+    uint32_t finished_module = 0;
+
+    for (size_t i = 0; i < voice->rack->modules.size(); i++) {
+        if (voice->rack->modules[i]) {
+            if (voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], scheduler_lock, voice_lock)) {
+                finished = true;
+                finished_module = voice->rack->modules[i]->module_id();
+            }
+        }
+    }
+    if (finished) {
+        voice->is_keyed_off = true;
+        voice->transition(mem, VOICE_STATE_FINALIZING);
+        if (voice->finished_callback) {
+            voice_lock.unlock();
+            scheduler_lock.unlock();
+            voice->invoke_callback(kern, mem, thread_id, voice->finished_callback, voice->finished_callback_user_data, finished_module);
+            scheduler_lock.lock();
+            voice_lock.lock();
+        }
+        voice->is_keyed_off = false;
+
+        stop(mem, voice);
+    }
+
+    for (size_t i = 0; i < voice->rack->vdef->output_count; i++) {
+        if (voice->products[i].data)
+            deliver_data(mem, queue_copy, voice, static_cast<uint8_t>(i), voice->products[i]);
+    }
+
+    voice->frame_count++;
+}
+
+void VoiceScheduler::process_segment(KernelState &kern, const MemState &mem, const SceUID thread_id, const std::vector<Voice *> &queue_copy,
+    const size_t begin, const size_t end) {
+    // Voices of the same level have no patch between them
+    for (std::vector<Voice *> &level : levels)
+        level.clear();
+    for (size_t i = begin; i < end; i++) {
+        Voice *voice = queue_copy[i];
+        if (voice->level >= levels.size())
+            levels.resize(voice->level + 1);
+        levels[voice->level].push_back(voice);
+    }
+
+    finished.assign(end - begin, 0);
+
+    const int32_t first = static_cast<int32_t>(begin);
+    for (const std::vector<Voice *> &level : levels) {
+        if (level.empty())
+            continue;
+
+        workers.run(static_cast<uint32_t>(level.size()), [&](const uint32_t index) {
+            Voice *voice = level[index];
+
+            // The modules are given the scheduler lock, which stays with the updating thread
+            std::recursive_mutex worker_mutex;
+            std::unique_lock<std::recursive_mutex> worker_lock(worker_mutex);
+            std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
+
+            // Take the products of the voices processed before this one in the segment, in delivery order.
+            // The voices before the segment already delivered theirs.
+            for (Patch *patch : voice->incoming) {
+                const Voice *source = patch->source;
+                if (patch->output_sub_index == -1 || patch->dest != voice || !is_in_graph(source)
+                    || source->order < first || source->order >= voice->order)
+                    continue;
+
+                if (static_cast<uint32_t>(patch->output_index) < source->rack->vdef->output_count && source->products[patch->output_index].data)
+                    voice->inputs.receive(patch, source->products[patch->output_index]);
+            }
+
+            memset(voice->products, 0, sizeof(voice->products));
+
+            bool voice_finished = false;
+            for (size_t i = 0; i < voice->rack->modules.size(); i++) {
+                if (voice->rack->modules[i] && voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], worker_lock, voice_lock))
+                    voice_finished = true;
+            }
+
+            if (voice_finished) {
+                // Same as stop, the voice is removed from the queue once the segment is done
+                voice->is_keyed_off = true;
+                voice->transition(mem, VOICE_STATE_FINALIZING);
+                voice->is_keyed_off = false;
+                voice->transition(mem, VOICE_STATE_AVAILABLE);
+                finished[voice->order - first] = !voice->is_paused;
+            }
+
+            voice->frame_count++;
+        });
+    }
+
+    // Deliver to the voices after the segment and drop the finished voices, in queue order
+    for (size_t i = begin; i < end; i++) {
+        Voice *voice = queue_copy[i];
+
+        for (size_t port = 0; port < voice->rack->vdef->output_count; port++) {
+            if (!voice->products[port].data)
+                continue;
+
+            for (const auto &patch_ptr : voice->patches[port]) {
+                Patch *patch = patch_ptr.get(mem);
+                if (!patch || patch->output_sub_index == -1 || !is_in_graph(patch->dest) || patch->dest->order < static_cast<int32_t>(end))
+                    continue;
+
+                const std::lock_guard<std::mutex> guard(*patch->dest->voice_mutex);
+                patch->dest->inputs.receive(patch, voice->products[port]);
+            }
+        }
+
+        if (finished[i - begin])
+            deque_voice(voice);
+    }
+}
+
 void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID thread_id) {
     std::unique_lock<std::recursive_mutex> scheduler_lock(mutex);
     is_updating = true;
 
+    if (graph_dirty)
+        rebuild_graph(mem);
+
+    if (workers.size() != worker_count)
+        workers.start(worker_count);
+
     // make a copy of the queue, this way we have no issue if it is modified in a callback
     std::vector<ngs::Voice *> queue_copy = queue;
 
@@ -129,43 +277,26 @@ void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID
         voice->inputs.reset_inputs();
     }
 
-    for (ngs::Voice *voice : queue_copy) {
-        // Modify the state, in peace....
-        std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
-        memset(voice->products, 0, sizeof(voice->products));
-
-        bool finished = false;
-        uint32_t finished_module = 0;
-
-        for (size_t i = 0; i < voice->rack->modules.size(); i++) {
-            if (voice->rack->modules[i]) {
-                if (voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], scheduler_lock, voice_lock)) {
-                    finished = true;
-                    finished_module = voice->rack->modules[i]->module_id();
-                }
-            }
-        }
-        if (finished) {
-            voice->is_keyed_off = true;
-            voice->transition(mem, VOICE_STATE_FINALIZING);
-            if (voice->finished_callback) {
-                voice_lock.unlock();
-                scheduler_lock.unlock();
-                voice->invoke_callback(kern, mem, thread_id, voice->finished_callback, voice->finished_callback_user_data, finished_module);
-                scheduler_lock.lock();
-                voice_lock.lock();
-            }
-            voice->is_keyed_off = false;
-
-            stop(mem, voice);
+    // Voices which may run guest code are processed one at a time on this thread, in queue order.
+    // The segments of voices between them are spread on the workers level by level. Each voice mixes
+    // its inputs in the same order in both cases, so the output does not depend on the worker count.
+    const uint32_t generation = graph_generation;
+    size_t begin = 0;
+    while (begin < queue_copy.size()) {
+        size_t end = begin;
+        // a callback changing the routing leaves the graph out of date until the next update
+        if (workers.size() > 0 && graph_generation == generation) {
+            while (end < queue_copy.size() && can_process_concurrently(queue_copy[end]))
+                end++;
         }
 
-        for (size_t i = 0; i < voice->rack->vdef->output_count; i++) {
-            if (voice->products[i].data)
-                deliver_data(mem, queue_copy, voice, static_cast<uint8_t>(i), voice->products[i]);
+        if (end - begin > 1) {
+            process_segment(kern, mem, thread_id, queue_copy, begin, end);
+            begin = end;
+        } else {
+            process_voice(kern, mem, thread_id, queue_copy, queue_copy[begin], scheduler_lock);
+            begin++;
         }
-
-        voice->frame_count++;
     }
 
     while (!operations_pending.empty()) {
@@ -219,6 +350,7 @@ bool VoiceScheduler::resort_to_respect_dependencies(const MemState &mem, Voice *
             if (dest_pos < position) {
                 // Switch to the end. Resort dependencies for this one that just got sorted too.
                 std::rotate(queue.begin() + dest_pos, queue.begin() + dest_pos + 1, queue.end());
+                invalidate_graph();
                 resort_to_respect_dependencies(mem, dest);
                 position = get_position(source);
             }
@@ -240,6 +372,9 @@ Ptr<Patch> VoiceScheduler::patch(const MemState &mem, SceNgsPatchSetupInfo *info
         return patch;
     }
 
+    // the graph of a running update can't know about this patch
+    graph_generation++;
+
     const int32_t source_pos = get_position(source);
     const int32_t dest_pos = get_position(dest);
 
@@ -249,6 +384,92 @@ Ptr<Patch> VoiceScheduler::patch(const MemState &mem, SceNgsPatchSetupInfo *info
     }
 
     resort_to_respect_dependencies(mem, source);
+    add_to_graph(mem, patch.get(mem));
     return patch;
 }
+
+void VoiceScheduler::invalidate_graph() {
+    graph_dirty = true;
+    graph_generation++;
+}
+
+bool VoiceScheduler::is_in_graph(const Voice *voice) const {
+    return voice->graph_id == graph_id;
+}
+
+void VoiceScheduler::rebuild_graph(const MemState &mem) {
+    graph_id++;
+    for (size_t i = 0; i < queue.size(); i++) {
+        Voice *voice = queue[i];
+        voice->incoming.clear();
+        voice->level = 0;
+        voice->order = static_cast<int32_t>(i);
+        voice->graph_id = graph_id;
+    }
+
+    // Going through the sources in queue order gives the final level of a source before its patches
+    // are followed, and adds the incoming patches in delivery order
+    for (Voice *source : queue) {
+        for (const auto &patches : source->patches) {
+            for (const auto &patch_ptr : patches) {
+                Patch *patch = patch_ptr.get(mem);
+                if (!patch || patch->output_sub_index == -1 || !is_in_graph(patch->dest))
+                    continue;
+
+                Voice *dest = patch->dest;
+                dest->incoming.push_back(patch);
+                if (dest->order > source->order)
+                    dest->level = std::max(dest->level, source->level + 1);
+            }
+        }
+    }
+
+    graph_dirty = false;
+}
+
+void VoiceScheduler::add_to_graph(const MemState &mem, Patch *patch) {
+    if (graph_dirty || !is_in_graph(patch->source) || !is_in_graph(patch->dest))
+        return;
+
+    std::vector<Patch *> &incoming = patch->dest->incoming;
+    if (vector_utils::contains(incoming, patch))
+        return;
+
+    // Removed patches are left in the graph and skipped when delivering, so levels only grow until the next rebuild
+    const auto delivered_before = [](const Patch *lhs, const Patch *rhs) {
+        return std::make_tuple(lhs->source->order, lhs->output_index, lhs->output_sub_index)
+            < std::make_tuple(rhs->source->order, rhs->output_index, rhs->output_sub_index);
+    };
+    incoming.insert(std::upper_bound(incoming.begin(), incoming.end(), patch, delivered_before), patch);
+
+    if (patch->dest->order > patch->source->order)
+        raise_level(mem, patch->dest, patch->source->level + 1);
+}
+
+void VoiceScheduler::raise_level(const MemState &mem, Voice *voice, const uint32_t level) {
+    if (voice->level >= level)
+        return;
+
+    voice->level = level;
+    for (const auto &patches : voice->patches) {
+        for (const auto &patch_ptr : patches) {
+            Patch *patch = patch_ptr.get(mem);
+            if (patch && patch->output_sub_index != -1 && is_in_graph(patch->dest) && patch->dest->order > voice->order)
+                raise_level(mem, patch->dest, level + 1);
+        }
+    }
+}
+
+bool VoiceScheduler::can_process_concurrently(const Voice *voice) const {
+    // guest callbacks have to run on the updating thread
+    if (voice->finished_callback)
+        return false;
+
+    for (size_t i = 0; i < voice->rack->modules.size(); i++) {
+        if (voice->datas[i].callback || voice->rack->modules[i]->has_shared_state())
+            return false;
+    }
+
+    return true;
+}
 } // namespace ngs
@@ -0,0 +1,451 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+using namespace ngs::dsp;
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr float SAMPLE_RATE = 48000.0f;
+constexpr int GRANULARITY = 512;
+
+std::vector<float> random_signal(const int frames, const uint32_t seed = 1) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> signal(frames * CHANNELS);
+    for (auto &sample : signal)
+        sample = dist(gen);
+    return signal;
+}
+
+std::vector<float> sine(const int frames, const float frequency, const float amplitude = 1.0f) {
+    std::vector<float> signal(frames * CHANNELS);
+    for (int i = 0; i < frames; i++)
+        signal[i * CHANNELS] = signal[i * CHANNELS + 1] = amplitude * std::sin(2.0 * PI * frequency * i / SAMPLE_RATE);
+    return signal;
+}
+
+// Feed a long signal through a processor one granule at a time, like the voice scheduler does
+template <typename F>
+std::vector<float> run_granules(const std::vector<float> &input, const int granularity, F process) {
+    std::vector<float> output(input.size());
+    const int frames = static_cast<int>(input.size()) / CHANNELS;
+    for (int start = 0; start < frames; start += granularity) {
+        const int count = std::min(granularity, frames - start);
+        process(input.data() + start * CHANNELS, output.data() + start * CHANNELS, count);
+    }
+    return output;
+}
+
+double magnitude_at(const BiquadCoefficients &c, const double frequency) {
+    const std::complex<double> z = std::polar(1.0, -2.0 * PI * frequency / SAMPLE_RATE);
+    const std::complex<double> num = static_cast<double>(c.b0) + static_cast<double>(c.b1) * z + static_cast<double>(c.b2) * z * z;
+    const std::complex<double> den = 1.0 + static_cast<double>(c.a1) * z + static_cast<double>(c.a2) * z * z;
+    return std::abs(num / den);
+}
+
+double rms(const std::vector<float> &signal, const int first_frame, const int last_frame, const int channel = 0) {
+    double sum = 0.0;
+    for (int i = first_frame; i < last_frame; i++)
+        sum += signal[i * CHANNELS + channel] * signal[i * CHANNELS + channel];
+    return std::sqrt(sum / (last_frame - first_frame));
+}
+
+} // namespace
+
+TEST(ngs_dsp, gain_matches_scalar) {
+    const std::vector<float> input = random_signal(GRANULARITY + 1);
+    std::vector<float> output(input.size());
+    apply_gain(input.data(), output.data(), GRANULARITY + 1, 0.37f);
+
+    for (size_t i = 0; i < input.size(); i++)
+        ASSERT_FLOAT_EQ(output[i], input[i] * 0.37f);
+}
+
+TEST(ngs_dsp, gain_curve_matches_scalar) {
+    const int frames = GRANULARITY + 1;
+    const std::vector<float> input = random_signal(frames);
+    std::vector<float> gains(frames);
+    for (int i = 0; i < frames; i++)
+        gains[i] = static_cast<float>(i) / frames;
+
+    std::vector<float> output(input.size());
+    apply_gain_curve(input.data(), output.data(), gains.data(), frames);
+
+    for (int i = 0; i < frames; i++) {
+        ASSERT_FLOAT_EQ(output[i * CHANNELS], input[i * CHANNELS] * gains[i]);
+        ASSERT_FLOAT_EQ(output[i * CHANNELS + 1], input[i * CHANNELS + 1] * gains[i]);
+    }
+}
+
+TEST(ngs_dsp, biquad_designs_have_expected_response) {
+    const BiquadCoefficients lowpass = make_biquad(FilterType::LowPass, 1000.0f, 0.7071f, 0.0f, SAMPLE_RATE);
+    EXPECT_NEAR(magnitude_at(lowpass, 0.0), 1.0, 1e-4);
+    EXPECT_NEAR(magnitude_at(lowpass, 1000.0), std::sqrt(0.5), 1e-3);
+    EXPECT_LT(magnitude_at(lowpass, 20000.0), 0.01);
+
+    const BiquadCoefficients highpass = make_biquad(FilterType::HighPass, 1000.0f, 0.7071f, 0.0f, SAMPLE_RATE);
+    EXPECT_LT(magnitude_at(highpass, 20.0), 0.01);
+    EXPECT_NEAR(magnitude_at(highpass, 23990.0), 1.0, 1e-3);
+
+    const BiquadCoefficients peak = make_biquad(FilterType::Peak, 2000.0f, 2.0f, 6.0f, SAMPLE_RATE);
+    EXPECT_NEAR(20.0 * std::log10(magnitude_at(peak, 2000.0)), 6.0, 1e-2);
+    EXPECT_NEAR(magnitude_at(peak, 20.0), 1.0, 1e-2);
+
+    const BiquadCoefficients shelf = make_biquad(FilterType::LowShelf, 200.0f, 0.7071f, -12.0f, SAMPLE_RATE);
+    EXPECT_NEAR(20.0 * std::log10(magnitude_at(shelf, 5.0)), -12.0, 0.1);
+    EXPECT_NEAR(magnitude_at(shelf, 10000.0), 1.0, 1e-2);
+
+    const BiquadCoefficients notch = make_biquad(FilterType::Notch, 3000.0f, 1.0f, 0.0f, SAMPLE_RATE);
+    EXPECT_LT(magnitude_at(notch, 3000.0), 1e-3);
+
+    const BiquadCoefficients allpass = make_biquad(FilterType::AllPass, 3000.0f, 1.0f, 0.0f, SAMPLE_RATE);
+    EXPECT_NEAR(magnitude_at(allpass, 500.0), 1.0, 1e-4);
+    EXPECT_NEAR(magnitude_at(allpass, 9000.0), 1.0, 1e-4);
+
+    const BiquadCoefficients normalized = make_biquad(FilterType::LowPassNormalized, 1000.0f, 8.0f, 0.0f, SAMPLE_RATE);
+    EXPECT_LT(magnitude_at(normalized, 1000.0), 1.05);
+}
+
+TEST(ngs_dsp, biquad_chain_matches_reference) {
+    const BiquadCoefficients coeffs[5] = {
+        make_biquad(FilterType::LowPass, 4000.0f, 2.0f, 0.0f, SAMPLE_RATE),
+        make_biquad(FilterType::Peak, 800.0f, 1.0f, -6.0f, SAMPLE_RATE),
+        make_biquad(FilterType::HighShelf, 8000.0f, 0.7071f, 3.0f, SAMPLE_RATE),
+        make_biquad(FilterType::Notch, 2000.0f, 4.0f, 0.0f, SAMPLE_RATE),
+        make_biquad(FilterType::HighPassOnePole, 100.0f, 0.0f, 0.0f, SAMPLE_RATE),
+    };
+
+    const int frames = GRANULARITY * 4 + 3;
+    const std::vector<float> input = random_signal(frames);
+
+    // every chain length takes a different path, tiny granules start and end inside the pipeline
+    for (int count = 1; count <= 5; count++) {
+        std::vector<double> reference(input.begin(), input.end());
+        for (int stage = 0; stage < count; stage++) {
+            const BiquadCoefficients &c = coeffs[stage];
+            for (int ch = 0; ch < CHANNELS; ch++) {
+                // direct form I in double precision
+                double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+                for (int i = 0; i < frames; i++) {
+                    const double x = reference[i * CHANNELS + ch];
+                    const double y = c.b0 * x + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2;
+                    x2 = x1;
+                    x1 = x;
+                    y2 = y1;
+                    y1 = y;
+                    reference[i * CHANNELS + ch] = y;
+                }
+            }
+        }
+
+        for (const int granularity : { 300, 2, 1 }) {
+            BiquadHistory history[5];
+            const std::vector<float> output = run_granules(input, granularity, [&](const float *src, float *dest, int n) {
+                biquad_chain(coeffs, history, count, src, dest, n);
+            });
+
+            for (size_t i = 0; i < output.size(); i++)
+                ASSERT_NEAR(output[i], reference[i], 1e-4) << count << " stages, granularity " << granularity << ", sample " << i;
+        }
+    }
+}
+
+TEST(ngs_dsp, biquad_chain_in_place) {
+    const BiquadCoefficients coeffs[4] = {
+        make_biquad(FilterType::BandPassZero, 1000.0f, 1.0f, 0.0f, SAMPLE_RATE),
+        make_biquad(FilterType::LowShelf, 300.0f, 0.7071f, 6.0f, SAMPLE_RATE),
+        make_biquad(FilterType::AllPass, 5000.0f, 0.5f, 0.0f, SAMPLE_RATE),
+        make_biquad(FilterType::LowPassNormalized, 9000.0f, 3.0f, 0.0f, SAMPLE_RATE),
+    };
+
+    for (const int count : { 1, 4 }) {
+        BiquadHistory history_a[4], history_b[4];
+        const std::vector<float> input = random_signal(GRANULARITY);
+        std::vector<float> out_of_place(input.size());
+        std::vector<float> in_place = input;
+        biquad_chain(coeffs, history_a, count, input.data(), out_of_place.data(), GRANULARITY);
+        biquad_chain(coeffs, history_b, count, in_place.data(), in_place.data(), GRANULARITY);
+
+        EXPECT_EQ(out_of_place, in_place);
+    }
+}
+
+TEST(ngs_dsp, distortion_matches_scalar) {
+    const DistortionParams params{ 3.0f, 2.0f, 0.8f, 0.05f, 0.75f, 0.25f };
+    const int frames = GRANULARITY + 1;
+    const std::vector<float> input = random_signal(frames);
+    std::vector<float> output(input.size());
+    distort(params, input.data(), output.data(), frames);
+
+    for (size_t i = 0; i < input.size(); i++) {
+        const float x = input[i];
+        float shaped = std::clamp(params.drive * x / (1.0f + params.shape * std::abs(x)), -params.clip, params.clip);
+        if (std::abs(x) < params.gate)
+            shaped = 0.0f;
+        ASSERT_NEAR(output[i], params.wet * shaped + params.dry * x, 1e-6);
+    }
+}
+
+TEST(ngs_dsp, compressor_steady_state_gain) {
+    CompressorParams params{};
+    params.ratio = 4.0f;
+    params.threshold = -20.0f;
+    params.attack = 1.0f;
+    params.release = 50.0f;
+    params.peak_mode = true;
+
+    // 0 dB is 20 dB over the threshold, a 4:1 ratio takes 15 dB off
+    const std::vector<float> input(GRANULARITY * 20 * CHANNELS, 1.0f);
+    Compressor compressor;
+    const std::vector<float> output = run_granules(input, GRANULARITY, [&](const float *src, float *dest, int count) {
+        compressor.process(params, SAMPLE_RATE, src, dest, count);
+    });
+
+    EXPECT_NEAR(output.back(), std::pow(10.0f, -15.0f / 20.0f), 1e-3);
+    EXPECT_NEAR(compressor.input_level[0], 1.0f, 1e-3);
+    EXPECT_NEAR(compressor.output_level[1], std::pow(10.0f, -15.0f / 20.0f), 1e-3);
+
+    // below the threshold only the makeup gain applies
+    params.makeup_gain = 6.0f;
+    const std::vector<float> quiet(GRANULARITY * 40 * CHANNELS, 0.01f);
+    const std::vector<float> quiet_output = run_granules(quiet, GRANULARITY, [&](const float *src, float *dest, int count) {
+        compressor.process(params, SAMPLE_RATE, src, dest, count);
+    });
+    EXPECT_NEAR(quiet_output.back(), 0.01f * std::pow(10.0f, 6.0f / 20.0f), 1e-4);
+}
+
+TEST(ngs_dsp, compressor_matches_reference) {
+    CompressorParams params{};
+    params.ratio = 3.0f;
+    params.threshold = -12.0f;
+    params.attack = 5.0f;
+    params.release = 80.0f;
+    params.makeup_gain = 2.0f;
+    params.soft_knee = 6.0f;
+    params.stereo_link = true;
+    params.peak_mode = false;
+
+    const int frames = GRANULARITY * 8 + 5;
+    const std::vector<float> input = random_signal(frames, 7);
+    Compressor compressor;
+    const std::vector<float> output = run_granules(input, 333, [&](const float *src, float *dest, int count) {
+        compressor.process(params, SAMPLE_RATE, src, dest, count);
+    });
+
+    const double attack = std::exp(-1000.0 / (params.attack * SAMPLE_RATE));
+    const double release = std::exp(-1000.0 / (params.release * SAMPLE_RATE));
+    const double slope = 1.0 / params.ratio - 1.0;
+    double env[CHANNELS] = {};
+    for (int i = 0; i < frames; i++) {
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            const double level = input[i * CHANNELS + ch] * input[i * CHANNELS + ch];
+            const double coeff = (level > env[ch]) ? attack : release;
+            env[ch] = coeff * env[ch] + (1.0 - coeff) * level;
+        }
+        const double linked = std::max(env[0], env[1]);
+        const double over = 10.0 * std::log10(std::max(linked, 1e-10)) - params.threshold;
+        double reduction = 0.0;
+        if (2.0 * over > params.soft_knee)
+            reduction = slope * over;
+        else if (2.0 * over > -params.soft_knee)
+            reduction = slope * (over + params.soft_knee / 2.0) * (over + params.soft_knee / 2.0) / (2.0 * params.soft_knee);
+        const double gain = std::pow(10.0, (reduction + params.makeup_gain) / 20.0);
+
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            const double expected = input[i * CHANNELS + ch] * gain;
+            ASSERT_NEAR(output[i * CHANNELS + ch], expected, 1e-3 * std::max(1.0, std::abs(expected))) << "at frame " << i;
+        }
+    }
+}
+
+TEST(ngs_dsp, envelope_attack_sustain_release) {
+    EnvelopeParams params{};
+    params.points[0] = { 10, 0.0f, EnvelopeCurve::Linear };
+    params.points[1] = { 0, 1.0f, EnvelopeCurve::Linear };
+    params.count = 2;
+    params.release = 20;
+    params.loop_end = -1;
+
+    const std::vector<float> input(GRANULARITY * CHANNELS, 1.0f);
+    std::vector<float> output(input.size());
+    Envelope envelope;
+
+    EXPECT_FALSE(envelope.process(params, SAMPLE_RATE, false, input.data(), output.data(), GRANULARITY));
+    // a 10 ms ramp at 48 kHz, halfway there after 240 frames
+    EXPECT_NEAR(output[240 * CHANNELS], 0.5f, 1e-3);
+    EXPECT_NEAR(output[480 * CHANNELS], 1.0f, 1e-3);
+    EXPECT_FLOAT_EQ(output.back(), 1.0f);
+
+    // the 20 ms release spans 960 frames
+    EXPECT_FALSE(envelope.process(params, SAMPLE_RATE, true, input.data(), output.data(), GRANULARITY));
+    EXPECT_TRUE(envelope.releasing);
+    EXPECT_NEAR(output[480 * CHANNELS + 1], 0.5f, 1e-3);
+    EXPECT_TRUE(envelope.process(params, SAMPLE_RATE, true, input.data(), output.data(), GRANULARITY));
+    EXPECT_FLOAT_EQ(output.back(), 0.0f);
+}
+
+TEST(ngs_dsp, envelope_loops) {
+    EnvelopeParams params{};
+    params.points[0] = { 5, 0.0f, EnvelopeCurve::Linear };
+    params.points[1] = { 5, 1.0f, EnvelopeCurve::Curved };
+    params.points[2] = { 5, 0.0f, EnvelopeCurve::Linear };
+    params.count = 3;
+    params.loop_start = 0;
+    params.loop_end = 2;
+
+    // 0 -> 1 -> 0 every 10 ms, so the height after 20 ms is back at the start
+    const int frames = 960;
+    const std::vector<float> input(frames * CHANNELS, 1.0f);
+    std::vector<float> output(input.size());
+    Envelope envelope;
+    envelope.process(params, SAMPLE_RATE, false, input.data(), output.data(), frames);
+
+    EXPECT_NEAR(output[240 * CHANNELS], 1.0f, 1e-3);
+    EXPECT_NEAR(output[480 * CHANNELS], 0.0f, 1e-3);
+    EXPECT_NEAR(output[720 * CHANNELS], 1.0f, 1e-3);
+    EXPECT_LT(envelope.point, 2u);
+}
+
+TEST(ngs_dsp, delay_echoes_with_feedback) {
+    DelayParams params{};
+    params.dry = 1.0f;
+    params.taps[0] = { 10.0f, 1.0f, 0.5f, FilterType::Off, 0.0f, 0.0f, 0.0f };
+
+    const int frames = GRANULARITY * 4;
+    std::vector<float> input(frames * CHANNELS, 0.0f);
+    input[0] = 1.0f;
+    input[1] = -1.0f;
+
+    Delay delay;
+    const std::vector<float> output = run_granules(input, GRANULARITY, [&](const float *src, float *dest, int count) {
+        delay.process(params, SAMPLE_RATE, src, dest, count);
+    });
+
+    EXPECT_FLOAT_EQ(output[0], 1.0f);
+    EXPECT_FLOAT_EQ(output[1], -1.0f);
+    EXPECT_NEAR(output[480 * CHANNELS], 1.0f, 1e-6);
+    EXPECT_NEAR(output[480 * CHANNELS + 1], -1.0f, 1e-6);
+    EXPECT_NEAR(output[960 * CHANNELS], 0.5f, 1e-6);
+    EXPECT_NEAR(output[1440 * CHANNELS], 0.25f, 1e-6);
+    EXPECT_NEAR(output[1000 * CHANNELS], 0.0f, 1e-6);
+}
+
+TEST(ngs_dsp, delay_taps_are_independent) {
+    DelayParams params{};
+    params.taps[0] = { 1.0f, 0.5f, 0.0f, FilterType::Off, 0.0f, 0.0f, 0.0f };
+    params.taps[3] = { 2.0f, 0.25f, 0.0f, FilterType::LowPassOnePole, 24000.0f, 0.0f, 0.0f };
+
+    std::vector<float> input(GRANULARITY * CHANNELS, 0.0f);
+    input[0] = 1.0f;
+    std::vector<float> output(input.size());
+    Delay delay;
+    delay.process(params, SAMPLE_RATE, input.data(), output.data(), GRANULARITY);
+
+    EXPECT_FLOAT_EQ(output[0], 0.0f);
+    EXPECT_NEAR(output[48 * CHANNELS], 0.5f, 1e-6);
+    EXPECT_GT(output[96 * CHANNELS], 0.2f);
+    EXPECT_FLOAT_EQ(output[1], 0.0f);
+}
+
+TEST(ngs_dsp, pitch_shift_octave_up) {
+    const int frames = static_cast<int>(SAMPLE_RATE);
+    const std::vector<float> input = sine(frames, 300.0f);
+
+    PitchShifter shifter;
+    const std::vector<float> output = run_granules(input, GRANULARITY, [&](const float *src, float *dest, int count) {
+        shifter.process(1200.0f, SAMPLE_RATE, src, dest, count);
+    });
+
+    // most of the energy must have moved to 600 Hz
+    const auto power_at = [&](const float frequency) {
+        std::complex<double> sum = 0.0;
+        for (int i = frames / 4; i < frames; i++)
+            sum += static_cast<double>(output[i * CHANNELS]) * std::polar(1.0, -2.0 * PI * frequency * i / SAMPLE_RATE);
+        return std::norm(sum);
+    };
+    EXPECT_GT(power_at(600.0f), 20.0 * power_at(300.0f));
+
+    PitchShifter unchanged;
+    std::vector<float> copy(input.size());
+    unchanged.process(0.0f, SAMPLE_RATE, input.data(), copy.data(), frames);
+    EXPECT_EQ(copy, input);
+}
+
+TEST(ngs_dsp, reverb_decays) {
+    ReverbParams params{};
+    params.room = 0.0f;
+    params.room_hf = -100.0f;
+    params.decay_time = 1.0f;
+    params.decay_hf_ratio = 0.8f;
+    params.reflections = -1000.0f;
+    params.reflections_delay = 0.01f;
+    params.reverb = 0.0f;
+    params.reverb_delay = 0.02f;
+    params.diffusion = 100.0f;
+    params.density = 100.0f;
+    params.hf_reference = 5000.0f;
+    params.pattern[0] = 0;
+    params.pattern[1] = 1;
+    params.early_reflection_scalar = 1.0f;
+    params.dry = -10000.0f;
+
+    const int frames = static_cast<int>(SAMPLE_RATE * 1.5f);
+    const std::vector<float> input = random_signal(frames, 3);
+    std::vector<float> burst(input.size(), 0.0f);
+    std::copy_n(input.begin(), 4800 * CHANNELS, burst.begin());
+
+    Reverb reverb;
+    const std::vector<float> output = run_granules(burst, GRANULARITY, [&](const float *src, float *dest, int count) {
+        reverb.process(params, SAMPLE_RATE, src, dest, count);
+    });
+
+    for (const float sample : output)
+        ASSERT_TRUE(std::isfinite(sample));
+
+    // a 1 s decay time drops 60 dB per second, measure 300 ms apart once the burst is over
+    const double early = rms(output, 9600, 14400);
+    const double late = rms(output, 24000, 28800);
+    EXPECT_GT(early, 1e-3);
+    EXPECT_NEAR(20.0 * std::log10(late / early), -18.0, 6.0);
+    EXPECT_GT(rms(output, 9600, 14400, 1), 1e-3);
+}
+
+TEST(ngs_dsp, reverb_dry_only) {
+    ReverbParams params{};
+    params.room = -10000.0f;
+    params.decay_time = 1.0f;
+    params.hf_reference = 5000.0f;
+    params.dry = 0.0f;
+
+    const std::vector<float> input = random_signal(GRANULARITY);
+    std::vector<float> output(input.size());
+    Reverb reverb;
+    reverb.process(params, SAMPLE_RATE, input.data(), output.data(), GRANULARITY);
+
+    for (size_t i = 0; i < input.size(); i++)
+        ASSERT_NEAR(output[i], input[i], 1e-6);
+}
@@ -160,11 +160,10 @@ bool Context::init_info_from_trp() {
 static constexpr std::uint32_t TROPHY_USR_MAGIC = 0x12D5819A;
 
 void Context::save_trophy_progress_file() {
-    // Open the file
-    const SceUID output = open_file(*io, trophy_progress_output_file_path.c_str(), SCE_O_WRONLY | SCE_O_CREAT, pref_path, "save_trophy_progress");
-
-    auto write_stuff = [&](const void *data, std::uint32_t amount) -> int {
-        return write_file(output, data, amount, *io, "save_trophy_progress_file");
+    // The whole file is replaced by the write-behind worker, an unlock does not wait for the disk
+    vfs::FileUpdate update;
+    auto write_stuff = [&](const void *data, std::uint32_t amount) {
+        update.data.insert(update.data.end(), static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + amount);
     };
 
     write_stuff(&TROPHY_USR_MAGIC, 4);
@@ -178,7 +177,8 @@ void Context::save_trophy_progress_file() {
     write_stuff(unlock_timestamps.data(), (std::uint32_t)unlock_timestamps.size() * 8);
     write_stuff(trophy_kinds.data(), (std::uint32_t)trophy_kinds.size() * 4);
 
-    close_file(*io, output, "save_trophy_progress_file");
+    update.size = update.data.size();
+    io->write_behind.update(expand_path(*io, trophy_progress_output_file_path.c_str(), pref_path), std::move(update));
 }
 
 bool Context::load_trophy_progress_file(const SceUID &progress_input_file) {
@@ -0,0 +1,120 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Times the translation of guest addresses to the GPU buffer memory mapped there, done for every vertex
+// stream, index buffer and uniform buffer of a draw when memory mapping is used:
+// - map: the lower_bound over the std::map of the mappings
+// - table: the page table of MappingTable
+// for a range of mapping counts.
+
+#include <renderer/vulkan/mapping_table.h>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace renderer::vulkan;
+
+namespace {
+
+using Table = MappingTable<uint64_t>;
+using Mapping = Table::Mapping;
+
+constexpr uint32_t MAPPING_SIZE = 1024 * 1024;
+constexpr size_t LOOKUP_COUNT = 4096;
+
+struct Options {
+    double seconds = 0.2;
+};
+
+// Average time of a lookup in nanoseconds, lookup returns the device address
+template <typename Lookup>
+double time_lookups(const Options &options, const std::vector<Address> &addresses, Lookup lookup) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const auto deadline = start + std::chrono::duration<double>(options.seconds);
+    uint64_t lookups = 0;
+    uint64_t sum = 0;
+    auto now = start;
+    while (now < deadline) {
+        for (const Address address : addresses)
+            sum += lookup(address);
+        lookups += addresses.size();
+        now = clock::now();
+    }
+
+    // keep the lookups from being optimized away
+    if (sum == 0)
+        fmt::print("");
+    return std::chrono::duration<double, std::nano>(now - start).count() / lookups;
+}
+
+void print_usage() {
+    fmt::print("Usage: renderer-benchmark [--seconds S]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::stod(argv[++i]);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    fmt::print("ns per lookup, {} random addresses in {} KiB mappings\n", LOOKUP_COUNT, MAPPING_SIZE / 1024);
+    fmt::print("{:>8} {:>10} {:>10}\n", "mappings", "map", "table");
+    for (const uint32_t mapping_count : { 4u, 16u, 64u, 256u, 1024u }) {
+        std::mt19937 random(mapping_count);
+        std::map<Address, Mapping, std::greater<Address>> mappings;
+        Table table;
+        for (uint32_t i = 0; i < mapping_count; i++) {
+            // leave a gap between the mappings, like separate allocations
+            const Mapping mapping{ 0x81000000 + i * MAPPING_SIZE * 2, MAPPING_SIZE, i + 1, uint64_t(i + 1) << 32 };
+            mappings[mapping.address] = mapping;
+            table.map(mapping);
+        }
+
+        std::vector<Address> addresses(LOOKUP_COUNT);
+        for (Address &address : addresses)
+            address = 0x81000000 + (random() % mapping_count) * MAPPING_SIZE * 2 + random() % MAPPING_SIZE;
+
+        const double map_time = time_lookups(options, addresses, [&](Address address) -> uint64_t {
+            auto it = mappings.lower_bound(address);
+            if (it == mappings.end() || it->first + it->second.size < address)
+                return 0;
+            return it->second.device_address + address - it->first;
+        });
+        const double table_time = time_lookups(options, addresses, [&](Address address) -> uint64_t {
+            const Mapping *mapping = table.find(address);
+            return mapping ? mapping->device_address + address - mapping->address : 0;
+        });
+        fmt::print("{:>8} {:>10.2f} {:>10.2f}\n", mapping_count, map_time, table_time);
+    }
+
+    return 0;
+}
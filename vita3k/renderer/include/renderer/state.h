@@ -19,10 +19,12 @@
 
 #include <features/state.h>
 #include <renderer/commands.h>
+#include <renderer/trace.h>
 #include <renderer/types.h>
 #include <threads/queue.h>
 
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <string_view>
 
@@ -78,6 +80,18 @@ struct State {
     uint32_t shaders_count_compiled = 0;
     uint32_t programs_count_pre_compiled = 0;
 
+    // running totals, only used to profile the renderer
+    uint64_t draw_count = 0;
+    uint64_t pipeline_bind_count = 0;
+    uint64_t surface_sync_count = 0;
+    // on Vulkan, texture descriptor sets found in the cache or not and single descriptors written
+    uint64_t descriptor_set_hits = 0;
+    uint64_t descriptor_set_misses = 0;
+    uint64_t descriptor_writes = 0;
+
+    // set when the commands processed are recorded to a GXM trace
+    std::unique_ptr<trace::Writer> trace;
+
     bool should_display;
 
     bool need_page_table = false;
@@ -95,7 +109,7 @@ struct State {
     virtual std::vector<uint32_t> dump_frame(DisplayState &display, uint32_t &width, uint32_t &height) = 0;
     // return a mask of the features which can influence the compiled shaders
     virtual uint32_t get_features_mask() {
-        return 0;
+        return features.optimize_spirv ? 1 : 0;
     }
     // return a bitmask with the Filter enum values of the supported enum filters
     virtual int get_supported_filters() = 0;
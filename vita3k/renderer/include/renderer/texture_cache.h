@@ -100,6 +100,8 @@ public:
     // use a separate sampler cache
     bool use_sampler_cache = false;
     int anisotropic_filtering = 1;
+    // number of textures uploaded since the creation of the cache, only used for profiling
+    uint64_t upload_count = 0;
 
     // used to quickly get the info from a hash of a gxm_texture
     unordered_map_fast<TextureGxmDataRepr, TextureCacheInfo *> texture_lookup;
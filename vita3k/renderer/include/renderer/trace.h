@@ -0,0 +1,143 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <renderer/commands.h>
+
+#include <mem/ptr.h>
+#include <util/fs.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct MemState;
+
+namespace renderer {
+struct State;
+
+// A GXM trace is a record of everything the renderer thread consumed while running an app: the command lists
+// and the guest memory they read. It can be replayed without the app (see renderer-replay) to measure the
+// renderer alone on an identical workload.
+//
+// File layout: a FileHeader followed by records, each one starting with a RecordType byte.
+// Host pointers embedded in the commands are kept as-is and only serve as identifiers, the structures they
+// point to are stored after the command record.
+namespace trace {
+
+constexpr uint32_t MAGIC = 0x54473356; // 'V3GT'
+constexpr uint32_t VERSION = 1;
+
+enum class RecordType : uint8_t {
+    // MemoryRecord followed by the content of the range
+    Memory,
+    // FragmentProgramRecord
+    FragmentProgram,
+    // VertexProgramRecord followed by the streams and the attributes
+    VertexProgram,
+    // BatchRecord, the following commands until the next batch belong to this command list
+    Batch,
+    // CommandRecord followed by payload_size bytes
+    Command,
+};
+
+#pragma pack(push, 1)
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t backend;
+    uint32_t page_size;
+    float res_multiplier;
+};
+
+struct MemoryRecord {
+    Address address;
+    uint32_t size;
+};
+
+struct FragmentProgramRecord {
+    Address gxm_program; // SceGxmFragmentProgram
+    Address program; // SceGxmProgram
+    uint8_t is_maskupdate;
+    uint8_t has_blend;
+    uint32_t blend; // SceGxmBlendInfo
+};
+
+struct VertexProgramRecord {
+    Address gxm_program; // SceGxmVertexProgram
+    Address program; // SceGxmProgram
+    uint64_t key_hash;
+    uint32_t stream_count;
+    uint32_t attribute_count;
+};
+
+struct BatchRecord {
+    uint64_t context; // Context * at capture time, 0 for commands sent without a context
+};
+
+struct CommandRecord {
+    CommandOpcode opcode;
+    uint8_t flags;
+    uint8_t has_status;
+    uint32_t payload_size;
+    uint8_t data[MAX_COMMAND_DATA_SIZE];
+};
+#pragma pack(pop)
+
+// Records the renderer thread activity. All its functions must be called from the renderer thread.
+class Writer {
+public:
+    bool open(const fs::path &path);
+
+    // the first call also writes the file header and the content of all the allocated guest memory
+    void begin_batch(const State &state, MemState &mem, const CommandList &command_list);
+    // must be called before and after the command handler, pointers given to the command are only valid before
+    // and created objects only exist after
+    void begin_command(MemState &mem, const Command &cmd, const Context *context);
+    void end_command(const Command &cmd);
+
+    // write the content of the guest range if it changed since it was last written
+    void capture_range(MemState &mem, Address address, uint32_t size);
+
+private:
+    // write all the allocated pages, done once when the capture starts
+    void capture_all_pages(MemState &mem);
+    void capture_page(MemState &mem, uint32_t page);
+    void capture_program(MemState &mem, Address gxm_program, bool is_fragment);
+
+    template <typename T>
+    void push_payload(const T *value, size_t count = 1) {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(value);
+        payload.insert(payload.end(), bytes, bytes + sizeof(T) * count);
+    }
+
+    fs::ofstream file;
+    uint32_t page_size = 0;
+    bool memory_captured = false;
+
+    // hash of the content of each page when it was last written, 0 if never written
+    std::vector<uint64_t> page_hashes;
+    // renderer data of the programs already written, to notice when an address is reused by another program
+    std::unordered_map<Address, const void *> captured_programs;
+
+    CommandRecord pending{};
+    std::vector<uint8_t> payload;
+};
+
+} // namespace trace
+} // namespace renderer
@@ -27,6 +27,7 @@
 #include <array>
 #include <bitset>
 #include <map>
+#include <optional>
 #include <vector>
 
 static constexpr auto DEFAULT_RES_WIDTH = 960;
@@ -189,6 +190,8 @@ struct ShaderProgram {
 };
 
 struct FragmentProgram : ShaderProgram {
+    // blending the program was created with, kept so that a GXM trace can recreate it
+    std::optional<SceGxmBlendInfo> blend;
 };
 
 struct VertexProgram : ShaderProgram {
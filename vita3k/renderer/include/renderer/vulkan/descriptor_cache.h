@@ -0,0 +1,82 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/containers.h>
+#include <vkutil/vkutil.h>
+
+#include <array>
+#include <span>
+#include <vector>
+
+namespace renderer::vulkan {
+
+struct VKState;
+
+// Texture descriptor sets are never updated once written: a draw binding the same images and samplers as
+// a previous one binds the set written then. Each texture layout has a fixed number of sets, the least
+// recently used one is rewritten on a miss once no frame being rendered can still use it.
+class DescriptorSetCache {
+private:
+    // sets of a single layout
+    static constexpr uint32_t CACHE_SIZE = 256;
+
+    struct Entry {
+        // of the images, 0 if nothing is written in the set
+        uint64_t hash = 0;
+        std::array<vk::DescriptorImageInfo, 16> images;
+        uint32_t images_count = 0;
+        vk::DescriptorSet set;
+        // context.frame_timestamp of the last frame using the set
+        uint64_t last_used_frame = 0;
+    };
+
+    struct LayoutCache {
+        bool is_init = false;
+        lru::Queue<Entry> queue;
+        unordered_map_fast<uint64_t, Entry *> entries;
+    };
+
+    VKState &state;
+
+    // indexed by the number of textures - 1
+    std::array<LayoutCache, 16> vertex_caches;
+    std::array<LayoutCache, 16> fragment_caches;
+
+    // entries written with each image view and sampler handle, so forgetting a handle does not go through every set
+    unordered_map_fast<uint64_t, std::vector<std::pair<LayoutCache *, Entry *>>> entries_by_handle;
+
+    void init_layout(LayoutCache &cache, bool is_vertex, uint32_t textures_count);
+    void index_handles(LayoutCache &cache, Entry &entry);
+    void drop(LayoutCache &cache, Entry &entry);
+
+public:
+    explicit DescriptorSetCache(VKState &state);
+
+    // Set with the images bound, they are written to it on a miss. Returns null if all the sets of the layout
+    // may still be used by a frame being rendered, the caller must write its own set then.
+    vk::DescriptorSet get(bool is_vertex, std::span<const vk::DescriptorImageInfo> images, uint64_t frame_timestamp);
+    void write(vk::DescriptorSet set, std::span<const vk::DescriptorImageInfo> images);
+
+    // The sets using an image view or sampler about to be destroyed must not be bound anymore
+    void forget(vk::Sampler sampler);
+    // Same with the handles of several image views and samplers
+    void forget(std::span<const uint64_t> handles);
+};
+
+} // namespace renderer::vulkan
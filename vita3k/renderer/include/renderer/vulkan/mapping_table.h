@@ -0,0 +1,152 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace renderer::vulkan {
+
+// Translates guest addresses to the GPU buffer memory mapped there with a lookup per 4 KiB page. The mappings
+// must not overlap. Lookups do not take any lock, a range must not be unmapped while it is being looked up.
+// A page shared by several mappings (mappings which do not start or end on a page) is not in the table, the
+// lookup fails there and the caller has to use its own.
+template <typename Buffer, uint32_t MAX_MAPPINGS = 1024>
+class MappingTable {
+public:
+    struct Mapping {
+        Address address;
+        uint32_t size;
+        Buffer buffer;
+        uint64_t device_address;
+    };
+
+private:
+    static constexpr uint32_t PAGE_BITS = 12;
+    static constexpr uint64_t PAGE_COUNT = (uint64_t(1) << 32) >> PAGE_BITS;
+    static constexpr uint32_t SHARED_PAGE = ~0u;
+
+    // index + 1 of the slot of the mapping covering each page, 0 if there is none, SHARED_PAGE if there are several
+    std::unique_ptr<std::atomic<uint32_t>[]> pages;
+    std::array<Mapping, MAX_MAPPINGS> slots;
+    std::vector<uint32_t> free_slots;
+    // slot index of each mapping by address, only used when mapping and unmapping
+    std::map<Address, uint32_t> mapped_slots;
+
+    static uint64_t first_page(const Mapping &mapping) {
+        return mapping.address >> PAGE_BITS;
+    }
+
+    static uint64_t end_page(const Mapping &mapping) {
+        return (uint64_t(mapping.address) + mapping.size + (uint64_t(1) << PAGE_BITS) - 1) >> PAGE_BITS;
+    }
+
+    // Value of a page computed from the mappings covering it
+    uint32_t page_value(uint64_t page) const {
+        const uint64_t page_start = page << PAGE_BITS;
+        const uint64_t page_end = page_start + (uint64_t(1) << PAGE_BITS);
+        uint32_t value = 0;
+        auto it = mapped_slots.upper_bound(static_cast<Address>(page_start));
+        if (it != mapped_slots.begin())
+            it--;
+        for (; it != mapped_slots.end() && it->first < page_end; it++) {
+            const Mapping &mapping = slots[it->second];
+            if (end_page(mapping) <= page)
+                continue;
+            if (value)
+                return SHARED_PAGE;
+            value = it->second + 1;
+        }
+        return value;
+    }
+
+    const Mapping *get(uint64_t page) const {
+        const uint32_t slot = pages[page].load(std::memory_order_acquire);
+        return (slot && slot != SHARED_PAGE) ? &slots[slot - 1] : nullptr;
+    }
+
+public:
+    // Replaces the mapping at the same address if there is one. An empty mapping covers no page and is not added.
+    // Returns false if all the slots are used, the mapping can't be looked up then
+    bool map(const Mapping &mapping) {
+        if (!pages) {
+            pages = std::make_unique<std::atomic<uint32_t>[]>(PAGE_COUNT);
+            for (uint32_t slot = MAX_MAPPINGS; slot > 0; slot--)
+                free_slots.push_back(slot - 1);
+        }
+        unmap(mapping.address);
+        if (mapping.size == 0)
+            return true;
+        if (free_slots.empty())
+            return false;
+
+        const uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        slots[slot] = mapping;
+        mapped_slots[mapping.address] = slot;
+
+        const uint64_t first = first_page(mapping);
+        const uint64_t last = end_page(mapping) - 1;
+        for (uint64_t page = first; page <= last; page++) {
+            // only the first and last pages can be shared with another mapping
+            const uint32_t value = (page == first || page == last) ? page_value(page) : slot + 1;
+            pages[page].store(value, std::memory_order_release);
+        }
+        return true;
+    }
+
+    void unmap(Address address) {
+        const auto it = mapped_slots.find(address);
+        if (it == mapped_slots.end())
+            return;
+
+        const uint32_t slot = it->second;
+        mapped_slots.erase(it);
+        free_slots.push_back(slot);
+
+        const Mapping &mapping = slots[slot];
+        const uint64_t first = first_page(mapping);
+        const uint64_t last = end_page(mapping) - 1;
+        for (uint64_t page = first; page <= last; page++) {
+            // a page shared with another mapping now only belongs to it
+            const uint32_t value = (page == first || page == last) ? page_value(page) : 0;
+            pages[page].store(value, std::memory_order_release);
+        }
+    }
+
+    // Mapping containing address, its end included like any pointer to the end of a buffer
+    const Mapping *find(Address address) const {
+        if (!pages)
+            return nullptr;
+
+        const uint64_t page = address >> PAGE_BITS;
+        const Mapping *mapping = get(page);
+        if (!mapping && page > 0 && (address & ((1 << PAGE_BITS) - 1)) == 0)
+            mapping = get(page - 1);
+        if (!mapping || address - mapping->address > mapping->size)
+            return nullptr;
+        return mapping;
+    }
+};
+
+} // namespace renderer::vulkan
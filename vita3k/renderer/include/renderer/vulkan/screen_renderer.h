@@ -74,7 +74,7 @@ public:
 
     ScreenRenderer(VKState &state);
 
-    bool create(SDL_Window *window);
+    bool create(SDL_Window *window, bool headless = false);
     // called after the logical device has been created
     bool setup();
     void cleanup();
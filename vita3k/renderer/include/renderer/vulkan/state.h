@@ -20,6 +20,8 @@
 #include <renderer/state.h>
 #include <renderer/types.h>
 
+#include <renderer/vulkan/descriptor_cache.h>
+#include <renderer/vulkan/mapping_table.h>
 #include <renderer/vulkan/pipeline_cache.h>
 #include <renderer/vulkan/screen_renderer.h>
 #include <renderer/vulkan/surface_cache.h>
@@ -47,6 +49,7 @@ struct VKState : public renderer::State {
     VKSurfaceCache surface_cache;
     PipelineCache pipeline_cache;
     VKTextureCache texture_cache;
+    DescriptorSetCache descriptor_cache;
 
     vk::Instance instance;
     vk::Device device;
@@ -88,6 +91,8 @@ struct VKState : public renderer::State {
 
     // only used when memory mapping is enabled
     std::map<Address, MappedMemory, std::greater<Address>> mapped_memories;
+    // same mappings, looked up for every draw
+    MappingTable<vk::Buffer> mapping_table;
 
     // queue where we put requests that need to wait for the GPU
     Queue<WaitThreadRequest> request_queue;
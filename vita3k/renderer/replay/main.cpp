@@ -0,0 +1,621 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Replays a GXM trace recorded with --gxm-trace against the OpenGL or Vulkan renderer, as fast as possible,
+// and reports how much CPU time the renderer spent on each frame.
+
+#include <renderer/functions.h>
+#include <renderer/state.h>
+#include <renderer/texture_cache.h>
+#include <renderer/trace.h>
+#include <renderer/types.h>
+
+#include <config/state.h>
+#include <display/state.h>
+#include <gxm/state.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <util/align.h>
+#include <util/fs.h>
+#include <util/log.h>
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace renderer;
+using namespace renderer::trace;
+
+namespace {
+
+struct FrameStats {
+    double cpu_ms;
+    uint64_t draws;
+    uint64_t pipeline_binds;
+    uint64_t texture_uploads;
+    uint64_t surface_syncs;
+    uint64_t descriptor_set_hits;
+    uint64_t descriptor_set_misses;
+    uint64_t descriptor_writes;
+};
+
+struct Counters {
+    uint64_t draws = 0;
+    uint64_t pipeline_binds = 0;
+    uint64_t texture_uploads = 0;
+    uint64_t surface_syncs = 0;
+    uint64_t descriptor_set_hits = 0;
+    uint64_t descriptor_set_misses = 0;
+    uint64_t descriptor_writes = 0;
+};
+
+class PayloadReader {
+    const std::vector<uint8_t> &payload;
+    size_t offset = 0;
+
+public:
+    explicit PayloadReader(const std::vector<uint8_t> &payload)
+        : payload(payload) {
+    }
+
+    template <typename T>
+    T take() {
+        T value{};
+        if (offset + sizeof(T) <= payload.size())
+            memcpy(&value, payload.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+};
+
+template <typename T>
+bool read(fs::ifstream &file, T &value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+// return a reference to the next argument of the command, so that it can be remapped
+template <typename T>
+T &next_argument(CommandHelper &helper) {
+    T *arg = reinterpret_cast<T *>(helper.cmd->data + helper.point);
+    helper.point += sizeof(T);
+    return *arg;
+}
+
+class Replayer {
+    State &state;
+    MemState &mem;
+    Config &config;
+    SDL_Window *window;
+
+    DisplayState display;
+    // only needed by render_frame's signature
+    GxmState gxm;
+
+    // objects created by the trace, indexed by their address at capture time
+    std::map<uint64_t, std::unique_ptr<Context>> contexts;
+    std::map<uint64_t, std::unique_ptr<RenderTarget>> render_targets;
+    Context *batch_context = nullptr;
+
+    // programs constructed in guest memory, their content must survive the memory records
+    std::map<Address, uint32_t> host_objects;
+
+    std::chrono::steady_clock::duration frame_time{};
+    Counters last_counters;
+
+    Counters counters() const {
+        return {
+            .draws = state.draw_count,
+            .pipeline_binds = state.pipeline_bind_count,
+            .texture_uploads = state.get_texture_cache()->upload_count,
+            .surface_syncs = state.surface_sync_count,
+            .descriptor_set_hits = state.descriptor_set_hits,
+            .descriptor_set_misses = state.descriptor_set_misses,
+            .descriptor_writes = state.descriptor_writes
+        };
+    }
+
+    void ensure_allocated(Address address, uint32_t size) {
+        const uint32_t page_size = mem.page_size;
+        for (uint64_t page = align_down(address, page_size); page < static_cast<uint64_t>(address) + size; page += page_size) {
+            if (page != 0 && !is_valid_addr(mem, static_cast<Address>(page)))
+                alloc_at(mem, static_cast<Address>(page), page_size, "gxm trace");
+        }
+    }
+
+    void write_memory(Address address, const std::vector<uint8_t> &data) {
+        const uint32_t size = static_cast<uint32_t>(data.size());
+        ensure_allocated(address, size);
+
+        constexpr uint32_t max_object_size = std::max(sizeof(SceGxmFragmentProgram), sizeof(SceGxmVertexProgram));
+        std::vector<std::pair<Address, std::vector<uint8_t>>> saved;
+        for (auto it = host_objects.lower_bound(address > max_object_size ? address - max_object_size : 0);
+             it != host_objects.end() && it->first < address + size; ++it) {
+            if (it->first + it->second <= address)
+                continue;
+
+            const uint8_t *object = Ptr<const uint8_t>(it->first).get(mem);
+            saved.emplace_back(it->first, std::vector<uint8_t>(object, object + it->second));
+        }
+
+        memcpy(Ptr<uint8_t>(address).get(mem), data.data(), size);
+
+        for (const auto &[object_address, content] : saved)
+            memcpy(Ptr<uint8_t>(object_address).get(mem), content.data(), content.size());
+    }
+
+    template <typename T>
+    T *construct_program(Address address) {
+        ensure_allocated(address, sizeof(T));
+        T *program = Ptr<T>(address).get(mem);
+        if (host_objects.contains(address))
+            std::destroy_at(program);
+
+        new (program) T();
+        host_objects[address] = sizeof(T);
+        return program;
+    }
+
+    bool replay_fragment_program(const FragmentProgramRecord &record) {
+        SceGxmFragmentProgram *fp = construct_program<SceGxmFragmentProgram>(record.gxm_program);
+        fp->program = Ptr<const SceGxmProgram>(record.program);
+        fp->is_maskupdate = record.is_maskupdate;
+
+        SceGxmBlendInfo blend;
+        memcpy(&blend, &record.blend, sizeof(blend));
+        return renderer::create(fp->renderer_data, state, *fp->program.get(mem), record.has_blend ? &blend : nullptr, state.gxp_ptr_map);
+    }
+
+    bool replay_vertex_program(const VertexProgramRecord &record, std::vector<SceGxmVertexStream> &&streams, std::vector<SceGxmVertexAttribute> &&attributes) {
+        SceGxmVertexProgram *vp = construct_program<SceGxmVertexProgram>(record.gxm_program);
+        vp->program = Ptr<const SceGxmProgram>(record.program);
+        vp->key_hash = record.key_hash;
+        vp->streams = std::move(streams);
+        vp->attributes = std::move(attributes);
+
+        return renderer::create(vp->renderer_data, state, *vp->program.get(mem), state.gxp_ptr_map, vp->attributes);
+    }
+
+    template <typename T>
+    static T *lookup(std::map<uint64_t, std::unique_ptr<T>> &objects, uint64_t id) {
+        const auto it = objects.find(id);
+        return it == objects.end() ? nullptr : it->second.get();
+    }
+
+    void replay_command(const CommandRecord &record, const std::vector<uint8_t> &payload_data) {
+        // sync objects live in guest memory and hold host data, the trace order already is the one they enforced
+        if (record.opcode == CommandOpcode::WaitSyncObject || record.opcode == CommandOpcode::SignalSyncObject)
+            return;
+
+        Command *cmd = generic_command_allocate();
+        cmd->opcode = record.opcode;
+        cmd->flags = record.flags;
+        cmd->next = nullptr;
+        memcpy(cmd->data, record.data, sizeof(cmd->data));
+
+        int status = CommandErrorCodePending;
+        cmd->status = record.has_status ? &status : nullptr;
+
+        // these must outlive the command
+        SceGxmRenderTargetParams params;
+        SceGxmColorSurface sync_surface;
+
+        PayloadReader payload(payload_data);
+        CommandHelper helper(cmd);
+        switch (record.opcode) {
+        case CommandOpcode::CreateContext:
+            next_argument<std::unique_ptr<Context> *>(helper) = &contexts[payload.take<uint64_t>()];
+            break;
+
+        case CommandOpcode::DestroyContext:
+            next_argument<std::unique_ptr<Context> *>(helper) = &contexts[payload.take<uint64_t>()];
+            break;
+
+        case CommandOpcode::CreateRenderTarget:
+            params = payload.take<SceGxmRenderTargetParams>();
+            next_argument<std::unique_ptr<RenderTarget> *>(helper) = &render_targets[payload.take<uint64_t>()];
+            next_argument<SceGxmRenderTargetParams *>(helper) = &params;
+            break;
+
+        case CommandOpcode::DestroyRenderTarget:
+            next_argument<std::unique_ptr<RenderTarget> *>(helper) = &render_targets[payload.take<uint64_t>()];
+            break;
+
+        case CommandOpcode::SetContext: {
+            RenderTarget *&target = next_argument<RenderTarget *>(helper);
+            target = lookup(render_targets, reinterpret_cast<uint64_t>(target));
+            // the handler deletes the surfaces
+            SceGxmColorSurface *&color_surface = next_argument<SceGxmColorSurface *>(helper);
+            if (color_surface)
+                color_surface = new SceGxmColorSurface(payload.take<SceGxmColorSurface>());
+            SceGxmDepthStencilSurface *&depth_stencil_surface = next_argument<SceGxmDepthStencilSurface *>(helper);
+            if (depth_stencil_surface)
+                depth_stencil_surface = new SceGxmDepthStencilSurface(payload.take<SceGxmDepthStencilSurface>());
+            break;
+        }
+
+        case CommandOpcode::SyncSurfaceData:
+            if (record.has_status) {
+                next_argument<SceGxmNotification>(helper);
+                next_argument<SceGxmNotification>(helper);
+                SceGxmColorSurface *&surface = next_argument<SceGxmColorSurface *>(helper);
+                if (surface) {
+                    sync_surface = payload.take<SceGxmColorSurface>();
+                    surface = &sync_surface;
+                }
+            }
+            break;
+
+        case CommandOpcode::TransferCopy: {
+            next_argument<uint32_t>(helper);
+            next_argument<uint32_t>(helper);
+            next_argument<SceGxmTransferColorKeyMode>(helper);
+            SceGxmTransferImage *images = new SceGxmTransferImage[2];
+            images[0] = payload.take<SceGxmTransferImage>();
+            images[1] = payload.take<SceGxmTransferImage>();
+            next_argument<SceGxmTransferImage *>(helper) = images;
+            break;
+        }
+
+        case CommandOpcode::TransferDownscale:
+            next_argument<SceGxmTransferImage *>(helper) = new SceGxmTransferImage(payload.take<SceGxmTransferImage>());
+            next_argument<SceGxmTransferImage *>(helper) = new SceGxmTransferImage(payload.take<SceGxmTransferImage>());
+            break;
+
+        case CommandOpcode::TransferFill:
+            next_argument<uint32_t>(helper);
+            next_argument<SceGxmTransferImage *>(helper) = new SceGxmTransferImage(payload.take<SceGxmTransferImage>());
+            break;
+
+        case CommandOpcode::NewFrame: {
+            DisplayFrameInfo *&next_frame = next_argument<DisplayFrameInfo *>(helper);
+            if (next_frame) {
+                next_frame = new DisplayFrameInfo(payload.take<DisplayFrameInfo>());
+                next_argument<DisplayState *>(helper) = &display;
+            }
+            break;
+        }
+
+        case CommandOpcode::MemoryMap: {
+            const Ptr<void> address = next_argument<Ptr<void>>(helper);
+            ensure_allocated(address.address(), next_argument<uint32_t>(helper));
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        CommandList command_list;
+        command_list.first = cmd;
+        command_list.last = cmd;
+        command_list.context = batch_context;
+
+        const auto start = std::chrono::steady_clock::now();
+        renderer::process_batch(state, mem, config, command_list);
+        if (record.opcode == CommandOpcode::NewFrame && state.should_display) {
+            const SceFVector2 viewport_pos = { 0.0f, 0.0f };
+            const SceFVector2 viewport_size = { DEFAULT_RES_WIDTH * state.res_multiplier, DEFAULT_RES_HEIGHT * state.res_multiplier };
+            state.render_frame(viewport_pos, viewport_size, display, gxm, mem);
+            state.swap_window(window);
+        }
+        frame_time += std::chrono::steady_clock::now() - start;
+
+        if (record.opcode == CommandOpcode::CreateContext) {
+            Context *context = lookup(contexts, payload_data.empty() ? 0 : *reinterpret_cast<const uint64_t *>(payload_data.data()));
+            if (context) {
+                context->alloc_func = generic_command_allocate;
+                context->free_func = generic_command_free;
+            }
+        } else if (record.opcode == CommandOpcode::NewFrame) {
+            end_frame();
+        }
+    }
+
+    void end_frame() {
+        const Counters current = counters();
+        frames.push_back({
+            .cpu_ms = std::chrono::duration<double, std::milli>(frame_time).count(),
+            .draws = current.draws - last_counters.draws,
+            .pipeline_binds = current.pipeline_binds - last_counters.pipeline_binds,
+            .texture_uploads = current.texture_uploads - last_counters.texture_uploads,
+            .surface_syncs = current.surface_syncs - last_counters.surface_syncs,
+            .descriptor_set_hits = current.descriptor_set_hits - last_counters.descriptor_set_hits,
+            .descriptor_set_misses = current.descriptor_set_misses - last_counters.descriptor_set_misses,
+            .descriptor_writes = current.descriptor_writes - last_counters.descriptor_writes,
+        });
+
+        last_counters = current;
+        frame_time = {};
+    }
+
+public:
+    std::vector<FrameStats> frames;
+
+    Replayer(State &state, MemState &mem, Config &config, SDL_Window *window)
+        : state(state)
+        , mem(mem)
+        , config(config)
+        , window(window) {
+    }
+
+    bool run(fs::ifstream &file, std::optional<uint32_t> max_frames) {
+        RecordType type;
+        while (read(file, type)) {
+            if (max_frames && frames.size() >= *max_frames)
+                break;
+
+            switch (type) {
+            case RecordType::Memory: {
+                MemoryRecord record;
+                if (!read(file, record))
+                    return false;
+
+                std::vector<uint8_t> data(record.size);
+                if (!file.read(reinterpret_cast<char *>(data.data()), data.size()))
+                    return false;
+
+                write_memory(record.address, data);
+                break;
+            }
+
+            case RecordType::FragmentProgram: {
+                FragmentProgramRecord record;
+                if (!read(file, record))
+                    return false;
+
+                if (!replay_fragment_program(record))
+                    LOG_ERROR("Could not recreate the fragment program at {}", log_hex(record.gxm_program));
+                break;
+            }
+
+            case RecordType::VertexProgram: {
+                VertexProgramRecord record;
+                if (!read(file, record))
+                    return false;
+
+                std::vector<SceGxmVertexStream> streams(record.stream_count);
+                std::vector<SceGxmVertexAttribute> attributes(record.attribute_count);
+                if (!file.read(reinterpret_cast<char *>(streams.data()), streams.size() * sizeof(SceGxmVertexStream))
+                    || !file.read(reinterpret_cast<char *>(attributes.data()), attributes.size() * sizeof(SceGxmVertexAttribute)))
+                    return false;
+
+                if (!replay_vertex_program(record, std::move(streams), std::move(attributes)))
+                    LOG_ERROR("Could not recreate the vertex program at {}", log_hex(record.gxm_program));
+                break;
+            }
+
+            case RecordType::Batch: {
+                BatchRecord record;
+                if (!read(file, record))
+                    return false;
+
+                batch_context = lookup(contexts, record.context);
+                break;
+            }
+
+            case RecordType::Command: {
+                CommandRecord record;
+                if (!read(file, record))
+                    return false;
+
+                std::vector<uint8_t> payload(record.payload_size);
+                if (!file.read(reinterpret_cast<char *>(payload.data()), payload.size()))
+                    return false;
+
+                replay_command(record, payload);
+                break;
+            }
+
+            default:
+                LOG_ERROR("Unknown record type {} in the trace", static_cast<int>(type));
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+double percentile(std::vector<double> sorted_values, double p) {
+    if (sorted_values.empty())
+        return 0.0;
+
+    const size_t index = std::min(sorted_values.size() - 1, static_cast<size_t>(p * sorted_values.size()));
+    return sorted_values[index];
+}
+
+void print_report(const std::vector<FrameStats> &frames, const std::optional<fs::path> &csv_path) {
+    if (frames.empty()) {
+        fmt::print("The trace does not contain any frame\n");
+        return;
+    }
+
+    std::vector<double> times;
+    Counters totals;
+    for (const FrameStats &frame : frames) {
+        times.push_back(frame.cpu_ms);
+        totals.draws += frame.draws;
+        totals.pipeline_binds += frame.pipeline_binds;
+        totals.texture_uploads += frame.texture_uploads;
+        totals.surface_syncs += frame.surface_syncs;
+        totals.descriptor_set_hits += frame.descriptor_set_hits;
+        totals.descriptor_set_misses += frame.descriptor_set_misses;
+        totals.descriptor_writes += frame.descriptor_writes;
+    }
+
+    const double total_ms = std::accumulate(times.begin(), times.end(), 0.0);
+    std::sort(times.begin(), times.end());
+    const double count = static_cast<double>(frames.size());
+
+    fmt::print("Replayed {} frames, {:.3f} ms of renderer CPU time\n", frames.size(), total_ms);
+    fmt::print("CPU time per frame (ms): avg {:.3f}, p50 {:.3f}, p90 {:.3f}, p99 {:.3f}, max {:.3f}\n",
+        total_ms / count, percentile(times, 0.5), percentile(times, 0.9), percentile(times, 0.99), times.back());
+    fmt::print("Per frame: {:.1f} draws, {:.1f} pipeline binds, {:.1f} texture uploads, {:.1f} surface syncs\n",
+        totals.draws / count, totals.pipeline_binds / count, totals.texture_uploads / count, totals.surface_syncs / count);
+    fmt::print("Descriptor sets per frame: {:.1f} hits, {:.1f} misses, {:.1f} descriptors written\n",
+        totals.descriptor_set_hits / count, totals.descriptor_set_misses / count, totals.descriptor_writes / count);
+
+    if (!csv_path)
+        return;
+
+    fs::ofstream csv(*csv_path);
+    if (!csv.is_open()) {
+        LOG_ERROR("Could not open {} for writing", *csv_path);
+        return;
+    }
+
+    csv << "frame,cpu_ms,draws,pipeline_binds,texture_uploads,surface_syncs,descriptor_set_hits,descriptor_set_misses,descriptor_writes\n";
+    for (size_t i = 0; i < frames.size(); i++) {
+        const FrameStats &frame = frames[i];
+        csv << fmt::format("{},{:.4f},{},{},{},{},{},{},{}\n", i, frame.cpu_ms, frame.draws, frame.pipeline_binds, frame.texture_uploads, frame.surface_syncs,
+            frame.descriptor_set_hits, frame.descriptor_set_misses, frame.descriptor_writes);
+    }
+}
+
+void print_usage() {
+    fmt::print("Usage: renderer-replay <trace> [--backend OpenGL|Vulkan] [--frames N] [--csv <file>] [--cache <dir>]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    const fs::path trace_path = fs_utils::utf8_to_path(argv[1]);
+    std::optional<std::string> backend_name;
+    std::optional<uint32_t> max_frames;
+    std::optional<fs::path> csv_path;
+    fs::path cache_path = trace_path;
+    cache_path += ".cache";
+
+    for (int i = 2; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+
+        if (arg == "--backend")
+            backend_name = argv[++i];
+        else if (arg == "--frames")
+            max_frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (arg == "--csv")
+            csv_path = fs_utils::utf8_to_path(argv[++i]);
+        else if (arg == "--cache")
+            cache_path = fs_utils::utf8_to_path(argv[++i]);
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    fs::ifstream file(trace_path, std::ios::binary);
+    FileHeader header;
+    if (!file.is_open() || !read(file, header) || header.magic != MAGIC) {
+        LOG_ERROR("{} is not a GXM trace", trace_path);
+        return 1;
+    }
+    if (header.version != VERSION) {
+        LOG_ERROR("Unsupported GXM trace version {}, expected {}", header.version, VERSION);
+        return 1;
+    }
+
+    Backend backend = static_cast<Backend>(header.backend);
+    if (backend_name)
+        backend = (*backend_name == "OpenGL") ? Backend::OpenGL : Backend::Vulkan;
+
+    Config config;
+    config.headless = (backend == Backend::Vulkan);
+    config.current_config.resolution_multiplier = header.res_multiplier;
+    // pipelines compiled in the background would make the frame times depend on the machine load
+    config.current_config.async_pipeline_compilation = false;
+
+    if (config.headless)
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        LOG_ERROR("SDL initialisation failed: {}", SDL_GetError());
+        return 1;
+    }
+
+    const Uint32 window_type = (backend == Backend::OpenGL) ? SDL_WINDOW_OPENGL : 0;
+    SDL_Window *window = SDL_CreateWindow("renderer-replay", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+        static_cast<int>(DEFAULT_RES_WIDTH * header.res_multiplier), static_cast<int>(DEFAULT_RES_HEIGHT * header.res_multiplier), window_type | SDL_WINDOW_HIDDEN);
+    if (!window) {
+        LOG_ERROR("SDL failed to create window: {}", SDL_GetError());
+        return 1;
+    }
+
+    char *sdl_base_path = SDL_GetBasePath();
+    Root root_paths;
+    root_paths.set_base_path(fs_utils::utf8_to_path(sdl_base_path));
+    root_paths.set_static_assets_path(fs_utils::utf8_to_path(sdl_base_path));
+    SDL_free(sdl_base_path);
+    root_paths.set_pref_path(cache_path);
+    root_paths.set_log_path(cache_path);
+    root_paths.set_shared_path(cache_path);
+    root_paths.set_cache_path(cache_path);
+    fs::create_directories(cache_path);
+
+    std::unique_ptr<State> state;
+    if (!renderer::init(window, state, backend, config, root_paths)) {
+        LOG_ERROR("Could not initialise the renderer");
+        return 1;
+    }
+
+    MemState mem;
+    state->late_init(config, "REPLAY", mem);
+    if (!::init(mem, state->need_page_table) || mem.page_size != header.page_size) {
+        LOG_ERROR("Could not initialise the guest memory with {} bytes pages", header.page_size);
+        return 1;
+    }
+
+    state->set_app("REPLAY", trace_path.stem().string().c_str());
+    state->res_multiplier = header.res_multiplier;
+    state->set_surface_sync_state(config.current_config.disable_surface_sync);
+    state->set_screen_filter(config.current_config.screen_filter);
+    state->set_anisotropic_filtering(config.current_config.anisotropic_filtering);
+    state->set_stretch_display(false);
+    state->stretch_hd_pixel_perfect(false);
+    state->set_async_compilation(config.current_config.async_pipeline_compilation);
+    if (backend == Backend::OpenGL)
+        SDL_GL_SetSwapInterval(0);
+
+    Replayer replayer(*state, mem, config, window);
+    const bool complete = replayer.run(file, max_frames);
+    if (!complete)
+        LOG_WARN("The trace is truncated, stopping the replay");
+
+    print_report(replayer.frames, csv_path);
+
+    state->preclose_action();
+    state.reset();
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+
+    return 0;
+}
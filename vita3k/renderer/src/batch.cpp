@@ -90,6 +90,10 @@ static void process_batch(renderer::State &state, const FeatureState &features,
         { CommandOpcode::DestroyContext, cmd_handle_destroy_context }
     };
 
+    trace::Writer *const trace = state.trace.get();
+    if (trace)
+        trace->begin_batch(state, mem, command_list);
+
     Command *cmd = command_list.first;
 
     // Take a batch, and execute it. Hope it's not too large
@@ -103,7 +107,13 @@ static void process_batch(renderer::State &state, const FeatureState &features,
             LOG_ERROR("Unimplemented command opcode {}", static_cast<int>(cmd->opcode));
         } else {
             CommandHelper helper(cmd);
+            if (trace)
+                trace->begin_command(mem, *cmd, command_list.context);
+
             handler->second(state, mem, config, helper, features, command_list.context);
+
+            if (trace)
+                trace->end_command(*cmd);
         }
 
         Command *last_cmd = cmd;
@@ -117,6 +127,10 @@ static void process_batch(renderer::State &state, const FeatureState &features,
     } while (true);
 }
 
+void process_batch(renderer::State &state, MemState &mem, Config &config, CommandList &command_list) {
+    process_batch(state, state.features, mem, config, command_list);
+}
+
 void process_batches(renderer::State &state, const FeatureState &features, MemState &mem, Config &config) {
     while (!state.should_display) {
         // Try to wait for a batch (about 2 or 3ms, game should be fast for this)
@@ -190,6 +190,9 @@ bool create(std::unique_ptr<FragmentProgram> &fp, State &state, const SceGxmProg
         return false;
     }
 
+    if (blend)
+        fp->blend = *blend;
+
     // Try to hash this shader
     fp->hash = sha256(&program, program.size);
     gxp_ptr_map.emplace(fp->hash, &program);
@@ -272,10 +275,17 @@ bool init(SDL_Window *window, std::unique_ptr<State> &state, Backend backend, co
     }
 
     state->current_backend = backend;
+    state->features.optimize_spirv = config.optimize_shaders;
 
     // Can change this
     state->command_buffer_queue.maxPendingCount_ = 30;
 
+    if (config.gxm_trace_path) {
+        state->trace = std::make_unique<trace::Writer>();
+        if (!state->trace->open(fs_utils::utf8_to_path(*config.gxm_trace_path)))
+            state->trace.reset();
+    }
+
     return true;
 }
 } // namespace renderer
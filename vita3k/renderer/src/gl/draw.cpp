@@ -94,6 +94,7 @@ void draw(GLState &renderer, GLContext &context, const FeatureState &features, S
     }
 
     glUseProgram(program_id);
+    renderer.pipeline_bind_count++;
 
     const bool use_raw_image = renderer.features.preserve_f16_nan_as_u16 && color::is_write_surface_stored_rawly(gxm::get_base_format(context.record.color_surface.colorFormat));
 
@@ -82,6 +82,7 @@ COMMAND(handle_set_context) {
 
 COMMAND(handle_sync_surface_data) {
     TRACY_FUNC_COMMANDS(handle_sync_surface_data);
+    renderer.surface_sync_count++;
 
     const SceGxmNotification vertex_notification = helper.pop<SceGxmNotification>();
     const SceGxmNotification fragment_notification = helper.pop<SceGxmNotification>();
@@ -221,6 +222,7 @@ COMMAND(handle_draw) {
     Ptr<const void> indices = helper.pop<Ptr<const void>>();
     const std::uint32_t count = helper.pop<const std::uint32_t>();
     const std::uint32_t instance_count = helper.pop<const std::uint32_t>();
+    renderer.draw_count++;
 
     switch (renderer.current_backend) {
     case Backend::OpenGL:
@@ -742,6 +742,7 @@ void TextureCache::cache_and_bind_texture(const SceGxmTexture &gxm_texture, MemS
             import_upload_texture();
         else
             upload_texture(gxm_texture, mem);
+        upload_count++;
 
         if (!info->use_hash) {
             info->dirty = false;
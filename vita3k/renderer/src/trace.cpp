@@ -0,0 +1,348 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/trace.h>
+
+#include <renderer/state.h>
+#include <renderer/types.h>
+
+#include <display/state.h>
+#include <gxm/functions.h>
+#include <gxm/types.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <util/align.h>
+#include <util/log.h>
+
+#include <cstring>
+
+#if defined(__x86_64__) && !defined(__APPLE__)
+#include <xxh_x86dispatch.h>
+#else
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#endif
+
+namespace renderer::trace {
+
+template <typename T>
+static void write(fs::ofstream &file, const T &value) {
+    file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static uint32_t transfer_image_size(const SceGxmTransferImage &image) {
+    // tiled images are made of 32x32 tiles, take the whole last row of tiles
+    return image.stride * align(image.y + image.height, 32);
+}
+
+bool Writer::open(const fs::path &path) {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LOG_ERROR("Could not open the GXM trace file {}", path);
+        return false;
+    }
+
+    LOG_INFO("Recording GXM trace to {}", path);
+    return true;
+}
+
+void Writer::begin_batch(const State &state, MemState &mem, const CommandList &command_list) {
+    if (!memory_captured) {
+        memory_captured = true;
+        page_size = mem.page_size;
+        page_hashes.assign((uint64_t(1) << 32) / page_size, 0);
+
+        const FileHeader header = {
+            .magic = MAGIC,
+            .version = VERSION,
+            .backend = static_cast<uint32_t>(state.current_backend),
+            .page_size = page_size,
+            .res_multiplier = state.res_multiplier
+        };
+        write(file, header);
+
+        capture_all_pages(mem);
+    }
+
+    write(file, RecordType::Batch);
+    write(file, BatchRecord{ reinterpret_cast<uint64_t>(command_list.context) });
+}
+
+static bool can_capture(MemState &mem, Address address) {
+    if (!is_valid_addr(mem, address))
+        return false;
+
+    // reading it would trigger the protection callbacks and change what the app is doing
+    MemPerm perm;
+    return !is_protecting(mem, address, &perm) || perm != MemPerm::None;
+}
+
+void Writer::capture_page(MemState &mem, uint32_t page) {
+    const Address address = page * page_size;
+    const uint8_t *data = Ptr<const uint8_t>(address).get(mem);
+
+    uint64_t hash = XXH3_64bits(data, page_size);
+    // 0 means the page was never written
+    hash += (hash == 0);
+    if (page_hashes[page] == hash)
+        return;
+
+    page_hashes[page] = hash;
+    write(file, RecordType::Memory);
+    write(file, MemoryRecord{ address, page_size });
+    file.write(reinterpret_cast<const char *>(data), page_size);
+}
+
+void Writer::capture_range(MemState &mem, Address address, uint32_t size) {
+    if (size == 0)
+        return;
+
+    const uint32_t first_page = address / page_size;
+    const uint32_t last_page = static_cast<uint32_t>((static_cast<uint64_t>(address) + size - 1) / page_size);
+    for (uint32_t page = first_page; page <= last_page && page < page_hashes.size(); page++) {
+        if (can_capture(mem, page * page_size))
+            capture_page(mem, page);
+    }
+}
+
+void Writer::capture_all_pages(MemState &mem) {
+    for (uint32_t page = 1; page < page_hashes.size(); page++) {
+        if (can_capture(mem, page * page_size))
+            capture_page(mem, page);
+    }
+}
+
+void Writer::capture_program(MemState &mem, Address gxm_program, bool is_fragment) {
+    if (is_fragment) {
+        const SceGxmFragmentProgram *fp = Ptr<const SceGxmFragmentProgram>(gxm_program).get(mem);
+        const void *&captured = captured_programs[gxm_program];
+        if (captured == fp->renderer_data.get())
+            return;
+        captured = fp->renderer_data.get();
+
+        capture_range(mem, fp->program.address(), fp->program.get(mem)->size);
+
+        FragmentProgramRecord record = {
+            .gxm_program = gxm_program,
+            .program = fp->program.address(),
+            .is_maskupdate = fp->is_maskupdate,
+            .has_blend = fp->renderer_data->blend.has_value(),
+            .blend = 0
+        };
+        if (fp->renderer_data->blend)
+            memcpy(&record.blend, &*fp->renderer_data->blend, sizeof(record.blend));
+
+        write(file, RecordType::FragmentProgram);
+        write(file, record);
+    } else {
+        const SceGxmVertexProgram *vp = Ptr<const SceGxmVertexProgram>(gxm_program).get(mem);
+        const void *&captured = captured_programs[gxm_program];
+        if (captured == vp->renderer_data.get())
+            return;
+        captured = vp->renderer_data.get();
+
+        capture_range(mem, vp->program.address(), vp->program.get(mem)->size);
+
+        const VertexProgramRecord record = {
+            .gxm_program = gxm_program,
+            .program = vp->program.address(),
+            .key_hash = vp->key_hash,
+            .stream_count = static_cast<uint32_t>(vp->streams.size()),
+            .attribute_count = static_cast<uint32_t>(vp->attributes.size())
+        };
+        write(file, RecordType::VertexProgram);
+        write(file, record);
+        file.write(reinterpret_cast<const char *>(vp->streams.data()), vp->streams.size() * sizeof(SceGxmVertexStream));
+        file.write(reinterpret_cast<const char *>(vp->attributes.data()), vp->attributes.size() * sizeof(SceGxmVertexAttribute));
+    }
+}
+
+void Writer::begin_command(MemState &mem, const Command &cmd, const Context *context) {
+    pending = {};
+    pending.opcode = cmd.opcode;
+    pending.flags = cmd.flags;
+    pending.has_status = cmd.status != nullptr;
+    memcpy(pending.data, cmd.data, sizeof(pending.data));
+    payload.clear();
+
+    // work on a copy so that the handler can still pop the arguments
+    Command cmd_copy = cmd;
+    CommandHelper helper(&cmd_copy);
+
+    switch (cmd.opcode) {
+    case CommandOpcode::DestroyContext: {
+        const uint64_t id = reinterpret_cast<uint64_t>(helper.pop<std::unique_ptr<Context> *>()->get());
+        push_payload(&id);
+        break;
+    }
+
+    case CommandOpcode::CreateRenderTarget:
+        helper.pop<std::unique_ptr<RenderTarget> *>();
+        push_payload(helper.pop<SceGxmRenderTargetParams *>());
+        break;
+
+    case CommandOpcode::DestroyRenderTarget: {
+        const uint64_t id = reinterpret_cast<uint64_t>(helper.pop<std::unique_ptr<RenderTarget> *>()->get());
+        push_payload(&id);
+        break;
+    }
+
+    case CommandOpcode::SetContext: {
+        helper.pop<RenderTarget *>();
+        const SceGxmColorSurface *color_surface = helper.pop<SceGxmColorSurface *>();
+        const SceGxmDepthStencilSurface *depth_stencil_surface = helper.pop<SceGxmDepthStencilSurface *>();
+        if (color_surface) {
+            // the scene may load what the CPU wrote there
+            const size_t stride = gxm::get_stride_in_bytes(color_surface->colorFormat, color_surface->strideInPixels);
+            capture_range(mem, color_surface->data.address(), static_cast<uint32_t>(stride * color_surface->height));
+            push_payload(color_surface);
+        }
+        if (depth_stencil_surface)
+            push_payload(depth_stencil_surface);
+        break;
+    }
+
+    case CommandOpcode::SyncSurfaceData:
+        if (cmd.status) {
+            helper.pop<SceGxmNotification>();
+            helper.pop<SceGxmNotification>();
+            const SceGxmColorSurface *surface = helper.pop<SceGxmColorSurface *>();
+            if (surface)
+                push_payload(surface);
+        }
+        break;
+
+    case CommandOpcode::Draw: {
+        helper.pop<SceGxmPrimitiveType>();
+        const SceGxmIndexFormat format = helper.pop<SceGxmIndexFormat>();
+        const Ptr<const void> indices = helper.pop<Ptr<const void>>();
+        const uint32_t count = helper.pop<uint32_t>();
+
+        const uint32_t index_size = (format == SCE_GXM_INDEX_FORMAT_U16) ? 2 : 4;
+        capture_range(mem, indices.address(), count * index_size);
+        if (context) {
+            for (const GXMStreamInfo &stream : context->record.vertex_streams)
+                capture_range(mem, stream.data.address(), static_cast<uint32_t>(stream.size));
+        }
+        break;
+    }
+
+    case CommandOpcode::TransferCopy: {
+        helper.pop<uint32_t>();
+        helper.pop<uint32_t>();
+        helper.pop<SceGxmTransferColorKeyMode>();
+        const SceGxmTransferImage *images = helper.pop<SceGxmTransferImage *>();
+        capture_range(mem, images[0].address.address(), transfer_image_size(images[0]));
+        push_payload(images, 2);
+        break;
+    }
+
+    case CommandOpcode::TransferDownscale: {
+        const SceGxmTransferImage *src = helper.pop<SceGxmTransferImage *>();
+        const SceGxmTransferImage *dst = helper.pop<SceGxmTransferImage *>();
+        capture_range(mem, src->address.address(), transfer_image_size(*src));
+        push_payload(src);
+        push_payload(dst);
+        break;
+    }
+
+    case CommandOpcode::TransferFill:
+        helper.pop<uint32_t>();
+        push_payload(helper.pop<SceGxmTransferImage *>());
+        break;
+
+    case CommandOpcode::NewFrame: {
+        const DisplayFrameInfo *next_frame = helper.pop<DisplayFrameInfo *>();
+        if (next_frame) {
+            // the frame displayed may have been drawn by the CPU, both display pixel formats use 4 bytes per pixel
+            capture_range(mem, next_frame->base.address(), next_frame->pitch * next_frame->image_size.y * 4);
+            push_payload(next_frame);
+        }
+        file.flush();
+        break;
+    }
+
+    case CommandOpcode::SetState:
+        switch (helper.pop<GXMState>()) {
+        case GXMState::Program: {
+            const Ptr<void> program = helper.pop<Ptr<void>>();
+            const bool is_fragment = helper.pop<bool>();
+            capture_program(mem, program.address(), is_fragment);
+            break;
+        }
+
+        case GXMState::UniformBuffer: {
+            const Ptr<uint8_t> data = helper.pop<Ptr<uint8_t>>();
+            helper.pop<bool>();
+            helper.pop<int>();
+            capture_range(mem, data.address(), helper.pop<uint32_t>());
+            break;
+        }
+
+        case GXMState::Texture: {
+            helper.pop<uint32_t>();
+            const SceGxmTexture texture = helper.pop<SceGxmTexture>();
+            uint32_t size = gxm::texture_size_first_mip(texture);
+            // the whole mip chain is less than a third larger than the first level
+            if (texture.true_mip_count() > 1)
+                size += size / 3;
+            capture_range(mem, texture.data_addr << 2, size);
+
+            if (gxm::is_paletted_format(gxm::get_base_format(gxm::get_format(texture))))
+                capture_range(mem, texture.palette_addr << 6, 256 * sizeof(uint32_t));
+            break;
+        }
+
+        default:
+            break;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Writer::end_command(const Command &cmd) {
+    Command cmd_copy = cmd;
+    CommandHelper helper(&cmd_copy);
+
+    // the replay needs to know which object the following commands refer to
+    switch (cmd.opcode) {
+    case CommandOpcode::CreateContext: {
+        const uint64_t id = reinterpret_cast<uint64_t>(helper.pop<std::unique_ptr<Context> *>()->get());
+        push_payload(&id);
+        break;
+    }
+
+    case CommandOpcode::CreateRenderTarget: {
+        const uint64_t id = reinterpret_cast<uint64_t>(helper.pop<std::unique_ptr<RenderTarget> *>()->get());
+        push_payload(&id);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    pending.payload_size = static_cast<uint32_t>(payload.size());
+    write(file, RecordType::Command);
+    write(file, pending);
+    file.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+}
+
+} // namespace renderer::trace
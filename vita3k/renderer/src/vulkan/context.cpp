@@ -559,8 +559,11 @@ void new_frame(VKContext &context) {
     }
     frame.color_descriptor.descriptors_idx = 0;
 
-    // deferred destruction of the objects
-    frame.destroy_queue.destroy_objects();
+    // deferred destruction of the objects, new ones may get the same handles as the image views and samplers destroyed
+    std::vector<uint64_t> destroyed_views;
+    frame.destroy_queue.destroy_objects(&destroyed_views);
+    if (!destroyed_views.empty())
+        context.state.descriptor_cache.forget(destroyed_views);
 
     context.last_vert_texture_count = ~0;
     context.last_frag_texture_count = ~0;
@@ -0,0 +1,194 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/vulkan/descriptor_cache.h>
+
+#include <renderer/vulkan/state.h>
+
+#include <xxh3.h>
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace renderer::vulkan {
+
+static uint64_t hash_images(std::span<const vk::DescriptorImageInfo> images) {
+    // hashing the structures would include their padding
+    std::array<uint64_t, 16 * 3> fields;
+    for (size_t i = 0; i < images.size(); i++) {
+        fields[i * 3] = std::bit_cast<uint64_t>(images[i].sampler);
+        fields[i * 3 + 1] = std::bit_cast<uint64_t>(images[i].imageView);
+        fields[i * 3 + 2] = static_cast<uint64_t>(images[i].imageLayout);
+    }
+    // 0 is kept for the sets with nothing written
+    return XXH_INLINE_XXH3_64bits(fields.data(), images.size() * 3 * sizeof(uint64_t)) | 1;
+}
+
+static bool same_images(std::span<const vk::DescriptorImageInfo> images, const std::array<vk::DescriptorImageInfo, 16> &cached) {
+    for (size_t i = 0; i < images.size(); i++) {
+        if (images[i].sampler != cached[i].sampler || images[i].imageView != cached[i].imageView || images[i].imageLayout != cached[i].imageLayout)
+            return false;
+    }
+    return true;
+}
+
+DescriptorSetCache::DescriptorSetCache(VKState &state)
+    : state(state) {
+}
+
+void DescriptorSetCache::init_layout(LayoutCache &cache, bool is_vertex, uint32_t textures_count) {
+    vk::DescriptorPoolSize pool_size{
+        .type = vk::DescriptorType::eCombinedImageSampler,
+        .descriptorCount = textures_count * CACHE_SIZE
+    };
+
+    vk::DescriptorPoolCreateInfo descriptor_pool_info{
+        .maxSets = CACHE_SIZE
+    };
+    descriptor_pool_info.setPoolSizes(pool_size);
+
+    vk::DescriptorPool descriptor_pool = state.device.createDescriptorPool(descriptor_pool_info);
+    state.frame_descriptor_pools.push_back(descriptor_pool);
+
+    const vk::DescriptorSetLayout set_layout = is_vertex ? state.pipeline_cache.vertex_textures_layout[textures_count] : state.pipeline_cache.fragment_textures_layout[textures_count];
+    std::vector<vk::DescriptorSetLayout> layouts(CACHE_SIZE, set_layout);
+    vk::DescriptorSetAllocateInfo descr_set_info{
+        .descriptorPool = descriptor_pool
+    };
+    descr_set_info.setSetLayouts(layouts);
+    const auto descriptor_sets = state.device.allocateDescriptorSets(descr_set_info);
+
+    cache.queue.init(CACHE_SIZE);
+    for (uint32_t i = 0; i < CACHE_SIZE; i++)
+        cache.queue.items[i].content.set = descriptor_sets[i];
+    cache.is_init = true;
+}
+
+template <typename F>
+static void for_each_handle(const std::array<vk::DescriptorImageInfo, 16> &images, uint32_t count, F &&f) {
+    std::array<uint64_t, 16 * 2> handles;
+    for (uint32_t i = 0; i < count; i++) {
+        handles[i * 2] = std::bit_cast<uint64_t>(images[i].sampler);
+        handles[i * 2 + 1] = std::bit_cast<uint64_t>(images[i].imageView);
+    }
+    // the same handle can be bound several times
+    const auto end = handles.begin() + count * 2;
+    std::sort(handles.begin(), end);
+    std::for_each(handles.begin(), std::unique(handles.begin(), end), [&](uint64_t handle) {
+        if (handle)
+            f(handle);
+    });
+}
+
+void DescriptorSetCache::index_handles(LayoutCache &cache, Entry &entry) {
+    for_each_handle(entry.images, entry.images_count, [&](uint64_t handle) {
+        entries_by_handle[handle].emplace_back(&cache, &entry);
+    });
+}
+
+void DescriptorSetCache::drop(LayoutCache &cache, Entry &entry) {
+    if (entry.hash == 0)
+        return;
+
+    // another entry with the same hash may have replaced this one
+    auto it = cache.entries.find(entry.hash);
+    if (it != cache.entries.end() && it->second == &entry)
+        cache.entries.erase(it);
+    entry.hash = 0;
+
+    for_each_handle(entry.images, entry.images_count, [&](uint64_t handle) {
+        auto indexed = entries_by_handle.find(handle);
+        if (indexed == entries_by_handle.end())
+            return;
+        std::erase(indexed->second, std::make_pair(&cache, &entry));
+        if (indexed->second.empty())
+            entries_by_handle.erase(indexed);
+    });
+}
+
+vk::DescriptorSet DescriptorSetCache::get(bool is_vertex, std::span<const vk::DescriptorImageInfo> images, uint64_t frame_timestamp) {
+    LayoutCache &cache = is_vertex ? vertex_caches[images.size() - 1] : fragment_caches[images.size() - 1];
+    if (!cache.is_init)
+        init_layout(cache, is_vertex, static_cast<uint32_t>(images.size()));
+
+    const uint64_t hash = hash_images(images);
+    auto it = cache.entries.find(hash);
+    if (it != cache.entries.end() && same_images(images, it->second->images)) {
+        Entry *entry = it->second;
+        entry->last_used_frame = frame_timestamp;
+        cache.queue.set_as_mru(entry);
+        state.descriptor_set_hits++;
+        return entry->set;
+    }
+    state.descriptor_set_misses++;
+
+    Entry *entry = cache.queue.get_lru();
+    // every set is in use by a frame still being rendered
+    if (entry->last_used_frame != 0 && entry->last_used_frame + MAX_FRAMES_RENDERING > frame_timestamp)
+        return nullptr;
+
+    drop(cache, *entry);
+    write(entry->set, images);
+    entry->hash = hash;
+    std::copy(images.begin(), images.end(), entry->images.begin());
+    entry->images_count = static_cast<uint32_t>(images.size());
+    index_handles(cache, *entry);
+    entry->last_used_frame = frame_timestamp;
+    // on a hash collision, the entry found first is replaced
+    cache.entries[hash] = entry;
+    cache.queue.set_as_mru(entry);
+
+    return entry->set;
+}
+
+void DescriptorSetCache::write(vk::DescriptorSet set, std::span<const vk::DescriptorImageInfo> images) {
+    std::array<vk::WriteDescriptorSet, 16> write_descrs;
+    for (uint32_t i = 0; i < images.size(); i++) {
+        write_descrs[i] = vk::WriteDescriptorSet{
+            .dstSet = set,
+            .dstBinding = i,
+            .dstArrayElement = 0,
+            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        };
+        write_descrs[i].setImageInfo(images[i]);
+    }
+    state.device.updateDescriptorSets(static_cast<uint32_t>(images.size()), write_descrs.data(), 0, nullptr);
+    state.descriptor_writes += images.size();
+}
+
+void DescriptorSetCache::forget(vk::Sampler sampler) {
+    const uint64_t handle = std::bit_cast<uint64_t>(sampler);
+    forget(std::span(&handle, 1));
+}
+
+void DescriptorSetCache::forget(std::span<const uint64_t> handles) {
+    for (const uint64_t handle : handles) {
+        const auto indexed = entries_by_handle.find(handle);
+        if (indexed == entries_by_handle.end())
+            continue;
+
+        // dropping the entries removes them from the index
+        const std::vector<std::pair<LayoutCache *, Entry *>> entries = std::move(indexed->second);
+        entries_by_handle.erase(indexed);
+        // their sets are rewritten once they become the least recently used ones
+        for (const auto &[cache, entry] : entries)
+            drop(*cache, *entry);
+    }
+}
+
+} // namespace renderer::vulkan
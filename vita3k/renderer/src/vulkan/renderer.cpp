@@ -172,6 +172,7 @@ VKState::VKState(int gpu_idx)
     , surface_cache(*this)
     , pipeline_cache(*this)
     , texture_cache(*this)
+    , descriptor_cache(*this)
     , screen_renderer(*this) {
 }
 
@@ -193,15 +194,20 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
             .apiVersion = VK_API_VERSION_1_0
         };
 
-        unsigned int instance_req_ext_count;
-        if (!SDL_Vulkan_GetInstanceExtensions(window, &instance_req_ext_count, nullptr)) {
-            LOG_ERROR("Could not get required extensions");
-            return false;
-        }
-
         std::vector<const char *> instance_extensions;
-        instance_extensions.resize(instance_req_ext_count);
-        SDL_Vulkan_GetInstanceExtensions(window, &instance_req_ext_count, instance_extensions.data());
+        if (config.headless) {
+            // render to a headless surface, this also works with software drivers and without any display server
+            instance_extensions = { vk::KHRSurfaceExtensionName, vk::EXTHeadlessSurfaceExtensionName };
+        } else {
+            unsigned int instance_req_ext_count;
+            if (!SDL_Vulkan_GetInstanceExtensions(window, &instance_req_ext_count, nullptr)) {
+                LOG_ERROR("Could not get required extensions");
+                return false;
+            }
+
+            instance_extensions.resize(instance_req_ext_count);
+            SDL_Vulkan_GetInstanceExtensions(window, &instance_req_ext_count, instance_extensions.data());
+        }
 
         const std::set<std::string> optional_instance_extensions = {
             vk::KHRGetPhysicalDeviceProperties2ExtensionName,
@@ -295,7 +301,7 @@ bool VKState::create(SDL_Window *window, std::unique_ptr<renderer::State> &state
     }
 
     // Create Surface
-    if (!screen_renderer.create(window))
+    if (!screen_renderer.create(window, config.headless))
         return false;
 
     // Select Physical Device
@@ -763,6 +769,7 @@ uint32_t VKState::get_features_mask() {
             bool use_shader_interlock : 1;
             bool use_texture_viewport : 1;
             bool use_memory_mapping : 1;
+            bool optimize_spirv : 1;
         };
         uint32_t value;
     } features_mask;
@@ -772,6 +779,7 @@ uint32_t VKState::get_features_mask() {
     features_mask.use_shader_interlock = features.support_shader_interlock;
     features_mask.use_texture_viewport = features.use_texture_viewport;
     features_mask.use_memory_mapping = features.support_memory_mapping;
+    features_mask.optimize_spirv = features.optimize_spirv;
 
     return features_mask.value;
 }
@@ -821,6 +829,8 @@ bool VKState::map_memory(MemState &mem, Ptr<void> address, uint32_t size) {
 
         add_external_mapping(mem, address.address(), size, static_cast<uint8_t *>(buffer.mapped_data));
         mapped_memories[address.address()] = { address.address(), std::move(buffer), mapped_buffer, size, buffer_address };
+        if (!mapping_table.map({ address.address(), size, mapped_buffer, buffer_address }))
+            LOG_WARN_ONCE("Too many memory mappings, the ones over the limit are slower to look up");
     } else {
         void *host_address = address.get(mem);
         auto host_mem_props = device.getMemoryHostPointerPropertiesEXT(vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT, host_address);
@@ -881,6 +891,8 @@ bool VKState::map_memory(MemState &mem, Ptr<void> address, uint32_t size) {
         const uint64_t buffer_address = device.getBufferAddress(address_info);
 
         mapped_memories[address.address()] = { address.address(), device_memory, mapped_buffer, size, buffer_address };
+        if (!mapping_table.map({ address.address(), size, mapped_buffer, buffer_address }))
+            LOG_WARN_ONCE("Too many memory mappings, the ones over the limit are slower to look up");
     }
 
     return true;
@@ -904,10 +916,14 @@ void VKState::unmap_memory(MemState &mem, Ptr<void> address) {
     } else {
         remove_external_mapping(mem, address.cast<uint8_t>().get(mem));
     }
+    mapping_table.unmap(address.address());
     mapped_memories.erase(ite);
 }
 
 std::tuple<vk::Buffer, uint32_t> VKState::get_matching_mapping(const Ptr<void> address) {
+    if (const auto *mapping = mapping_table.find(address.address()))
+        return std::make_tuple(mapping->buffer, address.address() - mapping->address);
+
     auto mapped_memory = mapped_memories.lower_bound(address.address());
     if (mapped_memory == mapped_memories.end()
         || mapped_memory->first + mapped_memory->second.size < address.address()) {
@@ -919,6 +935,9 @@ std::tuple<vk::Buffer, uint32_t> VKState::get_matching_mapping(const Ptr<void> a
 }
 
 uint64_t VKState::get_matching_device_address(const Address address) {
+    if (const auto *mapping = mapping_table.find(address))
+        return mapping->device_address + address - mapping->address;
+
     auto mapped_memory = mapped_memories.lower_bound(address);
     if (mapped_memory == mapped_memories.end()
         || mapped_memory->first + mapped_memory->second.size < address) {
@@ -179,20 +179,6 @@ static void draw_bind_descriptors(VKContext &context, MemState &mem) {
     context.last_vert_texture_count = vertex_textures_count;
     context.last_frag_texture_count = fragment_texture_count;
 
-    {
-        if (need_vert_descr) {
-            context.last_vert_texture_descriptor = retrieve_descriptor(context, true, vertex_textures_count);
-        }
-        descriptors[2] = context.last_vert_texture_descriptor;
-
-        if (need_frag_descr) {
-            context.last_frag_texture_descriptor = retrieve_descriptor(context, false, fragment_texture_count);
-        }
-        descriptors[3] = context.last_frag_texture_descriptor;
-    }
-
-    // bind textures
-    std::array<vk::WriteDescriptorSet, 16> write_descrs;
     // some default sampler in case a slot has never been set and we read a slot with higher idx
     vk::DescriptorImageInfo default_image_info{
         .sampler = context.state.default_image.sampler,
@@ -200,33 +186,33 @@ static void draw_bind_descriptors(VKContext &context, MemState &mem) {
         .imageLayout = vk::ImageLayout::eGeneral
     };
 
-    // vertex
-    if (need_vert_descr) {
-        for (uint32_t i = 0; i < vertex_textures_count; i++) {
-            write_descrs[i] = vk::WriteDescriptorSet{
-                .dstSet = descriptors[2],
-                .dstBinding = i,
-                .dstArrayElement = 0,
-                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-            };
-            write_descrs[i].setImageInfo(context.vertex_textures[i].sampler ? context.vertex_textures[i] : default_image_info);
+    const auto bind_textures = [&](bool is_vertex, uint16_t textures_count, const vk::DescriptorImageInfo *textures) {
+        if (textures_count == 0)
+            return context.empty_set;
+
+        std::array<vk::DescriptorImageInfo, 16> images;
+        for (uint32_t i = 0; i < textures_count; i++)
+            images[i] = textures[i].sampler ? textures[i] : default_image_info;
+        const std::span<const vk::DescriptorImageInfo> bound_images(images.data(), textures_count);
+
+        vk::DescriptorSet set = state.descriptor_cache.get(is_vertex, bound_images, context.frame_timestamp);
+        if (!set) {
+            // all the cached sets may still be in use, write one for this frame only
+            set = retrieve_descriptor(context, is_vertex, textures_count);
+            state.descriptor_cache.write(set, bound_images);
         }
-        state.device.updateDescriptorSets(vertex_textures_count, write_descrs.data(), 0, nullptr);
+        return set;
+    };
+
+    if (need_vert_descr) {
+        context.last_vert_texture_descriptor = bind_textures(true, vertex_textures_count, context.vertex_textures);
     }
+    descriptors[2] = context.last_vert_texture_descriptor;
 
-    // fragment
     if (need_frag_descr) {
-        for (uint32_t i = 0; i < fragment_texture_count; i++) {
-            write_descrs[i] = vk::WriteDescriptorSet{
-                .dstSet = descriptors[3],
-                .dstBinding = i,
-                .dstArrayElement = 0,
-                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-            };
-            write_descrs[i].setImageInfo(context.fragment_textures[i].sampler ? context.fragment_textures[i] : default_image_info);
-        }
-        state.device.updateDescriptorSets(fragment_texture_count, write_descrs.data(), 0, nullptr);
+        context.last_frag_texture_descriptor = bind_textures(false, fragment_texture_count, context.fragment_textures);
     }
+    descriptors[3] = context.last_frag_texture_descriptor;
 
     const uint32_t dynamic_offset_count = state.features.support_memory_mapping ? 2U : 4U;
     const uint32_t dynamic_offsets[] = {
@@ -373,8 +359,10 @@ void draw(VKContext &context, SceGxmPrimitiveType type, SceGxmIndexFormat format
         if (new_pipeline != context.current_pipeline) {
             context.current_pipeline = new_pipeline;
 
-            if (new_pipeline != nullptr)
+            if (new_pipeline != nullptr) {
                 context.render_cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, context.current_pipeline);
+                context.state.pipeline_bind_count++;
+            }
         }
     }
 
@@ -29,7 +29,19 @@ ScreenRenderer::ScreenRenderer(VKState &state)
     : state(state) {
 }
 
-bool ScreenRenderer::create(SDL_Window *window) {
+bool ScreenRenderer::create(SDL_Window *window, bool headless) {
+    this->window = window;
+
+    if (headless) {
+        try {
+            this->surface = state.instance.createHeadlessSurfaceEXT(vk::HeadlessSurfaceCreateInfoEXT{});
+        } catch (vk::SystemError &err) {
+            LOG_ERROR("Failed to create headless vulkan surface: {}.", err.what());
+            return false;
+        }
+        return true;
+    }
+
     VkSurfaceKHR surface = VK_NULL_HANDLE;
     bool surface_error = SDL_Vulkan_CreateSurface(window, state.instance, &surface);
     if (!surface_error) {
@@ -37,7 +49,6 @@ bool ScreenRenderer::create(SDL_Window *window) {
         LOG_ERROR("Failed to create vulkan surface. SDL Error: {}.", error);
         return false;
     }
-    this->window = window;
     this->surface = vk::SurfaceKHR(surface);
 
     return true;
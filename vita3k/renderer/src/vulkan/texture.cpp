@@ -482,6 +482,7 @@ void VKTextureCache::configure_sampler(size_t index, const SceGxmTexture &textur
     vk::Sampler &sampler = samplers[index];
     if (sampler) {
         // the previous one has not been used for a while, we can destroy it
+        state.descriptor_cache.forget(sampler);
         state.device.destroy(sampler);
     }
 
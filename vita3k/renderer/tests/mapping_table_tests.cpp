@@ -0,0 +1,281 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/vulkan/mapping_table.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <set>
+
+using namespace renderer::vulkan;
+
+namespace {
+
+constexpr uint32_t PAGE = 4096;
+
+using Table = MappingTable<uint64_t>;
+using Mapping = Table::Mapping;
+
+// The lookup the table replaces
+struct ReferenceMappings {
+    std::map<Address, Mapping, std::greater<Address>> mappings;
+
+    const Mapping *find(Address address) const {
+        auto it = mappings.lower_bound(address);
+        if (it == mappings.end() || it->first + it->second.size < address)
+            return nullptr;
+        return &it->second;
+    }
+
+    bool shares_page(Address address) const {
+        const uint64_t page_start = address & ~uint64_t(PAGE - 1);
+        int count = 0;
+        for (const auto &[start, mapping] : mappings)
+            count += (start < page_start + PAGE && start + uint64_t(mapping.size) > page_start);
+        return count > 1;
+    }
+};
+
+void expect_same(const Table &table, const ReferenceMappings &reference, Address address) {
+    const Mapping *expected = reference.find(address);
+    const Mapping *found = table.find(address);
+    // pages shared by several mappings are not in the table
+    if (!found && reference.shares_page(address))
+        return;
+    ASSERT_EQ(found != nullptr, expected != nullptr) << std::hex << address;
+    if (expected) {
+        EXPECT_EQ(found->address, expected->address) << std::hex << address;
+        EXPECT_EQ(found->buffer, expected->buffer) << std::hex << address;
+    }
+}
+
+} // namespace
+
+TEST(mapping_table, finds_mappings) {
+    Table table;
+    EXPECT_EQ(table.find(0x81000000), nullptr);
+
+    ASSERT_TRUE(table.map({ 0x81000000, 3 * PAGE, 1, 0x1000000 }));
+    ASSERT_TRUE(table.map({ 0x81003000, PAGE - 16, 2, 0x2000000 }));
+
+    EXPECT_EQ(table.find(0x80FFFFFF), nullptr);
+    EXPECT_EQ(table.find(0x81000000)->buffer, 1u);
+    EXPECT_EQ(table.find(0x81002FFF)->buffer, 1u);
+    // the end of the first mapping is the start of the second
+    EXPECT_EQ(table.find(0x81003000)->buffer, 2u);
+    EXPECT_EQ(table.find(0x81003FF0)->buffer, 2u);
+    EXPECT_EQ(table.find(0x81003FF1), nullptr);
+
+    table.unmap(0x81003000);
+    // now only the end of the first mapping
+    EXPECT_EQ(table.find(0x81003000)->buffer, 1u);
+    EXPECT_EQ(table.find(0x81003001), nullptr);
+
+    // the top of the address space
+    ASSERT_TRUE(table.map({ 0xFFFF0000, 0x10000, 3, 0 }));
+    EXPECT_EQ(table.find(0xFFFFFFFF)->buffer, 3u);
+}
+
+TEST(mapping_table, rejects_mappings_over_the_limit) {
+    MappingTable<uint64_t, 2> table;
+    ASSERT_TRUE(table.map({ 0x81000000, PAGE, 1, 0 }));
+    ASSERT_TRUE(table.map({ 0x82000000, PAGE, 2, 0 }));
+    EXPECT_FALSE(table.map({ 0x83000000, PAGE, 3, 0 }));
+    EXPECT_EQ(table.find(0x83000000), nullptr);
+
+    // unmapping frees a slot
+    table.unmap(0x81000000);
+    ASSERT_TRUE(table.map({ 0x83000000, PAGE, 3, 0 }));
+    EXPECT_EQ(table.find(0x83000000)->buffer, 3u);
+    EXPECT_EQ(table.find(0x81000000), nullptr);
+}
+
+TEST(mapping_table, ignores_empty_mappings) {
+    MappingTable<uint64_t, 1> table;
+    ASSERT_TRUE(table.map({ 0, 0, 1, 0 }));
+    ASSERT_TRUE(table.map({ 0x81000000, 0, 2, 0 }));
+    EXPECT_EQ(table.find(0), nullptr);
+    EXPECT_EQ(table.find(0x81000000), nullptr);
+    table.unmap(0);
+    table.unmap(0x81000000);
+
+    // they did not use the only slot
+    ASSERT_TRUE(table.map({ 0x82000000, PAGE, 3, 0 }));
+    EXPECT_EQ(table.find(0x82000000)->buffer, 3u);
+}
+
+TEST(mapping_table, replaces_a_mapping_at_the_same_address) {
+    MappingTable<uint64_t, 2> table;
+    ASSERT_TRUE(table.map({ 0x82000000, PAGE, 1, 0 }));
+    // remapping many times reuses the slot of the previous mapping
+    for (uint64_t buffer = 2; buffer < 10; buffer++) {
+        ASSERT_TRUE(table.map({ 0x81000000, (buffer % 3 + 1) * PAGE, buffer, 0 }));
+        EXPECT_EQ(table.find(0x81000000)->buffer, buffer);
+    }
+    // the pages of a larger previous mapping are not kept
+    ASSERT_TRUE(table.map({ 0x81000000, PAGE, 10, 0 }));
+    EXPECT_EQ(table.find(0x81000800)->buffer, 10u);
+    EXPECT_EQ(table.find(0x81001800), nullptr);
+    EXPECT_EQ(table.find(0x82000000)->buffer, 1u);
+
+    // an empty mapping removes the previous one
+    ASSERT_TRUE(table.map({ 0x81000000, 0, 11, 0 }));
+    EXPECT_EQ(table.find(0x81000800), nullptr);
+    ASSERT_TRUE(table.map({ 0x83000000, PAGE, 12, 0 }));
+    EXPECT_EQ(table.find(0x83000000)->buffer, 12u);
+}
+
+TEST(mapping_table, handles_mappings_sharing_a_page) {
+    MappingTable<uint64_t, 2> table;
+    // the first mapping ends and the second one starts in the middle of the page at 0x81001000
+    ASSERT_TRUE(table.map({ 0x81000000, PAGE + 0x800, 1, 0 }));
+    ASSERT_TRUE(table.map({ 0x81001900, PAGE, 2, 0 }));
+
+    EXPECT_EQ(table.find(0x81000FFF)->buffer, 1u);
+    EXPECT_EQ(table.find(0x81002000)->buffer, 2u);
+    // the shared page is left to the caller lookup, it must never give the wrong mapping
+    EXPECT_EQ(table.find(0x81001004), nullptr);
+    EXPECT_EQ(table.find(0x81001900), nullptr);
+
+    // unmapping the second mapping, found through a page it shares, frees its slot
+    table.unmap(0x81001900);
+    ASSERT_TRUE(table.map({ 0x83000800, 16, 3, 0 }));
+    EXPECT_EQ(table.find(0x83000808)->buffer, 3u);
+    EXPECT_EQ(table.find(0x81002000), nullptr);
+    // and gives the shared page back to the first one
+    EXPECT_EQ(table.find(0x81001004)->buffer, 1u);
+    EXPECT_EQ(table.find(0x81001800)->buffer, 1u);
+    EXPECT_EQ(table.find(0x81001801), nullptr);
+}
+
+TEST(mapping_table, keeps_pages_of_a_neighbour_when_unmapping) {
+    Table table;
+    // three mappings in one page and one going on to the next pages
+    ASSERT_TRUE(table.map({ 0x81000000, 0x100, 1, 0 }));
+    ASSERT_TRUE(table.map({ 0x81000200, 0x100, 2, 0 }));
+    ASSERT_TRUE(table.map({ 0x81000400, 3 * PAGE, 3, 0 }));
+
+    table.unmap(0x81000000);
+    EXPECT_EQ(table.find(0x81000000), nullptr);
+    EXPECT_EQ(table.find(0x81001000)->buffer, 3u);
+    EXPECT_EQ(table.find(0x81003400)->buffer, 3u);
+
+    table.unmap(0x81000200);
+    // the first page only belongs to the last mapping now
+    EXPECT_EQ(table.find(0x81000400)->buffer, 3u);
+    EXPECT_EQ(table.find(0x810003FF), nullptr);
+
+    table.unmap(0x81000400);
+    for (Address address = 0x81000000; address < 0x81005000; address += 0x100)
+        EXPECT_EQ(table.find(address), nullptr) << std::hex << address;
+}
+
+TEST(mapping_table, matches_map_lookup_on_random_mappings) {
+    std::mt19937 random(1234);
+    // a small window so that mappings end up next to each other
+    constexpr uint32_t WINDOW_PAGES = 512;
+    constexpr Address WINDOW_START = 0x81000000;
+
+    Table table;
+    ReferenceMappings reference;
+    std::set<uint32_t> used_pages;
+    uint64_t next_buffer = 1;
+
+    for (int step = 0; step < 4000; step++) {
+        const bool do_unmap = !reference.mappings.empty() && random() % 3 == 0;
+        if (do_unmap) {
+            auto it = reference.mappings.begin();
+            std::advance(it, random() % reference.mappings.size());
+            const Mapping mapping = it->second;
+            for (uint32_t page = 0; page * PAGE < mapping.size; page++)
+                used_pages.erase((mapping.address - WINDOW_START) / PAGE + page);
+            table.unmap(mapping.address);
+            reference.mappings.erase(it);
+        } else {
+            const uint32_t first_page = random() % WINDOW_PAGES;
+            const uint32_t page_count = 1 + random() % 8;
+            bool is_free = first_page + page_count <= WINDOW_PAGES;
+            for (uint32_t page = first_page; is_free && page < first_page + page_count; page++)
+                is_free = !used_pages.contains(page);
+            if (!is_free)
+                continue;
+
+            // some mappings do not end on a page
+            const uint32_t size = page_count * PAGE - (random() % 2 ? random() % PAGE : 0);
+            const Mapping mapping{ WINDOW_START + first_page * PAGE, size, next_buffer++, random() };
+            ASSERT_TRUE(table.map(mapping));
+            reference.mappings[mapping.address] = mapping;
+            for (uint32_t page = first_page; page < first_page + page_count; page++)
+                used_pages.insert(page);
+        }
+
+        for (const auto &[address, mapping] : reference.mappings) {
+            for (const Address probe : { address - 1, address, address + mapping.size - 1, address + mapping.size, address + mapping.size + 1 })
+                expect_same(table, reference, probe);
+        }
+        for (int i = 0; i < 32; i++)
+            expect_same(table, reference, WINDOW_START - PAGE + random() % ((WINDOW_PAGES + 2) * PAGE));
+        if (HasFailure())
+            return;
+    }
+}
+
+TEST(mapping_table, matches_map_lookup_on_random_unaligned_mappings) {
+    std::mt19937 random(5678);
+    constexpr uint32_t WINDOW_SIZE = 64 * PAGE;
+    constexpr Address WINDOW_START = 0x81000000;
+
+    Table table;
+    ReferenceMappings reference;
+    uint64_t next_buffer = 1;
+
+    for (int step = 0; step < 4000; step++) {
+        const bool do_unmap = !reference.mappings.empty() && random() % 3 == 0;
+        if (do_unmap) {
+            auto it = reference.mappings.begin();
+            std::advance(it, random() % reference.mappings.size());
+            table.unmap(it->first);
+            reference.mappings.erase(it);
+        } else {
+            // mappings of a few bytes to a few pages, starting and ending anywhere
+            const Address address = WINDOW_START + (random() % WINDOW_SIZE & ~0xFu);
+            const uint32_t size = 16 + random() % (random() % 2 ? 3 * PAGE : 0x400);
+            if (address + size > WINDOW_START + WINDOW_SIZE)
+                continue;
+            // the mappings are not allowed to overlap, touching is fine
+            const Mapping *before = reference.find(address);
+            const auto after = reference.mappings.lower_bound(address + size - 1);
+            if ((before && before->address + before->size > address) || (after != reference.mappings.end() && after->first >= address))
+                continue;
+
+            const Mapping mapping{ address, size, next_buffer++, random() };
+            ASSERT_TRUE(table.map(mapping));
+            reference.mappings[mapping.address] = mapping;
+        }
+
+        for (const auto &[address, mapping] : reference.mappings) {
+            for (const Address probe : { address - 1, address, address + mapping.size - 1, address + mapping.size, address + mapping.size + 1 })
+                expect_same(table, reference, probe);
+        }
+        for (int i = 0; i < 32; i++)
+            expect_same(table, reference, WINDOW_START - PAGE + random() % (WINDOW_SIZE + 2 * PAGE));
+        if (HasFailure())
+            return;
+    }
+}
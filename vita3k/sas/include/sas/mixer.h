@@ -0,0 +1,36 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+
+// SSE/NEON kernels of the grain mixer. Buffers hold float samples in the s16 range, stereo is interleaved.
+namespace sas::mixer {
+
+// dest += src * (left, right) for every mono frame of src
+void mix_mono(const float *src, float *dest, int frames, float left, float right);
+// dest += src * (left, right) for every stereo frame of src
+void mix_stereo(const float *src, float *dest, int frames, float left, float right);
+// Round and saturate samples to s16
+void to_s16(const float *src, int16_t *dest, int samples);
+// dest = saturate(dest * (left, right) + src) for every stereo frame
+void mix_s16(const float *src, int16_t *dest, int frames, float left, float right);
+// Largest absolute value of each channel of a stereo buffer, saturated to s16
+void peak(const float *src, int frames, int32_t &left, int32_t &right);
+
+} // namespace sas::mixer
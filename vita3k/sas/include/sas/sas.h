@@ -0,0 +1,221 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <codec/state.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ngs::dsp {
+struct Delay;
+struct Reverb;
+} // namespace ngs::dsp
+
+// Software implementation of libsas, the voice synthesizer inherited from the PSP. Voices play VAG/HE-VAG,
+// PCM or noise through an ADSR envelope at a given pitch, and everything is mixed one grain at a time
+// into a dry and an effect (wet) bus.
+namespace sas {
+
+constexpr int32_t SAMPLE_RATE = 48000;
+constexpr int32_t MAX_VOICES = 32;
+
+constexpr int32_t DEFAULT_GRAIN = 256;
+constexpr int32_t MIN_GRAIN = 64;
+constexpr int32_t MAX_GRAIN = 2048;
+
+// 0x1000 plays the source at 48 kHz
+constexpr int32_t PITCH_BASE = 0x1000;
+constexpr int32_t PITCH_MAX = 0x4000;
+
+constexpr int32_t VOLUME_MAX = 0x1000;
+constexpr int32_t NOISE_CLOCK_MAX = 0x3F;
+constexpr int32_t EFFECT_PARAM_MAX = 0x7F;
+constexpr int32_t PCM_MAX_SAMPLES = 0x10000;
+
+constexpr int32_t ENVELOPE_HEIGHT_MAX = 0x40000000;
+constexpr int32_t ENVELOPE_RATE_MAX = 0x7FFFFFFF;
+
+enum class SourceType {
+    None,
+    Vag,
+    Pcm,
+    Noise,
+};
+
+enum class AdsrCurve : int32_t {
+    LinearIncrease,
+    LinearDecrease,
+    LinearBent,
+    ExponentDecrease,
+    ExponentIncrease,
+    Direct,
+};
+
+enum AdsrFlag : uint32_t {
+    ADSR_ATTACK = 1 << 0,
+    ADSR_DECAY = 1 << 1,
+    ADSR_SUSTAIN = 1 << 2,
+    ADSR_RELEASE = 1 << 3,
+};
+
+enum class EnvelopePhase {
+    Attack,
+    Decay,
+    Sustain,
+    Release,
+    Off,
+};
+
+enum class EffectType : int32_t {
+    Off = -1,
+    Room,
+    StudioSmall,
+    StudioMedium,
+    StudioLarge,
+    Hall,
+    Space,
+    Echo,
+    Delay,
+    Pipe,
+};
+
+enum class OutputMode : int32_t {
+    Stereo,
+    // dry left, dry right, wet left, wet right
+    Multichannel,
+};
+
+struct Envelope {
+    // Indexed by EnvelopePhase, up to Release
+    int32_t rates[4] = { ENVELOPE_RATE_MAX, 0, 0, ENVELOPE_RATE_MAX };
+    AdsrCurve curves[4] = { AdsrCurve::LinearIncrease, AdsrCurve::ExponentDecrease, AdsrCurve::LinearIncrease, AdsrCurve::LinearDecrease };
+    int32_t sustain_level = ENVELOPE_HEIGHT_MAX;
+
+    EnvelopePhase phase = EnvelopePhase::Off;
+    int64_t height = 0;
+
+    void key_on();
+    void key_off();
+    // Decode the two ADSR words of the PSX SPU format
+    void set_simple(uint32_t adsr1, uint32_t adsr2);
+    // Move to the next sample and return its height
+    int32_t step();
+};
+
+struct Voice {
+    SourceType type = SourceType::None;
+    const uint8_t *data = nullptr;
+    uint32_t size = 0; // bytes for VAG, samples for PCM
+    bool loop = false;
+    uint32_t loop_pos = 0; // PCM only, in samples
+    int32_t noise_clock = 0;
+
+    int32_t pitch = PITCH_BASE;
+    int32_t volume[2] = { VOLUME_MAX, VOLUME_MAX };
+    int32_t wet_volume[2] = {};
+    int32_t distortion = 0;
+    Envelope envelope;
+
+    bool paused = false;
+    bool ended = true;
+
+    void key_on();
+    void key_off();
+    // Render frames mono samples of the voice in dest, with its envelope applied
+    void render(float *dest, int frames);
+
+private:
+    int32_t next_sample();
+    bool decode_vag_frame();
+
+    bool primed = false;
+    bool source_ended = false;
+    uint32_t read_pos = 0;
+    int64_t loop_frame = -1;
+    bool last_frame = false;
+    ADPCMHistory history = {};
+    int16_t block[HEVAG_FRAME_SAMPLES] = {};
+    uint32_t block_pos = 0;
+    uint32_t block_size = 0;
+    uint16_t noise_lfsr = 1;
+    uint32_t noise_counter = 0;
+
+    // linear interpolation between current and next, phase is 12 bits of fraction like the pitch
+    int32_t current = 0;
+    int32_t next = 0;
+    uint32_t phase = 0;
+};
+
+struct Config {
+    int32_t grain = DEFAULT_GRAIN;
+    int32_t voices = MAX_VOICES;
+    int32_t reverbs = 1;
+};
+
+// Parse a configuration string ("numGrains=256 numVoices=32 numReverbs=1"), missing keys keep their defaults
+bool parse_config(const char *str, Config &config);
+uint32_t needed_memory_size(const Config &config);
+
+struct Peak {
+    int32_t left = 0;
+    int32_t right = 0;
+};
+
+struct Engine {
+    int32_t grain = DEFAULT_GRAIN;
+    int32_t voice_count = MAX_VOICES;
+    OutputMode output_mode = OutputMode::Stereo;
+    std::array<Voice, MAX_VOICES> voices;
+
+    bool dry_enabled = true;
+    bool wet_enabled = false;
+    EffectType effect_type = EffectType::Off;
+    int32_t effect_delay = 0;
+    int32_t effect_feedback = 0;
+    int32_t effect_volume[2] = {};
+
+    Peak dry_peak;
+    Peak wet_peak;
+    Peak pre_master_peak;
+
+    Engine();
+    ~Engine();
+
+    void reset(const Config &config);
+    void set_effect_type(EffectType type);
+
+    // Mix a grain of every voice into dest, as interleaved stereo (four channels in multichannel mode)
+    void render(int16_t *dest);
+    // Add a grain on top of dest, whose current content is first scaled by the volumes (0x1000 is unity)
+    void render_mix(int16_t *dest, int32_t left, int32_t right);
+
+private:
+    void mix();
+
+    std::vector<float> voice_buffer;
+    std::vector<float> dry;
+    std::vector<float> wet;
+    std::vector<float> master;
+    std::unique_ptr<ngs::dsp::Reverb> reverb;
+    std::unique_ptr<ngs::dsp::Delay> delay;
+};
+
+} // namespace sas
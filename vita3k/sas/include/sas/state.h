@@ -0,0 +1,36 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/ptr.h>
+#include <sas/sas.h>
+
+#include <mutex>
+
+namespace sas {
+
+// libsas has a single instance per process, the game hands it a work buffer we only keep to give back on exit
+struct State {
+    std::mutex mutex;
+    bool initialized = false;
+    Ptr<void> buffer;
+    uint32_t buffer_size = 0;
+    Engine engine;
+};
+
+} // namespace sas
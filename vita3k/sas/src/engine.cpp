@@ -0,0 +1,238 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/mixer.h>
+#include <sas/sas.h>
+
+#include <ngs/dsp.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+namespace sas {
+
+namespace {
+
+// The environments of the effect types, loosely based on the I3DL2 presets of the same names
+struct ReverbPreset {
+    float decay_time;
+    float decay_hf_ratio;
+    float reflections;
+    float reflections_delay;
+    float reverb;
+    float reverb_delay;
+    float diffusion;
+    float density;
+};
+
+constexpr ReverbPreset REVERB_PRESETS[] = {
+    /* Room */ { 0.4f, 0.83f, -1646.0f, 0.002f, 53.0f, 0.003f, 100.0f, 100.0f },
+    /* StudioSmall */ { 1.1f, 0.83f, -400.0f, 0.005f, 500.0f, 0.01f, 100.0f, 100.0f },
+    /* StudioMedium */ { 1.3f, 0.83f, -1000.0f, 0.02f, -200.0f, 0.024f, 100.0f, 100.0f },
+    /* StudioLarge */ { 1.5f, 0.83f, -1600.0f, 0.02f, -1000.0f, 0.04f, 100.0f, 100.0f },
+    /* Hall */ { 3.92f, 0.7f, -1230.0f, 0.02f, -2.0f, 0.029f, 100.0f, 100.0f },
+    /* Space */ { 10.05f, 0.23f, -602.0f, 0.02f, 198.0f, 0.03f, 100.0f, 100.0f },
+    /* Echo */ {},
+    /* Delay */ {},
+    /* Pipe */ { 2.81f, 0.14f, 429.0f, 0.014f, 1023.0f, 0.021f, 80.0f, 60.0f },
+};
+
+// Echo and delay go up to about half a second
+constexpr float DELAY_MS_PER_STEP = 4.0f;
+
+ngs::dsp::ReverbParams make_reverb_params(const EffectType type) {
+    const ReverbPreset &preset = REVERB_PRESETS[static_cast<int32_t>(type)];
+    ngs::dsp::ReverbParams params{};
+    params.room = 0.0f;
+    params.room_hf = -600.0f;
+    params.decay_time = preset.decay_time;
+    params.decay_hf_ratio = preset.decay_hf_ratio;
+    params.reflections = preset.reflections;
+    params.reflections_delay = preset.reflections_delay;
+    params.reverb = preset.reverb;
+    params.reverb_delay = preset.reverb_delay;
+    params.diffusion = preset.diffusion;
+    params.density = preset.density;
+    params.hf_reference = 5000.0f;
+    params.pattern[0] = 0;
+    params.pattern[1] = 1;
+    params.early_reflection_scalar = 1.0f;
+    // the dry signal goes through its own bus
+    params.dry = -10000.0f;
+    return params;
+}
+
+} // namespace
+
+bool parse_config(const char *str, Config &config) {
+    if (!str)
+        return true;
+
+    std::istringstream stream(str);
+    std::string token;
+    while (stream >> token) {
+        const size_t equal = token.find('=');
+        if (equal == std::string::npos) {
+            LOG_ERROR("Malformed SAS config entry {}", token);
+            return false;
+        }
+
+        const std::string key = token.substr(0, equal);
+        int32_t value;
+        try {
+            value = std::stoi(token.substr(equal + 1));
+        } catch (...) {
+            LOG_ERROR("Malformed SAS config entry {}", token);
+            return false;
+        }
+
+        if (key == "numGrains")
+            config.grain = value;
+        else if (key == "numVoices")
+            config.voices = value;
+        else if (key == "numReverbs")
+            config.reverbs = value;
+        else
+            LOG_WARN("Unknown SAS config entry {}", token);
+    }
+
+    return config.grain >= MIN_GRAIN && config.grain <= MAX_GRAIN && config.voices > 0 && config.voices <= MAX_VOICES
+        && config.reverbs >= 0 && config.reverbs <= 1;
+}
+
+uint32_t needed_memory_size(const Config &config) {
+    // The engine lives on the host, this only has to be a plausible size for the game to allocate:
+    // the voice states, a grain of dry and wet mix and the reverb work area
+    constexpr uint32_t HEADER_SIZE = 0x400;
+    constexpr uint32_t VOICE_SIZE = 0x100;
+    constexpr uint32_t REVERB_SIZE = 0x20000;
+    return HEADER_SIZE + config.voices * VOICE_SIZE + config.grain * 4 * sizeof(int32_t) + config.reverbs * REVERB_SIZE;
+}
+
+Engine::Engine() {
+    reset(Config{});
+}
+
+Engine::~Engine() = default;
+
+void Engine::reset(const Config &config) {
+    grain = config.grain;
+    voice_count = config.voices;
+    output_mode = OutputMode::Stereo;
+    voices.fill(Voice{});
+
+    dry_enabled = true;
+    wet_enabled = false;
+    effect_delay = 0;
+    effect_feedback = 0;
+    effect_volume[0] = effect_volume[1] = 0;
+    set_effect_type(EffectType::Off);
+
+    dry_peak = wet_peak = pre_master_peak = {};
+
+    // sized for the largest grain so that changing it never allocates
+    voice_buffer.assign(MAX_GRAIN, 0.0f);
+    dry.assign(MAX_GRAIN * 2, 0.0f);
+    wet.assign(MAX_GRAIN * 2, 0.0f);
+    master.assign(MAX_GRAIN * 4, 0.0f);
+}
+
+void Engine::set_effect_type(const EffectType type) {
+    effect_type = type;
+    reverb.reset();
+    delay.reset();
+    if (type == EffectType::Echo || type == EffectType::Delay)
+        delay = std::make_unique<ngs::dsp::Delay>();
+    else if (type != EffectType::Off)
+        reverb = std::make_unique<ngs::dsp::Reverb>();
+}
+
+void Engine::mix() {
+    const int frames = grain;
+    std::fill_n(dry.begin(), frames * 2, 0.0f);
+    std::fill_n(wet.begin(), frames * 2, 0.0f);
+
+    for (int32_t v = 0; v < voice_count; v++) {
+        Voice &voice = voices[v];
+        if (voice.ended || voice.paused)
+            continue;
+
+        voice.render(voice_buffer.data(), frames);
+        mixer::mix_mono(voice_buffer.data(), dry.data(), frames, static_cast<float>(voice.volume[0]) / VOLUME_MAX, static_cast<float>(voice.volume[1]) / VOLUME_MAX);
+        if (voice.wet_volume[0] != 0 || voice.wet_volume[1] != 0)
+            mixer::mix_mono(voice_buffer.data(), wet.data(), frames, static_cast<float>(voice.wet_volume[0]) / VOLUME_MAX, static_cast<float>(voice.wet_volume[1]) / VOLUME_MAX);
+    }
+
+    mixer::peak(dry.data(), frames, dry_peak.left, dry_peak.right);
+
+    // keep the effect running on silence so that its tail decays naturally
+    if (wet_enabled) {
+        if (reverb) {
+            reverb->process(make_reverb_params(effect_type), SAMPLE_RATE, wet.data(), wet.data(), frames);
+        } else if (delay) {
+            ngs::dsp::DelayParams params{};
+            params.taps[0].delay = effect_delay * DELAY_MS_PER_STEP;
+            params.taps[0].volume = 1.0f;
+            params.taps[0].feedback = (effect_type == EffectType::Echo) ? static_cast<float>(effect_feedback) / (EFFECT_PARAM_MAX + 1) : 0.0f;
+            params.taps[0].filter = ngs::dsp::FilterType::Off;
+            delay->process(params, SAMPLE_RATE, wet.data(), wet.data(), frames);
+        }
+    }
+
+    float *out = master.data();
+    std::fill_n(out, frames * 2, 0.0f);
+    if (wet_enabled)
+        mixer::mix_stereo(wet.data(), out, frames, static_cast<float>(effect_volume[0]) / VOLUME_MAX, static_cast<float>(effect_volume[1]) / VOLUME_MAX);
+    mixer::peak(out, frames, wet_peak.left, wet_peak.right);
+
+    if (output_mode == OutputMode::Multichannel) {
+        // keep the scaled wet bus apart, the game mixes the four channels itself
+        std::memcpy(wet.data(), out, frames * 2 * sizeof(float));
+        for (int i = frames - 1; i >= 0; i--) {
+            out[i * 4] = dry_enabled ? dry[i * 2] : 0.0f;
+            out[i * 4 + 1] = dry_enabled ? dry[i * 2 + 1] : 0.0f;
+            out[i * 4 + 2] = wet[i * 2];
+            out[i * 4 + 3] = wet[i * 2 + 1];
+        }
+        pre_master_peak = dry_peak;
+        return;
+    }
+
+    if (dry_enabled)
+        mixer::mix_stereo(dry.data(), out, frames, 1.0f, 1.0f);
+    mixer::peak(out, frames, pre_master_peak.left, pre_master_peak.right);
+}
+
+void Engine::render(int16_t *dest) {
+    mix();
+    const int channels = (output_mode == OutputMode::Multichannel) ? 4 : 2;
+    mixer::to_s16(master.data(), dest, grain * channels);
+}
+
+void Engine::render_mix(int16_t *dest, const int32_t left, const int32_t right) {
+    const OutputMode mode = output_mode;
+    // the game's buffer is always stereo
+    output_mode = OutputMode::Stereo;
+    mix();
+    output_mode = mode;
+    mixer::mix_s16(master.data(), dest, grain, static_cast<float>(left) / VOLUME_MAX, static_cast<float>(right) / VOLUME_MAX);
+}
+
+} // namespace sas
@@ -0,0 +1,150 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/sas.h>
+
+#include <algorithm>
+
+namespace sas {
+
+namespace {
+
+// Rates of the simple ADSR words, a 7 bit value made of a shift and a step
+int32_t simple_rate(uint32_t n) {
+    n &= 0x7F;
+    if (n == 0x7F)
+        return 0;
+    const int32_t rate = static_cast<int32_t>(((7 - (n & 3)) << 26) >> (n >> 2));
+    return std::max(rate, 1);
+}
+
+int32_t exponent_rate(const uint32_t n) {
+    if (n == 0)
+        return ENVELOPE_RATE_MAX;
+    return static_cast<int32_t>(0x80000000u >> n);
+}
+
+int64_t advance(const AdsrCurve curve, const int32_t rate, const int64_t height) {
+    // exponential curves still move by at least one step so that they reach their target
+    const int64_t min_step = rate > 0 ? 1 : 0;
+    switch (curve) {
+    case AdsrCurve::LinearIncrease:
+        return height + rate;
+    case AdsrCurve::LinearDecrease:
+        return height - rate;
+    case AdsrCurve::LinearBent:
+        return height + ((height < ENVELOPE_HEIGHT_MAX / 4 * 3) ? rate : rate / 4);
+    case AdsrCurve::ExponentDecrease:
+        return height - std::max((height * rate) >> 31, min_step);
+    case AdsrCurve::ExponentIncrease:
+        return height + std::max(((ENVELOPE_HEIGHT_MAX - height) * rate) >> 31, min_step);
+    case AdsrCurve::Direct:
+        return rate;
+    }
+    return height;
+}
+
+} // namespace
+
+void Envelope::key_on() {
+    phase = EnvelopePhase::Attack;
+    height = 0;
+}
+
+void Envelope::key_off() {
+    if (phase != EnvelopePhase::Off)
+        phase = EnvelopePhase::Release;
+}
+
+void Envelope::set_simple(const uint32_t adsr1, const uint32_t adsr2) {
+    const auto attack = static_cast<size_t>(EnvelopePhase::Attack);
+    const auto decay = static_cast<size_t>(EnvelopePhase::Decay);
+    const auto sustain = static_cast<size_t>(EnvelopePhase::Sustain);
+    const auto release = static_cast<size_t>(EnvelopePhase::Release);
+
+    rates[attack] = simple_rate(adsr1 >> 8);
+    curves[attack] = (adsr1 & 0x8000) ? AdsrCurve::LinearBent : AdsrCurve::LinearIncrease;
+
+    rates[decay] = exponent_rate((adsr1 >> 4) & 0xF);
+    curves[decay] = AdsrCurve::ExponentDecrease;
+
+    sustain_level = static_cast<int32_t>(((adsr1 & 0xF) + 1) << 26);
+
+    rates[sustain] = simple_rate(adsr2 >> 6);
+    switch ((adsr2 >> 13) & 0x7) {
+    case 0:
+        curves[sustain] = AdsrCurve::LinearIncrease;
+        break;
+    case 2:
+        curves[sustain] = AdsrCurve::LinearDecrease;
+        break;
+    case 4:
+        curves[sustain] = AdsrCurve::LinearBent;
+        break;
+    default:
+        curves[sustain] = AdsrCurve::ExponentDecrease;
+        break;
+    }
+
+    const uint32_t release_shift = adsr2 & 0x1F;
+    if (adsr2 & 0x20) {
+        curves[release] = AdsrCurve::ExponentDecrease;
+        rates[release] = exponent_rate(release_shift);
+    } else {
+        curves[release] = AdsrCurve::LinearDecrease;
+        if (release_shift == 30)
+            rates[release] = ENVELOPE_HEIGHT_MAX;
+        else if (release_shift == 29)
+            rates[release] = 1;
+        else
+            rates[release] = static_cast<int32_t>(0x10000000u >> release_shift);
+    }
+    if (release_shift == 31)
+        rates[release] = 0;
+}
+
+int32_t Envelope::step() {
+    if (phase == EnvelopePhase::Off)
+        return 0;
+
+    const auto index = static_cast<size_t>(phase);
+    height = std::clamp<int64_t>(advance(curves[index], rates[index], height), 0, ENVELOPE_HEIGHT_MAX);
+
+    switch (phase) {
+    case EnvelopePhase::Attack:
+        if (height >= ENVELOPE_HEIGHT_MAX)
+            phase = EnvelopePhase::Decay;
+        break;
+    case EnvelopePhase::Decay:
+        if (height <= sustain_level) {
+            height = sustain_level;
+            phase = EnvelopePhase::Sustain;
+        }
+        break;
+    case EnvelopePhase::Sustain:
+    case EnvelopePhase::Release:
+        if (height == 0)
+            phase = EnvelopePhase::Off;
+        break;
+    default:
+        break;
+    }
+
+    return static_cast<int32_t>(height);
+}
+
+} // namespace sas
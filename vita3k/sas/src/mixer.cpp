@@ -0,0 +1,209 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/mixer.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#else
+#include <emmintrin.h>
+#endif
+
+namespace sas::mixer {
+
+namespace {
+
+constexpr float S16_MIN = -32768.0f;
+constexpr float S16_MAX = 32767.0f;
+
+int16_t saturate(const float sample) {
+    // lrint rounds to nearest even like the vector conversions
+    return static_cast<int16_t>(std::lrint(std::clamp(sample, S16_MIN, S16_MAX)));
+}
+
+} // namespace
+
+#if defined(__aarch64__)
+
+void mix_mono(const float *src, float *dest, const int frames, const float left, const float right) {
+    const float32x4_t gains = { left, right, left, right };
+    int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4_t in = vld1q_f32(src + i);
+        const float32x4_t lo = vzip1q_f32(in, in);
+        const float32x4_t hi = vzip2q_f32(in, in);
+        vst1q_f32(dest + i * 2, vmlaq_f32(vld1q_f32(dest + i * 2), lo, gains));
+        vst1q_f32(dest + i * 2 + 4, vmlaq_f32(vld1q_f32(dest + i * 2 + 4), hi, gains));
+    }
+    for (; i < frames; i++) {
+        dest[i * 2] += src[i] * left;
+        dest[i * 2 + 1] += src[i] * right;
+    }
+}
+
+void mix_stereo(const float *src, float *dest, const int frames, const float left, const float right) {
+    const float32x4_t gains = { left, right, left, right };
+    const int samples = frames * 2;
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+        vst1q_f32(dest + i, vmlaq_f32(vld1q_f32(dest + i), vld1q_f32(src + i), gains));
+    for (; i < samples; i += 2) {
+        dest[i] += src[i] * left;
+        dest[i + 1] += src[i + 1] * right;
+    }
+}
+
+void to_s16(const float *src, int16_t *dest, const int samples) {
+    const float32x4_t low = vdupq_n_f32(S16_MIN);
+    const float32x4_t high = vdupq_n_f32(S16_MAX);
+    int i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const int32x4_t a = vcvtnq_s32_f32(vminq_f32(vmaxq_f32(vld1q_f32(src + i), low), high));
+        const int32x4_t b = vcvtnq_s32_f32(vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), low), high));
+        vst1q_s16(dest + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+    for (; i < samples; i++)
+        dest[i] = saturate(src[i]);
+}
+
+void mix_s16(const float *src, int16_t *dest, const int frames, const float left, const float right) {
+    const float32x4_t gains = { left, right, left, right };
+    const float32x4_t low = vdupq_n_f32(S16_MIN);
+    const float32x4_t high = vdupq_n_f32(S16_MAX);
+    const int samples = frames * 2;
+    int i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        const float32x4_t existing = vcvtq_f32_s32(vmovl_s16(vld1_s16(dest + i)));
+        const float32x4_t sum = vmlaq_f32(vld1q_f32(src + i), existing, gains);
+        vst1_s16(dest + i, vqmovn_s32(vcvtnq_s32_f32(vminq_f32(vmaxq_f32(sum, low), high))));
+    }
+    for (; i < samples; i += 2) {
+        dest[i] = saturate(src[i] + dest[i] * left);
+        dest[i + 1] = saturate(src[i + 1] + dest[i + 1] * right);
+    }
+}
+
+void peak(const float *src, const int frames, int32_t &left, int32_t &right) {
+    float32x4_t highest = vdupq_n_f32(0.0f);
+    const int samples = frames * 2;
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+        highest = vmaxq_f32(highest, vabsq_f32(vld1q_f32(src + i)));
+    float l = std::max(vgetq_lane_f32(highest, 0), vgetq_lane_f32(highest, 2));
+    float r = std::max(vgetq_lane_f32(highest, 1), vgetq_lane_f32(highest, 3));
+    for (; i < samples; i += 2) {
+        l = std::max(l, std::abs(src[i]));
+        r = std::max(r, std::abs(src[i + 1]));
+    }
+    left = static_cast<int32_t>(std::min(l, S16_MAX));
+    right = static_cast<int32_t>(std::min(r, S16_MAX));
+}
+
+#else
+
+namespace {
+
+// Clamp before converting, out of range values would come back as 0x80000000 and saturate the wrong way
+__m128i clamp_to_s32(const __m128 a) {
+    return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, _mm_set1_ps(S16_MIN)), _mm_set1_ps(S16_MAX)));
+}
+
+} // namespace
+
+void mix_mono(const float *src, float *dest, const int frames, const float left, const float right) {
+    const __m128 gains = _mm_setr_ps(left, right, left, right);
+    int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 in = _mm_loadu_ps(src + i);
+        const __m128 lo = _mm_unpacklo_ps(in, in);
+        const __m128 hi = _mm_unpackhi_ps(in, in);
+        _mm_storeu_ps(dest + i * 2, _mm_add_ps(_mm_loadu_ps(dest + i * 2), _mm_mul_ps(lo, gains)));
+        _mm_storeu_ps(dest + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(dest + i * 2 + 4), _mm_mul_ps(hi, gains)));
+    }
+    for (; i < frames; i++) {
+        dest[i * 2] += src[i] * left;
+        dest[i * 2 + 1] += src[i] * right;
+    }
+}
+
+void mix_stereo(const float *src, float *dest, const int frames, const float left, const float right) {
+    const __m128 gains = _mm_setr_ps(left, right, left, right);
+    const int samples = frames * 2;
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+        _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(_mm_loadu_ps(src + i), gains)));
+    for (; i < samples; i += 2) {
+        dest[i] += src[i] * left;
+        dest[i + 1] += src[i + 1] * right;
+    }
+}
+
+void to_s16(const float *src, int16_t *dest, const int samples) {
+    int i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m128i a = clamp_to_s32(_mm_loadu_ps(src + i));
+        const __m128i b = clamp_to_s32(_mm_loadu_ps(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packs_epi32(a, b));
+    }
+    for (; i < samples; i++)
+        dest[i] = saturate(src[i]);
+}
+
+void mix_s16(const float *src, int16_t *dest, const int frames, const float left, const float right) {
+    const __m128 gains = _mm_setr_ps(left, right, left, right);
+    const int samples = frames * 2;
+    int i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m128i existing = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i));
+        // sign extend the eight samples to two vectors of s32
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(existing, existing), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(existing, existing), 16);
+        const __m128 a = _mm_add_ps(_mm_loadu_ps(src + i), _mm_mul_ps(_mm_cvtepi32_ps(lo), gains));
+        const __m128 b = _mm_add_ps(_mm_loadu_ps(src + i + 4), _mm_mul_ps(_mm_cvtepi32_ps(hi), gains));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packs_epi32(clamp_to_s32(a), clamp_to_s32(b)));
+    }
+    for (; i < samples; i += 2) {
+        dest[i] = saturate(src[i] + dest[i] * left);
+        dest[i + 1] = saturate(src[i + 1] + dest[i + 1] * right);
+    }
+}
+
+void peak(const float *src, const int frames, int32_t &left, int32_t &right) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 highest = _mm_setzero_ps();
+    const int samples = frames * 2;
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+        highest = _mm_max_ps(highest, _mm_andnot_ps(sign, _mm_loadu_ps(src + i)));
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, highest);
+    float l = std::max(lanes[0], lanes[2]);
+    float r = std::max(lanes[1], lanes[3]);
+    for (; i < samples; i += 2) {
+        l = std::max(l, std::abs(src[i]));
+        r = std::max(r, std::abs(src[i + 1]));
+    }
+    left = static_cast<int32_t>(std::min(l, S16_MAX));
+    right = static_cast<int32_t>(std::min(r, S16_MAX));
+}
+
+#endif
+
+} // namespace sas::mixer
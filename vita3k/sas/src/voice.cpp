@@ -0,0 +1,168 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/sas.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sas {
+
+namespace {
+
+enum VagFlag : uint8_t {
+    VAG_END = 1 << 0,
+    VAG_REPEAT = 1 << 1,
+    VAG_LOOP_START = 1 << 2,
+    // a frame with every flag set is silent and stops the voice
+    VAG_STOP = VAG_END | VAG_REPEAT | VAG_LOOP_START,
+};
+
+constexpr float ENVELOPE_SCALE = 1.0f / ENVELOPE_HEIGHT_MAX;
+constexpr float OVERDRIVE = 4.0f;
+
+} // namespace
+
+void Voice::key_on() {
+    ended = (type == SourceType::None);
+    primed = false;
+    source_ended = false;
+    read_pos = 0;
+    loop_frame = -1;
+    last_frame = false;
+    history = {};
+    block_pos = block_size = 0;
+    noise_lfsr = 1;
+    noise_counter = 0;
+    current = next = 0;
+    phase = 0;
+    envelope.key_on();
+}
+
+void Voice::key_off() {
+    envelope.key_off();
+}
+
+bool Voice::decode_vag_frame() {
+    if (last_frame || read_pos + HEVAG_FRAME_SIZE > size)
+        return false;
+
+    const uint8_t *frame = data + read_pos;
+    const uint8_t flags = frame[1] & 0xF;
+    if (flags == VAG_STOP)
+        return false;
+
+    if (loop && (flags & VAG_LOOP_START))
+        loop_frame = read_pos;
+
+    decode_hevag_frame(frame, history, block);
+    block_pos = 0;
+    block_size = HEVAG_FRAME_SAMPLES;
+    read_pos += HEVAG_FRAME_SIZE;
+
+    if (flags & VAG_END) {
+        if (loop && loop_frame >= 0)
+            read_pos = static_cast<uint32_t>(loop_frame);
+        else
+            last_frame = true;
+    }
+
+    return true;
+}
+
+int32_t Voice::next_sample() {
+    switch (type) {
+    case SourceType::Vag:
+        if (block_pos >= block_size && !decode_vag_frame())
+            break;
+        return block[block_pos++];
+
+    case SourceType::Pcm: {
+        if (read_pos >= size) {
+            if (!loop || loop_pos >= size)
+                break;
+            read_pos = loop_pos;
+        }
+        int16_t sample;
+        std::memcpy(&sample, data + read_pos * sizeof(int16_t), sizeof(sample));
+        read_pos++;
+        return sample;
+    }
+
+    case SourceType::Noise: {
+        // 15 bit LFSR of the SPU, clocked (4 + step) << shift times per 0x10000 samples
+        noise_counter += (4 + (noise_clock & 3)) << (noise_clock >> 2);
+        while (noise_counter >= 0x10000) {
+            noise_counter -= 0x10000;
+            const uint16_t parity = ((noise_lfsr >> 15) ^ (noise_lfsr >> 12) ^ (noise_lfsr >> 11) ^ (noise_lfsr >> 10) ^ 1) & 1;
+            noise_lfsr = static_cast<uint16_t>((noise_lfsr << 1) | parity);
+        }
+        return static_cast<int16_t>(noise_lfsr);
+    }
+
+    default:
+        break;
+    }
+
+    source_ended = true;
+    return 0;
+}
+
+void Voice::render(float *dest, const int frames) {
+    if (!primed) {
+        current = next_sample();
+        next = next_sample();
+        primed = true;
+    }
+
+    // noise is generated at the output rate, the pitch only applies to sampled sources
+    const uint32_t step = (type == SourceType::Noise) ? PITCH_BASE : static_cast<uint32_t>(pitch);
+    const float drive = static_cast<float>(distortion) / VOLUME_MAX;
+
+    int i = 0;
+    for (; i < frames && !ended; i++) {
+        const int32_t sample = current + (((next - current) * static_cast<int32_t>(phase)) >> 12);
+        float value = static_cast<float>(sample) * (static_cast<float>(envelope.step()) * ENVELOPE_SCALE);
+        if (drive > 0.0f) {
+            // blend in an overdriven and soft clipped copy of the voice
+            const float driven = value * (OVERDRIVE / 32768.0f);
+            const float clipped = 32768.0f * driven / (1.0f + std::abs(driven));
+            value += (clipped - value) * drive;
+        }
+        dest[i] = value;
+
+        phase += step;
+        while (phase >= PITCH_BASE) {
+            phase -= PITCH_BASE;
+            if (source_ended) {
+                // the last decoded sample has been played
+                ended = true;
+                break;
+            }
+            current = next;
+            next = next_sample();
+        }
+
+        if (envelope.phase == EnvelopePhase::Off)
+            ended = true;
+    }
+
+    std::fill(dest + i, dest + frames, 0.0f);
+}
+
+} // namespace sas
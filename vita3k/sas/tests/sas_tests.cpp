@@ -0,0 +1,390 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/mixer.h>
+#include <sas/sas.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace sas;
+
+namespace {
+
+constexpr int GRAIN = 256;
+
+std::vector<int16_t> ramp(const int samples) {
+    std::vector<int16_t> pcm(samples);
+    for (int i = 0; i < samples; i++)
+        pcm[i] = static_cast<int16_t>((i * 37) % 20000 - 10000);
+    return pcm;
+}
+
+// Render grains back to back, like successive sceSasCore calls
+std::vector<int16_t> render_grains(Engine &engine, const int count) {
+    std::vector<int16_t> output(count * engine.grain * 2);
+    for (int g = 0; g < count; g++)
+        engine.render(output.data() + g * engine.grain * 2);
+    return output;
+}
+
+Engine &make_engine() {
+    static Engine engine;
+    Config config;
+    config.grain = GRAIN;
+    engine.reset(config);
+    return engine;
+}
+
+void set_pcm(Voice &voice, const std::vector<int16_t> &pcm, const bool loop = false, const uint32_t loop_pos = 0) {
+    voice.type = SourceType::Pcm;
+    voice.data = reinterpret_cast<const uint8_t *>(pcm.data());
+    voice.size = static_cast<uint32_t>(pcm.size());
+    voice.loop = loop;
+    voice.loop_pos = loop_pos;
+}
+
+// A VAG frame whose nibbles all have the same value
+std::vector<uint8_t> vag_frame(const uint8_t predictor, const uint8_t shift, const uint8_t flags, const uint8_t nibble) {
+    std::vector<uint8_t> frame(HEVAG_FRAME_SIZE, static_cast<uint8_t>(nibble | (nibble << 4)));
+    frame[0] = static_cast<uint8_t>((predictor << 4) | shift);
+    frame[1] = flags;
+    return frame;
+}
+
+} // namespace
+
+TEST(sas, pcm_voice_at_unity_pitch_is_bit_exact) {
+    Engine &engine = make_engine();
+    const std::vector<int16_t> pcm = ramp(GRAIN * 2 + 100);
+    Voice &voice = engine.voices[0];
+    set_pcm(voice, pcm);
+    voice.key_on();
+
+    const std::vector<int16_t> output = render_grains(engine, 3);
+    for (size_t i = 0; i < pcm.size(); i++) {
+        ASSERT_EQ(output[i * 2], pcm[i]) << i;
+        ASSERT_EQ(output[i * 2 + 1], pcm[i]) << i;
+    }
+    for (size_t i = pcm.size() * 2; i < output.size(); i++)
+        ASSERT_EQ(output[i], 0);
+    EXPECT_TRUE(voice.ended);
+}
+
+TEST(sas, pcm_voice_loops_from_loop_position) {
+    Engine &engine = make_engine();
+    const std::vector<int16_t> pcm = ramp(100);
+    Voice &voice = engine.voices[3];
+    set_pcm(voice, pcm, true, 40);
+    voice.key_on();
+
+    const std::vector<int16_t> output = render_grains(engine, 2);
+    for (int i = 0; i < GRAIN * 2; i++) {
+        const int expected = i < 100 ? i : 40 + (i - 100) % 60;
+        ASSERT_EQ(output[i * 2], pcm[expected]) << i;
+    }
+    EXPECT_FALSE(voice.ended);
+}
+
+TEST(sas, pitch_steps_through_the_source) {
+    Engine &engine = make_engine();
+    const std::vector<int16_t> pcm = ramp(GRAIN * 4);
+
+    Voice &fast = engine.voices[0];
+    set_pcm(fast, pcm);
+    fast.pitch = PITCH_BASE * 2;
+    fast.volume[1] = 0;
+    fast.key_on();
+
+    Voice &slow = engine.voices[1];
+    set_pcm(slow, pcm);
+    slow.pitch = PITCH_BASE / 2;
+    slow.volume[0] = 0;
+    slow.key_on();
+
+    const std::vector<int16_t> output = render_grains(engine, 1);
+    for (int i = 0; i < GRAIN; i++) {
+        ASSERT_EQ(output[i * 2], pcm[i * 2]) << i;
+        // half pitch plays every source sample twice, the second time halfway to the next one
+        const int32_t a = pcm[i / 2];
+        const int32_t b = pcm[i / 2 + 1];
+        const int32_t expected = (i & 1) ? a + (((b - a) * 0x800) >> 12) : a;
+        ASSERT_EQ(output[i * 2 + 1], expected) << i;
+    }
+}
+
+TEST(sas, volumes_pan_and_saturate) {
+    Engine &engine = make_engine();
+    std::vector<int16_t> pcm(GRAIN, 20000);
+
+    Voice &a = engine.voices[0];
+    set_pcm(a, pcm);
+    a.volume[0] = VOLUME_MAX / 2;
+    a.volume[1] = VOLUME_MAX;
+    a.key_on();
+
+    Voice &b = engine.voices[1];
+    set_pcm(b, pcm);
+    b.volume[0] = 0;
+    b.volume[1] = VOLUME_MAX;
+    b.key_on();
+
+    const std::vector<int16_t> output = render_grains(engine, 1);
+    for (int i = 0; i < GRAIN; i++) {
+        ASSERT_EQ(output[i * 2], 10000);
+        ASSERT_EQ(output[i * 2 + 1], 32767);
+    }
+    EXPECT_EQ(engine.dry_peak.left, 10000);
+    EXPECT_EQ(engine.dry_peak.right, 32767);
+}
+
+TEST(sas, vag_voice_matches_the_codec_decoder) {
+    std::vector<uint8_t> vag;
+    for (const auto &frame : { vag_frame(0, 4, 0, 3), vag_frame(2, 6, 0, 9), vag_frame(4, 2, 1, 5) })
+        vag.insert(vag.end(), frame.begin(), frame.end());
+
+    // golden samples straight from the HE-VAG decoder
+    std::vector<int16_t> golden(HEVAG_FRAME_SAMPLES * 3);
+    ADPCMHistory history = {};
+    for (int f = 0; f < 3; f++)
+        decode_hevag_frame(vag.data() + f * HEVAG_FRAME_SIZE, history, golden.data() + f * HEVAG_FRAME_SAMPLES);
+
+    Engine &engine = make_engine();
+    Voice &voice = engine.voices[0];
+    voice.type = SourceType::Vag;
+    voice.data = vag.data();
+    voice.size = static_cast<uint32_t>(vag.size());
+    voice.key_on();
+
+    const std::vector<int16_t> output = render_grains(engine, 1);
+    for (size_t i = 0; i < golden.size(); i++)
+        ASSERT_EQ(output[i * 2], golden[i]) << i;
+    for (size_t i = golden.size(); i < GRAIN; i++)
+        ASSERT_EQ(output[i * 2], 0) << i;
+    EXPECT_TRUE(voice.ended);
+}
+
+TEST(sas, vag_voice_repeats_its_loop) {
+    std::vector<uint8_t> vag;
+    for (const auto &frame : { vag_frame(0, 4, 0, 1), vag_frame(0, 4, 4, 2), vag_frame(0, 4, 3, 3) })
+        vag.insert(vag.end(), frame.begin(), frame.end());
+
+    Engine &engine = make_engine();
+    Voice &voice = engine.voices[0];
+    voice.type = SourceType::Vag;
+    voice.data = vag.data();
+    voice.size = static_cast<uint32_t>(vag.size());
+    voice.loop = true;
+    voice.key_on();
+
+    // predictor 0 has no history, each frame decodes to a constant
+    const int16_t levels[] = { 1 << 8, 2 << 8, 3 << 8 };
+    const std::vector<int16_t> output = render_grains(engine, 2);
+    for (int i = 0; i < GRAIN * 2; i++) {
+        const int frame = i / HEVAG_FRAME_SAMPLES;
+        const int expected = frame == 0 ? 0 : 1 + (frame - 1) % 2;
+        ASSERT_EQ(output[i * 2], levels[expected]) << i;
+    }
+    EXPECT_FALSE(voice.ended);
+}
+
+TEST(sas, linear_adsr_shapes_the_voice) {
+    Engine &engine = make_engine();
+    std::vector<int16_t> pcm(GRAIN * 8, 16384);
+
+    Voice &voice = engine.voices[0];
+    set_pcm(voice, pcm);
+    const int32_t rate = ENVELOPE_HEIGHT_MAX / 64;
+    voice.envelope.rates[static_cast<size_t>(EnvelopePhase::Attack)] = rate;
+    voice.envelope.rates[static_cast<size_t>(EnvelopePhase::Decay)] = rate;
+    voice.envelope.curves[static_cast<size_t>(EnvelopePhase::Decay)] = AdsrCurve::LinearDecrease;
+    voice.envelope.sustain_level = ENVELOPE_HEIGHT_MAX / 2;
+    voice.envelope.rates[static_cast<size_t>(EnvelopePhase::Release)] = rate;
+    voice.key_on();
+
+    const std::vector<int16_t> output = render_grains(engine, 1);
+    for (int i = 0; i < GRAIN; i++) {
+        int64_t height;
+        if (i < 64)
+            height = static_cast<int64_t>(rate) * (i + 1);
+        else
+            height = std::max<int64_t>(ENVELOPE_HEIGHT_MAX - static_cast<int64_t>(rate) * (i - 63), ENVELOPE_HEIGHT_MAX / 2);
+        const double expected = 16384.0 * height / ENVELOPE_HEIGHT_MAX;
+        ASSERT_NEAR(output[i * 2], expected, 1.0) << i;
+    }
+    EXPECT_EQ(voice.envelope.phase, EnvelopePhase::Sustain);
+
+    voice.key_off();
+    render_grains(engine, 1);
+    EXPECT_EQ(voice.envelope.phase, EnvelopePhase::Off);
+    EXPECT_TRUE(voice.ended);
+}
+
+TEST(sas, simple_adsr_decodes_spu_words) {
+    Envelope envelope;
+    // attack shift 0 step 0 linear, decay shift 15, sustain level 7, sustain decreasing, exponential release 5
+    envelope.set_simple(0x00F7, 0x4000 | (0x7F << 6) | 0x20 | 5);
+    EXPECT_EQ(envelope.rates[0], 7 << 26);
+    EXPECT_EQ(envelope.curves[0], AdsrCurve::LinearIncrease);
+    EXPECT_EQ(envelope.rates[1], static_cast<int32_t>(0x80000000u >> 15));
+    EXPECT_EQ(envelope.sustain_level, 8 << 26);
+    EXPECT_EQ(envelope.curves[2], AdsrCurve::LinearDecrease);
+    EXPECT_EQ(envelope.rates[2], 0);
+    EXPECT_EQ(envelope.curves[3], AdsrCurve::ExponentDecrease);
+    EXPECT_EQ(envelope.rates[3], static_cast<int32_t>(0x80000000u >> 5));
+}
+
+TEST(sas, paused_voices_keep_their_position) {
+    Engine &engine = make_engine();
+    const std::vector<int16_t> pcm = ramp(GRAIN * 3);
+    Voice &voice = engine.voices[0];
+    set_pcm(voice, pcm);
+    voice.key_on();
+
+    render_grains(engine, 1);
+    voice.paused = true;
+    const std::vector<int16_t> silent = render_grains(engine, 1);
+    for (const int16_t sample : silent)
+        ASSERT_EQ(sample, 0);
+
+    voice.paused = false;
+    const std::vector<int16_t> resumed = render_grains(engine, 1);
+    for (int i = 0; i < GRAIN; i++)
+        ASSERT_EQ(resumed[i * 2], pcm[GRAIN + i]) << i;
+}
+
+TEST(sas, noise_is_deterministic) {
+    Engine &engine = make_engine();
+    Voice &voice = engine.voices[0];
+    voice.type = SourceType::Noise;
+    voice.noise_clock = NOISE_CLOCK_MAX;
+    voice.key_on();
+    const std::vector<int16_t> first = render_grains(engine, 2);
+
+    voice.key_on();
+    const std::vector<int16_t> second = render_grains(engine, 2);
+    EXPECT_EQ(first, second);
+    EXPECT_GT(engine.dry_peak.left, 0);
+}
+
+TEST(sas, delay_effect_sends_a_delayed_copy) {
+    Engine &engine = make_engine();
+    std::vector<int16_t> pcm(8, 0);
+    pcm[0] = 8000;
+
+    Voice &voice = engine.voices[0];
+    set_pcm(voice, pcm);
+    voice.volume[0] = voice.volume[1] = 0;
+    voice.wet_volume[0] = voice.wet_volume[1] = VOLUME_MAX;
+    voice.key_on();
+
+    engine.wet_enabled = true;
+    engine.set_effect_type(EffectType::Delay);
+    engine.effect_delay = 2; // 8 ms
+    engine.effect_volume[0] = engine.effect_volume[1] = VOLUME_MAX;
+
+    const std::vector<int16_t> output = render_grains(engine, 4);
+    const int delay_frames = SAMPLE_RATE * 8 / 1000;
+    for (int i = 0; i < GRAIN * 4; i++)
+        ASSERT_EQ(output[i * 2], i == delay_frames ? 8000 : 0) << i;
+}
+
+TEST(sas, core_with_mix_adds_to_the_buffer) {
+    Engine &engine = make_engine();
+    std::vector<int16_t> pcm(GRAIN, 1000);
+    Voice &voice = engine.voices[0];
+    set_pcm(voice, pcm);
+    voice.key_on();
+
+    std::vector<int16_t> buffer(GRAIN * 2);
+    for (int i = 0; i < GRAIN; i++) {
+        buffer[i * 2] = 4000;
+        buffer[i * 2 + 1] = 32000;
+    }
+    engine.render_mix(buffer.data(), VOLUME_MAX / 2, VOLUME_MAX);
+    for (int i = 0; i < GRAIN; i++) {
+        ASSERT_EQ(buffer[i * 2], 3000);
+        ASSERT_EQ(buffer[i * 2 + 1], 32767);
+    }
+}
+
+TEST(sas, mixer_kernels_match_scalar_code) {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dist(-40000.0f, 40000.0f);
+
+    // odd sizes go through the scalar tails as well
+    for (const int frames : { 1, 7, 64, 333 }) {
+        std::vector<float> mono(frames), stereo(frames * 2), dest(frames * 2), expected(frames * 2);
+        for (auto &s : mono)
+            s = dist(gen);
+        for (auto &s : stereo)
+            s = dist(gen);
+        for (int i = 0; i < frames * 2; i++)
+            dest[i] = expected[i] = dist(gen);
+
+        mixer::mix_mono(mono.data(), dest.data(), frames, 0.25f, -0.5f);
+        mixer::mix_stereo(stereo.data(), dest.data(), frames, 0.75f, 0.125f);
+        for (int i = 0; i < frames; i++) {
+            expected[i * 2] = (expected[i * 2] + mono[i] * 0.25f) + stereo[i * 2] * 0.75f;
+            expected[i * 2 + 1] = (expected[i * 2 + 1] + mono[i] * -0.5f) + stereo[i * 2 + 1] * 0.125f;
+        }
+        for (int i = 0; i < frames * 2; i++)
+            ASSERT_FLOAT_EQ(dest[i], expected[i]) << frames << " " << i;
+
+        std::vector<int16_t> converted(frames * 2);
+        mixer::to_s16(dest.data(), converted.data(), frames * 2);
+        for (int i = 0; i < frames * 2; i++)
+            ASSERT_EQ(converted[i], static_cast<int16_t>(std::lrint(std::clamp(dest[i], -32768.0f, 32767.0f)))) << i;
+
+        std::vector<int16_t> mixed = converted;
+        mixer::mix_s16(stereo.data(), mixed.data(), frames, 0.5f, 2.0f);
+        for (int i = 0; i < frames * 2; i++) {
+            const float sum = stereo[i] + converted[i] * ((i & 1) ? 2.0f : 0.5f);
+            ASSERT_EQ(mixed[i], static_cast<int16_t>(std::lrint(std::clamp(sum, -32768.0f, 32767.0f)))) << i;
+        }
+
+        int32_t left, right;
+        mixer::peak(mono.data(), frames / 2, left, right);
+        float l = 0.0f, r = 0.0f;
+        for (int i = 0; i < frames / 2; i++) {
+            l = std::max(l, std::abs(mono[i * 2]));
+            r = std::max(r, std::abs(mono[i * 2 + 1]));
+        }
+        EXPECT_EQ(left, static_cast<int32_t>(std::min(l, 32767.0f)));
+        EXPECT_EQ(right, static_cast<int32_t>(std::min(r, 32767.0f)));
+    }
+}
+
+TEST(sas, parses_config_strings) {
+    Config config;
+    EXPECT_TRUE(parse_config("numGrains=512 numVoices=16 numReverbs=0", config));
+    EXPECT_EQ(config.grain, 512);
+    EXPECT_EQ(config.voices, 16);
+    EXPECT_EQ(config.reverbs, 0);
+
+    Config defaults;
+    EXPECT_TRUE(parse_config(nullptr, defaults));
+    EXPECT_EQ(defaults.grain, DEFAULT_GRAIN);
+
+    Config bad;
+    EXPECT_FALSE(parse_config("numVoices=64", bad));
+    EXPECT_FALSE(parse_config("numGrains", bad));
+}
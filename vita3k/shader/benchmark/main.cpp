@@ -0,0 +1,262 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Decodes the USSE instructions of a set of GXP programs with the decode table and with the
+// linear search through the matchers it replaced, and reports how many instructions each
+// of them gets through per millisecond.
+// Then translates every program to SPIR-V and reports what the SPIR-V optimizer makes of
+// it: the instruction counts before and after, the time spent and whether the optimized
+// module still validates and goes through SPIRV-Cross.
+
+#include <gxm/types.h>
+#include <shader/spirv_optimizer.h>
+#include <shader/spirv_recompiler.h>
+#include <shader/usse_decoder.h>
+#include <shader/usse_translator.h>
+#include <util/fs.h>
+
+#include <fmt/core.h>
+#include <spirv_glsl.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace shader;
+
+namespace {
+
+using TranslatorMatcher = decoder::Matcher<usse::USSETranslatorVisitor, uint64_t>;
+
+struct Options {
+    std::vector<std::string> paths;
+    double seconds = 1.0;
+};
+
+struct Program {
+    std::string name;
+    std::vector<char> bytes;
+};
+
+// Append the primary and secondary programs of a GXP file to instructions and the file itself to programs
+bool load_gxp(const fs::path &path, std::vector<uint64_t> &instructions, std::vector<Program> &programs) {
+    fs::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        return false;
+
+    const std::vector<char> bytes{ std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+    if (bytes.size() < sizeof(SceGxmProgram) || std::memcmp(bytes.data(), "GXP", 4) != 0)
+        return false;
+
+    const auto &program = *reinterpret_cast<const SceGxmProgram *>(bytes.data());
+    const auto *begin = reinterpret_cast<const uint64_t *>(bytes.data());
+    const auto *end = reinterpret_cast<const uint64_t *>(bytes.data() + bytes.size());
+    const auto append = [&](const uint64_t *first, const uint64_t *last) {
+        if (first < begin || last > end || first > last)
+            return false;
+        instructions.insert(instructions.end(), first, last);
+        return true;
+    };
+
+    const uint64_t *primary = program.primary_program_start();
+    if (!append(primary, primary + program.primary_program_instr_count)
+        || !append(program.secondary_program_start(), program.secondary_program_end()))
+        return false;
+
+    programs.push_back({ path.filename().string(), bytes });
+    return true;
+}
+
+// Run decode over all the instructions for the given time, returns the instructions decoded per millisecond
+double time_decoder(const Options &options, const std::vector<uint64_t> &instructions, const std::function<size_t(uint64_t)> &decode) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const auto deadline = start + std::chrono::duration<double>(options.seconds);
+    uint64_t decoded = 0;
+    size_t checksum = 0;
+    auto now = start;
+    while (now < deadline) {
+        for (const uint64_t instruction : instructions)
+            checksum += decode(instruction);
+        decoded += instructions.size();
+        now = clock::now();
+    }
+
+    // keep the decoding from being optimized out
+    if (checksum == 0)
+        fmt::print("");
+
+    return decoded / std::chrono::duration<double, std::milli>(now - start).count();
+}
+
+// Translate every program to SPIR-V and report how the optimizer shrinks them, returns false if any optimized module is broken
+bool report_optimizer(const std::vector<Program> &programs) {
+    using clock = std::chrono::steady_clock;
+
+    // the same defaults as convert_gxp_to_glsl_from_filepath, the hints are not available offline
+    const FeatureState features{
+        .support_shader_interlock = true,
+        .direct_fragcolor = false
+    };
+    Hints hints{
+        .attributes = nullptr,
+        .color_format = SCE_GXM_COLOR_FORMAT_U8U8U8U8_ABGR,
+    };
+    std::fill_n(hints.vertex_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+    std::fill_n(hints.fragment_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+
+    size_t optimized = 0;
+    size_t skipped = 0;
+    size_t failures = 0;
+    size_t count_before = 0;
+    size_t count_after = 0;
+    std::chrono::duration<double, std::milli> elapsed{};
+    for (const Program &program : programs) {
+        const auto &gxp = *reinterpret_cast<const SceGxmProgram *>(program.bytes.data());
+        usse::SpirvCode spirv = convert_gxp(gxp, program.name, features, Target::SpirVVulkan, hints).spirv;
+
+        // only look at the modules the translator got right
+        if (spirv.empty() || !validate_spirv(spirv)) {
+            skipped++;
+            continue;
+        }
+
+        const size_t before = count_spirv_instructions(spirv);
+        const auto start = clock::now();
+        if (!optimize_spirv(spirv)) {
+            skipped++;
+            continue;
+        }
+        elapsed += clock::now() - start;
+
+        std::string error;
+        if (!validate_spirv(spirv, &error)) {
+            fmt::print("{}: the optimized module is invalid: {}\n", program.name, error);
+            failures++;
+            continue;
+        }
+
+        try {
+            spirv_cross::CompilerGLSL glsl(spirv);
+            glsl.compile();
+        } catch (const spirv_cross::CompilerError &e) {
+            fmt::print("{}: SPIRV-Cross rejected the optimized module: {}\n", program.name, e.what());
+            failures++;
+            continue;
+        }
+
+        optimized++;
+        count_before += before;
+        count_after += count_spirv_instructions(spirv);
+    }
+
+    fmt::print("\n{} programs optimized, {} skipped, {} failures\n", optimized, skipped, failures);
+    if (optimized > 0) {
+        fmt::print("{:<16} {:>18}\n", "instructions", "count");
+        fmt::print("{:<16} {:>18}\n", "before", count_before);
+        fmt::print("{:<16} {:>18} ({:.1f}% fewer)\n", "after", count_after, 100.0 * (static_cast<double>(count_before) - static_cast<double>(count_after)) / count_before);
+        fmt::print("{:.3f} ms per program\n", elapsed.count() / optimized);
+    }
+
+    return failures == 0;
+}
+
+void print_usage() {
+    fmt::print("Usage: shader-benchmark [--seconds S] <file.gxp or directory>...\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--seconds") {
+            if (i + 1 >= argc) {
+                print_usage();
+                return 1;
+            }
+            options.seconds = std::stod(argv[++i]);
+        } else {
+            options.paths.push_back(arg);
+        }
+    }
+
+    if (options.paths.empty() || options.seconds <= 0.0) {
+        print_usage();
+        return 1;
+    }
+
+    std::vector<uint64_t> instructions;
+    std::vector<Program> programs;
+    for (const std::string &path : options.paths) {
+        if (fs::is_directory(path)) {
+            for (const auto &entry : fs::recursive_directory_iterator(path)) {
+                if (fs::is_regular_file(entry.path()) && entry.path().extension() == ".gxp")
+                    load_gxp(entry.path(), instructions, programs);
+            }
+        } else if (!load_gxp(path, instructions, programs)) {
+            fmt::print("Skipping {}, not a GXP program\n", path);
+        }
+    }
+
+    if (instructions.empty()) {
+        fmt::print("No instruction to decode\n");
+        return 1;
+    }
+
+    const auto matchers = usse::GetUSSEMatchers<TranslatorMatcher>();
+    const auto find_linear = [&](const uint64_t instruction) -> const TranslatorMatcher * {
+        const auto iter = std::find_if(matchers.begin(), matchers.end(), [instruction](const auto &matcher) { return matcher.Matches(instruction); });
+        return iter != matchers.end() ? &*iter : nullptr;
+    };
+
+    // both decoders must pick the same handler
+    size_t unmatched = 0;
+    for (const uint64_t instruction : instructions) {
+        const TranslatorMatcher *linear = find_linear(instruction);
+        const auto *table = usse::DecodeUSSE<usse::USSETranslatorVisitor>(instruction);
+        if ((linear == nullptr) != (table == nullptr) || (linear && std::strcmp(linear->GetName(), table->GetName()) != 0)) {
+            fmt::print("Decoders disagree on {:016x}\n", instruction);
+            return 1;
+        }
+        unmatched += (linear == nullptr);
+    }
+
+    fmt::print("{} programs, {} instructions ({} unmatched)\n", programs.size(), instructions.size(), unmatched);
+    fmt::print("{:<16} {:>18}\n", "decoder", "instructions/ms");
+
+    // the linear decoder returned a copy of the matcher, std::function included
+    const double linear = time_decoder(options, instructions, [&](const uint64_t instruction) -> size_t {
+        const TranslatorMatcher *matcher = find_linear(instruction);
+        const auto copy = matcher ? std::optional<const TranslatorMatcher>(*matcher) : std::nullopt;
+        return copy.has_value();
+    });
+    fmt::print("{:<16} {:>18.0f}\n", "linear", linear);
+
+    const double table = time_decoder(options, instructions, [](const uint64_t instruction) -> size_t {
+        return usse::DecodeUSSE<usse::USSETranslatorVisitor>(instruction) != nullptr;
+    });
+    fmt::print("{:<16} {:>18.0f} ({:.1f}x)\n", "table", table, table / linear);
+
+    return report_optimizer(programs) ? 0 : 1;
+}
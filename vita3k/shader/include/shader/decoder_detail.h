@@ -12,9 +12,24 @@
 #include <array>
 #include <cassert>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace shader::decoder::detail {
 
+/**
+ * A bitstring which can be given as a template argument, so that the
+ * masks and shifts it describes are known at compile time.
+ */
+template <size_t N>
+struct BitString {
+    constexpr BitString(const char (&str)[N]) {
+        std::copy_n(str, N, bits);
+    }
+
+    char bits[N] = {};
+};
+
 /**
  * Helper functions for the decoders.
  *
@@ -33,7 +48,7 @@ private:
      * A '0' in a bitstring indicates that a zero must be present at that bit position.
      * A '1' in a bitstring indicates that a one must be present at that bit position.
      */
-    static auto GetMaskAndExpect(const char *const bitstring) {
+    static constexpr auto GetMaskAndExpect(const char *const bitstring) {
         const auto one = static_cast<opcode_type>(1);
         opcode_type mask = 0, expect = 0;
         for (size_t i = 0; i < opcode_bitsize; i++) {
@@ -60,7 +75,7 @@ private:
      * An argument is specified by a continuous string of the same character.
      */
     template <size_t N>
-    static auto GetArgInfo(const char *const bitstring) {
+    static constexpr auto GetArgInfo(const char *const bitstring) {
         const auto one = static_cast<opcode_type>(1);
         std::array<opcode_type, N> masks = {};
         std::array<size_t, N> shifts = {};
@@ -139,6 +154,32 @@ private:
             };
         }
     };
+
+    /**
+     * Same as VisitorCaller, but the Visitor member function and the bitstring are template
+     * arguments: the masks and shifts of the arguments are constants of the generated function.
+     */
+    template <typename FnT>
+    struct StaticCaller;
+
+    template <typename Visitor, typename... Args, typename CallRetT>
+    struct StaticCaller<CallRetT (Visitor::*)(Args...)> {
+        template <CallRetT (Visitor::*fn)(Args...), BitString bitstring>
+        static CallRetT Call(Visitor &v, opcode_type instruction) {
+            static_assert(std::is_same<visitor_type, Visitor>::value, "Member function is not from Matcher's Visitor");
+            return Invoke<fn, bitstring>(v, instruction, std::index_sequence_for<Args...>());
+        }
+
+    private:
+        template <CallRetT (Visitor::*fn)(Args...), BitString bitstring, size_t... iota>
+        static CallRetT Invoke(Visitor &v, opcode_type instruction, std::index_sequence<iota...>) {
+            static constexpr auto arg_info = GetArgInfo<sizeof...(iota)>(bitstring.bits);
+            static constexpr std::array<opcode_type, sizeof...(iota)> arg_masks = std::get<0>(arg_info);
+            static constexpr std::array<size_t, sizeof...(iota)> arg_shifts = std::get<1>(arg_info);
+            (void)instruction;
+            return (v.*fn)(static_cast<Args>((instruction & arg_masks[iota]) >> arg_shifts[iota])...);
+        }
+    };
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
@@ -159,6 +200,23 @@ public:
 
         return MatcherT(name, mask, expect, proxy_fn);
     }
+
+    /**
+     * Creates a matcher for a Visitor member function known at compile time.
+     * A StaticMatcher calls a function generated for fn and bitstring, other
+     * matchers are made by GetMatcher.
+     */
+    template <auto fn, BitString bitstring>
+    static constexpr MatcherT Make(const char *const name) {
+        static_assert(sizeof(bitstring.bits) == opcode_bitsize + 1, "Bitstring doesn't match the opcode size");
+
+        if constexpr (std::is_pointer_v<typename MatcherT::handler_function>) {
+            const auto mask_expect = GetMaskAndExpect(bitstring.bits);
+            return MatcherT{ name, std::get<0>(mask_expect), std::get<1>(mask_expect), &StaticCaller<decltype(fn)>::template Call<fn, bitstring> };
+        } else {
+            return GetMatcher(fn, name, bitstring.bits);
+        }
+    }
 };
 
 } // namespace shader::decoder::detail
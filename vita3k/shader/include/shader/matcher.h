@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <functional>
 
 namespace shader::decoder {
@@ -76,4 +78,132 @@ private:
     handler_function fn;
 };
 
+/**
+ * Matcher generated at compile time.
+ *
+ * The handler is a plain function which extracts the arguments of the
+ * visitor function with constant masks and shifts, see
+ * detail::Make.
+ */
+template <typename Visitor, typename OpcodeType>
+struct StaticMatcher {
+    using opcode_type = OpcodeType;
+    using visitor_type = Visitor;
+    using handler_return_type = typename Visitor::instruction_return_type;
+    using handler_function = handler_return_type (*)(Visitor &, opcode_type);
+
+    const char *name;
+    opcode_type mask;
+    opcode_type expected;
+    handler_function fn;
+
+    /// Gets the name of this type of instruction.
+    constexpr const char *GetName() const {
+        return name;
+    }
+
+    /// Gets the mask for this instruction.
+    constexpr opcode_type GetMask() const {
+        return mask;
+    }
+
+    /// Gets the expected value after masking for this instruction.
+    constexpr opcode_type GetExpected() const {
+        return expected;
+    }
+
+    /**
+     * Tests to see if the given instruction is the instruction this matcher represents.
+     * @param instruction The instruction to test
+     * @returns true if the given instruction matches.
+     */
+    constexpr bool Matches(opcode_type instruction) const {
+        return (instruction & mask) == expected;
+    }
+
+    /**
+     * Calls the corresponding instruction handler on visitor for this type of instruction.
+     * @param v The visitor to use
+     * @param instruction The instruction to decode.
+     */
+    handler_return_type call(Visitor &v, opcode_type instruction) const {
+        assert(Matches(instruction));
+        return fn(v, instruction);
+    }
+};
+
+/**
+ * Lookup table of matchers indexed by the top bits of an instruction.
+ *
+ * Each slot lists the matchers which can match an instruction starting
+ * with its bits, in the order they are given, so Decode finds the same
+ * matcher as a linear search through all of them. Most slots hold a
+ * single matcher.
+ *
+ * @tparam MatcherT The type of the Matcher to use.
+ * @tparam Count Number of matchers in the table.
+ * @tparam IndexBits Number of top bits of the instruction used as index.
+ */
+template <typename MatcherT, size_t Count, size_t IndexBits = 8>
+class DecodeTable {
+public:
+    using opcode_type = typename MatcherT::opcode_type;
+
+    static_assert(Count <= UINT8_MAX, "Too many matchers");
+    static_assert(IndexBits > 0 && IndexBits <= 16, "Invalid index size");
+
+    constexpr explicit DecodeTable(const std::array<MatcherT, Count> &table)
+        : matchers{ table } {
+        for (size_t index = 0; index < slots.size(); index++) {
+            Slot &slot = slots[index];
+            const opcode_type bits = static_cast<opcode_type>(index) << shift;
+
+            for (size_t i = 0; i < Count; i++) {
+                const MatcherT &matcher = matchers[i];
+                if ((bits & matcher.GetMask() & index_mask) != (matcher.GetExpected() & index_mask))
+                    continue;
+
+                slot.matchers[slot.count++] = static_cast<uint8_t>(i);
+
+                // Matched on the index alone, the next matchers can't be reached
+                if ((matcher.GetMask() & ~index_mask) == 0)
+                    break;
+            }
+        }
+    }
+
+    /**
+     * Finds the matcher of the given instruction.
+     * @param instruction The instruction to decode.
+     * @returns the first matcher matching the instruction, nullptr if there is none.
+     */
+    constexpr const MatcherT *Decode(opcode_type instruction) const {
+        const Slot &slot = slots[instruction >> shift];
+        for (size_t i = 0; i < slot.count; i++) {
+            const MatcherT &matcher = matchers[slot.matchers[i]];
+            if (matcher.Matches(instruction))
+                return &matcher;
+        }
+
+        return nullptr;
+    }
+
+    /// Gets the matchers of this table, in matching order.
+    constexpr const std::array<MatcherT, Count> &GetMatchers() const {
+        return matchers;
+    }
+
+private:
+    static constexpr size_t shift = sizeof(opcode_type) * 8 - IndexBits;
+    static constexpr opcode_type index_mask = static_cast<opcode_type>(~opcode_type{}) << shift;
+
+    struct Slot {
+        std::array<uint8_t, Count> matchers{};
+        uint8_t count = 0;
+    };
+
+    std::array<MatcherT, Count> matchers;
+    std::array<Slot, size_t{ 1 } << IndexBits> slots{};
+};
+
 } // namespace shader::decoder
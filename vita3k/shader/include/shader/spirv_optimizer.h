@@ -0,0 +1,39 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <shader/usse_translator_types.h>
+
+#include <string>
+
+// SPIRV-Tools run on the SPIR-V modules emitted by the recompiler before they get cached: the
+// performance passes of spirv-opt, which turn the register banks indexed with constants into SSA
+// values and clean up the copies, constants and dead code the translation leaves behind.
+namespace shader {
+
+// Optimize the module in place. Returns false and leaves it untouched if it is not valid or the
+// optimizer fails.
+bool optimize_spirv(usse::SpirvCode &spirv);
+
+// Validation of a module by the SPIRV-Tools validator. Its messages are stored in error.
+bool validate_spirv(const usse::SpirvCode &spirv, std::string *error = nullptr);
+
+// Number of instructions of the module, debug information excluded
+size_t count_spirv_instructions(const usse::SpirvCode &spirv);
+
+} // namespace shader
@@ -0,0 +1,103 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <shader/spirv_optimizer.h>
+
+#include <util/log.h>
+
+#include <SPIRV/spirv.hpp>
+#include <spirv-tools/libspirv.hpp>
+#include <spirv-tools/optimizer.hpp>
+
+namespace shader {
+
+namespace {
+
+// The recompiler targets both Vulkan and OpenGL, the modules are checked against the core rules
+// of the highest SPIR-V version Vulkan 1.1 accepts
+constexpr spv_target_env TARGET_ENV = SPV_ENV_UNIVERSAL_1_3;
+
+constexpr uint32_t HEADER_SIZE = 5;
+
+bool is_debug(const spv::Op op) {
+    switch (op) {
+    case spv::OpSourceContinued:
+    case spv::OpSource:
+    case spv::OpSourceExtension:
+    case spv::OpName:
+    case spv::OpMemberName:
+    case spv::OpString:
+    case spv::OpLine:
+    case spv::OpNoLine:
+    case spv::OpModuleProcessed:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Appends the messages of SPIRV-Tools to messages, one per line
+spvtools::MessageConsumer collect_messages(std::string &messages) {
+    return [&messages](spv_message_level_t, const char *, const spv_position_t &position, const char *message) {
+        if (!messages.empty())
+            messages += '\n';
+        messages += fmt::format("word {}: {}", position.index, message);
+    };
+}
+
+} // namespace
+
+bool optimize_spirv(usse::SpirvCode &spirv) {
+    std::string messages;
+    spvtools::Optimizer optimizer(TARGET_ENV);
+    optimizer.SetMessageConsumer(collect_messages(messages));
+    optimizer.RegisterPerformancePasses();
+
+    // the module is validated before the passes run, the invalid ones are left as they are
+    usse::SpirvCode optimized;
+    if (!optimizer.Run(spirv.data(), spirv.size(), &optimized)) {
+        LOG_DEBUG("Skipping the optimization of a SPIR-V module: {}", messages);
+        return false;
+    }
+
+    spirv = std::move(optimized);
+    return true;
+}
+
+bool validate_spirv(const usse::SpirvCode &spirv, std::string *error) {
+    std::string messages;
+    spvtools::SpirvTools tools(TARGET_ENV);
+    tools.SetMessageConsumer(collect_messages(messages));
+    const bool valid = tools.Validate(spirv.data(), spirv.size());
+    if (!valid && error)
+        *error = messages;
+    return valid;
+}
+
+size_t count_spirv_instructions(const usse::SpirvCode &spirv) {
+    size_t count = 0;
+    for (size_t position = HEADER_SIZE; position < spirv.size();) {
+        const uint32_t word_count = spirv[position] >> 16;
+        if (word_count == 0)
+            break;
+        count += !is_debug(static_cast<spv::Op>(spirv[position] & 0xFFFF));
+        position += word_count;
+    }
+    return count;
+}
+
+} // namespace shader
@@ -16,6 +16,7 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <shader/spirv_optimizer.h>
 #include <shader/spirv_recompiler.h>
 #include <shader/uniform_block.h>
 #include <shader/usse_disasm.h>
@@ -1894,6 +1895,9 @@ static SpirvCode convert_gxp_to_spirv_impl(const SceGxmProgram &program, const s
 
     b.dump(spirv);
 
+    if (features.optimize_spirv)
+        optimize_spirv(spirv);
+
     if (LOG_SHADER_CODE || force_shader_debug) {
         std::string spirv_dump;
         spirv_disasm_print(spirv, &spirv_dump);
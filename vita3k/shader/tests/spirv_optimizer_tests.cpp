@@ -0,0 +1,338 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <shader/spirv_optimizer.h>
+
+#include <SPIRV/spirv.hpp>
+
+#include <gtest/gtest.h>
+
+#include <bit>
+#include <string>
+#include <vector>
+
+using namespace shader;
+
+namespace {
+
+// Assembles a fragment shader with a main function writing to a float output. The tests add their
+// own declarations and the body of main.
+struct Assembler {
+    uint32_t bound = 1;
+    std::vector<uint32_t> names;
+    std::vector<uint32_t> globals;
+    std::vector<uint32_t> code;
+
+    uint32_t id() {
+        return bound++;
+    }
+
+    static void emit(std::vector<uint32_t> &section, const spv::Op op, const std::vector<uint32_t> &operands) {
+        section.push_back(static_cast<uint32_t>((operands.size() + 1) << 16) | op);
+        section.insert(section.end(), operands.begin(), operands.end());
+    }
+
+    uint32_t type(const spv::Op op, const std::vector<uint32_t> &operands) {
+        const uint32_t result = id();
+        std::vector<uint32_t> words{ result };
+        words.insert(words.end(), operands.begin(), operands.end());
+        emit(globals, op, words);
+        return result;
+    }
+
+    uint32_t global(const spv::Op op, const uint32_t result_type, const std::vector<uint32_t> &operands) {
+        const uint32_t result = id();
+        std::vector<uint32_t> words{ result_type, result };
+        words.insert(words.end(), operands.begin(), operands.end());
+        emit(globals, op, words);
+        return result;
+    }
+
+    uint32_t value(const spv::Op op, const uint32_t result_type, const std::vector<uint32_t> &operands) {
+        const uint32_t result = id();
+        std::vector<uint32_t> words{ result_type, result };
+        words.insert(words.end(), operands.begin(), operands.end());
+        emit(code, op, words);
+        return result;
+    }
+
+    void op(const spv::Op op, const std::vector<uint32_t> &operands) {
+        emit(code, op, operands);
+    }
+
+    void name(const uint32_t target, const std::string &str) {
+        std::vector<uint32_t> words{ target };
+        for (size_t i = 0; i <= str.size(); i += 4) {
+            uint32_t word = 0;
+            for (size_t byte = 0; byte < 4 && i + byte < str.size(); byte++)
+                word |= static_cast<uint32_t>(str[i + byte]) << (byte * 8);
+            words.push_back(word);
+        }
+        emit(names, spv::OpName, words);
+    }
+
+    // Common declarations
+    uint32_t main = id();
+    uint32_t type_void = type(spv::OpTypeVoid, {});
+    uint32_t type_main = type(spv::OpTypeFunction, { type_void });
+    uint32_t type_bool = type(spv::OpTypeBool, {});
+    uint32_t type_float = type(spv::OpTypeFloat, { 32 });
+    uint32_t type_int = type(spv::OpTypeInt, { 32, 1 });
+    uint32_t type_uint = type(spv::OpTypeInt, { 32, 0 });
+    uint32_t type_vec4 = type(spv::OpTypeVector, { type_float, 4 });
+    uint32_t pointer_output_float = type(spv::OpTypePointer, { spv::StorageClassOutput, type_float });
+    uint32_t output = global(spv::OpVariable, pointer_output_float, { spv::StorageClassOutput });
+
+    uint32_t constant(const uint32_t constant_type, const uint32_t value) {
+        return global(spv::OpConstant, constant_type, { value });
+    }
+
+    uint32_t constant(const float value) {
+        return constant(type_float, std::bit_cast<uint32_t>(value));
+    }
+
+    usse::SpirvCode finish(const std::vector<uint32_t> &interface = {}) {
+        usse::SpirvCode spirv{ spv::MagicNumber, 0x00010300, 0, 0, 0 };
+        emit(spirv, spv::OpCapability, { 1 });
+        emit(spirv, spv::OpMemoryModel, { 0, 1 });
+        // "main"
+        std::vector<uint32_t> entry_point{ spv::ExecutionModelFragment, main, 0x6E69616D, 0, output };
+        entry_point.insert(entry_point.end(), interface.begin(), interface.end());
+        emit(spirv, spv::OpEntryPoint, entry_point);
+        emit(spirv, spv::OpExecutionMode, { main, 7 });
+        spirv.insert(spirv.end(), names.begin(), names.end());
+        spirv.insert(spirv.end(), globals.begin(), globals.end());
+        emit(spirv, spv::OpFunction, { type_void, main, 0, type_main });
+        emit(spirv, spv::OpLabel, { id() });
+        spirv.insert(spirv.end(), code.begin(), code.end());
+        emit(spirv, spv::OpReturn, {});
+        emit(spirv, spv::OpFunctionEnd, {});
+        spirv[3] = bound;
+        return spirv;
+    }
+};
+
+// Operands of the instructions of a module with the given opcode, result type and id included
+std::vector<std::vector<uint32_t>> find_all(const usse::SpirvCode &spirv, const spv::Op op) {
+    std::vector<std::vector<uint32_t>> found;
+    for (size_t position = 5; position < spirv.size();) {
+        const uint32_t word_count = spirv[position] >> 16;
+        if ((spirv[position] & 0xFFFF) == static_cast<uint32_t>(op))
+            found.emplace_back(spirv.begin() + position + 1, spirv.begin() + position + word_count);
+        position += word_count;
+    }
+    return found;
+}
+
+// Value stored to the output by main
+uint32_t output_value(const usse::SpirvCode &spirv, const Assembler &assembler) {
+    for (const auto &store : find_all(spirv, spv::OpStore)) {
+        if (store[0] == assembler.output)
+            return store[1];
+    }
+    return 0;
+}
+
+std::vector<uint32_t> find_def(const usse::SpirvCode &spirv, const spv::Op op, const uint32_t id) {
+    for (const auto &inst : find_all(spirv, op)) {
+        if (inst.size() > 1 && inst[1] == id)
+            return inst;
+    }
+    return {};
+}
+
+void optimize_valid(usse::SpirvCode &spirv) {
+    std::string error;
+    ASSERT_TRUE(validate_spirv(spirv, &error)) << error;
+    const size_t before = count_spirv_instructions(spirv);
+    ASSERT_TRUE(optimize_spirv(spirv));
+    ASSERT_TRUE(validate_spirv(spirv, &error)) << error;
+    EXPECT_LT(count_spirv_instructions(spirv), before);
+}
+
+} // namespace
+
+TEST(spirv_optimizer, scalarizes_constantly_indexed_arrays) {
+    Assembler a;
+    const uint32_t four = a.constant(a.type_uint, 4);
+    const uint32_t one = a.constant(a.type_uint, 1);
+    const uint32_t two = a.constant(2.0f);
+    const uint32_t type_array = a.type(spv::OpTypeArray, { a.type_float, four });
+    const uint32_t pointer_array = a.type(spv::OpTypePointer, { spv::StorageClassPrivate, type_array });
+    const uint32_t pointer_float = a.type(spv::OpTypePointer, { spv::StorageClassPrivate, a.type_float });
+    const uint32_t bank = a.global(spv::OpVariable, pointer_array, { spv::StorageClassPrivate });
+    a.name(bank, "r");
+
+    const uint32_t store_pointer = a.value(spv::OpAccessChain, pointer_float, { bank, one });
+    a.op(spv::OpStore, { store_pointer, two });
+    const uint32_t load_pointer = a.value(spv::OpAccessChain, pointer_float, { bank, one });
+    const uint32_t loaded = a.value(spv::OpLoad, a.type_float, { load_pointer });
+    a.op(spv::OpStore, { a.output, loaded });
+
+    usse::SpirvCode spirv = a.finish();
+    optimize_valid(spirv);
+
+    EXPECT_TRUE(find_all(spirv, spv::OpAccessChain).empty());
+    EXPECT_TRUE(find_def(spirv, spv::OpVariable, bank).empty());
+    EXPECT_EQ(output_value(spirv, a), two);
+}
+
+TEST(spirv_optimizer, keeps_dynamically_indexed_arrays) {
+    Assembler a;
+    const uint32_t four = a.constant(a.type_uint, 4);
+    const uint32_t one = a.constant(a.type_uint, 1);
+    const uint32_t two = a.constant(2.0f);
+    const uint32_t type_array = a.type(spv::OpTypeArray, { a.type_float, four });
+    const uint32_t pointer_array = a.type(spv::OpTypePointer, { spv::StorageClassPrivate, type_array });
+    const uint32_t pointer_float = a.type(spv::OpTypePointer, { spv::StorageClassPrivate, a.type_float });
+    const uint32_t pointer_input_uint = a.type(spv::OpTypePointer, { spv::StorageClassInput, a.type_uint });
+    const uint32_t bank = a.global(spv::OpVariable, pointer_array, { spv::StorageClassPrivate });
+    const uint32_t input = a.global(spv::OpVariable, pointer_input_uint, { spv::StorageClassInput });
+
+    const uint32_t store_pointer = a.value(spv::OpAccessChain, pointer_float, { bank, one });
+    a.op(spv::OpStore, { store_pointer, two });
+    const uint32_t index = a.value(spv::OpLoad, a.type_uint, { input });
+    const uint32_t load_pointer = a.value(spv::OpAccessChain, pointer_float, { bank, index });
+    const uint32_t loaded = a.value(spv::OpLoad, a.type_float, { load_pointer });
+    a.op(spv::OpStore, { a.output, loaded });
+
+    usse::SpirvCode spirv = a.finish({ input });
+    std::string error;
+    ASSERT_TRUE(optimize_spirv(spirv));
+    ASSERT_TRUE(validate_spirv(spirv, &error)) << error;
+
+    // the bank moves to the function but stays an array, loaded through an access chain
+    EXPECT_FALSE(find_def(spirv, spv::OpVariable, bank).empty());
+    EXPECT_FALSE(find_all(spirv, spv::OpAccessChain).empty());
+    EXPECT_FALSE(find_def(spirv, spv::OpLoad, output_value(spirv, a)).empty());
+}
+
+TEST(spirv_optimizer, folds_constants) {
+    Assembler a;
+    const uint32_t two = a.constant(a.type_int, 2);
+    const uint32_t three = a.constant(a.type_int, 3);
+    const uint32_t one = a.constant(1.0f);
+
+    const uint32_t sum = a.value(spv::OpIAdd, a.type_int, { two, three });
+    const uint32_t converted = a.value(spv::OpConvertSToF, a.type_float, { sum });
+    const uint32_t product = a.value(spv::OpFMul, a.type_float, { converted, one });
+    a.op(spv::OpStore, { a.output, product });
+
+    usse::SpirvCode spirv = a.finish();
+    optimize_valid(spirv);
+
+    EXPECT_TRUE(find_all(spirv, spv::OpIAdd).empty());
+    EXPECT_TRUE(find_all(spirv, spv::OpFMul).empty());
+    const auto constant = find_def(spirv, spv::OpConstant, output_value(spirv, a));
+    ASSERT_EQ(constant.size(), 3u);
+    EXPECT_EQ(constant[2], std::bit_cast<uint32_t>(5.0f));
+}
+
+TEST(spirv_optimizer, propagates_copies_through_composites) {
+    Assembler a;
+    const uint32_t pointer_input_vec4 = a.type(spv::OpTypePointer, { spv::StorageClassInput, a.type_vec4 });
+    const uint32_t input = a.global(spv::OpVariable, pointer_input_vec4, { spv::StorageClassInput });
+
+    const uint32_t vector = a.value(spv::OpLoad, a.type_vec4, { input });
+    const uint32_t shuffled = a.value(spv::OpVectorShuffle, a.type_vec4, { vector, vector, 4, 1, 6, 3 });
+    const uint32_t component = a.value(spv::OpCompositeExtract, a.type_float, { shuffled, 2 });
+    const uint32_t splat = a.value(spv::OpCompositeConstruct, a.type_vec4, { component, component, component, component });
+    const uint32_t extracted = a.value(spv::OpCompositeExtract, a.type_float, { splat, 1 });
+    const uint32_t copy = a.value(spv::OpCopyObject, a.type_float, { extracted });
+    a.op(spv::OpStore, { a.output, copy });
+
+    usse::SpirvCode spirv = a.finish({ input });
+    optimize_valid(spirv);
+
+    EXPECT_TRUE(find_all(spirv, spv::OpVectorShuffle).empty());
+    EXPECT_TRUE(find_all(spirv, spv::OpCompositeConstruct).empty());
+    EXPECT_TRUE(find_all(spirv, spv::OpCopyObject).empty());
+    const auto extract = find_def(spirv, spv::OpCompositeExtract, output_value(spirv, a));
+    ASSERT_EQ(extract.size(), 4u);
+    EXPECT_EQ(extract[2], vector);
+    EXPECT_EQ(extract[3], 2u);
+}
+
+TEST(spirv_optimizer, forwards_stores_within_blocks) {
+    Assembler a;
+    const uint32_t one = a.constant(1.0f);
+    const uint32_t two = a.constant(2.0f);
+    const uint32_t pointer_float = a.type(spv::OpTypePointer, { spv::StorageClassPrivate, a.type_float });
+    const uint32_t temp = a.global(spv::OpVariable, pointer_float, { spv::StorageClassPrivate });
+
+    a.op(spv::OpStore, { temp, one });
+    a.op(spv::OpStore, { temp, two });
+    const uint32_t loaded = a.value(spv::OpLoad, a.type_float, { temp });
+    a.op(spv::OpStore, { a.output, loaded });
+
+    usse::SpirvCode spirv = a.finish();
+    optimize_valid(spirv);
+
+    EXPECT_TRUE(find_def(spirv, spv::OpVariable, temp).empty());
+    EXPECT_TRUE(find_all(spirv, spv::OpLoad).empty());
+    EXPECT_EQ(find_all(spirv, spv::OpStore).size(), 1u);
+    EXPECT_EQ(output_value(spirv, a), two);
+}
+
+TEST(spirv_optimizer, leaves_invalid_modules_untouched) {
+    Assembler a;
+    // a value that is never defined stored to the output
+    a.op(spv::OpStore, { a.output, a.bound + 10 });
+
+    usse::SpirvCode spirv = a.finish();
+    const usse::SpirvCode original = spirv;
+    EXPECT_FALSE(optimize_spirv(spirv));
+    EXPECT_EQ(spirv, original);
+}
+
+TEST(spirv_optimizer, validation_reports_broken_modules) {
+    const auto build = [](const auto &body) {
+        Assembler a;
+        body(a);
+        return a.finish();
+    };
+
+    EXPECT_TRUE(validate_spirv(build([](Assembler &a) {
+        a.op(spv::OpStore, { a.output, a.constant(1.0f) });
+    })));
+
+    std::string error;
+    // undefined id
+    EXPECT_FALSE(validate_spirv(build([](Assembler &a) {
+        a.op(spv::OpStore, { a.output, a.bound + 10 });
+    }),
+        &error));
+    EXPECT_FALSE(error.empty());
+
+    // the loaded type is not the one of the pointer
+    EXPECT_FALSE(validate_spirv(build([](Assembler &a) {
+        const uint32_t loaded = a.value(spv::OpLoad, a.type_int, { a.output });
+        a.op(spv::OpStore, { a.output, loaded });
+    })));
+
+    // a block without terminator before the function ends
+    usse::SpirvCode spirv = build([](Assembler &) {});
+    spirv.erase(spirv.end() - 2);
+    EXPECT_FALSE(validate_spirv(spirv));
+
+    // a value used before its definition
+    EXPECT_FALSE(validate_spirv(build([](Assembler &a) {
+        const uint32_t negated = a.bound + 1;
+        a.op(spv::OpStore, { a.output, negated });
+        a.value(spv::OpFNegate, a.type_float, { a.constant(1.0f) });
+    })));
+}
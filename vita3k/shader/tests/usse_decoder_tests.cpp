@@ -0,0 +1,155 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <shader/usse_decoder.h>
+#include <shader/usse_translator.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace shader;
+
+namespace {
+
+using TranslatorMatcher = decoder::Matcher<usse::USSETranslatorVisitor, uint64_t>;
+
+// Visitor keeping the arguments of the last handler called
+struct RecordingVisitor {
+    using instruction_return_type = bool;
+
+    std::vector<uint64_t> args;
+
+    bool wide(uint8_t op, bool flag, uint16_t offset, uint32_t value) {
+        args = { op, flag, offset, value };
+        return true;
+    }
+
+    bool narrow(uint8_t a, uint8_t b) {
+        args = { a, b };
+        return true;
+    }
+
+    bool none() {
+        args.clear();
+        return false;
+    }
+};
+
+template <typename MatcherT>
+constexpr std::array<MatcherT, 4> make_recording_matchers() {
+    using V = RecordingVisitor;
+    return {
+#define INST(fn, name, bitstring) decoder::detail::detail<MatcherT>::template Make<fn, bitstring>(name)
+        // clang-format off
+        INST(&V::wide,   "WIDE",   "0001oooof---ssssssssssssssssvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv----"),
+        // overlaps with the next one, comes first
+        INST(&V::narrow, "NARROW", "0010------------aaaa-----------------------------------bbbbbbbb1"),
+        INST(&V::none,   "NONE",   "0010------------------------------------------------------------"),
+        INST(&V::none,   "NONE2",  "1111111111111111000000000000000000000000000000000000000000000000"),
+        // clang-format on
+#undef INST
+    };
+}
+
+const TranslatorMatcher *find_linear(const std::array<TranslatorMatcher, usse::USSE_INSTRUCTION_COUNT> &matchers, const uint64_t instruction) {
+    const auto iter = std::find_if(matchers.begin(), matchers.end(), [instruction](const auto &matcher) { return matcher.Matches(instruction); });
+    return iter != matchers.end() ? &*iter : nullptr;
+}
+
+void expect_same_match(const std::array<TranslatorMatcher, usse::USSE_INSTRUCTION_COUNT> &matchers, const uint64_t instruction) {
+    const TranslatorMatcher *linear = find_linear(matchers, instruction);
+    const auto *table = usse::DecodeUSSE<usse::USSETranslatorVisitor>(instruction);
+
+    ASSERT_EQ(linear == nullptr, table == nullptr) << std::hex << instruction;
+    if (linear)
+        ASSERT_STREQ(linear->GetName(), table->GetName()) << std::hex << instruction;
+}
+
+} // namespace
+
+TEST(usse_decoder, table_matches_linear_decoder) {
+    const auto matchers = usse::GetUSSEMatchers<TranslatorMatcher>();
+    std::mt19937_64 gen(42);
+
+    // every encoding, with random values in its fields
+    for (const TranslatorMatcher &matcher : matchers) {
+        for (int i = 0; i < 10000; i++)
+            expect_same_match(matchers, (gen() & ~matcher.GetMask()) | matcher.GetExpected());
+    }
+
+    for (int i = 0; i < 1000000; i++)
+        expect_same_match(matchers, gen());
+}
+
+TEST(usse_decoder, table_keeps_the_matchers_order) {
+    const auto &table = usse::usse_decode_table<usse::USSETranslatorVisitor>;
+    const auto matchers = usse::GetUSSEMatchers<TranslatorMatcher>();
+
+    for (size_t i = 0; i < matchers.size(); i++) {
+        EXPECT_STREQ(table.GetMatchers()[i].GetName(), matchers[i].GetName());
+        EXPECT_EQ(table.GetMatchers()[i].GetMask(), matchers[i].GetMask());
+        EXPECT_EQ(table.GetMatchers()[i].GetExpected(), matchers[i].GetExpected());
+    }
+}
+
+TEST(usse_decoder, static_matcher_extracts_the_same_fields) {
+    using Dynamic = decoder::Matcher<RecordingVisitor, uint64_t>;
+    using Static = decoder::StaticMatcher<RecordingVisitor, uint64_t>;
+
+    const auto dynamic_matchers = make_recording_matchers<Dynamic>();
+    constexpr decoder::DecodeTable<Static, 4> table{ make_recording_matchers<Static>() };
+
+    std::mt19937_64 gen(7);
+    for (int i = 0; i < 100000; i++) {
+        uint64_t instruction = gen();
+        // most random words would match nothing
+        if (i % 2 == 0)
+            instruction = (instruction & ~(uint64_t(0xF) << 60)) | (uint64_t(gen() % 3) << 60);
+
+        const auto dynamic = std::find_if(dynamic_matchers.begin(), dynamic_matchers.end(), [instruction](const auto &matcher) { return matcher.Matches(instruction); });
+        const Static *matcher = table.Decode(instruction);
+        ASSERT_EQ(dynamic == dynamic_matchers.end(), matcher == nullptr);
+        if (!matcher)
+            continue;
+
+        ASSERT_STREQ(dynamic->GetName(), matcher->GetName());
+        RecordingVisitor expected, actual;
+        EXPECT_EQ(dynamic->call(expected, instruction), matcher->call(actual, instruction));
+        EXPECT_EQ(expected.args, actual.args);
+    }
+}
+
+TEST(usse_decoder, first_matcher_wins) {
+    using Static = decoder::StaticMatcher<RecordingVisitor, uint64_t>;
+    constexpr decoder::DecodeTable<Static, 4> table{ make_recording_matchers<Static>() };
+
+    // NARROW needs its last bit set, NONE takes the others
+    static_assert(std::string_view(table.Decode(0x2000000000000001)->GetName()) == "NARROW");
+    static_assert(std::string_view(table.Decode(0x2000000000000000)->GetName()) == "NONE");
+    static_assert(std::string_view(table.Decode(0xFFFF000000000000)->GetName()) == "NONE2");
+    static_assert(table.Decode(0xFFFF000000000001) == nullptr);
+    static_assert(table.Decode(0x4000000000000000) == nullptr);
+
+    RecordingVisitor visitor;
+    table.Decode(0x1A81234567890ABC)->call(visitor, 0x1A81234567890ABC);
+    EXPECT_EQ(visitor.args, (std::vector<uint64_t>{ 0xA, 1, 0x1234, 0x567890AB }));
+}
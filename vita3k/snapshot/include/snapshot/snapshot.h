@@ -0,0 +1,50 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <cstdint>
+
+struct EmuEnvState;
+
+namespace snapshot {
+
+struct SnapshotStats {
+    uint64_t allocated_bytes = 0;
+    uint64_t stored_bytes = 0; // bytes actually written to or read from the snapshot file
+    uint32_t chunk_count = 0;
+    uint32_t zero_chunks = 0;
+    uint32_t base_chunks = 0; // chunks taken from the base snapshot
+    uint32_t mapped_chunks = 0; // chunks mapped copy-on-write from the snapshot files instead of copied
+    uint32_t thread_count = 0;
+    float elapsed_ms = 0;
+};
+
+/// Save the state of the running app: the guest memory, the threads, the kernel objects, the open files,
+/// the audio ports, the display state and the state of the HLE libraries which registered a snapshot handler.
+/// If base is set, the chunks of memory which did not change since the base snapshot are not stored again.
+/// The threads are paused while saving and resumed afterwards. Nothing is saved while a thread runs a callback.
+bool save(const fs::path &path, EmuEnvState &emuenv, const fs::path &base = {}, SnapshotStats *stats = nullptr);
+
+/// Restore a snapshot in a new run of the emulator, after the app is loaded by load_app and instead of starting it.
+/// The guest memory is mapped copy-on-write from the snapshot files when the platform allows it.
+/// The threads are resumed once everything is restored, those which were waiting in a kernel call make the call again.
+bool load(const fs::path &path, EmuEnvState &emuenv, SnapshotStats *stats = nullptr);
+
+} // namespace snapshot
@@ -0,0 +1,1407 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <snapshot/snapshot.h>
+
+#include <audio/state.h>
+#include <display/state.h>
+#include <emuenv/state.h>
+#include <io/functions.h>
+#include <io/state.h>
+#include <kernel/callback.h>
+#include <kernel/state.h>
+#include <kernel/sync_primitives.h>
+#include <kernel/thread/thread_state.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <util/align.h>
+#include <util/byte_stream.h>
+#include <util/log.h>
+
+#include <miniz.h>
+
+#if defined(__x86_64__) && !defined(__APPLE__)
+#include <xxh_x86dispatch.h>
+#else
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <thread>
+
+namespace snapshot {
+
+constexpr uint32_t MAGIC = 0x534B3356; // V3KS
+constexpr uint32_t VERSION = 3;
+constexpr uint32_t CHUNK_SIZE = KiB(64);
+// a chunk which compresses worse than this is stored as is, it can then be mapped instead of inflated on load
+constexpr uint32_t MIN_COMPRESSION_RATIO = 8;
+constexpr auto SUSPEND_TIMEOUT = std::chrono::seconds(2);
+// SCE_AUDIO_OUT_MODE_MONO, the other mode is stereo
+constexpr int AUDIO_OUT_MODE_MONO = 0;
+
+enum class SectionType : uint32_t {
+    Memory,
+    Kernel,
+    Threads,
+    Objects,
+    Files,
+    Audio,
+    Display,
+    Libraries,
+};
+
+enum class ChunkEncoding : uint8_t {
+    Zero,
+    Raw,
+    Deflate,
+    Base, // same content as the chunk at the same address in the base snapshot
+};
+
+#pragma pack(push, 1)
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t chunk_size;
+    char title_id[16];
+    uint32_t section_count;
+    // followed by the file name of the base snapshot, relative to this one, as a string
+};
+
+struct SectionHeader {
+    SectionType type;
+    uint64_t size;
+};
+
+struct ChunkRecord {
+    Address address;
+    uint32_t size;
+    ChunkEncoding encoding;
+    uint64_t hash;
+    uint64_t offset; // aligned to the page size for raw chunks, so that they can be mapped
+    uint32_t stored_size;
+};
+#pragma pack(pop)
+
+struct Range {
+    Address address;
+    uint32_t page_count;
+    std::string name;
+};
+
+struct Chunk {
+    ChunkRecord record;
+    std::vector<uint8_t> data;
+};
+
+// Read-only view of a whole snapshot file, mapped when the platform allows it
+class SnapshotFile {
+public:
+    SnapshotFile() = default;
+    SnapshotFile(const SnapshotFile &) = delete;
+    SnapshotFile &operator=(const SnapshotFile &) = delete;
+
+    ~SnapshotFile() {
+#ifndef _WIN32
+        if (data && data != MAP_FAILED)
+            munmap(const_cast<uint8_t *>(data), size);
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    bool open(const fs::path &path) {
+#ifdef _WIN32
+        fs::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return false;
+        buffer.resize(file.tellg());
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+        data = buffer.data();
+        size = buffer.size();
+        return !file.fail();
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size == 0)
+            return false;
+        size = st.st_size;
+        data = static_cast<const uint8_t *>(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+        return data != MAP_FAILED;
+#endif
+    }
+
+    bool contains(uint64_t offset, uint64_t length) const {
+        return offset <= size && length <= size - offset;
+    }
+
+#ifndef _WIN32
+    // Map a page-aligned part of the file over dest, copy-on-write: writes to it never reach the file
+    bool map(void *dest, uint64_t offset, size_t length) const {
+        return mmap(dest, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, offset) != MAP_FAILED;
+    }
+#endif
+
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+
+private:
+#ifdef _WIN32
+    std::vector<uint8_t> buffer;
+#else
+    int fd = -1;
+#endif
+};
+
+struct SnapshotContent {
+    FileHeader header{};
+    std::string base_name;
+    std::vector<Range> ranges;
+    std::vector<ChunkRecord> chunks;
+    // content of the sections other than the memory one
+    std::map<SectionType, std::string> sections;
+
+    ByteReader section(SectionType type) const {
+        static const std::string empty;
+        const auto section = sections.find(type);
+        return ByteReader(section != sections.end() ? section->second : empty);
+    }
+};
+
+static bool is_zero(const uint8_t *data, uint32_t size) {
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(data);
+    return std::all_of(words, words + size / sizeof(uint64_t), [](uint64_t word) { return word == 0; });
+}
+
+static bool parse(const SnapshotFile &file, SnapshotContent &content) {
+    ByteReader reader(file.data, file.size);
+    content.header = reader.read<FileHeader>();
+    if (reader.failed || content.header.magic != MAGIC || content.header.version != VERSION)
+        return false;
+    content.base_name = reader.read_string();
+
+    for (uint32_t section = 0; section < content.header.section_count && !reader.failed; section++) {
+        const auto section_header = reader.read<SectionHeader>();
+        if (!reader.can_read(section_header.size))
+            break;
+        const size_t section_end = reader.position() + section_header.size;
+        if (section_header.type == SectionType::Memory) {
+            ByteReader memory(reader.current(), section_header.size);
+            const auto range_count = memory.read<uint32_t>();
+            for (uint32_t i = 0; i < range_count && !memory.failed; i++) {
+                Range range;
+                range.address = memory.read<Address>();
+                range.page_count = memory.read<uint32_t>();
+                range.name = memory.read_string();
+                content.ranges.push_back(std::move(range));
+            }
+            content.chunks = memory.read_vector<ChunkRecord>();
+            if (memory.failed)
+                return false;
+        } else {
+            // sections written by a newer version are kept but never read
+            content.sections[section_header.type].assign(reinterpret_cast<const char *>(reader.current()), section_header.size);
+        }
+        reader.seek(section_end);
+    }
+
+    return !reader.failed;
+}
+
+// Pause the guest threads and wait until those that were running have actually stopped
+class ThreadsPause {
+public:
+    explicit ThreadsPause(KernelState &kernel)
+        : kernel(kernel)
+        , was_paused(kernel.is_threads_paused()) {
+        if (!was_paused)
+            kernel.pause_threads();
+    }
+
+    ~ThreadsPause() {
+        if (!was_paused)
+            kernel.resume_threads();
+    }
+
+    bool wait_suspended(const std::vector<ThreadStatePtr> &threads) {
+        const auto deadline = std::chrono::steady_clock::now() + SUSPEND_TIMEOUT;
+        for (const auto &thread : threads) {
+            std::unique_lock<std::mutex> lock(thread->mutex);
+            if (!thread->status_cond.wait_until(lock, deadline, [&] { return thread->status != ThreadStatus::run; })) {
+                LOG_ERROR("Thread {} ({}) could not be suspended", thread->name, thread->id);
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    KernelState &kernel;
+    bool was_paused;
+};
+
+static std::vector<ThreadStatePtr> list_threads(KernelState &kernel) {
+    std::vector<ThreadStatePtr> threads;
+    const std::lock_guard<std::mutex> lock(kernel.mutex);
+    for (const auto &[_, thread] : kernel.threads)
+        threads.push_back(thread);
+    return threads;
+}
+
+static std::vector<Range> collect_ranges(const MemState &mem) {
+    std::vector<Range> ranges;
+    // page 0 is the inaccessible null page
+    for (uint32_t page = 1; page < mem.allocator.max_offset;) {
+        const AllocMemPage &alloc_page = mem.alloc_table[page];
+        if (!alloc_page.allocated) {
+            page++;
+            continue;
+        }
+
+        const auto name = mem.page_name_map.find(page);
+        ranges.push_back({ page * mem.page_size, alloc_page.size, name != mem.page_name_map.end() ? name->second : std::string() });
+        page += alloc_page.size;
+    }
+    return ranges;
+}
+
+// same clock as the kernel timers, their times are saved relative to it
+static uint64_t get_timer_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+static SceUID find_callback_uid(const KernelState &kernel, const CallbackPtr &callback) {
+    const auto it = std::find_if(kernel.callbacks.begin(), kernel.callbacks.end(), [&](const auto &entry) { return entry.second == callback; });
+    return it != kernel.callbacks.end() ? it->first : SCE_UID_INVALID_UID;
+}
+
+static CallbackPtr find_callback(const KernelState &kernel, SceUID uid) {
+    const auto it = kernel.callbacks.find(uid);
+    return it != kernel.callbacks.end() ? it->second : nullptr;
+}
+
+static ThreadStatePtr find_thread(const KernelState &kernel, SceUID id) {
+    const auto it = kernel.threads.find(id);
+    return it != kernel.threads.end() ? it->second : nullptr;
+}
+
+// the waiting threads make their kernel call again once resumed, the queues start empty
+static WaitingThreadQueuePtr create_waiting_queue(uint32_t attr) {
+    if (attr & SCE_KERNEL_ATTR_TH_PRIO)
+        return std::make_unique<PriorityThreadDataQueue<WaitingThreadData>>();
+    return std::make_unique<FIFOThreadDataQueue<WaitingThreadData>>();
+}
+
+static void save_kernel(ByteWriter &writer, EmuEnvState &emuenv) {
+    KernelState &kernel = emuenv.kernel;
+    // the process time goes on from the time of the snapshot
+    writer.write(rtc_get_ticks(kernel.base_tick.tick) - kernel.start_tick);
+    writer.write(kernel.peek_next_uid());
+    writer.write(kernel.tls_address.address());
+    writer.write(kernel.tls_psize);
+    writer.write(kernel.tls_msize);
+    writer.write(kernel.thread_event_start.address());
+    writer.write(kernel.thread_event_start_arg);
+    writer.write(kernel.thread_event_end.address());
+    writer.write(kernel.thread_event_end_arg);
+    writer.write(kernel.process_param.address());
+    writer.write(emuenv.main_thread_id);
+
+    writer.write(static_cast<uint32_t>(kernel.loaded_modules.size()));
+    for (const auto &[uid, module] : kernel.loaded_modules) {
+        writer.write(uid);
+        writer.write(*module);
+    }
+    writer.write(static_cast<uint32_t>(kernel.loaded_sysmodules.size()));
+    for (const auto &[id, uids] : kernel.loaded_sysmodules) {
+        writer.write(id);
+        writer.write_vector(uids);
+    }
+    writer.write_vector(kernel.loaded_internal_sysmodules);
+
+    const std::lock_guard<std::mutex> lock(kernel.export_nids_mutex);
+    writer.write(static_cast<uint32_t>(kernel.export_nids.size()));
+    for (const auto &[nid, address] : kernel.export_nids) {
+        writer.write(nid);
+        writer.write(address);
+    }
+    writer.write(static_cast<uint32_t>(kernel.func_binding_infos.entries.size()));
+    for (const auto &[nid, address] : kernel.func_binding_infos.entries) {
+        writer.write(nid);
+        writer.write(address);
+    }
+    // the relocation entries are in guest memory, they are saved as guest addresses
+    writer.write(static_cast<uint32_t>(kernel.var_binding_infos.entries.size()));
+    for (const auto &[nid, info] : kernel.var_binding_infos.entries) {
+        writer.write(nid);
+        writer.write(static_cast<Address>(static_cast<const uint8_t *>(info.entries) - emuenv.mem.memory.get()));
+        writer.write(info.size);
+        writer.write(info.module_nid);
+    }
+    writer.write(static_cast<uint32_t>(kernel.module_uid_by_nid.size()));
+    for (const auto &[nid, uid] : kernel.module_uid_by_nid) {
+        writer.write(nid);
+        writer.write(uid);
+    }
+    writer.write(static_cast<uint32_t>(kernel.import_fast_paths.size()));
+    for (const auto &[nid, address] : kernel.import_fast_paths) {
+        writer.write(nid);
+        writer.write(address);
+    }
+}
+
+static bool load_kernel(ByteReader &reader, EmuEnvState &emuenv) {
+    KernelState &kernel = emuenv.kernel;
+    kernel.start_tick = rtc_get_ticks(kernel.base_tick.tick) - reader.read<uint64_t>();
+    kernel.set_next_uid(reader.read<SceUID>());
+    kernel.tls_address = Ptr<const void>(reader.read<Address>());
+    kernel.tls_psize = reader.read<unsigned int>();
+    kernel.tls_msize = reader.read<unsigned int>();
+    kernel.thread_event_start = Ptr<const void>(reader.read<Address>());
+    kernel.thread_event_start_arg = reader.read<Address>();
+    kernel.thread_event_end = Ptr<const void>(reader.read<Address>());
+    kernel.thread_event_end_arg = reader.read<Address>();
+    kernel.process_param = Ptr<SceProcessParam>(reader.read<Address>());
+    emuenv.main_thread_id = reader.read<SceUID>();
+
+    // the modules loaded by load_app are in the snapshot too, with the same uids
+    kernel.loaded_modules.clear();
+    const auto module_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < module_count && !reader.failed; i++) {
+        const auto uid = reader.read<SceUID>();
+        kernel.loaded_modules.emplace(uid, std::make_shared<KernelModule>(reader.read<KernelModule>()));
+    }
+    kernel.loaded_sysmodules.clear();
+    const auto sysmodule_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < sysmodule_count && !reader.failed; i++) {
+        const auto id = reader.read<SceSysmoduleModuleId>();
+        kernel.loaded_sysmodules[id] = reader.read_vector<SceUID>();
+    }
+    kernel.loaded_internal_sysmodules = reader.read_vector<SceSysmoduleInternalModuleId>();
+
+    const std::lock_guard<std::mutex> lock(kernel.export_nids_mutex);
+    kernel.export_nids.clear();
+    const auto export_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < export_count && !reader.failed; i++) {
+        const auto nid = reader.read<uint32_t>();
+        kernel.export_nids.emplace(nid, reader.read<Address>());
+    }
+    kernel.func_binding_infos.entries.clear();
+    const auto func_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < func_count && !reader.failed; i++) {
+        const auto nid = reader.read<uint32_t>();
+        kernel.func_binding_infos.entries.emplace_back(nid, reader.read<Address>());
+    }
+    kernel.var_binding_infos.entries.clear();
+    const auto var_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < var_count && !reader.failed; i++) {
+        const auto nid = reader.read<uint32_t>();
+        VarBindingInfo info;
+        info.entries = emuenv.mem.memory.get() + reader.read<Address>();
+        info.size = reader.read<uint32_t>();
+        info.module_nid = reader.read<uint32_t>();
+        kernel.var_binding_infos.entries.emplace_back(nid, info);
+    }
+    kernel.module_uid_by_nid.clear();
+    const auto module_nid_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < module_nid_count && !reader.failed; i++) {
+        const auto nid = reader.read<uint32_t>();
+        kernel.module_uid_by_nid[nid] = reader.read<uint32_t>();
+    }
+    kernel.import_fast_paths.clear();
+    const auto fast_path_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < fast_path_count && !reader.failed; i++) {
+        const auto nid = reader.read<uint32_t>();
+        kernel.import_fast_paths[nid] = reader.read<Address>();
+    }
+
+    return !reader.failed;
+}
+
+static void save_threads(ByteWriter &writer, KernelState &kernel, const std::vector<ThreadStatePtr> &threads) {
+    writer.write(static_cast<uint32_t>(threads.size()));
+    for (const ThreadStatePtr &thread : threads) {
+        const ThreadSnapshot snapshot = thread->get_snapshot();
+        writer.write(snapshot.id);
+        writer.write_string(snapshot.name);
+        writer.write(snapshot.entry_point);
+        writer.write(snapshot.stack);
+        writer.write(snapshot.stack_size);
+        writer.write(snapshot.tls);
+        writer.write(snapshot.halt_instruction);
+        writer.write(snapshot.priority);
+        writer.write(snapshot.affinity_mask);
+        // relative to the start of the process, which changes in the new run
+        writer.write(snapshot.start_tick - kernel.start_tick);
+        writer.write(snapshot.status);
+        writer.write(snapshot.call_level);
+        writer.write(snapshot.run_start_callback);
+        writer.write(snapshot.init_context);
+        writer.write(snapshot.context);
+        writer.write(snapshot.returned_value);
+
+        const std::lock_guard<std::mutex> lock(kernel.mutex);
+        std::vector<SceUID> callbacks;
+        for (const CallbackPtr &callback : thread->callbacks)
+            callbacks.push_back(find_callback_uid(kernel, callback));
+        writer.write_vector(callbacks);
+    }
+}
+
+static std::vector<std::pair<ThreadSnapshot, std::vector<SceUID>>> read_threads(ByteReader &reader, const KernelState &kernel) {
+    std::vector<std::pair<ThreadSnapshot, std::vector<SceUID>>> threads;
+    const auto count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < count && !reader.failed; i++) {
+        ThreadSnapshot snapshot;
+        snapshot.id = reader.read<SceUID>();
+        snapshot.name = reader.read_string();
+        snapshot.entry_point = reader.read<Address>();
+        snapshot.stack = reader.read<Address>();
+        snapshot.stack_size = reader.read<int>();
+        snapshot.tls = reader.read<Address>();
+        snapshot.halt_instruction = reader.read<Address>();
+        snapshot.priority = reader.read<int>();
+        snapshot.affinity_mask = reader.read<SceInt32>();
+        snapshot.start_tick = kernel.start_tick + reader.read<uint64_t>();
+        snapshot.status = reader.read<ThreadStatus>();
+        snapshot.call_level = reader.read<int>();
+        snapshot.run_start_callback = reader.read<bool>();
+        snapshot.init_context = reader.read<CPUContext>();
+        snapshot.context = reader.read<CPUContext>();
+        snapshot.returned_value = reader.read<uint32_t>();
+        threads.emplace_back(std::move(snapshot), reader.read_vector<SceUID>());
+    }
+    return threads;
+}
+
+static void save_primitive(ByteWriter &writer, SceUID uid, const SyncPrimitive &primitive) {
+    writer.write(uid);
+    writer.write(primitive.attr);
+    writer.write_string(primitive.name);
+}
+
+static SceUID load_primitive(ByteReader &reader, SyncPrimitive &primitive) {
+    primitive.uid = reader.read<SceUID>();
+    primitive.attr = reader.read<uint32_t>();
+    const std::string name = reader.read_string();
+    strncpy(primitive.name, name.c_str(), KERNELOBJECT_MAX_NAME_LENGTH);
+    primitive.name[KERNELOBJECT_MAX_NAME_LENGTH] = '\0';
+    return primitive.uid;
+}
+
+static void save_mutexes(ByteWriter &writer, const MutexPtrs &mutexes) {
+    writer.write(static_cast<uint32_t>(mutexes.size()));
+    for (const auto &[uid, mutex] : mutexes) {
+        save_primitive(writer, uid, *mutex);
+        writer.write(mutex->init_count);
+        writer.write(mutex->lock_count);
+        writer.write(mutex->owner ? mutex->owner->id : 0);
+        writer.write(mutex->workarea.address());
+    }
+}
+
+static void load_mutexes(ByteReader &reader, const KernelState &kernel, MutexPtrs &mutexes) {
+    const auto count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < count && !reader.failed; i++) {
+        const MutexPtr mutex = std::make_shared<Mutex>();
+        const SceUID uid = load_primitive(reader, *mutex);
+        mutex->init_count = reader.read<int>();
+        mutex->lock_count = reader.read<int>();
+        mutex->owner = find_thread(kernel, reader.read<SceUID>());
+        mutex->workarea = Ptr<SceKernelLwMutexWork>(reader.read<Address>());
+        mutex->waiting_threads = create_waiting_queue(mutex->attr);
+        mutexes.emplace(uid, mutex);
+    }
+}
+
+static void save_condvars(ByteWriter &writer, const CondvarPtrs &condvars) {
+    writer.write(static_cast<uint32_t>(condvars.size()));
+    for (const auto &[uid, condvar] : condvars) {
+        save_primitive(writer, uid, *condvar);
+        writer.write(condvar->associated_mutex ? condvar->associated_mutex->uid : 0);
+    }
+}
+
+static void load_condvars(ByteReader &reader, const MutexPtrs &mutexes, CondvarPtrs &condvars) {
+    const auto count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < count && !reader.failed; i++) {
+        const CondvarPtr condvar = std::make_shared<Condvar>();
+        const SceUID uid = load_primitive(reader, *condvar);
+        const auto mutex = mutexes.find(reader.read<SceUID>());
+        condvar->associated_mutex = mutex != mutexes.end() ? mutex->second : nullptr;
+        condvar->waiting_threads = create_waiting_queue(condvar->attr);
+        condvars.emplace(uid, condvar);
+    }
+}
+
+static void save_objects(ByteWriter &writer, KernelState &kernel) {
+    const std::lock_guard<std::mutex> lock(kernel.mutex);
+
+    writer.write(static_cast<uint32_t>(kernel.simple_events.size()));
+    for (const auto &[uid, event] : kernel.simple_events) {
+        save_primitive(writer, uid, *event);
+        writer.write(event->pattern);
+        writer.write(event->last_user_data);
+        writer.write(event->auto_reset);
+        writer.write(event->cb_wakeup_only);
+    }
+
+    const uint64_t now = get_timer_time();
+    writer.write(static_cast<uint32_t>(kernel.timers.size()));
+    for (const auto &[uid, timer] : kernel.timers) {
+        save_primitive(writer, uid, *timer);
+        writer.write(timer->is_started);
+        writer.write(timer->is_repeat);
+        writer.write(timer->is_pulse);
+        writer.write(timer->event_set);
+        writer.write(timer->event_interval);
+        writer.write(static_cast<int64_t>(now - timer->time));
+        const bool has_next_event = timer->next_event != std::numeric_limits<uint64_t>::max();
+        writer.write(has_next_event);
+        writer.write(has_next_event ? static_cast<int64_t>(timer->next_event - now) : 0);
+    }
+
+    writer.write(static_cast<uint32_t>(kernel.semaphores.size()));
+    for (const auto &[uid, semaphore] : kernel.semaphores) {
+        save_primitive(writer, uid, *semaphore);
+        writer.write(semaphore->max);
+        writer.write(semaphore->val);
+        writer.write(semaphore->init_val);
+    }
+
+    save_mutexes(writer, kernel.mutexes);
+    save_mutexes(writer, kernel.lwmutexes);
+    save_condvars(writer, kernel.condvars);
+    save_condvars(writer, kernel.lwcondvars);
+
+    writer.write(static_cast<uint32_t>(kernel.rwlocks.size()));
+    for (const auto &[uid, rwlock] : kernel.rwlocks) {
+        save_primitive(writer, uid, *rwlock);
+        writer.write(rwlock->state);
+        writer.write(static_cast<uint32_t>(rwlock->owners.size()));
+        for (const auto &[owner, count] : rwlock->owners) {
+            writer.write(owner->id);
+            writer.write(count);
+        }
+    }
+
+    writer.write(static_cast<uint32_t>(kernel.eventflags.size()));
+    for (const auto &[uid, eventflag] : kernel.eventflags) {
+        save_primitive(writer, uid, *eventflag);
+        writer.write(eventflag->flags);
+    }
+
+    writer.write(static_cast<uint32_t>(kernel.msgpipes.size()));
+    for (const auto &[uid, msgpipe] : kernel.msgpipes) {
+        writer.write(static_cast<uint64_t>(msgpipe->data_buffer.Capacity()));
+        save_primitive(writer, uid, *msgpipe);
+        std::vector<uint8_t> data(msgpipe->data_buffer.Used());
+        msgpipe->data_buffer.Peek(data.data(), data.size());
+        writer.write_vector(data);
+    }
+
+    writer.write(static_cast<uint32_t>(kernel.callbacks.size()));
+    for (const auto &[uid, callback] : kernel.callbacks) {
+        writer.write(uid);
+        writer.write(callback->get_owner_thread_id());
+        writer.write_string(callback->get_name());
+        writer.write(callback->get_callback_function().address());
+        writer.write(callback->get_user_common_ptr().address());
+        writer.write(callback->get_notifier_id());
+        writer.write(callback->get_notify_arg());
+        writer.write(callback->get_num_notifications());
+    }
+}
+
+// the threads must be restored first, they own mutexes and callbacks
+static bool load_objects(ByteReader &reader, KernelState &kernel) {
+    const std::lock_guard<std::mutex> lock(kernel.mutex);
+
+    const auto event_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < event_count && !reader.failed; i++) {
+        const SimpleEventPtr event = std::make_shared<SimpleEvent>();
+        const SceUID uid = load_primitive(reader, *event);
+        event->pattern = reader.read<SceUInt32>();
+        event->last_user_data = reader.read<SceUInt64>();
+        event->auto_reset = reader.read<bool>();
+        event->cb_wakeup_only = reader.read<bool>();
+        event->waiting_threads = create_waiting_queue(event->attr);
+        kernel.simple_events.emplace(uid, event);
+    }
+
+    const uint64_t now = get_timer_time();
+    const auto timer_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < timer_count && !reader.failed; i++) {
+        const TimerPtr timer = std::make_shared<Timer>();
+        const SceUID uid = load_primitive(reader, *timer);
+        timer->is_started = reader.read<bool>();
+        timer->is_repeat = reader.read<bool>();
+        timer->is_pulse = reader.read<bool>();
+        timer->event_set = reader.read<bool>();
+        timer->event_interval = reader.read<uint64_t>();
+        timer->time = now - reader.read<int64_t>();
+        const bool has_next_event = reader.read<bool>();
+        const auto next_event = reader.read<int64_t>();
+        timer->next_event = has_next_event ? now + next_event : std::numeric_limits<uint64_t>::max();
+        timer->waiting_threads = create_waiting_queue(timer->attr);
+        kernel.timers.emplace(uid, timer);
+    }
+
+    const auto semaphore_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < semaphore_count && !reader.failed; i++) {
+        const SemaphorePtr semaphore = std::make_shared<Semaphore>();
+        const SceUID uid = load_primitive(reader, *semaphore);
+        semaphore->max = reader.read<int>();
+        semaphore->val = reader.read<int>();
+        semaphore->init_val = reader.read<int>();
+        semaphore->waiting_threads = create_waiting_queue(semaphore->attr);
+        kernel.semaphores.emplace(uid, semaphore);
+    }
+
+    load_mutexes(reader, kernel, kernel.mutexes);
+    load_mutexes(reader, kernel, kernel.lwmutexes);
+    load_condvars(reader, kernel.mutexes, kernel.condvars);
+    load_condvars(reader, kernel.lwmutexes, kernel.lwcondvars);
+
+    const auto rwlock_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < rwlock_count && !reader.failed; i++) {
+        const RWLockPtr rwlock = std::make_shared<RWLock>();
+        const SceUID uid = load_primitive(reader, *rwlock);
+        rwlock->state = reader.read<RWLockState>();
+        const auto owner_count = reader.read<uint32_t>();
+        for (uint32_t j = 0; j < owner_count && !reader.failed; j++) {
+            const ThreadStatePtr owner = find_thread(kernel, reader.read<SceUID>());
+            const auto count = reader.read<int>();
+            if (owner)
+                rwlock->owners.emplace(owner, count);
+        }
+        rwlock->waiting_threads = create_waiting_queue(rwlock->attr);
+        kernel.rwlocks.emplace(uid, rwlock);
+    }
+
+    const auto eventflag_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < eventflag_count && !reader.failed; i++) {
+        const EventFlagPtr eventflag = std::make_shared<EventFlag>();
+        const SceUID uid = load_primitive(reader, *eventflag);
+        eventflag->flags = reader.read<int>();
+        eventflag->waiting_threads = create_waiting_queue(eventflag->attr);
+        kernel.eventflags.emplace(uid, eventflag);
+    }
+
+    const auto msgpipe_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < msgpipe_count && !reader.failed; i++) {
+        const auto capacity = reader.read<uint64_t>();
+        if (reader.failed)
+            break;
+        const MsgPipePtr msgpipe = std::make_shared<MsgPipe>(capacity);
+        const SceUID uid = load_primitive(reader, *msgpipe);
+        const std::vector<uint8_t> data = reader.read_vector<uint8_t>();
+        msgpipe->data_buffer.Insert(data.data(), data.size());
+        msgpipe->receivers = create_waiting_queue(msgpipe->attr);
+        // like msgpipe_create, the senders are always in FIFO order
+        msgpipe->senders = create_waiting_queue(0);
+        kernel.msgpipes.emplace(uid, msgpipe);
+    }
+
+    const auto callback_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < callback_count && !reader.failed; i++) {
+        const auto uid = reader.read<SceUID>();
+        const auto owner_id = reader.read<SceUID>();
+        std::string name = reader.read_string();
+        const auto function = Ptr<SceKernelCallbackFunction>(reader.read<Address>());
+        const auto common = Ptr<void>(reader.read<Address>());
+        const auto notifier_id = reader.read<SceUID>();
+        const auto notify_arg = reader.read<SceInt32>();
+        const auto notification_count = reader.read<uint32_t>();
+        const CallbackPtr callback = std::make_shared<Callback>(owner_id, find_thread(kernel, owner_id), name, function, common);
+        for (uint32_t j = 0; j < notification_count; j++)
+            callback->notify(notifier_id, notify_arg);
+        kernel.callbacks.emplace(uid, callback);
+    }
+
+    return !reader.failed;
+}
+
+static void save_files(ByteWriter &writer, IOState &io) {
+    writer.write(io.next_fd);
+
+    writer.write(static_cast<uint32_t>(io.std_files.size()));
+    for (const auto &[fd, file] : io.std_files) {
+        writer.write(fd);
+        writer.write_string(file.get_vita_loc());
+        writer.write(file.get_open_mode());
+        writer.write(file.tell());
+    }
+
+    writer.write(static_cast<uint32_t>(io.tty_files.size()));
+    for (const auto &[fd, type] : io.tty_files) {
+        writer.write(fd);
+        writer.write(type);
+    }
+
+    writer.write(static_cast<uint32_t>(io.dir_entries.size()));
+    for (const auto &[fd, dir] : io.dir_entries) {
+        writer.write(fd);
+        writer.write_string(dir.get_vita_loc());
+    }
+
+    const std::lock_guard<std::mutex> lock(io.overlay_mutex);
+    writer.write(io.next_overlay_id);
+    writer.write(static_cast<uint32_t>(io.overlays.size()));
+    for (const FiosOverlay &overlay : io.overlays) {
+        writer.write(overlay.id);
+        writer.write(overlay.type);
+        writer.write(overlay.order);
+        writer.write(overlay.process_id);
+        writer.write_string(overlay.dst);
+        writer.write_string(overlay.src);
+    }
+}
+
+// the files are opened again with the same descriptors. A file which can not be opened anymore is left closed.
+static bool load_files(ByteReader &reader, EmuEnvState &emuenv) {
+    IOState &io = emuenv.io;
+    const auto next_fd = reader.read<SceUID>();
+
+    const auto file_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < file_count && !reader.failed; i++) {
+        const auto fd = reader.read<SceUID>();
+        const std::string path = reader.read_string();
+        // not created or truncated again: the file keeps what was written to it since the snapshot
+        const int flags = reader.read<int>() & ~(SCE_O_TRUNC | SCE_O_EXCL);
+        const auto position = reader.read<SceOff>();
+        if (reader.failed)
+            break;
+        io.next_fd = fd;
+        if (open_file(io, path.c_str(), flags, emuenv.pref_path, "snapshot") != fd) {
+            LOG_WARN("Could not open the file {} again, it stays closed", path);
+            continue;
+        }
+        io.std_files.at(fd).seek(position, SCE_SEEK_SET);
+    }
+
+    const auto tty_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < tty_count && !reader.failed; i++) {
+        const auto fd = reader.read<SceUID>();
+        io.tty_files.emplace(fd, reader.read<TtyType>());
+    }
+
+    const auto dir_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < dir_count && !reader.failed; i++) {
+        const auto fd = reader.read<SceUID>();
+        const std::string path = reader.read_string();
+        if (reader.failed)
+            break;
+        // the listing starts over
+        io.next_fd = fd;
+        if (open_dir(io, path.c_str(), emuenv.pref_path, "snapshot") != fd)
+            LOG_WARN("Could not open the directory {} again, it stays closed", path);
+    }
+    io.next_fd = next_fd;
+
+    const std::lock_guard<std::mutex> lock(io.overlay_mutex);
+    io.next_overlay_id = reader.read<SceUID>();
+    io.overlays.clear();
+    const auto overlay_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < overlay_count && !reader.failed; i++) {
+        FiosOverlay overlay;
+        overlay.id = reader.read<SceUID>();
+        overlay.type = reader.read<SceFiosOverlayType>();
+        overlay.order = reader.read<uint8_t>();
+        overlay.process_id = reader.read<SceUID>();
+        overlay.dst = reader.read_string();
+        overlay.src = reader.read_string();
+        io.overlays.push_back(std::move(overlay));
+    }
+
+    return !reader.failed;
+}
+
+static void save_audio(ByteWriter &writer, AudioState &audio) {
+    const std::lock_guard<std::mutex> lock(audio.mutex);
+    writer.write(audio.next_port_id);
+    writer.write(static_cast<uint32_t>(audio.out_ports.size()));
+    for (const auto &[id, port] : audio.out_ports) {
+        writer.write(id);
+        writer.write(port->type);
+        writer.write(port->len);
+        writer.write(port->freq);
+        writer.write(port->mode);
+        writer.write(port->left_channel_volume);
+        writer.write(port->right_channel_volume);
+        writer.write(port->volume);
+    }
+}
+
+// the ports are opened again empty, the samples which were queued in them are lost
+static bool load_audio(ByteReader &reader, AudioState &audio) {
+    const auto next_port_id = reader.read<int>();
+    const auto port_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < port_count && !reader.failed; i++) {
+        const auto id = reader.read<int>();
+        const auto type = reader.read<int>();
+        const auto len = reader.read<int>();
+        const auto freq = reader.read<int>();
+        const auto mode = reader.read<int>();
+        const auto left_channel_volume = reader.read<int>();
+        const auto right_channel_volume = reader.read<int>();
+        const auto volume = reader.read<float>();
+        if (reader.failed)
+            break;
+
+        const AudioOutPortPtr port = audio.open_port(mode == AUDIO_OUT_MODE_MONO ? 1 : 2, freq, len);
+        if (!port) {
+            LOG_WARN("Could not open the audio port {} again", id);
+            continue;
+        }
+        port->type = type;
+        port->len = len;
+        port->freq = freq;
+        port->mode = mode;
+        port->left_channel_volume = left_channel_volume;
+        port->right_channel_volume = right_channel_volume;
+        audio.set_volume(*port, volume);
+
+        const std::lock_guard<std::mutex> lock(audio.mutex);
+        audio.out_ports.emplace(id, port);
+    }
+
+    const std::lock_guard<std::mutex> lock(audio.mutex);
+    audio.next_port_id = next_port_id;
+    return !reader.failed;
+}
+
+static void save_display(ByteWriter &writer, DisplayState &display) {
+    writer.write(display.sce_frame);
+    writer.write(display.vblank_count.load());
+    writer.write(display.last_setframe_vblank_count.load());
+
+    const std::lock_guard<std::mutex> lock(display.mutex);
+    std::vector<SceUID> callbacks;
+    for (const auto &[uid, _] : display.vblank_callbacks)
+        callbacks.push_back(uid);
+    writer.write_vector(callbacks);
+}
+
+static bool load_display(ByteReader &reader, KernelState &kernel, DisplayState &display) {
+    display.sce_frame = reader.read<DisplayFrameInfo>();
+    {
+        const std::lock_guard<std::mutex> lock(display.display_info_mutex);
+        display.next_rendered_frame = display.sce_frame;
+    }
+    display.vblank_count = reader.read<uint64_t>();
+    display.last_setframe_vblank_count = reader.read<uint64_t>();
+
+    const std::lock_guard<std::mutex> lock(display.mutex);
+    for (const SceUID uid : reader.read_vector<SceUID>()) {
+        if (const CallbackPtr callback = find_callback(kernel, uid))
+            display.vblank_callbacks.emplace(uid, callback);
+    }
+    return !reader.failed;
+}
+
+static void save_libraries(ByteWriter &writer, KernelState &kernel) {
+    writer.write(static_cast<uint32_t>(kernel.snapshot_handlers.size()));
+    for (const auto &[name, handler] : kernel.snapshot_handlers) {
+        std::string data;
+        handler.save(data);
+        writer.write_string(name);
+        writer.write_string(data);
+    }
+}
+
+static bool load_libraries(ByteReader &reader, KernelState &kernel) {
+    const auto count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < count && !reader.failed; i++) {
+        const std::string name = reader.read_string();
+        const std::string data = reader.read_string();
+        if (reader.failed)
+            break;
+        const auto handler = kernel.snapshot_handlers.find(name);
+        if (handler == kernel.snapshot_handlers.end()) {
+            LOG_WARN("The state of the library {} is in the snapshot but the library is not loaded", name);
+            continue;
+        }
+        if (!handler->second.load(data)) {
+            LOG_ERROR("The state of the library {} in the snapshot is invalid", name);
+            return false;
+        }
+    }
+    return !reader.failed;
+}
+
+static std::map<Address, ChunkRecord> load_base_chunks(const SnapshotContent &base) {
+    std::map<Address, ChunkRecord> chunks;
+    for (const auto &chunk : base.chunks)
+        chunks.emplace(chunk.address, chunk);
+    return chunks;
+}
+
+static void encode_chunks(MemState &mem, std::vector<Chunk> &chunks, const std::map<Address, ChunkRecord> &base_chunks) {
+    std::atomic<size_t> next_chunk = 0;
+    const auto encode = [&] {
+        for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+            ChunkRecord &record = chunks[i].record;
+            const uint8_t *data = Ptr<uint8_t>(record.address).get(mem);
+
+            record.hash = XXH3_64bits(data, record.size);
+            const auto base = base_chunks.find(record.address);
+            if (base != base_chunks.end() && base->second.size == record.size && base->second.hash == record.hash) {
+                record.encoding = ChunkEncoding::Base;
+                continue;
+            }
+            if (is_zero(data, record.size)) {
+                record.encoding = ChunkEncoding::Zero;
+                continue;
+            }
+
+            std::vector<uint8_t> &compressed = chunks[i].data;
+            mz_ulong compressed_size = mz_compressBound(record.size);
+            compressed.resize(compressed_size);
+            if (mz_compress2(compressed.data(), &compressed_size, data, record.size, MZ_BEST_SPEED) == MZ_OK
+                && compressed_size < record.size - record.size / MIN_COMPRESSION_RATIO) {
+                record.encoding = ChunkEncoding::Deflate;
+                compressed.resize(compressed_size);
+            } else {
+                record.encoding = ChunkEncoding::Raw;
+                compressed.assign(data, data + record.size);
+            }
+            record.stored_size = static_cast<uint32_t>(compressed.size());
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const uint32_t worker_count = std::clamp(std::thread::hardware_concurrency(), 1U, 8U);
+    for (uint32_t i = 1; i < worker_count; i++)
+        workers.emplace_back(encode);
+    encode();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+bool save(const fs::path &path, EmuEnvState &emuenv, const fs::path &base, SnapshotStats *stats) {
+    const auto start = std::chrono::steady_clock::now();
+    MemState &mem = emuenv.mem;
+    KernelState &kernel = emuenv.kernel;
+
+    SnapshotFile base_file;
+    SnapshotContent base_content;
+    if (!base.empty()) {
+        if (!base_file.open(base) || !parse(base_file, base_content)) {
+            LOG_ERROR("Could not read the base snapshot {}", base);
+            return false;
+        }
+        if (!base_content.base_name.empty() || base_content.header.page_size != mem.page_size) {
+            LOG_ERROR("The snapshot {} can not be used as a base", base);
+            return false;
+        }
+    }
+    const auto base_chunks = load_base_chunks(base_content);
+
+    ThreadsPause pause(kernel);
+    const std::vector<ThreadStatePtr> threads = list_threads(kernel);
+    if (!pause.wait_suspended(threads))
+        return false;
+    // the host side of a callback, and of the kernel call which runs it, can not be saved
+    for (const ThreadStatePtr &thread : threads) {
+        if (thread->get_call_level() > 1 || thread->is_processing_callbacks) {
+            LOG_ERROR("Thread {} ({}) is running a callback, try to save the snapshot again later", thread->name, thread->id);
+            return false;
+        }
+    }
+
+    std::string kernel_section;
+    ByteWriter kernel_writer(kernel_section);
+    save_kernel(kernel_writer, emuenv);
+    std::string thread_section;
+    ByteWriter thread_writer(thread_section);
+    save_threads(thread_writer, kernel, threads);
+    std::string object_section;
+    ByteWriter object_writer(object_section);
+    save_objects(object_writer, kernel);
+    std::string file_section;
+    ByteWriter file_writer(file_section);
+    save_files(file_writer, emuenv.io);
+    std::string audio_section;
+    ByteWriter audio_writer(audio_section);
+    save_audio(audio_writer, emuenv.audio);
+    std::string display_section;
+    ByteWriter display_writer(display_section);
+    save_display(display_writer, emuenv.display);
+    std::string library_section;
+    ByteWriter library_writer(library_section);
+    save_libraries(library_writer, kernel);
+
+    std::vector<Range> ranges;
+    std::vector<Chunk> chunks;
+    {
+        const std::lock_guard<std::mutex> lock(mem.generation_mutex);
+        ranges = collect_ranges(mem);
+        for (const Range &range : ranges) {
+            const Address range_end = range.address + range.page_count * mem.page_size;
+            for (Address address = range.address; address < range_end; address += CHUNK_SIZE) {
+                Chunk chunk{};
+                chunk.record.address = address;
+                chunk.record.size = std::min<uint32_t>(CHUNK_SIZE, range_end - address);
+                chunks.push_back(std::move(chunk));
+            }
+        }
+        encode_chunks(mem, chunks, base_chunks);
+    }
+
+    // a thread waiting in a kernel call may have been woken up and changed the memory while it was saved
+    for (const ThreadStatePtr &thread : threads) {
+        if (thread->status == ThreadStatus::run) {
+            LOG_ERROR("Thread {} ({}) woke up while the snapshot was saved, try to save it again", thread->name, thread->id);
+            return false;
+        }
+    }
+
+    std::string memory_section;
+    ByteWriter memory_writer(memory_section);
+    memory_writer.write(static_cast<uint32_t>(ranges.size()));
+    for (const Range &range : ranges) {
+        memory_writer.write(range.address);
+        memory_writer.write(range.page_count);
+        memory_writer.write_string(range.name);
+    }
+    memory_writer.write(static_cast<uint32_t>(chunks.size()));
+    // filled once the offsets of the chunks are known
+    const size_t chunk_table_offset = memory_section.size();
+    memory_section.resize(memory_section.size() + chunks.size() * sizeof(ChunkRecord));
+
+    const std::string base_name = base.empty() ? std::string() : fs_utils::path_to_utf8(base.filename());
+    const std::pair<SectionType, const std::string *> sections[] = {
+        { SectionType::Memory, &memory_section },
+        { SectionType::Kernel, &kernel_section },
+        { SectionType::Threads, &thread_section },
+        { SectionType::Objects, &object_section },
+        { SectionType::Files, &file_section },
+        { SectionType::Audio, &audio_section },
+        { SectionType::Display, &display_section },
+        { SectionType::Libraries, &library_section },
+    };
+
+    // layout: header, base name, sections, then the chunk data
+    uint64_t offset = sizeof(FileHeader) + sizeof(uint32_t) + base_name.size();
+    for (const auto &[_, section] : sections)
+        offset += sizeof(SectionHeader) + section->size();
+    for (size_t i = 0; i < chunks.size(); i++) {
+        ChunkRecord &record = chunks[i].record;
+        if (record.encoding == ChunkEncoding::Raw)
+            offset = align(offset, static_cast<uint64_t>(mem.page_size));
+        if (record.encoding == ChunkEncoding::Raw || record.encoding == ChunkEncoding::Deflate) {
+            record.offset = offset;
+            offset += record.stored_size;
+        }
+        memcpy(memory_section.data() + chunk_table_offset + i * sizeof(ChunkRecord), &record, sizeof(ChunkRecord));
+    }
+
+    FileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.page_size = mem.page_size;
+    header.chunk_size = CHUNK_SIZE;
+    strncpy(header.title_id, emuenv.io.title_id.c_str(), sizeof(header.title_id) - 1);
+    header.section_count = static_cast<uint32_t>(std::size(sections));
+
+    std::string prefix;
+    ByteWriter prefix_writer(prefix);
+    prefix_writer.write(header);
+    prefix_writer.write_string(base_name);
+
+    // write to a temporary file first so that a failure does not destroy the previous snapshot
+    fs::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        fs::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("Could not create the snapshot file {}", path);
+            return false;
+        }
+        file.write(prefix.data(), prefix.size());
+        for (const auto &[type, section] : sections) {
+            const SectionHeader section_header{ type, section->size() };
+            file.write(reinterpret_cast<const char *>(&section_header), sizeof(section_header));
+            file.write(section->data(), section->size());
+        }
+        uint64_t written = file.tellp();
+        const std::vector<char> padding(mem.page_size);
+        for (const Chunk &chunk : chunks) {
+            if (chunk.data.empty() || chunk.record.encoding == ChunkEncoding::Base)
+                continue;
+            file.write(padding.data(), chunk.record.offset - written);
+            file.write(reinterpret_cast<const char *>(chunk.data.data()), chunk.data.size());
+            written = chunk.record.offset + chunk.data.size();
+        }
+        if (file.fail()) {
+            LOG_ERROR("Could not write the snapshot file {}", path);
+            return false;
+        }
+    }
+    fs::rename(temp_path, path);
+
+    SnapshotStats result;
+    for (const Chunk &chunk : chunks) {
+        result.allocated_bytes += chunk.record.size;
+        result.stored_bytes += chunk.data.size();
+        result.zero_chunks += chunk.record.encoding == ChunkEncoding::Zero;
+        result.base_chunks += chunk.record.encoding == ChunkEncoding::Base;
+    }
+    result.chunk_count = static_cast<uint32_t>(chunks.size());
+    result.thread_count = static_cast<uint32_t>(threads.size());
+    result.elapsed_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Saved snapshot {} in {:.1f} ms: {} MiB of guest memory, {} MiB stored, {} unchanged chunks, {} threads",
+        path, result.elapsed_ms, result.allocated_bytes / MiB(1), result.stored_bytes / MiB(1), result.base_chunks, result.thread_count);
+    if (stats)
+        *stats = result;
+
+    return true;
+}
+
+static bool is_range_protected(MemState &mem, Address address, uint32_t size) {
+    const std::lock_guard<std::mutex> lock(mem.protect_mutex);
+    // the tree is sorted in decreasing order: this is the last segment starting before the end of the range
+    const auto segment = mem.protect_tree.lower_bound(address + size - 1);
+    return segment != mem.protect_tree.end() && address < segment->first + segment->second.size;
+}
+
+// fresh is set when the range of the chunk was allocated by the load, its pages are still zero
+static bool restore_chunk(MemState &mem, const ChunkRecord &record, const SnapshotFile &file, bool fresh, SnapshotStats &stats) {
+    uint8_t *const dest = Ptr<uint8_t>(record.address).get(mem);
+    switch (record.encoding) {
+    case ChunkEncoding::Zero:
+        if (!fresh)
+            memset(dest, 0, record.size);
+        return true;
+    case ChunkEncoding::Raw:
+        if (!file.contains(record.offset, record.size))
+            return false;
+        stats.stored_bytes += record.size;
+#ifndef _WIN32
+        // protected memory is tracked by the renderer, mapping the file would drop the protection
+        if (record.offset % mem.page_size == 0 && !is_range_protected(mem, record.address, record.size) && file.map(dest, record.offset, record.size)) {
+            stats.mapped_chunks++;
+            return true;
+        }
+#endif
+        memcpy(dest, file.data + record.offset, record.size);
+        return true;
+    case ChunkEncoding::Deflate: {
+        if (!file.contains(record.offset, record.stored_size))
+            return false;
+        stats.stored_bytes += record.stored_size;
+        if (is_range_protected(mem, record.address, record.size)) {
+            std::vector<uint8_t> data(record.size);
+            mz_ulong size = record.size;
+            if (mz_uncompress(data.data(), &size, file.data + record.offset, record.stored_size) != MZ_OK || size != record.size)
+                return false;
+            memcpy(dest, data.data(), record.size);
+            return true;
+        }
+        mz_ulong size = record.size;
+        return mz_uncompress(dest, &size, file.data + record.offset, record.stored_size) == MZ_OK && size == record.size;
+    }
+    default:
+        return false;
+    }
+}
+
+// Allocate the ranges of the snapshot, the ones allocated by load_app must be the same. Returns the start and end of the new ranges.
+static std::optional<std::map<Address, Address>> allocate_ranges(MemState &mem, const std::vector<Range> &ranges) {
+    std::vector<Range> current_ranges;
+    {
+        const std::lock_guard<std::mutex> lock(mem.generation_mutex);
+        current_ranges = collect_ranges(mem);
+    }
+    for (const Range &current : current_ranges) {
+        const bool in_snapshot = std::any_of(ranges.begin(), ranges.end(), [&](const Range &range) {
+            return range.address == current.address && range.page_count == current.page_count;
+        });
+        if (!in_snapshot) {
+            LOG_ERROR("Memory at {} ({}) does not match the snapshot, the app or the emulator changed since it was saved", log_hex(current.address), current.name);
+            return std::nullopt;
+        }
+    }
+
+    std::map<Address, Address> fresh_ranges;
+    for (const Range &range : ranges) {
+        if (mem.alloc_table[range.address / mem.page_size].allocated)
+            continue;
+        const uint32_t size = range.page_count * mem.page_size;
+        if (!try_alloc_at(mem, range.address, size, range.name.c_str())) {
+            LOG_ERROR("Could not allocate the memory at {} ({})", log_hex(range.address), range.name);
+            return std::nullopt;
+        }
+        fresh_ranges.emplace(range.address, range.address + size);
+    }
+    return fresh_ranges;
+}
+
+static bool is_fresh(const std::map<Address, Address> &fresh_ranges, Address address) {
+    auto range = fresh_ranges.upper_bound(address);
+    if (range == fresh_ranges.begin())
+        return false;
+    --range;
+    return address < range->second;
+}
+
+bool load(const fs::path &path, EmuEnvState &emuenv, SnapshotStats *stats) {
+    const auto start = std::chrono::steady_clock::now();
+    MemState &mem = emuenv.mem;
+    KernelState &kernel = emuenv.kernel;
+
+    SnapshotFile file;
+    SnapshotContent content;
+    if (!file.open(path) || !parse(file, content)) {
+        LOG_ERROR("Could not read the snapshot {}", path);
+        return false;
+    }
+    if (content.header.page_size != mem.page_size || content.header.chunk_size != CHUNK_SIZE) {
+        LOG_ERROR("The snapshot {} was saved with a different memory layout", path);
+        return false;
+    }
+    if (emuenv.io.title_id != std::string(content.header.title_id, strnlen(content.header.title_id, sizeof(content.header.title_id)))) {
+        LOG_ERROR("The snapshot {} belongs to another app", path);
+        return false;
+    }
+
+    SnapshotFile base_file;
+    SnapshotContent base_content;
+    if (!content.base_name.empty()) {
+        const fs::path base = path.parent_path() / fs_utils::utf8_to_path(content.base_name);
+        if (!base_file.open(base) || !parse(base_file, base_content) || !base_content.base_name.empty()) {
+            LOG_ERROR("Could not read the base snapshot {}", base);
+            return false;
+        }
+    }
+    const auto base_chunks = load_base_chunks(base_content);
+
+    {
+        const std::lock_guard<std::mutex> lock(kernel.mutex);
+        if (!kernel.threads.empty()) {
+            LOG_ERROR("A snapshot can only be loaded before the app is started");
+            return false;
+        }
+    }
+
+    const auto fresh_ranges = allocate_ranges(mem, content.ranges);
+    if (!fresh_ranges)
+        return false;
+
+    SnapshotStats result;
+    for (const ChunkRecord &record : content.chunks) {
+        const ChunkRecord *source = &record;
+        const SnapshotFile *source_file = &file;
+        if (record.encoding == ChunkEncoding::Base) {
+            const auto base = base_chunks.find(record.address);
+            if (base == base_chunks.end() || base->second.size != record.size) {
+                LOG_CRITICAL("Snapshot {} does not match its base at {}, guest memory is now inconsistent", path, log_hex(record.address));
+                return false;
+            }
+            source = &base->second;
+            source_file = &base_file;
+            result.base_chunks++;
+        }
+        if (!restore_chunk(mem, *source, *source_file, is_fresh(*fresh_ranges, record.address), result)) {
+            LOG_CRITICAL("Snapshot {} is corrupted at {}, guest memory is now inconsistent", path, log_hex(record.address));
+            return false;
+        }
+        result.zero_chunks += source->encoding == ChunkEncoding::Zero;
+        result.allocated_bytes += record.size;
+    }
+    result.chunk_count = static_cast<uint32_t>(content.chunks.size());
+
+    ByteReader kernel_reader = content.section(SectionType::Kernel);
+    if (!load_kernel(kernel_reader, emuenv)) {
+        LOG_ERROR("The kernel state of the snapshot {} is invalid", path);
+        return false;
+    }
+
+    ByteReader thread_reader = content.section(SectionType::Threads);
+    const auto thread_snapshots = read_threads(thread_reader, kernel);
+    if (thread_reader.failed) {
+        LOG_ERROR("The threads of the snapshot {} are invalid", path);
+        return false;
+    }
+    std::vector<ThreadStatePtr> threads;
+    for (const auto &[snapshot, _] : thread_snapshots) {
+        const ThreadStatePtr thread = kernel.restore_thread(mem, snapshot);
+        if (!thread) {
+            LOG_ERROR("Could not create the thread {} ({}) again", snapshot.name, snapshot.id);
+            return false;
+        }
+        threads.push_back(thread);
+    }
+    result.thread_count = static_cast<uint32_t>(threads.size());
+
+    ByteReader object_reader = content.section(SectionType::Objects);
+    if (!load_objects(object_reader, kernel)) {
+        LOG_ERROR("The kernel objects of the snapshot {} are invalid", path);
+        return false;
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        const std::lock_guard<std::mutex> lock(kernel.mutex);
+        for (const SceUID uid : thread_snapshots[i].second) {
+            if (const CallbackPtr callback = find_callback(kernel, uid))
+                threads[i]->callbacks.push_back(callback);
+        }
+    }
+
+    ByteReader file_reader = content.section(SectionType::Files);
+    ByteReader audio_reader = content.section(SectionType::Audio);
+    ByteReader display_reader = content.section(SectionType::Display);
+    if (!load_files(file_reader, emuenv) || !load_audio(audio_reader, emuenv.audio) || !load_display(display_reader, kernel, emuenv.display)) {
+        LOG_ERROR("The snapshot {} is invalid", path);
+        return false;
+    }
+    // last, the libraries may rely on everything else
+    ByteReader library_reader = content.section(SectionType::Libraries);
+    if (!load_libraries(library_reader, kernel))
+        return false;
+
+    for (const ThreadStatePtr &thread : threads) {
+        if (thread->get_call_level() > 0)
+            thread->resume();
+    }
+
+    result.elapsed_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Loaded snapshot {} in {:.1f} ms: {} MiB of guest memory, {} chunks mapped, {} threads restored",
+        path, result.elapsed_ms, result.allocated_bytes / MiB(1), result.mapped_chunks, result.thread_count);
+    if (stats)
+        *stats = result;
+
+    return true;
+}
+
+} // namespace snapshot
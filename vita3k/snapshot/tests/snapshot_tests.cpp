@@ -0,0 +1,320 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <snapshot/snapshot.h>
+
+#include <audio/state.h>
+#include <emuenv/state.h>
+#include <io/functions.h>
+#include <io/state.h>
+#include <kernel/callback.h>
+#include <kernel/state.h>
+#include <kernel/sync_primitives.h>
+#include <kernel/thread/thread_state.h>
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr const char *TITLE_ID = "PCSG00001";
+constexpr const char *FILE_PATH = "ux0:data/snapshot_tests.bin";
+constexpr uint32_t DATA_SIZE = MiB(1);
+constexpr uint32_t ZERO_SIZE = KiB(256);
+// SCE_AUDIO_OUT_MODE_STEREO
+constexpr int SCE_AUDIO_OUT_MODE_STEREO = 1;
+
+void init_env(EmuEnvState &emuenv, const fs::path &pref_path) {
+    ASSERT_TRUE(init(emuenv.mem, false));
+    ASSERT_TRUE(emuenv.kernel.init(emuenv.mem, [](CPUState &, uint32_t, SceUID) {}, CPUBackend::Dynarmic, false));
+    ASSERT_TRUE(emuenv.audio.init([](SceUID) {}, "Null"));
+    emuenv.io.title_id = TITLE_ID;
+    emuenv.pref_path = pref_path;
+}
+
+void exit_threads(KernelState &kernel) {
+    kernel.exit_delete_all_threads();
+    // the host threads remove themselves from the kernel once they are done
+    for (int i = 0; i < 1000; i++) {
+        {
+            const std::lock_guard<std::mutex> lock(kernel.mutex);
+            if (kernel.threads.empty())
+                return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+template <typename T>
+std::shared_ptr<T> make_primitive(KernelState &kernel, const char *name, uint32_t attr) {
+    auto primitive = std::make_shared<T>();
+    primitive->uid = kernel.get_next_uid();
+    primitive->attr = attr;
+    strncpy(primitive->name, name, KERNELOBJECT_MAX_NAME_LENGTH);
+    return primitive;
+}
+
+// Saves the state of an app in one EmuEnvState, then loads it in a fresh one as a new run of the emulator would
+class snapshot_round_trip : public testing::Test {
+protected:
+    void SetUp() override {
+        root = fs::temp_directory_path() / fmt::format("vita3k-snapshot-tests-{}", std::chrono::steady_clock::now().time_since_epoch().count());
+        fs::create_directories(root / "ux0" / "data");
+        snapshot_path = root / "state.v3ks";
+
+        init_env(saved, root);
+        init_env(loaded, root);
+        for (EmuEnvState *emuenv : { &saved, &loaded }) {
+            emuenv->kernel.snapshot_handlers.emplace("Test", LibrarySnapshotHandler{
+                                                                 [this](std::string &data) { data = library_state; },
+                                                                 [this](const std::string &data) {
+                                                                     library_state = data;
+                                                                     return data != "invalid";
+                                                                 },
+                                                             });
+        }
+    }
+
+    void TearDown() override {
+        exit_threads(saved.kernel);
+        exit_threads(loaded.kernel);
+        fs::remove_all(root);
+    }
+
+    // guest memory with data, a range of zeros and a block which is not a multiple of the chunk size
+    void fill_memory() {
+        data = alloc(saved.mem, DATA_SIZE, "snapshot data");
+        zeros = alloc(saved.mem, ZERO_SIZE, "snapshot zeros");
+        tail = alloc(saved.mem, KiB(12), "snapshot tail");
+        ASSERT_NE(data, 0u);
+        ASSERT_NE(zeros, 0u);
+        ASSERT_NE(tail, 0u);
+        uint8_t *bytes = Ptr<uint8_t>(data).get(saved.mem);
+        for (uint32_t i = 0; i < DATA_SIZE; i++)
+            bytes[i] = static_cast<uint8_t>(i * 31 + (i >> 12));
+        memset(Ptr<uint8_t>(zeros).get(saved.mem), 0, ZERO_SIZE);
+        memset(Ptr<uint8_t>(tail).get(saved.mem), 0x5A, KiB(12));
+    }
+
+    bool same_memory(Address address, uint32_t size) {
+        return memcmp(Ptr<uint8_t>(address).get(saved.mem), Ptr<uint8_t>(address).get(loaded.mem), size) == 0;
+    }
+
+    EmuEnvState saved;
+    EmuEnvState loaded;
+    fs::path root;
+    fs::path snapshot_path;
+    std::string library_state;
+    Address data = 0;
+    Address zeros = 0;
+    Address tail = 0;
+};
+
+} // namespace
+
+TEST_F(snapshot_round_trip, restores_memory) {
+    fill_memory();
+
+    snapshot::SnapshotStats save_stats;
+    ASSERT_TRUE(snapshot::save(snapshot_path, saved, {}, &save_stats));
+    EXPECT_GT(save_stats.zero_chunks, 0u);
+    EXPECT_LT(save_stats.stored_bytes, save_stats.allocated_bytes);
+
+    snapshot::SnapshotStats load_stats;
+    ASSERT_TRUE(snapshot::load(snapshot_path, loaded, &load_stats));
+    EXPECT_EQ(load_stats.allocated_bytes, save_stats.allocated_bytes);
+    EXPECT_EQ(load_stats.chunk_count, save_stats.chunk_count);
+
+    EXPECT_TRUE(same_memory(data, DATA_SIZE));
+    EXPECT_TRUE(same_memory(zeros, ZERO_SIZE));
+    EXPECT_TRUE(same_memory(tail, KiB(12)));
+    EXPECT_EQ(loaded.mem.page_name_map.at(data / loaded.mem.page_size), "snapshot data");
+
+    // the mapped memory is private to the process, writing to it leaves the snapshot as it was
+    memset(Ptr<uint8_t>(data).get(loaded.mem), 0xFF, DATA_SIZE);
+    EmuEnvState again;
+    init_env(again, root);
+    ASSERT_TRUE(snapshot::load(snapshot_path, again, nullptr));
+    EXPECT_EQ(memcmp(Ptr<uint8_t>(data).get(saved.mem), Ptr<uint8_t>(data).get(again.mem), DATA_SIZE), 0);
+}
+
+TEST_F(snapshot_round_trip, restores_incremental_snapshot) {
+    fill_memory();
+    const fs::path base_path = root / "base.v3ks";
+    ASSERT_TRUE(snapshot::save(base_path, saved));
+
+    Ptr<uint8_t>(data + KiB(300)).get(saved.mem)[0] ^= 0xFF;
+    snapshot::SnapshotStats stats;
+    ASSERT_TRUE(snapshot::save(snapshot_path, saved, base_path, &stats));
+    EXPECT_GT(stats.base_chunks, 0u);
+
+    ASSERT_TRUE(snapshot::load(snapshot_path, loaded));
+    EXPECT_TRUE(same_memory(data, DATA_SIZE));
+    EXPECT_TRUE(same_memory(tail, KiB(12)));
+}
+
+TEST_F(snapshot_round_trip, restores_kernel_objects) {
+    KernelState &kernel = saved.kernel;
+
+    const SemaphorePtr semaphore = make_primitive<Semaphore>(kernel, "semaphore", SCE_KERNEL_ATTR_TH_PRIO);
+    semaphore->max = 8;
+    semaphore->val = 3;
+    semaphore->init_val = 1;
+    kernel.semaphores.emplace(semaphore->uid, semaphore);
+
+    const EventFlagPtr eventflag = make_primitive<EventFlag>(kernel, "eventflag", 0);
+    eventflag->flags = 0x1234;
+    kernel.eventflags.emplace(eventflag->uid, eventflag);
+
+    const TimerPtr timer = make_primitive<Timer>(kernel, "timer", 0);
+    timer->is_started = true;
+    timer->event_interval = 500;
+    timer->next_event = std::numeric_limits<uint64_t>::max();
+    kernel.timers.emplace(timer->uid, timer);
+
+    auto msgpipe = std::make_shared<MsgPipe>(KiB(4));
+    msgpipe->uid = kernel.get_next_uid();
+    strncpy(msgpipe->name, "msgpipe", KERNELOBJECT_MAX_NAME_LENGTH);
+    const char message[] = "queued message";
+    msgpipe->data_buffer.Insert(reinterpret_cast<const uint8_t *>(message), sizeof(message));
+    kernel.msgpipes.emplace(msgpipe->uid, msgpipe);
+
+    const ThreadStatePtr thread = kernel.create_thread(saved.mem, "snapshot thread", Ptr<const void>(0x81000000), 0x50, SCE_KERNEL_THREAD_CPU_AFFINITY_MASK_DEFAULT, KiB(64), nullptr);
+    ASSERT_TRUE(thread);
+    std::string callback_name = "callback";
+    const SceUID callback_uid = kernel.get_next_uid();
+    const CallbackPtr callback = std::make_shared<Callback>(thread->id, thread, callback_name, Ptr<SceKernelCallbackFunction>(0x81000100), Ptr<void>(0x1000));
+    callback->notify(thread->id, 7);
+    kernel.callbacks.emplace(callback_uid, callback);
+    thread->callbacks.push_back(callback);
+
+    ASSERT_TRUE(snapshot::save(snapshot_path, saved));
+    ASSERT_TRUE(snapshot::load(snapshot_path, loaded));
+    KernelState &restored = loaded.kernel;
+
+    const SemaphorePtr restored_semaphore = restored.semaphores.at(semaphore->uid);
+    EXPECT_STREQ(restored_semaphore->name, "semaphore");
+    EXPECT_EQ(restored_semaphore->attr, semaphore->attr);
+    EXPECT_EQ(restored_semaphore->max, 8);
+    EXPECT_EQ(restored_semaphore->val, 3);
+    EXPECT_EQ(restored_semaphore->init_val, 1);
+    EXPECT_TRUE(restored_semaphore->waiting_threads);
+
+    EXPECT_EQ(restored.eventflags.at(eventflag->uid)->flags, 0x1234);
+
+    const TimerPtr restored_timer = restored.timers.at(timer->uid);
+    EXPECT_TRUE(restored_timer->is_started);
+    EXPECT_EQ(restored_timer->event_interval, 500u);
+    EXPECT_EQ(restored_timer->next_event, std::numeric_limits<uint64_t>::max());
+
+    const MsgPipePtr restored_msgpipe = restored.msgpipes.at(msgpipe->uid);
+    ASSERT_EQ(restored_msgpipe->data_buffer.Used(), sizeof(message));
+    char restored_message[sizeof(message)];
+    restored_msgpipe->data_buffer.Peek(reinterpret_cast<uint8_t *>(restored_message), sizeof(message));
+    EXPECT_STREQ(restored_message, message);
+
+    const ThreadStatePtr restored_thread = restored.get_thread(thread->id);
+    ASSERT_TRUE(restored_thread);
+    EXPECT_EQ(restored_thread->name, "snapshot thread");
+    EXPECT_EQ(restored_thread->entry_point, thread->entry_point);
+    EXPECT_EQ(restored_thread->priority, thread->priority);
+    EXPECT_EQ(restored_thread->stack_size, thread->stack_size);
+    EXPECT_EQ(restored_thread->stack.get(), thread->stack.get());
+    EXPECT_EQ(restored_thread->status, ThreadStatus::dormant);
+
+    const CallbackPtr restored_callback = restored.callbacks.at(callback_uid);
+    EXPECT_EQ(restored_callback->get_name(), "callback");
+    EXPECT_EQ(restored_callback->get_owner_thread_id(), thread->id);
+    EXPECT_EQ(restored_callback->get_callback_function().address(), 0x81000100u);
+    EXPECT_EQ(restored_callback->get_notify_arg(), 7);
+    EXPECT_EQ(restored_callback->get_num_notifications(), 1u);
+    ASSERT_EQ(restored_thread->callbacks.size(), 1u);
+    EXPECT_EQ(restored_thread->callbacks.front(), restored_callback);
+
+    // the uids given after the load do not collide with the restored ones
+    EXPECT_EQ(restored.get_next_uid(), kernel.get_next_uid());
+}
+
+TEST_F(snapshot_round_trip, restores_files_audio_and_libraries) {
+    const SceUID fd = open_file(saved.io, FILE_PATH, SCE_O_RDWR | SCE_O_CREAT | SCE_O_TRUNC, root, "snapshot_tests");
+    ASSERT_GE(fd, 0);
+    const char contents[] = "some file contents";
+    ASSERT_EQ(write_file(fd, contents, sizeof(contents), saved.io, "snapshot_tests"), static_cast<int>(sizeof(contents)));
+    ASSERT_EQ(seek_file(fd, 5, SCE_SEEK_SET, saved.io, "snapshot_tests"), 5);
+
+    const AudioOutPortPtr port = saved.audio.open_port(2, 48000, 256);
+    ASSERT_TRUE(port);
+    port->type = 0;
+    port->len = 256;
+    port->freq = 48000;
+    port->mode = SCE_AUDIO_OUT_MODE_STEREO;
+    port->left_channel_volume = 0x4000;
+    port->right_channel_volume = 0x2000;
+    const int port_id = saved.audio.next_port_id++;
+    saved.audio.out_ports.emplace(port_id, port);
+
+    library_state = "library state";
+    ASSERT_TRUE(snapshot::save(snapshot_path, saved));
+    library_state.clear();
+    close_file(saved.io, fd, "snapshot_tests");
+
+    ASSERT_TRUE(snapshot::load(snapshot_path, loaded));
+
+    EXPECT_EQ(tell_file(loaded.io, fd, "snapshot_tests"), 5);
+    char restored_contents[sizeof(contents) - 5];
+    ASSERT_EQ(read_file(restored_contents, loaded.io, fd, sizeof(restored_contents), "snapshot_tests"), static_cast<int>(sizeof(restored_contents)));
+    EXPECT_STREQ(restored_contents, contents + 5);
+    EXPECT_EQ(loaded.io.next_fd, saved.io.next_fd);
+
+    const AudioOutPortPtr restored_port = loaded.audio.out_ports.at(port_id);
+    EXPECT_EQ(restored_port->len, 256);
+    EXPECT_EQ(restored_port->freq, 48000);
+    EXPECT_EQ(restored_port->mode, SCE_AUDIO_OUT_MODE_STEREO);
+    EXPECT_EQ(restored_port->left_channel_volume, 0x4000);
+    EXPECT_EQ(restored_port->right_channel_volume, 0x2000);
+    EXPECT_EQ(loaded.audio.next_port_id, saved.audio.next_port_id);
+
+    EXPECT_EQ(library_state, "library state");
+}
+
+TEST_F(snapshot_round_trip, rejects_invalid_snapshots) {
+    fill_memory();
+    ASSERT_TRUE(snapshot::save(snapshot_path, saved));
+
+    loaded.io.title_id = "PCSG00002";
+    EXPECT_FALSE(snapshot::load(snapshot_path, loaded));
+    loaded.io.title_id = TITLE_ID;
+
+    // a library which can not restore its state fails the load
+    library_state = "invalid";
+    ASSERT_TRUE(snapshot::save(snapshot_path, saved));
+    EXPECT_FALSE(snapshot::load(snapshot_path, loaded));
+
+    // a truncated file is not a snapshot
+    const auto size = fs::file_size(snapshot_path);
+    fs::resize_file(snapshot_path, size / 2);
+    EmuEnvState other;
+    init_env(other, root);
+    EXPECT_FALSE(snapshot::load(snapshot_path, other));
+}
@@ -6,6 +6,8 @@
 
 std::vector<SceFVector2> get_touchpad_fingers_pos(SceTouchPortType &port);
 int handle_touchpad_event(SDL_ControllerTouchpadEvent &touchpad);
+// Must be called before the guest and the vsync start using the touch buffers
+void touch_init_buffers();
 void touch_vsync_update(const EmuEnvState &emuenv);
 int handle_touch_event(SDL_TouchFingerEvent &finger);
 int toggle_touchscreen();
@@ -22,13 +22,15 @@
 #include <touch/functions.h>
 #include <touch/state.h>
 #include <touch/touch.h>
+#include <util/history_ring.h>
 
 #include <SDL_events.h>
 
+#include <algorithm>
 #include <cstring>
 
-static SceTouchData touch_buffers[MAX_TOUCH_BUFFER_SAVED][2];
-static int touch_buffer_idx = 0;
+// written at each vsync, read by sceTouchRead/Peek without a lock
+static HistoryRing<SceTouchData, MAX_TOUCH_BUFFER_SAVED * 2> touch_history[2];
 static bool is_touchpad = false;
 static SDL_TouchFingerEvent finger_buffer[8];
 static SDL_ControllerTouchpadEvent touchpad_buffer[8];
@@ -87,15 +89,29 @@ static SceTouchData recover_touchpad_events(const EmuEnvState &emuenv) {
     return touch_data;
 }
 
+static uint64_t get_touch_timestamp() {
+    const auto ts = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(ts.time_since_epoch()).count();
+}
+
+void touch_init_buffers() {
+    // reads made before the first vsync get a buffer with no touch instead of none
+    SceTouchData data = {};
+    data.timeStamp = get_touch_timestamp();
+    for (int port = 0; port < 2; port++) {
+        if (touch_history[port].count() == 0)
+            touch_history[port].push(data);
+    }
+}
+
 void touch_vsync_update(const EmuEnvState &emuenv) {
-    std::chrono::time_point<std::chrono::steady_clock> ts = std::chrono::steady_clock::now();
-    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(ts.time_since_epoch()).count();
+    const uint64_t timestamp = get_touch_timestamp();
 
+    SceTouchData buffers[2] = {};
     if (finger_count > 0) {
         SceTouchData touch_data = is_touchpad ? recover_touchpad_events(emuenv) : recover_touch_events(emuenv);
         touch_data.timeStamp = timestamp;
 
-        SceTouchData *buffers = touch_buffers[(touch_buffer_idx + 1) % MAX_TOUCH_BUFFER_SAVED];
         for (int port = 0; port < 2; port++) {
             buffers[port].status = 0;
             buffers[port].reportNum = 0;
@@ -109,7 +125,7 @@ void touch_vsync_update(const EmuEnvState &emuenv) {
 
         for (int port = 0; port < 2; port++) {
             // do it for both the front and the back touchscreen
-            SceTouchData *data = &touch_buffers[(touch_buffer_idx + 1) % MAX_TOUCH_BUFFER_SAVED][port];
+            SceTouchData *data = &buffers[port];
             memset(data, 0, sizeof(SceTouchData));
             data->timeStamp = timestamp;
 
@@ -162,8 +178,8 @@ void touch_vsync_update(const EmuEnvState &emuenv) {
         }
     }
 
-    touch_buffer_idx++;
-    touch_buffer_idx %= MAX_TOUCH_BUFFER_SAVED;
+    for (int port = 0; port < 2; port++)
+        touch_history[port].push(buffers[port]);
 }
 
 int handle_touch_event(SDL_TouchFingerEvent &finger) {
@@ -292,25 +308,14 @@ int touch_get(const SceUID thread_id, EmuEnvState &emuenv, const SceUInt32 &port
         last_vcount[port_idx] = vblank_count;
     }
 
-    int corr_buffer_idx;
-    if (is_peek) {
-        corr_buffer_idx = touch_buffer_idx;
-    } else {
-        // give the oldest buffer first
-        corr_buffer_idx = (touch_buffer_idx - nb_returned_data + 1 + MAX_TOUCH_BUFFER_SAVED) % MAX_TOUCH_BUFFER_SAVED;
-    }
-    for (int32_t i = 0; i < nb_returned_data; i++) {
-        memcpy(&pData[i], &touch_buffers[corr_buffer_idx][port_idx], sizeof(SceTouchData));
-        if (forceTouchEnabled[port_idx]) {
+    // give the oldest buffer first, a peek returns the latest ones as well
+    nb_returned_data = touch_history[port_idx].read(pData, std::min<uint32_t>(nb_returned_data, MAX_TOUCH_BUFFER_SAVED));
+    if (forceTouchEnabled[port_idx]) {
+        for (int32_t i = 0; i < nb_returned_data; i++) {
             for (int32_t j = 0; j < pData[i].reportNum; j++) {
                 pData[i].report[j].force = 128;
             }
         }
-        // if peek, repeat the last buffer
-        if (!is_peek) {
-            corr_buffer_idx++;
-            corr_buffer_idx %= MAX_TOUCH_BUFFER_SAVED;
-        }
     }
 
     return nb_returned_data;
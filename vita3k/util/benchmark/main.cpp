@@ -0,0 +1,104 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Measures what a log call costs the calling thread, the guest thread in the emulator:
+// - spdlog writing synchronously to a file, like LOG_* used to
+// - the ring with arguments stored as they are, or formatted on the calling thread
+// - messages suppressed by the deduplication and the rate limit, and a disabled level
+// The time the writer then takes to write everything to the file is reported separately.
+
+#include <util/log.h>
+
+#include <spdlog/sinks/basic_file_sink.h>
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+struct Options {
+    uint32_t calls = 200000;
+    std::string path = (std::filesystem::temp_directory_path() / "vita3k-log-benchmark").string();
+};
+
+void run_case(const Options &options, const char *name, const std::function<void(uint32_t)> &log) {
+    const auto start = clock::now();
+    for (uint32_t i = 0; i < options.calls; i++)
+        log(i);
+    const auto logged = clock::now();
+    logging::flush();
+    const auto flushed = clock::now();
+
+    fmt::print("{:<28} {:>12.1f} {:>12.1f}\n", name, std::chrono::duration<double, std::nano>(logged - start).count() / options.calls,
+        std::chrono::duration<double, std::milli>(flushed - logged).count());
+}
+
+void print_usage() {
+    fmt::print("Usage: util-benchmark [--calls N] [--log-dir DIR]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--calls" && i + 1 < argc) {
+            options.calls = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--log-dir" && i + 1 < argc) {
+            options.path = (std::filesystem::path(argv[++i]) / "vita3k-log-benchmark").string();
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    const std::string export_name = "sceKernelUnimplementedFunction";
+    fmt::print("{} calls per case, ns per call on the calling thread, ms to write the rest\n", options.calls);
+    fmt::print("{:<28} {:>12} {:>12}\n", "case", "call", "flush");
+
+    {
+        auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(options.path + "-sync.log", true);
+        sink->set_pattern("%^[%H:%M:%S.%e] |%L| [%!]: %v%$");
+        spdlog::logger logger("sync", sink);
+        run_case(options, "spdlog synchronous", [&](uint32_t i) {
+            logger.log(spdlog::source_loc{ __FILE__, __LINE__, SPDLOG_FUNCTION }, spdlog::level::warn, "Call {} of {} returned {}", i, export_name, -1);
+        });
+        logger.flush();
+    }
+
+    if (logging::add_sink(options.path + ".log") != Success)
+        return 1;
+    logging::set_level(spdlog::level::info);
+
+    logging::set_rate_limit(0);
+    run_case(options, "ring, arguments stored", [&](uint32_t i) { LOG_WARN("Call {} returned {}", i, -1); });
+    run_case(options, "ring, formatted", [&](uint32_t i) { LOG_WARN("Call {} of {} returned {}", i, export_name, -1); });
+    run_case(options, "ring, identical message", [&](uint32_t) { LOG_WARN("Unimplemented {} import called.", export_name); });
+
+    logging::set_rate_limit(1000);
+    run_case(options, "ring, over the rate limit", [&](uint32_t i) { LOG_WARN("Call {} returned {}", i, -1); });
+    run_case(options, "disabled level", [&](uint32_t i) { LOG_DEBUG("Call {} returned {}", i, -1); });
+
+    return 0;
+}
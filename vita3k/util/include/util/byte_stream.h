@@ -0,0 +1,151 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Appends values to a byte buffer, in the host byte order
+class ByteWriter {
+public:
+    explicit ByteWriter(std::string &buffer)
+        : buffer(buffer) {
+    }
+
+    template <typename T>
+    void write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void write_bytes(const void *data, size_t size) {
+        buffer.append(static_cast<const char *>(data), size);
+    }
+
+    void write_string(const std::string &str) {
+        write(static_cast<uint32_t>(str.size()));
+        buffer += str;
+    }
+
+    template <typename T>
+    void write_vector(const std::vector<T> &values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(static_cast<uint32_t>(values.size()));
+        write_bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    size_t size() const {
+        return buffer.size();
+    }
+
+private:
+    std::string &buffer;
+};
+
+// Reads back what a ByteWriter wrote, every read is bounds checked
+// Once a read goes past the end, failed is set and all the following reads return empty values
+class ByteReader {
+public:
+    ByteReader(const void *data, size_t size)
+        : data(static_cast<const uint8_t *>(data))
+        , size(size) {
+    }
+
+    explicit ByteReader(const std::string &buffer)
+        : ByteReader(buffer.data(), buffer.size()) {
+    }
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (!can_read(sizeof(T)))
+            return value;
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    bool read_bytes(void *dest, size_t length) {
+        if (!can_read(length))
+            return false;
+        memcpy(dest, data + offset, length);
+        offset += length;
+        return true;
+    }
+
+    std::string read_string() {
+        const auto length = read<uint32_t>();
+        if (!can_read(length))
+            return {};
+        std::string str(reinterpret_cast<const char *>(data + offset), length);
+        offset += length;
+        return str;
+    }
+
+    template <typename T>
+    std::vector<T> read_vector() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto count = read<uint32_t>();
+        if (!can_read(static_cast<uint64_t>(count) * sizeof(T)))
+            return {};
+        std::vector<T> values(count);
+        memcpy(values.data(), data + offset, count * sizeof(T));
+        offset += count * sizeof(T);
+        return values;
+    }
+
+    void skip(size_t length) {
+        if (can_read(length))
+            offset += length;
+    }
+
+    // Bounds check of a read of length bytes at the current position
+    bool can_read(uint64_t length) {
+        if (failed || length > size - offset) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t *current() const {
+        return data + offset;
+    }
+
+    size_t position() const {
+        return offset;
+    }
+
+    void seek(size_t position) {
+        if (position > size)
+            failed = true;
+        else
+            offset = position;
+    }
+
+    bool failed = false;
+
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t offset = 0;
+};
@@ -30,5 +30,6 @@ enum ExitCode {
     ModuleLoadFailed,
     InitThreadFailed,
     RunThreadFailed,
-    KernelInitFailed
+    KernelInitFailed,
+    SnapshotLoadFailed
 };
@@ -0,0 +1,111 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// The last SIZE samples of an input, written by a single thread at a time and read from any thread without a lock.
+// The newest sample can be updated in place until the next one is pushed: it follows the host between two vblanks
+// while the older ones keep the state they had at the vblank that ended them.
+template <typename T, uint32_t SIZE>
+class HistoryRing {
+    static_assert(std::is_trivially_copyable_v<T>, "the samples are copied word by word");
+    static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+
+public:
+    // Most samples a read returns, the ones older than this may be overwritten while they are copied
+    static constexpr uint32_t MAX_READ = SIZE / 2;
+
+    // Samples pushed since the start
+    uint64_t count() const {
+        return head.load(std::memory_order_acquire);
+    }
+
+    void push(const T &sample) {
+        const uint64_t index = head.load(std::memory_order_relaxed);
+        store(slots[index % SIZE], sample);
+        head.store(index + 1, std::memory_order_release);
+    }
+
+    void update_newest(const T &sample) {
+        const uint64_t index = head.load(std::memory_order_relaxed);
+        if (index == 0)
+            push(sample);
+        else
+            store(slots[(index - 1) % SIZE], sample);
+    }
+
+    // Copies the newest samples, at most count and MAX_READ, the oldest first. Returns how many were copied.
+    uint32_t read(T *out, uint32_t count) const {
+        while (true) {
+            const uint64_t end = head.load(std::memory_order_acquire);
+            const uint32_t copied = static_cast<uint32_t>(std::min<uint64_t>({ count, end, MAX_READ }));
+            const uint64_t begin = end - copied;
+            for (uint32_t i = 0; i < copied; i++)
+                load(slots[(begin + i) % SIZE], out[i]);
+
+            // the slot of a sample is written again when the one SIZE samples later is pushed
+            if (head.load(std::memory_order_acquire) - begin < SIZE)
+                return copied;
+        }
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // the sequence is odd while the slot is written
+    struct Slot {
+        std::atomic<uint32_t> sequence = 0;
+        std::array<std::atomic<uint64_t>, WORDS> words{};
+    };
+
+    static void store(Slot &slot, const T &sample) {
+        uint64_t words[WORDS] = {};
+        std::memcpy(words, &sample, sizeof(T));
+
+        const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    static void load(const Slot &slot, T &sample) {
+        uint64_t words[WORDS];
+        while (true) {
+            const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence & 1)
+                continue;
+            for (size_t i = 0; i < WORDS; i++)
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+                break;
+        }
+        std::memcpy(&sample, words, sizeof(T));
+    }
+
+    std::array<Slot, SIZE> slots;
+    std::atomic<uint64_t> head = 0;
+};
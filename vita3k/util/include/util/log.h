@@ -23,14 +23,31 @@
 #include <util/exit_code.h>
 #include <util/fs.h>
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 
-#define LOG_TRACE SPDLOG_TRACE
-#define LOG_DEBUG SPDLOG_DEBUG
-#define LOG_INFO SPDLOG_INFO
-#define LOG_WARN SPDLOG_WARN
-#define LOG_ERROR SPDLOG_ERROR
-#define LOG_CRITICAL SPDLOG_CRITICAL
+// Every call site gets its own rate limit and deduplication state, the arguments are checked against
+// the format at compile time and only evaluated when the level is enabled
+#define LOG_AT(level, format, ...)                                                                                    \
+    do {                                                                                                              \
+        if (logging::should_log(level)) {                                                                             \
+            static logging::CallSite LOG_SITE(__FILE__, __LINE__, SPDLOG_FUNCTION);                                   \
+            logging::log<logging::is_literal<decltype(format)>>(LOG_SITE, level, format, ##__VA_ARGS__);              \
+        }                                                                                                             \
+    } while (0)
+
+#define LOG_TRACE(...) LOG_AT(spdlog::level::trace, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(spdlog::level::debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(spdlog::level::info, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(spdlog::level::warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(spdlog::level::err, __VA_ARGS__)
+#define LOG_CRITICAL(...) LOG_AT(spdlog::level::critical, __VA_ARGS__)
 
 #define LOG_TRACE_IF(flag, ...) \
     if (flag)                   \
@@ -66,11 +83,132 @@
 #define LOG_ERROR_ONCE(...) LOG_ONCE(LOG_ERROR, __VA_ARGS__)
 #define LOG_CRITICAL_ONCE(...) LOG_ONCE(LOG_CRITICAL, __VA_ARGS__)
 
+template <class T>
+class Ptr;
+
 namespace logging {
 
 ExitCode init(const Root &root_paths, bool use_stdout);
 void set_level(spdlog::level::level_enum log_level);
 ExitCode add_sink(const fs::path &log_path);
+// Write everything logged so far, also done on exit and on a crash
+void flush();
+// Maximum number of messages written per second from a single call site, 0 to remove the limit
+void set_rate_limit(uint32_t messages_per_second);
+
+// The messages are queued in a ring and written by a dedicated thread, the calling thread only formats
+// them when an argument may not be alive anymore by the time the writer gets to it
+struct CallSite {
+    CallSite(const char *file, int line, const char *function);
+
+    const spdlog::source_loc source;
+    CallSite *next = nullptr;
+
+    // only held to update the fields below
+    std::atomic<bool> busy = false;
+    bool has_last = false;
+    uint64_t last_hash = 0;
+    // identical messages not written since the last one was
+    uint32_t repeats = 0;
+    int64_t last_written = 0;
+    int64_t window = 0;
+    uint32_t window_count = 0;
+    // messages over the rate limit since the last one written
+    uint32_t dropped = 0;
+    spdlog::level::level_enum level = spdlog::level::info;
+};
+
+struct Record;
+// Turns the arguments stored in a record into the message
+typedef void (*FormatFn)(std::string_view format, const void *args, fmt::memory_buffer &out);
+
+// Arguments of a message from a literal format with only arguments of these types are stored as they are
+constexpr size_t RECORD_ARGS_SIZE = 128;
+
+template <typename T>
+constexpr bool is_literal = std::is_array_v<std::remove_reference_t<T>>;
+
+template <typename T>
+struct is_deferrable : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_same_v<T, void *> || std::is_same_v<T, const void *>> {};
+
+template <typename T>
+struct is_deferrable<Ptr<T>> : std::true_type {};
+
+inline bool should_log(spdlog::level::level_enum level) {
+    return spdlog::default_logger_raw()->should_log(level);
+}
+
+// Returns null when the message must not be written: it repeats the last one, the call site is over its rate limit
+// or the ring is full
+Record *begin_record(CallSite &site, spdlog::level::level_enum level, uint64_t hash);
+void *record_args(Record *record);
+void commit_deferred(Record *record, FormatFn format_args, std::string_view format);
+void commit_text(Record *record, std::string_view text);
+
+template <typename T>
+uint64_t hash_arg(const T &value) {
+    return std::hash<T>{}(value);
+}
+
+template <typename T>
+uint64_t hash_arg(const Ptr<T> &value) {
+    return value.address();
+}
+
+template <typename... Args>
+void format_args(std::string_view format, const void *args, fmt::memory_buffer &out) {
+    std::apply([&](const Args &...values) { fmt::format_to(std::back_inserter(out), fmt::runtime(format), values...); },
+        *static_cast<const std::tuple<Args...> *>(args));
+}
+
+inline void format_verbatim(std::string_view format, const void *args, fmt::memory_buffer &out) {
+    out.append(format);
+}
+
+template <bool literal, typename... Args>
+void log(CallSite &site, spdlog::level::level_enum level, fmt::format_string<Args...> format, Args &&...args) {
+    using Stored = std::tuple<std::remove_cvref_t<Args>...>;
+    constexpr bool deferred = literal && (is_deferrable<std::remove_cvref_t<Args>>::value && ...)
+        && sizeof(Stored) <= RECORD_ARGS_SIZE && alignof(Stored) <= alignof(std::max_align_t);
+
+    const fmt::string_view format_string = format;
+    const std::string_view format_view(format_string.data(), format_string.size());
+    if constexpr (deferred) {
+        uint64_t hash = std::hash<const void *>{}(format_view.data());
+        ((hash = hash * 31 + hash_arg(args)), ...);
+        Record *record = begin_record(site, level, hash);
+        if (!record)
+            return;
+
+        new (record_args(record)) Stored(args...);
+        commit_deferred(record, &format_args<std::remove_cvref_t<Args>...>, format_view);
+    } else {
+        fmt::memory_buffer text;
+        fmt::format_to(std::back_inserter(text), format, std::forward<Args>(args)...);
+        const std::string_view text_view(text.data(), text.size());
+        Record *record = begin_record(site, level, std::hash<std::string_view>{}(text_view));
+        if (record)
+            commit_text(record, text_view);
+    }
+}
+
+// A single argument is written as it is, like spdlog does
+template <bool literal, typename T>
+void log(CallSite &site, spdlog::level::level_enum level, const T &message) {
+    if constexpr (literal) {
+        const std::string_view text(message);
+        Record *record = begin_record(site, level, std::hash<const void *>{}(text.data()));
+        if (record)
+            commit_deferred(record, &format_verbatim, text);
+    } else {
+        fmt::memory_buffer text;
+        fmt::format_to(std::back_inserter(text), "{}", message);
+        const std::string_view text_view(text.data(), text.size());
+        Record *record = begin_record(site, level, std::hash<std::string_view>{}(text_view));
+        if (record)
+            commit_text(record, text_view);
+    }
+}
 
 } // namespace logging
 
@@ -113,8 +251,6 @@ std::string log_hex_full(T val) {
     return fmt::format("0x{:0{}X}", static_cast<std::make_unsigned_t<T>>(val), sizeof(T) * 2);
 }
 
-template <class T>
-class Ptr;
 FMT_BEGIN_NAMESPACE
 template <typename T, typename Char>
 struct formatter<Ptr<T>, Char> : formatter<string_view, Char> {
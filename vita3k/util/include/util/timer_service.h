@@ -0,0 +1,114 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct TimerStats {
+    uint64_t fired = 0;
+    // deadlines of a periodic timer skipped because the previous call returned too late
+    uint64_t missed_periods = 0;
+    // how long after their deadline the timers were fired
+    std::chrono::nanoseconds total_lateness{ 0 };
+    std::chrono::nanoseconds max_lateness{ 0 };
+};
+
+// Fires every timer of the emulator from a single thread: the display vblank, thread delays...
+// The deadlines are kept in a min-heap, the thread sleeps until the earliest one with an absolute
+// deadline and spins the last microseconds so that the host scheduler granularity does not add up.
+class TimerService {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef uint64_t TimerId;
+    // Called without the service lock with the time the timer was fired at, it can add and cancel timers
+    typedef std::function<void(Clock::time_point)> Callback;
+
+    TimerService() = default;
+    TimerService(const TimerService &) = delete;
+    TimerService &operator=(const TimerService &) = delete;
+    ~TimerService();
+
+    void start();
+    // The single shot timers left are fired right away so that nobody keeps waiting on them,
+    // the periodic ones are kept for the next start
+    void stop();
+
+    // Fired once at deadline, or every period starting from deadline when period is not zero. Never returns 0.
+    TimerId add(Clock::time_point deadline, Callback callback, Clock::duration period = Clock::duration::zero());
+    // Returns false when the timer does not exist anymore. Once it returns, the callback is not running
+    // anymore unless it is the one canceling itself.
+    bool cancel(TimerId id);
+    // Blocks the calling thread until deadline, through the service thread when it is running
+    void wait_until(Clock::time_point deadline);
+
+    // Fires the timers due at now and returns the earliest deadline left, Clock::time_point::max() when there is none.
+    // This is what the service thread runs, a headless loop can call it directly with its own clock instead of starting it.
+    Clock::time_point process(Clock::time_point now);
+
+    size_t size() const;
+    TimerStats get_stats() const;
+    void reset_stats();
+
+    // Sleeps with an absolute host deadline and spins the rest
+    static void sleep_until(Clock::time_point deadline);
+
+private:
+    struct Timer {
+        Callback callback;
+        Clock::duration period;
+        Clock::time_point deadline;
+    };
+
+    struct Deadline {
+        Clock::time_point time;
+        TimerId id;
+
+        bool operator>(const Deadline &other) const {
+            return time > other.time || (time == other.time && id > other.id);
+        }
+    };
+
+    TimerId add_locked(Clock::time_point deadline, Callback callback, Clock::duration period = Clock::duration::zero());
+    void run();
+    Clock::time_point next_deadline();
+
+    mutable std::mutex mutex;
+    // signaled when a timer earlier than the one the thread is waiting for is added, or on stop
+    std::condition_variable changed;
+    // signaled when a callback returns
+    std::condition_variable idle;
+    std::thread thread;
+    bool stopping = false;
+
+    // heap ordered by Deadline::operator>, entries of canceled timers are dropped once they reach the top
+    std::vector<Deadline> deadlines;
+    std::unordered_map<TimerId, std::shared_ptr<Timer>> timers;
+    TimerId next_id = 1;
+    TimerId running = 0;
+    std::thread::id processing_thread;
+
+    TimerStats stats;
+};
@@ -0,0 +1,62 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads running the independent iterations of a loop along with the calling thread
+class WorkerPool {
+public:
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+    ~WorkerPool();
+
+    // Number of helper threads worth starting on this host, 0 when it has too few cores to spare
+    static uint32_t default_size();
+
+    void start(const uint32_t count);
+    void stop();
+    uint32_t size() const { return static_cast<uint32_t>(threads.size()); }
+
+    // Call task for every index below count, spread on the workers and the calling thread.
+    // Returns once all the calls are done.
+    void run(const uint32_t count, const std::function<void(uint32_t)> &task);
+
+private:
+    void work(uint64_t seen);
+    void run_tasks();
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(uint32_t)> *current_task = nullptr;
+    uint32_t task_count = 0;
+    std::atomic<uint32_t> next_task = 0;
+    uint32_t busy_workers = 0;
+    uint64_t generation = 0;
+    bool quit = false;
+};
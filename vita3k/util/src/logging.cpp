@@ -22,29 +22,463 @@
 #include <Windows.h>
 #endif
 
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/base_sink.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/msvc_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 namespace logging {
 
 static const fs::path &LOG_FILE_NAME = "vita3k.log";
 static const char *LOG_PATTERN = "%^[%H:%M:%S.%e] |%L| [%!]: %v%$";
-static std::vector<spdlog::sink_ptr> sinks;
+static const char *LOGGER_NAME = "vita3k logger";
 
-static void register_log_exception_handler();
+// Number of records the ring holds, a record is about 256 bytes
+constexpr uint64_t RING_SIZE = 4096;
+// An identical message from the same call site is written again with its count after this time
+constexpr int64_t REPEAT_INTERVAL_MS = 1000;
+constexpr uint32_t DEFAULT_RATE_LIMIT = 1000;
+// How long a flush waits for the writer, it may be stuck when flushing for a crash
+constexpr auto FLUSH_TIMEOUT = std::chrono::seconds(2);
+
+struct Record {
+    std::atomic<uint64_t> sequence;
+    uint64_t position = 0;
+    spdlog::source_loc source;
+    spdlog::level::level_enum level = spdlog::level::info;
+    spdlog::log_clock::time_point time;
+    size_t thread_id = 0;
+    // identical messages from the call site which were not written before this one
+    uint32_t repeats = 0;
+    // this message is one of them, written again to report the count
+    bool repeat = false;
+    uint32_t dropped = 0;
+    // null when the text is stored
+    FormatFn format_args = nullptr;
+    std::string_view format;
+    uint32_t text_size = 0;
+    // for the texts which don't fit in args, its capacity is reused by the next records of the slot
+    std::string long_text;
+    bool sync = false;
+    alignas(std::max_align_t) unsigned char args[RECORD_ARGS_SIZE];
+};
+
+// A bounded multi-producer queue (Vyukov), each record has a sequence telling whether it is free for
+// the producer at a position, or ready for the writer
+struct Backend {
+    Backend()
+        : records(new Record[RING_SIZE]) {
+        for (uint64_t i = 0; i < RING_SIZE; i++)
+            records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<Record[]> records;
+    alignas(64) std::atomic<uint64_t> enqueue_pos = 0;
+    alignas(64) std::atomic<uint64_t> dequeue_pos = 0;
+    alignas(64) std::atomic<uint64_t> lost = 0;
+
+    std::once_flag start_flag;
+    std::atomic<bool> stopped = false;
+    std::thread writer;
+    std::thread::id writer_id;
+    std::mutex wake_mutex;
+    std::condition_variable wake_cond;
+    std::atomic<bool> writer_idle = false;
+    bool quit = false;
+
+    std::atomic<uint32_t> rate_limit = DEFAULT_RATE_LIMIT;
+    std::mutex sites_mutex;
+    CallSite *sites = nullptr;
+
+    // written to, guarded by sinks_mutex
+    std::vector<spdlog::sink_ptr> sinks;
+    // the sinks of the default logger, used as long as init was not called
+    std::vector<spdlog::sink_ptr> fallback_sinks;
+    std::recursive_mutex sinks_mutex;
+};
+
+// never destroyed, messages can be logged by the static destructors
+static Backend &backend() {
+    static Backend *const instance = new Backend;
+    return *instance;
+}
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class SiteLock {
+public:
+    explicit SiteLock(CallSite &site)
+        : site(site) {
+        while (site.busy.exchange(true, std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+    ~SiteLock() {
+        site.busy.store(false, std::memory_order_release);
+    }
+
+private:
+    CallSite &site;
+};
+
+static const std::vector<spdlog::sink_ptr> &output_sinks(Backend &b) {
+    return b.sinks.empty() ? b.fallback_sinks : b.sinks;
+}
+
+static void write(Backend &b, const spdlog::source_loc &source, spdlog::level::level_enum level, spdlog::log_clock::time_point time, size_t thread_id, std::string_view text) {
+    spdlog::details::log_msg msg(time, source, LOGGER_NAME, level, spdlog::string_view_t(text.data(), text.size()));
+    msg.thread_id = thread_id;
+
+    const std::lock_guard<std::recursive_mutex> lock(b.sinks_mutex);
+    for (const spdlog::sink_ptr &sink : output_sinks(b)) {
+        if (sink->should_log(level))
+            sink->log(msg);
+    }
+}
+
+static void write_record(Backend &b, Record &record, fmt::memory_buffer &text) {
+    if (const uint64_t lost = b.lost.exchange(0, std::memory_order_relaxed))
+        write(b, {}, spdlog::level::warn, record.time, record.thread_id, fmt::format("{} messages were lost, the log ring was full", lost));
+    if (record.dropped)
+        write(b, record.source, record.level, record.time, record.thread_id, fmt::format("{} messages from here were dropped by the rate limit", record.dropped));
+    if (record.repeats && !record.repeat)
+        write(b, record.source, record.level, record.time, record.thread_id, fmt::format("The previous message was repeated {} more times", record.repeats));
+
+    text.clear();
+    if (record.format_args) {
+        try {
+            record.format_args(record.format, record.args, text);
+        } catch (const std::exception &e) {
+            text.clear();
+            fmt::format_to(std::back_inserter(text), "Failed to format \"{}\": {}", record.format, e.what());
+        }
+    } else if (record.text_size <= RECORD_ARGS_SIZE) {
+        text.append(reinterpret_cast<const char *>(record.args), reinterpret_cast<const char *>(record.args) + record.text_size);
+    } else {
+        text.append(record.long_text.data(), record.long_text.data() + record.long_text.size());
+    }
+    if (record.repeat)
+        fmt::format_to(std::back_inserter(text), " (repeated {} times)", record.repeats);
+
+    write(b, record.source, record.level, record.time, record.thread_id, std::string_view(text.data(), text.size()));
+}
+
+static void flush_sinks(Backend &b) {
+    const std::lock_guard<std::recursive_mutex> lock(b.sinks_mutex);
+    for (const spdlog::sink_ptr &sink : output_sinks(b))
+        sink->flush();
+}
+
+// Write the next record if it is ready, only called by the writer
+static bool write_next(Backend &b, fmt::memory_buffer &text) {
+    const uint64_t position = b.dequeue_pos.load(std::memory_order_relaxed);
+    Record &record = b.records[position % RING_SIZE];
+    if (record.sequence.load(std::memory_order_acquire) != position + 1)
+        return false;
 
-static void flush() {
-    spdlog::details::registry::instance().flush_all();
+    write_record(b, record, text);
+
+    record.sequence.store(position + RING_SIZE, std::memory_order_release);
+    b.dequeue_pos.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+static bool has_ready_record(Backend &b) {
+    const uint64_t position = b.dequeue_pos.load(std::memory_order_relaxed);
+    return b.records[position % RING_SIZE].sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+static void writer_main(Backend &b) {
+    fmt::memory_buffer text;
+    bool written = false;
+    while (true) {
+        if (write_next(b, text)) {
+            written = true;
+            continue;
+        }
+
+        // keep the files up to date once a burst is written
+        if (written) {
+            flush_sinks(b);
+            written = false;
+        }
+
+        std::unique_lock<std::mutex> lock(b.wake_mutex);
+        if (b.quit && !has_ready_record(b))
+            return;
+
+        b.writer_idle.store(true);
+        // a producer can miss that the writer went idle, the timeout bounds the delay it adds
+        b.wake_cond.wait_for(lock, std::chrono::milliseconds(100), [&] { return b.quit || has_ready_record(b); });
+        b.writer_idle.store(false);
+    }
+}
+
+static void wake_writer(Backend &b) {
+    if (b.writer_idle.load()) {
+        const std::lock_guard<std::mutex> lock(b.wake_mutex);
+        b.wake_cond.notify_one();
+    }
+}
+
+static void report_sites(Backend &b);
+static void shutdown();
+
+static void start(Backend &b) {
+    {
+        const std::lock_guard<std::recursive_mutex> lock(b.sinks_mutex);
+        if (b.sinks.empty())
+            b.fallback_sinks = spdlog::default_logger()->sinks();
+    }
+    b.writer = std::thread(writer_main, std::ref(b));
+    b.writer_id = b.writer.get_id();
+    std::atexit(shutdown);
+}
+
+// Returns a record owned by the caller until it is committed, null if the ring is full and wait is not set
+static Record *reserve(Backend &b, bool wait) {
+    std::call_once(b.start_flag, start, std::ref(b));
+    if (b.stopped.load(std::memory_order_acquire) || std::this_thread::get_id() == b.writer_id) {
+        // nothing would write the ring anymore
+        thread_local Record record;
+        record.sync = true;
+        return &record;
+    }
+
+    uint64_t position = b.enqueue_pos.load(std::memory_order_relaxed);
+    while (true) {
+        Record &record = b.records[position % RING_SIZE];
+        const int64_t diff = static_cast<int64_t>(record.sequence.load(std::memory_order_acquire) - position);
+        if (diff == 0) {
+            if (b.enqueue_pos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                record.position = position;
+                return &record;
+            }
+        } else if (diff < 0) {
+            // full
+            if (!wait)
+                return nullptr;
+
+            wake_writer(b);
+            std::this_thread::yield();
+            position = b.enqueue_pos.load(std::memory_order_relaxed);
+        } else {
+            position = b.enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
 }
 
+static void commit(Backend &b, Record &record) {
+    if (record.sync) {
+        fmt::memory_buffer text;
+        write_record(b, record, text);
+        return;
+    }
+
+    record.sequence.store(record.position + 1, std::memory_order_release);
+    wake_writer(b);
+}
+
+static void set_text(Record &record, std::string_view text) {
+    record.format_args = nullptr;
+    record.text_size = static_cast<uint32_t>(text.size());
+    if (text.size() <= RECORD_ARGS_SIZE)
+        std::copy(text.begin(), text.end(), reinterpret_cast<char *>(record.args));
+    else
+        record.long_text.assign(text);
+}
+
+// Queue a text without going through the call site filters
+static void push_text(Backend &b, const spdlog::source_loc &source, spdlog::level::level_enum level, std::string_view text) {
+    Record *record = reserve(b, true);
+    record->source = source;
+    record->level = level;
+    record->time = spdlog::log_clock::now();
+    record->thread_id = spdlog::details::os::thread_id();
+    record->repeats = 0;
+    record->repeat = false;
+    record->dropped = 0;
+    set_text(*record, text);
+    commit(b, *record);
+}
+
+CallSite::CallSite(const char *file, int line, const char *function)
+    : source(file, line, function) {
+    Backend &b = backend();
+    const std::lock_guard<std::mutex> lock(b.sites_mutex);
+    next = b.sites;
+    b.sites = this;
+}
+
+Record *begin_record(CallSite &site, spdlog::level::level_enum level, uint64_t hash) {
+    Backend &b = backend();
+    const int64_t now = now_ms();
+    uint32_t repeats = 0;
+    uint32_t dropped = 0;
+    bool repeat = false;
+    {
+        const SiteLock lock(site);
+        if (site.has_last && site.last_hash == hash) {
+            site.repeats++;
+            if (now - site.last_written < REPEAT_INTERVAL_MS)
+                return nullptr;
+            repeat = true;
+        }
+
+        const uint32_t limit = b.rate_limit.load(std::memory_order_relaxed);
+        if (limit != 0) {
+            if (site.window != now / 1000) {
+                site.window = now / 1000;
+                site.window_count = 0;
+            }
+            if (++site.window_count > limit) {
+                if (!repeat)
+                    site.dropped++;
+                return nullptr;
+            }
+        }
+
+        repeats = site.repeats;
+        dropped = site.dropped;
+        site.repeats = 0;
+        site.dropped = 0;
+        site.has_last = true;
+        site.last_hash = hash;
+        site.last_written = now;
+        site.level = level;
+    }
+
+    Record *record = reserve(b, level >= spdlog::level::err);
+    if (!record) {
+        b.lost.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    record->source = site.source;
+    record->level = level;
+    record->time = spdlog::log_clock::now();
+    record->thread_id = spdlog::details::os::thread_id();
+    record->repeats = repeats;
+    record->repeat = repeat;
+    record->dropped = dropped;
+    return record;
+}
+
+void *record_args(Record *record) {
+    return record->args;
+}
+
+void commit_deferred(Record *record, FormatFn format_args, std::string_view format) {
+    record->format_args = format_args;
+    record->format = format;
+    commit(backend(), *record);
+}
+
+void commit_text(Record *record, std::string_view text) {
+    set_text(*record, text);
+    commit(backend(), *record);
+}
+
+// Queue the counts the call sites hold, nothing else would report them if they never log again
+static void report_sites(Backend &b) {
+    std::vector<std::tuple<const CallSite *, spdlog::level::level_enum, std::string>> reports;
+    {
+        const std::lock_guard<std::mutex> lock(b.sites_mutex);
+        for (CallSite *site = b.sites; site; site = site->next) {
+            const SiteLock site_lock(*site);
+            if (site->repeats)
+                reports.emplace_back(site, site->level, fmt::format("The previous message was repeated {} more times", site->repeats));
+            if (site->dropped)
+                reports.emplace_back(site, site->level, fmt::format("{} messages from here were dropped by the rate limit", site->dropped));
+            site->repeats = 0;
+            site->dropped = 0;
+            // the next message is written even if it is the same
+            site->has_last = false;
+        }
+    }
+
+    for (const auto &[site, level, text] : reports)
+        push_text(b, site->source, level, text);
+}
+
+// Wait for the writer to be done with everything queued so far
+static void wait_writer(Backend &b) {
+    if (b.stopped.load(std::memory_order_acquire) || !b.writer.joinable() || std::this_thread::get_id() == b.writer_id)
+        return;
+
+    const uint64_t target = b.enqueue_pos.load(std::memory_order_acquire);
+    const auto deadline = std::chrono::steady_clock::now() + FLUSH_TIMEOUT;
+    while (b.dequeue_pos.load(std::memory_order_acquire) < target && std::chrono::steady_clock::now() < deadline) {
+        {
+            const std::lock_guard<std::mutex> lock(b.wake_mutex);
+            b.wake_cond.notify_one();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void flush() {
+    Backend &b = backend();
+    report_sites(b);
+    wait_writer(b);
+    flush_sinks(b);
+}
+
+static void shutdown() {
+    Backend &b = backend();
+    report_sites(b);
+    {
+        const std::lock_guard<std::mutex> lock(b.wake_mutex);
+        b.quit = true;
+    }
+    b.wake_cond.notify_one();
+    if (b.writer.joinable())
+        b.writer.join();
+
+    b.stopped.store(true, std::memory_order_release);
+    flush_sinks(b);
+}
+
+void set_rate_limit(uint32_t messages_per_second) {
+    backend().rate_limit.store(messages_per_second, std::memory_order_relaxed);
+}
+
+// The sink of the default logger, for the messages logged with spdlog directly
+class RingSink : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+protected:
+    void sink_it_(const spdlog::details::log_msg &msg) override {
+        push_text(backend(), msg.source, msg.level, std::string_view(msg.payload.data(), msg.payload.size()));
+    }
+
+    void flush_() override {
+        logging::flush();
+    }
+};
+
+static void register_log_exception_handler();
+
 ExitCode init(const Root &root_paths, bool use_stdout) {
-    sinks.clear();
-    if (use_stdout)
-        sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+    {
+        Backend &b = backend();
+        const std::lock_guard<std::recursive_mutex> lock(b.sinks_mutex);
+        b.sinks.clear();
+        if (use_stdout)
+            b.sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+    }
 
     if (add_sink(root_paths.get_log_path() / LOG_FILE_NAME) != Success)
         return InitConfigFailed;
@@ -83,21 +517,24 @@ void set_level(spdlog::level::level_enum log_level) {
 }
 
 ExitCode add_sink(const fs::path &log_path) {
+    Backend &b = backend();
+    const std::lock_guard<std::recursive_mutex> lock(b.sinks_mutex);
     try {
-        sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(log_path.generic_path().native(), true));
+        b.sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(log_path.generic_path().native(), true));
     } catch (const spdlog::spdlog_ex &ex) {
         std::cerr << "File log initialization failed: " << ex.what() << std::endl;
         return InitConfigFailed;
     }
 
 #ifdef _MSC_VER
-    if (sinks.size() == 2) { // spdlog is being initialized
-        sinks.push_back(std::make_shared<spdlog::sinks::msvc_sink_mt>());
+    if (b.sinks.size() == 2) { // spdlog is being initialized
+        b.sinks.push_back(std::make_shared<spdlog::sinks::msvc_sink_mt>());
     }
 #endif
 
-    spdlog::set_default_logger(std::make_shared<spdlog::logger>("vita3k logger", begin(sinks), end(sinks)));
-    spdlog::set_pattern(LOG_PATTERN);
+    for (const spdlog::sink_ptr &sink : b.sinks)
+        sink->set_pattern(LOG_PATTERN);
+    spdlog::set_default_logger(std::make_shared<spdlog::logger>(LOGGER_NAME, std::make_shared<RingSink>()));
     return Success;
 }
 
@@ -160,6 +597,22 @@ void register_log_exception_handler() {
 }
 
 #else
-void register_log_exception_handler() {}
+// the access violations are handled by mem, it raises SIGTRAP for the ones it can't handle
+static void crash_handler(int sig) {
+    flush();
+    // the handler was reset to the default one, let it terminate the process
+    raise(sig);
+}
+
+void register_log_exception_handler() {
+    struct sigaction sa = {};
+    sa.sa_handler = crash_handler;
+    sa.sa_flags = SA_RESETHAND;
+    sigemptyset(&sa.sa_mask);
+    for (const int sig : { SIGABRT, SIGILL, SIGFPE, SIGTRAP }) {
+        if (sigaction(sig, &sa, nullptr) == -1)
+            LOG_CRITICAL("Failed to register a crash handler for signal {}", sig);
+    }
+}
 #endif
 } // namespace logging
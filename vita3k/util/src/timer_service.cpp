@@ -0,0 +1,245 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/timer_service.h>
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <cerrno>
+#include <time.h>
+#endif
+
+typedef TimerService::Clock Clock;
+
+#ifdef __linux__
+// clock_nanosleep usually returns within the timer slack of the thread, 50us by default
+constexpr auto SPIN_TAIL = std::chrono::microseconds(100);
+#else
+// the other hosts only get sleep_until, which can wake up a whole scheduler tick late: this spins up to 1ms
+// of a core for every deadline, the price of not missing the vblank there
+constexpr auto SPIN_TAIL = std::chrono::microseconds(1000);
+#endif
+// The thread waits on the condition variable, where an earlier timer can wake it up, until this close to the deadline
+constexpr auto SLEEP_MARGIN = std::chrono::milliseconds(2);
+
+TimerService::~TimerService() {
+    stop();
+}
+
+void TimerService::start() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (thread.joinable())
+        return;
+
+    stopping = false;
+    thread = std::thread(&TimerService::run, this);
+}
+
+void TimerService::stop() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (!thread.joinable())
+            return;
+        stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+
+    std::vector<std::shared_ptr<Timer>> left;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        thread = std::thread();
+        for (auto it = timers.begin(); it != timers.end();) {
+            if (it->second->period == Clock::duration::zero()) {
+                left.push_back(std::move(it->second));
+                it = timers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    const Clock::time_point now = Clock::now();
+    for (const auto &timer : left)
+        timer->callback(now);
+}
+
+TimerService::TimerId TimerService::add(Clock::time_point deadline, Callback callback, Clock::duration period) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return add_locked(deadline, std::move(callback), period);
+}
+
+TimerService::TimerId TimerService::add_locked(Clock::time_point deadline, Callback callback, Clock::duration period) {
+    const TimerId id = next_id++;
+    const bool earliest = deadline < next_deadline();
+    timers.emplace(id, std::make_shared<Timer>(Timer{ std::move(callback), period, deadline }));
+    deadlines.push_back({ deadline, id });
+    std::push_heap(deadlines.begin(), deadlines.end(), std::greater<>());
+
+    if (earliest)
+        changed.notify_one();
+    return id;
+}
+
+bool TimerService::cancel(TimerId id) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (timers.erase(id) == 0)
+        return false;
+
+    if (std::this_thread::get_id() != processing_thread)
+        idle.wait(lock, [&] { return running != id; });
+    return true;
+}
+
+void TimerService::wait_until(Clock::time_point deadline) {
+    struct Waiter {
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool done = false;
+    };
+
+    Waiter waiter;
+    bool queued = false;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (thread.joinable() && !stopping) {
+            queued = true;
+            add_locked(deadline, [&waiter](Clock::time_point) {
+                const std::lock_guard<std::mutex> waiter_lock(waiter.mutex);
+                waiter.done = true;
+                waiter.cond.notify_one();
+            });
+        }
+    }
+
+    if (!queued) {
+        sleep_until(deadline);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(waiter.mutex);
+    waiter.cond.wait(lock, [&] { return waiter.done; });
+}
+
+Clock::time_point TimerService::process(Clock::time_point now) {
+    std::unique_lock<std::mutex> lock(mutex);
+    processing_thread = std::this_thread::get_id();
+
+    while (!deadlines.empty() && deadlines.front().time <= now) {
+        std::pop_heap(deadlines.begin(), deadlines.end(), std::greater<>());
+        const Deadline due = deadlines.back();
+        deadlines.pop_back();
+
+        const auto it = timers.find(due.id);
+        if (it == timers.end() || it->second->deadline != due.time)
+            continue;
+
+        const std::shared_ptr<Timer> timer = it->second;
+        if (timer->period == Clock::duration::zero()) {
+            timers.erase(it);
+        } else {
+            // skip the deadlines already passed instead of firing the timer for each of them in a row
+            timer->deadline += timer->period;
+            if (timer->deadline <= now) {
+                const auto missed = (now - timer->deadline) / timer->period + 1;
+                stats.missed_periods += missed;
+                timer->deadline += missed * timer->period;
+            }
+            deadlines.push_back({ timer->deadline, due.id });
+            std::push_heap(deadlines.begin(), deadlines.end(), std::greater<>());
+        }
+
+        const auto lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(now - due.time);
+        stats.fired++;
+        stats.total_lateness += lateness;
+        stats.max_lateness = std::max(stats.max_lateness, lateness);
+
+        running = due.id;
+        lock.unlock();
+        timer->callback(now);
+        lock.lock();
+        running = 0;
+        idle.notify_all();
+    }
+
+    processing_thread = std::thread::id();
+    return next_deadline();
+}
+
+size_t TimerService::size() const {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return timers.size();
+}
+
+TimerStats TimerService::get_stats() const {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void TimerService::reset_stats() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    stats = {};
+}
+
+void TimerService::sleep_until(Clock::time_point deadline) {
+    const Clock::time_point wake = deadline - SPIN_TAIL;
+    if (Clock::now() < wake) {
+#ifdef __linux__
+        // steady_clock is CLOCK_MONOTONIC
+        const auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(wake.time_since_epoch()).count();
+        const timespec time = { static_cast<time_t>(since_epoch / 1000000000), static_cast<long>(since_epoch % 1000000000) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {
+        }
+#else
+        std::this_thread::sleep_until(wake);
+#endif
+    }
+
+    while (Clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+void TimerService::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        const Clock::time_point deadline = next_deadline();
+        if (deadline == Clock::time_point::max()) {
+            changed.wait(lock);
+            continue;
+        }
+
+        if (deadline - Clock::now() > SLEEP_MARGIN) {
+            changed.wait_until(lock, deadline - SLEEP_MARGIN);
+            continue;
+        }
+
+        lock.unlock();
+        sleep_until(deadline);
+        process(Clock::now());
+        lock.lock();
+    }
+}
+
+Clock::time_point TimerService::next_deadline() {
+    // drop the canceled timers first so that the thread does not wake up for them
+    while (!deadlines.empty() && !timers.contains(deadlines.front().id)) {
+        std::pop_heap(deadlines.begin(), deadlines.end(), std::greater<>());
+        deadlines.pop_back();
+    }
+    return deadlines.empty() ? Clock::time_point::max() : deadlines.front().time;
+}
@@ -0,0 +1,99 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/worker_pool.h>
+
+#include <algorithm>
+
+uint32_t WorkerPool::default_size() {
+    // keep a core for the emulated threads, the calling thread also takes part
+    const uint32_t cores = std::thread::hardware_concurrency();
+    return (cores > 2) ? std::min<uint32_t>(cores - 2, 7) : 0;
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+void WorkerPool::start(const uint32_t count) {
+    stop();
+
+    quit = false;
+    for (uint32_t i = 0; i < count; i++)
+        threads.emplace_back(&WorkerPool::work, this, generation);
+}
+
+void WorkerPool::stop() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+
+    for (std::thread &thread : threads)
+        thread.join();
+    threads.clear();
+}
+
+void WorkerPool::run(const uint32_t count, const std::function<void(uint32_t)> &task) {
+    if (threads.empty() || count < 2) {
+        for (uint32_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        current_task = &task;
+        task_count = count;
+        next_task = 0;
+        busy_workers = size();
+        generation++;
+    }
+    wake.notify_all();
+
+    run_tasks();
+
+    // every worker must be done with the task before it goes out of scope
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return busy_workers == 0; });
+    current_task = nullptr;
+}
+
+void WorkerPool::run_tasks() {
+    for (uint32_t index = next_task++; index < task_count; index = next_task++)
+        (*current_task)(index);
+}
+
+void WorkerPool::work(uint64_t seen) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit)
+                return;
+
+            seen = generation;
+        }
+
+        run_tasks();
+
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0)
+            done.notify_one();
+    }
+}
@@ -0,0 +1,121 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/history_ring.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// every field is derived from the index so that a torn copy is noticed
+struct Sample {
+    uint64_t timestamp;
+    uint32_t buttons;
+    uint32_t inverted;
+    uint8_t axes[4];
+};
+
+Sample make_sample(uint64_t index, uint32_t update = 0) {
+    const uint32_t buttons = static_cast<uint32_t>(index * 7 + update);
+    const uint8_t axis = static_cast<uint8_t>(index + update);
+    return { index * 16667 + update, buttons, ~buttons, { axis, axis, axis, axis } };
+}
+
+bool is_consistent(const Sample &sample) {
+    return sample.inverted == ~sample.buttons && sample.axes[0] == sample.axes[1] && sample.axes[0] == sample.axes[2] && sample.axes[0] == sample.axes[3];
+}
+
+} // namespace
+
+TEST(history_ring, returns_distinct_samples_oldest_first) {
+    HistoryRing<Sample, 16> ring;
+    Sample out[16];
+    EXPECT_EQ(ring.read(out, 4), 0u);
+
+    for (uint64_t i = 0; i < 5; i++)
+        ring.push(make_sample(i));
+    ASSERT_EQ(ring.read(out, 3), 3u);
+    EXPECT_EQ(out[0].timestamp, make_sample(2).timestamp);
+    EXPECT_EQ(out[1].timestamp, make_sample(3).timestamp);
+    EXPECT_EQ(out[2].timestamp, make_sample(4).timestamp);
+
+    // the newest sample follows the host until the next one is pushed
+    ring.update_newest(make_sample(4, 5));
+    ASSERT_EQ(ring.read(out, 2), 2u);
+    EXPECT_EQ(out[0].buttons, make_sample(3).buttons);
+    EXPECT_EQ(out[1].buttons, make_sample(4, 5).buttons);
+    EXPECT_EQ(ring.count(), 5u);
+}
+
+TEST(history_ring, keeps_the_last_samples_after_wrapping) {
+    typedef HistoryRing<Sample, 16> Ring;
+    Ring ring;
+    for (uint64_t i = 0; i < 100; i++)
+        ring.push(make_sample(i));
+
+    Sample out[16];
+    ASSERT_EQ(ring.read(out, 16), Ring::MAX_READ);
+    for (uint32_t i = 0; i < Ring::MAX_READ; i++)
+        EXPECT_EQ(out[i].timestamp, make_sample(100 - Ring::MAX_READ + i).timestamp);
+}
+
+// A sampler pushing a sample per vblank and updating the newest one in between, read by guest threads
+TEST(history_ring, synthetic_input_read_concurrently) {
+    constexpr uint64_t VBLANKS = 20000;
+    constexpr uint32_t UPDATES_PER_VBLANK = 4;
+
+    HistoryRing<Sample, 128> ring;
+    std::atomic<bool> done = false;
+    std::thread sampler([&] {
+        for (uint64_t i = 0; i < VBLANKS; i++) {
+            ring.push(make_sample(i));
+            for (uint32_t update = 1; update <= UPDATES_PER_VBLANK; update++)
+                ring.update_newest(make_sample(i, update));
+        }
+        done = true;
+    });
+
+    std::vector<std::thread> readers;
+    std::atomic<uint64_t> failures = 0;
+    for (int reader = 0; reader < 3; reader++) {
+        readers.emplace_back([&, reader] {
+            Sample out[64];
+            const uint32_t count = 1 + reader * 31;
+            while (!done) {
+                const uint32_t copied = ring.read(out, count);
+                for (uint32_t i = 0; i < copied; i++) {
+                    if (!is_consistent(out[i]))
+                        failures++;
+                    // one sample per vblank, all of them older than the newest are final
+                    if (i > 0 && out[i].timestamp / 16667 != out[i - 1].timestamp / 16667 + 1)
+                        failures++;
+                    if (i + 1 < copied && out[i].timestamp % 16667 != UPDATES_PER_VBLANK)
+                        failures++;
+                }
+            }
+        });
+    }
+
+    sampler.join();
+    for (auto &reader : readers)
+        reader.join();
+    EXPECT_EQ(failures, 0u);
+}
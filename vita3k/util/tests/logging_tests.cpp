@@ -0,0 +1,189 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/log.h>
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Message {
+    spdlog::level::level_enum level;
+    std::string function;
+    std::string text;
+};
+
+class CaptureSink : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    std::vector<Message> take() {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        return std::move(messages);
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg &msg) override {
+        messages.push_back({ msg.level, msg.source.funcname ? msg.source.funcname : "", std::string(msg.payload.data(), msg.payload.size()) });
+    }
+    void flush_() override {}
+
+private:
+    std::vector<Message> messages;
+};
+
+enum class Color {
+    Red,
+    Green,
+};
+
+} // namespace
+
+template <>
+struct fmt::formatter<Color> : fmt::formatter<std::string_view> {
+    auto format(Color color, fmt::format_context &ctx) const {
+        return fmt::formatter<std::string_view>::format(color == Color::Red ? "red" : "green", ctx);
+    }
+};
+
+namespace {
+
+// Messages are written to the capture sink by the writer thread, the logger is set before anything is logged
+class logging_backend : public testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        sink = std::make_shared<CaptureSink>();
+        auto logger = std::make_shared<spdlog::logger>("test", sink);
+        logger->set_level(spdlog::level::trace);
+        spdlog::set_default_logger(logger);
+    }
+
+    void SetUp() override {
+        logging::set_rate_limit(0);
+        logging::flush();
+        sink->take();
+    }
+
+    std::vector<Message> written() {
+        logging::flush();
+        return sink->take();
+    }
+
+    static std::shared_ptr<CaptureSink> sink;
+};
+
+std::shared_ptr<CaptureSink> logging_backend::sink;
+
+std::vector<std::string> texts(const std::vector<Message> &messages) {
+    std::vector<std::string> result;
+    for (const Message &message : messages)
+        result.push_back(message.text);
+    return result;
+}
+
+void log_value(int value) {
+    LOG_INFO("value {}", value);
+}
+
+TEST_F(logging_backend, formats_every_kind_of_argument) {
+    const std::string name = "name";
+    const char *c_string = "c string";
+    const int numbers[] = { 1, 2 };
+    LOG_INFO("deferred {} {:.1f} {} {}", 42, 1.5, true, Color::Green);
+    LOG_WARN("eager {} {} {}", name, c_string, std::string("temporary"));
+    LOG_ERROR("as it is {}");
+    LOG_DEBUG(name);
+    LOG_TRACE(fmt::runtime("runtime {}"), 7);
+    LOG_INFO("{}", fmt::join(numbers, ","));
+    LOG_INFO_IF(false, "hidden");
+    LOG_INFO_IF(true, "shown {}", 1);
+
+    const std::vector<Message> messages = written();
+    EXPECT_EQ(texts(messages), (std::vector<std::string>{ "deferred 42 1.5 true green", "eager name c string temporary", "as it is {}", "name", "runtime 7", "1,2", "shown 1" }));
+    ASSERT_EQ(messages.size(), 7u);
+    EXPECT_EQ(messages[1].level, spdlog::level::warn);
+    EXPECT_EQ(messages[0].function, "TestBody");
+}
+
+TEST_F(logging_backend, long_messages_are_kept_whole) {
+    const std::string text(1000, 'x');
+    LOG_INFO("{}", text);
+    EXPECT_EQ(texts(written()), std::vector<std::string>{ text });
+}
+
+TEST_F(logging_backend, deduplicates_repeated_messages) {
+    for (int i = 0; i < 5; i++)
+        log_value(1);
+    for (int i = 0; i < 4; i++)
+        log_value(2);
+
+    EXPECT_EQ(texts(written()), (std::vector<std::string>{ "value 1", "The previous message was repeated 4 more times", "value 2", "The previous message was repeated 3 more times" }));
+}
+
+TEST_F(logging_backend, limits_the_rate_of_a_call_site) {
+    logging::set_rate_limit(10);
+    for (int i = 0; i < 25; i++)
+        log_value(i);
+    // the other call sites are not limited
+    LOG_INFO("other");
+
+    const std::vector<std::string> result = texts(written());
+    ASSERT_GE(result.size(), 12u);
+    EXPECT_EQ(result.front(), "value 0");
+    EXPECT_NE(std::find(result.begin(), result.end(), "other"), result.end());
+    // every message is either written or counted, the count is reported by the next flush
+    int count = 0;
+    for (const std::string &text : result) {
+        int dropped = 0;
+        if (text.starts_with("value "))
+            count++;
+        else if (sscanf(text.c_str(), "%d messages from here were dropped", &dropped) == 1)
+            count += dropped;
+    }
+    EXPECT_EQ(count, 25);
+}
+
+TEST_F(logging_backend, keeps_the_order_of_each_thread) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 2000; i++)
+                LOG_ERROR("thread {} message {}", t, i);
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    std::vector<int> next(4, 0);
+    for (const std::string &text : texts(written())) {
+        int t = 0;
+        int i = 0;
+        ASSERT_EQ(sscanf(text.c_str(), "thread %d message %d", &t, &i), 2) << text;
+        EXPECT_EQ(i, next[t]);
+        next[t] = i + 1;
+    }
+    EXPECT_EQ(next, std::vector<int>(4, 2000));
+}
+
+} // namespace
@@ -0,0 +1,124 @@
+// Vita3K emulator project
+// Copyright (C) 2025 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/timer_service.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+typedef TimerService::Clock Clock;
+
+// A fixed origin so that the headless loops do not depend on the host clock
+const Clock::time_point origin = Clock::time_point(1h);
+
+} // namespace
+
+TEST(timer_service, fires_due_timers_in_order) {
+    TimerService service;
+    std::vector<int> fired;
+    service.add(origin + 3ms, [&](Clock::time_point) { fired.push_back(3); });
+    service.add(origin + 1ms, [&](Clock::time_point) { fired.push_back(1); });
+    service.add(origin + 2ms, [&](Clock::time_point) { fired.push_back(2); });
+
+    EXPECT_EQ(service.process(origin), origin + 1ms);
+    EXPECT_TRUE(fired.empty());
+
+    EXPECT_EQ(service.process(origin + 2ms), origin + 3ms);
+    EXPECT_EQ(fired, std::vector<int>({ 1, 2 }));
+
+    EXPECT_EQ(service.process(origin + 10ms), Clock::time_point::max());
+    EXPECT_EQ(fired, std::vector<int>({ 1, 2, 3 }));
+    EXPECT_EQ(service.size(), 0u);
+
+    const TimerStats stats = service.get_stats();
+    EXPECT_EQ(stats.fired, 3u);
+    EXPECT_EQ(stats.max_lateness, 7ms);
+    EXPECT_EQ(stats.total_lateness, 1ms + 0ms + 7ms);
+}
+
+TEST(timer_service, periodic_timer_keeps_its_phase) {
+    TimerService service;
+    std::vector<Clock::time_point> fired;
+    service.add(origin + 16ms, [&](Clock::time_point now) { fired.push_back(now); }, 16ms);
+
+    for (Clock::time_point now = origin; now < origin + 50ms; now += 1ms)
+        service.process(now);
+    EXPECT_EQ(fired, std::vector<Clock::time_point>({ origin + 16ms, origin + 32ms, origin + 48ms }));
+    EXPECT_EQ(service.get_stats().max_lateness, 0ns);
+
+    // a stall of several periods fires the timer once and goes back on the same phase
+    EXPECT_EQ(service.process(origin + 100ms), origin + 112ms);
+    EXPECT_EQ(fired.size(), 4u);
+    EXPECT_EQ(service.get_stats().missed_periods, 2u);
+}
+
+TEST(timer_service, cancel_from_callbacks) {
+    TimerService service;
+    int first = 0;
+    int second = 0;
+    TimerService::TimerId second_id = 0;
+    const auto cancel_second = [&](Clock::time_point now) {
+        first++;
+        // cancel the other one and add a new one due right away
+        EXPECT_TRUE(service.cancel(second_id));
+        service.add(now, [&](Clock::time_point) { second += 10; });
+    };
+    const TimerService::TimerId first_id = service.add(origin + 1ms, cancel_second, 1ms);
+    second_id = service.add(origin + 2ms, [&](Clock::time_point) { second++; });
+
+    service.process(origin + 1ms);
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(second, 10);
+
+    EXPECT_TRUE(service.cancel(first_id));
+    EXPECT_FALSE(service.cancel(first_id));
+    EXPECT_FALSE(service.cancel(second_id));
+    EXPECT_EQ(service.process(origin + 5ms), Clock::time_point::max());
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(second, 10);
+}
+
+TEST(timer_service, wait_until_on_service_thread) {
+    TimerService service;
+    service.start();
+
+    for (int i = 0; i < 20; i++) {
+        const Clock::time_point deadline = Clock::now() + 1ms;
+        service.wait_until(deadline);
+        EXPECT_GE(Clock::now(), deadline);
+    }
+    EXPECT_EQ(service.get_stats().fired, 20u);
+
+    // stopping releases the threads still waiting
+    std::atomic<bool> released = false;
+    std::thread waiter([&] {
+        service.wait_until(Clock::now() + 1h);
+        released = true;
+    });
+    while (service.size() == 0)
+        std::this_thread::yield();
+    service.stop();
+    waiter.join();
+    EXPECT_TRUE(released);
+}
@@ -174,7 +174,8 @@ public:
     void add_buffer(Buffer &buffer);
     void add_cmd_buffer(vk::CommandBuffer cmd_buffer, vk::CommandPool cmd_pool);
 
-    void destroy_objects();
+    // The handles of the image views and samplers destroyed are added to destroyed_views if it is set
+    void destroy_objects(std::vector<uint64_t> *destroyed_views = nullptr);
 };
 
 } // namespace vkutil
@@ -268,7 +268,7 @@ void DestroyQueue::add_cmd_buffer(vk::CommandBuffer cmd_buffer, vk::CommandPool
         break;                                        \
     }
 
-void DestroyQueue::destroy_objects() {
+void DestroyQueue::destroy_objects(std::vector<uint64_t> *destroyed_views) {
     if (destroy_list.empty())
         return;
 
@@ -276,6 +276,8 @@ void DestroyQueue::destroy_objects() {
     while (idx < destroy_list.size()) {
         const vk ::ObjectType type = static_cast<vk::ObjectType>(destroy_list[idx++]);
         uint64_t el = destroy_list[idx++];
+        if (destroyed_views && (type == vk::ObjectType::eImageView || type == vk::ObjectType::eSampler))
+            destroyed_views->push_back(el);
         switch (type) {
             // handle special cases apart
 